@@ -0,0 +1,162 @@
+/**
+ * @file main.cpp
+ * @brief Test producer for shared-memory frame rings, standing in for the
+ * Unreal Engine renderer.
+ *
+ * Usage:
+ *   frame_producer [--name /vf_frames] [--size WxH] [--fps N]
+ *                  [--frames N] [--slots N]
+ *
+ * Renders a synthetic scene (sky, horizon and an aircraft silhouette
+ * flying across it) straight into the ring slots as RGB8 and publishes
+ * them at --fps, or as fast as possible with --fps 0. Runs for --frames
+ * frames, or until SIGINT / SIGTERM without it, then prints how many
+ * frames were published and dropped because readers held every slot.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "utils/frame_ring.h"
+
+using Clock = std::chrono::steady_clock;
+
+/** Set by the signal handler. */
+static std::atomic<bool> g_stop{false};
+
+/**
+ * @brief Stop producing on SIGINT / SIGTERM.
+ */
+static void on_signal(int) { g_stop.store(true); }
+
+/**
+ * @brief Parse a non-negative integer option value.
+ */
+static size_t parse_count(const std::string& text) {
+  const long value = std::stol(text);
+  if (value < 0) throw std::invalid_argument("bad count: " + text);
+  return size_t(value);
+}
+
+/**
+ * @brief Check whether (x, y) lies inside the aircraft silhouette centred
+ * at (cx, cy) with wingspan @p span, flying to the right.
+ */
+static bool in_aircraft(float x, float y, float cx, float cy, float span) {
+  const float u = (x - cx) / span, v = (y - cy) / span;  // body frame
+  const bool fuselage = u * u / 0.25f + v * v / 0.0016f <= 1.f;
+  const float sweep = std::fabs(v) * 0.6f;  // wings swept back
+  const bool wings = std::fabs(v) <= 0.5f && u <= 0.05f - sweep &&
+                     u >= -0.1f - sweep;
+  const bool tail = std::fabs(v) <= 0.18f && u <= -0.38f - sweep * 0.5f &&
+                    u >= -0.48f;
+  return fuselage || wings || tail;
+}
+
+/**
+ * @brief Render frame @p index of the scene as RGB8.
+ */
+static void render(uint8_t* pixels, uint32_t width, uint32_t height,
+                   uint64_t index) {
+  const float t = float(index) / 120.f;
+  const float span = 0.25f * float(width);
+  const float cx = std::fmod(t, 1.f) * (float(width) + span) - span / 2;
+  const float cy = float(height) * (0.35f + 0.1f * std::sin(6.283f * t));
+  const auto horizon = uint32_t(0.7f * float(height));
+  for (uint32_t y = 0; y < height; ++y) {
+    const float shade = float(y) / float(height);
+    for (uint32_t x = 0; x < width; ++x) {
+      uint8_t* p = pixels + (size_t(y) * width + x) * 3;
+      if (in_aircraft(float(x), float(y), cx, cy, span)) {
+        p[0] = p[1] = p[2] = 40;
+      } else if (y < horizon) {
+        p[0] = uint8_t(90 + 100 * shade);
+        p[1] = uint8_t(150 + 70 * shade);
+        p[2] = 235;
+      } else {
+        p[0] = 96;
+        p[1] = uint8_t(110 - 30 * shade);
+        p[2] = 70;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string name = "/vf_frames";
+  uint32_t width = 640, height = 480;
+  size_t fps = 30, frames = 0, slots = 4;
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (i + 1 >= argc) throw std::invalid_argument("missing value: " + arg);
+      const std::string value = argv[++i];
+      if (arg == "--name") {
+        name = value;
+      } else if (arg == "--size") {
+        const size_t x = value.find('x');
+        if (x == std::string::npos)
+          throw std::invalid_argument("bad size: " + value);
+        width = uint32_t(parse_count(value.substr(0, x)));
+        height = uint32_t(parse_count(value.substr(x + 1)));
+        if (width == 0 || height == 0)
+          throw std::invalid_argument("bad size: " + value);
+      } else if (arg == "--fps") {
+        fps = parse_count(value);
+      } else if (arg == "--frames") {
+        frames = parse_count(value);
+      } else if (arg == "--slots") {
+        slots = parse_count(value);
+      } else {
+        throw std::invalid_argument("unknown option: " + arg);
+      }
+    }
+
+    FrameRingWriter ring(name, slots, size_t(width) * height * 3);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::printf("producing %ux%u RGB8 frames into %s (%zu slots)\n", width,
+                height, name.c_str(), slots);
+    std::fflush(stdout);
+
+    const auto period = fps ? std::chrono::nanoseconds(1000000000 / fps)
+                            : std::chrono::nanoseconds(0);
+    const Clock::time_point start = Clock::now();
+    Clock::time_point next = start;
+    for (uint64_t i = 0; !g_stop.load() && (frames == 0 || i < frames); ++i) {
+      if (void* pixels = ring.begin()) {
+        render(static_cast<uint8_t*>(pixels), width, height, i);
+        FrameInfo info;
+        info.width = width;
+        info.height = height;
+        info.channels = 3;
+        info.timestamp_ns = uint64_t(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now().time_since_epoch())
+                .count());
+        ring.commit(info);
+      }
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("published %llu frames (dropped %zu) in %.2f s\n",
+                static_cast<unsigned long long>(ring.published()),
+                ring.dropped(), seconds);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "frame_producer: %s\n", e.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file main.cpp
+ * @brief Dynamic batching inference server on a Unix domain socket.
+ *
+ * Usage:
+ *   inference_server [--socket PATH] [--model MODEL.onnx]
+ *                    [--input-shape CxHxW] [--max-batch N]
+ *                    [--max-delay-us US] [--batch-sizes 1,2,4,8]
+ *                    [--threads N]
+ *
+ * Without --model a small built-in convolutional classifier is served, so
+ * the server and load_generator can be benchmarked without a model file.
+ * Plans come from a PlanCache warmed up for every batch size; as imported
+ * graphs are specialized to their input shapes, the cache builds the graph
+ * for each size. Partial batches are padded to the next planned size.
+ * SIGINT or SIGTERM stops the server and prints its counters.
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "runtime/fusion.h"
+#include "runtime/onnx.h"
+#include "runtime/operators.h"
+#include "runtime/plan_cache.h"
+#include "serving/server.h"
+#include "utils/parallel.h"
+
+/** Server stopped by the signal handler. */
+static InferenceServer* g_server = nullptr;
+
+/**
+ * @brief Stop the server on SIGINT / SIGTERM.
+ */
+static void on_signal(int) {
+  if (g_server) g_server->stop();
+}
+
+/**
+ * @brief Split @p text at @p separator into positive integers.
+ */
+static std::vector<size_t> parse_sizes(const std::string& text,
+                                       char separator) {
+  std::vector<size_t> sizes;
+  std::stringstream stream(text);
+  for (std::string item; std::getline(stream, item, separator);) {
+    const long value = std::stol(item);
+    if (value <= 0) throw std::invalid_argument("bad size list: " + text);
+    sizes.push_back(size_t(value));
+  }
+  if (sizes.empty()) throw std::invalid_argument("bad size list: " + text);
+  return sizes;
+}
+
+/**
+ * @brief Build the demo classifier for a batch of @p batch images:
+ * two strided 3x3 conv-relu layers, global pooling and a linear head.
+ */
+static std::shared_ptr<Graph> demo_graph(size_t batch, size_t channels) {
+  std::mt19937 rng(42);
+  std::normal_distribution<float> normal(0.f, 0.1f);
+  const auto random = [&](const Shape& shape) {
+    Tensor<float> t(shape);
+    for (size_t i = 0; i < t.numel(); ++i) t.data()[i] = normal(rng);
+    return t;
+  };
+  Conv2dParams strided;
+  strided.stride_h = strided.stride_w = 2;
+  strided.pad_top = strided.pad_left = strided.pad_bottom = 1;
+  strided.pad_right = 1;
+  const auto relu = std::make_shared<ReluOp>();
+
+  auto g = std::make_shared<Graph>();
+  ValueId x = g->addInput("image");
+  x = g->addNode("conv1",
+                 std::make_shared<Conv2dOp>(random({16, channels, 3, 3}),
+                                            random({16}), strided),
+                 {x});
+  x = g->addNode("relu1", relu, {x});
+  x = g->addNode("conv2",
+                 std::make_shared<Conv2dOp>(random({32, 16, 3, 3}),
+                                            random({32}), strided),
+                 {x});
+  x = g->addNode("relu2", relu, {x});
+  x = g->addNode("pool", std::make_shared<GlobalAveragePoolOp>(), {x});
+  x = g->addNode("flatten", std::make_shared<ReshapeOp>(Shape{batch, 32}),
+                 {x});
+  g->addOutput(g->addNode(
+      "fc", std::make_shared<LinearOp>(random({10, 32}), random({10})), {x}));
+  return g;
+}
+
+int main(int argc, char** argv) {
+  std::string socket_path = "/tmp/vision-foundry.sock";
+  std::string model_path;
+  Shape input_shape{3, 224, 224};
+  ServerOptions options;
+  options.batching.max_batch = 8;
+  options.batching.batch_sizes = {1, 2, 4, 8};
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (i + 1 >= argc) throw std::invalid_argument("missing value: " + arg);
+      const std::string value = argv[++i];
+      if (arg == "--socket") {
+        socket_path = value;
+      } else if (arg == "--model") {
+        model_path = value;
+      } else if (arg == "--input-shape") {
+        input_shape = Shape();
+        for (size_t d : parse_sizes(value, 'x')) input_shape.push_back(d);
+      } else if (arg == "--max-batch") {
+        options.batching.max_batch = parse_sizes(value, ',').at(0);
+      } else if (arg == "--max-delay-us") {
+        options.batching.max_delay = std::chrono::microseconds(
+            std::stol(value));
+      } else if (arg == "--batch-sizes") {
+        options.batching.batch_sizes = parse_sizes(value, ',');
+      } else if (arg == "--threads") {
+        set_num_threads(parse_sizes(value, ',').at(0));
+      } else {
+        throw std::invalid_argument("unknown option: " + arg);
+      }
+    }
+    if (input_shape.rank() != 3 && model_path.empty())
+      throw std::invalid_argument("the demo model needs a CxHxW shape");
+
+    // One plan per batch size the batcher can produce.
+    std::vector<size_t> sizes;
+    for (size_t b : options.batching.batch_sizes)
+      if (b <= options.batching.max_batch) sizes.push_back(b);
+    if (options.batching.batch_sizes.empty())
+      for (size_t b = 1; b <= options.batching.max_batch; ++b)
+        sizes.push_back(b);
+    else
+      options.batching.batch_sizes = sizes;
+    PlanCache cache(
+        [&](const std::vector<Shape>& shapes) -> std::shared_ptr<const Graph> {
+          std::shared_ptr<Graph> graph;
+          if (model_path.empty()) {
+            graph = demo_graph(shapes.at(0)[0], input_shape[0]);
+          } else {
+            OnnxImportOptions import;
+            import.input_shapes = shapes;
+            graph = import_onnx_file(model_path, import).graph;
+          }
+          return std::make_shared<Graph>(fuse_graph(*graph));
+        },
+        std::max<size_t>(sizes.size(), 1));
+    std::vector<std::vector<Shape>> batch_shapes;
+    for (size_t b : sizes) {
+      Shape batch_shape{b};
+      for (size_t d : input_shape) batch_shape.push_back(d);
+      batch_shapes.push_back({batch_shape});
+    }
+    cache.warmup(batch_shapes);
+
+    options.socket_path = socket_path;
+    InferenceServer server(
+        [&cache](const Tensor<float>& batch) -> Tensor<float> {
+          return cache.run({&batch, 1})->output(0);
+        },
+        options);
+    g_server = &server;
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::printf("serving %s on %s (%zu plans, %zu threads)\n",
+                model_path.empty() ? "demo model" : model_path.c_str(),
+                socket_path.c_str(), cache.size(), num_threads());
+    std::fflush(stdout);
+    server.run();
+    g_server = nullptr;
+
+    const ServerStats stats = server.stats();
+    std::printf(
+        "connections %zu (refused %zu, dropped %zu), requests %zu, "
+        "batches %zu (mean %.2f, padded %zu), failed %zu\n",
+        stats.accepted, stats.refused, stats.dropped, stats.requests,
+        stats.batcher.batches, stats.batcher.meanBatch(),
+        stats.batcher.padded_samples, stats.batcher.failed);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "inference_server: %s\n", e.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file main.cpp
+ * @brief Load generator for inference_server.
+ *
+ * Usage:
+ *   load_generator [--socket PATH] [--clients N] [--requests N]
+ *                  [--in-flight N] [--shape CxHxW]
+ *
+ * Each client thread opens its own connection and keeps up to --in-flight
+ * requests pipelined until it has sent --requests random images. The
+ * throughput and the latency percentiles over all requests are printed.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "serving/client.h"
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Parse a positive integer option value.
+ */
+static size_t parse_count(const std::string& text) {
+  const long value = std::stol(text);
+  if (value <= 0) throw std::invalid_argument("bad count: " + text);
+  return size_t(value);
+}
+
+/**
+ * @brief Get the @p q quantile of sorted latencies, in milliseconds.
+ */
+static double percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0.;
+  const size_t i = std::min(sorted.size() - 1,
+                            size_t(q * double(sorted.size())));
+  return sorted[i];
+}
+
+int main(int argc, char** argv) {
+  std::string socket_path = "/tmp/vision-foundry.sock";
+  size_t clients = 4, requests = 256, in_flight = 4;
+  Shape shape{3, 224, 224};
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (i + 1 >= argc) throw std::invalid_argument("missing value: " + arg);
+      const std::string value = argv[++i];
+      if (arg == "--socket") {
+        socket_path = value;
+      } else if (arg == "--clients") {
+        clients = parse_count(value);
+      } else if (arg == "--requests") {
+        requests = parse_count(value);
+      } else if (arg == "--in-flight") {
+        in_flight = parse_count(value);
+      } else if (arg == "--shape") {
+        shape = Shape();
+        std::stringstream stream(value);
+        for (std::string d; std::getline(stream, d, 'x');)
+          shape.push_back(parse_count(d));
+      } else {
+        throw std::invalid_argument("unknown option: " + arg);
+      }
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "load_generator: %s\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  std::mutex mutex;
+  std::vector<double> latencies;
+  size_t failures = 0;
+  std::string error;
+  const Clock::time_point start = Clock::now();
+  std::vector<std::thread> threads;
+  for (size_t c = 0; c < clients; ++c)
+    threads.emplace_back([&, c] {
+      std::vector<double> local;
+      size_t failed = 0;
+      try {
+        InferenceClient client(socket_path);
+        std::mt19937 rng(static_cast<unsigned>(c));
+        std::uniform_real_distribution<float> pixel(0.f, 1.f);
+        Tensor<float> image(shape);
+        for (size_t i = 0; i < image.numel(); ++i)
+          image.data()[i] = pixel(rng);
+
+        std::map<uint64_t, Clock::time_point> sent;
+        size_t issued = 0;
+        while (issued < requests || !sent.empty()) {
+          while (issued < requests && sent.size() < in_flight) {
+            const Clock::time_point now = Clock::now();
+            sent[client.send(image)] = now;
+            ++issued;
+          }
+          const Message response = client.receive();
+          const auto it = sent.find(response.id);
+          if (it == sent.end())
+            throw std::runtime_error("unexpected response id");
+          local.push_back(std::chrono::duration<double, std::milli>(
+                              Clock::now() - it->second)
+                              .count());
+          if (response.status != MessageStatus::kOk) ++failed;
+          sent.erase(it);
+        }
+      } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = e.what();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      latencies.insert(latencies.end(), local.begin(), local.end());
+      failures += failed;
+    });
+  for (std::thread& t : threads) t.join();
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  if (!error.empty())
+    std::fprintf(stderr, "load_generator: %s\n", error.c_str());
+  std::sort(latencies.begin(), latencies.end());
+  std::printf(
+      "%zu responses (%zu failed) in %.3f s: %.1f req/s, latency ms "
+      "p50 %.3f p95 %.3f p99 %.3f max %.3f\n",
+      latencies.size(), failures, seconds, double(latencies.size()) / seconds,
+      percentile(latencies, 0.50), percentile(latencies, 0.95),
+      percentile(latencies, 0.99), percentile(latencies, 1.0));
+  return error.empty() && failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
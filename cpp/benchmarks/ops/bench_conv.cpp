@@ -0,0 +1,145 @@
+/**
+ * @file bench_conv.cpp
+ * @brief Per-shape benchmarks of the convolution algorithms.
+ *
+ * Shapes are taken from common detector backbones. Each shape is run with
+ * the automatically selected NCHW and NCHWc algorithms, and stride-1 3x3
+ * shapes additionally with im2col and Winograd forced, so the algorithms can
+ * be compared layer by layer. Grouped-free shapes also run as INT8 QConv2d
+ * so the quantized speed-up can be read per layer. Results are reported in
+ * FLOP/s (multiply-adds count as two operations for INT8 too).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "ops/conv.h"
+#include "ops/quantize.h"
+#include "ops/winograd.h"
+
+/**
+ * @brief Convolution layer shape used by the benchmarks.
+ */
+struct ConvShape {
+  const char* name;
+  size_t c_in, c_out, size, kernel, stride, groups;
+};
+
+/** Backbone layer shapes (batch 1, square inputs, "same" padding). */
+static const ConvShape kShapes[] = {
+    {"resnet_conv2_3x3", 64, 64, 56, 3, 1, 1},
+    {"resnet_conv3_3x3", 128, 128, 28, 3, 1, 1},
+    {"resnet_conv4_3x3", 256, 256, 14, 3, 1, 1},
+    {"resnet_conv3_down", 128, 256, 28, 3, 2, 1},
+    {"resnet_conv2_1x1", 256, 64, 56, 1, 1, 1},
+    {"fpn_lateral_1x1", 512, 256, 28, 1, 1, 1},
+    {"mobilenet_dw_3x3", 144, 144, 56, 3, 1, 144},
+    {"mobilenet_dw_3x3_s2", 144, 144, 56, 3, 2, 144},
+};
+
+/** Label suffix per ConvAlgorithm value. */
+static const char* const kAlgorithmNames[] = {"auto", "gemm", "im2col",
+                                              "direct", "depthwise",
+                                              "winograd"};
+
+/**
+ * @brief Get the convolution geometry of a benchmark shape.
+ */
+static Conv2dParams shape_params(const ConvShape& s) {
+  Conv2dParams p;
+  p.stride_h = p.stride_w = s.stride;
+  p.pad_top = p.pad_left = p.pad_bottom = p.pad_right = s.kernel / 2;
+  p.groups = s.groups;
+  return p;
+}
+
+/**
+ * @brief Run one layer shape with arguments (shape, layout, algorithm).
+ */
+static void BM_Conv2d(benchmark::State& state) {
+  const ConvShape& s = kShapes[state.range(0)];
+  const auto layout = ConvLayout(state.range(1));
+  const auto algorithm = ConvAlgorithm(state.range(2));
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  Tensor<float> x(Shape{1, s.c_in, s.size, s.size});
+  Tensor<float> w(Shape{s.c_out, s.c_in / s.groups, s.kernel, s.kernel});
+  Tensor<float> b(Shape{s.c_out});
+  for (auto* t : {&x, &w, &b})
+    for (size_t i = 0; i < t->numel(); ++i) (*t)[i] = dist(rng);
+
+  const Conv2d conv(w, b, shape_params(s), layout, algorithm);
+  const Tensor<float> input =
+      layout == ConvLayout::kNchwc ? to_nchwc(x, conv.block()) : x;
+  Tensor<float> output(conv.outputShape(input.shape()));
+  for (auto _ : state) {
+    conv.forward(input, output);
+    benchmark::DoNotOptimize(output.data());
+  }
+  const double flops = 2. * double(s.c_out * s.c_in / s.groups) *
+                       double(s.kernel * s.kernel) *
+                       double(output.dim(2) * output.dim(3));
+  state.counters["FLOPS"] =
+      benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetLabel(std::string(s.name) +
+                 (layout == ConvLayout::kNchwc ? "/nchwc/" : "/nchw/") +
+                 kAlgorithmNames[int(conv.algorithm())]);
+}
+
+/**
+ * @brief Register every shape in both layouts, plus forced NCHW algorithms.
+ */
+static void conv_shapes(benchmark::internal::Benchmark* b) {
+  const auto automatic = int64_t(ConvAlgorithm::kAuto);
+  const auto nchw = int64_t(ConvLayout::kNchw);
+  for (int64_t i = 0; i < int64_t(std::size(kShapes)); ++i) {
+    for (ConvLayout l : {ConvLayout::kNchw, ConvLayout::kNchwc})
+      b->Args({i, int64_t(l), automatic});
+    const ConvShape& s = kShapes[i];
+    if (winograd_supported(shape_params(s), s.kernel, s.kernel))
+      for (ConvAlgorithm a : {ConvAlgorithm::kIm2col, ConvAlgorithm::kWinograd})
+        b->Args({i, nchw, int64_t(a)});
+  }
+  b->ArgNames({"shape", "layout", "algorithm"})->UseRealTime();
+}
+
+BENCHMARK(BM_Conv2d)->Apply(conv_shapes);
+
+/**
+ * @brief Run one ungrouped layer shape in INT8 with argument (shape).
+ */
+static void BM_QConv2d(benchmark::State& state) {
+  const ConvShape& s = kShapes[state.range(0)];
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  Tensor<float> x(Shape{1, s.c_in, s.size, s.size});
+  Tensor<float> w(Shape{s.c_out, s.c_in, s.kernel, s.kernel});
+  Tensor<float> b(Shape{s.c_out});
+  for (auto* t : {&x, &w, &b})
+    for (size_t i = 0; i < t->numel(); ++i) (*t)[i] = dist(rng);
+
+  const QConv2d conv(w, b, shape_params(s), choose_quant_params(-1.f, 1.f));
+  Tensor<float> output(conv.outputShape(x.shape()));
+  for (auto _ : state) {
+    conv.forward(x, output);
+    benchmark::DoNotOptimize(output.data());
+  }
+  const double flops = 2. * double(s.c_out * s.c_in) *
+                       double(s.kernel * s.kernel) *
+                       double(output.dim(2) * output.dim(3));
+  state.counters["FLOPS"] =
+      benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetLabel(std::string(s.name) + "/int8/" + qgemm_kernel_name());
+}
+
+/**
+ * @brief Register every ungrouped shape.
+ */
+static void qconv_shapes(benchmark::internal::Benchmark* b) {
+  for (int64_t i = 0; i < int64_t(std::size(kShapes)); ++i)
+    if (kShapes[i].groups == 1) b->Args({i});
+  b->ArgNames({"shape"})->UseRealTime();
+}
+
+BENCHMARK(BM_QConv2d)->Apply(qconv_shapes);
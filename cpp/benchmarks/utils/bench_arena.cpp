@@ -0,0 +1,70 @@
+/**
+ * @file bench_arena.cpp
+ * @brief Cost of per-batch transient allocations through the heap, the
+ * thread-local pool and the monotonic arena.
+ *
+ * Each iteration loads one batch: per sample a decode buffer, a resized
+ * tensor and a short list of boxes are allocated and dropped, the way
+ * getItem() and post-processing do. Results are reported in samples per
+ * second.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory_resource>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "utils/arena.h"
+
+/** Samples per batch. */
+static constexpr int kBatch = 32;
+
+/**
+ * @brief Allocate one sample's transient memory from @p resource.
+ */
+static void load_sample(std::pmr::memory_resource* resource) {
+  std::pmr::vector<unsigned char> decoded(resource);
+  decoded.reserve(64 * 64 * 3);
+  Tensor<float> resized(Shape{3, 16, 16}, resource);
+  std::pmr::vector<float> boxes(resource);
+  for (int i = 0; i < 64; ++i) boxes.push_back(float(i));
+  benchmark::DoNotOptimize(decoded.data());
+  benchmark::DoNotOptimize(resized.data());
+  benchmark::DoNotOptimize(boxes.data());
+}
+
+/**
+ * @brief Transient memory from operator new.
+ */
+static void BM_HeapScratch(benchmark::State& state) {
+  for (auto _ : state)
+    for (int i = 0; i < kBatch; ++i)
+      load_sample(std::pmr::new_delete_resource());
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+
+/**
+ * @brief Transient memory from the thread-local pool.
+ */
+static void BM_ThreadPoolScratch(benchmark::State& state) {
+  for (auto _ : state)
+    for (int i = 0; i < kBatch; ++i) load_sample(thread_pool_resource());
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+
+/**
+ * @brief Transient memory from an arena reset per batch.
+ */
+static void BM_ArenaScratch(benchmark::State& state) {
+  MonotonicArena arena;
+  for (auto _ : state) {
+    arena.reset();
+    for (int i = 0; i < kBatch; ++i) load_sample(&arena);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+
+BENCHMARK(BM_HeapScratch)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ThreadPoolScratch)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ArenaScratch)->ThreadRange(1, 8)->UseRealTime();
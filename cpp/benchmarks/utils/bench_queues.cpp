@@ -0,0 +1,138 @@
+/**
+ * @file bench_queues.cpp
+ * @brief Throughput of the inter-thread queues and the object pool.
+ *
+ * The lock-free SPSC and MPMC queues are measured against the mutex-based
+ * BoundedQueue under the same traffic: a producer/consumer pair streaming
+ * items, and N threads each pushing and popping through one shared queue.
+ * Results are reported in items per second.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "utils/bounded_queue.h"
+#include "utils/mpmc_queue.h"
+#include "utils/object_pool.h"
+#include "utils/spsc_queue.h"
+
+/** Items streamed per iteration of the pair benchmarks. */
+static constexpr int64_t kBurst = 1 << 16;
+
+/**
+ * @brief Stream kBurst items from a producer thread to the benchmark
+ * thread through a lock-free queue.
+ */
+template <typename Queue>
+static void BM_LockFreePair(benchmark::State& state) {
+  Queue queue(1024);
+  for (auto _ : state) {
+    std::thread producer([&] {
+      for (int64_t i = 0; i < kBurst; ++i)
+        while (!queue.tryPush(i)) std::this_thread::yield();
+    });
+    int64_t item = 0, sum = 0;
+    for (int64_t received = 0; received < kBurst;) {
+      if (queue.tryPop(item)) {
+        sum += item;
+        ++received;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kBurst);
+}
+
+/**
+ * @brief Same stream through the mutex-based BoundedQueue.
+ */
+static void BM_BoundedQueuePair(benchmark::State& state) {
+  BoundedQueue<int64_t> queue(1024);
+  for (auto _ : state) {
+    std::thread producer([&] {
+      for (int64_t i = 0; i < kBurst; ++i) queue.push(i);
+    });
+    int64_t item = 0, sum = 0;
+    for (int64_t received = 0; received < kBurst; ++received) {
+      queue.pop(item);
+      sum += item;
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kBurst);
+}
+
+/** Queues shared by the threads of the contended benchmarks. */
+static MpmcQueue<int64_t> g_mpmc(1024);
+static BoundedQueue<int64_t> g_bounded(1024);
+
+/**
+ * @brief Every thread pushes an item and pops one from a shared MPMC
+ * queue.
+ */
+static void BM_MpmcContended(benchmark::State& state) {
+  int64_t item = 0;
+  for (auto _ : state) {
+    while (!g_mpmc.tryPush(item)) std::this_thread::yield();
+    while (!g_mpmc.tryPop(item)) std::this_thread::yield();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Same traffic through the mutex-based BoundedQueue.
+ */
+static void BM_BoundedContended(benchmark::State& state) {
+  int64_t item = 0;
+  for (auto _ : state) {
+    g_bounded.push(item);
+    g_bounded.pop(item);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/** Pool shared by the threads of BM_ObjectPool. */
+static ObjectPool<std::vector<float>> g_pool(16, [] {
+  return std::make_unique<std::vector<float>>(4096);
+});
+
+/**
+ * @brief Acquire and release a pooled buffer, touching one element.
+ */
+static void BM_ObjectPool(benchmark::State& state) {
+  for (auto _ : state) {
+    auto buffer = g_pool.acquire();
+    (*buffer)[0] += 1.f;
+    benchmark::DoNotOptimize(buffer->data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Allocate the same buffer from the heap each time, for reference.
+ */
+static void BM_HeapBuffer(benchmark::State& state) {
+  for (auto _ : state) {
+    auto buffer = std::make_unique<std::vector<float>>(4096);
+    (*buffer)[0] += 1.f;
+    benchmark::DoNotOptimize(buffer->data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_LockFreePair<SpscQueue<int64_t>>)->UseRealTime();
+BENCHMARK(BM_LockFreePair<MpmcQueue<int64_t>>)->UseRealTime();
+BENCHMARK(BM_BoundedQueuePair)->UseRealTime();
+BENCHMARK(BM_MpmcContended)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_BoundedContended)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ObjectPool)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_HeapBuffer)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdexcept>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "utils/convert.h"
+#include "utils/numa.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Stack equally shaped samples along a new leading batch axis.
+ *
+ * Samples are copied (and converted, if the element types differ) in
+ * parallel straight into the batch, so a loader over 16-bit samples, e.g. a
+ * CachedDataset<Half, ...>, can feed float batches without an intermediate
+ * float copy per sample, or keep the batch in 16 bits to halve its size.
+ *
+ * With a @p numa_node the batch is placed on that node, so a loader on one
+ * socket can hand batches to inference threads on another without remote
+ * reads. Node-local batches come from a per-thread NumaBufferCache: the
+ * memory of a batch is reused once it has been released, so steady-state
+ * batches do not map new pages.
+ *
+ * @tparam To Element type of the batch.
+ * @tparam From Element type of the samples.
+ * @param samples Samples of identical shape, e.g. from DataLoader::nextBatch().
+ * @param numa_node NUMA node of the batch, or -1 for first touch.
+ * @return Tensor of shape [samples.size(), ...sample shape].
+ * @throws std::invalid_argument if there are no samples, the shapes differ,
+ *         the batch would exceed kMaxTensorRank or the node does not exist.
+ */
+template <typename To, typename From>
+Tensor<To> collate(const std::vector<Tensor<From>>& samples,
+                   int numa_node = -1) {
+  if (samples.empty()) throw std::invalid_argument("collate: no samples");
+  const Shape& shape = samples[0].shape();
+  if (shape.rank() >= kMaxTensorRank)
+    throw std::invalid_argument("collate: sample rank too large");
+  for (const Tensor<From>& sample : samples)
+    if (sample.shape() != shape)
+      throw std::invalid_argument("collate: sample shapes differ");
+  Shape stacked{samples.size()};
+  for (size_t d : shape) stacked.push_back(d);
+  thread_local NumaBufferCache numa_batches;
+  Tensor<To> batch =
+      numa_node < 0 ? Tensor<To>(stacked)
+                    : numa_batches.tensor<To>(stacked, size_t(numa_node));
+  const size_t per_sample = shape.numel();
+  parallel_for(0, samples.size(), 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i)
+      convert(samples[i].data(), samples[i].numel(),
+              batch.data() + i * per_sample);
+  });
+  return batch;
+}
@@ -1,9 +1,12 @@
 #pragma once
 #include <algorithm>
+#include <memory_resource>
 #include <numeric>
 #include <random>
 #include <vector>
 
+#include "utils/arena.h"
+
 /**
  * @brief Abstract base class representing a dataset interface.
  *
@@ -38,6 +41,25 @@ class Dataset {
    */
   virtual SampleType getItem(size_t index) const = 0;
 
+  /**
+   * @brief Retrieve an item, taking transient memory from @p scratch.
+   *
+   * DataLoader calls this with its per-batch arena. Datasets that
+   * allocate while loading (decode buffers, intermediate tensors, or
+   * std::pmr containers in the sample itself) override it to allocate
+   * from @p scratch, which is reset when the batch after next is loaded;
+   * the default ignores @p scratch and calls getItem(index).
+   *
+   * @param index The zero-based index of the item to retrieve.
+   * @param scratch Memory valid until the loader's batch after next.
+   * @return The dataset item at the specified index.
+   */
+  virtual SampleType getItemScratch(
+      size_t index, std::pmr::memory_resource* scratch) const {
+    (void)scratch;
+    return getItem(index);
+  }
+
   /**
    * @brief Get the total number of items in the dataset.
    *
@@ -56,6 +78,14 @@ class Dataset {
  * optional shuffling of data. The batch size and shuffle behavior are
  * configurable.
  *
+ * Each batch is loaded through Dataset::getItemScratch() with a
+ * MonotonicArena, so datasets can place per-sample transient memory (and
+ * even the samples) in it at the cost of a pointer bump. Batches alternate
+ * between two arenas and an arena is reset when it is reused, so the
+ * usual `batch = loader.nextBatch();` keeps the previous batch valid until
+ * it is replaced: samples using arena memory are valid until the second
+ * following call to nextBatch().
+ *
  * @tparam DatasetType The type of the dataset being loaded.
  */
 template <typename DatasetType>
@@ -66,6 +96,8 @@ class DataLoader {
   bool shuffle_;                /**< Whether to shuffle data between epochs */
   std::vector<size_t> indices_; /**< Indices used for batching */
   size_t current_index_;        /**< Current index in the dataset */
+  MonotonicArena arenas_[2];    /**< Scratch memory, by batch parity */
+  size_t batches_ = 0;          /**< Batches loaded so far */
 
  public:
   /**
@@ -108,15 +140,26 @@ class DataLoader {
    * samples.
    */
   std::vector<typename DatasetType::type_t> nextBatch() {
-    std::vector<typename DatasetType::type_t> batch;
+    using SampleType = typename DatasetType::type_t;
+    MonotonicArena& arena = arenas_[batches_++ % 2];
+    arena.reset();  // its last batch is two batches old
+    std::vector<SampleType> batch;
     size_t end_index = std::min(current_index_ + batch_size_, indices_.size());
+    batch.reserve(end_index - current_index_);
     for (size_t i = current_index_; i < end_index; ++i) {
-      batch.push_back(dataset_.getItem(indices_[i]));
+      batch.push_back(dataset_.getItemScratch(indices_[i], &arena));
     }
     current_index_ = end_index;
     return batch;
   }
 
+  /**
+   * @brief Get the arena holding the current batch's scratch memory.
+   */
+  const MonotonicArena& arena() const {
+    return arenas_[(batches_ + 1) % 2];
+  }
+
   /**
    * @brief Reset the DataLoader to start from the beginning.
    *
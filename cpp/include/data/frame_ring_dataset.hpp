@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+#include "data/data.hpp"
+#include "tensor/tensor.hpp"
+#include "utils/frame_ring.h"
+
+/**
+ * @brief Dataset over the frames an external renderer publishes into a
+ * shared-memory FrameRing, read in place.
+ *
+ * Item i is frame first + i, as a [height, width, channels] tensor viewing
+ * the ring slot (no copy); getItem() waits for frames not yet rendered.
+ * Each returned tensor pins its slot until the tensor and its copies are
+ * gone, so the ring needs more slots than the samples held at once (e.g.
+ * the batch size of a DataLoader plus one). Tensors must be treated as
+ * read-only. Iterate in order (no shuffling): the ring only keeps the
+ * most recent frames.
+ *
+ * @tparam T Pixel type of the frames (uint8_t or float).
+ */
+template <typename T>
+class FrameRingDataset : public Dataset<Tensor<T>> {
+ private:
+  const FrameRingReader& reader_;    /**< Attached ring */
+  uint64_t first_;                   /**< Sequence of item 0 */
+  size_t size_;                      /**< Number of frames */
+  std::chrono::nanoseconds timeout_; /**< Longest wait for one frame */
+
+ public:
+  /**
+   * @brief Expose @p frames frames of a ring.
+   *
+   * @param reader Attached reader; must outlive the dataset.
+   * @param frames Number of items.
+   * @param first Sequence of the first item (default: the next frame).
+   * @param timeout Longest wait for a frame in getItem().
+   */
+  FrameRingDataset(const FrameRingReader& reader, size_t frames,
+                   std::optional<uint64_t> first = std::nullopt,
+                   std::chrono::nanoseconds timeout = std::chrono::seconds(1))
+      : reader_(reader),
+        first_(first ? *first : reader.published()),
+        size_(frames),
+        timeout_(timeout) {}
+
+  /**
+   * @brief Get a frame, waiting for it to be published.
+   *
+   * @param index The zero-based index of the frame.
+   * @return View of the frame's pixels.
+   * @throws std::out_of_range if @p index is out of range.
+   * @throws std::runtime_error if the frame does not arrive in time or was
+   *         overwritten before it was read.
+   * @throws std::invalid_argument if the frame's pixel type is not @p T.
+   */
+  Tensor<T> getItem(size_t index) const override {
+    if (index >= size_)
+      throw std::out_of_range("FrameRingDataset: index out of range");
+    const uint64_t sequence = first_ + index;
+    if (!reader_.waitFor(sequence, timeout_))
+      throw std::runtime_error("FrameRingDataset: frame not published");
+    std::optional<SharedFrame> frame = reader_.get(sequence);
+    if (!frame)
+      throw std::runtime_error("FrameRingDataset: frame overwritten");
+    return frame->template tensor<T>();
+  }
+
+  /**
+   * @brief Get the number of frames.
+   */
+  size_t size() const override { return size_; }
+};
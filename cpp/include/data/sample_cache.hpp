@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "data/data.hpp"
+#include "tensor/tensor.hpp"
+#include "utils/convert.h"
+
+/**
+ * @brief Dataset that keeps decoded samples in memory, optionally as 16-bit.
+ *
+ * Wraps a dataset whose samples are tensors (typically decoded and resized
+ * images) and stores each sample, converted to @p Storage, the first time it
+ * is requested. Later epochs are served from memory without decoding. With
+ * Storage = Half or BFloat16 the cache holds twice as many samples in the
+ * same budget and loaders read half the bytes.
+ *
+ * Samples are cached until @p capacity_bytes is reached; later samples are
+ * converted on every request. Returned tensors share the cached buffer and
+ * must be treated as read-only. getItem() is safe to call concurrently.
+ *
+ * @tparam Storage Element type of the cached samples.
+ * @tparam DatasetType Wrapped dataset with Tensor samples.
+ */
+template <typename Storage, typename DatasetType>
+class CachedDataset : public Dataset<Tensor<Storage>> {
+ private:
+  const DatasetType& source_;                    /**< Wrapped dataset */
+  size_t capacity_bytes_;                        /**< Cache budget */
+  mutable std::mutex mutex_;                     /**< Guards the fields below */
+  mutable std::vector<Tensor<Storage>> samples_; /**< Cached samples */
+  mutable size_t bytes_ = 0;                     /**< Bytes cached */
+  mutable size_t hits_ = 0;                      /**< Requests served */
+  mutable size_t misses_ = 0;                    /**< Requests decoded */
+
+ public:
+  /**
+   * @brief Wrap a dataset.
+   *
+   * @param source Dataset to cache; must outlive the cache.
+   * @param capacity_bytes Largest number of sample bytes to keep.
+   */
+  explicit CachedDataset(
+      const DatasetType& source,
+      size_t capacity_bytes = std::numeric_limits<size_t>::max())
+      : source_(source),
+        capacity_bytes_(capacity_bytes),
+        samples_(source.size()) {}
+
+  /**
+   * @brief Get a sample, decoding and caching it on first use.
+   *
+   * @param index The zero-based index of the sample.
+   * @return The sample converted to Storage.
+   * @throws std::out_of_range if @p index is out of range.
+   */
+  Tensor<Storage> getItem(size_t index) const override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (index >= samples_.size())
+        throw std::out_of_range("CachedDataset: index out of range");
+      if (!samples_[index].empty()) {
+        ++hits_;
+        return samples_[index];
+      }
+      ++misses_;
+    }
+    // Decode outside the lock so other samples can be served meanwhile.
+    Tensor<Storage> sample = tensor_cast<Storage>(source_.getItem(index));
+    const size_t bytes = sample.numel() * sizeof(Storage);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_[index].empty() && bytes <= capacity_bytes_ - bytes_) {
+      samples_[index] = sample;
+      bytes_ += bytes;
+    }
+    return samples_[index].empty() ? sample : samples_[index];
+  }
+
+  /**
+   * @brief Get the number of samples.
+   */
+  size_t size() const override { return samples_.size(); }
+
+  /**
+   * @brief Get the number of sample bytes held by the cache.
+   */
+  size_t bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+  }
+
+  /**
+   * @brief Get the number of requests served from the cache.
+   */
+  size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+
+  /**
+   * @brief Get the number of requests that decoded the sample.
+   */
+  size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+};
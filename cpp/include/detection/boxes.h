@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Set of axis-aligned detection boxes stored column-wise.
+ *
+ * Boxes are stored as a structure of arrays so that kernels touching a single
+ * attribute (e.g. scores during sorting, coordinates during overlap tests)
+ * stream through contiguous memory. Coordinates are in pixels with
+ * (x1, y1) the top-left and (x2, y2) the bottom-right corner.
+ */
+struct BoxSet {
+  std::vector<float> x1;       /**< Left edges */
+  std::vector<float> y1;       /**< Top edges */
+  std::vector<float> x2;       /**< Right edges */
+  std::vector<float> y2;       /**< Bottom edges */
+  std::vector<float> scores;   /**< Detection confidences */
+  std::vector<int32_t> labels; /**< Class indices */
+
+  /**
+   * @brief Get the number of boxes in the set.
+   *
+   * @return The number of boxes.
+   */
+  size_t size() const { return x1.size(); }
+
+  /**
+   * @brief Check whether the set contains no boxes.
+   *
+   * @return true if the set is empty, false otherwise.
+   */
+  bool empty() const { return x1.empty(); }
+
+  /**
+   * @brief Reserve storage for @p n boxes in every column.
+   *
+   * @param n The number of boxes to reserve space for.
+   */
+  void reserve(size_t n) {
+    x1.reserve(n);
+    y1.reserve(n);
+    x2.reserve(n);
+    y2.reserve(n);
+    scores.reserve(n);
+    labels.reserve(n);
+  }
+
+  /**
+   * @brief Remove all boxes from the set.
+   */
+  void clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    scores.clear();
+    labels.clear();
+  }
+
+  /**
+   * @brief Append a box to the set.
+   *
+   * @param bx1 Left edge.
+   * @param by1 Top edge.
+   * @param bx2 Right edge.
+   * @param by2 Bottom edge.
+   * @param score Detection confidence.
+   * @param label Class index.
+   */
+  void push_back(float bx1, float by1, float bx2, float by2, float score,
+                 int32_t label) {
+    x1.push_back(bx1);
+    y1.push_back(by1);
+    x2.push_back(bx2);
+    y2.push_back(by2);
+    scores.push_back(score);
+    labels.push_back(label);
+  }
+
+  /**
+   * @brief Get the area of box @p i.
+   *
+   * @param i Index of the box.
+   * @return The box area (0 for degenerate boxes).
+   */
+  float area(size_t i) const {
+    const float w = x2[i] - x1[i], h = y2[i] - y1[i];
+    return w > 0.f && h > 0.f ? w * h : 0.f;
+  }
+};
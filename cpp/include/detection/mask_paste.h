@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "detection/boxes.h"
+#include "detection/rle.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Parameters controlling how instance masks are pasted into an image.
+ */
+struct MaskPasteParams {
+  float threshold = .5f; /**< Probability at or above which a pixel is set */
+};
+
+/**
+ * @brief Paste per-instance mask predictions into image space as RLEs.
+ *
+ * Each low-resolution mask (typically 28x28) is bilinearly resampled over its
+ * box extent only, matching detectron2's `paste_masks_in_image` with
+ * `align_corners=False`, thresholded, and emitted directly as a run-length
+ * encoded full-image mask. No full-resolution buffer is allocated per
+ * instance. Instances are processed in parallel.
+ *
+ * @param masks Mask probabilities of shape [N, mask_height, mask_width].
+ * @param boxes The N boxes the masks were predicted for, in image pixels.
+ * @param height Image height in pixels.
+ * @param width Image width in pixels.
+ * @param params Paste parameters.
+ * @return One encoded mask per instance.
+ * @throws std::invalid_argument if @p masks and @p boxes disagree.
+ */
+std::vector<Rle> paste_masks_rle(const Tensor<float>& masks,
+                                 const BoxSet& boxes, size_t height,
+                                 size_t width,
+                                 const MaskPasteParams& params = {});
+
+/**
+ * @brief Paste per-instance mask predictions into a shared label image.
+ *
+ * Pixels covered by instance `i` are set to `i + 1`; background stays 0.
+ * Where instances overlap, the one with the higher score wins (ties go to the
+ * lower index), independent of the order in which the parallel workers run.
+ * Only box extents are touched, so @p labels should be zeroed by the caller.
+ *
+ * @param masks Mask probabilities of shape [N, mask_height, mask_width].
+ * @param boxes The N boxes the masks were predicted for, in image pixels.
+ * @param labels Label image of shape [height, width].
+ * @param params Paste parameters.
+ * @throws std::invalid_argument if @p masks, @p boxes and @p labels disagree.
+ */
+void paste_masks_label_image(const Tensor<float>& masks, const BoxSet& boxes,
+                             Tensor<int32_t>& labels,
+                             const MaskPasteParams& params = {});
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "detection/boxes.h"
+#include "detection/rle.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Parameters of the panoptic merging stage.
+ *
+ * Panoptic ids are packed as `category * label_divisor + instance`, where
+ * `instance` counts from 1 per thing category and is 0 for stuff segments
+ * (the Panoptic-DeepLab / Cityscapes convention).
+ */
+struct PanopticParams {
+  float score_threshold = .5f;        /**< Min score of kept instances */
+  float overlap_threshold = .5f;      /**< Max already claimed fraction */
+  size_t stuff_area_threshold = 4096; /**< Min pixels of a stuff segment */
+  uint32_t label_divisor = 1000;      /**< Category multiplier in packed ids */
+  uint32_t void_id = 0;               /**< Id of pixels without a segment */
+};
+
+/**
+ * @brief Description of one segment in a panoptic image.
+ *
+ * Mirrors an entry of COCO panoptic `segments_info`.
+ */
+struct PanopticSegment {
+  uint32_t id = 0;        /**< Packed panoptic id */
+  int32_t category = 0;   /**< Class index */
+  bool is_thing = false;  /**< Whether the segment is an instance */
+  size_t area = 0;        /**< Number of pixels */
+  float score = 0.f;      /**< Instance score (0 for stuff) */
+  int64_t instance = -1;  /**< Index of the source instance (-1 for stuff) */
+};
+
+/**
+ * @brief Output of the panoptic merging stage.
+ */
+struct PanopticResult {
+  Tensor<uint32_t> ids;                  /**< Panoptic id image [H, W] */
+  std::vector<PanopticSegment> segments; /**< One entry per segment */
+};
+
+/**
+ * @brief Merge instance and semantic predictions into a panoptic image.
+ *
+ * Instances are visited in descending score order and painted from their run
+ * lengths directly, so only instance pixels are touched; an instance is
+ * dropped if more than `overlap_threshold` of it is already claimed by
+ * better instances, otherwise it takes the unclaimed remainder. The remaining
+ * pixels are then filled from the semantic label map for stuff classes in a
+ * single pass over the image. Stuff segments smaller than
+ * `stuff_area_threshold` are returned to void.
+ *
+ * @param masks Instance masks, all of the semantic map's size.
+ * @param instances Scores and labels of the instances (boxes are unused).
+ * @param semantic Semantic class per pixel, shape [H, W].
+ * @param is_stuff Flag per semantic class; classes not flagged (or out of
+ * range) are never painted from the semantic map. With the default `void_id`
+ * of 0, class 0 should be the semantic background and not flagged.
+ * @param params Merging parameters.
+ * @return The panoptic id image and its segment descriptions.
+ * @throws std::invalid_argument if the inputs disagree in count or size.
+ */
+PanopticResult panoptic_merge(const std::vector<Rle>& masks,
+                              const BoxSet& instances,
+                              const Tensor<int32_t>& semantic,
+                              const std::vector<bool>& is_stuff,
+                              const PanopticParams& params = {});
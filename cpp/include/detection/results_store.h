@@ -0,0 +1,276 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "detection/boxes.h"
+#include "detection/spatial_index.h"
+#include "utils/mapped_file.h"
+
+/**
+ * @brief Entry of a results store class dictionary.
+ */
+struct ResultsClass {
+  int32_t label = 0; /**< Class index as found in BoxSet::labels */
+  std::string name;  /**< Human readable class name (may be empty) */
+};
+
+/**
+ * @brief Zone map summarising one block of a results store.
+ *
+ * Scans compare a query against these bounds to skip whole blocks without
+ * touching their column data.
+ */
+struct ResultsBlockInfo {
+  uint64_t offset = 0;      /**< Byte offset of the block in the file */
+  uint32_t rows = 0;        /**< Number of detections in the block */
+  uint32_t frame_bytes = 0; /**< Size of the varint frame id column */
+  int64_t frame_min = 0;    /**< Smallest frame id */
+  int64_t frame_max = 0;    /**< Largest frame id */
+  float score_min = 0.f;    /**< Smallest score */
+  float score_max = 0.f;    /**< Largest score */
+  float x_min = 0.f;        /**< Smallest left edge */
+  float y_min = 0.f;        /**< Smallest top edge */
+  float x_max = 0.f;        /**< Largest right edge */
+  float y_max = 0.f;        /**< Largest bottom edge */
+  uint64_t class_mask = 0;  /**< Bit c set if class code c (mod 64) occurs */
+};
+
+/**
+ * @brief Filter applied by ResultsStoreReader::scan().
+ *
+ * Every condition must hold for a detection to be returned. Ranges are
+ * inclusive and default to matching everything.
+ */
+struct ResultsQuery {
+  int64_t frame_min = std::numeric_limits<int64_t>::min(); /**< First frame */
+  int64_t frame_max = std::numeric_limits<int64_t>::max(); /**< Last frame */
+  float min_score = -std::numeric_limits<float>::infinity(); /**< Score floor */
+  std::vector<int32_t> labels;         /**< Accepted classes (empty = all) */
+  std::optional<SpatialWindow> window; /**< Boxes must intersect this */
+};
+
+/**
+ * @brief Detections returned by a scan, in storage order.
+ */
+struct ResultsRows {
+  std::vector<int64_t> frame_ids; /**< Frame id of every detection */
+  BoxSet boxes;                   /**< Boxes, scores and class labels */
+};
+
+/**
+ * @brief Block counters reported by a scan.
+ */
+struct ResultsScanStats {
+  size_t blocks_total = 0;   /**< Blocks in the store */
+  size_t blocks_skipped = 0; /**< Blocks rejected by their zone map */
+  size_t rows_scanned = 0;   /**< Rows of blocks that were decoded */
+};
+
+/**
+ * @brief Append-only writer of a columnar detection results store.
+ *
+ * Detections are buffered and written in blocks of a fixed number of rows.
+ * Each block stores its columns contiguously:
+ *
+ *   scores, x1, y1, x2, y2 : float32[rows]
+ *   classes                : uint16[rows], codes into the class dictionary
+ *   frame ids              : zigzag LEB128 varints of the delta to the
+ *                            previous row (the first row is relative to the
+ *                            block's smallest frame id)
+ *
+ * Blocks are padded to 8 bytes. Every flush() (and close()) then appends a
+ * footer holding the zone maps of the blocks and the dictionary entries
+ * added since the previous footer, padded to 8 bytes, followed by a
+ * fixed-size trailer pointing at the footer. Each footer links to the
+ * trailer before it, so the newest trailer reaches the whole index. Nothing
+ * indexed is ever overwritten: if the writer dies, the store stays readable
+ * up to its last flush(), and reopening it for appending continues after
+ * that footer, so a store can grow across runs. Files use the host
+ * (little-endian) byte order.
+ */
+class ResultsStoreWriter {
+ private:
+  std::ofstream out_;                      /**< Output stream */
+  std::string path_;                       /**< Path of the store */
+  uint32_t rows_per_block_;                /**< Rows per full block */
+  uint64_t offset_ = 0;                    /**< Current end of the file */
+  uint64_t last_trailer_ = 0;              /**< Newest trailer (0: none) */
+  std::vector<ResultsBlockInfo> blocks_;   /**< Zone maps of written blocks */
+  std::vector<ResultsClass> classes_;      /**< Class dictionary */
+  size_t indexed_blocks_ = 0;              /**< Blocks covered by a footer */
+  size_t indexed_classes_ = 0;             /**< Classes covered by a footer */
+  std::vector<std::string> class_names_;   /**< Names indexed by label */
+  std::vector<int64_t> frames_;            /**< Buffered frame ids */
+  BoxSet pending_;                         /**< Buffered detections */
+  bool open_ = false;                      /**< Whether close() is pending */
+
+ public:
+  /**
+   * @brief Create a store, or reopen one for appending.
+   *
+   * @param path Path of the store file.
+   * @param class_names Optional class names indexed by label, recorded in
+   *        the dictionary the first time each label is written.
+   * @param append Append to an existing store instead of truncating it.
+   * @param rows_per_block Rows per block; ignored when appending, where the
+   *        value stored in the file is kept. Appending to a store whose
+   *        writer died drops whatever followed its last footer.
+   * @throws std::runtime_error if the file cannot be opened or an existing
+   *         store is malformed.
+   * @throws std::invalid_argument if @p rows_per_block is zero.
+   */
+  explicit ResultsStoreWriter(const std::string& path,
+                              std::vector<std::string> class_names = {},
+                              bool append = false,
+                              uint32_t rows_per_block = 4096);
+
+  /**
+   * @brief Flush pending rows and finalise the store.
+   */
+  ~ResultsStoreWriter();
+
+  ResultsStoreWriter(const ResultsStoreWriter&) = delete;
+  ResultsStoreWriter& operator=(const ResultsStoreWriter&) = delete;
+
+  /**
+   * @brief Append the detections of one frame.
+   *
+   * @param frame_id Identifier of the frame the boxes belong to.
+   * @param boxes Detections of the frame.
+   * @throws std::length_error if more than 65536 distinct classes are used.
+   */
+  void append(int64_t frame_id, const BoxSet& boxes);
+
+  /**
+   * @brief Write buffered rows as a (possibly short) block and index it.
+   *
+   * Appends a footer for the blocks written since the last one and hands
+   * the file to the OS, so the rows survive the writer process dying.
+   * Rows appended since the last flush() may be lost in that case.
+   *
+   * @throws std::runtime_error if writing fails.
+   */
+  void flush();
+
+  /**
+   * @brief Flush and close the file. Further appends are not allowed.
+   *
+   * @throws std::runtime_error if writing fails.
+   */
+  void close();
+
+ private:
+  uint16_t classCode(int32_t label);
+  void writeBlock();
+  void writeFooter();
+};
+
+/**
+ * @brief Memory-mapped reader of a columnar detection results store.
+ *
+ * Opening only parses the footers; column data is paged in lazily by the OS
+ * as scans touch it. Blocks whose zone map cannot satisfy a query are
+ * skipped without reading their pages. The spatial bounds of the zone maps
+ * are indexed by a PackedRTree, so window and nearest-neighbour queries
+ * only look at the blocks near the query instead of testing every block.
+ * A store whose writer died is read up to its newest intact footer; the
+ * torn tail after it is ignored.
+ */
+class ResultsStoreReader {
+ private:
+  MappedFile file_;                      /**< Mapping of the store */
+  uint32_t rows_per_block_ = 0;          /**< Rows per full block */
+  uint64_t data_end_ = 0;                /**< End of the newest trailer */
+  std::vector<ResultsBlockInfo> blocks_; /**< Zone map of every block */
+  std::vector<ResultsClass> classes_;    /**< Class dictionary */
+  size_t rows_ = 0;                      /**< Total number of detections */
+  std::optional<PackedRTree> block_tree_; /**< R-tree over block bounds */
+
+  void readIndex(uint64_t trailer);
+
+  /**
+   * @brief Map the labels of @p query to dictionary codes.
+   *
+   * @param query Query whose labels are translated.
+   * @param class_mask Receives the block class mask of the accepted codes.
+   * @return Whether each code is accepted; empty if all are.
+   */
+  std::vector<bool> acceptedCodes(const ResultsQuery& query,
+                                  uint64_t& class_mask) const;
+
+  /**
+   * @brief Append the rows of block @p b matching @p query to @p out.
+   */
+  void scanBlock(const ResultsBlockInfo& b, const ResultsQuery& query,
+                 const std::vector<bool>& accept, ResultsRows& out) const;
+
+ public:
+  /**
+   * @brief Map a store and read its footers.
+   *
+   * @param path Path of the store file.
+   * @throws std::system_error if the file cannot be mapped.
+   * @throws std::runtime_error if the file is not a valid store.
+   */
+  explicit ResultsStoreReader(const std::string& path);
+
+  /**
+   * @brief Get the number of detections in the store.
+   */
+  size_t size() const { return rows_; }
+
+  /**
+   * @brief Get the configured number of rows per block.
+   */
+  uint32_t rowsPerBlock() const { return rows_per_block_; }
+
+  /**
+   * @brief Get the zone maps of all blocks.
+   */
+  const std::vector<ResultsBlockInfo>& blocks() const { return blocks_; }
+
+  /**
+   * @brief Get the class dictionary in code order.
+   */
+  const std::vector<ResultsClass>& classes() const { return classes_; }
+
+  /**
+   * @brief Offset just past the newest intact trailer.
+   *
+   * Equals the file size unless a writer died after its last flush().
+   */
+  uint64_t dataEnd() const { return data_end_; }
+
+  /**
+   * @brief Return all detections matching @p query.
+   *
+   * @param query Filter to apply.
+   * @param stats Optional block and row counters of the scan.
+   * @return Matching detections in storage order.
+   */
+  ResultsRows scan(const ResultsQuery& query = {},
+                   ResultsScanStats* stats = nullptr) const;
+
+  /**
+   * @brief Return the detections matching @p query closest to a point.
+   *
+   * Distance is measured from the point to the nearest point of each box,
+   * as in PackedRTree::nearest(). Blocks are visited by increasing distance
+   * of their zone map until none can hold a closer detection.
+   *
+   * @param x Query point x coordinate.
+   * @param y Query point y coordinate.
+   * @param k Maximum number of results.
+   * @param query Filter the results must also match.
+   * @param stats Optional block and row counters of the search.
+   * @return Up to @p k detections ordered by increasing distance.
+   */
+  ResultsRows nearest(float x, float y, size_t k,
+                      const ResultsQuery& query = {},
+                      ResultsScanStats* stats = nullptr) const;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Run-length encoded binary mask.
+ *
+ * Uses the COCO convention: pixels are traversed in column-major order and
+ * @ref counts holds alternating run lengths of 0s and 1s, starting with 0s
+ * (the first run may have length zero). This makes masks interchangeable with
+ * pycocotools on the Python side.
+ */
+struct Rle {
+  size_t height = 0;             /**< Mask height in pixels */
+  size_t width = 0;              /**< Mask width in pixels */
+  std::vector<uint32_t> counts;  /**< Alternating 0/1 run lengths */
+};
+
+/**
+ * @brief Incrementally build an Rle from runs in column-major order.
+ *
+ * Consecutive runs of the same value are merged, so producers can append
+ * pixel by pixel or span by span without caring about run boundaries.
+ */
+class RleBuilder {
+ private:
+  Rle rle_;            /**< Mask under construction */
+  bool value_ = false; /**< Value of the currently open run */
+  size_t run_ = 0;     /**< Length of the currently open run */
+  size_t total_ = 0;   /**< Pixels appended so far */
+
+ public:
+  /**
+   * @brief Start building a mask of the given size.
+   *
+   * @param height Mask height in pixels.
+   * @param width Mask width in pixels.
+   */
+  RleBuilder(size_t height, size_t width);
+
+  /**
+   * @brief Append @p length pixels of the given value.
+   *
+   * @param value Pixel value of the span.
+   * @param length Number of pixels in the span.
+   */
+  void append(bool value, size_t length);
+
+  /**
+   * @brief Finish the mask, padding any remaining pixels with 0s.
+   *
+   * @return The encoded mask. The builder must not be used afterwards.
+   */
+  Rle finish();
+};
+
+/**
+ * @brief Encode a binary mask.
+ *
+ * @param mask Row-major mask of @p height x @p width bytes (non-zero = set).
+ * @param height Mask height in pixels.
+ * @param width Mask width in pixels.
+ * @return The run-length encoded mask.
+ */
+Rle rle_encode(const uint8_t* mask, size_t height, size_t width);
+
+/**
+ * @brief Decode a mask into a row-major byte image.
+ *
+ * @param rle The encoded mask.
+ * @param mask Destination of height x width bytes, receives 0 or 1.
+ */
+void rle_decode(const Rle& rle, uint8_t* mask);
+
+/**
+ * @brief Count the set pixels of an encoded mask.
+ *
+ * @param rle The encoded mask.
+ * @return The number of pixels with value 1.
+ */
+size_t rle_area(const Rle& rle);
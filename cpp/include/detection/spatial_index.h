@@ -0,0 +1,164 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "detection/boxes.h"
+
+/**
+ * @brief Optional predicate restricting spatial query results.
+ *
+ * Receives the index of a candidate box in the indexed BoxSet and returns
+ * whether it should be reported, e.g. to restrict results to a class or a
+ * frame range stored alongside the boxes. An empty filter accepts everything.
+ */
+using SpatialFilter = std::function<bool(uint32_t)>;
+
+/**
+ * @brief Axis-aligned query window in the coordinates of the indexed boxes.
+ */
+struct SpatialWindow {
+  float x1 = 0.f; /**< Left edge */
+  float y1 = 0.f; /**< Top edge */
+  float x2 = 0.f; /**< Right edge */
+  float y2 = 0.f; /**< Bottom edge */
+};
+
+/**
+ * @brief Static, bulk-loaded R-tree over a BoxSet.
+ *
+ * Boxes are sorted along a Hilbert curve of their centres and packed bottom-up
+ * into full nodes, so the tree has minimal height, no slack and lives in two
+ * flat arrays (as in the flatbush library). The tree is immutable once built;
+ * it is meant for large, write-once collections such as a scene or an archive
+ * of detections.
+ */
+class PackedRTree {
+ private:
+  size_t node_size_;                /**< Maximum children per node */
+  size_t num_items_;                /**< Number of indexed boxes */
+  std::vector<float> bounds_;       /**< x1, y1, x2, y2 per node */
+  std::vector<uint32_t> refs_;      /**< Item index (leaf) or first child */
+  std::vector<size_t> level_ends_;  /**< One past the last node per level */
+
+ public:
+  /** Default maximum number of children per node. */
+  static constexpr size_t kDefaultNodeSize = 16;
+
+  /**
+   * @brief Build the tree over all boxes of @p boxes.
+   *
+   * @param boxes Boxes to index. Result indices refer to positions in it.
+   * @param node_size Maximum number of children per node (at least 2).
+   */
+  explicit PackedRTree(const BoxSet& boxes,
+                       size_t node_size = kDefaultNodeSize);
+
+  /**
+   * @brief Get the number of indexed boxes.
+   *
+   * @return The number of boxes.
+   */
+  size_t size() const { return num_items_; }
+
+  /**
+   * @brief Find all boxes intersecting a window.
+   *
+   * @param window The query window (edges are inclusive).
+   * @param results Receives the indices of the matching boxes (appended).
+   * @param filter Optional predicate applied to candidates.
+   */
+  void search(const SpatialWindow& window, std::vector<uint32_t>& results,
+              const SpatialFilter& filter = {}) const;
+
+  /**
+   * @brief Find the boxes closest to a point.
+   *
+   * Distance is measured from the point to the nearest point of each box, so
+   * boxes containing the point have distance 0.
+   *
+   * @param x Query point x coordinate.
+   * @param y Query point y coordinate.
+   * @param k Maximum number of results.
+   * @param max_distance Boxes further away are ignored.
+   * @param filter Optional predicate applied to candidates.
+   * @return Indices of up to @p k boxes ordered by increasing distance.
+   */
+  std::vector<uint32_t> nearest(
+      float x, float y, size_t k,
+      float max_distance = std::numeric_limits<float>::infinity(),
+      const SpatialFilter& filter = {}) const;
+};
+
+/**
+ * @brief Uniform grid over a BoxSet.
+ *
+ * Each box is registered in every cell it overlaps (cells stored in CSR form).
+ * Building is a couple of linear passes, which makes the grid the better
+ * choice for per-frame indexes of evenly spread boxes; the R-tree adapts
+ * better to clustered data.
+ */
+class UniformGrid {
+ private:
+  BoxSet boxes_;                   /**< Copy of the indexed coordinates */
+  float origin_x_ = 0.f;           /**< Left edge of the grid */
+  float origin_y_ = 0.f;           /**< Top edge of the grid */
+  float cell_size_ = 1.f;          /**< Side length of one cell */
+  size_t cols_ = 0;                /**< Number of cell columns */
+  size_t rows_ = 0;                /**< Number of cell rows */
+  std::vector<uint32_t> offsets_;  /**< Start of each cell in items_ */
+  std::vector<uint32_t> items_;    /**< Box indices grouped by cell */
+
+ public:
+  /**
+   * @brief Build the grid over all boxes of @p boxes.
+   *
+   * @param boxes Boxes to index. Result indices refer to positions in it.
+   * @param cell_size Side length of a grid cell, in box coordinates.
+   * @throws std::invalid_argument if @p cell_size is not positive.
+   */
+  UniformGrid(const BoxSet& boxes, float cell_size);
+
+  /**
+   * @brief Get the number of indexed boxes.
+   *
+   * @return The number of boxes.
+   */
+  size_t size() const { return boxes_.size(); }
+
+  /**
+   * @brief Find all boxes intersecting a window.
+   *
+   * Each box is reported once even if it spans several cells.
+   *
+   * @param window The query window (edges are inclusive).
+   * @param results Receives the indices of the matching boxes (appended).
+   * @param filter Optional predicate applied to candidates.
+   */
+  void search(const SpatialWindow& window, std::vector<uint32_t>& results,
+              const SpatialFilter& filter = {}) const;
+
+  /**
+   * @brief Find the boxes closest to a point.
+   *
+   * Cells are visited in rings of increasing distance until no unvisited cell
+   * can hold a closer box.
+   *
+   * @param x Query point x coordinate.
+   * @param y Query point y coordinate.
+   * @param k Maximum number of results.
+   * @param max_distance Boxes further away are ignored.
+   * @param filter Optional predicate applied to candidates.
+   * @return Indices of up to @p k boxes ordered by increasing distance.
+   */
+  std::vector<uint32_t> nearest(
+      float x, float y, size_t k,
+      float max_distance = std::numeric_limits<float>::infinity(),
+      const SpatialFilter& filter = {}) const;
+
+ private:
+  size_t cellX(float x) const;
+  size_t cellY(float y) const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+
+#include "detection/boxes.h"
+
+/**
+ * @brief Position of a tile's top-left corner in full-image coordinates.
+ */
+struct TileOffset {
+  float x = 0.f; /**< Horizontal offset in pixels */
+  float y = 0.f; /**< Vertical offset in pixels */
+};
+
+/**
+ * @brief Parameters for merging detections of overlapping tiles.
+ */
+struct TileMergeParams {
+  float iou_threshold = .5f; /**< Boxes overlapping more are duplicates */
+  bool class_aware = true;   /**< Only suppress boxes of the same class */
+};
+
+/**
+ * @brief Merge per-tile detections of a large scene into one BoxSet.
+ *
+ * Boxes are shifted into full-image coordinates and duplicates produced by
+ * overlapping tiles are removed with greedy non-maximum suppression. Overlap
+ * candidates are found with a PackedRTree window query instead of comparing
+ * every pair, so merging stays fast for scenes with many thousands of boxes.
+ *
+ * @param tiles Detections of each tile, in tile coordinates.
+ * @param offsets Offset of each tile within the full image.
+ * @param params Merge parameters.
+ * @return Surviving detections in full-image coordinates, best score first.
+ * @throws std::invalid_argument if @p tiles and @p offsets differ in size.
+ */
+BoxSet merge_tile_detections(const std::vector<BoxSet>& tiles,
+                             const std::vector<TileOffset>& offsets,
+                             const TileMergeParams& params = {});
@@ -0,0 +1,235 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "ops/gemm.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Geometry of a 2D convolution.
+ *
+ * Padding may be asymmetric (as produced by "SAME" padding in ONNX and
+ * TensorFlow models).
+ */
+struct Conv2dParams {
+  size_t stride_h = 1;   /**< Vertical stride */
+  size_t stride_w = 1;   /**< Horizontal stride */
+  size_t pad_top = 0;    /**< Zero rows added above the input */
+  size_t pad_left = 0;   /**< Zero columns added left of the input */
+  size_t pad_bottom = 0; /**< Zero rows added below the input */
+  size_t pad_right = 0;  /**< Zero columns added right of the input */
+  size_t dilation_h = 1; /**< Vertical kernel dilation */
+  size_t dilation_w = 1; /**< Horizontal kernel dilation */
+  size_t groups = 1;     /**< Number of channel groups */
+};
+
+/**
+ * @brief Memory layout of convolution activations.
+ */
+enum class ConvLayout {
+  kNchw,  /**< Plain [N, C, H, W] */
+  kNchwc, /**< Blocked [N, ceil(C / c), H, W, c] with c = nchwc_block() */
+};
+
+/**
+ * @brief Convolution implementation.
+ */
+enum class ConvAlgorithm {
+  kAuto,      /**< Pick the best algorithm for the shape and layout */
+  kGemm,      /**< 1x1, stride 1, unpadded: a single GEMM per group (NCHW) */
+  kIm2col,    /**< Lower to im2col followed by GEMM (NCHW) */
+  kDirect,    /**< Register-blocked direct convolution (NCHWc, groups = 1) */
+  kDepthwise, /**< Depthwise direct convolution (groups = C_in = C_out) */
+  kWinograd,  /**< Winograd F(4x4, 3x3), stride 1, ungrouped (NCHW) */
+};
+
+/**
+ * @brief Elementwise tail fused into a convolution.
+ *
+ * The output becomes `clamp(conv(x) + bias + residual, clamp_min,
+ * clamp_max)`, computed by each kernel on freshly written output rows so
+ * residual adds and activations (ReLU, ReLU6) cost no extra pass over memory.
+ */
+struct ConvEpilogue {
+  const Tensor<float>* residual = nullptr; /**< Output-shaped addend or null */
+  float clamp_min = -std::numeric_limits<float>::infinity(); /**< Floor */
+  float clamp_max = std::numeric_limits<float>::infinity();  /**< Ceiling */
+};
+
+/**
+ * @brief Get the channel block size of the NCHWc layout on this CPU.
+ *
+ * @return 16 when AVX-512 is available, 8 otherwise.
+ */
+size_t nchwc_block();
+
+/**
+ * @brief Compute the output extent of a convolution along one axis.
+ *
+ * @param input Input extent.
+ * @param kernel Kernel extent.
+ * @param stride Stride.
+ * @param pad_begin Padding before the first element.
+ * @param pad_end Padding after the last element.
+ * @param dilation Kernel dilation.
+ * @return The output extent (0 if the kernel does not fit).
+ */
+size_t conv_output_size(size_t input, size_t kernel, size_t stride,
+                        size_t pad_begin, size_t pad_end, size_t dilation);
+
+/**
+ * @brief Convert an NCHW tensor to the blocked NCHWc layout.
+ *
+ * Channels beyond C in the last block are zero.
+ *
+ * @param src Tensor of shape [N, C, H, W].
+ * @param dst Tensor of shape [N, ceil(C / c), H, W, c].
+ * @throws std::invalid_argument if the shapes do not match.
+ */
+void nchw_to_nchwc(const Tensor<float>& src, Tensor<float>& dst);
+
+/**
+ * @brief Convert an NCHWc tensor back to the plain NCHW layout.
+ *
+ * @param src Tensor of shape [N, ceil(C / c), H, W, c].
+ * @param dst Tensor of shape [N, C, H, W].
+ * @throws std::invalid_argument if the shapes do not match.
+ */
+void nchwc_to_nchw(const Tensor<float>& src, Tensor<float>& dst);
+
+/**
+ * @brief Convert an NCHW tensor to the blocked NCHWc layout.
+ *
+ * @param src Tensor of shape [N, C, H, W].
+ * @param block Channel block size c.
+ * @return Tensor of shape [N, ceil(C / c), H, W, c].
+ */
+Tensor<float> to_nchwc(const Tensor<float>& src, size_t block);
+
+/**
+ * @brief Convert an NCHWc tensor back to the plain NCHW layout.
+ *
+ * @param src Tensor of shape [N, ceil(C / c), H, W, c].
+ * @param channels Number of real channels C.
+ * @return Tensor of shape [N, C, H, W].
+ */
+Tensor<float> to_nchw(const Tensor<float>& src, size_t channels);
+
+/**
+ * @brief 2D convolution layer with weights prepared at construction.
+ *
+ * The constructor validates the geometry, selects an algorithm and stores
+ * the weights in the form that algorithm consumes (packed GEMM panels,
+ * Winograd-domain filters or channel-blocked filters), so forward() only
+ * touches activations.
+ *
+ * Activations use the layout given at construction. NCHWc tensors must use
+ * the block size returned by block().
+ */
+class Conv2d {
+ private:
+  Conv2dParams params_;                   /**< Convolution geometry */
+  ConvLayout layout_;                     /**< Activation layout */
+  ConvAlgorithm algorithm_;               /**< Selected implementation */
+  size_t in_channels_;                    /**< Input channels */
+  size_t out_channels_;                   /**< Output channels */
+  size_t kernel_h_;                       /**< Kernel height */
+  size_t kernel_w_;                       /**< Kernel width */
+  size_t block_ = 0;                      /**< NCHWc channel block */
+  std::vector<GemmPackedA> gemm_weights_; /**< Packed per group/position */
+  Tensor<float> weights_;                 /**< Blocked direct weights */
+  Tensor<float> bias_;                    /**< Bias (padded to blocks) */
+
+ public:
+  /**
+   * @brief Prepare a convolution layer.
+   *
+   * @param weight Filters of shape [C_out, C_in / groups, KH, KW].
+   * @param bias Bias of shape [C_out], or an empty tensor for no bias.
+   * @param params Convolution geometry.
+   * @param layout Layout of input and output activations.
+   * @param algorithm Implementation to use (kAuto selects by shape).
+   * @param prepacked GEMM operands saved from packedWeights() of an identical
+   *        layer under the same sgemm_pack_key(), used instead of packing
+   *        @p weight (e.g. views of a memory-mapped cache). Empty to pack.
+   * @throws std::invalid_argument if the parameters are inconsistent, the
+   *         requested algorithm does not support them, or @p prepacked does
+   *         not match the layer.
+   */
+  Conv2d(const Tensor<float>& weight, const Tensor<float>& bias,
+         const Conv2dParams& params, ConvLayout layout = ConvLayout::kNchw,
+         ConvAlgorithm algorithm = ConvAlgorithm::kAuto,
+         std::vector<GemmPackedA> prepacked = {});
+
+  /**
+   * @brief Get the selected algorithm.
+   */
+  ConvAlgorithm algorithm() const { return algorithm_; }
+
+  /**
+   * @brief Get the activation layout.
+   */
+  ConvLayout layout() const { return layout_; }
+
+  /**
+   * @brief Get the NCHWc channel block size (0 for NCHW layers).
+   */
+  size_t block() const { return block_; }
+
+  /**
+   * @brief Get the number of input channels.
+   */
+  size_t inChannels() const { return in_channels_; }
+
+  /**
+   * @brief Get the number of output channels.
+   */
+  size_t outChannels() const { return out_channels_; }
+
+  /**
+   * @brief Get the convolution geometry.
+   */
+  const Conv2dParams& params() const { return params_; }
+
+  /**
+   * @brief Get the packed GEMM operands.
+   *
+   * @return One matrix per group for kGemm and kIm2col, 36 for kWinograd,
+   *         none for the direct algorithms.
+   */
+  const std::vector<GemmPackedA>& packedWeights() const {
+    return gemm_weights_;
+  }
+
+  /**
+   * @brief Compute the output shape for an input shape.
+   *
+   * @param input Input shape in the layer's layout.
+   * @return Output shape in the layer's layout.
+   * @throws std::invalid_argument if the input shape is not compatible.
+   */
+  Shape outputShape(const Shape& input) const;
+
+  /**
+   * @brief Run the convolution.
+   *
+   * Scratch space (im2col buffers) is kept per thread and reused, so
+   * repeated calls with the same shapes do not allocate.
+   *
+   * @param input Input activations.
+   * @param output Output activations of shape outputShape(input.shape()).
+   * @param epilogue Residual add and clamp fused into the kernels.
+   * @throws std::invalid_argument if the shapes are not compatible.
+   */
+  void forward(const Tensor<float>& input, Tensor<float>& output,
+               const ConvEpilogue& epilogue = {}) const;
+
+  /**
+   * @brief Run the convolution, allocating the output.
+   *
+   * @param input Input activations.
+   * @return Output activations.
+   */
+  Tensor<float> forward(const Tensor<float>& input) const;
+};
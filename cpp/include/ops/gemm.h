@@ -0,0 +1,212 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <string>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Matrix A of a GEMM packed ahead of time into micro-kernel panels.
+ *
+ * Layers with constant weights (convolutions, linear layers) pack their weight
+ * matrix once with sgemm_pack_a() and reuse it on every call, so the packing
+ * cost is paid at model load instead of per inference.
+ */
+struct GemmPackedA {
+  size_t m = 0;        /**< Rows of A */
+  size_t k = 0;        /**< Columns of A (the reduction dimension) */
+  size_t mr = 0;       /**< Rows per micro-panel of the packing kernel */
+  size_t nr = 0;       /**< Columns per micro-tile of the packing kernel */
+  Tensor<float> data;  /**< Packed panels */
+
+  /**
+   * @brief Check whether the packed matrix holds no data.
+   */
+  bool empty() const { return data.empty(); }
+};
+
+/**
+ * @brief Elementwise tail fused into sgemm_packed().
+ *
+ * Each micro-tile of C is finished with
+ * `C = clamp(C + row_bias[i] + residual[i, j], clamp_min, clamp_max)` right
+ * after its last accumulation, while it is still in L1, instead of in a
+ * separate pass over C.
+ */
+struct GemmEpilogue {
+  const float* row_bias = nullptr; /**< Per-row bias of m values, or null */
+  const float* residual = nullptr; /**< [m, n] matrix added to C, or null */
+  size_t ldr = 0;                  /**< Row stride of the residual */
+  float clamp_min = -std::numeric_limits<float>::infinity(); /**< Floor */
+  float clamp_max = std::numeric_limits<float>::infinity();  /**< Ceiling */
+
+  /**
+   * @brief Check whether the epilogue changes C at all.
+   */
+  bool active() const {
+    return row_bias || residual ||
+           clamp_min > -std::numeric_limits<float>::infinity() ||
+           clamp_max < std::numeric_limits<float>::infinity();
+  }
+};
+
+/**
+ * @brief Cache blocking of sgemm() and sgemm_packed().
+ *
+ * The defaults suit common server parts; the best values depend on the
+ * cache sizes of the CPU, so they can be tuned per machine (see autotune()
+ * in runtime/autotune.h). Both are rounded down to whole micro-tiles. The
+ * depth of a packed panel is fixed, since pre-packed weights depend on it.
+ */
+struct GemmBlocking {
+  size_t mc = 144;  /**< Rows of a packed A block (sized for L2) */
+  size_t nc = 3072; /**< Columns of a packed B panel (sized for L3) */
+};
+
+/**
+ * @brief Get the cache blocking used by sgemm() and sgemm_packed().
+ *
+ * @return The blocking of the calling thread's innermost GemmBlockingScope,
+ *         or else the process-wide one.
+ */
+GemmBlocking sgemm_blocking();
+
+/**
+ * @brief Set the process-wide cache blocking of sgemm() and sgemm_packed().
+ *
+ * Affects calls started afterwards; results are identical for any
+ * blocking, only the speed changes.
+ *
+ * @param blocking New blocking; GemmBlocking{} restores the defaults.
+ * @throws std::invalid_argument if a block size is 0.
+ */
+void set_sgemm_blocking(const GemmBlocking& blocking);
+
+/**
+ * @brief Overrides the cache blocking of GEMMs called on this thread.
+ *
+ * Lets a caller such as a tuned Executor use its own blocking without
+ * touching the process-wide setting other threads rely on. Scopes nest and
+ * must be destroyed on the thread that created them, in reverse order.
+ */
+class GemmBlockingScope {
+ private:
+  GemmBlocking blocking_;        /**< Blocking in effect */
+  const GemmBlocking* previous_; /**< Enclosing scope's, or null */
+
+ public:
+  /**
+   * @brief Use @p blocking on this thread.
+   *
+   * @throws std::invalid_argument if a block size is 0.
+   */
+  explicit GemmBlockingScope(const GemmBlocking& blocking);
+
+  /**
+   * @brief Restore the enclosing blocking.
+   */
+  ~GemmBlockingScope();
+
+  GemmBlockingScope(const GemmBlockingScope&) = delete;
+  GemmBlockingScope& operator=(const GemmBlockingScope&) = delete;
+};
+
+/**
+ * @brief Single-precision general matrix multiply on row-major matrices.
+ *
+ * Computes `C = alpha * op(A) * op(B) + beta * C` where `op(A)` is [m, k],
+ * `op(B)` is [k, n] and C is [m, n]. The implementation follows the BLIS
+ * design: op(B) is packed into [kc, nc] panels that stay in L3, op(A) into
+ * [mc, kc] blocks that stay in L2, and a register-blocked FMA micro-kernel
+ * (AVX-512 12x32, AVX2 6x16 or a portable fallback, chosen at run time)
+ * computes each micro-tile of C. Macro-tiles are distributed over threads
+ * along both M and N, so short-and-wide products parallelise too.
+ *
+ * If @p beta is zero, C is not read, so it may hold uninitialised values.
+ *
+ * @param trans_a Use the transpose of A (A is stored [k, m]).
+ * @param trans_b Use the transpose of B (B is stored [n, k]).
+ * @param m Rows of op(A) and C.
+ * @param n Columns of op(B) and C.
+ * @param k Columns of op(A) and rows of op(B).
+ * @param alpha Scale applied to the product.
+ * @param a Matrix A.
+ * @param lda Row stride of A in elements.
+ * @param b Matrix B.
+ * @param ldb Row stride of B in elements.
+ * @param beta Scale applied to the existing contents of C.
+ * @param c Matrix C.
+ * @param ldc Row stride of C in elements.
+ */
+void sgemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+           float alpha, const float* a, size_t lda, const float* b, size_t ldb,
+           float beta, float* c, size_t ldc);
+
+/**
+ * @brief Pack `alpha * op(A)` for repeated use with sgemm_packed().
+ *
+ * @param trans_a Use the transpose of A (A is stored [k, m]).
+ * @param m Rows of op(A).
+ * @param k Columns of op(A).
+ * @param alpha Scale folded into the packed values.
+ * @param a Matrix A.
+ * @param lda Row stride of A in elements.
+ * @return The packed matrix, laid out for the micro-kernel of this CPU.
+ */
+GemmPackedA sgemm_pack_a(bool trans_a, size_t m, size_t k, float alpha,
+                         const float* a, size_t lda);
+
+/**
+ * @brief Get a key identifying the panel layout of sgemm_pack_a().
+ *
+ * Packed matrices only suit the micro-kernel that produced them, so caches
+ * of packed weights must be keyed by this string (e.g. "f32-12x32").
+ *
+ * @return The key for the micro-kernel selected on this CPU.
+ */
+std::string sgemm_pack_key();
+
+/**
+ * @brief Adopt panels packed earlier by sgemm_pack_a(), e.g. from a cache.
+ *
+ * No data is copied, so @p data may be a view of a memory-mapped file.
+ *
+ * @param m Rows of A.
+ * @param k Columns of A.
+ * @param data Panels packed with alpha already applied, under the current
+ *        sgemm_pack_key().
+ * @return The packed matrix.
+ * @throws std::invalid_argument if @p data has the wrong size.
+ */
+GemmPackedA sgemm_adopt_packed(size_t m, size_t k, Tensor<float> data);
+
+/**
+ * @brief General matrix multiply with a pre-packed left operand.
+ *
+ * Computes `C = A * op(B) + beta * C` where A was packed by sgemm_pack_a(),
+ * then applies @p epilogue to C.
+ *
+ * @param a Packed matrix of shape [m, k].
+ * @param trans_b Use the transpose of B (B is stored [n, k]).
+ * @param n Columns of op(B) and C.
+ * @param b Matrix B.
+ * @param ldb Row stride of B in elements.
+ * @param beta Scale applied to the existing contents of C.
+ * @param c Matrix C of shape [m, n].
+ * @param ldc Row stride of C in elements.
+ * @param epilogue Bias, residual and clamp applied to the result.
+ * @throws std::invalid_argument if @p a is empty.
+ */
+void sgemm_packed(const GemmPackedA& a, bool trans_b, size_t n, const float* b,
+                  size_t ldb, float beta, float* c, size_t ldc,
+                  const GemmEpilogue& epilogue = {});
+
+/**
+ * @brief Multiply two row-major matrices.
+ *
+ * @param a Matrix of shape [m, k].
+ * @param b Matrix of shape [k, n].
+ * @return The product of shape [m, n].
+ * @throws std::invalid_argument if the shapes are not compatible.
+ */
+Tensor<float> matmul(const Tensor<float>& a, const Tensor<float>& b);
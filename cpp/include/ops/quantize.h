@@ -0,0 +1,200 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ops/conv.h"
+#include "ops/gemm.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Affine mapping between real values and unsigned 8-bit codes.
+ *
+ * A code q represents `scale * (q - zero_point)`. Activations use this
+ * asymmetric form so that ReLU outputs spend all 256 codes on [0, max].
+ */
+struct QuantParams {
+  float scale = 1.f;      /**< Real value of one quantization step */
+  int32_t zero_point = 0; /**< Code representing 0.0, in [0, 255] */
+};
+
+/**
+ * @brief Choose unsigned 8-bit parameters covering a real range.
+ *
+ * The range is widened to include zero, so zero (the padding value) is
+ * exactly representable.
+ *
+ * @param min Smallest value to represent.
+ * @param max Largest value to represent.
+ * @return Parameters mapping [min, max] onto [0, 255].
+ * @throws std::invalid_argument if the range is not finite or min > max.
+ */
+QuantParams choose_quant_params(float min, float max);
+
+/**
+ * @brief Quantize real values to unsigned 8-bit codes.
+ *
+ * Values are rounded to nearest (ties to even) and saturated to [0, 255].
+ *
+ * @param x Values to quantize.
+ * @param n Number of values.
+ * @param params Target parameters.
+ * @param q Output codes.
+ */
+void quantize_u8(const float* x, size_t n, const QuantParams& params,
+                 uint8_t* q);
+
+/**
+ * @brief Left GEMM operand quantized per row and packed for qgemm().
+ *
+ * Every row of A is quantized symmetrically to signed codes in
+ * [-qmax, qmax] with its own scale, which for convolution weights is
+ * per-output-channel quantization. The codes are stored as [mr, 4] groups
+ * of four consecutive K values, the operand layout of `vpdpbusd` and
+ * `vpmaddubsw`.
+ */
+struct QGemmPackedA {
+  size_t m = 0;              /**< Rows of A */
+  size_t k = 0;              /**< Columns of A (the reduction dimension) */
+  size_t mr = 0;             /**< Rows per micro-panel of the kernel */
+  size_t nr = 0;             /**< Columns per micro-tile of the kernel */
+  int32_t qmax = 0;          /**< Largest code magnitude used */
+  Tensor<int8_t> data;       /**< Packed codes */
+  Tensor<float> scales;      /**< Per-row scale [m] */
+  Tensor<int32_t> row_sums;  /**< Per-row sum of codes [m] */
+
+  /**
+   * @brief Check whether the packed matrix holds no data.
+   */
+  bool empty() const { return data.empty(); }
+};
+
+/**
+ * @brief Quantize and pack a row-major matrix A for qgemm().
+ *
+ * The packing follows the integer micro-kernel selected for the CPU:
+ * AVX-512 VNNI 12x32, AVX-VNNI 6x16, AVX2 4x16 or a portable 4x8 fallback.
+ * The AVX2 kernel multiplies with `vpmaddubsw`, whose 16-bit pair sums
+ * saturate for full-range codes, so it packs weights with 7 bits
+ * (qmax = 63); the VNNI kernels accumulate in 32 bits and use qmax = 127.
+ *
+ * @param m Rows of A.
+ * @param k Columns of A.
+ * @param a Matrix A.
+ * @param lda Row stride of A in elements.
+ * @return Packed matrix.
+ */
+QGemmPackedA qgemm_quantize_a(size_t m, size_t k, const float* a, size_t lda);
+
+/**
+ * @brief Get the name of the integer micro-kernel used by qgemm_quantize_a().
+ *
+ * @return "avx512-vnni", "avx-vnni", "avx2" or "generic".
+ */
+const char* qgemm_kernel_name();
+
+/**
+ * @brief 8-bit integer matrix multiply with a pre-quantized left operand.
+ *
+ * Computes `C = A * op(B)` where A is the quantized [m, k] weight matrix and
+ * op(B) is a [k, n] matrix of unsigned codes with parameters @p b_params.
+ * Products are accumulated exactly in 32 bits and each micro-tile is
+ * dequantized as `scale_a[i] * scale_b * (acc - zero_point * row_sum[i])`
+ * before the epilogue is applied, so the float result never makes an extra
+ * pass over C. op(B) is repacked on every call into panels of groups of four
+ * K values, which the multiply reuses across all rows of A.
+ *
+ * @param a Operand from qgemm_quantize_a().
+ * @param trans_b Use the transpose of B (B is stored [n, k]).
+ * @param n Columns of op(B) and C.
+ * @param b Codes of B.
+ * @param ldb Row stride of B in elements.
+ * @param b_params Quantization of B.
+ * @param c Matrix C (overwritten).
+ * @param ldc Row stride of C in elements.
+ * @param epilogue Bias, residual and clamp applied to each tile of C.
+ * @throws std::invalid_argument if @p a was packed for another kernel.
+ */
+void qgemm(const QGemmPackedA& a, bool trans_b, size_t n, const uint8_t* b,
+           size_t ldb, const QuantParams& b_params, float* c, size_t ldc,
+           const GemmEpilogue& epilogue = {});
+
+/**
+ * @brief 2D convolution with 8-bit weights and activations (NCHW).
+ *
+ * Weights are quantized per output channel at construction. forward()
+ * quantizes the float input with the calibrated input parameters, lowers it
+ * to an 8-bit im2col matrix (padding with the zero point, so padded taps are
+ * exact zeros) and runs one qgemm() per group, with the bias, residual and
+ * clamp fused into the dequantization. Input and output stay float, so the
+ * layer is a drop-in replacement for Conv2d.
+ */
+class QConv2d {
+ private:
+  Conv2dParams params_;               /**< Geometry */
+  QuantParams input_;                 /**< Input quantization */
+  size_t in_channels_ = 0;            /**< C_in */
+  size_t out_channels_ = 0;           /**< C_out */
+  size_t kernel_h_ = 0;               /**< Kernel height */
+  size_t kernel_w_ = 0;               /**< Kernel width */
+  std::vector<QGemmPackedA> weights_; /**< One packed matrix per group */
+  Tensor<float> bias_;                /**< [C_out] or empty */
+
+ public:
+  /**
+   * @brief Quantize a convolution layer.
+   *
+   * @param weight Filters of shape [C_out, C_in / groups, KH, KW].
+   * @param bias Bias of shape [C_out], or an empty tensor.
+   * @param params Convolution geometry.
+   * @param input Quantization of the input activations.
+   * @throws std::invalid_argument if the shapes or geometry are invalid.
+   */
+  QConv2d(const Tensor<float>& weight, const Tensor<float>& bias,
+          const Conv2dParams& params, const QuantParams& input);
+
+  /**
+   * @brief Get the number of input channels.
+   */
+  size_t inChannels() const { return in_channels_; }
+
+  /**
+   * @brief Get the number of output channels.
+   */
+  size_t outChannels() const { return out_channels_; }
+
+  /**
+   * @brief Get the convolution geometry.
+   */
+  const Conv2dParams& params() const { return params_; }
+
+  /**
+   * @brief Get the input quantization.
+   */
+  const QuantParams& inputParams() const { return input_; }
+
+  /**
+   * @brief Get the packed weights, one matrix per group.
+   */
+  const std::vector<QGemmPackedA>& packedWeights() const { return weights_; }
+
+  /**
+   * @brief Compute the output shape for an input shape.
+   *
+   * @param input Input shape [N, C_in, H, W].
+   * @return Output shape [N, C_out, OH, OW].
+   * @throws std::invalid_argument if the input shape is not compatible.
+   */
+  Shape outputShape(const Shape& input) const;
+
+  /**
+   * @brief Run the convolution.
+   *
+   * @param input Input activations.
+   * @param output Output activations of shape outputShape(input.shape()).
+   * @param epilogue Residual add and clamp fused into the dequantization.
+   * @throws std::invalid_argument if the shapes are not compatible.
+   */
+  void forward(const Tensor<float>& input, Tensor<float>& output,
+               const ConvEpilogue& epilogue = {}) const;
+};
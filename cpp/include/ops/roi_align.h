@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Parameters of the ROIAlign operation.
+ *
+ * Semantics follow torchvision.ops.roi_align so that heads trained in Python
+ * produce identical features in the C++ core.
+ */
+struct RoiAlignParams {
+  size_t pooled_height = 7;  /**< Output bins along the y axis */
+  size_t pooled_width = 7;   /**< Output bins along the x axis */
+  float spatial_scale = 1.f; /**< Scale from box coordinates to feature map */
+  int sampling_ratio = 0;    /**< Samples per bin axis (<= 0: adaptive) */
+  bool aligned = true;       /**< Shift box coordinates by -0.5 pixel */
+};
+
+/**
+ * @brief Pool fixed-size features for each region of interest (ROIAlign).
+ *
+ * Each output bin is the average of a regular grid of bilinearly interpolated
+ * samples. Sampling positions and corner weights are precomputed per ROI and
+ * shared by all channels; channels are the innermost (contiguous) dimension
+ * so every corner read is a SIMD load. ROIs are processed in parallel.
+ *
+ * @param input Feature map in NHWC layout, shape [N, H, W, C].
+ * @param rois Regions of shape [R, 5], each row being
+ * (batch_index, x1, y1, x2, y2) in input image coordinates.
+ * @param output Destination of shape [R, pooled_height, pooled_width, C].
+ * @param params Pooling parameters.
+ * @throws std::invalid_argument if the tensor shapes are inconsistent.
+ */
+void roi_align(const Tensor<float>& input, const Tensor<float>& rois,
+               Tensor<float>& output, const RoiAlignParams& params);
+
+/**
+ * @brief Pool fixed-size features for each region of interest (ROIAlign).
+ *
+ * Convenience overload allocating the output tensor.
+ *
+ * @param input Feature map in NHWC layout, shape [N, H, W, C].
+ * @param rois Regions of shape [R, 5] as (batch_index, x1, y1, x2, y2).
+ * @param params Pooling parameters.
+ * @return Pooled features of shape [R, pooled_height, pooled_width, C].
+ */
+Tensor<float> roi_align(const Tensor<float>& input, const Tensor<float>& rois,
+                        const RoiAlignParams& params);
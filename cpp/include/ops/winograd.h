@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "ops/conv.h"
+#include "ops/gemm.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Check whether a convolution can use Winograd F(4x4, 3x3).
+ *
+ * @param params Convolution geometry.
+ * @param kernel_h Kernel height.
+ * @param kernel_w Kernel width.
+ * @return true for ungrouped 3x3 convolutions with stride and dilation 1.
+ */
+bool winograd_supported(const Conv2dParams& params, size_t kernel_h,
+                        size_t kernel_w);
+
+/**
+ * @brief Check whether Winograd F(4x4, 3x3) is expected to beat im2col.
+ *
+ * The transforms cost O(C_in + C_out) per tile while the transformed-domain
+ * GEMMs save a factor of four in multiplications on O(C_in * C_out) work, so
+ * Winograd wins once both channel counts are moderately large.
+ *
+ * @param params Convolution geometry.
+ * @param in_channels Input channels.
+ * @param out_channels Output channels.
+ * @param kernel_h Kernel height.
+ * @param kernel_w Kernel width.
+ * @return true if the shape is supported and likely profitable.
+ */
+bool winograd_profitable(const Conv2dParams& params, size_t in_channels,
+                         size_t out_channels, size_t kernel_h,
+                         size_t kernel_w);
+
+/**
+ * @brief Transform 3x3 filters into the Winograd domain.
+ *
+ * Computes `U = G g G^T` for every filter and packs the 36 resulting
+ * [C_out, C_in] matrices for sgemm_packed(), so the transform is paid once
+ * when the model is loaded.
+ *
+ * @param weight Filters of shape [C_out, C_in, 3, 3].
+ * @return 36 packed matrices, one per transformed-domain position.
+ * @throws std::invalid_argument if @p weight is not [C_out, C_in, 3, 3].
+ */
+std::vector<GemmPackedA> winograd_transform_weights(
+    const Tensor<float>& weight);
+
+/**
+ * @brief Run a stride-1 3x3 convolution with Winograd F(4x4, 3x3).
+ *
+ * Input tiles of 6x6 are transformed in parallel (`V = B^T d B`), multiplied
+ * with the cached filters by 36 independent GEMMs run as one parallel batch,
+ * and transformed back (`Y = A^T M A`) in parallel. Tiles are processed in
+ * blocks so the workspace stays small for high-resolution inputs.
+ *
+ * @param weights Filters from winograd_transform_weights().
+ * @param bias Bias of C_out values, or null.
+ * @param params Convolution geometry (only padding is used).
+ * @param input Input of shape [N, C_in, H, W].
+ * @param output Output of shape [N, C_out, OH, OW].
+ * @param epilogue Residual add and clamp applied by the output transform.
+ * @throws std::invalid_argument if the shapes do not match the weights.
+ */
+void winograd_conv(const std::vector<GemmPackedA>& weights, const float* bias,
+                   const Conv2dParams& params, const Tensor<float>& input,
+                   Tensor<float>& output, const ConvEpilogue& epilogue = {});
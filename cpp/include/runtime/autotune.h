@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ops/conv.h"
+#include "ops/gemm.h"
+#include "runtime/graph.h"
+#include "runtime/operators.h"
+#include "tensor/tensor.hpp"
+#include "utils/cpu_features.h"
+
+/**
+ * @brief Measured best configuration of one convolution shape.
+ */
+struct ConvTuning {
+  ConvAlgorithm algorithm = ConvAlgorithm::kAuto; /**< Fastest algorithm */
+  size_t threads = 0;  /**< Fastest thread count (0: process limit) */
+  double micros = 0.;  /**< Latency measured with that configuration */
+};
+
+/**
+ * @brief Persisted autotuning results of one machine type.
+ *
+ * Results are keyed by CPU model (see cpu_model()), since block sizes,
+ * algorithm and thread count optima differ between processor families. One
+ * file can be shared by a heterogeneous fleet: it holds one section per
+ * model and a database only reads and rewrites the section of its own
+ * model. The file is plain text:
+ *
+ *     cpu AMD EPYC 7763 64-Core Processor
+ *     gemm 144 3072
+ *     conv nchw:i1x64x56x56:o64:k3x3:s1x1:p1x1x1x1:d1x1:g1 winograd 8 412.5
+ *
+ * Lines starting with '#' are comments. save() replaces the file
+ * atomically, but concurrent writers may lose each other's additions.
+ */
+class TuningDatabase {
+ private:
+  std::string path_;                        /**< Backing file, or empty */
+  std::string cpu_;                         /**< CPU model of the entries */
+  std::optional<GemmBlocking> gemm_;        /**< Tuned GEMM blocking */
+  std::map<std::string, ConvTuning> convs_; /**< Tuning per conv key */
+
+ public:
+  /**
+   * @brief Open a database, reading the section of @p cpu if the file
+   * exists.
+   *
+   * @param path Backing file; empty for an in-memory database.
+   * @param cpu CPU model whose entries are used.
+   * @throws std::runtime_error if the file exists but is malformed.
+   */
+  explicit TuningDatabase(std::string path = {},
+                          std::string cpu = cpu_model());
+
+  /**
+   * @brief Get the backing file (empty if none).
+   */
+  const std::string& path() const { return path_; }
+
+  /**
+   * @brief Get the CPU model of the entries.
+   */
+  const std::string& cpu() const { return cpu_; }
+
+  /**
+   * @brief Get the number of tuned convolution shapes.
+   */
+  size_t size() const { return convs_.size(); }
+
+  /**
+   * @brief Get the tuning of a convolution shape.
+   *
+   * @param key Key from conv_tuning_key().
+   * @return The entry, or null if the shape was not tuned.
+   */
+  const ConvTuning* findConv(const std::string& key) const;
+
+  /**
+   * @brief Record the tuning of a convolution shape.
+   */
+  void setConv(const std::string& key, const ConvTuning& tuning);
+
+  /**
+   * @brief Get the tuned GEMM blocking, if any.
+   */
+  const std::optional<GemmBlocking>& gemm() const { return gemm_; }
+
+  /**
+   * @brief Record the tuned GEMM blocking.
+   */
+  void setGemm(const GemmBlocking& blocking) { gemm_ = blocking; }
+
+  /**
+   * @brief Write the entries back to the backing file.
+   *
+   * Sections of other CPU models already in the file are kept.
+   *
+   * @throws std::runtime_error if there is no backing file or it cannot be
+   *         written.
+   */
+  void save() const;
+};
+
+/**
+ * @brief Get the name of a convolution algorithm as stored in a tuning
+ * database (e.g. "winograd").
+ */
+const char* conv_algorithm_name(ConvAlgorithm algorithm);
+
+/**
+ * @brief Build the tuning key of a convolution node for an input shape.
+ *
+ * The key covers the layout, input shape, output channels and geometry;
+ * weights and epilogue do not affect it.
+ */
+std::string conv_tuning_key(const Conv2dOp& op, const Shape& input);
+
+/**
+ * @brief Settings of autotune().
+ */
+struct AutotuneOptions {
+  std::vector<size_t> thread_counts; /**< Empty: 1, 2, 4, ... num_threads() */
+  size_t repeats = 3;     /**< Timed runs per candidate; the fastest counts */
+  bool retune = false;    /**< Re-measure shapes already in the database */
+  bool tune_gemm = true;  /**< Tune the GEMM blocking if not yet tuned */
+};
+
+/**
+ * @brief Benchmark candidate configurations and record the fastest.
+ *
+ * Every Conv2d node of @p graph is run, at the shape it has for
+ * @p input_shapes, with each algorithm that supports it (in its layout)
+ * and each candidate thread count, on random data. The GEMM cache blocking
+ * is tuned once per database on a representative im2col-sized product,
+ * and the layers are timed with it. Candidates run under a ThreadLimitScope
+ * and a GemmBlockingScope, so the process-wide settings never change and a
+ * thread count above num_threads() runs with num_threads(). Apply the
+ * results with apply_tuning() (or a PlanCache).
+ *
+ * @param graph Graph whose layers are tuned.
+ * @param input_shapes Shapes of the graph inputs, in input order.
+ * @param db Database receiving the results.
+ * @param options Settings.
+ * @return Number of convolution shapes measured.
+ * @throws std::invalid_argument if shape inference fails or the options
+ *         are invalid.
+ */
+size_t autotune(const Graph& graph, const std::vector<Shape>& input_shapes,
+                TuningDatabase& db, const AutotuneOptions& options = {});
+
+/**
+ * @brief Specialize a graph for input shapes using tuned configurations.
+ *
+ * Conv2d nodes with a database entry are rebuilt with the tuned algorithm
+ * (sharing nothing with the source node but the weights) and their thread
+ * count is reported in @p node_threads for Executor::setNodeThreads().
+ * Nodes without an entry are shared with @p graph.
+ *
+ * @param graph Source graph.
+ * @param input_shapes Shapes of the graph inputs, in input order.
+ * @param db Tuning results.
+ * @param node_threads Optional thread limit per node (0: no limit).
+ * @return @p graph itself if no algorithm changes, else the specialized
+ *         graph with the same node and value names.
+ * @throws std::invalid_argument if shape inference fails.
+ */
+std::shared_ptr<const Graph> apply_tuning(
+    std::shared_ptr<const Graph> graph, const std::vector<Shape>& input_shapes,
+    const TuningDatabase& db, std::vector<size_t>* node_threads = nullptr);
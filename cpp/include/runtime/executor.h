@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "ops/gemm.h"
+#include "runtime/graph.h"
+#include "runtime/memory_planner.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Runs a Graph for fixed input shapes from one preallocated arena.
+ *
+ * The constructor infers every shape, computes the lifetime of each
+ * intermediate and places them all in a single arena with plan_memory().
+ * Tensor views and operator argument lists are built once, so run() performs
+ * no heap allocation once operator scratch buffers have warmed up.
+ *
+ * Graph outputs live in the arena too and stay valid until the next run().
+ * An executor is not safe to run from several threads at once.
+ */
+class Executor {
+ private:
+  std::shared_ptr<const Graph> graph_; /**< Executed graph */
+  std::vector<Shape> shapes_;          /**< Shape per value */
+  MemoryPlan plan_;                    /**< Arena placement */
+  Tensor<float> arena_;                /**< Storage of all intermediates */
+  std::vector<Tensor<float>> values_;  /**< View per value */
+  std::vector<std::vector<const Tensor<float>*>> args_; /**< Node inputs */
+  std::vector<size_t> node_threads_; /**< Thread limit per node (0: none) */
+  std::optional<GemmBlocking> gemm_blocking_; /**< Blocking of run() */
+
+ public:
+  /**
+   * @brief Plan a graph for the given input shapes.
+   *
+   * The arena is placed on @p numa_node if one is given; otherwise its pages
+   * go to the node of the constructing thread (first touch), so construct
+   * the executor on the node that will run it.
+   *
+   * @param graph Graph to execute.
+   * @param input_shapes Shapes of the graph inputs, in input order.
+   * @param numa_node NUMA node of the arena, or -1 for first touch.
+   * @throws std::invalid_argument if shape inference fails or the node does
+   *         not exist.
+   */
+  Executor(std::shared_ptr<const Graph> graph,
+           const std::vector<Shape>& input_shapes, int numa_node = -1);
+
+  /**
+   * @brief Get the executed graph.
+   */
+  const Graph& graph() const { return *graph_; }
+
+  /**
+   * @brief Get the memory plan of the intermediates.
+   *
+   * Offsets are indexed by node.
+   */
+  const MemoryPlan& plan() const { return plan_; }
+
+  /**
+   * @brief Get the inferred shape of a value.
+   */
+  const Shape& shape(ValueId value) const { return shapes_[value]; }
+
+  /**
+   * @brief Limit the threads of individual nodes.
+   *
+   * Small layers often run fastest on fewer threads than the process
+   * limit; a node with a nonzero entry runs with at most that many
+   * threads (and never more than num_threads()). The limits apply to this
+   * executor's run() only (see ThreadLimitScope), so concurrent executors
+   * and the process-wide limit are unaffected. Typically filled from a
+   * tuning database by apply_tuning().
+   *
+   * @param threads Limit per node index, 0 for none; empty to clear.
+   * @throws std::invalid_argument if the size is neither 0 nor the number
+   *         of nodes.
+   */
+  void setNodeThreads(std::vector<size_t> threads);
+
+  /**
+   * @brief Get the thread limit per node (empty if none is set).
+   */
+  const std::vector<size_t>& nodeThreads() const { return node_threads_; }
+
+  /**
+   * @brief Set the GEMM cache blocking used while this executor runs.
+   *
+   * Applied per run() with a GemmBlockingScope, so other threads keep
+   * their own blocking. Typically the tuned blocking of a TuningDatabase.
+   *
+   * @param blocking Blocking, or std::nullopt for the process-wide one.
+   * @throws std::invalid_argument if a block size is 0.
+   */
+  void setGemmBlocking(std::optional<GemmBlocking> blocking);
+
+  /**
+   * @brief Get the GEMM cache blocking of run() (empty: process-wide).
+   */
+  const std::optional<GemmBlocking>& gemmBlocking() const {
+    return gemm_blocking_;
+  }
+
+  /**
+   * @brief Run the graph.
+   *
+   * @param inputs Graph inputs, in input order, with the planned shapes.
+   *        They are read in place and must outlive the call.
+   * @throws std::invalid_argument if the inputs do not match the plan.
+   */
+  void run(std::span<const Tensor<float>> inputs);
+
+  /**
+   * @brief Get a graph output of the last run().
+   *
+   * @param index Output index.
+   * @return View into the arena, valid until the next run().
+   */
+  const Tensor<float>& output(size_t index) const {
+    return values_[graph_->outputs()[index]];
+  }
+};
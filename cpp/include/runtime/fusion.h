@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+
+#include "runtime/graph.h"
+
+/**
+ * @brief Counts of rewrites performed by fuse_graph().
+ */
+struct FusionStats {
+  size_t folded_batch_norms = 0; /**< BatchNorm nodes folded into convs */
+  size_t fused_residuals = 0;    /**< Add nodes fused into conv epilogues */
+  size_t fused_activations = 0;  /**< Clip/Relu nodes fused into producers */
+};
+
+/**
+ * @brief Fuse elementwise chains into the nodes that produce their input.
+ *
+ * Starting at every Conv2d node, the pass absorbs the chain of nodes that
+ * are the sole consumer of the previous value:
+ *  - BatchNorm is folded into the filters and bias (load-time cost only);
+ *  - one Add becomes a fused residual input of the convolution epilogue;
+ *  - Clip/Relu nodes become the epilogue clamp.
+ * A BatchNorm is only folded before any Add or clamp, since the epilogue
+ * runs after the bias. Add nodes not absorbed by a convolution absorb their
+ * trailing Clip/Relu chain.
+ *
+ * Values that are graph outputs or have several consumers end a chain, so
+ * every value visible outside a fused chain keeps its name and meaning. The
+ * fused node is placed at the position of the last node it absorbed.
+ *
+ * @param graph Graph to rewrite.
+ * @param stats Optional counts of the rewrites.
+ * @return The fused graph.
+ */
+Graph fuse_graph(const Graph& graph, FusionStats* stats = nullptr);
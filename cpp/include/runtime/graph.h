@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Index of a value (tensor) in a Graph.
+ */
+using ValueId = size_t;
+
+/**
+ * @brief Single-output operator of an inference graph.
+ *
+ * Operators are immutable once built: weights are prepared in the
+ * constructor, and forward() writes into caller-provided memory so the
+ * executor decides where every intermediate lives.
+ */
+class Operator {
+ public:
+  virtual ~Operator() = default;
+
+  /**
+   * @brief Get the operator type name (e.g. "Conv2d").
+   */
+  virtual const char* type() const = 0;
+
+  /**
+   * @brief Infer the output shape from the input shapes.
+   *
+   * @param inputs Shapes of the inputs, in node order.
+   * @return Output shape.
+   * @throws std::invalid_argument if the inputs are not supported.
+   */
+  virtual Shape outputShape(std::span<const Shape> inputs) const = 0;
+
+  /**
+   * @brief Compute the output.
+   *
+   * Must not allocate in steady state; the output never aliases an input.
+   *
+   * @param inputs Input tensors, in node order.
+   * @param output Output tensor of shape outputShape().
+   */
+  virtual void forward(std::span<const Tensor<float>* const> inputs,
+                       Tensor<float>& output) const = 0;
+};
+
+/**
+ * @brief Operator application producing one value.
+ */
+struct Node {
+  std::string name;                     /**< Node name (also its output's) */
+  std::shared_ptr<const Operator> op;   /**< Operator to run */
+  std::vector<ValueId> inputs;          /**< Consumed values */
+  ValueId output = 0;                   /**< Produced value */
+};
+
+/**
+ * @brief Directed acyclic operator graph.
+ *
+ * Nodes can only consume values that already exist, so the node list is
+ * always in topological order and is executed as stored.
+ */
+class Graph {
+ private:
+  std::vector<std::string> values_; /**< Value names */
+  std::vector<Node> nodes_;         /**< Nodes in execution order */
+  std::vector<ValueId> inputs_;     /**< Graph inputs */
+  std::vector<ValueId> outputs_;    /**< Graph outputs */
+
+ public:
+  /**
+   * @brief Add a graph input.
+   *
+   * @param name Input name.
+   * @return The new value.
+   */
+  ValueId addInput(const std::string& name);
+
+  /**
+   * @brief Append a node.
+   *
+   * @param name Node name, also used for its output value.
+   * @param op Operator to apply.
+   * @param inputs Values consumed by the node.
+   * @return The value produced by the node.
+   * @throws std::invalid_argument if @p op is null or an input is unknown.
+   */
+  ValueId addNode(const std::string& name, std::shared_ptr<const Operator> op,
+                  std::vector<ValueId> inputs);
+
+  /**
+   * @brief Mark a value as a graph output.
+   *
+   * @param value Value to expose.
+   * @throws std::invalid_argument if @p value is unknown.
+   */
+  void addOutput(ValueId value);
+
+  /**
+   * @brief Get the nodes in execution order.
+   */
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+  /**
+   * @brief Get the graph inputs.
+   */
+  const std::vector<ValueId>& inputs() const { return inputs_; }
+
+  /**
+   * @brief Get the graph outputs.
+   */
+  const std::vector<ValueId>& outputs() const { return outputs_; }
+
+  /**
+   * @brief Get the number of values.
+   */
+  size_t numValues() const { return values_.size(); }
+
+  /**
+   * @brief Get the name of a value.
+   */
+  const std::string& valueName(ValueId value) const { return values_[value]; }
+
+  /**
+   * @brief Infer the shape of every value.
+   *
+   * @param input_shapes Shapes of the graph inputs, in input order.
+   * @return Shapes indexed by ValueId.
+   * @throws std::invalid_argument if the input count is wrong or an operator
+   *         rejects its input shapes.
+   */
+  std::vector<Shape> inferShapes(const std::vector<Shape>& input_shapes) const;
+};
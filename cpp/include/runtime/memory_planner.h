@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Size and live range of one intermediate tensor.
+ *
+ * Steps are node indices: the tensor is written at step @p first and read
+ * for the last time at step @p last (inclusive).
+ */
+struct TensorLifetime {
+  size_t bytes = 0; /**< Size in bytes */
+  size_t first = 0; /**< Step producing the tensor */
+  size_t last = 0;  /**< Last step reading the tensor */
+};
+
+/**
+ * @brief Placement of tensors in a single arena.
+ */
+struct MemoryPlan {
+  std::vector<size_t> offsets; /**< Byte offset per tensor */
+  size_t arena_bytes = 0;      /**< Arena size needed by the offsets */
+  size_t peak_live_bytes = 0;  /**< Largest total live at one step */
+};
+
+/**
+ * @brief Assign arena offsets to tensors with known lifetimes.
+ *
+ * Uses the greedy-by-size heuristic: tensors are placed largest first, each
+ * into the smallest gap between already placed tensors whose lifetimes
+ * overlap its own, or after them if no gap fits. Tensors with disjoint
+ * lifetimes may share memory. The result is usually at or near
+ * MemoryPlan::peak_live_bytes, which is a lower bound for any placement.
+ *
+ * @param tensors Tensors to place.
+ * @param alignment Alignment of every offset in bytes (a power of two).
+ * @return Offsets indexed like @p tensors and the arena size.
+ * @throws std::invalid_argument if a lifetime ends before it starts or the
+ *         alignment is not a power of two.
+ */
+MemoryPlan plan_memory(const std::vector<TensorLifetime>& tensors,
+                       size_t alignment = 64);
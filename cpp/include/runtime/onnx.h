@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "runtime/graph.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Options of import_onnx().
+ */
+struct OnnxImportOptions {
+  /**
+   * Shapes of the graph inputs, in input order. When empty the shapes
+   * declared by the model are used, with symbolic dimensions (e.g. the
+   * batch) set to 1.
+   */
+  std::vector<Shape> input_shapes;
+};
+
+/**
+ * @brief Result of import_onnx().
+ */
+struct OnnxModel {
+  std::shared_ptr<Graph> graph;   /**< Imported inference graph */
+  std::vector<Shape> input_shapes; /**< Shapes the graph was built for */
+  int64_t opset = 0;              /**< Default-domain opset of the model */
+  size_t folded_nodes = 0;        /**< Nodes evaluated at import */
+};
+
+/**
+ * @brief Import an ONNX model into an inference graph.
+ *
+ * The ModelProto is decoded with the in-tree wire-format reader (no
+ * protobuf or ONNX runtime dependency). Shapes are inferred node by node
+ * while importing, and every node whose inputs are all constant (including
+ * the Shape/Gather/Concat chains exporters emit to compute reshape targets)
+ * is evaluated at import, so the graph only contains work that depends on
+ * the inputs and is specialized to the input shapes. Channel-wise constant
+ * Add/Sub/Mul/Div become BatchNormOp nodes that fuse_graph() can fold into
+ * a preceding convolution.
+ *
+ * Supported operators: Conv, BatchNormalization, Relu, Clip, LeakyRelu,
+ * Sigmoid, Add, Sub, Mul, Div, MaxPool, GlobalAveragePool, Concat, Resize
+ * and Upsample (nearest, integer factors), Reshape, Flatten, Squeeze,
+ * Unsqueeze, Transpose, Gemm, MatMul (constant right operand), Identity,
+ * Dropout, Cast, Constant, Shape, Gather and Slice (the last two on
+ * constants only). Tensors must be float32, float64, int32 or int64 and
+ * stored inside the model.
+ *
+ * @param model Serialized ModelProto.
+ * @param options Import options.
+ * @return The imported graph.
+ * @throws std::runtime_error if the model is malformed.
+ * @throws std::invalid_argument if the model uses an unsupported operator,
+ *         attribute or data type, or the input shapes do not fit it.
+ */
+OnnxModel import_onnx(std::span<const uint8_t> model,
+                      const OnnxImportOptions& options = {});
+
+/**
+ * @brief Import an ONNX model file into an inference graph.
+ *
+ * The file is memory-mapped for the duration of the import.
+ *
+ * @param path Path of the `.onnx` file.
+ * @param options Import options.
+ * @return The imported graph.
+ * @throws std::system_error if the file cannot be mapped.
+ * @see import_onnx()
+ */
+OnnxModel import_onnx_file(const std::string& path,
+                           const OnnxImportOptions& options = {});
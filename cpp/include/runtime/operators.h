@@ -0,0 +1,462 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ops/conv.h"
+#include "runtime/graph.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief 2D convolution node with an optional fused epilogue.
+ *
+ * The source weights are kept next to the prepared Conv2d so graph passes
+ * can derive new layers from them (e.g. with a batch norm folded in). With a
+ * fused residual the node takes a second input that is added to the output
+ * before clamping.
+ */
+class Conv2dOp : public Operator {
+ private:
+  Tensor<float> weight_;     /**< Filters [C_out, C_in / groups, KH, KW] */
+  Tensor<float> bias_;       /**< Bias [C_out] or empty */
+  Conv2d conv_;              /**< Prepared layer */
+  bool residual_ = false;    /**< Second input added before clamping */
+  float clamp_min_ = -std::numeric_limits<float>::infinity(); /**< Floor */
+  float clamp_max_ = std::numeric_limits<float>::infinity();  /**< Ceiling */
+
+ public:
+  /**
+   * @brief Prepare a convolution node.
+   *
+   * Arguments are forwarded to the Conv2d constructor. The source tensors
+   * are held by reference, so they may be views of a mapped weights file.
+   */
+  Conv2dOp(const Tensor<float>& weight, const Tensor<float>& bias,
+           const Conv2dParams& params, ConvLayout layout = ConvLayout::kNchw,
+           ConvAlgorithm algorithm = ConvAlgorithm::kAuto,
+           std::vector<GemmPackedA> prepacked = {});
+
+  /**
+   * @brief Get the prepared layer.
+   */
+  const Conv2d& conv() const { return conv_; }
+
+  /**
+   * @brief Get the source filters.
+   */
+  const Tensor<float>& weight() const { return weight_; }
+
+  /**
+   * @brief Get the source bias (empty if none).
+   */
+  const Tensor<float>& bias() const { return bias_; }
+
+  /**
+   * @brief Check whether a residual input is fused.
+   */
+  bool hasResidual() const { return residual_; }
+
+  /**
+   * @brief Get the fused clamp floor.
+   */
+  float clampMin() const { return clamp_min_; }
+
+  /**
+   * @brief Get the fused clamp ceiling.
+   */
+  float clampMax() const { return clamp_max_; }
+
+  /**
+   * @brief Derive a layer computing `conv(x) * scale[c] + shift[c]`.
+   *
+   * The scale is folded into the filters and the shift into the bias.
+   *
+   * @param scale Per-output-channel multiplier [C_out].
+   * @param shift Per-output-channel offset [C_out].
+   * @return New node without an epilogue, using the same algorithm request.
+   * @throws std::invalid_argument if the shapes differ or an epilogue is
+   *         already fused.
+   */
+  std::shared_ptr<Conv2dOp> foldAffine(const Tensor<float>& scale,
+                                       const Tensor<float>& shift) const;
+
+  /**
+   * @brief Derive a node that also adds a second input to the output.
+   */
+  std::shared_ptr<Conv2dOp> withResidual() const;
+
+  /**
+   * @brief Derive a node that also clamps the output to [lo, hi].
+   *
+   * Clamps compose, so the result clamps to the intersection.
+   */
+  std::shared_ptr<Conv2dOp> withClamp(float lo, float hi) const;
+
+  /**
+   * @brief Derive a node running the same layer with another algorithm.
+   *
+   * The weights are prepared anew for @p algorithm; the epilogue is kept.
+   *
+   * @throws std::invalid_argument if @p algorithm does not support the
+   *         layer (see Conv2d).
+   */
+  std::shared_ptr<Conv2dOp> withAlgorithm(ConvAlgorithm algorithm) const;
+
+  const char* type() const override { return "Conv2d"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Inference-mode batch normalization over the channels of NCHW input.
+ *
+ * The statistics are folded at construction into a per-channel affine
+ * transform `y = x * scale + shift`.
+ */
+class BatchNormOp : public Operator {
+ private:
+  Tensor<float> scale_; /**< gamma / sqrt(var + eps) */
+  Tensor<float> shift_; /**< beta - mean * scale */
+
+ public:
+  /**
+   * @brief Fold batch-norm statistics into a per-channel affine transform.
+   *
+   * @param gamma Scale of shape [C].
+   * @param beta Shift of shape [C].
+   * @param mean Running mean of shape [C].
+   * @param var Running variance of shape [C].
+   * @param eps Value added to the variance.
+   * @throws std::invalid_argument if the shapes differ.
+   */
+  BatchNormOp(const Tensor<float>& gamma, const Tensor<float>& beta,
+              const Tensor<float>& mean, const Tensor<float>& var,
+              float eps = 1e-5f);
+
+  /**
+   * @brief Create a per-channel affine transform directly.
+   *
+   * Used for channel-wise constant multiplies and adds, which the fusion
+   * pass can then fold into a preceding convolution like a batch norm.
+   *
+   * @param scale Multiplier of shape [C].
+   * @param shift Offset of shape [C].
+   * @throws std::invalid_argument if the shapes differ.
+   */
+  BatchNormOp(const Tensor<float>& scale, const Tensor<float>& shift);
+
+  /**
+   * @brief Get the per-channel multiplier.
+   */
+  const Tensor<float>& scale() const { return scale_; }
+
+  /**
+   * @brief Get the per-channel offset.
+   */
+  const Tensor<float>& shift() const { return shift_; }
+
+  const char* type() const override { return "BatchNorm"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Elementwise clamp to [min, max] (ReLU6 is Clip(0, 6)).
+ */
+class ClipOp : public Operator {
+ private:
+  float min_; /**< Floor */
+  float max_; /**< Ceiling */
+
+ public:
+  /**
+   * @brief Create a clamp to [min, max].
+   *
+   * @throws std::invalid_argument if @p min > @p max.
+   */
+  ClipOp(float min, float max);
+
+  /**
+   * @brief Get the floor.
+   */
+  float min() const { return min_; }
+
+  /**
+   * @brief Get the ceiling.
+   */
+  float max() const { return max_; }
+
+  const char* type() const override { return "Clip"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Elementwise `max(x, 0)`.
+ */
+class ReluOp : public ClipOp {
+ public:
+  ReluOp() : ClipOp(0.f, std::numeric_limits<float>::infinity()) {}
+
+  const char* type() const override { return "Relu"; }
+};
+
+/**
+ * @brief Elementwise sum of two tensors of the same shape, optionally
+ * clamped (a fused trailing activation).
+ */
+class AddOp : public Operator {
+ private:
+  float clamp_min_; /**< Floor */
+  float clamp_max_; /**< Ceiling */
+
+ public:
+  /**
+   * @brief Create a sum clamped to [clamp_min, clamp_max].
+   */
+  explicit AddOp(float clamp_min = -std::numeric_limits<float>::infinity(),
+                 float clamp_max = std::numeric_limits<float>::infinity())
+      : clamp_min_(clamp_min), clamp_max_(clamp_max) {}
+
+  /**
+   * @brief Get the clamp floor.
+   */
+  float clampMin() const { return clamp_min_; }
+
+  /**
+   * @brief Get the clamp ceiling.
+   */
+  float clampMax() const { return clamp_max_; }
+
+  const char* type() const override { return "Add"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief 2D max pooling over NCHW input.
+ *
+ * Padding is symmetric and padded positions are ignored rather than treated
+ * as zeros.
+ */
+class MaxPool2dOp : public Operator {
+ private:
+  size_t kernel_; /**< Window size */
+  size_t stride_; /**< Stride */
+  size_t pad_;    /**< Padding on every side */
+
+ public:
+  /**
+   * @brief Create a pooling operator.
+   *
+   * @param kernel Window size.
+   * @param stride Stride.
+   * @param pad Padding on every side (less than @p kernel).
+   * @throws std::invalid_argument if kernel or stride is 0 or pad >= kernel.
+   */
+  MaxPool2dOp(size_t kernel, size_t stride, size_t pad = 0);
+
+  const char* type() const override { return "MaxPool2d"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Global average pooling of [N, C, H, W] input to [N, C, 1, 1].
+ */
+class GlobalAveragePoolOp : public Operator {
+ public:
+  const char* type() const override { return "GlobalAveragePool"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Elementwise logistic function `1 / (1 + exp(-x))`.
+ */
+class SigmoidOp : public Operator {
+ public:
+  const char* type() const override { return "Sigmoid"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Elementwise `x >= 0 ? x : alpha * x`.
+ */
+class LeakyReluOp : public Operator {
+ private:
+  float alpha_; /**< Slope for negative inputs */
+
+ public:
+  explicit LeakyReluOp(float alpha = 0.01f) : alpha_(alpha) {}
+
+  /**
+   * @brief Get the slope for negative inputs.
+   */
+  float alpha() const { return alpha_; }
+
+  const char* type() const override { return "LeakyRelu"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Elementwise product of two tensors of the same shape (e.g. the
+ * gate of SiLU, `x * sigmoid(x)`).
+ */
+class MulOp : public Operator {
+ public:
+  const char* type() const override { return "Mul"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Concatenation of any number of inputs along one axis.
+ */
+class ConcatOp : public Operator {
+ private:
+  size_t axis_; /**< Concatenation axis */
+
+ public:
+  explicit ConcatOp(size_t axis) : axis_(axis) {}
+
+  /**
+   * @brief Get the concatenation axis.
+   */
+  size_t axis() const { return axis_; }
+
+  const char* type() const override { return "Concat"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Nearest-neighbour upsampling of NCHW input by integer factors.
+ */
+class UpsampleNearestOp : public Operator {
+ private:
+  size_t scale_h_; /**< Vertical factor */
+  size_t scale_w_; /**< Horizontal factor */
+
+ public:
+  /**
+   * @brief Create an upsampling operator.
+   *
+   * @throws std::invalid_argument if a factor is 0.
+   */
+  UpsampleNearestOp(size_t scale_h, size_t scale_w);
+
+  const char* type() const override { return "UpsampleNearest"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Reinterpretation of the input with a fixed shape.
+ *
+ * Values never alias in the executor, so the data is copied.
+ */
+class ReshapeOp : public Operator {
+ private:
+  Shape shape_; /**< Output shape */
+
+ public:
+  explicit ReshapeOp(const Shape& shape) : shape_(shape) {}
+
+  const char* type() const override { return "Reshape"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Permutation of the input dimensions.
+ */
+class TransposeOp : public Operator {
+ private:
+  std::vector<size_t> perm_; /**< Output dimension i is input perm_[i] */
+
+ public:
+  /**
+   * @brief Create a transpose.
+   *
+   * @param perm Permutation of the input dimensions.
+   * @throws std::invalid_argument if @p perm is not a permutation.
+   */
+  explicit TransposeOp(std::vector<size_t> perm);
+
+  const char* type() const override { return "Transpose"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Fully connected layer `y = x * W^T + b` on [M, K] input.
+ */
+class LinearOp : public Operator {
+ private:
+  Tensor<float> weight_; /**< [N, K] */
+  Tensor<float> bias_;   /**< [N] or empty */
+
+ public:
+  /**
+   * @brief Create a fully connected layer.
+   *
+   * @param weight Weights of shape [N, K].
+   * @param bias Bias of shape [N], or an empty tensor.
+   * @throws std::invalid_argument if the shapes are inconsistent.
+   */
+  LinearOp(const Tensor<float>& weight, const Tensor<float>& bias);
+
+  /**
+   * @brief Get the weights [N, K].
+   */
+  const Tensor<float>& weight() const { return weight_; }
+
+  /**
+   * @brief Get the bias (empty if none).
+   */
+  const Tensor<float>& bias() const { return bias_; }
+
+  const char* type() const override { return "Linear"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Source of a fixed tensor (no inputs).
+ */
+class ConstantOp : public Operator {
+ private:
+  Tensor<float> value_; /**< Emitted tensor */
+
+ public:
+  explicit ConstantOp(const Tensor<float>& value) : value_(value) {}
+
+  /**
+   * @brief Get the emitted tensor.
+   */
+  const Tensor<float>& value() const { return value_; }
+
+  const char* type() const override { return "Constant"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "runtime/autotune.h"
+#include "runtime/executor.h"
+#include "runtime/graph.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Hit, miss and eviction counts of a PlanCache.
+ */
+struct PlanCacheStats {
+  size_t hits = 0;      /**< Lookups served by a cached plan */
+  size_t misses = 0;    /**< Lookups that planned the graph */
+  size_t evictions = 0; /**< Plans dropped to stay within capacity */
+};
+
+/**
+ * @brief Executors of one graph specialized per input shape, LRU-bounded.
+ *
+ * An Executor is planned for fixed shapes: shape inference, the arena
+ * layout and the tensor views are all derived from the input shapes. With
+ * variable inputs (e.g. aspect-ratio buckets) the cache keeps one executor
+ * per set of input shapes, so only the first batch of each shape pays for
+ * planning. Operator state that does not depend on the shape (selected
+ * convolution algorithms, packed weights) lives in the graph and is shared
+ * by all plans; per-thread operator scratch is sized by the largest shape
+ * run so far.
+ *
+ * At most @p capacity plans are kept; each holds its own arena, so the
+ * capacity bounds memory as well as planning work. When full, the least
+ * recently used plan is dropped. warmup() plans (and optionally runs) the
+ * expected shapes ahead of time so no request pays the first-run cost.
+ *
+ * A model whose graph is itself specialized to its input shapes (an ONNX
+ * import folds them into reshapes) is cached through a GraphBuilder
+ * instead: each new plan builds its own graph for its shapes.
+ *
+ * With a tuning database (setTuning()), each new plan runs convolutions
+ * with the algorithm and thread count measured fastest for its shape on
+ * this CPU model, and the database's GEMM blocking is applied. In
+ * autotuning mode, shapes missing from the database are benchmarked when
+ * first planned and the results saved, so only the first run on each
+ * machine type pays for tuning.
+ *
+ * Like Executor, a cache is not safe to use from several threads at once.
+ */
+class PlanCache {
+ public:
+  /**
+   * @brief Builds the graph to plan for a set of input shapes.
+   */
+  using GraphBuilder =
+      std::function<std::shared_ptr<const Graph>(const std::vector<Shape>&)>;
+
+ private:
+  /**
+   * @brief Cached plan and its key.
+   */
+  struct Entry {
+    std::vector<size_t> key;             /**< Encoded input shapes */
+    std::shared_ptr<Executor> executor;  /**< Plan for those shapes */
+  };
+  using EntryList = std::list<Entry>;
+
+  std::shared_ptr<const Graph> graph_;  /**< Executed graph, if shared */
+  GraphBuilder builder_;                /**< Per-shape graphs otherwise */
+  size_t capacity_;                     /**< Most plans kept */
+  EntryList entries_;                   /**< Most recently used first */
+  std::map<std::vector<size_t>, EntryList::iterator> index_; /**< By key */
+  PlanCacheStats stats_;                /**< Lookup counts */
+  std::shared_ptr<TuningDatabase> tuning_; /**< Tuned configurations */
+  bool autotune_ = false;               /**< Tune shapes missing from it */
+  AutotuneOptions autotune_options_;    /**< Settings of autotune() */
+
+  /**
+   * @brief Build the (tuned) executor for a set of input shapes.
+   */
+  std::shared_ptr<Executor> plan(const std::vector<Shape>& input_shapes);
+
+ public:
+  /**
+   * @brief Create an empty cache.
+   *
+   * @param graph Graph to execute.
+   * @param capacity Largest number of plans kept.
+   * @throws std::invalid_argument if @p graph is null or @p capacity is 0.
+   */
+  PlanCache(std::shared_ptr<const Graph> graph, size_t capacity = 8);
+
+  /**
+   * @brief Create an empty cache building one graph per set of shapes.
+   *
+   * @param builder Called with the input shapes of each new plan; it may
+   *        throw to reject them.
+   * @param capacity Largest number of plans kept.
+   * @throws std::invalid_argument if @p builder is empty or @p capacity
+   *         is 0.
+   */
+  PlanCache(GraphBuilder builder, size_t capacity = 8);
+
+  /**
+   * @brief Specialize plans with the configurations of a tuning database.
+   *
+   * Drops the plans made so far, so they are rebuilt with the tuned
+   * configurations; each plan runs with the database's GEMM blocking (see
+   * Executor::setGemmBlocking()) without changing the process-wide one.
+   *
+   * @param db Tuning database, or null to stop using one.
+   * @param autotune Whether to tune shapes missing from @p db when they are
+   *        first planned (saving @p db afterwards if it has a file).
+   * @param options Settings of the tuning runs.
+   */
+  void setTuning(std::shared_ptr<TuningDatabase> db, bool autotune = false,
+                 AutotuneOptions options = {});
+
+  /**
+   * @brief Get the tuning database (null if none).
+   */
+  const std::shared_ptr<TuningDatabase>& tuning() const { return tuning_; }
+
+  /**
+   * @brief Get the executed graph (null for a cache built on a
+   * GraphBuilder).
+   */
+  const std::shared_ptr<const Graph>& graph() const { return graph_; }
+
+  /**
+   * @brief Get the largest number of plans kept.
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Get the number of cached plans.
+   */
+  size_t size() const { return entries_.size(); }
+
+  /**
+   * @brief Get the lookup counts.
+   */
+  const PlanCacheStats& stats() const { return stats_; }
+
+  /**
+   * @brief Get the total arena bytes of the cached plans.
+   */
+  size_t arenaBytes() const;
+
+  /**
+   * @brief Check whether a plan for the given input shapes is cached,
+   * without counting a lookup or changing the LRU order.
+   */
+  bool contains(const std::vector<Shape>& input_shapes) const;
+
+  /**
+   * @brief Get the plan for the given input shapes, planning it on a miss.
+   *
+   * @param input_shapes Shapes of the graph inputs, in input order.
+   * @return The executor; it stays usable after eviction, since the caller
+   *         shares ownership.
+   * @throws std::invalid_argument if shape inference fails or the graph
+   *         builder returns null.
+   * @throws std::runtime_error if autotuning results cannot be saved.
+   */
+  std::shared_ptr<Executor> get(const std::vector<Shape>& input_shapes);
+
+  /**
+   * @brief Run the graph with the plan matching the input shapes.
+   *
+   * @param inputs Graph inputs, in input order.
+   * @return The executor that ran; read the results with output().
+   * @throws std::invalid_argument if the inputs do not fit the graph.
+   */
+  std::shared_ptr<Executor> run(std::span<const Tensor<float>> inputs);
+
+  /**
+   * @brief Plan the expected input shapes ahead of time.
+   *
+   * With @p run_once every new plan is also run on zero inputs, so
+   * operator scratch buffers are allocated and first-touch page faults are
+   * taken before serving. Shapes beyond the capacity evict earlier ones.
+   *
+   * @param shapes One set of input shapes per expected batch shape.
+   * @param run_once Whether to run each newly planned executor once.
+   * @throws std::invalid_argument if shape inference fails.
+   */
+  void warmup(const std::vector<std::vector<Shape>>& shapes,
+              bool run_once = true);
+
+  /**
+   * @brief Drop every plan and reset the counts.
+   */
+  void clear();
+};
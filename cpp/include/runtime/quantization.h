@@ -0,0 +1,256 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "data/collate.hpp"
+#include "data/data.hpp"
+#include "ops/quantize.h"
+#include "runtime/graph.h"
+#include "runtime/operators.h"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Rule turning observed activations into a quantization range.
+ */
+enum class CalibrationMethod {
+  kMinMax,     /**< Full observed range; no clipping */
+  kPercentile, /**< Clip |x| at a percentile of the observed values */
+  kEntropy,    /**< Clip |x| where the KL divergence of the codes is least */
+};
+
+/**
+ * @brief Settings of a Calibrator.
+ */
+struct CalibrationOptions {
+  CalibrationMethod method = CalibrationMethod::kMinMax; /**< Range rule */
+  double percentile = 99.99; /**< Kept share of |x| for kPercentile, in % */
+  size_t bins = 2048;        /**< Histogram bins for kPercentile/kEntropy */
+};
+
+/**
+ * @brief Input quantization per layer, keyed by node name.
+ */
+using CalibrationTable = std::map<std::string, QuantParams>;
+
+/**
+ * @brief Collects activation statistics of the quantizable layers of a graph.
+ *
+ * Every Conv2d (NCHW, not depthwise) and Linear node is observed at its
+ * first input. Batches are run eagerly with every intermediate kept, so
+ * the statistics can be taken after each node. kMinMax needs one pass over
+ * the calibration data; the histogram methods need a second pass, since
+ * the histogram range is the absolute maximum found by the first.
+ *
+ * The table refers to node names, so calibrate the graph that will be
+ * quantized (i.e. after fuse_graph(), if it is used).
+ */
+class Calibrator {
+ private:
+  /**
+   * @brief Statistics of one observed layer input.
+   */
+  struct Observer {
+    std::string name;                                     /**< Layer node */
+    ValueId value = 0;                                    /**< Observed */
+    float min = std::numeric_limits<float>::infinity();   /**< Smallest */
+    float max = -std::numeric_limits<float>::infinity();  /**< Largest */
+    std::vector<double> histogram;                        /**< Counts of |x| */
+  };
+
+  const Graph& graph_;             /**< Calibrated graph */
+  CalibrationOptions options_;     /**< Settings */
+  std::vector<Observer> observers_; /**< One per quantizable layer */
+  size_t pass_ = 0;                /**< 0: range, 1: histogram */
+
+ public:
+  /**
+   * @brief Prepare the statistics of a graph's quantizable layers.
+   *
+   * @param graph Graph to calibrate; must outlive the calibrator.
+   * @param options Settings.
+   * @throws std::invalid_argument if the options are out of range.
+   */
+  explicit Calibrator(const Graph& graph, CalibrationOptions options = {});
+
+  /**
+   * @brief Get the number of observed layers.
+   */
+  size_t numLayers() const { return observers_.size(); }
+
+  /**
+   * @brief Run one calibration batch and record its statistics.
+   *
+   * @param inputs Graph inputs, in input order.
+   * @throws std::invalid_argument if the inputs do not fit the graph.
+   */
+  void collect(std::span<const Tensor<float>> inputs);
+
+  /**
+   * @brief Finish the current pass over the calibration data.
+   *
+   * @return true if the data must be passed once more.
+   */
+  bool nextPass();
+
+  /**
+   * @brief Derive the input quantization of every observed layer.
+   *
+   * @return Parameters per layer node name.
+   * @throws std::runtime_error if no batch was collected.
+   */
+  CalibrationTable table() const;
+};
+
+/**
+ * @brief Calibrate a single-input graph on a dataset.
+ *
+ * Iterates @p loader once per Calibrator pass (resetting it before each),
+ * stacks every batch into a float tensor with collate() and feeds it to the
+ * graph.
+ *
+ * @tparam DatasetType Dataset whose samples are tensors (float or 16-bit).
+ * @param graph Graph to calibrate.
+ * @param loader Loader over the calibration images.
+ * @param options Settings.
+ * @return Input quantization per layer node name.
+ * @throws std::runtime_error if the loader yields no batch.
+ */
+template <typename DatasetType>
+CalibrationTable calibrate(const Graph& graph, DataLoader<DatasetType>& loader,
+                           const CalibrationOptions& options = {}) {
+  Calibrator calibrator(graph, options);
+  do {
+    loader.reset();
+    while (loader.hasNext()) {
+      const Tensor<float> batch = collate<float>(loader.nextBatch());
+      calibrator.collect(std::span(&batch, 1));
+    }
+  } while (calibrator.nextPass());
+  return calibrator.table();
+}
+
+/**
+ * @brief INT8 convolution node with the fused epilogue of its source.
+ */
+class QConv2dOp : public Operator {
+ private:
+  QConv2d conv_;          /**< Quantized layer */
+  bool residual_ = false; /**< Second input added before clamping */
+  float clamp_min_;       /**< Floor */
+  float clamp_max_;       /**< Ceiling */
+
+ public:
+  /**
+   * @brief Quantize a convolution node.
+   *
+   * @param source Float node (NCHW layout).
+   * @param input Quantization of its first input.
+   * @throws std::invalid_argument if @p source uses the NCHWc layout.
+   */
+  QConv2dOp(const Conv2dOp& source, const QuantParams& input);
+
+  /**
+   * @brief Get the quantized layer.
+   */
+  const QConv2d& conv() const { return conv_; }
+
+  const char* type() const override { return "QConv2d"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief INT8 fully connected layer `y = x * W^T + b` on [M, K] input.
+ */
+class QLinearOp : public Operator {
+ private:
+  QGemmPackedA weight_; /**< Quantized [N, K] weights */
+  Tensor<float> bias_;  /**< [N] or empty */
+  QuantParams input_;   /**< Input quantization */
+
+ public:
+  /**
+   * @brief Quantize a fully connected node.
+   *
+   * @param source Float node.
+   * @param input Quantization of its input.
+   */
+  QLinearOp(const LinearOp& source, const QuantParams& input);
+
+  const char* type() const override { return "QLinear"; }
+  Shape outputShape(std::span<const Shape> inputs) const override;
+  void forward(std::span<const Tensor<float>* const> inputs,
+               Tensor<float>& output) const override;
+};
+
+/**
+ * @brief Counts of rewrites performed by quantize_graph().
+ */
+struct QuantizationStats {
+  size_t quantized_convs = 0;   /**< Conv2d nodes replaced by QConv2d */
+  size_t quantized_linears = 0; /**< Linear nodes replaced by QLinear */
+  size_t float_layers = 0;      /**< Conv2d/Linear nodes kept in FP32 */
+};
+
+/**
+ * @brief Replace calibrated layers with their INT8 counterparts.
+ *
+ * Conv2d and Linear nodes with an entry in @p table are replaced; all other
+ * nodes, and layers without an entry, are kept. Depthwise and NCHWc
+ * convolutions stay in FP32: they are bandwidth-bound, so 8-bit weights
+ * gain little while per-channel errors are largest there. Activations stay
+ * float between nodes; each INT8 layer quantizes its own input.
+ *
+ * @param graph Graph to rewrite (the one given to the Calibrator).
+ * @param table Input quantization per node name.
+ * @param stats Optional counts of the rewrites.
+ * @return The quantized graph, with the same value names.
+ */
+Graph quantize_graph(const Graph& graph, const CalibrationTable& table,
+                     QuantizationStats* stats = nullptr);
+
+/**
+ * @brief Accuracy and speed of a quantized graph relative to its source.
+ */
+struct QuantizationReport {
+  double max_abs_error = 0.;  /**< Largest |fp32 - int8| over all outputs */
+  double mean_abs_error = 0.; /**< Mean |fp32 - int8| over all outputs */
+  double sqnr_db = 0.;        /**< Signal-to-quantization-noise ratio */
+  double fp32_ms = 0.;        /**< Mean latency of the source graph */
+  double int8_ms = 0.;        /**< Mean latency of the quantized graph */
+  std::string kernel;         /**< INT8 micro-kernel, see qgemm_kernel_name() */
+
+  /**
+   * @brief Get the speed-up of the quantized graph.
+   */
+  double speedup() const { return int8_ms > 0. ? fp32_ms / int8_ms : 0.; }
+};
+
+/**
+ * @brief Measure a quantized graph against its FP32 source.
+ *
+ * Both graphs are planned with Executor for the shapes of @p inputs, run
+ * once to compare every output and warm the scratch buffers, and then
+ * timed over @p repeats runs each.
+ *
+ * @param reference FP32 graph.
+ * @param quantized Graph from quantize_graph().
+ * @param inputs Graph inputs, in input order.
+ * @param repeats Timed runs per graph.
+ * @return Accuracy and latency figures.
+ * @throws std::invalid_argument if the graphs' outputs differ in shape.
+ */
+QuantizationReport compare_quantized(const Graph& reference,
+                                     const Graph& quantized,
+                                     std::span<const Tensor<float>> inputs,
+                                     size_t repeats = 10);
+
+/**
+ * @brief Format a report as a single human-readable line.
+ */
+std::string format_quantization_report(const QuantizationReport& report);
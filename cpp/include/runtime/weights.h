@@ -0,0 +1,188 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ops/conv.h"
+#include "runtime/operators.h"
+#include "tensor/tensor.hpp"
+#include "utils/mapped_file.h"
+
+/**
+ * @brief Named tensor to be written by save_weights().
+ */
+using NamedTensor = std::pair<std::string, Tensor<float>>;
+
+/**
+ * @brief Index entry of a weights file.
+ */
+struct WeightsEntry {
+  std::string name;    /**< Tensor name */
+  Shape shape;         /**< Tensor dimensions */
+  uint64_t offset = 0; /**< Byte offset of the data in the file */
+};
+
+/**
+ * @brief Write tensors to a weights container file.
+ *
+ * Layout: a 32-byte header (magic, version, tensor count, index size, tag),
+ * the index (name, element type, shape and offset per tensor), then
+ * the float32 data of every tensor starting on a 64-byte boundary so mapped
+ * tensors satisfy the Tensor alignment. The file is written under a
+ * temporary name and renamed into place, so readers (including processes
+ * that still map an older version) never observe a partial file.
+ *
+ * @param path Destination path.
+ * @param tensors Tensors to store; names must be unique.
+ * @param tag Caller-defined value stored in the header (see
+ *        WeightsFile::tag()).
+ * @throws std::invalid_argument if a name is repeated.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void save_weights(const std::string& path,
+                  const std::vector<NamedTensor>& tensors, uint64_t tag = 0);
+
+/**
+ * @brief Weights container opened with a shared read-only memory mapping.
+ *
+ * Tensors are returned as views of the mapping: nothing is read or copied
+ * at open beyond the index, pages are faulted in on first use, and every
+ * process mapping the same file shares one copy in the page cache. Views
+ * keep the mapping alive and must not be written to.
+ */
+class WeightsFile {
+ private:
+  std::string path_;                  /**< Mapped path */
+  std::shared_ptr<MappedFile> file_;  /**< Mapping shared by views */
+  uint64_t tag_ = 0;                  /**< Header tag */
+  std::vector<WeightsEntry> entries_; /**< Index in file order */
+  std::unordered_map<std::string, size_t> by_name_; /**< Name to entry */
+
+ public:
+  /**
+   * @brief Map a weights file and read its index.
+   *
+   * @param path Path of the file.
+   * @throws std::system_error if the file cannot be mapped.
+   * @throws std::runtime_error if the file is not a valid container.
+   */
+  explicit WeightsFile(const std::string& path);
+
+  /**
+   * @brief Get the path of the mapped file.
+   */
+  const std::string& path() const { return path_; }
+
+  /**
+   * @brief Get the tag passed to save_weights().
+   */
+  uint64_t tag() const { return tag_; }
+
+  /**
+   * @brief Get the index entries in file order.
+   */
+  const std::vector<WeightsEntry>& entries() const { return entries_; }
+
+  /**
+   * @brief Check whether a tensor is stored.
+   */
+  bool contains(const std::string& name) const {
+    return by_name_.count(name) != 0;
+  }
+
+  /**
+   * @brief Get a zero-copy view of a tensor.
+   *
+   * @param name Tensor name.
+   * @return Read-only view sharing ownership of the mapping.
+   * @throws std::out_of_range if no tensor has this name.
+   */
+  Tensor<float> tensor(const std::string& name) const;
+
+  /**
+   * @brief Get a zero-copy view of a tensor if it is stored.
+   */
+  std::optional<Tensor<float>> find(const std::string& name) const;
+};
+
+/**
+ * @brief Sidecar container of prepacked weights next to a weights file.
+ *
+ * Packed GEMM panels depend on the micro-kernel of the CPU, so they are kept
+ * in `<weights>.<sgemm_pack_key()>.packed`. The first load on a machine
+ * packs and inserts them; save() persists the sidecar and later loads, by
+ * this or any other process on the host, map the panels in place. The
+ * sidecar is tagged with the size and modification time of the weights
+ * file and ignored once they change.
+ */
+class PrepackedCache {
+ private:
+  std::string path_;                 /**< Sidecar path */
+  uint64_t source_ = 0;              /**< Fingerprint of the weights file */
+  std::optional<WeightsFile> file_;  /**< Existing sidecar, if valid */
+  std::vector<NamedTensor> pending_; /**< Inserted, not yet saved */
+
+ public:
+  /**
+   * @brief Open (or prepare to create) the sidecar of a weights file.
+   *
+   * A missing, stale or corrupt sidecar is ignored and rebuilt on save().
+   *
+   * @param weights_path Path of the weights file.
+   */
+  explicit PrepackedCache(const std::string& weights_path);
+
+  /**
+   * @brief Get the sidecar path.
+   */
+  const std::string& path() const { return path_; }
+
+  /**
+   * @brief Look up a prepacked tensor (saved or pending).
+   */
+  std::optional<Tensor<float>> find(const std::string& name) const;
+
+  /**
+   * @brief Add a prepacked tensor to be written by save().
+   */
+  void insert(const std::string& name, const Tensor<float>& tensor);
+
+  /**
+   * @brief Check whether save() has anything new to write.
+   */
+  bool dirty() const { return !pending_.empty(); }
+
+  /**
+   * @brief Write the saved and pending tensors to the sidecar and remap it.
+   *
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void save();
+};
+
+/**
+ * @brief Build a convolution node from tensors in a weights file.
+ *
+ * Reads `<name>.weight` and, if present, `<name>.bias` in place. Packed GEMM
+ * operands are taken from @p cache when available (zero copy); otherwise the
+ * layer packs them and, if @p cache is given, inserts them for save().
+ *
+ * @param weights Weights file.
+ * @param name Layer name prefix.
+ * @param params Convolution geometry.
+ * @param layout Activation layout.
+ * @param algorithm Algorithm request.
+ * @param cache Optional prepacked sidecar.
+ * @return The convolution node.
+ * @throws std::out_of_range if `<name>.weight` is missing.
+ */
+std::shared_ptr<Conv2dOp> load_conv2d(
+    const WeightsFile& weights, const std::string& name,
+    const Conv2dParams& params, ConvLayout layout = ConvLayout::kNchw,
+    ConvAlgorithm algorithm = ConvAlgorithm::kAuto,
+    PrepackedCache* cache = nullptr);
@@ -0,0 +1,176 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Batched model: maps a stacked batch [n, ...sample shape] to a
+ * tensor whose leading dimension is n, row i being the result of sample i.
+ */
+using BatchModel = std::function<Tensor<float>(const Tensor<float>& batch)>;
+
+/**
+ * @brief Get the size a batch of @p n samples is padded to.
+ *
+ * @param n Number of samples.
+ * @param batch_sizes Planned batch sizes, ascending; empty for no padding.
+ * @return The smallest planned size >= @p n (or @p n).
+ * @throws std::invalid_argument if @p n exceeds every planned size.
+ */
+size_t padded_batch_size(size_t n, const std::vector<size_t>& batch_sizes);
+
+/**
+ * @brief Run a batched model on equally shaped samples.
+ *
+ * The samples are stacked, padded with zero samples to
+ * padded_batch_size(), and the output is split back into one tensor per
+ * sample (copied, so the model may reuse its output buffer).
+ *
+ * @param model Batched model.
+ * @param samples Samples of one shape.
+ * @param batch_sizes Planned batch sizes, see padded_batch_size().
+ * @return Result of each sample.
+ * @throws std::runtime_error if the model output does not match the batch.
+ * @throws std::exception whatever the model throws.
+ */
+std::vector<Tensor<float>> run_batch(const BatchModel& model,
+                                     const std::vector<Tensor<float>>& samples,
+                                     const std::vector<size_t>& batch_sizes);
+
+/**
+ * @brief Settings of a DynamicBatcher.
+ */
+struct BatchingOptions {
+  size_t max_batch = 8;  /**< Most requests per batch */
+  /** Longest a request waits for others to join its batch */
+  std::chrono::microseconds max_delay{2000};
+  /**
+   * Batch sizes the model is planned for, ascending. A batch is padded with
+   * zero samples up to the next listed size (e.g. {1, 2, 4, 8}), bounding
+   * the number of plans the model needs. Empty: any size up to max_batch.
+   */
+  std::vector<size_t> batch_sizes;
+};
+
+/**
+ * @brief Counters of a DynamicBatcher.
+ */
+struct BatcherStats {
+  size_t requests = 0;        /**< Requests completed */
+  size_t batches = 0;         /**< Model runs */
+  size_t padded_samples = 0;  /**< Zero samples added to fill batch sizes */
+  size_t failed = 0;          /**< Requests completed with an error */
+
+  /**
+   * @brief Get the mean number of requests per model run.
+   */
+  double meanBatch() const {
+    return batches ? double(requests) / double(batches) : 0.;
+  }
+};
+
+/**
+ * @brief Groups single-sample requests into batches under a latency budget.
+ *
+ * Requests are queued as they arrive. The batcher thread starts a batch
+ * with the oldest request and closes it when max_batch requests of the
+ * same shape are waiting or the oldest has waited max_delay, whichever
+ * comes first. So under light load a request waits at most max_delay
+ * before running, and under heavy load batches fill up immediately and
+ * the batched kernels run at full width.
+ *
+ * The model sees the stacked batch [n, ...sample shape] (padded to a
+ * configured batch size) and returns a tensor whose leading dimension is
+ * n; row i is the result of request i. The model runs on the batcher
+ * thread only, so it need not be thread-safe; its output may be reused
+ * (e.g. an executor arena), as rows are copied out before the next run.
+ */
+class DynamicBatcher {
+ public:
+  using Model = BatchModel;
+  /** Completion: the result, or an empty tensor and the error */
+  using Callback = std::function<void(Tensor<float>, std::exception_ptr)>;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Queued request.
+   */
+  struct Request {
+    Tensor<float> sample;   /**< Input */
+    Callback done;          /**< Completion */
+    Clock::time_point time; /**< Arrival */
+  };
+
+  Model model_;                      /**< Batched model */
+  BatchingOptions options_;          /**< Settings */
+  mutable std::mutex mutex_;         /**< Guards queue_, stop_ and stats_ */
+  std::condition_variable wake_;     /**< Signalled on arrival and stop */
+  std::deque<Request> queue_;        /**< Waiting requests, oldest first */
+  bool stop_ = false;                /**< Set by stop() */
+  BatcherStats stats_;               /**< Counters */
+  std::thread thread_;               /**< Batcher thread */
+
+  /**
+   * @brief Main loop of the batcher thread.
+   */
+  void loop();
+
+  /**
+   * @brief Run one batch and complete its requests.
+   */
+  void runBatch(std::vector<Request>& batch);
+
+ public:
+  /**
+   * @brief Start the batcher thread.
+   *
+   * @param model Batched model.
+   * @param options Settings.
+   * @throws std::invalid_argument if the model is empty, max_batch is 0
+   *         or the batch sizes are not ascending and positive.
+   */
+  DynamicBatcher(Model model, BatchingOptions options = {});
+
+  /**
+   * @brief Complete the queued requests and stop the thread.
+   */
+  ~DynamicBatcher();
+
+  DynamicBatcher(const DynamicBatcher&) = delete;
+  DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+  /**
+   * @brief Queue a request (thread-safe).
+   *
+   * @param sample Input sample (without the batch dimension).
+   * @param done Called on the batcher thread with the result or error.
+   * @throws std::invalid_argument if @p sample is empty.
+   * @throws std::runtime_error if the batcher is stopped.
+   */
+  void submit(Tensor<float> sample, Callback done);
+
+  /**
+   * @brief Get the number of queued requests.
+   */
+  size_t pending() const;
+
+  /**
+   * @brief Get the counters.
+   */
+  BatcherStats stats() const;
+
+  /**
+   * @brief Complete the queued requests and stop accepting new ones.
+   */
+  void stop();
+};
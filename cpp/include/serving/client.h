@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "serving/protocol.h"
+
+/**
+ * @brief Blocking client of an InferenceServer.
+ *
+ * Requests may be pipelined: send() several, then receive() their
+ * responses, which arrive in completion order and are matched by id.
+ * Not thread-safe; use one client per thread.
+ *
+ * Linux only.
+ */
+class InferenceClient {
+ private:
+  int fd_ = -1;                /**< Connected socket */
+  uint64_t next_id_ = 1;       /**< Id of the next request */
+  MessageReader reader_;       /**< Incoming frames */
+  std::vector<uint8_t> frame_; /**< Encoding buffer, reused */
+
+ public:
+  /**
+   * @brief Connect to a server.
+   *
+   * @param socket_path Unix domain socket the server listens on.
+   * @throws std::invalid_argument if the path is empty or too long.
+   * @throws std::system_error if the connection fails.
+   */
+  explicit InferenceClient(const std::string& socket_path);
+
+  /**
+   * @brief Close the connection.
+   */
+  ~InferenceClient();
+
+  InferenceClient(const InferenceClient&) = delete;
+  InferenceClient& operator=(const InferenceClient&) = delete;
+
+  /**
+   * @brief Send a request without waiting for its response.
+   *
+   * @param sample Input sample (without the batch dimension).
+   * @return Id of the request, echoed by its response.
+   * @throws std::system_error if the connection fails.
+   */
+  uint64_t send(const Tensor<float>& sample);
+
+  /**
+   * @brief Wait for the next response.
+   *
+   * @return Response; its status tells success from failure.
+   * @throws std::runtime_error if the server closes the connection or
+   *         sends a malformed frame.
+   * @throws std::system_error if the connection fails.
+   */
+  Message receive();
+
+  /**
+   * @brief Run one request and wait for its result.
+   *
+   * Must not be mixed with outstanding send() requests.
+   *
+   * @param sample Input sample.
+   * @return Output sample.
+   * @throws std::runtime_error if the server reports an error.
+   */
+  Tensor<float> infer(const Tensor<float>& sample);
+};
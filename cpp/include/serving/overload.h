@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Degradation applied to the input stream at one controller level.
+ */
+struct QualityLevel {
+  size_t downscale = 1;  /**< Spatial factor frames are reduced by */
+  size_t keep_every = 1; /**< Run one frame in this many, skip the rest */
+  size_t max_batch = 8;  /**< Most frames per batch */
+};
+
+/**
+ * @brief Settings of an OverloadController.
+ */
+struct OverloadControlOptions {
+  double target_p99_ms = 50.; /**< Latency the controller keeps p99 under */
+  /**
+   * Levels from best quality to cheapest. Empty: full resolution at batch
+   * 4 and 8, then half resolution, then also every other frame, then
+   * quarter resolution at every third frame.
+   */
+  std::vector<QualityLevel> levels;
+  size_t window = 64; /**< Completed frames per evaluation */
+  /** Queued frames treated as overload whatever the latency */
+  size_t queue_high = 16;
+  /**
+   * Recovery needs p99 below target_p99_ms * recover_ratio and the queue
+   * below half of queue_high, rounded up (so an empty queue always
+   * qualifies); between that and the target nothing changes.
+   */
+  double recover_ratio = 0.7;
+  size_t degrade_windows = 1; /**< Overloaded windows before stepping down */
+  size_t recover_windows = 3; /**< Calm windows before stepping back up */
+};
+
+/**
+ * @brief Chooses the quality level that keeps tail latency under target.
+ *
+ * The owner reports each completed frame's end-to-end latency together
+ * with the current queue depth. Every `window` frames the controller
+ * evaluates the window's p99 latency and peak queue depth: a window over
+ * the target (or with a deep queue) counts towards degrading one level,
+ * a window well under it towards recovering one level. Degrading is quick
+ * and recovering deliberately slow, and the band between the two
+ * thresholds holds the level, so the controller does not oscillate around
+ * the target. After a change the counters restart, so each step is judged
+ * on frames run at the new level.
+ *
+ * Not thread-safe; the owner serializes the calls.
+ */
+class OverloadController {
+ private:
+  OverloadControlOptions options_; /**< Settings */
+  size_t level_ = 0;               /**< Current index into the levels */
+  std::vector<double> window_;     /**< Latencies of the current window */
+  size_t peak_queue_ = 0;          /**< Deepest queue in the window */
+  size_t overloaded_ = 0;          /**< Consecutive overloaded windows */
+  size_t calm_ = 0;                /**< Consecutive calm windows */
+  double last_p99_ms_ = 0.;        /**< p99 of the last window */
+  size_t changes_ = 0;             /**< Level changes so far */
+
+ public:
+  /**
+   * @brief Create a controller at the best level.
+   *
+   * @param options Settings.
+   * @throws std::invalid_argument if a setting or level field is 0 or
+   *         negative, or recover_ratio exceeds 1.
+   */
+  explicit OverloadController(OverloadControlOptions options = {});
+
+  /**
+   * @brief Report a completed frame.
+   *
+   * @param latency_ms End-to-end latency of the frame.
+   * @param queue_depth Frames waiting when it completed.
+   * @return true if the level changed.
+   */
+  bool observe(double latency_ms, size_t queue_depth);
+
+  /**
+   * @brief Get the current level index (0 = best quality).
+   */
+  size_t level() const { return level_; }
+
+  /**
+   * @brief Get the current level.
+   */
+  const QualityLevel& quality() const { return options_.levels[level_]; }
+
+  /**
+   * @brief Get the p99 latency of the last evaluated window.
+   */
+  double lastP99() const { return last_p99_ms_; }
+
+  /**
+   * @brief Get the number of level changes so far.
+   */
+  size_t changes() const { return changes_; }
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+
+/** First word of every frame ("VFSV" read as a little-endian word). */
+constexpr uint32_t kServingMagic = 0x56535646;
+
+/** Largest frame accepted by MessageReader (header included). */
+constexpr size_t kMaxMessageBytes = size_t(256) << 20;
+
+/**
+ * @brief Outcome of a request, carried by its response.
+ */
+enum class MessageStatus : uint32_t {
+  kOk = 0,    /**< Request, or successful response; the tensor is set */
+  kError = 1, /**< Failed request; the error text is set */
+};
+
+/**
+ * @brief Request or response exchanged with the inference server.
+ *
+ * A client sends one message per input sample, with an id of its choice;
+ * the server answers each with a message of the same id, in completion
+ * order (not necessarily the request order).
+ */
+struct Message {
+  uint64_t id = 0;                          /**< Chosen by the client */
+  MessageStatus status = MessageStatus::kOk; /**< Outcome */
+  Tensor<float> tensor;                     /**< Input or output sample */
+  std::string error;                        /**< Reason of a kError */
+};
+
+/**
+ * @brief Serialize a message as one frame.
+ *
+ * Frame layout, in native byte order (the transport is a local socket):
+ * `u32 magic, u32 frame bytes, u64 id, u32 status, u32 rank,
+ * u64 dims[rank]`, then the float32 elements for kOk or the UTF-8 error
+ * text for kError.
+ *
+ * @param message Message to encode.
+ * @param out Buffer the frame is appended to.
+ * @throws std::invalid_argument if the frame would exceed kMaxMessageBytes.
+ */
+void encode_message(const Message& message, std::vector<uint8_t>& out);
+
+/**
+ * @brief Incremental decoder of a stream of frames.
+ *
+ * Bytes are fed as they arrive from the socket, in arbitrary pieces;
+ * next() yields each message once its frame is complete.
+ */
+class MessageReader {
+ private:
+  std::vector<uint8_t> buffer_; /**< Received, not yet decoded bytes */
+  size_t offset_ = 0;           /**< Start of the first undecoded frame */
+
+ public:
+  /**
+   * @brief Append received bytes.
+   */
+  void feed(const uint8_t* data, size_t size);
+
+  /**
+   * @brief Decode the next complete frame.
+   *
+   * @param message Receives the message.
+   * @return false if no complete frame is buffered.
+   * @throws std::runtime_error if the stream is malformed; the connection
+   *         should then be dropped.
+   */
+  bool next(Message& message);
+
+  /**
+   * @brief Get the number of buffered, undecoded bytes.
+   */
+  size_t buffered() const { return buffer_.size() - offset_; }
+};
@@ -0,0 +1,258 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "serving/batcher.h"
+#include "serving/overload.h"
+
+/**
+ * @brief What happens to frames that cannot meet their stream's deadline.
+ */
+enum class OverloadPolicy {
+  kDrop,      /**< Drop the frame */
+  kDownscale, /**< Run it downscaled if that meets the deadline, else drop */
+};
+
+/**
+ * @brief Outcome of a scheduled frame.
+ */
+enum class FrameStatus {
+  kDone,       /**< Ran at full resolution */
+  kDownscaled, /**< Ran downscaled to meet the deadline */
+  kDropped,    /**< Skipped: late, or pushed out of a full queue */
+  kSkipped,    /**< Skipped by the overload controller */
+  kFailed,     /**< The model threw */
+};
+
+/**
+ * @brief Settings of one stream of a StreamScheduler.
+ */
+struct StreamOptions {
+  std::string name;  /**< Label used in reports */
+  size_t weight = 1; /**< Frames served per round-robin visit (quantum) */
+  int priority = 0;  /**< Higher classes are served first */
+  /** Budget from submission to completion of each frame */
+  std::chrono::microseconds deadline{100000};
+  size_t max_queue = 4; /**< Queued frames; the oldest is dropped beyond */
+  OverloadPolicy overload = OverloadPolicy::kDrop; /**< Late frames */
+};
+
+/**
+ * @brief Settings of a StreamScheduler.
+ */
+struct SchedulerOptions {
+  size_t max_batch = 8;            /**< Most frames per batch */
+  std::vector<size_t> batch_sizes; /**< Padding, see padded_batch_size() */
+  size_t downscale = 2; /**< Spatial factor of OverloadPolicy::kDownscale */
+  /** Adaptive resolution, frame skipping and batch size; off if unset */
+  std::optional<OverloadControlOptions> overload_control;
+};
+
+/**
+ * @brief Counters and latency percentiles of one stream.
+ */
+struct StreamStats {
+  std::string name;      /**< Stream label */
+  size_t submitted = 0;  /**< Frames submitted */
+  size_t completed = 0;  /**< Frames run (full or downscaled) */
+  size_t downscaled = 0; /**< Frames run downscaled */
+  size_t dropped = 0;    /**< Frames dropped */
+  size_t skipped = 0;    /**< Frames skipped by the overload controller */
+  size_t failed = 0;     /**< Frames the model failed on */
+  size_t late = 0;       /**< Completed after their deadline */
+  /** Latency percentiles of recent completed frames, in milliseconds */
+  double p50_ms = 0., p95_ms = 0., p99_ms = 0., max_ms = 0.;
+};
+
+/**
+ * @brief Format stream statistics as one line per stream.
+ */
+std::string format_stream_stats(const std::vector<StreamStats>& stats);
+
+/**
+ * @brief Batches frames of many streams onto one model, fairly and within
+ * per-stream deadlines.
+ *
+ * Each stream has its own bounded queue. Whenever the model is idle the
+ * scheduler thread forms the next batch: priority classes are served in
+ * descending order, and streams within a class by deficit round robin, a
+ * visit granting a stream `weight` frames, so a busy stream gets its share
+ * and no more however fast it submits. Spare batch slots go to lower
+ * classes. A batch holds frames of one shape.
+ *
+ * The scheduler keeps a moving average of the batch run time per frame
+ * shape. A frame that would complete after its deadline is downscaled
+ * (by averaging `downscale` x `downscale` pixel blocks of its [C, H, W]
+ * data) if its stream allows it and that fits, and dropped otherwise, so
+ * an overloaded engine sheds the work that is useless anyway instead of
+ * making every stream late. The model must then accept both shapes, e.g.
+ * by keeping a plan per shape.
+ *
+ * Deadlines act per frame; with `overload_control` set an
+ * OverloadController also watches the p99 latency (of completed and failed
+ * frames) and queue depth over all streams and degrades the whole engine
+ * step by step while they stay over target: all frames are downscaled,
+ * only one in `keep_every` frames per stream is run (the others complete
+ * as kSkipped on the submitting thread) and batches are capped, and
+ * quality returns once latency has stayed well under target.
+ *
+ * Callbacks run on the scheduler thread, except for frames pushed out of
+ * a full queue, which are reported on the submitting thread.
+ */
+class StreamScheduler {
+ public:
+  /** Completion: the outcome and, for kDone / kDownscaled, the result */
+  using Callback = std::function<void(FrameStatus, Tensor<float>)>;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /** Completed frames kept per stream for the latency percentiles. */
+  static constexpr size_t kLatencyWindow = 1024;
+
+  /**
+   * @brief Queued frame.
+   */
+  struct Frame {
+    Tensor<float> data;         /**< Input */
+    Callback done;              /**< Completion */
+    Clock::time_point arrival;  /**< Submission */
+    Clock::time_point deadline; /**< Latest useful completion */
+  };
+
+  /**
+   * @brief Per-stream state.
+   */
+  struct Stream {
+    StreamOptions options;       /**< Settings */
+    std::deque<Frame> queue;     /**< Waiting frames, oldest first */
+    size_t deficit = 0;          /**< Frames left in the current visit */
+    bool visiting = false;       /**< Visit cut short by a full batch */
+    StreamStats stats;           /**< Counters */
+    std::vector<double> latency; /**< Ring of recent latencies (ms) */
+    size_t latency_next = 0;     /**< Next ring slot */
+    size_t arrivals = 0;         /**< Frames seen by the frame skipping */
+  };
+
+  /**
+   * @brief Streams of one priority, served round robin.
+   */
+  struct PriorityClass {
+    std::vector<size_t> streams; /**< Stream ids */
+    size_t cursor = 0;           /**< Stream being visited */
+  };
+
+  /**
+   * @brief Frame picked for a batch.
+   */
+  struct Picked {
+    size_t stream;   /**< Stream id */
+    Frame frame;     /**< The frame */
+    size_t factor;   /**< Downscale factor, applied outside the lock */
+  };
+
+  BatchModel model_;             /**< Batched model */
+  SchedulerOptions options_;     /**< Settings */
+  mutable std::mutex mutex_;     /**< Guards the fields below */
+  std::condition_variable wake_; /**< Signalled on work and stop */
+  std::vector<std::unique_ptr<Stream>> streams_; /**< By stream id */
+  /** Classes by descending priority */
+  std::map<int, PriorityClass, std::greater<int>> classes_;
+  std::vector<std::pair<Shape, double>> cost_; /**< Batch seconds by shape */
+  std::optional<OverloadController> controller_; /**< Adaptive quality */
+  size_t queued_ = 0;  /**< Frames in all queues */
+  bool stop_ = false;  /**< Set by stop() */
+  std::thread thread_; /**< Scheduler thread */
+
+  /**
+   * @brief Main loop of the scheduler thread.
+   */
+  void loop();
+
+  /**
+   * @brief Pick the next batch (lock held); late frames go to @p dropped.
+   */
+  std::vector<Picked> pick(std::vector<Picked>& dropped);
+
+  /**
+   * @brief Get the expected run time of a batch of @p shape frames (lock
+   * held); 0 until one has run.
+   */
+  double cost(const Shape& shape) const;
+
+  /**
+   * @brief Record a completed frame's latency (lock held).
+   *
+   * @return The latency in milliseconds.
+   */
+  double record(Stream& stream, const Frame& frame, Clock::time_point now);
+
+ public:
+  /**
+   * @brief Start the scheduler thread.
+   *
+   * @param model Batched model, see DynamicBatcher.
+   * @param options Settings.
+   * @throws std::invalid_argument if the model is empty, max_batch or
+   *         downscale is 0, the batch sizes are not ascending or the
+   *         overload control options are invalid.
+   */
+  StreamScheduler(BatchModel model, SchedulerOptions options = {});
+
+  /**
+   * @brief Run the queued frames and stop the thread.
+   */
+  ~StreamScheduler();
+
+  StreamScheduler(const StreamScheduler&) = delete;
+  StreamScheduler& operator=(const StreamScheduler&) = delete;
+
+  /**
+   * @brief Register a stream (thread-safe).
+   *
+   * @param options Stream settings.
+   * @return Stream id, used by submit().
+   * @throws std::invalid_argument if weight or max_queue is 0.
+   */
+  size_t addStream(const StreamOptions& options);
+
+  /**
+   * @brief Queue a frame of a stream (thread-safe).
+   *
+   * @param stream Stream id.
+   * @param frame Input frame (without the batch dimension).
+   * @param done Completion.
+   * @throws std::out_of_range if the stream does not exist.
+   * @throws std::invalid_argument if @p frame is empty.
+   * @throws std::runtime_error if the scheduler is stopped.
+   */
+  void submit(size_t stream, Tensor<float> frame, Callback done);
+
+  /**
+   * @brief Get the statistics of every stream, by stream id.
+   */
+  std::vector<StreamStats> stats() const;
+
+  /**
+   * @brief Get the quality level set by the overload controller (the
+   * full quality level if there is none).
+   */
+  QualityLevel quality() const;
+
+  /**
+   * @brief Run the queued frames and stop accepting new ones.
+   */
+  void stop();
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "serving/batcher.h"
+#include "serving/protocol.h"
+
+/**
+ * @brief Settings of an InferenceServer.
+ */
+struct ServerOptions {
+  std::string socket_path;        /**< Unix domain socket to listen on */
+  BatchingOptions batching;       /**< Dynamic batching settings */
+  size_t max_connections = 1024;  /**< Further clients are refused */
+  /**
+   * Unsent response bytes above which a client is no longer read from
+   * until it takes its responses; requests already read still complete.
+   */
+  size_t max_output_bytes = 16 << 20;
+};
+
+/**
+ * @brief Counters of an InferenceServer.
+ */
+struct ServerStats {
+  size_t accepted = 0;      /**< Connections accepted */
+  size_t refused = 0;       /**< Connections over max_connections */
+  size_t dropped = 0;       /**< Connections closed on malformed input */
+  size_t requests = 0;      /**< Requests received */
+  size_t responses = 0;     /**< Responses queued for sending */
+  BatcherStats batcher;     /**< Batching counters */
+};
+
+/**
+ * @brief Inference server on a Unix domain socket.
+ *
+ * One thread runs an edge-triggered epoll loop over the listening socket,
+ * every client connection and an eventfd. Requests (see Message) are
+ * decoded as their bytes arrive and handed to a DynamicBatcher, which runs
+ * the model on its own thread; completed results are queued, the eventfd
+ * wakes the loop and it writes the responses back without blocking. A
+ * client may pipeline any number of requests on one connection; responses
+ * carry the request ids and arrive in completion order. A client that does
+ * not read its responses is not read from either (see max_output_bytes),
+ * and a client that shuts down its sending side still gets the responses
+ * to its requests before the connection is closed.
+ *
+ * Linux only.
+ */
+class InferenceServer {
+ private:
+  /**
+   * @brief Per-client state, owned by the loop thread.
+   */
+  struct Connection {
+    int fd = -1;                  /**< Socket */
+    MessageReader reader;         /**< Incoming frames */
+    std::vector<uint8_t> output;  /**< Encoded responses not yet sent */
+    size_t written = 0;           /**< Bytes of output already sent */
+    size_t in_flight = 0;         /**< Requests not answered in output */
+    bool writable = true;         /**< Last write did not hit EAGAIN */
+    bool paused = false;          /**< Input unread: output over cap */
+    bool eof = false;             /**< Client finished sending */
+  };
+
+  ServerOptions options_;   /**< Settings */
+  int listen_fd_ = -1;      /**< Listening socket */
+  int epoll_fd_ = -1;       /**< Event loop */
+  int event_fd_ = -1;       /**< Wakes the loop */
+  std::atomic<bool> stop_{false};  /**< Set by stop() */
+  std::map<uint64_t, std::unique_ptr<Connection>> connections_; /**< By id */
+  uint64_t next_connection_ = 1;  /**< Id of the next connection */
+  std::mutex done_mutex_;         /**< Guards done_ */
+  /** Encoded responses from the batcher thread, by connection id */
+  std::vector<std::pair<uint64_t, std::vector<uint8_t>>> done_;
+  mutable std::mutex stats_mutex_;  /**< Guards stats_ */
+  ServerStats stats_;               /**< Counters (batcher excluded) */
+  std::unique_ptr<DynamicBatcher> batcher_;  /**< Runs the model */
+
+  /**
+   * @brief Accept every pending connection.
+   */
+  void accept();
+
+  /**
+   * @brief Read everything available from a connection and submit its
+   * requests, pausing while its output is over max_output_bytes; closes
+   * it on malformed input, or once answered after EOF.
+   */
+  void read(uint64_t id);
+
+  /**
+   * @brief Send as much queued output as the socket accepts, then resume
+   * reading or close the connection if that was waiting for it.
+   */
+  void flush(uint64_t id);
+
+  /**
+   * @brief Forget a connection; its pending responses are discarded.
+   */
+  void close(uint64_t id);
+
+  /**
+   * @brief Move completed responses to their connections and send them.
+   */
+  void deliver();
+
+  /**
+   * @brief Queue a response for the loop thread (called on any thread).
+   *
+   * A message that cannot be encoded, e.g. a result over kMaxMessageBytes,
+   * is answered with a kError response of the same id instead.
+   */
+  void respond(uint64_t connection, const Message& message);
+
+ public:
+  /**
+   * @brief Bind the socket and start the batcher.
+   *
+   * A stale socket file at the path is replaced.
+   *
+   * @param model Batched model, see DynamicBatcher.
+   * @param options Settings.
+   * @throws std::invalid_argument if the socket path is empty or too long.
+   * @throws std::system_error if the socket cannot be set up.
+   */
+  InferenceServer(DynamicBatcher::Model model, ServerOptions options);
+
+  /**
+   * @brief Close every connection and remove the socket file.
+   */
+  ~InferenceServer();
+
+  InferenceServer(const InferenceServer&) = delete;
+  InferenceServer& operator=(const InferenceServer&) = delete;
+
+  /**
+   * @brief Serve clients until stop() is called.
+   *
+   * @throws std::system_error if waiting for events fails.
+   */
+  void run();
+
+  /**
+   * @brief Make run() return; pending requests are dropped.
+   *
+   * Thread-safe and async-signal-safe, so it can be called from a SIGINT
+   * handler.
+   */
+  void stop();
+
+  /**
+   * @brief Get the counters.
+   */
+  ServerStats stats() const;
+};
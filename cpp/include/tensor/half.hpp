@@ -0,0 +1,128 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+/**
+ * @brief IEEE 754 binary16 value (1 sign, 5 exponent, 10 mantissa bits).
+ *
+ * A storage type: arithmetic is done in float after conversion. Conversions
+ * round to nearest even, overflow to infinity and keep subnormals, matching
+ * the F16C instructions used by the bulk conversion kernels in
+ * utils/convert.h (NaN payloads are not preserved).
+ */
+struct Half {
+  uint16_t bits = 0; /**< Raw encoding */
+
+  /**
+   * @brief Construct positive zero.
+   */
+  Half() = default;
+
+  /**
+   * @brief Convert from float, rounding to nearest even.
+   */
+  explicit Half(float value) : bits(fromFloat(value)) {}
+
+  /**
+   * @brief Create a value from its raw encoding.
+   */
+  static Half fromBits(uint16_t bits) {
+    Half h;
+    h.bits = bits;
+    return h;
+  }
+
+  /**
+   * @brief Convert to float (exact).
+   */
+  explicit operator float() const {
+    constexpr uint32_t kShiftedExp = 0x7c00u << 13;
+    uint32_t u = uint32_t(bits & 0x7fffu) << 13;
+    const uint32_t exp = u & kShiftedExp;
+    u += (127u - 15u) << 23;
+    float f;
+    if (exp == kShiftedExp) {  // Inf/NaN
+      f = std::bit_cast<float>(u + ((128u - 16u) << 23));
+    } else if (exp == 0) {  // zero/subnormal: renormalize via float math
+      f = std::bit_cast<float>(u + (1u << 23)) -
+          std::bit_cast<float>(113u << 23);
+    } else {
+      f = std::bit_cast<float>(u);
+    }
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(f) |
+                                uint32_t(bits & 0x8000u) << 16);
+  }
+
+  bool operator==(const Half& other) const = default;
+
+ private:
+  /**
+   * @brief Encode a float with round-to-nearest-even.
+   */
+  static uint16_t fromFloat(float value) {
+    uint32_t u = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+    uint16_t out;
+    if (u >= (127u + 16u) << 23) {  // overflow, Inf or NaN
+      out = u > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if (u < 113u << 23) {  // zero or subnormal result
+      // Adding 0.5 aligns the subnormal mantissa so the FPU rounds it.
+      const float magic = std::bit_cast<float>(126u << 23);
+      out = uint16_t(std::bit_cast<uint32_t>(std::bit_cast<float>(u) + magic) -
+                     (126u << 23));
+    } else {
+      const uint32_t odd = (u >> 13) & 1u;
+      u += ((15u - 127u) << 23) + 0xfffu + odd;
+      out = uint16_t(u >> 13);
+    }
+    return uint16_t(out | sign >> 16);
+  }
+};
+
+/**
+ * @brief bfloat16 value (the upper 16 bits of a float).
+ *
+ * Keeps the float exponent range with an 8-bit mantissa. Conversion from
+ * float rounds to nearest even and quiets NaNs, matching `vcvtneps2bf16`.
+ */
+struct BFloat16 {
+  uint16_t bits = 0; /**< Raw encoding */
+
+  /**
+   * @brief Construct positive zero.
+   */
+  BFloat16() = default;
+
+  /**
+   * @brief Convert from float, rounding to nearest even.
+   */
+  explicit BFloat16(float value) {
+    const uint32_t u = std::bit_cast<uint32_t>(value);
+    if ((u & 0x7fffffffu) > 0x7f800000u)
+      bits = uint16_t((u >> 16) | 0x40u);
+    else
+      bits = uint16_t((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+  }
+
+  /**
+   * @brief Create a value from its raw encoding.
+   */
+  static BFloat16 fromBits(uint16_t bits) {
+    BFloat16 b;
+    b.bits = bits;
+    return b;
+  }
+
+  /**
+   * @brief Convert to float (exact).
+   */
+  explicit operator float() const {
+    return std::bit_cast<float>(uint32_t(bits) << 16);
+  }
+
+  bool operator==(const BFloat16& other) const = default;
+};
+
+static_assert(sizeof(Half) == 2 && sizeof(BFloat16) == 2,
+              "16-bit storage types must not be padded");
@@ -0,0 +1,264 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+/** Maximum number of dimensions a tensor can have. */
+constexpr size_t kMaxTensorRank = 6;
+
+/** Byte alignment of tensor buffers allocated by Tensor (one cache line). */
+constexpr size_t kTensorAlignment = 64;
+
+/**
+ * @brief Fixed-capacity list of tensor dimensions.
+ *
+ * Dimensions are stored inline (no heap allocation) so shapes can be copied
+ * freely on hot paths. The layout meaning of each dimension (NCHW, NHWC, ...)
+ * is defined by the operation consuming the tensor.
+ */
+class Shape {
+ private:
+  std::array<size_t, kMaxTensorRank> dims_{}; /**< Dimension extents */
+  size_t rank_ = 0;                           /**< Number of dimensions */
+
+ public:
+  /**
+   * @brief Construct an empty (rank 0) shape.
+   */
+  Shape() = default;
+
+  /**
+   * @brief Construct a shape from a list of dimension extents.
+   *
+   * @param dims Dimension extents, outermost first.
+   * @throws std::invalid_argument if more than kMaxTensorRank dimensions are
+   * given.
+   */
+  Shape(std::initializer_list<size_t> dims) {
+    if (dims.size() > kMaxTensorRank)
+      throw std::invalid_argument("Shape: rank exceeds kMaxTensorRank");
+    std::copy(dims.begin(), dims.end(), dims_.begin());
+    rank_ = dims.size();
+  }
+
+  /**
+   * @brief Append a dimension to the shape.
+   *
+   * @param dim Extent of the new innermost dimension.
+   * @throws std::invalid_argument if the shape is already at kMaxTensorRank.
+   */
+  void push_back(size_t dim) {
+    if (rank_ == kMaxTensorRank)
+      throw std::invalid_argument("Shape: rank exceeds kMaxTensorRank");
+    dims_[rank_++] = dim;
+  }
+
+  /**
+   * @brief Get the number of dimensions.
+   *
+   * @return The rank of the shape.
+   */
+  size_t rank() const { return rank_; }
+
+  /**
+   * @brief Get the total number of elements described by the shape.
+   *
+   * @return Product of all dimensions (1 for a rank 0 shape).
+   */
+  size_t numel() const {
+    size_t n = 1;
+    for (size_t i = 0; i < rank_; ++i) n *= dims_[i];
+    return n;
+  }
+
+  size_t operator[](size_t i) const { return dims_[i]; }
+  size_t& operator[](size_t i) { return dims_[i]; }
+
+  const size_t* begin() const { return dims_.data(); }
+  const size_t* end() const { return dims_.data() + rank_; }
+
+  bool operator==(const Shape& other) const {
+    return rank_ == other.rank_ && std::equal(begin(), end(), other.begin());
+  }
+  bool operator!=(const Shape& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Dense, row-major, n-dimensional array.
+ *
+ * A Tensor either owns a cache-line aligned buffer or is a view onto memory
+ * owned elsewhere (an arena, a memory-mapped file, ...). Copies are shallow
+ * and share the underlying buffer; use clone() for a deep copy.
+ *
+ * @tparam T Element type. Must be trivially copyable.
+ */
+template <typename T>
+class Tensor {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Tensor element type must be trivially copyable");
+
+ private:
+  std::shared_ptr<void> storage_; /**< Owner of the buffer (null for views) */
+  T* data_ = nullptr;             /**< First element */
+  Shape shape_;                   /**< Dimensions of the tensor */
+
+ public:
+  using value_type = T; /**< Alias for the tensor element type */
+
+ public:
+  /**
+   * @brief Construct an empty tensor holding no data.
+   */
+  Tensor() = default;
+
+  /**
+   * @brief Construct a zero-initialized tensor of the given shape.
+   *
+   * The buffer is aligned to kTensorAlignment bytes.
+   *
+   * @param shape Dimensions of the tensor.
+   */
+  explicit Tensor(const Shape& shape) : shape_(shape) {
+    const size_t n = shape_.numel();
+    if (n == 0) return;
+    void* p =
+        ::operator new(n * sizeof(T), std::align_val_t{kTensorAlignment});
+    std::memset(p, 0, n * sizeof(T));
+    storage_ = std::shared_ptr<void>(p, [](void* q) {
+      ::operator delete(q, std::align_val_t{kTensorAlignment});
+    });
+    data_ = static_cast<T*>(p);
+  }
+
+  /**
+   * @brief Construct a zero-initialized tensor in memory from @p resource.
+   *
+   * The buffer comes from the resource, so with a MonotonicArena a
+   * per-batch scratch tensor's data costs a pointer bump. The reference
+   * count stays on the heap: it must remain valid while any copy of the
+   * tensor exists, even after its data is released. The resource must
+   * outlive every copy of the tensor (for an arena: until it is reset).
+   *
+   * @param shape Dimensions of the tensor.
+   * @param resource Memory resource providing the buffer.
+   */
+  Tensor(const Shape& shape, std::pmr::memory_resource* resource)
+      : shape_(shape) {
+    const size_t n = shape_.numel();
+    if (n == 0) return;
+    const size_t bytes = n * sizeof(T);
+    void* p = resource->allocate(bytes, kTensorAlignment);
+    std::memset(p, 0, bytes);
+    storage_ = std::shared_ptr<void>(p, [resource, bytes](void* q) {
+      resource->deallocate(q, bytes, kTensorAlignment);
+    });
+    data_ = static_cast<T*>(p);
+  }
+
+  /**
+   * @brief Create a tensor viewing existing memory.
+   *
+   * No data is copied. If @p owner is given the tensor shares ownership of it,
+   * otherwise the caller must keep @p data alive for the lifetime of the view.
+   *
+   * @param data Pointer to the first element.
+   * @param shape Dimensions of the view.
+   * @param owner Optional object keeping @p data alive.
+   * @return A tensor referencing @p data.
+   */
+  static Tensor wrap(T* data, const Shape& shape,
+                     std::shared_ptr<void> owner = nullptr) {
+    Tensor t;
+    t.storage_ = std::move(owner);
+    t.data_ = data;
+    t.shape_ = shape;
+    return t;
+  }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+
+  /**
+   * @brief Get the object keeping the buffer alive.
+   *
+   * @return Shared owner of the buffer, or null for non-owning views.
+   */
+  const std::shared_ptr<void>& storage() const { return storage_; }
+
+  const Shape& shape() const { return shape_; }
+  size_t rank() const { return shape_.rank(); }
+  size_t dim(size_t i) const { return shape_[i]; }
+  size_t numel() const { return data_ ? shape_.numel() : 0; }
+  bool empty() const { return data_ == nullptr; }
+
+  T& operator[](size_t i) { return data_[i]; }
+  const T& operator[](size_t i) const { return data_[i]; }
+
+  /**
+   * @brief Access an element by its multi-dimensional index.
+   *
+   * @param idx One index per dimension, outermost first.
+   * @return Reference to the element.
+   */
+  template <typename... Idx>
+  T& operator()(Idx... idx) {
+    return data_[offset(idx...)];
+  }
+
+  template <typename... Idx>
+  const T& operator()(Idx... idx) const {
+    return data_[offset(idx...)];
+  }
+
+  /**
+   * @brief Reinterpret the tensor with a different shape.
+   *
+   * The returned tensor shares the buffer with this one.
+   *
+   * @param shape New dimensions. Must describe the same number of elements.
+   * @return A view of the same data with the new shape.
+   * @throws std::invalid_argument if the element counts differ.
+   */
+  Tensor reshape(const Shape& shape) const {
+    if (shape.numel() != shape_.numel())
+      throw std::invalid_argument("Tensor::reshape: element count mismatch");
+    Tensor t = *this;
+    t.shape_ = shape;
+    return t;
+  }
+
+  /**
+   * @brief Create a deep copy of the tensor in a newly allocated buffer.
+   *
+   * @return An owning tensor with the same shape and contents.
+   */
+  Tensor clone() const {
+    Tensor t(shape_);
+    if (numel() > 0) std::memcpy(t.data_, data_, numel() * sizeof(T));
+    return t;
+  }
+
+  /**
+   * @brief Set every element to @p value.
+   *
+   * @param value The value to assign.
+   */
+  void fill(T value) { std::fill(data_, data_ + numel(), value); }
+
+ private:
+  template <typename... Idx>
+  size_t offset(Idx... idx) const {
+    const size_t indices[] = {static_cast<size_t>(idx)...};
+    size_t off = 0;
+    for (size_t i = 0; i < sizeof...(Idx); ++i)
+      off = off * shape_[i] + indices[i];
+    return off;
+  }
+};
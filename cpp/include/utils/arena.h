@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @brief Bump allocator for short-lived allocations that all die together,
+ * e.g. the scratch buffers of one batch.
+ *
+ * Allocating moves a pointer through the current block; deallocating does
+ * nothing, and reset() rewinds the arena at once. Unlike
+ * std::pmr::monotonic_buffer_resource the blocks are kept across resets,
+ * and when a batch needed several blocks they are merged into one, so
+ * after the first few batches every allocation is a pointer bump inside
+ * memory that is already mapped.
+ *
+ * Use through std::pmr containers or the Tensor(shape, resource)
+ * constructor. Not thread-safe: give each thread its own arena.
+ */
+class MonotonicArena : public std::pmr::memory_resource {
+ public:
+  /** Size of the first block unless the constructor is given another. */
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+ private:
+  /**
+   * @brief Memory obtained from the upstream resource.
+   */
+  struct Block {
+    void* data;  /**< Start of the block */
+    size_t size; /**< Bytes in the block */
+  };
+
+  std::pmr::memory_resource* upstream_; /**< Source of the blocks */
+  size_t block_size_;                   /**< Size of the next new block */
+  std::vector<Block> blocks_;           /**< Blocks in use order */
+  size_t offset_ = 0;                   /**< Bytes used in the last block */
+  size_t used_ = 0;                     /**< Bytes handed out since reset */
+
+ public:
+  /**
+   * @brief Construct an empty arena; no memory is taken until the first
+   * allocation.
+   *
+   * @param block_size Size of the first block in bytes.
+   * @param upstream Resource providing the blocks.
+   * @throws std::invalid_argument if @p block_size is 0.
+   */
+  explicit MonotonicArena(
+      size_t block_size = kDefaultBlockSize,
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+  ~MonotonicArena() override;
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  /**
+   * @brief Make all memory available again.
+   *
+   * Everything allocated since the last reset becomes invalid. Blocks are
+   * kept; several blocks are replaced by one of their combined size.
+   */
+  void reset();
+
+  /**
+   * @brief Return every block to the upstream resource.
+   */
+  void release();
+
+  /**
+   * @brief Get the number of bytes handed out since the last reset
+   * (including alignment padding).
+   */
+  size_t used() const { return used_; }
+
+  /**
+   * @brief Get the number of bytes held in blocks.
+   */
+  size_t capacity() const;
+
+ protected:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override;
+};
+
+/**
+ * @brief Get the calling thread's pool allocator.
+ *
+ * A std::pmr::unsynchronized_pool_resource per thread: small allocations
+ * and frees are served from size-class free lists without locks or
+ * calls into malloc. Memory must be freed on the thread that allocated
+ * it, before that thread exits.
+ *
+ * @return The pool; valid for the lifetime of the calling thread.
+ */
+std::pmr::memory_resource* thread_pool_resource();
@@ -0,0 +1,131 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Blocking ring buffer of fixed capacity for any number of producers
+ * and consumers.
+ *
+ * push() blocks while the queue is full and pop() while it is empty, which
+ * gives back-pressure between the stages of a pipeline. close() wakes every
+ * waiter: pushes fail from then on, and pops drain the remaining elements
+ * before failing.
+ *
+ * @tparam T Element type (movable).
+ */
+template <typename T>
+class BoundedQueue {
+ private:
+  std::vector<T> slots_;             /**< Ring storage */
+  size_t head_ = 0;                  /**< Next slot to pop */
+  size_t size_ = 0;                  /**< Stored elements */
+  bool closed_ = false;              /**< No more pushes accepted */
+  mutable std::mutex mutex_;         /**< Guards every member */
+  std::condition_variable not_full_;  /**< Signalled after a pop */
+  std::condition_variable not_empty_; /**< Signalled after a push */
+
+ public:
+  /**
+   * @brief Construct an empty queue.
+   *
+   * @param capacity Most elements held at once.
+   * @throws std::invalid_argument if @p capacity is 0.
+   */
+  explicit BoundedQueue(size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("BoundedQueue: capacity must be positive");
+    slots_.resize(capacity);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @brief Get the most elements held at once.
+   */
+  size_t capacity() const { return slots_.size(); }
+
+  /**
+   * @brief Get the number of stored elements.
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+  /**
+   * @brief Append an element, waiting while the queue is full.
+   *
+   * @param value Element to store.
+   * @return false if the queue is closed (@p value is dropped).
+   */
+  bool push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&] { return closed_ || size_ < slots_.size(); });
+    if (closed_) return false;
+    slots_[(head_ + size_) % slots_.size()] = std::move(value);
+    ++size_;
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest element, waiting while the queue is empty.
+   *
+   * @param value Receives the element.
+   * @return false if the queue is closed and empty.
+   */
+  bool pop(T& value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [&] { return closed_ || size_ > 0; });
+    if (size_ == 0) return false;
+    value = std::move(slots_[head_]);
+    head_ = (head_ + 1) % slots_.size();
+    --size_;
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest element if there is one.
+   *
+   * @param value Receives the element.
+   * @return false if the queue is empty.
+   */
+  bool tryPop(T& value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (size_ == 0) return false;
+    value = std::move(slots_[head_]);
+    head_ = (head_ + 1) % slots_.size();
+    --size_;
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Reject further pushes and wake every waiting thread.
+   */
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  /**
+   * @brief Check whether close() was called.
+   */
+  bool closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+  }
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "tensor/half.hpp"
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Convert floats to half precision.
+ *
+ * Uses AVX-512F or F16C when available and the scalar Half conversion
+ * otherwise; every path rounds to nearest even.
+ *
+ * @param src Source values.
+ * @param n Number of values.
+ * @param dst Destination values.
+ */
+void convert(const float* src, size_t n, Half* dst);
+
+/**
+ * @brief Convert half precision values to floats (exact).
+ *
+ * @param src Source values.
+ * @param n Number of values.
+ * @param dst Destination values.
+ */
+void convert(const Half* src, size_t n, float* dst);
+
+/**
+ * @brief Convert floats to bfloat16.
+ *
+ * Uses AVX-512 BF16 (`vcvtneps2bf16`) when available, an AVX2 integer
+ * rounding kernel otherwise, and the scalar BFloat16 conversion as the
+ * fallback; every path rounds to nearest even. `vcvtneps2bf16` treats
+ * subnormal inputs as zero, so those may differ between CPUs.
+ *
+ * @param src Source values.
+ * @param n Number of values.
+ * @param dst Destination values.
+ */
+void convert(const float* src, size_t n, BFloat16* dst);
+
+/**
+ * @brief Convert bfloat16 values to floats (exact).
+ *
+ * @param src Source values.
+ * @param n Number of values.
+ * @param dst Destination values.
+ */
+void convert(const BFloat16* src, size_t n, float* dst);
+
+/**
+ * @brief Convert 8-bit pixels, e.g. rendered RGB8 frames, to floats
+ * (exact, not normalized). The loop is vectorized by the compiler.
+ *
+ * @param src Source values.
+ * @param n Number of values.
+ * @param dst Destination values.
+ */
+void convert(const uint8_t* src, size_t n, float* dst);
+
+/**
+ * @brief Copy values of the same type, so generic code can call convert()
+ * without special-casing an identity conversion.
+ */
+template <typename T>
+void convert(const T* src, size_t n, T* dst) {
+  std::copy_n(src, n, dst);
+}
+
+/**
+ * @brief Convert a tensor to another element type.
+ *
+ * @tparam To Target element type.
+ * @tparam From Source element type.
+ * @param src Tensor to convert.
+ * @return Newly allocated tensor of the same shape (empty if @p src is).
+ */
+template <typename To, typename From>
+Tensor<To> tensor_cast(const Tensor<From>& src) {
+  if (src.empty()) return Tensor<To>();
+  Tensor<To> dst(src.shape());
+  convert(src.data(), src.numel(), dst.data());
+  return dst;
+}
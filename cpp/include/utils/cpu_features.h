@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define VF_X86 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/** Compile a single function for the given instruction set extensions. */
+#define VF_TARGET(features) __attribute__((target(features)))
+#else
+#define VF_TARGET(features)
+#endif
+
+#if defined(__clang__)
+/** Fully unroll the following loop (keeps register tiles in registers). */
+#define VF_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define VF_UNROLL _Pragma("GCC unroll 32")
+#else
+#define VF_UNROLL
+#endif
+
+/**
+ * @brief Instruction set extensions available on the host CPU.
+ *
+ * A flag is only set when both the CPU and the operating system support the
+ * extension (i.e. the OS saves the corresponding register state).
+ */
+struct CpuFeatures {
+  bool avx2 = false;        /**< AVX2 integer and float vectors */
+  bool fma = false;         /**< Fused multiply-add (FMA3) */
+  bool f16c = false;        /**< Half precision conversion */
+  bool avx512f = false;     /**< AVX-512 foundation */
+  bool avx512bw = false;    /**< AVX-512 byte and word instructions */
+  bool avx512vl = false;    /**< AVX-512 vector length extensions */
+  bool avx512vnni = false;  /**< AVX-512 vector neural network instructions */
+  bool avx512bf16 = false;  /**< AVX-512 bfloat16 instructions */
+  bool avxvnni = false;     /**< VEX-encoded VNNI (AVX-VNNI) */
+};
+
+/**
+ * @brief Get the instruction set extensions of the host CPU.
+ *
+ * Detection runs once on first use. Kernels with SIMD specializations use this
+ * to select an implementation at runtime.
+ *
+ * @return The detected (or overridden) feature set.
+ */
+const CpuFeatures& cpu_features();
+
+/**
+ * @brief Get the model name of the host CPU.
+ *
+ * The CPUID brand string (e.g. "AMD EPYC 7763 64-Core Processor") with
+ * surrounding spaces removed, used to key per-machine tuning results.
+ * Unaffected by set_cpu_features().
+ *
+ * @return The model name, or "unknown" if the CPU does not report one.
+ */
+const std::string& cpu_model();
+
+/**
+ * @brief Override the feature set reported by cpu_features().
+ *
+ * Intended for tests and benchmarks that need to force a particular kernel
+ * (e.g. the scalar fallback). Enabling a feature the CPU lacks will crash the
+ * first kernel that uses it. Not thread-safe with respect to running kernels.
+ *
+ * @param features The feature set to report from now on.
+ */
+void set_cpu_features(const CpuFeatures& features);
+
+/**
+ * @brief Restore the feature set detected from the host CPU.
+ */
+void reset_cpu_features();
@@ -0,0 +1,343 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "tensor/tensor.hpp"
+#include "utils/wait.h"
+
+/** Identifies a frame ring ("VFFR"). */
+constexpr uint32_t kFrameRingMagic = 0x52464656;
+
+/** Layout version; readers reject other versions. */
+constexpr uint32_t kFrameRingVersion = 1;
+
+/** Most readers attached to one ring at a time. */
+constexpr size_t kMaxFrameReaders = 8;
+
+/** Most slots of a ring (one bit each in a reader's pin mask). */
+constexpr size_t kMaxFrameSlots = 64;
+
+/**
+ * @brief Element type of a frame's pixels.
+ */
+enum class FramePixelType : uint32_t {
+  kUInt8 = 0,   /**< 8-bit unsigned, e.g. RGB8 */
+  kFloat32 = 1, /**< 32-bit float */
+};
+
+/**
+ * @brief Size in bytes of one element of @p type.
+ */
+inline size_t frame_pixel_size(FramePixelType type) {
+  return type == FramePixelType::kFloat32 ? 4 : 1;
+}
+
+/**
+ * @brief Description of a frame; pixels are [height, width, channels].
+ */
+struct FrameInfo {
+  uint64_t sequence = 0;     /**< Frame number, set by the writer */
+  uint64_t timestamp_ns = 0; /**< Capture or render time */
+  uint32_t width = 0;        /**< Columns */
+  uint32_t height = 0;       /**< Rows */
+  uint32_t channels = 0;     /**< Interleaved channels */
+  FramePixelType type = FramePixelType::kUInt8; /**< Element type */
+
+  /**
+   * @brief Get the size of the pixels in bytes.
+   */
+  size_t bytes() const {
+    return size_t(width) * height * channels * frame_pixel_size(type);
+  }
+};
+
+/**
+ * @brief Start of the shared memory object of a frame ring, which carries
+ * video frames between processes, e.g. from a renderer to the data loader
+ * or an inference stream.
+ *
+ * Layout (all offsets multiples of kCacheLineSize, native byte order):
+ *
+ *   FrameRingHeader | slot 0 | slot 1 | ... | slot N-1
+ *   slot = FrameSlotHeader | pixels (slot_bytes)
+ *
+ * One writer publishes frames with increasing sequence numbers 0, 1, ...
+ * Each slot is guarded seqlock-style by its version word: it is odd
+ * (2s + 1) while frame s is being written and even (2s + 2) once frame s
+ * is complete, so readers can tell whole frames from torn ones without
+ * locks and the writer never waits.
+ *
+ * Readers use frames in place. Each attached reader owns a bitmask of
+ * pinned slots; the writer skips pinned slots, so a frame cannot change
+ * while a reader holds it. A reader sets its bit and then re-checks the
+ * version, and the writer marks the slot odd and then re-checks the pins
+ * (backing off if pinned), so one of them always sees the other. When
+ * every slot is pinned the writer drops the frame rather than block the
+ * renderer.
+ *
+ * Reader entries record the reader's process id. A reader that died
+ * without detaching would otherwise hold its entry and pins forever, so
+ * entries of dead processes are reclaimed by the next reader to attach and
+ * by the writer when it finds every slot pinned.
+ */
+struct FrameRingHeader {
+  std::atomic<uint32_t> magic;  /**< kFrameRingMagic once initialized */
+  uint32_t version;             /**< kFrameRingVersion */
+  uint32_t slot_count;          /**< Number of slots */
+  uint32_t reserved;            /**< Zero */
+  uint64_t slot_bytes;          /**< Pixel capacity of each slot */
+  uint64_t slot_stride;         /**< Distance between slot headers */
+  /** Frames published so far (the sequence of the next frame) */
+  alignas(kCacheLineSize) std::atomic<uint64_t> published;
+  std::atomic<uint32_t> epoch;   /**< Futex word bumped to wake readers */
+  std::atomic<uint32_t> waiters; /**< Readers sleeping on epoch */
+  std::atomic<uint32_t> closed;  /**< Non-zero once the writer is gone */
+  /** Process id of each attached reader (0: entry free) */
+  alignas(kCacheLineSize) std::atomic<uint32_t> attached[kMaxFrameReaders];
+  /** Slots pinned by each reader, one bit per slot */
+  alignas(kCacheLineSize) std::atomic<uint64_t> pins[kMaxFrameReaders];
+};
+
+/**
+ * @brief Start of each slot, followed by the pixels.
+ */
+struct alignas(kCacheLineSize) FrameSlotHeader {
+  /** 0 if never written, 2s + 1 while writing frame s, 2s + 2 after */
+  std::atomic<uint64_t> version;
+  FrameInfo info; /**< Description of the frame in the slot */
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "frame rings need address-free atomics");
+
+/**
+ * @brief Producer end of a frame ring; creates the shared memory object.
+ *
+ * Not thread-safe: one thread publishes.
+ *
+ * @code
+ *   FrameRingWriter ring("/vf_frames", 4, 1920 * 1080 * 3);
+ *   FrameInfo info{.width = 1920, .height = 1080, .channels = 3};
+ *   if (void* pixels = ring.begin()) {
+ *     render_into(pixels);
+ *     ring.commit(info);
+ *   }
+ * @endcode
+ */
+class FrameRingWriter {
+ private:
+  std::string name_;                  /**< Shared memory object name */
+  uint8_t* base_ = nullptr;           /**< Start of the mapping */
+  size_t size_ = 0;                   /**< Length of the mapping */
+  FrameRingHeader* header_ = nullptr; /**< Ring header */
+  uint64_t next_sequence_ = 0;        /**< Sequence of the next frame */
+  size_t next_slot_ = 0;              /**< Start of the next slot search */
+  std::optional<size_t> current_;     /**< Slot between begin() and commit() */
+  size_t dropped_ = 0;                /**< begin() calls without a free slot */
+
+  FrameSlotHeader* slot(size_t i) const;
+  bool pinned(size_t i) const;
+
+ public:
+  /**
+   * @brief Create (or replace) the ring.
+   *
+   * @param name Shared memory object name, e.g. "/vf_frames".
+   * @param slots Number of slots; at least one more than the frames all
+   *        readers hold at once, so the writer always finds a free slot.
+   * @param slot_bytes Largest frame in bytes.
+   * @throws std::invalid_argument if @p slots is not in [2,
+   *         kMaxFrameSlots] or @p slot_bytes is 0.
+   * @throws std::system_error if the object cannot be created or mapped.
+   */
+  FrameRingWriter(const std::string& name, size_t slots, size_t slot_bytes);
+
+  /**
+   * @brief Mark the ring closed, wake readers and remove the object.
+   *
+   * Attached readers keep their mapping.
+   */
+  ~FrameRingWriter();
+
+  FrameRingWriter(const FrameRingWriter&) = delete;
+  FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+  /**
+   * @brief Claim the oldest slot no reader holds.
+   *
+   * Abandons a frame begun but not committed.
+   *
+   * @return Where to write the pixels (kCacheLineSize-aligned), or null
+   *         if every slot is pinned (the frame is dropped).
+   */
+  void* begin();
+
+  /**
+   * @brief Publish the frame written since begin() and wake readers.
+   *
+   * @param info Description of the pixels; sequence is assigned.
+   * @return The frame's sequence number.
+   * @throws std::logic_error without a preceding begin().
+   * @throws std::invalid_argument if the pixels exceed slot_bytes.
+   */
+  uint64_t commit(FrameInfo info);
+
+  /**
+   * @brief Copy a frame in and publish it.
+   *
+   * @return false if every slot is pinned (the frame is dropped).
+   */
+  bool write(const FrameInfo& info, const void* pixels);
+
+  /**
+   * @brief Get the number of slots.
+   */
+  size_t slots() const { return header_->slot_count; }
+
+  /**
+   * @brief Get the pixel capacity of each slot.
+   */
+  size_t slotBytes() const { return header_->slot_bytes; }
+
+  /**
+   * @brief Get the number of frames published.
+   */
+  uint64_t published() const { return next_sequence_; }
+
+  /**
+   * @brief Get the number of frames dropped because every slot was pinned.
+   */
+  size_t dropped() const { return dropped_; }
+};
+
+/**
+ * @brief Frame held in place in a ring; the slot stays pinned while any
+ * copy of the frame (or of a tensor from it) exists.
+ */
+struct SharedFrame {
+  FrameInfo info;              /**< Description of the pixels */
+  const uint8_t* data;         /**< First pixel, in shared memory */
+  std::shared_ptr<void> owner; /**< Holds the pin */
+
+  /**
+   * @brief View the pixels as a [height, width, channels] tensor without
+   * copying. The tensor keeps the frame pinned and must be treated as
+   * read-only.
+   *
+   * @tparam T uint8_t or float, matching info.type.
+   * @throws std::invalid_argument if @p T does not match the frame.
+   */
+  template <typename T>
+  Tensor<T> tensor() const {
+    constexpr FramePixelType type = std::is_same_v<T, float>
+                                        ? FramePixelType::kFloat32
+                                        : FramePixelType::kUInt8;
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, uint8_t>,
+                  "frames hold uint8_t or float pixels");
+    if (info.type != type)
+      throw std::invalid_argument("SharedFrame: pixel type mismatch");
+    return Tensor<T>::wrap(
+        reinterpret_cast<T*>(const_cast<uint8_t*>(data)),
+        Shape{info.height, info.width, info.channels}, owner);
+  }
+};
+
+/**
+ * @brief Consumer end of a frame ring; attaches to an existing ring.
+ *
+ * Frames are returned in place (zero-copy) and pinned until released.
+ * Methods are thread-safe. Frames may outlive the reader.
+ */
+class FrameRingReader {
+ public:
+  struct State;
+
+ private:
+  std::shared_ptr<State> state_; /**< Mapping and pin counts */
+
+  std::optional<SharedFrame> pin(size_t slot, uint64_t sequence) const;
+
+ public:
+  /**
+   * @brief Attach to a ring created by a FrameRingWriter.
+   *
+   * @param name Shared memory object name.
+   * @throws std::system_error if the object cannot be opened or mapped.
+   * @throws std::runtime_error if it is not an initialized ring of this
+   *         version, its slot layout is inconsistent or kMaxFrameReaders
+   *         live readers are attached.
+   */
+  explicit FrameRingReader(const std::string& name);
+
+  /**
+   * @brief Detach; frames still held keep the mapping alive.
+   */
+  ~FrameRingReader();
+
+  FrameRingReader(const FrameRingReader&) = delete;
+  FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+  /**
+   * @brief Get the number of slots.
+   */
+  size_t slots() const;
+
+  /**
+   * @brief Get the number of frames published so far.
+   */
+  uint64_t published() const;
+
+  /**
+   * @brief Check whether the writer has gone away.
+   */
+  bool closed() const;
+
+  /**
+   * @brief Get a frame by sequence number.
+   *
+   * @return The frame, or nothing if it was not published yet or has
+   *         been overwritten.
+   * @throws std::runtime_error if the frame's description does not fit
+   *         its slot.
+   */
+  std::optional<SharedFrame> get(uint64_t sequence) const;
+
+  /**
+   * @brief Get the newest complete frame.
+   *
+   * @return The frame, or nothing if none was published.
+   * @throws std::runtime_error if the frame's description does not fit
+   *         its slot.
+   */
+  std::optional<SharedFrame> latest() const;
+
+  /**
+   * @brief Wait until frame @p sequence is published.
+   *
+   * Spins briefly, then sleeps on a futex shared with the writer.
+   *
+   * @return false on timeout or if the writer closed the ring first.
+   */
+  bool waitFor(uint64_t sequence, std::chrono::nanoseconds timeout) const;
+
+  /**
+   * @brief Wait for a frame newer than @p after and return the newest one,
+   * skipping frames that arrived meanwhile (live-stream semantics).
+   *
+   * @param after Sequence of the last frame used; use UINT64_MAX for none.
+   * @param timeout Longest wait.
+   * @return The frame, or nothing on timeout or close.
+   * @throws std::runtime_error if the frame's description does not fit
+   *         its slot.
+   */
+  std::optional<SharedFrame> waitLatest(
+      uint64_t after, std::chrono::nanoseconds timeout) const;
+};
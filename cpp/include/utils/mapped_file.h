@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The mapping is shared, so pages are served from the OS page cache and are
+ * shared between all processes mapping the same file. The class is move-only;
+ * the mapping is released on destruction.
+ */
+class MappedFile {
+ private:
+  const uint8_t* data_ = nullptr; /**< Start of the mapping */
+  size_t size_ = 0;               /**< Length of the mapping in bytes */
+#if defined(_WIN32)
+  void* file_ = nullptr;    /**< Windows file handle */
+  void* mapping_ = nullptr; /**< Windows file mapping handle */
+#endif
+
+ public:
+  /**
+   * @brief Construct an empty mapping.
+   */
+  MappedFile() = default;
+
+  /**
+   * @brief Map the file at @p path into memory.
+   *
+   * @param path Path of the file to map.
+   * @throws std::system_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::string& path);
+
+  /**
+   * @brief Unmap the file.
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /**
+   * @brief Get the first byte of the mapping.
+   *
+   * @return Pointer to the mapped file contents (null if empty).
+   */
+  const uint8_t* data() const { return data_; }
+
+  /**
+   * @brief Get the size of the mapping.
+   *
+   * @return Length of the mapped file in bytes.
+   */
+  size_t size() const { return size_; }
+
+ private:
+  void release() noexcept;
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/wait.h"
+
+/**
+ * @brief Lock-free bounded queue for any number of producers and
+ * consumers (Dmitry Vyukov's array-based design).
+ *
+ * Every cell carries a sequence number that tells whose turn it is: a
+ * producer claims the cell at the enqueue position with one
+ * compare-and-swap once the sequence says the cell is free, writes the
+ * element and publishes it by bumping the sequence; consumers mirror
+ * that. Producers and consumers contend on separate cache lines, there is
+ * no lock to be preempted while holding, and FIFO order holds per
+ * producer. Never blocks: pair it with an EventCount to let idle
+ * consumers sleep.
+ *
+ * A thread preempted between claiming a cell and publishing it holds up
+ * that cell: until it resumes, tryPush() reports full once the ring has
+ * wrapped around to the cell (even if other cells are free) and tryPop()
+ * reports empty when the cell is next in line. Callers that know better
+ * retry.
+ *
+ * @tparam T Element type (default-constructible and movable).
+ */
+template <typename T>
+class MpmcQueue {
+ private:
+  /**
+   * @brief Slot with its turn counter.
+   */
+  struct Cell {
+    std::atomic<size_t> sequence; /**< Position the cell is ready for */
+    T value;                      /**< Element */
+  };
+
+  std::unique_ptr<Cell[]> cells_; /**< Ring storage (a power of two) */
+  size_t mask_;                   /**< Capacity - 1 */
+  /** Next position to push */
+  alignas(kCacheLineSize) std::atomic<size_t> enqueue_{0};
+  /** Next position to pop */
+  alignas(kCacheLineSize) std::atomic<size_t> dequeue_{0};
+
+ public:
+  /**
+   * @brief Construct an empty queue.
+   *
+   * @param capacity Least number of elements held at once; rounded up to
+   *        a power of two (at least 2).
+   * @throws std::invalid_argument if @p capacity is 0.
+   */
+  explicit MpmcQueue(size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("MpmcQueue: capacity must be positive");
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    mask_ = size - 1;
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  /**
+   * @brief Get the most elements held at once.
+   */
+  size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * @brief Get the number of stored elements (approximate under
+   * concurrency).
+   */
+  size_t size() const {
+    const size_t head = dequeue_.load(std::memory_order_acquire);
+    const size_t tail = enqueue_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  /**
+   * @brief Append an element unless the queue is full.
+   *
+   * @param value Element; left untouched on failure.
+   * @return false if the queue is full.
+   */
+  bool tryPush(T& value) {
+    size_t pos = enqueue_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      const size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+      if (diff == 0) {
+        if (enqueue_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // the cell still holds an element from a lap ago
+      } else {
+        pos = enqueue_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Append a temporary unless the queue is full.
+   */
+  bool tryPush(T&& value) { return tryPush(value); }
+
+  /**
+   * @brief Remove the oldest element if there is one.
+   *
+   * @param value Receives the element.
+   * @return false if the queue is empty.
+   */
+  bool tryPop(T& value) {
+    size_t pos = dequeue_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      const size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+      if (diff == 0) {
+        if (dequeue_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          value = std::move(cell.value);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // the cell has not been filled yet
+      } else {
+        pos = dequeue_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
@@ -0,0 +1,224 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "utils/parallel.h"
+
+/**
+ * @brief One NUMA node: a set of CPUs and the memory attached to them.
+ */
+struct NumaNode {
+  size_t id = 0;             /**< Kernel node number */
+  std::vector<size_t> cpus;  /**< CPUs of the node, ascending */
+  size_t memory_bytes = 0;   /**< Total memory of the node (0: unknown) */
+};
+
+/**
+ * @brief Parse a kernel CPU list such as "0-3,8,10-11".
+ *
+ * @param list CPU list, as in sysfs `cpulist` files (may be empty).
+ * @return The listed CPUs, ascending and without duplicates.
+ * @throws std::invalid_argument if the list is malformed.
+ */
+std::vector<size_t> parse_cpu_list(const std::string& list);
+
+/**
+ * @brief Read the NUMA topology from sysfs.
+ *
+ * Every `node<N>` directory under @p root contributes a node with the CPUs
+ * of its `cpulist` file and the `MemTotal` of its `meminfo` file. Nodes
+ * without CPUs (memory-only nodes) are included.
+ *
+ * @param root Node directory, normally /sys/devices/system/node.
+ * @return Nodes ordered by id; empty if @p root does not list any.
+ * @throws std::invalid_argument if a `cpulist` file is malformed.
+ */
+std::vector<NumaNode> read_numa_topology(
+    const std::string& root = "/sys/devices/system/node");
+
+/**
+ * @brief Get the NUMA topology of the machine.
+ *
+ * Read from sysfs once. Without NUMA information (other systems, or
+ * kernels without NUMA support) the machine is one node 0 holding every
+ * hardware thread.
+ *
+ * @return Nodes ordered by id; never empty.
+ */
+const std::vector<NumaNode>& numa_nodes();
+
+/**
+ * @brief Get the node of a CPU.
+ *
+ * @param cpu CPU index.
+ * @return The id of the node listing @p cpu, or 0 if none does.
+ */
+size_t numa_node_of_cpu(size_t cpu);
+
+/**
+ * @brief Get the node the calling thread is currently running on.
+ *
+ * Threads migrate unless bound; see bind_thread_to_numa_node().
+ */
+size_t current_numa_node();
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node.
+ *
+ * Memory the thread touches first is then placed on that node by the
+ * kernel's default first-touch policy. Only supported on Linux; elsewhere
+ * this does nothing.
+ *
+ * @param node Node id.
+ * @throws std::invalid_argument if the node does not exist or has no CPUs.
+ * @throws std::system_error if the affinity cannot be set.
+ */
+void bind_thread_to_numa_node(size_t node);
+
+/**
+ * @brief Get the thread pool of a node.
+ *
+ * Created on first use with one worker per CPU of the node, each
+ * restricted to the node's CPUs, and kept until the process exits. Enter
+ * it with a ThreadPoolScope from a thread bound to the same node, so that
+ * parallel_for() and TaskGroup work (and the memory it first touches)
+ * stay node-local:
+ *
+ * @code
+ * bind_thread_to_numa_node(1);
+ * ThreadPoolScope scope(numa_thread_pool(1));
+ * executor.run(inputs);  // every layer runs on node 1
+ * @endcode
+ *
+ * @param node Node id.
+ * @return The node's pool.
+ * @throws std::invalid_argument if the node does not exist or has no CPUs.
+ */
+ThreadPool& numa_thread_pool(size_t node);
+
+/**
+ * @brief Allocate zeroed memory on a node.
+ *
+ * The pages are mapped with an explicit binding to @p node (`mbind`) and
+ * pre-faulted by the calling thread while it is temporarily bound to the
+ * node, so they are node-local even where the binding is not permitted.
+ * Elsewhere than on Linux this is a plain aligned allocation.
+ *
+ * @param bytes Size of the allocation (0 returns null).
+ * @param node Node id.
+ * @return Page-aligned memory, released with numa_free().
+ * @throws std::invalid_argument if the node does not exist.
+ * @throws std::bad_alloc if the memory cannot be mapped.
+ */
+void* numa_alloc(size_t bytes, size_t node);
+
+/**
+ * @brief Release memory from numa_alloc().
+ *
+ * @param ptr Allocation (may be null).
+ * @param bytes Size passed to numa_alloc().
+ */
+void numa_free(void* ptr, size_t bytes);
+
+/**
+ * @brief Get the node holding the page of an address.
+ *
+ * @param ptr Address of touched memory.
+ * @return The node id, or -1 if it cannot be queried.
+ */
+int numa_node_of_address(const void* ptr);
+
+/**
+ * @brief Allocate a zero-initialized tensor on a node.
+ *
+ * Use for long-lived buffers and arenas read by threads of one node; every
+ * call maps and pre-faults new pages, so recycle short-lived buffers such
+ * as batches through a NumaBufferCache instead.
+ *
+ * @tparam T Element type.
+ * @param shape Dimensions of the tensor.
+ * @param node Node id.
+ * @return Tensor owning node-local memory (without storage if @p shape has
+ *         no elements).
+ * @throws std::invalid_argument if the node does not exist.
+ */
+template <typename T>
+Tensor<T> numa_tensor(const Shape& shape, size_t node) {
+  const size_t bytes = shape.numel() * sizeof(T);
+  if (bytes == 0) return Tensor<T>(shape);
+  void* data = numa_alloc(bytes, node);
+  return Tensor<T>::wrap(
+      static_cast<T*>(data), shape,
+      std::shared_ptr<void>(data, [bytes](void* p) { numa_free(p, bytes); }));
+}
+
+/**
+ * @brief Recycles node-local memory between short-lived tensors.
+ *
+ * numa_alloc() maps, binds and pre-faults fresh pages, moving the calling
+ * thread onto the node and back, which is too slow to pay per batch. The
+ * cache keeps up to @p capacity allocations and hands one out again once
+ * no tensor refers to it any more, so a loader that keeps a few batches in
+ * flight reaches a steady state without allocating.
+ *
+ * Recycled memory is not cleared. A cache is not safe to use from several
+ * threads at once, but the tensors it returns may be released anywhere.
+ */
+class NumaBufferCache {
+ private:
+  /**
+   * @brief Cached allocation.
+   */
+  struct Buffer {
+    size_t node = 0;              /**< Node of the memory */
+    size_t bytes = 0;             /**< Size of the allocation */
+    std::shared_ptr<void> memory; /**< Shared with the tensors using it */
+  };
+
+  size_t capacity_;             /**< Most allocations kept */
+  std::vector<Buffer> buffers_; /**< Kept allocations */
+
+ public:
+  /**
+   * @brief Create an empty cache.
+   *
+   * @param capacity Largest number of allocations kept.
+   */
+  explicit NumaBufferCache(size_t capacity = 4) : capacity_(capacity) {}
+
+  /**
+   * @brief Get memory on a node no tensor is using.
+   *
+   * @param bytes Size needed (at least 1).
+   * @param node Node id.
+   * @return A recycled allocation of at least @p bytes, or a new one.
+   * @throws std::invalid_argument if the node does not exist.
+   */
+  std::shared_ptr<void> acquire(size_t bytes, size_t node);
+
+  /**
+   * @brief Get an uninitialized tensor on a node.
+   *
+   * @tparam T Element type.
+   * @param shape Dimensions of the tensor.
+   * @param node Node id.
+   * @return Tensor sharing a cached allocation.
+   * @throws std::invalid_argument if the node does not exist.
+   */
+  template <typename T>
+  Tensor<T> tensor(const Shape& shape, size_t node) {
+    const size_t bytes = shape.numel() * sizeof(T);
+    if (bytes == 0) return Tensor<T>(shape);
+    std::shared_ptr<void> memory = acquire(bytes, node);
+    T* data = static_cast<T*>(memory.get());
+    return Tensor<T>::wrap(data, shape, std::move(memory));
+  }
+
+  /**
+   * @brief Get the number of kept allocations.
+   */
+  size_t size() const { return buffers_.size(); }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utils/mpmc_queue.h"
+#include "utils/wait.h"
+
+/**
+ * @brief Fixed set of reusable objects (e.g. frame or batch buffers)
+ * handed out without locks.
+ *
+ * All objects are created up front; the free ones sit in an MpmcQueue of
+ * pointers, so acquiring and releasing from any threads is a lock-free
+ * queue operation with no allocation, and recycled buffers keep their
+ * memory (and page mapping) across uses. Handles return their object to
+ * the pool when destroyed. acquire() waits for a release when the pool is
+ * exhausted, spinning briefly and then sleeping on a futex, so the pool
+ * also bounds the number of buffers in flight.
+ *
+ * The pool must outlive its handles.
+ *
+ * @tparam T Object type.
+ */
+template <typename T>
+class ObjectPool {
+ public:
+  /**
+   * @brief Returns an object to its pool.
+   */
+  struct Releaser {
+    ObjectPool* pool = nullptr; /**< Owning pool */
+
+    void operator()(T* object) const { pool->release(object); }
+  };
+
+  /** Exclusive use of a pooled object; empty if none was available */
+  using Handle = std::unique_ptr<T, Releaser>;
+
+ private:
+  std::vector<std::unique_ptr<T>> objects_; /**< Every object */
+  MpmcQueue<T*> free_;                      /**< Objects not handed out */
+  EventCount released_;                     /**< Wakes acquire() */
+
+  /**
+   * @brief Put an object back and wake a waiting acquire().
+   */
+  void release(T* object) {
+    // The queue has room for every object, but reports full while a
+    // consumer a lap behind is preempted inside tryPop(); that is brief.
+    while (!free_.tryPush(object)) std::this_thread::yield();
+    released_.notify();
+  }
+
+ public:
+  /**
+   * @brief Create the objects.
+   *
+   * @param size Number of objects.
+   * @param make Creates each object (default: value-initialized T).
+   * @throws std::invalid_argument if @p size is 0.
+   */
+  explicit ObjectPool(size_t size,
+                      const std::function<std::unique_ptr<T>()>& make = {})
+      : free_(size == 0 ? 1 : size) {
+    if (size == 0)
+      throw std::invalid_argument("ObjectPool: size must be positive");
+    objects_.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      objects_.push_back(make ? make() : std::make_unique<T>());
+      free_.tryPush(objects_.back().get());
+    }
+  }
+
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  /**
+   * @brief Get the number of objects.
+   */
+  size_t size() const { return objects_.size(); }
+
+  /**
+   * @brief Get the number of objects not handed out (approximate under
+   * concurrency).
+   */
+  size_t available() const { return free_.size(); }
+
+  /**
+   * @brief Take an object if one is free.
+   *
+   * @return The object, or an empty handle.
+   */
+  Handle tryAcquire() {
+    T* object = nullptr;
+    if (!free_.tryPop(object)) return Handle(nullptr, Releaser{this});
+    return Handle(object, Releaser{this});
+  }
+
+  /**
+   * @brief Take an object, waiting for a release if none is free.
+   */
+  Handle acquire() {
+    T* object = nullptr;
+    released_.await([&] { return free_.tryPop(object); });
+    return Handle(object, Releaser{this});
+  }
+};
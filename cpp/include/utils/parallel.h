@@ -0,0 +1,245 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Signature of a type-erased range body used by parallel_for_range().
+ *
+ * @param context Caller supplied pointer passed through unchanged.
+ * @param begin First index of the chunk.
+ * @param end One past the last index of the chunk.
+ */
+using ParallelRangeFn = void (*)(void* context, size_t begin, size_t end);
+
+/**
+ * @brief Get the number of hardware threads available to the process.
+ *
+ * @return The number of hardware threads (at least 1).
+ */
+size_t hardware_threads();
+
+/**
+ * @brief Get the maximum number of threads used by parallel_for().
+ *
+ * @return The current thread limit (defaults to hardware_threads()),
+ *         lowered by any ThreadLimitScope of the calling thread.
+ */
+size_t num_threads();
+
+/**
+ * @brief Set the maximum number of threads used by parallel_for().
+ *
+ * Parallel work runs on shared work-stealing pools (see ThreadPoolScope);
+ * the limit caps how many threads of a pool (counting the caller) take
+ * part. A pool grows on demand to `n - 1` workers and never shrinks.
+ *
+ * @param n The new thread limit. A value of 0 restores the default.
+ */
+void set_num_threads(size_t n);
+
+/**
+ * @brief Caps the threads of parallel work started on the calling thread.
+ *
+ * While the scope lives, num_threads() on this thread returns at most
+ * @p n, and a parallel_for() called here is split into at most that many
+ * chunks, so no more threads work on it. Other threads and the process
+ * limit are unaffected, which lets concurrent callers (e.g. executors
+ * with per-node limits) each use their own cap. Scopes nest, never raise
+ * an enclosing cap and must be destroyed on the thread that created them,
+ * in reverse order.
+ */
+class ThreadLimitScope {
+ private:
+  size_t previous_; /**< Cap of the enclosing scope (0: none) */
+
+ public:
+  /**
+   * @brief Cap the calling thread at @p n threads (0 adds no cap).
+   */
+  explicit ThreadLimitScope(size_t n);
+
+  /**
+   * @brief Restore the enclosing cap.
+   */
+  ~ThreadLimitScope();
+
+  ThreadLimitScope(const ThreadLimitScope&) = delete;
+  ThreadLimitScope& operator=(const ThreadLimitScope&) = delete;
+};
+
+/**
+ * @brief Placement and size of a pool's worker threads.
+ */
+struct ThreadPoolOptions {
+  std::vector<size_t> cpus; /**< CPUs the workers may run on (empty: all) */
+  bool pin = false;         /**< Pin worker i to cpus[i % cpus.size()] */
+  size_t max_threads = 0;   /**< Threads taking part (0: num_threads()) */
+};
+
+/**
+ * @brief Work-stealing pool of worker threads (opaque).
+ *
+ * All parallel work runs on the default pool unless a ThreadPoolScope
+ * routes it to a pool made by create_thread_pool(), e.g. one per NUMA node.
+ */
+class ThreadPool;
+
+/**
+ * @brief Set the CPU affinity and size of the current pool's workers.
+ *
+ * Applies to running workers immediately and to workers started later.
+ * Calling threads are not affected. Affinity is only supported on Linux;
+ * elsewhere it is recorded but has no effect.
+ *
+ * @param options Affinity settings.
+ * @throws std::invalid_argument if a CPU index is out of range.
+ * @throws std::runtime_error if the affinity cannot be applied.
+ */
+void configure_thread_pool(const ThreadPoolOptions& options);
+
+/**
+ * @brief Get the number of worker threads started by the current pool.
+ */
+size_t pool_workers();
+
+/**
+ * @brief Create a pool with its own workers.
+ *
+ * The pool lives until the process exits. Its workers start on first use
+ * and are placed by @p options; at most `options.max_threads` threads
+ * (still capped by num_threads()) take part in its work.
+ *
+ * @param options Placement and size of the workers.
+ * @return The new pool.
+ * @throws std::invalid_argument if a CPU index is out of range.
+ * @throws std::runtime_error if the affinity cannot be applied.
+ */
+ThreadPool& create_thread_pool(const ThreadPoolOptions& options);
+
+/**
+ * @brief Routes the parallel work of the current thread to a pool.
+ *
+ * While the scope lives, parallel_for(), TaskGroup and
+ * configure_thread_pool() called on this thread use @p pool; work nested
+ * inside its tasks stays there too. Scopes nest and must be destroyed on
+ * the thread that created them, in reverse order.
+ */
+class ThreadPoolScope {
+ private:
+  ThreadPool* previous_pool_; /**< Pool of the enclosing scope */
+  void* previous_deque_;      /**< Deque of the enclosing scope */
+
+ public:
+  /**
+   * @brief Enter @p pool.
+   */
+  explicit ThreadPoolScope(ThreadPool& pool);
+
+  /**
+   * @brief Return to the enclosing pool.
+   */
+  ~ThreadPoolScope();
+
+  ThreadPoolScope(const ThreadPoolScope&) = delete;
+  ThreadPoolScope& operator=(const ThreadPoolScope&) = delete;
+};
+
+/**
+ * @brief Run a type-erased body over [begin, end) split into chunks.
+ *
+ * The range is split in halves down to an adaptive chunk size (at least
+ * @p grain indices, and coarse enough to give each thread a few chunks);
+ * halves are pushed onto the calling thread's work-stealing deque, where
+ * idle pool threads take them, while the caller works through the rest.
+ * Chunks run on up to num_threads() threads of the current pool (see
+ * ThreadPoolScope), one of which is the calling thread. The call returns
+ * once every chunk has completed. If a chunk throws, the first exception
+ * is rethrown on the calling thread after all chunks have finished.
+ *
+ * Calls may be nested: a call made from inside a chunk is parallel as well.
+ * While waiting, a thread runs chunks of the call it waits for and
+ * TaskGroup tasks, but never chunks of other calls, so a body is never
+ * re-entered on a thread where it is suspended. A TaskGroup task run this
+ * way may call any kernel, though, so per-thread scratch kept across the
+ * call must be per nesting depth (see ScratchScope); the library kernels
+ * keep theirs that way. No heap allocation is made once the pool has
+ * started.
+ *
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Minimum number of indices per chunk.
+ * @param fn Body invoked once per chunk.
+ * @param context Pointer passed to every invocation of @p fn.
+ */
+void parallel_for_range(size_t begin, size_t end, size_t grain,
+                        ParallelRangeFn fn, void* context);
+
+/**
+ * @brief Run a callable over [begin, end) split into chunks.
+ *
+ * The callable is invoked as `fn(chunk_begin, chunk_end)`. It is passed by
+ * reference (never copied) so invoking parallel_for() does not allocate.
+ *
+ * @tparam Function Callable with signature `void(size_t, size_t)`.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Minimum number of indices per chunk.
+ * @param fn The body to run for each chunk.
+ */
+template <typename Function>
+void parallel_for(size_t begin, size_t end, size_t grain, Function&& fn) {
+  using Body = std::remove_reference_t<Function>;
+  parallel_for_range(
+      begin, end, grain,
+      [](void* context, size_t b, size_t e) {
+        (*static_cast<Body*>(context))(b, e);
+      },
+      const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+}
+
+/**
+ * @brief Set of independent tasks run on the pool current at construction.
+ *
+ * Tasks may be spawned from any thread, including from inside other tasks
+ * or parallel_for() chunks, and may themselves use parallel_for(). wait()
+ * helps run the group's tasks instead of blocking, so nested groups do not
+ * deadlock even when every pool thread is waiting.
+ *
+ * A group must not be destroyed while tasks are pending; the destructor
+ * waits for them (discarding their exceptions).
+ */
+class TaskGroup {
+ private:
+  std::atomic<size_t> pending_{0}; /**< Spawned but unfinished tasks */
+  std::mutex error_mutex_;         /**< Guards error_ */
+  std::exception_ptr error_;       /**< First exception thrown by a task */
+  ThreadPool* pool_;               /**< Pool running the tasks */
+
+  friend struct GroupTask;
+
+ public:
+  TaskGroup();
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  ~TaskGroup();
+
+  /**
+   * @brief Spawn a task.
+   *
+   * @param fn Work to run on some pool thread (or the waiting thread).
+   */
+  void run(std::function<void()> fn);
+
+  /**
+   * @brief Wait until every spawned task has finished.
+   *
+   * @throws The first exception thrown by a task, if any.
+   */
+  void wait();
+};
@@ -0,0 +1,437 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utils/bounded_queue.h"
+
+/**
+ * @brief Activity of one pipeline stage over a run.
+ */
+struct PipelineStageStats {
+  std::string name;             /**< Stage name */
+  size_t workers = 0;           /**< Threads running the stage */
+  size_t items = 0;             /**< Items processed */
+  double busy_seconds = 0.;     /**< Time in the stage function, all threads */
+  double starved_seconds = 0.;  /**< Time waiting for input (source: for a
+                                     free buffer) */
+  double blocked_seconds = 0.;  /**< Time waiting for room downstream */
+  double wall_seconds = 0.;     /**< Duration of the run */
+
+  /**
+   * @brief Get the share of the run the stage's threads were busy (0..1).
+   *
+   * The slowest stage is the one with the highest occupancy; stages far
+   * below it have idle threads to spare.
+   */
+  double occupancy() const {
+    return wall_seconds > 0. && workers > 0
+               ? busy_seconds / (wall_seconds * double(workers))
+               : 0.;
+  }
+};
+
+/**
+ * @brief Format per-stage statistics as one line per stage.
+ */
+std::string format_pipeline_stats(
+    const std::vector<PipelineStageStats>& stats);
+
+/**
+ * @brief Pipeline of stages on dedicated threads, connected by bounded
+ * queues and recycling a fixed set of buffers.
+ *
+ * A pipeline owns @p buffers items, made once up front. The source takes a
+ * free item and fills it (e.g. decodes a frame into it); each following
+ * stage transforms it in place (preprocess, infer, postprocess, ...); after
+ * the last stage the item returns to the free list. Steady-state operation
+ * therefore allocates nothing, and the number of items in flight, which is
+ * the pipeline's memory and latency bound, is fixed.
+ *
+ * Every stage runs on its own threads; a stage with several workers
+ * processes items concurrently, so a slow stage can be widened until the
+ * pipeline's throughput approaches that of its slowest stage per worker.
+ * Stages with several workers may reorder items; a sink stage restores the
+ * source order before running. Stage functions may use parallel_for()
+ * internally.
+ *
+ * @code
+ * Pipeline<Frame> pipeline(8, [] { return Frame(1080, 1920); });
+ * pipeline.source("decode", [&](Frame& f) { return reader.next(f); })
+ *     .stage("preprocess", preprocess, 2)
+ *     .stage("infer", [&](Frame& f) { infer(f); })
+ *     .sink("postprocess", publish);
+ * pipeline.run();
+ * std::cout << format_pipeline_stats(pipeline.stats());
+ * @endcode
+ *
+ * If a stage throws, the pipeline stops and wait() rethrows the first
+ * exception. A pipeline runs once.
+ *
+ * @tparam Item Buffer type passed between the stages.
+ */
+template <typename Item>
+class Pipeline {
+ public:
+  using SourceFn = std::function<bool(Item&)>; /**< Fill; false at the end */
+  using StageFn = std::function<void(Item&)>;  /**< Transform in place */
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Recycled buffer with its position in the source order.
+   */
+  struct Slot {
+    Item item;        /**< User buffer */
+    size_t seq = 0;   /**< Index assigned by the source */
+  };
+
+  /**
+   * @brief One stage and its counters.
+   */
+  struct Stage {
+    std::string name;                     /**< Stage name */
+    SourceFn source;                      /**< Set for the source stage */
+    StageFn fn;                           /**< Set for other stages */
+    size_t workers = 1;                   /**< Threads */
+    bool ordered = false;                 /**< Runs items in source order */
+    std::atomic<size_t> running{0};       /**< Workers not yet finished */
+    std::atomic<uint64_t> items{0};       /**< Processed items */
+    std::atomic<uint64_t> busy_ns{0};     /**< In the stage function */
+    std::atomic<uint64_t> starved_ns{0};  /**< Waiting for input */
+    std::atomic<uint64_t> blocked_ns{0};  /**< Waiting for output room */
+  };
+
+  std::vector<std::unique_ptr<Slot>> slots_;   /**< Every buffer */
+  std::vector<std::unique_ptr<Stage>> stages_; /**< In flow order */
+  size_t queue_depth_;                         /**< Inter-stage capacity */
+  /** [0]: free buffers; [k]: input of stage k */
+  std::vector<std::unique_ptr<BoundedQueue<Slot*>>> queues_;
+  std::vector<std::thread> threads_;  /**< Stage workers */
+  bool started_ = false;              /**< start() was called */
+  bool sealed_ = false;               /**< A sink was added */
+  Clock::time_point start_time_;      /**< When start() ran */
+  std::atomic<int64_t> end_ns_{-1};   /**< Run duration once finished */
+  std::mutex error_mutex_;            /**< Guards error_ */
+  std::exception_ptr error_;          /**< First exception of a stage */
+
+  /**
+   * @brief Nanoseconds between two time points.
+   */
+  static uint64_t elapsed(Clock::time_point a, Clock::time_point b) {
+    return uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+  }
+
+  /**
+   * @brief Add a stage after the current last one.
+   */
+  Stage& append(std::string name, size_t workers) {
+    if (started_) throw std::runtime_error("Pipeline: already started");
+    if (sealed_)
+      throw std::invalid_argument("Pipeline: no stage may follow the sink");
+    if (workers == 0)
+      throw std::invalid_argument("Pipeline: stage needs a worker");
+    stages_.push_back(std::make_unique<Stage>());
+    Stage& stage = *stages_.back();
+    stage.name = std::move(name);
+    stage.workers = workers;
+    return stage;
+  }
+
+  /**
+   * @brief Record the first exception and stop every stage.
+   */
+  void fail(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (!error_) error_ = std::move(error);
+    }
+    stop();
+  }
+
+  /**
+   * @brief Queue receiving the output of stage @p k.
+   */
+  BoundedQueue<Slot*>& output(size_t k) {
+    return *queues_[k + 1 < stages_.size() ? k + 1 : 0];
+  }
+
+  /**
+   * @brief Mark one worker of stage @p k finished.
+   *
+   * The last worker ends the stream for the next stage; the run is over
+   * when the last stage finishes.
+   */
+  void finish(size_t k) {
+    if (stages_[k]->running.fetch_sub(1) != 1) return;
+    if (k + 1 < stages_.size()) {
+      queues_[k + 1]->close();
+    } else {
+      end_ns_.store(int64_t(elapsed(start_time_, Clock::now())));
+    }
+  }
+
+  /**
+   * @brief Worker loop of the source.
+   */
+  void runSource() {
+    Stage& stage = *stages_[0];
+    BoundedQueue<Slot*>& out = output(0);
+    try {
+      for (size_t seq = 0;; ++seq) {
+        const Clock::time_point t0 = Clock::now();
+        Slot* slot = nullptr;
+        if (!queues_[0]->pop(slot)) break;
+        const Clock::time_point t1 = Clock::now();
+        const bool more = stage.source(slot->item);
+        const Clock::time_point t2 = Clock::now();
+        stage.starved_ns += elapsed(t0, t1);
+        stage.busy_ns += elapsed(t1, t2);
+        if (!more) {
+          queues_[0]->push(slot);
+          break;
+        }
+        slot->seq = seq;
+        ++stage.items;
+        const bool pushed = out.push(slot);
+        stage.blocked_ns += elapsed(t2, Clock::now());
+        if (!pushed) break;
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+    finish(0);
+  }
+
+  /**
+   * @brief Worker loop of stage @p k > 0.
+   */
+  void runStage(size_t k) {
+    Stage& stage = *stages_[k];
+    BoundedQueue<Slot*>& in = *queues_[k];
+    BoundedQueue<Slot*>& out = output(k);
+    // Items that arrived ahead of their turn, by seq modulo the buffers.
+    std::vector<Slot*> early(stage.ordered ? slots_.size() : 0, nullptr);
+    size_t next = 0;
+    // Run one item and pass it on; false once the pipeline is stopped.
+    const auto process = [&](Slot* slot) {
+      const Clock::time_point t1 = Clock::now();
+      stage.fn(slot->item);
+      const Clock::time_point t2 = Clock::now();
+      stage.busy_ns += elapsed(t1, t2);
+      ++stage.items;
+      const bool pushed = out.push(slot);
+      stage.blocked_ns += elapsed(t2, Clock::now());
+      return pushed;
+    };
+    try {
+      for (bool open = true; open;) {
+        const Clock::time_point t0 = Clock::now();
+        Slot* slot = nullptr;
+        if (!in.pop(slot)) break;
+        stage.starved_ns += elapsed(t0, Clock::now());
+        if (!stage.ordered) {
+          open = process(slot);
+          continue;
+        }
+        early[slot->seq % early.size()] = slot;
+        for (Slot** due = &early[next % early.size()];
+             open && *due && (*due)->seq == next;
+             due = &early[next % early.size()]) {
+          slot = std::exchange(*due, nullptr);
+          ++next;
+          open = process(slot);
+        }
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+    finish(k);
+  }
+
+ public:
+  /**
+   * @brief Create the buffers of a pipeline.
+   *
+   * @param buffers Items in circulation (at least 1).
+   * @param make_item Builds each item once; default-constructed if empty.
+   * @param queue_depth Capacity of each inter-stage queue (0: @p buffers).
+   * @throws std::invalid_argument if @p buffers is 0.
+   */
+  explicit Pipeline(size_t buffers, std::function<Item()> make_item = {},
+                    size_t queue_depth = 0)
+      : queue_depth_(queue_depth ? queue_depth : buffers) {
+    if (buffers == 0)
+      throw std::invalid_argument("Pipeline: needs at least one buffer");
+    for (size_t i = 0; i < buffers; ++i) {
+      slots_.push_back(std::make_unique<Slot>());
+      if (make_item) slots_.back()->item = make_item();
+    }
+  }
+
+  /**
+   * @brief Stop and join every stage.
+   */
+  ~Pipeline() {
+    stop();
+    for (std::thread& thread : threads_)
+      if (thread.joinable()) thread.join();
+  }
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
+
+  /**
+   * @brief Set the first stage, which fills free items.
+   *
+   * @param name Stage name for statistics.
+   * @param fn Fills an item; returns false (leaving it unused) at the end
+   *        of the stream.
+   * @return This pipeline.
+   * @throws std::invalid_argument if a source was already set.
+   */
+  Pipeline& source(std::string name, SourceFn fn) {
+    if (!stages_.empty())
+      throw std::invalid_argument("Pipeline: the source must come first");
+    append(std::move(name), 1).source = std::move(fn);
+    return *this;
+  }
+
+  /**
+   * @brief Append a stage transforming items in place.
+   *
+   * @param name Stage name for statistics.
+   * @param fn Transform, called concurrently when @p workers > 1.
+   * @param workers Threads running the stage.
+   * @return This pipeline.
+   * @throws std::invalid_argument if there is no source yet, a sink was
+   *         added or @p workers is 0.
+   */
+  Pipeline& stage(std::string name, StageFn fn, size_t workers = 1) {
+    if (stages_.empty())
+      throw std::invalid_argument("Pipeline: add the source first");
+    append(std::move(name), workers).fn = std::move(fn);
+    return *this;
+  }
+
+  /**
+   * @brief Append the final stage, run on one thread in source order.
+   *
+   * @param name Stage name for statistics.
+   * @param fn Consumer of finished items.
+   * @return This pipeline.
+   * @throws std::invalid_argument as for stage().
+   */
+  Pipeline& sink(std::string name, StageFn fn) {
+    stage(std::move(name), std::move(fn), 1);
+    stages_.back()->ordered = true;
+    sealed_ = true;
+    return *this;
+  }
+
+  /**
+   * @brief Get the number of items in circulation.
+   */
+  size_t buffers() const { return slots_.size(); }
+
+  /**
+   * @brief Start every stage on its threads.
+   *
+   * @throws std::invalid_argument if there is no source.
+   * @throws std::runtime_error if the pipeline was already started.
+   */
+  void start() {
+    if (started_) throw std::runtime_error("Pipeline: already started");
+    if (stages_.empty()) throw std::invalid_argument("Pipeline: no source");
+    started_ = true;
+    queues_.push_back(std::make_unique<BoundedQueue<Slot*>>(slots_.size()));
+    for (const auto& slot : slots_) queues_[0]->push(slot.get());
+    for (size_t k = 1; k < stages_.size(); ++k)
+      queues_.push_back(std::make_unique<BoundedQueue<Slot*>>(queue_depth_));
+    start_time_ = Clock::now();
+    for (size_t k = 0; k < stages_.size(); ++k) {
+      stages_[k]->running = stages_[k]->workers;
+      for (size_t w = 0; w < stages_[k]->workers; ++w)
+        threads_.emplace_back([this, k] {
+          if (k == 0) {
+            runSource();
+          } else {
+            runStage(k);
+          }
+        });
+    }
+  }
+
+  /**
+   * @brief Wait until the stream has passed every stage.
+   *
+   * @throws The first exception thrown by a stage, if any.
+   */
+  void wait() {
+    for (std::thread& thread : threads_)
+      if (thread.joinable()) thread.join();
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      error = error_;
+    }
+    if (error) std::rethrow_exception(error);
+  }
+
+  /**
+   * @brief Run the whole stream: start() and wait().
+   */
+  void run() {
+    start();
+    wait();
+  }
+
+  /**
+   * @brief Ask every stage to stop; items in flight are dropped.
+   *
+   * Returns at once; call wait() to join the stages.
+   */
+  void stop() {
+    for (const auto& queue : queues_) queue->close();
+  }
+
+  /**
+   * @brief Get the statistics of every stage, in flow order.
+   *
+   * Counters are updated after every item, so the statistics can be polled
+   * while the pipeline runs.
+   */
+  std::vector<PipelineStageStats> stats() const {
+    const int64_t end = end_ns_.load();
+    const double wall =
+        !started_ ? 0.
+        : end >= 0
+            ? double(end) * 1e-9
+            : double(elapsed(start_time_, Clock::now())) * 1e-9;
+    std::vector<PipelineStageStats> result;
+    for (const auto& stage : stages_) {
+      PipelineStageStats s;
+      s.name = stage->name;
+      s.workers = stage->workers;
+      s.items = size_t(stage->items.load());
+      s.busy_seconds = double(stage->busy_ns.load()) * 1e-9;
+      s.starved_seconds = double(stage->starved_ns.load()) * 1e-9;
+      s.blocked_seconds = double(stage->blocked_ns.load()) * 1e-9;
+      s.wall_seconds = wall;
+      result.push_back(std::move(s));
+    }
+    return result;
+  }
+};
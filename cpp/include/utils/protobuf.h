@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Protocol buffers wire types.
+ */
+enum class ProtoWireType : uint8_t {
+  kVarint = 0,  /**< int32, int64, uint32, uint64, sint*, bool, enum */
+  kFixed64 = 1, /**< fixed64, sfixed64, double */
+  kBytes = 2,   /**< string, bytes, messages, packed repeated fields */
+  kFixed32 = 5, /**< fixed32, sfixed32, float */
+};
+
+/**
+ * @brief One field of an encoded protocol buffers message.
+ *
+ * Scalar payloads (varint and fixed) are kept in @ref value; length-delimited
+ * payloads are a view of the encoded buffer, which must outlive the field.
+ */
+struct ProtoField {
+  uint32_t number = 0;                         /**< Field number */
+  ProtoWireType wire = ProtoWireType::kVarint; /**< Wire type */
+  uint64_t value = 0;                  /**< Varint or fixed payload bits */
+  std::span<const uint8_t> bytes;      /**< Length-delimited payload */
+
+  /**
+   * @brief Get a varint payload as a (two's complement) int64.
+   */
+  int64_t asInt64() const { return int64_t(value); }
+
+  /**
+   * @brief Get a fixed32 payload as a float.
+   */
+  float asFloat() const;
+
+  /**
+   * @brief Get a fixed64 payload as a double.
+   */
+  double asDouble() const;
+
+  /**
+   * @brief Get a length-delimited payload as a string.
+   */
+  std::string_view asString() const {
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+};
+
+/**
+ * @brief Forward-only reader of the protocol buffers wire format.
+ *
+ * Decodes the fields of one message without a schema or generated code;
+ * nested messages are read by constructing a reader over ProtoField::bytes.
+ * Every read is bounds-checked, so truncated or malicious input throws
+ * rather than reading out of range. Groups (wire types 3 and 4) are not
+ * supported.
+ */
+class ProtoReader {
+ private:
+  const uint8_t* p_;   /**< Next unread byte */
+  const uint8_t* end_; /**< End of the message */
+
+ public:
+  /**
+   * @brief Create a reader over an encoded message.
+   *
+   * @param data Encoded message; must outlive the reader and its fields.
+   */
+  explicit ProtoReader(std::span<const uint8_t> data)
+      : p_(data.data()), end_(data.data() + data.size()) {}
+
+  /**
+   * @brief Read the next field.
+   *
+   * @param field Receives the field.
+   * @return false at the end of the message.
+   * @throws std::runtime_error if the encoding is invalid or truncated.
+   */
+  bool next(ProtoField& field);
+};
+
+/**
+ * @brief Append the values of a repeated varint field.
+ *
+ * Accepts both packed (one length-delimited field) and unpacked (one varint
+ * per field) encodings, so it is called once per occurrence of the field.
+ *
+ * @param field Occurrence of the field.
+ * @param out Receives the values (as int64).
+ * @throws std::runtime_error if the encoding is invalid.
+ */
+void proto_append_varints(const ProtoField& field, std::vector<int64_t>& out);
+
+/**
+ * @brief Append the values of a repeated float field (packed or unpacked).
+ *
+ * @param field Occurrence of the field.
+ * @param out Receives the values.
+ * @throws std::runtime_error if the encoding is invalid.
+ */
+void proto_append_floats(const ProtoField& field, std::vector<float>& out);
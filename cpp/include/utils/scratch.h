@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Nesting depth of scratch-holding calls on the calling thread.
+ */
+inline size_t& scratch_depth() {
+  thread_local size_t depth = 0;
+  return depth;
+}
+
+/**
+ * @brief Marks a call that holds scratch buffers across parallel_for().
+ *
+ * While a thread waits inside parallel_for() it may run TaskGroup tasks
+ * queued on it, and such a task may call the same kernel again. A kernel
+ * that keeps per-thread scratch alive across a parallel_for() opens a
+ * ScratchScope first; calls nested inside it on the same thread then get
+ * buffers of the next depth instead of overwriting the ones in use.
+ */
+class ScratchScope {
+ public:
+  ScratchScope() : depth_(scratch_depth()++) {}
+  ~ScratchScope() { --scratch_depth(); }
+
+  ScratchScope(const ScratchScope&) = delete;
+  ScratchScope& operator=(const ScratchScope&) = delete;
+
+  /**
+   * @brief Depth of this scope, counting from zero.
+   */
+  size_t depth() const { return depth_; }
+
+ private:
+  size_t depth_; /**< Depth of this scope */
+};
+
+/**
+ * @brief Per-thread 64-byte aligned scratch buffers, one set per depth.
+ *
+ * Declare one thread_local instance per kernel. Buffers only grow, so
+ * steady-state calls do not allocate, and growing the set of depths does
+ * not move buffers already handed out.
+ *
+ * @tparam T Element type.
+ * @tparam Slots Number of independent buffers per depth.
+ */
+template <typename T, size_t Slots = 1>
+class ScratchBuffers {
+ public:
+  /**
+   * @brief Get buffer @p slot of @p n elements for the current depth.
+   *
+   * The depth is that of the innermost open ScratchScope, or zero outside
+   * any scope.
+   */
+  T* get(size_t slot, size_t n) {
+    const size_t depth = scratch_depth() ? scratch_depth() - 1 : 0;
+    if (levels_.size() <= depth) levels_.resize(depth + 1);
+    Tensor<T>& buffer = levels_[depth][slot];
+    if (buffer.numel() < n) buffer = Tensor<T>(Shape{n});
+    return buffer.data();
+  }
+
+ private:
+  std::vector<std::array<Tensor<T>, Slots>> levels_; /**< Buffers by depth */
+};
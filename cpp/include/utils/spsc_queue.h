@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "utils/wait.h"
+
+/**
+ * @brief Lock-free bounded ring buffer for one producer and one consumer.
+ *
+ * The producer owns the tail index and the consumer the head index, each
+ * on its own cache line, and each side keeps a cached copy of the other's
+ * index so the shared line is only read when the ring looks full (or
+ * empty). A push or pop is then a slot access plus one release store.
+ * Never blocks: pair it with an EventCount to let an idle consumer sleep.
+ *
+ * Exactly one thread may push and one (other) thread may pop at a time.
+ *
+ * @tparam T Element type (default-constructible and movable).
+ */
+template <typename T>
+class SpscQueue {
+ private:
+  std::vector<T> slots_; /**< Ring storage (a power of two) */
+  size_t mask_;          /**< slots_.size() - 1 */
+  /** Next slot to pop, written by the consumer */
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0; /**< Consumer's copy of tail_ */
+  /** Next slot to push, written by the producer */
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0; /**< Producer's copy of head_ */
+
+ public:
+  /**
+   * @brief Construct an empty queue.
+   *
+   * @param capacity Least number of elements held at once; rounded up to
+   *        a power of two.
+   * @throws std::invalid_argument if @p capacity is 0.
+   */
+  explicit SpscQueue(size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("SpscQueue: capacity must be positive");
+    size_t size = 1;
+    while (size < capacity) size *= 2;
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /**
+   * @brief Get the most elements held at once.
+   */
+  size_t capacity() const { return slots_.size(); }
+
+  /**
+   * @brief Get the number of stored elements (approximate while the other
+   * side runs).
+   */
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Append an element unless the queue is full (producer only).
+   *
+   * @param value Element; left untouched on failure.
+   * @return false if the queue is full.
+   */
+  bool tryPush(T& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == slots_.size()) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == slots_.size()) return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Append a temporary unless the queue is full (producer only).
+   */
+  bool tryPush(T&& value) { return tryPush(value); }
+
+  /**
+   * @brief Remove the oldest element if there is one (consumer only).
+   *
+   * @param value Receives the element.
+   * @return false if the queue is empty.
+   */
+  bool tryPop(T& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/cpu_features.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+#endif
+
+/**
+ * Size that keeps independently written atomics on separate cache lines,
+ * so producers and consumers do not invalidate each other's line (false
+ * sharing).
+ */
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * @brief Hint to the CPU that the thread is spinning.
+ *
+ * On x86 this is PAUSE, which saves power and frees the core for the
+ * sibling hyper-thread while a spin loop waits.
+ */
+inline void cpu_relax() {
+#if defined(VF_X86)
+  _mm_pause();
+#endif
+}
+
+/**
+ * @brief Sleep while a word holds an expected value.
+ *
+ * Uses the futex system call on Linux and std::atomic::wait elsewhere.
+ * May return spuriously; callers re-check their condition.
+ *
+ * @param word Word to watch.
+ * @param expected Value to sleep on; returns at once if @p word differs.
+ * @param shared The word lives in memory shared between processes (Linux
+ *        only; process-private futexes are cheaper).
+ */
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected,
+                bool shared = false);
+
+/**
+ * @brief Like futex_wait(), giving up after @p timeout.
+ *
+ * @return false if the timeout expired (spurious returns count as true).
+ */
+bool futex_wait_for(std::atomic<uint32_t>& word, uint32_t expected,
+                    std::chrono::nanoseconds timeout, bool shared = false);
+
+/**
+ * @brief Wake threads sleeping in futex_wait() on @p word.
+ *
+ * @param word Watched word.
+ * @param all Wake every waiter instead of one.
+ * @param shared Must match the waiters' @p shared.
+ */
+void futex_wake(std::atomic<uint32_t>& word, bool all = false,
+                bool shared = false);
+
+/**
+ * @brief Lets consumers of a lock-free structure sleep until a producer
+ * publishes something, without a mutex on the fast path.
+ *
+ * A consumer that found nothing first spins briefly, then announces
+ * itself with prepareWait(), re-checks its condition and only then
+ * sleeps in wait() on the returned key; a producer calls notify() after
+ * publishing. The announcement is ordered before the re-check and the
+ * publication before notify()'s check for waiters, so a wakeup cannot be
+ * lost between the consumer's check and its sleep, and producers pay only
+ * an atomic load while nobody waits.
+ *
+ * @code
+ *   T item;
+ *   events.await([&] { return queue.tryPop(item); });
+ * @endcode
+ */
+class EventCount {
+ private:
+  alignas(kCacheLineSize) std::atomic<uint32_t> epoch_{0}; /**< Futex word */
+  alignas(kCacheLineSize) std::atomic<uint32_t> waiters_{0}; /**< Sleepers */
+
+ public:
+  /** Spins of await() before going to sleep. */
+  static constexpr int kSpins = 128;
+
+  /**
+   * @brief Announce an imminent wait.
+   *
+   * @return Key for wait(); re-check the condition before waiting.
+   */
+  uint32_t prepareWait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    // Orders the announcement before the caller's re-check (pairs with
+    // the fence in notify()).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Withdraw a prepareWait() whose re-check succeeded.
+   */
+  void cancelWait() { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+  /**
+   * @brief Sleep until a notify() after prepareWait() returned @p key.
+   */
+  void wait(uint32_t key) {
+    while (epoch_.load(std::memory_order_acquire) == key)
+      futex_wait(epoch_, key);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Wake waiters after publishing.
+   *
+   * @param all Wake every waiter instead of one.
+   */
+  void notify(bool all = false) {
+    // Orders the caller's publication before the waiter check.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) return;
+    epoch_.fetch_add(1, std::memory_order_release);
+    futex_wake(epoch_, all);
+  }
+
+  /**
+   * @brief Wait until @p ready returns true: spin, then sleep.
+   *
+   * @param ready Condition; typically a try-operation on the structure.
+   */
+  template <typename Predicate>
+  void await(Predicate&& ready) {
+    for (int i = 0; i < kSpins; ++i) {
+      if (ready()) return;
+      cpu_relax();
+    }
+    for (;;) {
+      const uint32_t key = prepareWait();
+      if (ready()) {
+        cancelWait();
+        return;
+      }
+      wait(key);
+      if (ready()) return;
+    }
+  }
+};
@@ -0,0 +1,207 @@
+#include "detection/mask_paste.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "utils/parallel.h"
+
+/**
+ * @brief Bilinear sampling position of one image row or column in a mask.
+ *
+ * Neighbours outside the mask get a zero weight (zero padding) and a clamped
+ * index so that reads stay in bounds.
+ */
+struct PasteSample {
+  size_t lo = 0;    /**< Lower mask neighbour */
+  size_t hi = 0;    /**< Upper mask neighbour */
+  float w_lo = 0.f; /**< Weight of the lower neighbour */
+  float w_hi = 0.f; /**< Weight of the upper neighbour */
+};
+
+/**
+ * @brief Image region a mask is resampled over, as half-open pixel ranges.
+ */
+struct PasteExtent {
+  size_t x0 = 0; /**< First column */
+  size_t x1 = 0; /**< One past the last column */
+  size_t y0 = 0; /**< First row */
+  size_t y1 = 0; /**< One past the last row */
+};
+
+/**
+ * @brief Compute the pixel range covered by a box, padded by one pixel.
+ *
+ * @param lo Box start coordinate.
+ * @param hi Box end coordinate.
+ * @param size Image size along the axis.
+ * @param first Receives the first pixel of the range.
+ * @param last Receives one past the last pixel of the range.
+ */
+static void axis_extent(float lo, float hi, size_t size, size_t& first,
+                        size_t& last) {
+  const float limit = static_cast<float>(size);
+  first = static_cast<size_t>(std::clamp(std::floor(lo) - 1.f, 0.f, limit));
+  last = static_cast<size_t>(std::clamp(std::ceil(hi) + 1.f, 0.f, limit));
+  last = std::max(first, last);
+}
+
+/**
+ * @brief Compute the paste extent of box @p i.
+ */
+static PasteExtent paste_extent(const BoxSet& boxes, size_t i, size_t height,
+                                size_t width) {
+  PasteExtent e;
+  axis_extent(boxes.x1[i], boxes.x2[i], width, e.x0, e.x1);
+  axis_extent(boxes.y1[i], boxes.y2[i], height, e.y0, e.y1);
+  return e;
+}
+
+/**
+ * @brief Compute mask sampling positions for the pixels [first, last).
+ *
+ * Pixel centres are mapped into the mask as in `grid_sample` with
+ * `align_corners=False`.
+ *
+ * @param start Box start coordinate.
+ * @param end Box end coordinate.
+ * @param first First pixel.
+ * @param last One past the last pixel.
+ * @param mask_size Mask size along the axis.
+ * @param samples Receives one sample per pixel.
+ */
+static void axis_samples(float start, float end, size_t first, size_t last,
+                         size_t mask_size, std::vector<PasteSample>& samples) {
+  samples.assign(last - first, PasteSample{});
+  const float extent = end - start;
+  if (!(extent > 0.f)) return;
+  const float scale = static_cast<float>(mask_size) / extent;
+  const auto max_index = static_cast<long long>(mask_size) - 1;
+  for (size_t p = first; p < last; ++p) {
+    const float u = (static_cast<float>(p) + .5f - start) * scale - .5f;
+    const float fl = std::floor(u);
+    const auto lo = static_cast<long long>(fl);
+    const float l = u - fl;
+    PasteSample& s = samples[p - first];
+    if (lo >= 0 && lo <= max_index) {
+      s.lo = static_cast<size_t>(lo);
+      s.w_lo = 1.f - l;
+    }
+    if (lo + 1 >= 0 && lo + 1 <= max_index) {
+      s.hi = static_cast<size_t>(lo + 1);
+      s.w_hi = l;
+    }
+  }
+}
+
+/**
+ * @brief Evaluate the resampled mask probability at one pixel.
+ */
+static float sample_mask(const float* mask, size_t mask_width,
+                         const PasteSample& sy, const PasteSample& sx) {
+  const float* row_lo = mask + sy.lo * mask_width;
+  const float* row_hi = mask + sy.hi * mask_width;
+  return sy.w_lo * (sx.w_lo * row_lo[sx.lo] + sx.w_hi * row_lo[sx.hi]) +
+         sy.w_hi * (sx.w_lo * row_hi[sx.lo] + sx.w_hi * row_hi[sx.hi]);
+}
+
+/**
+ * @brief Check that masks and boxes describe the same instances.
+ */
+static void check_inputs(const Tensor<float>& masks, const BoxSet& boxes) {
+  if (masks.rank() != 3)
+    throw std::invalid_argument("paste_masks: masks must be [N, H, W]");
+  if (masks.dim(0) != boxes.size())
+    throw std::invalid_argument("paste_masks: one mask per box required");
+}
+
+/**
+ * @brief Paste per-instance mask predictions into image space as RLEs.
+ */
+std::vector<Rle> paste_masks_rle(const Tensor<float>& masks,
+                                 const BoxSet& boxes, size_t height,
+                                 size_t width, const MaskPasteParams& params) {
+  check_inputs(masks, boxes);
+  const size_t n = boxes.size();
+  const size_t mh = masks.dim(1), mw = masks.dim(2);
+  std::vector<Rle> result(n);
+
+  parallel_for(0, n, 1, [&](size_t first, size_t last) {
+    std::vector<PasteSample> ys, xs;
+    for (size_t i = first; i < last; ++i) {
+      const PasteExtent e = paste_extent(boxes, i, height, width);
+      axis_samples(boxes.y1[i], boxes.y2[i], e.y0, e.y1, mh, ys);
+      axis_samples(boxes.x1[i], boxes.x2[i], e.x0, e.x1, mw, xs);
+      const float* mask = masks.data() + i * mh * mw;
+
+      // Traverse the box extent column by column; everything outside it is
+      // a run of zeros that the builder merges for free.
+      RleBuilder builder(height, width);
+      builder.append(false, e.x0 * height);
+      for (size_t x = e.x0; x < e.x1; ++x) {
+        const PasteSample& sx = xs[x - e.x0];
+        builder.append(false, e.y0);
+        for (size_t y = e.y0; y < e.y1; ++y) {
+          const float v = sample_mask(mask, mw, ys[y - e.y0], sx);
+          builder.append(v >= params.threshold, 1);
+        }
+        builder.append(false, height - e.y1);
+      }
+      result[i] = builder.finish();
+    }
+  });
+  return result;
+}
+
+/**
+ * @brief Paste per-instance mask predictions into a shared label image.
+ */
+void paste_masks_label_image(const Tensor<float>& masks, const BoxSet& boxes,
+                             Tensor<int32_t>& labels,
+                             const MaskPasteParams& params) {
+  check_inputs(masks, boxes);
+  if (labels.rank() != 2)
+    throw std::invalid_argument("paste_masks: labels must be [H, W]");
+  const size_t n = boxes.size();
+  const size_t height = labels.dim(0), width = labels.dim(1);
+  const size_t mh = masks.dim(1), mw = masks.dim(2);
+
+  // Rank instances by descending score so overlaps resolve deterministically.
+  std::vector<size_t> order(n), rank(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return boxes.scores[a] > boxes.scores[b];
+  });
+  for (size_t r = 0; r < n; ++r) rank[order[r]] = r;
+
+  int32_t* out = labels.data();
+  parallel_for(0, n, 1, [&](size_t first, size_t last) {
+    std::vector<PasteSample> ys, xs;
+    for (size_t i = first; i < last; ++i) {
+      const PasteExtent e = paste_extent(boxes, i, height, width);
+      axis_samples(boxes.y1[i], boxes.y2[i], e.y0, e.y1, mh, ys);
+      axis_samples(boxes.x1[i], boxes.x2[i], e.x0, e.x1, mw, xs);
+      const float* mask = masks.data() + i * mh * mw;
+      const auto id = static_cast<int32_t>(i + 1);
+
+      for (size_t y = e.y0; y < e.y1; ++y) {
+        const PasteSample& sy = ys[y - e.y0];
+        for (size_t x = e.x0; x < e.x1; ++x) {
+          if (sample_mask(mask, mw, sy, xs[x - e.x0]) < params.threshold)
+            continue;
+          // Claim the pixel unless a higher ranked instance already has it.
+          std::atomic_ref<int32_t> pixel(out[y * width + x]);
+          int32_t current = pixel.load(std::memory_order_relaxed);
+          while (current == 0 ||
+                 rank[static_cast<size_t>(current - 1)] > rank[i]) {
+            if (pixel.compare_exchange_weak(current, id,
+                                            std::memory_order_relaxed))
+              break;
+          }
+        }
+      }
+    }
+  });
+}
@@ -0,0 +1,123 @@
+#include "detection/panoptic.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * @brief Visit the row-major offsets of every set pixel of an RLE.
+ *
+ * Runs are in column-major order, so each run walks down image columns with
+ * a stride of the image width.
+ *
+ * @param rle The encoded mask.
+ * @param fn Callable invoked with the row-major offset of each set pixel.
+ */
+template <typename Function>
+static void for_each_set_pixel(const Rle& rle, Function&& fn) {
+  const size_t height = rle.height, width = rle.width;
+  size_t p = 0;
+  for (size_t i = 0; i < rle.counts.size(); ++i) {
+    const size_t run = rle.counts[i];
+    if (i % 2 == 1) {
+      size_t y = p % height, x = p / height;
+      for (size_t k = 0; k < run; ++k) {
+        fn(y * width + x);
+        if (++y == height) {
+          y = 0;
+          ++x;
+        }
+      }
+    }
+    p += run;
+  }
+}
+
+/**
+ * @brief Merge instance and semantic predictions into a panoptic image.
+ */
+PanopticResult panoptic_merge(const std::vector<Rle>& masks,
+                              const BoxSet& instances,
+                              const Tensor<int32_t>& semantic,
+                              const std::vector<bool>& is_stuff,
+                              const PanopticParams& params) {
+  if (semantic.rank() != 2)
+    throw std::invalid_argument("panoptic_merge: semantic must be [H, W]");
+  if (masks.size() != instances.size())
+    throw std::invalid_argument("panoptic_merge: one mask per instance");
+  const size_t height = semantic.dim(0), width = semantic.dim(1);
+  for (const Rle& m : masks)
+    if (m.height != height || m.width != width)
+      throw std::invalid_argument("panoptic_merge: mask size mismatch");
+
+  PanopticResult result;
+  result.ids = Tensor<uint32_t>(Shape{height, width});
+  uint32_t* ids = result.ids.data();
+  const uint32_t void_id = params.void_id;
+  if (void_id != 0) result.ids.fill(void_id);
+
+  // Things: best instances first, painting only unclaimed pixels.
+  std::vector<size_t> order(instances.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return instances.scores[a] > instances.scores[b];
+  });
+  std::unordered_map<int32_t, uint32_t> next_instance;
+  for (size_t i : order) {
+    if (instances.scores[i] < params.score_threshold) break;
+    size_t area = 0, overlap = 0;
+    for_each_set_pixel(masks[i], [&](size_t p) {
+      ++area;
+      overlap += ids[p] != void_id;
+    });
+    if (area == 0 || static_cast<float>(overlap) >
+                         params.overlap_threshold * static_cast<float>(area))
+      continue;
+
+    const int32_t category = instances.labels[i];
+    const uint32_t id = static_cast<uint32_t>(category) * params.label_divisor +
+                        ++next_instance[category];
+    for_each_set_pixel(masks[i], [&](size_t p) {
+      if (ids[p] == void_id) ids[p] = id;
+    });
+    result.segments.push_back(
+        {id, category, true, area - overlap, instances.scores[i],
+         static_cast<int64_t>(i)});
+  }
+
+  // Stuff: one pass over the image filling unclaimed pixels.
+  const int32_t* sem = semantic.data();
+  std::vector<size_t> stuff_area(is_stuff.size(), 0);
+  for (size_t p = 0; p < height * width; ++p) {
+    const int32_t c = sem[p];
+    if (ids[p] != void_id || c < 0 ||
+        static_cast<size_t>(c) >= is_stuff.size() || !is_stuff[c])
+      continue;
+    ids[p] = static_cast<uint32_t>(c) * params.label_divisor;
+    ++stuff_area[c];
+  }
+
+  // Return undersized stuff segments to void; only needed if any exist.
+  std::vector<bool> rejected(is_stuff.size(), false);
+  bool any_rejected = false;
+  for (size_t c = 0; c < stuff_area.size(); ++c) {
+    if (stuff_area[c] == 0) continue;
+    if (stuff_area[c] < params.stuff_area_threshold) {
+      rejected[c] = any_rejected = true;
+      continue;
+    }
+    result.segments.push_back({static_cast<uint32_t>(c) * params.label_divisor,
+                               static_cast<int32_t>(c), false, stuff_area[c],
+                               0.f, -1});
+  }
+  if (any_rejected) {
+    for (size_t p = 0; p < height * width; ++p) {
+      const int32_t c = sem[p];
+      if (c >= 0 && static_cast<size_t>(c) < rejected.size() && rejected[c] &&
+          ids[p] == static_cast<uint32_t>(c) * params.label_divisor)
+        ids[p] = void_id;
+    }
+  }
+  return result;
+}
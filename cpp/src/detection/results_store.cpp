@@ -0,0 +1,534 @@
+#include "detection/results_store.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+static_assert(std::endian::native == std::endian::little,
+              "results store files use little-endian byte order");
+static_assert(std::is_trivially_copyable_v<ResultsBlockInfo> &&
+                  sizeof(ResultsBlockInfo) == 64,
+              "ResultsBlockInfo is written to disk as-is");
+
+static constexpr char kMagic[8] = {'V', 'F', 'R', 'S', 'T', 'O', 'R', 'E'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kHeaderBytes = 16;
+static constexpr size_t kTrailerBytes = 16;
+
+/**
+ * @brief Round @p n up to a multiple of 8.
+ */
+static uint64_t pad8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+/**
+ * @brief Size in bytes of a block with @p rows rows.
+ */
+static uint64_t block_bytes(uint32_t rows, uint32_t frame_bytes) {
+  return pad8(uint64_t(rows) * (5 * sizeof(float) + sizeof(uint16_t)) +
+              frame_bytes);
+}
+
+/**
+ * @brief Append @p v as a zigzag LEB128 varint.
+ */
+static void put_varint(std::vector<uint8_t>& out, int64_t v) {
+  uint64_t u = (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+  while (u >= 0x80) {
+    out.push_back(uint8_t(u) | 0x80);
+    u >>= 7;
+  }
+  out.push_back(uint8_t(u));
+}
+
+/**
+ * @brief Decode a zigzag LEB128 varint, advancing @p p.
+ */
+static int64_t get_varint(const uint8_t*& p, const uint8_t* end) {
+  uint64_t u = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    const uint8_t b = *p++;
+    u |= uint64_t(b & 0x7f) << shift;
+    if (!(b & 0x80)) return int64_t(u >> 1) ^ -int64_t(u & 1);
+  }
+  throw std::runtime_error("ResultsStoreReader: corrupt frame id column");
+}
+
+/**
+ * @brief Bounds-checked little-endian reader over a byte range.
+ */
+struct ByteCursor {
+  const uint8_t* p;
+  const uint8_t* end;
+
+  template <typename T>
+  T get() {
+    if (size_t(end - p) < sizeof(T))
+      throw std::runtime_error("ResultsStoreReader: truncated footer");
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+  }
+};
+
+/**
+ * @brief Map a store and read its footers.
+ */
+ResultsStoreReader::ResultsStoreReader(const std::string& path)
+    : file_(path) {
+  const uint8_t* base = file_.data();
+  const size_t size = file_.size();
+  if (size < kHeaderBytes + kTrailerBytes || std::memcmp(base, kMagic, 8) != 0)
+    throw std::runtime_error("ResultsStoreReader: not a results store: " +
+                             path);
+  ByteCursor header{base + 8, base + kHeaderBytes};
+  if (header.get<uint32_t>() != kVersion)
+    throw std::runtime_error("ResultsStoreReader: unsupported version");
+  rows_per_block_ = header.get<uint32_t>();
+
+  // Trailers sit on 8-byte boundaries. A writer that died mid-write leaves
+  // a torn block or footer at the end; the newest intact trailer before it
+  // then describes the store.
+  for (uint64_t trailer = (size - kTrailerBytes) / 8 * 8;
+       trailer > kHeaderBytes; trailer -= 8) {
+    if (std::memcmp(base + trailer + 8, kMagic, 8) != 0) continue;
+    try {
+      readIndex(trailer);
+    } catch (const std::runtime_error&) {
+      blocks_.clear();
+      classes_.clear();
+      rows_ = 0;
+      continue;
+    }
+    BoxSet bounds;
+    bounds.reserve(blocks_.size());
+    for (const ResultsBlockInfo& b : blocks_)
+      bounds.push_back(b.x_min, b.y_min, b.x_max, b.y_max, 0.f, 0);
+    block_tree_.emplace(bounds);
+    return;
+  }
+  throw std::runtime_error("ResultsStoreReader: no intact footer in " + path);
+}
+
+/**
+ * @brief Read the chain of footers ending at the trailer at @p trailer.
+ */
+void ResultsStoreReader::readIndex(uint64_t trailer) {
+  const uint8_t* base = file_.data();
+  data_end_ = trailer + kTrailerBytes;
+  // Footers are visited newest first; each adds blocks and classes.
+  std::vector<std::vector<ResultsBlockInfo>> block_runs;
+  std::vector<std::vector<ResultsClass>> class_runs;
+  uint64_t at = trailer;
+  while (at != 0) {
+    ByteCursor link{base + at, base + at + kTrailerBytes};
+    const auto footer_at = link.get<uint64_t>();
+    if (std::memcmp(link.p, kMagic, 8) != 0 || footer_at < kHeaderBytes ||
+        footer_at % 8 != 0 || footer_at >= at)
+      throw std::runtime_error("ResultsStoreReader: bad footer offset");
+
+    ByteCursor footer{base + footer_at, base + at};
+    const auto previous = footer.get<uint64_t>();
+    if (previous != 0 &&
+        (previous % 8 != 0 || previous + kTrailerBytes > footer_at))
+      throw std::runtime_error("ResultsStoreReader: bad footer link");
+    const auto n_blocks = footer.get<uint64_t>();
+    if (n_blocks > (at - footer_at) / sizeof(ResultsBlockInfo))
+      throw std::runtime_error("ResultsStoreReader: bad block count");
+    std::vector<ResultsBlockInfo>& blocks = block_runs.emplace_back(n_blocks);
+    for (auto& b : blocks) {
+      b = footer.get<ResultsBlockInfo>();
+      if (b.offset < kHeaderBytes || b.offset % 8 != 0 ||
+          b.offset + block_bytes(b.rows, b.frame_bytes) > footer_at)
+        throw std::runtime_error("ResultsStoreReader: block out of range");
+    }
+    std::vector<ResultsClass>& classes =
+        class_runs.emplace_back(footer.get<uint32_t>());
+    for (auto& c : classes) {
+      c.label = footer.get<int32_t>();
+      const auto len = footer.get<uint32_t>();
+      if (size_t(footer.end - footer.p) < len)
+        throw std::runtime_error("ResultsStoreReader: truncated footer");
+      c.name.assign(reinterpret_cast<const char*>(footer.p), len);
+      footer.p += len;
+    }
+    if (pad8(uint64_t(footer.p - base)) != at)
+      throw std::runtime_error("ResultsStoreReader: footer size mismatch");
+    at = previous;
+  }
+  for (size_t run = block_runs.size(); run-- > 0;) {
+    for (const ResultsBlockInfo& b : block_runs[run]) rows_ += b.rows;
+    blocks_.insert(blocks_.end(), block_runs[run].begin(),
+                   block_runs[run].end());
+    classes_.insert(classes_.end(), class_runs[run].begin(),
+                    class_runs[run].end());
+  }
+}
+
+/**
+ * @brief Squared distance from a point to the nearest point of a box.
+ */
+static float box_distance_sq(float x, float y, float x1, float y1, float x2,
+                             float y2) {
+  const float dx = std::max({x1 - x, 0.f, x - x2});
+  const float dy = std::max({y1 - y, 0.f, y - y2});
+  return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Check whether the zone map of @p b admits rows matching @p query.
+ */
+static bool block_matches(const ResultsBlockInfo& b, const ResultsQuery& query,
+                          uint64_t class_mask) {
+  const SpatialWindow* w = query.window ? &*query.window : nullptr;
+  return b.frame_max >= query.frame_min && b.frame_min <= query.frame_max &&
+         b.score_max >= query.min_score && (b.class_mask & class_mask) &&
+         !(w && (b.x_min > w->x2 || b.y_min > w->y2 || b.x_max < w->x1 ||
+                 b.y_max < w->y1));
+}
+
+/**
+ * @brief Map the labels of @p query to dictionary codes.
+ */
+std::vector<bool> ResultsStoreReader::acceptedCodes(
+    const ResultsQuery& query, uint64_t& class_mask) const {
+  std::vector<bool> accept;
+  class_mask = ~uint64_t(0);
+  if (query.labels.empty()) return accept;
+  accept.assign(classes_.size(), false);
+  class_mask = 0;
+  for (size_t code = 0; code < classes_.size(); ++code)
+    if (std::find(query.labels.begin(), query.labels.end(),
+                  classes_[code].label) != query.labels.end()) {
+      accept[code] = true;
+      class_mask |= uint64_t(1) << (code % 64);
+    }
+  return accept;
+}
+
+/**
+ * @brief Append the rows of block @p b matching @p query to @p out.
+ */
+void ResultsStoreReader::scanBlock(const ResultsBlockInfo& b,
+                                   const ResultsQuery& query,
+                                   const std::vector<bool>& accept,
+                                   ResultsRows& out) const {
+  const uint8_t* col = file_.data() + b.offset;
+  const auto* scores = reinterpret_cast<const float*>(col);
+  const float* x1 = scores + b.rows;
+  const float* y1 = x1 + b.rows;
+  const float* x2 = y1 + b.rows;
+  const float* y2 = x2 + b.rows;
+  const auto* codes = reinterpret_cast<const uint16_t*>(y2 + b.rows);
+  const uint8_t* fp = reinterpret_cast<const uint8_t*>(codes + b.rows);
+  const uint8_t* fend = fp + b.frame_bytes;
+  const SpatialWindow* w = query.window ? &*query.window : nullptr;
+
+  int64_t frame = b.frame_min;
+  for (uint32_t i = 0; i < b.rows; ++i) {
+    frame += get_varint(fp, fend);
+    if (frame < query.frame_min || frame > query.frame_max ||
+        scores[i] < query.min_score)
+      continue;
+    if (codes[i] >= classes_.size())
+      throw std::runtime_error("ResultsStoreReader: bad class code");
+    if (!accept.empty() && !accept[codes[i]]) continue;
+    if (w && (x1[i] > w->x2 || y1[i] > w->y2 || x2[i] < w->x1 ||
+              y2[i] < w->y1))
+      continue;
+    out.frame_ids.push_back(frame);
+    out.boxes.push_back(x1[i], y1[i], x2[i], y2[i], scores[i],
+                        classes_[codes[i]].label);
+  }
+}
+
+/**
+ * @brief Return all detections matching @p query.
+ */
+ResultsRows ResultsStoreReader::scan(const ResultsQuery& query,
+                                     ResultsScanStats* stats) const {
+  uint64_t class_mask = 0;
+  const std::vector<bool> accept = acceptedCodes(query, class_mask);
+  const auto admits = [&](uint32_t block) {
+    return block_matches(blocks_[block], query, class_mask);
+  };
+  // A window query only visits the blocks the R-tree finds in it.
+  std::vector<uint32_t> visit;
+  if (query.window) {
+    block_tree_->search(*query.window, visit, admits);
+    std::sort(visit.begin(), visit.end());  // storage order
+  } else {
+    for (uint32_t block = 0; block < blocks_.size(); ++block)
+      if (admits(block)) visit.push_back(block);
+  }
+
+  ResultsScanStats local;
+  local.blocks_total = blocks_.size();
+  local.blocks_skipped = blocks_.size() - visit.size();
+  ResultsRows out;
+  for (const uint32_t block : visit) {
+    local.rows_scanned += blocks_[block].rows;
+    scanBlock(blocks_[block], query, accept, out);
+  }
+  if (stats) *stats = local;
+  return out;
+}
+
+/**
+ * @brief Return the detections matching @p query closest to a point.
+ */
+ResultsRows ResultsStoreReader::nearest(float x, float y, size_t k,
+                                        const ResultsQuery& query,
+                                        ResultsScanStats* stats) const {
+  uint64_t class_mask = 0;
+  const std::vector<bool> accept = acceptedCodes(query, class_mask);
+  ResultsScanStats local;
+  local.blocks_total = blocks_.size();
+  local.blocks_skipped = blocks_.size();
+  ResultsRows found;
+  std::vector<float> distances;
+  // The k smallest distances so far; the largest of them is on top.
+  std::priority_queue<float> best;
+  if (k != 0) {
+    // The distance of a block's bounds is a lower bound for its rows.
+    const std::vector<uint32_t> order = block_tree_->nearest(
+        x, y, blocks_.size(), std::numeric_limits<float>::infinity(),
+        [&](uint32_t block) {
+          return block_matches(blocks_[block], query, class_mask);
+        });
+    for (const uint32_t block : order) {
+      const ResultsBlockInfo& b = blocks_[block];
+      if (best.size() == k &&
+          box_distance_sq(x, y, b.x_min, b.y_min, b.x_max, b.y_max) >
+              best.top())
+        break;
+      --local.blocks_skipped;
+      local.rows_scanned += b.rows;
+      const size_t first = found.boxes.size();
+      scanBlock(b, query, accept, found);
+      for (size_t i = first; i < found.boxes.size(); ++i) {
+        const float d =
+            box_distance_sq(x, y, found.boxes.x1[i], found.boxes.y1[i],
+                            found.boxes.x2[i], found.boxes.y2[i]);
+        distances.push_back(d);
+        if (best.size() < k) {
+          best.push(d);
+        } else if (d < best.top()) {
+          best.pop();
+          best.push(d);
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> rank(distances.size());
+  std::iota(rank.begin(), rank.end(), size_t(0));
+  std::stable_sort(rank.begin(), rank.end(), [&](size_t a, size_t b) {
+    return distances[a] < distances[b];
+  });
+  rank.resize(std::min(rank.size(), k));
+  ResultsRows out;
+  out.boxes.reserve(rank.size());
+  for (const size_t i : rank) {
+    out.frame_ids.push_back(found.frame_ids[i]);
+    out.boxes.push_back(found.boxes.x1[i], found.boxes.y1[i],
+                        found.boxes.x2[i], found.boxes.y2[i],
+                        found.boxes.scores[i], found.boxes.labels[i]);
+  }
+  if (stats) *stats = local;
+  return out;
+}
+
+/**
+ * @brief Create a store, or reopen one for appending.
+ */
+ResultsStoreWriter::ResultsStoreWriter(const std::string& path,
+                                       std::vector<std::string> class_names,
+                                       bool append, uint32_t rows_per_block)
+    : path_(path),
+      rows_per_block_(rows_per_block),
+      class_names_(std::move(class_names)) {
+  if (rows_per_block_ == 0)
+    throw std::invalid_argument("ResultsStoreWriter: rows_per_block is 0");
+
+  if (append && std::filesystem::exists(path)) {
+    {
+      const ResultsStoreReader existing(path);
+      rows_per_block_ = existing.rowsPerBlock();
+      offset_ = existing.dataEnd();
+      blocks_ = existing.blocks();
+      classes_ = existing.classes();
+    }
+    last_trailer_ = offset_ - kTrailerBytes;
+    indexed_blocks_ = blocks_.size();
+    indexed_classes_ = classes_.size();
+    // Only the torn tail of a writer that died, if any, is dropped; the
+    // index stays intact until the next footer extends it.
+    std::filesystem::resize_file(path, offset_);
+    out_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    out_.seekp(std::streamoff(offset_));
+  } else {
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    out_.write(kMagic, 8);
+    out_.write(reinterpret_cast<const char*>(&kVersion), 4);
+    out_.write(reinterpret_cast<const char*>(&rows_per_block_), 4);
+    offset_ = kHeaderBytes;
+    writeFooter();  // an empty store is readable too
+  }
+  if (!out_)
+    throw std::runtime_error("ResultsStoreWriter: cannot open " + path);
+  open_ = true;
+  pending_.reserve(rows_per_block_);
+  frames_.reserve(rows_per_block_);
+}
+
+/**
+ * @brief Flush pending rows and finalise the store.
+ */
+ResultsStoreWriter::~ResultsStoreWriter() {
+  try {
+    close();
+  } catch (...) {
+    // Destructors must not throw; call close() to observe write errors.
+  }
+}
+
+/**
+ * @brief Look up or assign the dictionary code of @p label.
+ */
+uint16_t ResultsStoreWriter::classCode(int32_t label) {
+  for (size_t code = 0; code < classes_.size(); ++code)
+    if (classes_[code].label == label) return uint16_t(code);
+  if (classes_.size() > std::numeric_limits<uint16_t>::max())
+    throw std::length_error("ResultsStoreWriter: too many classes");
+  std::string name;
+  if (label >= 0 && size_t(label) < class_names_.size())
+    name = class_names_[size_t(label)];
+  classes_.push_back({label, std::move(name)});
+  return uint16_t(classes_.size() - 1);
+}
+
+/**
+ * @brief Append the detections of one frame.
+ */
+void ResultsStoreWriter::append(int64_t frame_id, const BoxSet& boxes) {
+  if (!open_) throw std::logic_error("ResultsStoreWriter: store is closed");
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    frames_.push_back(frame_id);
+    pending_.push_back(boxes.x1[i], boxes.y1[i], boxes.x2[i], boxes.y2[i],
+                       boxes.scores[i], boxes.labels[i]);
+    if (pending_.size() == rows_per_block_) writeBlock();
+  }
+}
+
+/**
+ * @brief Write buffered rows as a (possibly short) block and index it.
+ */
+void ResultsStoreWriter::flush() {
+  if (!open_) return;
+  if (!pending_.empty()) writeBlock();
+  writeFooter();
+  out_.flush();
+  if (!out_) throw std::runtime_error("ResultsStoreWriter: write failed");
+}
+
+/**
+ * @brief Encode the buffered rows as one block and record its zone map.
+ */
+void ResultsStoreWriter::writeBlock() {
+  const size_t n = pending_.size();
+  ResultsBlockInfo info;
+  info.offset = offset_;
+  info.rows = uint32_t(n);
+  info.frame_min = *std::min_element(frames_.begin(), frames_.end());
+  info.frame_max = *std::max_element(frames_.begin(), frames_.end());
+  const auto [smin, smax] =
+      std::minmax_element(pending_.scores.begin(), pending_.scores.end());
+  info.score_min = *smin;
+  info.score_max = *smax;
+  info.x_min = *std::min_element(pending_.x1.begin(), pending_.x1.end());
+  info.y_min = *std::min_element(pending_.y1.begin(), pending_.y1.end());
+  info.x_max = *std::max_element(pending_.x2.begin(), pending_.x2.end());
+  info.y_max = *std::max_element(pending_.y2.begin(), pending_.y2.end());
+
+  std::vector<uint16_t> codes(n);
+  for (size_t i = 0; i < n; ++i) {
+    codes[i] = classCode(pending_.labels[i]);
+    info.class_mask |= uint64_t(1) << (codes[i] % 64);
+  }
+  std::vector<uint8_t> frame_col;
+  int64_t prev = info.frame_min;
+  for (const int64_t f : frames_) {
+    put_varint(frame_col, f - prev);
+    prev = f;
+  }
+  info.frame_bytes = uint32_t(frame_col.size());
+
+  for (const auto* col : {&pending_.scores, &pending_.x1, &pending_.y1,
+                          &pending_.x2, &pending_.y2})
+    out_.write(reinterpret_cast<const char*>(col->data()),
+               std::streamsize(n * sizeof(float)));
+  out_.write(reinterpret_cast<const char*>(codes.data()),
+             std::streamsize(n * sizeof(uint16_t)));
+  frame_col.resize(block_bytes(info.rows, info.frame_bytes) -
+                   n * (5 * sizeof(float) + sizeof(uint16_t)));
+  out_.write(reinterpret_cast<const char*>(frame_col.data()),
+             std::streamsize(frame_col.size()));
+
+  offset_ += block_bytes(info.rows, info.frame_bytes);
+  blocks_.push_back(info);
+  pending_.clear();
+  frames_.clear();
+}
+
+/**
+ * @brief Append a footer for the blocks and classes added since the last
+ * one, followed by its trailer.
+ */
+void ResultsStoreWriter::writeFooter() {
+  if (last_trailer_ != 0 && indexed_blocks_ == blocks_.size() &&
+      indexed_classes_ == classes_.size())
+    return;
+  std::vector<uint8_t> bytes;
+  const auto put = [&](const auto& v) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&v);
+    bytes.insert(bytes.end(), p, p + sizeof(v));
+  };
+  put(last_trailer_);
+  put(uint64_t(blocks_.size() - indexed_blocks_));
+  for (size_t i = indexed_blocks_; i < blocks_.size(); ++i) put(blocks_[i]);
+  put(uint32_t(classes_.size() - indexed_classes_));
+  for (size_t i = indexed_classes_; i < classes_.size(); ++i) {
+    put(classes_[i].label);
+    put(uint32_t(classes_[i].name.size()));
+    bytes.insert(bytes.end(), classes_[i].name.begin(),
+                 classes_[i].name.end());
+  }
+  bytes.resize(pad8(bytes.size()));
+  put(offset_);
+  bytes.insert(bytes.end(), kMagic, kMagic + 8);
+  out_.write(reinterpret_cast<const char*>(bytes.data()),
+             std::streamsize(bytes.size()));
+
+  offset_ += bytes.size();
+  last_trailer_ = offset_ - kTrailerBytes;
+  indexed_blocks_ = blocks_.size();
+  indexed_classes_ = classes_.size();
+}
+
+/**
+ * @brief Flush and close the file.
+ */
+void ResultsStoreWriter::close() {
+  if (!open_) return;
+  flush();
+  open_ = false;
+  out_.close();
+  if (!out_) throw std::runtime_error("ResultsStoreWriter: write failed");
+}
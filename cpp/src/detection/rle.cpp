@@ -0,0 +1,76 @@
+#include "detection/rle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Start building a mask of the given size.
+ */
+RleBuilder::RleBuilder(size_t height, size_t width) {
+  rle_.height = height;
+  rle_.width = width;
+}
+
+/**
+ * @brief Append @p length pixels of the given value.
+ */
+void RleBuilder::append(bool value, size_t length) {
+  if (length == 0) return;
+  if (value != value_) {
+    rle_.counts.push_back(static_cast<uint32_t>(run_));
+    value_ = value;
+    run_ = 0;
+  }
+  run_ += length;
+  total_ += length;
+}
+
+/**
+ * @brief Finish the mask, padding any remaining pixels with 0s.
+ */
+Rle RleBuilder::finish() {
+  const size_t pixels = rle_.height * rle_.width;
+  if (total_ > pixels)
+    throw std::length_error("RleBuilder: more pixels than mask size");
+  append(false, pixels - total_);
+  if (run_ > 0 || rle_.counts.empty())
+    rle_.counts.push_back(static_cast<uint32_t>(run_));
+  return std::move(rle_);
+}
+
+/**
+ * @brief Encode a binary mask.
+ */
+Rle rle_encode(const uint8_t* mask, size_t height, size_t width) {
+  RleBuilder builder(height, width);
+  for (size_t x = 0; x < width; ++x)
+    for (size_t y = 0; y < height; ++y)
+      builder.append(mask[y * width + x] != 0, 1);
+  return builder.finish();
+}
+
+/**
+ * @brief Decode a mask into a row-major byte image.
+ */
+void rle_decode(const Rle& rle, uint8_t* mask) {
+  std::memset(mask, 0, rle.height * rle.width);
+  size_t p = 0;
+  for (size_t i = 0; i < rle.counts.size(); ++i) {
+    const size_t run = rle.counts[i];
+    if (i % 2 == 1) {
+      for (size_t k = p; k < p + run; ++k)
+        mask[(k % rle.height) * rle.width + k / rle.height] = 1;
+    }
+    p += run;
+  }
+}
+
+/**
+ * @brief Count the set pixels of an encoded mask.
+ */
+size_t rle_area(const Rle& rle) {
+  size_t area = 0;
+  for (size_t i = 1; i < rle.counts.size(); i += 2) area += rle.counts[i];
+  return area;
+}
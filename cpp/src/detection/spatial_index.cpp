@@ -0,0 +1,393 @@
+#include "detection/spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+/**
+ * @brief Map 16-bit grid coordinates to their position on a Hilbert curve.
+ *
+ * Branch-free implementation after "Fast Hilbert curve generation" by
+ * rawrunprotected, as used by flatbush.
+ *
+ * @param x Column in [0, 65535].
+ * @param y Row in [0, 65535].
+ * @return Distance along the curve.
+ */
+static uint32_t hilbert(uint32_t x, uint32_t y) {
+  uint32_t a = x ^ y;
+  uint32_t b = 0xFFFF ^ a;
+  uint32_t c = 0xFFFF ^ (x | y);
+  uint32_t d = x & (y ^ 0xFFFF);
+
+  uint32_t A = a | (b >> 1);
+  uint32_t B = (a >> 1) ^ a;
+  uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+  uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = (a & (a >> 2)) ^ (b & (b >> 2));
+  B = (a & (b >> 2)) ^ (b & ((a ^ b) >> 2));
+  C ^= (a & (c >> 2)) ^ (b & (d >> 2));
+  D ^= (b & (c >> 2)) ^ ((a ^ b) & (d >> 2));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = (a & (a >> 4)) ^ (b & (b >> 4));
+  B = (a & (b >> 4)) ^ (b & ((a ^ b) >> 4));
+  C ^= (a & (c >> 4)) ^ (b & (d >> 4));
+  D ^= (b & (c >> 4)) ^ ((a ^ b) & (d >> 4));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= (a & (c >> 8)) ^ (b & (d >> 8));
+  D ^= (b & (c >> 8)) ^ ((a ^ b) & (d >> 8));
+
+  a = C ^ (C >> 1);
+  b = D ^ (D >> 1);
+
+  uint32_t i0 = x ^ y;
+  uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+  i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+  i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+  i0 = (i0 | (i0 << 2)) & 0x33333333;
+  i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+  i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+  i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+  i1 = (i1 | (i1 << 2)) & 0x33333333;
+  i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+  return (i1 << 1) | i0;
+}
+
+/**
+ * @brief Squared distance from a point to the nearest point of a box.
+ */
+static float box_distance_sq(float x, float y, float x1, float y1, float x2,
+                             float y2) {
+  const float dx = x < x1 ? x1 - x : (x > x2 ? x - x2 : 0.f);
+  const float dy = y < y1 ? y1 - y : (y > y2 ? y - y2 : 0.f);
+  return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Check whether a box intersects a window (edges inclusive).
+ */
+static bool intersects(const SpatialWindow& w, float x1, float y1, float x2,
+                       float y2) {
+  return x1 <= w.x2 && y1 <= w.y2 && x2 >= w.x1 && y2 >= w.y1;
+}
+
+/**
+ * @brief Candidate entry of a best-first nearest neighbour search.
+ */
+struct NearestEntry {
+  float distance_sq; /**< Squared distance to the query point */
+  uint32_t ref;      /**< Node position or item index */
+  bool is_item;      /**< Whether @ref ref is an item index */
+
+  bool operator>(const NearestEntry& other) const {
+    return distance_sq > other.distance_sq;
+  }
+};
+
+using NearestQueue =
+    std::priority_queue<NearestEntry, std::vector<NearestEntry>,
+                        std::greater<NearestEntry>>;
+
+/**
+ * @brief Build the tree over all boxes of @p boxes.
+ */
+PackedRTree::PackedRTree(const BoxSet& boxes, size_t node_size)
+    : node_size_(std::max<size_t>(node_size, 2)), num_items_(boxes.size()) {
+  if (num_items_ == 0) return;
+
+  // Count nodes per level; leaves (the items themselves) form level 0.
+  size_t count = num_items_, total = num_items_;
+  level_ends_.push_back(total);
+  do {
+    count = (count + node_size_ - 1) / node_size_;
+    total += count;
+    level_ends_.push_back(total);
+  } while (count != 1);
+  bounds_.resize(total * 4);
+  refs_.resize(total);
+
+  // Sort items along the Hilbert curve of their centres.
+  float min_x = boxes.x1[0], min_y = boxes.y1[0];
+  float max_x = boxes.x2[0], max_y = boxes.y2[0];
+  for (size_t i = 1; i < num_items_; ++i) {
+    min_x = std::min(min_x, boxes.x1[i]);
+    min_y = std::min(min_y, boxes.y1[i]);
+    max_x = std::max(max_x, boxes.x2[i]);
+    max_y = std::max(max_y, boxes.y2[i]);
+  }
+  const float w = max_x - min_x, h = max_y - min_y;
+  const float sx = w > 0.f ? 65535.f / w : 0.f;
+  const float sy = h > 0.f ? 65535.f / h : 0.f;
+  std::vector<uint32_t> keys(num_items_), order(num_items_);
+  for (size_t i = 0; i < num_items_; ++i) {
+    const float cx = (boxes.x1[i] + boxes.x2[i]) * .5f - min_x;
+    const float cy = (boxes.y1[i] + boxes.y2[i]) * .5f - min_y;
+    keys[i] = hilbert(static_cast<uint32_t>(cx * sx),
+                      static_cast<uint32_t>(cy * sy));
+  }
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+  for (size_t pos = 0; pos < num_items_; ++pos) {
+    const uint32_t i = order[pos];
+    bounds_[pos * 4 + 0] = boxes.x1[i];
+    bounds_[pos * 4 + 1] = boxes.y1[i];
+    bounds_[pos * 4 + 2] = boxes.x2[i];
+    bounds_[pos * 4 + 3] = boxes.y2[i];
+    refs_[pos] = i;
+  }
+
+  // Pack each level into parents bottom-up.
+  size_t child = 0, parent = num_items_;
+  for (size_t level = 0; level + 1 < level_ends_.size(); ++level) {
+    const size_t end = level_ends_[level];
+    while (child < end) {
+      float nx1 = bounds_[child * 4 + 0], ny1 = bounds_[child * 4 + 1];
+      float nx2 = bounds_[child * 4 + 2], ny2 = bounds_[child * 4 + 3];
+      refs_[parent] = static_cast<uint32_t>(child);
+      const size_t last = std::min(child + node_size_, end);
+      for (size_t c = child + 1; c < last; ++c) {
+        nx1 = std::min(nx1, bounds_[c * 4 + 0]);
+        ny1 = std::min(ny1, bounds_[c * 4 + 1]);
+        nx2 = std::max(nx2, bounds_[c * 4 + 2]);
+        ny2 = std::max(ny2, bounds_[c * 4 + 3]);
+      }
+      bounds_[parent * 4 + 0] = nx1;
+      bounds_[parent * 4 + 1] = ny1;
+      bounds_[parent * 4 + 2] = nx2;
+      bounds_[parent * 4 + 3] = ny2;
+      child = last;
+      ++parent;
+    }
+  }
+}
+
+/**
+ * @brief Find all boxes intersecting a window.
+ */
+void PackedRTree::search(const SpatialWindow& window,
+                         std::vector<uint32_t>& results,
+                         const SpatialFilter& filter) const {
+  if (num_items_ == 0) return;
+  std::vector<size_t> stack{refs_.size() - 1};
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+    // Children of a node occupy [first, end) within the level below.
+    const size_t first = refs_[node];
+    const size_t level_end =
+        *std::upper_bound(level_ends_.begin(), level_ends_.end(), first);
+    const size_t end = std::min(first + node_size_, level_end);
+    for (size_t pos = first; pos < end; ++pos) {
+      const float* b = &bounds_[pos * 4];
+      if (!intersects(window, b[0], b[1], b[2], b[3])) continue;
+      if (pos < num_items_) {
+        if (!filter || filter(refs_[pos])) results.push_back(refs_[pos]);
+      } else {
+        stack.push_back(pos);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Find the boxes closest to a point.
+ */
+std::vector<uint32_t> PackedRTree::nearest(float x, float y, size_t k,
+                                           float max_distance,
+                                           const SpatialFilter& filter) const {
+  std::vector<uint32_t> results;
+  if (num_items_ == 0 || k == 0) return results;
+  const float max_sq = max_distance * max_distance;
+  NearestQueue queue;
+  queue.push({0.f, static_cast<uint32_t>(refs_.size() - 1), false});
+  while (!queue.empty()) {
+    const NearestEntry top = queue.top();
+    queue.pop();
+    if (top.distance_sq > max_sq) break;
+    if (top.is_item) {
+      results.push_back(top.ref);
+      if (results.size() == k) break;
+      continue;
+    }
+    const size_t first = refs_[top.ref];
+    const size_t level_end =
+        *std::upper_bound(level_ends_.begin(), level_ends_.end(), first);
+    const size_t end = std::min(first + node_size_, level_end);
+    for (size_t pos = first; pos < end; ++pos) {
+      const float* b = &bounds_[pos * 4];
+      const float d = box_distance_sq(x, y, b[0], b[1], b[2], b[3]);
+      if (d > max_sq) continue;
+      if (pos < num_items_) {
+        if (!filter || filter(refs_[pos])) queue.push({d, refs_[pos], true});
+      } else {
+        queue.push({d, static_cast<uint32_t>(pos), false});
+      }
+    }
+  }
+  return results;
+}
+
+/**
+ * @brief Build the grid over all boxes of @p boxes.
+ */
+UniformGrid::UniformGrid(const BoxSet& boxes, float cell_size)
+    : boxes_(boxes), cell_size_(cell_size) {
+  if (!(cell_size > 0.f))
+    throw std::invalid_argument("UniformGrid: cell size must be positive");
+  const size_t n = boxes_.size();
+  if (n == 0) return;
+
+  float max_x = boxes_.x2[0], max_y = boxes_.y2[0];
+  origin_x_ = boxes_.x1[0];
+  origin_y_ = boxes_.y1[0];
+  for (size_t i = 1; i < n; ++i) {
+    origin_x_ = std::min(origin_x_, boxes_.x1[i]);
+    origin_y_ = std::min(origin_y_, boxes_.y1[i]);
+    max_x = std::max(max_x, boxes_.x2[i]);
+    max_y = std::max(max_y, boxes_.y2[i]);
+  }
+  cols_ = static_cast<size_t>((max_x - origin_x_) / cell_size_) + 1;
+  rows_ = static_cast<size_t>((max_y - origin_y_) / cell_size_) + 1;
+
+  // Counting sort of (cell, box) pairs into CSR form.
+  offsets_.assign(cols_ * rows_ + 1, 0);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t cy = cellY(boxes_.y1[i]); cy <= cellY(boxes_.y2[i]); ++cy)
+      for (size_t cx = cellX(boxes_.x1[i]); cx <= cellX(boxes_.x2[i]); ++cx)
+        ++offsets_[cy * cols_ + cx + 1];
+  std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+  items_.resize(offsets_.back());
+  std::vector<uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t cy = cellY(boxes_.y1[i]); cy <= cellY(boxes_.y2[i]); ++cy)
+      for (size_t cx = cellX(boxes_.x1[i]); cx <= cellX(boxes_.x2[i]); ++cx)
+        items_[fill[cy * cols_ + cx]++] = static_cast<uint32_t>(i);
+}
+
+/**
+ * @brief Column of the cell containing @p x, clamped to the grid.
+ */
+size_t UniformGrid::cellX(float x) const {
+  const float c = std::floor((x - origin_x_) / cell_size_);
+  return static_cast<size_t>(std::clamp(c, 0.f, float(cols_ - 1)));
+}
+
+/**
+ * @brief Row of the cell containing @p y, clamped to the grid.
+ */
+size_t UniformGrid::cellY(float y) const {
+  const float r = std::floor((y - origin_y_) / cell_size_);
+  return static_cast<size_t>(std::clamp(r, 0.f, float(rows_ - 1)));
+}
+
+/**
+ * @brief Find all boxes intersecting a window.
+ */
+void UniformGrid::search(const SpatialWindow& window,
+                         std::vector<uint32_t>& results,
+                         const SpatialFilter& filter) const {
+  if (items_.empty()) return;
+  const size_t cx0 = cellX(window.x1), cx1 = cellX(window.x2);
+  const size_t cy0 = cellY(window.y1), cy1 = cellY(window.y2);
+  for (size_t cy = cy0; cy <= cy1; ++cy) {
+    for (size_t cx = cx0; cx <= cx1; ++cx) {
+      const size_t cell = cy * cols_ + cx;
+      for (uint32_t k = offsets_[cell]; k < offsets_[cell + 1]; ++k) {
+        const uint32_t i = items_[k];
+        if (!intersects(window, boxes_.x1[i], boxes_.y1[i], boxes_.x2[i],
+                        boxes_.y2[i]))
+          continue;
+        // Report a box only from the cell holding the top-left corner of its
+        // intersection with the window, so multi-cell boxes appear once.
+        if (cellX(std::max(window.x1, boxes_.x1[i])) != cx ||
+            cellY(std::max(window.y1, boxes_.y1[i])) != cy)
+          continue;
+        if (!filter || filter(i)) results.push_back(i);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Find the boxes closest to a point.
+ */
+std::vector<uint32_t> UniformGrid::nearest(float x, float y, size_t k,
+                                           float max_distance,
+                                           const SpatialFilter& filter) const {
+  std::vector<uint32_t> results;
+  if (items_.empty() || k == 0) return results;
+  const float max_sq = max_distance * max_distance;
+  const auto qx = static_cast<long long>(cellX(x));
+  const auto qy = static_cast<long long>(cellY(y));
+  const auto cols = static_cast<long long>(cols_);
+  const auto rows = static_cast<long long>(rows_);
+
+  // Max-heap of the best k candidates found so far.
+  std::priority_queue<std::pair<float, uint32_t>> best;
+  for (long long ring = 0;; ++ring) {
+    for (long long cy = qy - ring; cy <= qy + ring; ++cy) {
+      if (cy < 0 || cy >= rows) continue;
+      const bool edge_row = cy == qy - ring || cy == qy + ring;
+      for (long long cx = qx - ring; cx <= qx + ring;
+           cx += edge_row ? 1 : 2 * std::max(ring, 1LL)) {
+        if (cx < 0 || cx >= cols) continue;
+        const size_t cell = static_cast<size_t>(cy * cols + cx);
+        for (uint32_t j = offsets_[cell]; j < offsets_[cell + 1]; ++j) {
+          const uint32_t i = items_[j];
+          // Report a box only from the cell holding its closest point.
+          const float px = std::clamp(x, boxes_.x1[i], boxes_.x2[i]);
+          const float py = std::clamp(y, boxes_.y1[i], boxes_.y2[i]);
+          if (static_cast<long long>(cellX(px)) != cx ||
+              static_cast<long long>(cellY(py)) != cy)
+            continue;
+          const float d = box_distance_sq(x, y, boxes_.x1[i], boxes_.y1[i],
+                                          boxes_.x2[i], boxes_.y2[i]);
+          if (d > max_sq || (best.size() == k && d >= best.top().first))
+            continue;
+          if (filter && !filter(i)) continue;
+          best.emplace(d, i);
+          if (best.size() > k) best.pop();
+        }
+      }
+    }
+    // Cells beyond this ring are at least the distance from the query point
+    // to the edge of the rings visited so far.
+    const bool covers_grid = qx - ring <= 0 && qy - ring <= 0 &&
+                             qx + ring >= cols - 1 && qy + ring >= rows - 1;
+    if (covers_grid) break;
+    const float left = origin_x_ + float(qx - ring) * cell_size_;
+    const float top = origin_y_ + float(qy - ring) * cell_size_;
+    const float right = origin_x_ + float(qx + ring + 1) * cell_size_;
+    const float bottom = origin_y_ + float(qy + ring + 1) * cell_size_;
+    const float margin =
+        std::max(0.f, std::min({x - left, right - x, y - top, bottom - y}));
+    if (margin * margin > max_sq) break;
+    if (best.size() == k && best.top().first <= margin * margin) break;
+  }
+
+  results.resize(best.size());
+  for (size_t i = results.size(); i-- > 0;) {
+    results[i] = best.top().second;
+    best.pop();
+  }
+  return results;
+}
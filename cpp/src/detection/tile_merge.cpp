@@ -0,0 +1,69 @@
+#include "detection/tile_merge.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "detection/spatial_index.h"
+
+/**
+ * @brief Intersection over union of boxes @p a and @p b of a BoxSet.
+ */
+static float box_iou(const BoxSet& boxes, size_t a, size_t b) {
+  const float w = std::min(boxes.x2[a], boxes.x2[b]) -
+                  std::max(boxes.x1[a], boxes.x1[b]);
+  const float h = std::min(boxes.y2[a], boxes.y2[b]) -
+                  std::max(boxes.y1[a], boxes.y1[b]);
+  if (w <= 0.f || h <= 0.f) return 0.f;
+  const float inter = w * h;
+  return inter / (boxes.area(a) + boxes.area(b) - inter);
+}
+
+/**
+ * @brief Merge per-tile detections of a large scene into one BoxSet.
+ */
+BoxSet merge_tile_detections(const std::vector<BoxSet>& tiles,
+                             const std::vector<TileOffset>& offsets,
+                             const TileMergeParams& params) {
+  if (tiles.size() != offsets.size())
+    throw std::invalid_argument("merge_tile_detections: one offset per tile");
+
+  BoxSet all;
+  size_t total = 0;
+  for (const BoxSet& t : tiles) total += t.size();
+  all.reserve(total);
+  for (size_t t = 0; t < tiles.size(); ++t) {
+    const BoxSet& tile = tiles[t];
+    const TileOffset& o = offsets[t];
+    for (size_t i = 0; i < tile.size(); ++i)
+      all.push_back(tile.x1[i] + o.x, tile.y1[i] + o.y, tile.x2[i] + o.x,
+                    tile.y2[i] + o.y, tile.scores[i], tile.labels[i]);
+  }
+
+  std::vector<uint32_t> order(all.size()), rank(all.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return all.scores[a] > all.scores[b];
+  });
+  for (size_t r = 0; r < order.size(); ++r) rank[order[r]] = uint32_t(r);
+
+  const PackedRTree index(all);
+  std::vector<bool> suppressed(all.size(), false);
+  std::vector<uint32_t> candidates;
+  BoxSet merged;
+  for (const uint32_t i : order) {
+    if (suppressed[i]) continue;
+    merged.push_back(all.x1[i], all.y1[i], all.x2[i], all.y2[i],
+                     all.scores[i], all.labels[i]);
+    candidates.clear();
+    index.search({all.x1[i], all.y1[i], all.x2[i], all.y2[i]}, candidates,
+                 [&](uint32_t j) {
+                   return rank[j] > rank[i] && !suppressed[j] &&
+                          (!params.class_aware ||
+                           all.labels[j] == all.labels[i]);
+                 });
+    for (const uint32_t j : candidates)
+      if (box_iou(all, i, j) > params.iou_threshold) suppressed[j] = true;
+  }
+  return merged;
+}
@@ -0,0 +1,725 @@
+#include "ops/conv.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "ops/winograd.h"
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+#include "utils/scratch.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Get a per-thread 64-byte aligned scratch buffer of @p n floats.
+ *
+ * The buffer only grows, so steady-state convolutions do not allocate. It is
+ * kept per ScratchScope depth.
+ */
+static float* scratch(size_t n) {
+  thread_local ScratchBuffers<float> buffers;
+  return buffers.get(0, n);
+}
+
+/**
+ * @brief Apply the residual add and clamp of an epilogue to @p count outputs.
+ *
+ * @p residual points at the addends matching @p y, or is null.
+ */
+static void finish_outputs(float* y, const float* residual, size_t count,
+                           const ConvEpilogue& epilogue) {
+  if (residual)
+    for (size_t i = 0; i < count; ++i) y[i] += residual[i];
+  const float lo = epilogue.clamp_min, hi = epilogue.clamp_max;
+  if (lo > -std::numeric_limits<float>::infinity() ||
+      hi < std::numeric_limits<float>::infinity())
+    for (size_t i = 0; i < count; ++i) y[i] = std::min(std::max(y[i], lo), hi);
+}
+
+/**
+ * @brief Get the channel block size of the NCHWc layout on this CPU.
+ */
+size_t nchwc_block() {
+#if defined(VF_X86)
+  if (cpu_features().avx512f) return 16;
+#endif
+  return 8;
+}
+
+/**
+ * @brief Compute the output extent of a convolution along one axis.
+ */
+size_t conv_output_size(size_t input, size_t kernel, size_t stride,
+                        size_t pad_begin, size_t pad_end, size_t dilation) {
+  const size_t padded = input + pad_begin + pad_end;
+  const size_t extent = (kernel - 1) * dilation + 1;
+  if (kernel == 0 || stride == 0 || padded < extent) return 0;
+  return (padded - extent) / stride + 1;
+}
+
+/**
+ * @brief Convert an NCHW tensor to the blocked NCHWc layout.
+ */
+void nchw_to_nchwc(const Tensor<float>& src, Tensor<float>& dst) {
+  if (src.rank() != 4 || dst.rank() != 5 || dst.dim(4) == 0)
+    throw std::invalid_argument("nchw_to_nchwc: expected NCHW and NCHWc");
+  const size_t n = src.dim(0), c = src.dim(1), hw = src.dim(2) * src.dim(3);
+  const size_t cb = dst.dim(4), blocks = (c + cb - 1) / cb;
+  if (dst.shape() != Shape{n, blocks, src.dim(2), src.dim(3), cb})
+    throw std::invalid_argument("nchw_to_nchwc: shape mismatch");
+  const float* in = src.data();
+  float* out = dst.data();
+  parallel_for(0, n * blocks, 1, [&](size_t first, size_t last) {
+    for (size_t nb = first; nb < last; ++nb) {
+      const size_t b = nb % blocks, c0 = b * cb, cn = std::min(cb, c - c0);
+      const float* plane = in + (nb / blocks * c + c0) * hw;
+      float* block = out + nb * hw * cb;
+      for (size_t i = 0; i < hw; ++i, block += cb) {
+        for (size_t k = 0; k < cn; ++k) block[k] = plane[k * hw + i];
+        std::fill(block + cn, block + cb, 0.f);
+      }
+    }
+  });
+}
+
+/**
+ * @brief Convert an NCHWc tensor back to the plain NCHW layout.
+ */
+void nchwc_to_nchw(const Tensor<float>& src, Tensor<float>& dst) {
+  if (src.rank() != 5 || dst.rank() != 4 || src.dim(4) == 0)
+    throw std::invalid_argument("nchwc_to_nchw: expected NCHWc and NCHW");
+  const size_t n = dst.dim(0), c = dst.dim(1), hw = dst.dim(2) * dst.dim(3);
+  const size_t cb = src.dim(4), blocks = (c + cb - 1) / cb;
+  if (src.shape() != Shape{n, blocks, dst.dim(2), dst.dim(3), cb})
+    throw std::invalid_argument("nchwc_to_nchw: shape mismatch");
+  const float* in = src.data();
+  float* out = dst.data();
+  parallel_for(0, n * blocks, 1, [&](size_t first, size_t last) {
+    for (size_t nb = first; nb < last; ++nb) {
+      const size_t b = nb % blocks, c0 = b * cb, cn = std::min(cb, c - c0);
+      const float* block = in + nb * hw * cb;
+      float* plane = out + (nb / blocks * c + c0) * hw;
+      for (size_t i = 0; i < hw; ++i, block += cb)
+        for (size_t k = 0; k < cn; ++k) plane[k * hw + i] = block[k];
+    }
+  });
+}
+
+/**
+ * @brief Convert an NCHW tensor to the blocked NCHWc layout.
+ */
+Tensor<float> to_nchwc(const Tensor<float>& src, size_t block) {
+  if (src.rank() != 4 || block == 0)
+    throw std::invalid_argument("to_nchwc: expected NCHW and a block size");
+  Tensor<float> dst(Shape{src.dim(0), (src.dim(1) + block - 1) / block,
+                          src.dim(2), src.dim(3), block});
+  nchw_to_nchwc(src, dst);
+  return dst;
+}
+
+/**
+ * @brief Convert an NCHWc tensor back to the plain NCHW layout.
+ */
+Tensor<float> to_nchw(const Tensor<float>& src, size_t channels) {
+  if (src.rank() != 5)
+    throw std::invalid_argument("to_nchw: expected an NCHWc tensor");
+  Tensor<float> dst(Shape{src.dim(0), channels, src.dim(2), src.dim(3)});
+  nchwc_to_nchw(src, dst);
+  return dst;
+}
+
+/**
+ * @brief Arguments shared by the direct and depthwise NCHWc kernels for one
+ * output row.
+ */
+struct DirectArgs {
+  const float* in;   /**< Input image, [C_in blocks, H, W, cb] */
+  const float* w;    /**< Weights of the output channel block */
+  const float* bias; /**< Bias of the output channel block (or null) */
+  float* out;        /**< Output row, [OW, cb] */
+  size_t in_blocks;  /**< Input channel blocks (direct kernels only) */
+  size_t h, w_in;    /**< Input height and width */
+  size_t kh, kw;     /**< Kernel extent */
+  size_t sh, sw;     /**< Stride */
+  size_t dh, dw;     /**< Dilation */
+  ptrdiff_t ih0;     /**< Input row of kernel row 0 (may be negative) */
+  ptrdiff_t pl;      /**< Left padding */
+};
+
+/**
+ * @brief Output pixels per wide direct convolution tile.
+ *
+ * Twelve accumulators plus a weight vector fit the 16 ymm registers of AVX2
+ * and leave the FMA pipelines enough independent chains on AVX-512.
+ */
+static constexpr size_t kWideTile = 12;
+
+/** Kernel computing output pixels starting at column @p ow of a row. */
+using RowTileFn = void (*)(const DirectArgs& a, size_t ow);
+
+/**
+ * @brief Tile kernels of a direct convolution for one ISA and block size.
+ *
+ * The wide tiles require every input column they read to lie inside the
+ * image; `border` computes one pixel and checks each tap.
+ */
+struct DirectKernels {
+  RowTileFn wide;   /**< kWideTile interior pixels */
+  RowTileFn tile4;  /**< Four interior pixels */
+  RowTileFn tile1;  /**< One interior pixel */
+  RowTileFn border; /**< One pixel with bounds checks */
+};
+
+/**
+ * @brief Portable direct convolution tile of @p T pixels.
+ */
+template <size_t CB, size_t T, bool kChecked>
+static void direct_tile_scalar(const DirectArgs& a, size_t ow0) {
+  float acc[T][CB];
+  for (size_t t = 0; t < T; ++t)
+    for (size_t c = 0; c < CB; ++c) acc[t][c] = a.bias ? a.bias[c] : 0.f;
+  const ptrdiff_t iw0 = ptrdiff_t(ow0 * a.sw) - a.pl;
+  for (size_t icb = 0; icb < a.in_blocks; ++icb) {
+    const float* in_c = a.in + icb * a.h * a.w_in * CB;
+    const float* w_c = a.w + icb * a.kh * a.kw * CB * CB;
+    for (size_t y = 0; y < a.kh; ++y) {
+      const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+      if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+      for (size_t x = 0; x < a.kw; ++x) {
+        const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+        if (kChecked && (iw < 0 || iw >= ptrdiff_t(a.w_in))) continue;
+        const float* px = in_c + (size_t(ih) * a.w_in + size_t(iw)) * CB;
+        const float* wk = w_c + (y * a.kw + x) * CB * CB;
+        for (size_t ci = 0; ci < CB; ++ci)
+          for (size_t t = 0; t < T; ++t) {
+            const float v = px[t * a.sw * CB + ci];
+            for (size_t c = 0; c < CB; ++c) acc[t][c] += v * wk[ci * CB + c];
+          }
+      }
+    }
+  }
+  for (size_t t = 0; t < T; ++t)
+    std::copy(acc[t], acc[t] + CB, a.out + (ow0 + t) * CB);
+}
+
+/**
+ * @brief Portable depthwise convolution of one output pixel.
+ */
+template <size_t CB>
+static void depthwise_pixel_scalar(const DirectArgs& a, size_t ow) {
+  float acc[CB];
+  for (size_t c = 0; c < CB; ++c) acc[c] = a.bias ? a.bias[c] : 0.f;
+  const ptrdiff_t iw0 = ptrdiff_t(ow * a.sw) - a.pl;
+  for (size_t y = 0; y < a.kh; ++y) {
+    const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+    if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+    for (size_t x = 0; x < a.kw; ++x) {
+      const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+      if (iw < 0 || iw >= ptrdiff_t(a.w_in)) continue;
+      const float* px = a.in + (size_t(ih) * a.w_in + size_t(iw)) * CB;
+      const float* wk = a.w + (y * a.kw + x) * CB;
+      for (size_t c = 0; c < CB; ++c) acc[c] += px[c] * wk[c];
+    }
+  }
+  std::copy(acc, acc + CB, a.out + ow * CB);
+}
+
+#if defined(VF_X86)
+/**
+ * @brief AVX2/FMA direct convolution tile of @p T pixels (8-channel blocks).
+ *
+ * Each pixel keeps its eight output channels in one accumulator; every input
+ * channel contributes a broadcast input value times a weight vector.
+ */
+template <size_t T, bool kChecked>
+VF_TARGET("avx2,fma")
+static void direct_tile_avx2(const DirectArgs& a, size_t ow0) {
+  constexpr size_t CB = 8;
+  __m256 acc[T];
+  const __m256 bias = a.bias ? _mm256_loadu_ps(a.bias) : _mm256_setzero_ps();
+  VF_UNROLL for (size_t t = 0; t < T; ++t) acc[t] = bias;
+  const ptrdiff_t iw0 = ptrdiff_t(ow0 * a.sw) - a.pl;
+  const size_t step = a.sw * CB;
+  for (size_t icb = 0; icb < a.in_blocks; ++icb) {
+    const float* in_c = a.in + icb * a.h * a.w_in * CB;
+    const float* w_c = a.w + icb * a.kh * a.kw * CB * CB;
+    for (size_t y = 0; y < a.kh; ++y) {
+      const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+      if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+      for (size_t x = 0; x < a.kw; ++x) {
+        const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+        if (kChecked && (iw < 0 || iw >= ptrdiff_t(a.w_in))) continue;
+        const float* px = in_c + (size_t(ih) * a.w_in + size_t(iw)) * CB;
+        const float* wk = w_c + (y * a.kw + x) * CB * CB;
+        VF_UNROLL for (size_t ci = 0; ci < CB; ++ci) {
+          const __m256 wv = _mm256_load_ps(wk + ci * CB);
+          VF_UNROLL for (size_t t = 0; t < T; ++t) {
+            acc[t] = _mm256_fmadd_ps(_mm256_broadcast_ss(px + t * step + ci),
+                                     wv, acc[t]);
+          }
+        }
+      }
+    }
+  }
+  VF_UNROLL for (size_t t = 0; t < T; ++t) {
+    _mm256_storeu_ps(a.out + (ow0 + t) * CB, acc[t]);
+  }
+}
+
+/**
+ * @brief AVX-512 direct convolution tile of @p T pixels (16-channel blocks).
+ */
+template <size_t T, bool kChecked>
+VF_TARGET("avx512f")
+static void direct_tile_avx512(const DirectArgs& a, size_t ow0) {
+  constexpr size_t CB = 16;
+  __m512 acc[T];
+  const __m512 bias = a.bias ? _mm512_loadu_ps(a.bias) : _mm512_setzero_ps();
+  VF_UNROLL for (size_t t = 0; t < T; ++t) acc[t] = bias;
+  const ptrdiff_t iw0 = ptrdiff_t(ow0 * a.sw) - a.pl;
+  const size_t step = a.sw * CB;
+  for (size_t icb = 0; icb < a.in_blocks; ++icb) {
+    const float* in_c = a.in + icb * a.h * a.w_in * CB;
+    const float* w_c = a.w + icb * a.kh * a.kw * CB * CB;
+    for (size_t y = 0; y < a.kh; ++y) {
+      const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+      if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+      for (size_t x = 0; x < a.kw; ++x) {
+        const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+        if (kChecked && (iw < 0 || iw >= ptrdiff_t(a.w_in))) continue;
+        const float* px = in_c + (size_t(ih) * a.w_in + size_t(iw)) * CB;
+        const float* wk = w_c + (y * a.kw + x) * CB * CB;
+        VF_UNROLL for (size_t ci = 0; ci < CB; ++ci) {
+          const __m512 wv = _mm512_load_ps(wk + ci * CB);
+          VF_UNROLL for (size_t t = 0; t < T; ++t) {
+            acc[t] =
+                _mm512_fmadd_ps(_mm512_set1_ps(px[t * step + ci]), wv, acc[t]);
+          }
+        }
+      }
+    }
+  }
+  VF_UNROLL for (size_t t = 0; t < T; ++t) {
+    _mm512_storeu_ps(a.out + (ow0 + t) * CB, acc[t]);
+  }
+}
+
+/**
+ * @brief AVX2/FMA depthwise convolution of one output pixel.
+ */
+VF_TARGET("avx2,fma")
+static void depthwise_pixel_avx2(const DirectArgs& a, size_t ow) {
+  __m256 acc = a.bias ? _mm256_loadu_ps(a.bias) : _mm256_setzero_ps();
+  const ptrdiff_t iw0 = ptrdiff_t(ow * a.sw) - a.pl;
+  for (size_t y = 0; y < a.kh; ++y) {
+    const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+    if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+    for (size_t x = 0; x < a.kw; ++x) {
+      const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+      if (iw < 0 || iw >= ptrdiff_t(a.w_in)) continue;
+      const float* px = a.in + (size_t(ih) * a.w_in + size_t(iw)) * 8;
+      acc = _mm256_fmadd_ps(_mm256_loadu_ps(px),
+                            _mm256_load_ps(a.w + (y * a.kw + x) * 8), acc);
+    }
+  }
+  _mm256_storeu_ps(a.out + ow * 8, acc);
+}
+
+/**
+ * @brief AVX-512 depthwise convolution of one output pixel.
+ */
+VF_TARGET("avx512f")
+static void depthwise_pixel_avx512(const DirectArgs& a, size_t ow) {
+  __m512 acc = a.bias ? _mm512_loadu_ps(a.bias) : _mm512_setzero_ps();
+  const ptrdiff_t iw0 = ptrdiff_t(ow * a.sw) - a.pl;
+  for (size_t y = 0; y < a.kh; ++y) {
+    const ptrdiff_t ih = a.ih0 + ptrdiff_t(y * a.dh);
+    if (ih < 0 || ih >= ptrdiff_t(a.h)) continue;
+    for (size_t x = 0; x < a.kw; ++x) {
+      const ptrdiff_t iw = iw0 + ptrdiff_t(x * a.dw);
+      if (iw < 0 || iw >= ptrdiff_t(a.w_in)) continue;
+      const float* px = a.in + (size_t(ih) * a.w_in + size_t(iw)) * 16;
+      acc = _mm512_fmadd_ps(_mm512_loadu_ps(px),
+                            _mm512_load_ps(a.w + (y * a.kw + x) * 16), acc);
+    }
+  }
+  _mm512_storeu_ps(a.out + ow * 16, acc);
+}
+#endif
+
+/**
+ * @brief Select the direct convolution kernels for a channel block size.
+ */
+static DirectKernels select_direct(size_t block) {
+  constexpr size_t W = kWideTile;
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (block == 16 && cpu.avx512f)
+    return {direct_tile_avx512<W, false>, direct_tile_avx512<4, false>,
+            direct_tile_avx512<1, false>, direct_tile_avx512<1, true>};
+  if (block == 8 && cpu.avx2 && cpu.fma)
+    return {direct_tile_avx2<W, false>, direct_tile_avx2<4, false>,
+            direct_tile_avx2<1, false>, direct_tile_avx2<1, true>};
+#endif
+  if (block == 16)
+    return {direct_tile_scalar<16, W, false>, direct_tile_scalar<16, 4, false>,
+            direct_tile_scalar<16, 1, false>, direct_tile_scalar<16, 1, true>};
+  return {direct_tile_scalar<8, W, false>, direct_tile_scalar<8, 4, false>,
+          direct_tile_scalar<8, 1, false>, direct_tile_scalar<8, 1, true>};
+}
+
+/**
+ * @brief Select the depthwise pixel kernel for a channel block size.
+ */
+static RowTileFn select_depthwise(size_t block) {
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (block == 16 && cpu.avx512f) return depthwise_pixel_avx512;
+  if (block == 8 && cpu.avx2 && cpu.fma) return depthwise_pixel_avx2;
+#endif
+  return block == 16 ? depthwise_pixel_scalar<16> : depthwise_pixel_scalar<8>;
+}
+
+/**
+ * @brief Lower one image (or group) to the im2col matrix.
+ *
+ * Row `(c * KH + y) * KW + x` of @p col holds input channel c sampled at
+ * kernel tap (y, x) for every output pixel; padded taps are zero.
+ */
+static void im2col(const float* in, size_t channels, size_t h, size_t w,
+                   size_t kh, size_t kw, size_t oh, size_t ow,
+                   const Conv2dParams& p, float* col) {
+  parallel_for(0, channels * kh * kw, 4, [&](size_t first, size_t last) {
+    for (size_t r = first; r < last; ++r) {
+      const size_t c = r / (kh * kw), y = r / kw % kh, x = r % kw;
+      const float* plane = in + c * h * w;
+      float* dst = col + r * oh * ow;
+      for (size_t oy = 0; oy < oh; ++oy, dst += ow) {
+        const ptrdiff_t iy = ptrdiff_t(oy * p.stride_h + y * p.dilation_h) -
+                             ptrdiff_t(p.pad_top);
+        if (iy < 0 || iy >= ptrdiff_t(h)) {
+          std::fill(dst, dst + ow, 0.f);
+          continue;
+        }
+        const float* row = plane + size_t(iy) * w;
+        const ptrdiff_t ix0 =
+            ptrdiff_t(x * p.dilation_w) - ptrdiff_t(p.pad_left);
+        for (size_t ox = 0; ox < ow; ++ox) {
+          const ptrdiff_t ix = ix0 + ptrdiff_t(ox * p.stride_w);
+          dst[ox] = ix < 0 || ix >= ptrdiff_t(w) ? 0.f : row[ix];
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Prepare a convolution layer.
+ */
+Conv2d::Conv2d(const Tensor<float>& weight, const Tensor<float>& bias,
+               const Conv2dParams& params, ConvLayout layout,
+               ConvAlgorithm algorithm, std::vector<GemmPackedA> prepacked)
+    : params_(params), layout_(layout), algorithm_(algorithm) {
+  if (weight.rank() != 4)
+    throw std::invalid_argument("Conv2d: weight must be [C_out, C_in, KH, KW]");
+  const size_t groups = params.groups;
+  out_channels_ = weight.dim(0);
+  in_channels_ = weight.dim(1) * groups;
+  kernel_h_ = weight.dim(2);
+  kernel_w_ = weight.dim(3);
+  if (groups == 0 || out_channels_ % groups != 0 || in_channels_ == 0)
+    throw std::invalid_argument("Conv2d: C_out must be divisible by groups");
+  if (kernel_h_ == 0 || kernel_w_ == 0 || params.stride_h == 0 ||
+      params.stride_w == 0 || params.dilation_h == 0 || params.dilation_w == 0)
+    throw std::invalid_argument("Conv2d: kernel, stride and dilation > 0");
+  if (!bias.empty() && bias.shape() != Shape{out_channels_})
+    throw std::invalid_argument("Conv2d: bias must be [C_out]");
+
+  const bool depthwise = groups == in_channels_ && groups == out_channels_;
+  const bool pointwise = kernel_h_ == 1 && kernel_w_ == 1 &&
+                         params.stride_h == 1 && params.stride_w == 1 &&
+                         params.pad_top + params.pad_left +
+                                 params.pad_bottom + params.pad_right ==
+                             0;
+  if (algorithm_ == ConvAlgorithm::kAuto) {
+    if (depthwise)
+      algorithm_ = ConvAlgorithm::kDepthwise;
+    else if (layout_ == ConvLayout::kNchwc)
+      algorithm_ = ConvAlgorithm::kDirect;
+    else if (pointwise)
+      algorithm_ = ConvAlgorithm::kGemm;
+    else if (winograd_profitable(params, in_channels_, out_channels_,
+                                 kernel_h_, kernel_w_))
+      algorithm_ = ConvAlgorithm::kWinograd;
+    else
+      algorithm_ = ConvAlgorithm::kIm2col;
+  }
+  const bool nchw = layout_ == ConvLayout::kNchw;
+  switch (algorithm_) {
+    case ConvAlgorithm::kGemm:
+      if (!pointwise || !nchw)
+        throw std::invalid_argument(
+            "Conv2d: kGemm needs an unpadded stride-1 1x1 NCHW convolution");
+      break;
+    case ConvAlgorithm::kIm2col:
+      if (!nchw) throw std::invalid_argument("Conv2d: kIm2col needs NCHW");
+      break;
+    case ConvAlgorithm::kDirect:
+      if (nchw || groups != 1)
+        throw std::invalid_argument(
+            "Conv2d: kDirect needs NCHWc and an ungrouped convolution");
+      break;
+    case ConvAlgorithm::kDepthwise:
+      if (!depthwise)
+        throw std::invalid_argument("Conv2d: kDepthwise needs groups == C");
+      break;
+    case ConvAlgorithm::kWinograd:
+      if (!nchw || !winograd_supported(params, kernel_h_, kernel_w_))
+        throw std::invalid_argument(
+            "Conv2d: kWinograd needs an ungrouped stride-1 3x3 NCHW "
+            "convolution");
+      break;
+    default:
+      throw std::invalid_argument("Conv2d: unsupported algorithm");
+  }
+
+  const size_t taps = kernel_h_ * kernel_w_;
+  const float* w = weight.data();
+  const bool gemm = algorithm_ == ConvAlgorithm::kGemm ||
+                    algorithm_ == ConvAlgorithm::kIm2col;
+  const bool winograd = algorithm_ == ConvAlgorithm::kWinograd;
+  if (!prepacked.empty()) {
+    const size_t count = winograd ? 36 : groups;
+    const size_t m = winograd ? out_channels_ : out_channels_ / groups;
+    const size_t k = winograd ? in_channels_ : weight.dim(1) * taps;
+    bool valid = (gemm || winograd) && prepacked.size() == count;
+    for (const GemmPackedA& a : prepacked)
+      valid = valid && a.m == m && a.k == k && !a.empty();
+    if (!valid)
+      throw std::invalid_argument("Conv2d: prepacked weights do not match");
+    gemm_weights_ = std::move(prepacked);
+  }
+  if (gemm || winograd) {
+    if (!bias.empty()) bias_ = bias.clone();
+    if (!gemm_weights_.empty()) return;
+  }
+  if (gemm) {
+    const size_t og = out_channels_ / groups, k = weight.dim(1) * taps;
+    for (size_t g = 0; g < groups; ++g)
+      gemm_weights_.push_back(
+          sgemm_pack_a(false, og, k, 1.f, w + g * og * k, k));
+    return;
+  }
+  if (winograd) {
+    gemm_weights_ = winograd_transform_weights(weight);
+    return;
+  }
+  if (nchw) {  // Depthwise NCHW uses the filters as given.
+    weights_ = weight.clone();
+    if (!bias.empty()) bias_ = bias.clone();
+    return;
+  }
+
+  block_ = nchwc_block();
+  const size_t cb = block_;
+  const size_t ob = (out_channels_ + cb - 1) / cb;
+  if (!bias.empty()) {
+    bias_ = Tensor<float>(Shape{ob * cb});
+    std::copy(bias.data(), bias.data() + out_channels_, bias_.data());
+  }
+  if (algorithm_ == ConvAlgorithm::kDepthwise) {
+    // [C blocks, KH, KW, cb]
+    weights_ = Tensor<float>(Shape{ob, kernel_h_, kernel_w_, cb});
+    for (size_t c = 0; c < out_channels_; ++c)
+      for (size_t t = 0; t < taps; ++t)
+        weights_[(c / cb * taps + t) * cb + c % cb] = w[c * taps + t];
+    return;
+  }
+  // [C_out blocks, C_in blocks, KH, KW, cb_in, cb_out]
+  const size_t ib = (in_channels_ + cb - 1) / cb;
+  weights_ = Tensor<float>(Shape{ob, ib, kernel_h_, kernel_w_, cb, cb});
+  for (size_t co = 0; co < out_channels_; ++co)
+    for (size_t ci = 0; ci < in_channels_; ++ci)
+      for (size_t t = 0; t < taps; ++t)
+        weights_[(((co / cb * ib + ci / cb) * taps + t) * cb + ci % cb) * cb +
+                 co % cb] = w[(co * in_channels_ + ci) * taps + t];
+}
+
+/**
+ * @brief Compute the output shape for an input shape.
+ */
+Shape Conv2d::outputShape(const Shape& input) const {
+  const bool nchw = layout_ == ConvLayout::kNchw;
+  if (nchw ? input.rank() != 4 || input[1] != in_channels_
+           : input.rank() != 5 || input[4] != block_ ||
+                 input[1] != (in_channels_ + block_ - 1) / block_)
+    throw std::invalid_argument("Conv2d: input shape does not match layer");
+  const size_t oh =
+      conv_output_size(input[2], kernel_h_, params_.stride_h, params_.pad_top,
+                       params_.pad_bottom, params_.dilation_h);
+  const size_t ow =
+      conv_output_size(input[3], kernel_w_, params_.stride_w, params_.pad_left,
+                       params_.pad_right, params_.dilation_w);
+  if (oh == 0 || ow == 0)
+    throw std::invalid_argument("Conv2d: kernel larger than padded input");
+  if (nchw) return Shape{input[0], out_channels_, oh, ow};
+  return Shape{input[0], (out_channels_ + block_ - 1) / block_, oh, ow, block_};
+}
+
+/**
+ * @brief Run the convolution.
+ */
+void Conv2d::forward(const Tensor<float>& input, Tensor<float>& output,
+                     const ConvEpilogue& epilogue) const {
+  if (output.shape() != outputShape(input.shape()))
+    throw std::invalid_argument("Conv2d: output shape mismatch");
+  if (epilogue.residual && epilogue.residual->shape() != output.shape())
+    throw std::invalid_argument("Conv2d: residual shape mismatch");
+  const float* res = epilogue.residual ? epilogue.residual->data() : nullptr;
+  const size_t n = input.dim(0), h = input.dim(2), w = input.dim(3);
+  const size_t oh = output.dim(2), ow = output.dim(3);
+  const float* in = input.data();
+  float* out = output.data();
+  const float* bias = bias_.empty() ? nullptr : bias_.data();
+  const Conv2dParams& p = params_;
+
+  if (algorithm_ == ConvAlgorithm::kWinograd) {
+    winograd_conv(gemm_weights_, bias, p, input, output, epilogue);
+    return;
+  }
+  if (algorithm_ == ConvAlgorithm::kGemm ||
+      algorithm_ == ConvAlgorithm::kIm2col) {
+    const size_t groups = p.groups, ig = in_channels_ / groups;
+    const size_t og = out_channels_ / groups;
+    const size_t pixels = oh * ow;
+    ScratchScope scope;  // the im2col matrix outlives the GEMM calls
+    float* col = algorithm_ == ConvAlgorithm::kIm2col
+                     ? scratch(ig * kernel_h_ * kernel_w_ * pixels)
+                     : nullptr;
+    for (size_t b = 0; b < n; ++b) {
+      for (size_t g = 0; g < groups; ++g) {
+        const float* x = in + (b * in_channels_ + g * ig) * h * w;
+        const size_t at = (b * out_channels_ + g * og) * pixels;
+        if (col) {
+          im2col(x, ig, h, w, kernel_h_, kernel_w_, oh, ow, p, col);
+          x = col;
+        }
+        GemmEpilogue tail;
+        tail.row_bias = bias ? bias + g * og : nullptr;
+        tail.residual = res ? res + at : nullptr;
+        tail.ldr = pixels;
+        tail.clamp_min = epilogue.clamp_min;
+        tail.clamp_max = epilogue.clamp_max;
+        sgemm_packed(gemm_weights_[g], false, pixels, x, pixels, 0.f,
+                     out + at, pixels, tail);
+      }
+    }
+    return;
+  }
+
+  if (layout_ == ConvLayout::kNchw) {  // depthwise
+    // Tap-major loops: each kernel tap adds a scaled, shifted copy of the
+    // valid input columns to every output row, with no per-pixel branches.
+    const size_t kh = kernel_h_, kw = kernel_w_, sw = p.stride_w;
+    parallel_for(0, n * out_channels_, 1, [&](size_t first, size_t last) {
+      for (size_t nc = first; nc < last; ++nc) {
+        const size_t c = nc % out_channels_;
+        const float* plane = in + nc * h * w;
+        const float* filt = weights_.data() + c * kh * kw;
+        float* dst = out + nc * oh * ow;
+        std::fill(dst, dst + oh * ow, bias ? bias[c] : 0.f);
+        for (size_t x = 0; x < kw; ++x) {
+          const ptrdiff_t off =
+              ptrdiff_t(x * p.dilation_w) - ptrdiff_t(p.pad_left);
+          if (off >= ptrdiff_t(w)) continue;
+          const size_t ox_lo =
+              off >= 0 ? 0 : std::min(ow, (size_t(-off) + sw - 1) / sw);
+          const size_t ox_hi =
+              std::min(ow, size_t(ptrdiff_t(w) - 1 - off) / sw + 1);
+          for (size_t y = 0; y < kh; ++y) {
+            const float wv = filt[y * kw + x];
+            for (size_t oy = 0; oy < oh; ++oy) {
+              const ptrdiff_t iy = ptrdiff_t(oy * p.stride_h +
+                                             y * p.dilation_h) -
+                                   ptrdiff_t(p.pad_top);
+              if (iy < 0 || iy >= ptrdiff_t(h)) continue;
+              const float* row = plane + size_t(iy) * w;
+              float* d = dst + oy * ow;
+              for (size_t ox = ox_lo; ox < ox_hi; ++ox)
+                d[ox] += wv * row[ptrdiff_t(ox * sw) + off];
+            }
+          }
+        }
+        finish_outputs(dst, res ? res + nc * oh * ow : nullptr, oh * ow,
+                       epilogue);
+      }
+    });
+    return;
+  }
+
+  // NCHWc direct and depthwise kernels, parallel over output rows.
+  const size_t cb = block_, in_blocks = input.dim(1);
+  const size_t out_blocks = output.dim(1);
+  const bool depthwise = algorithm_ == ConvAlgorithm::kDepthwise;
+  const DirectKernels direct = select_direct(cb);
+  const RowTileFn pixel = select_depthwise(cb);
+
+  // Output columns whose taps all fall inside the image.
+  const size_t extent_w = (kernel_w_ - 1) * p.dilation_w;
+  const size_t ow_lo =
+      std::min(ow, (p.pad_left + p.stride_w - 1) / p.stride_w);
+  size_t ow_hi = 0;
+  if (w + p.pad_left > extent_w)
+    ow_hi = std::min(ow, (w - 1 + p.pad_left - extent_w) / p.stride_w + 1);
+  ow_hi = std::max(ow_hi, ow_lo);
+
+  const size_t taps = kernel_h_ * kernel_w_;
+  const size_t w_block = depthwise ? taps * cb : in_blocks * taps * cb * cb;
+  parallel_for(0, n * out_blocks * oh, 1, [&](size_t first, size_t last) {
+    for (size_t r = first; r < last; ++r) {
+      const size_t oy = r % oh, ob = r / oh % out_blocks;
+      const size_t b = r / oh / out_blocks;
+      DirectArgs a;
+      a.in = in + b * in_blocks * h * w * cb;
+      if (depthwise) a.in += ob * h * w * cb;
+      a.w = weights_.data() + ob * w_block;
+      a.bias = bias ? bias + ob * cb : nullptr;
+      a.out = out + r * ow * cb;
+      a.in_blocks = in_blocks;
+      a.h = h;
+      a.w_in = w;
+      a.kh = kernel_h_;
+      a.kw = kernel_w_;
+      a.sh = p.stride_h;
+      a.sw = p.stride_w;
+      a.dh = p.dilation_h;
+      a.dw = p.dilation_w;
+      a.ih0 = ptrdiff_t(oy * p.stride_h) - ptrdiff_t(p.pad_top);
+      a.pl = ptrdiff_t(p.pad_left);
+      if (depthwise) {
+        for (size_t x = 0; x < ow; ++x) pixel(a, x);
+      } else {
+        size_t x = 0;
+        for (; x < ow_lo; ++x) direct.border(a, x);
+        for (; x + kWideTile <= ow_hi; x += kWideTile) direct.wide(a, x);
+        for (; x + 4 <= ow_hi; x += 4) direct.tile4(a, x);
+        for (; x < ow_hi; ++x) direct.tile1(a, x);
+        for (; x < ow; ++x) direct.border(a, x);
+      }
+      finish_outputs(a.out, res ? res + r * ow * cb : nullptr, ow * cb,
+                     epilogue);
+    }
+  });
+}
+
+/**
+ * @brief Run the convolution, allocating the output.
+ */
+Tensor<float> Conv2d::forward(const Tensor<float>& input) const {
+  Tensor<float> output(outputShape(input.shape()));
+  forward(input, output);
+  return output;
+}
@@ -0,0 +1,492 @@
+#include "ops/gemm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+#include "utils/scratch.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+#endif
+
+/** Depth of a packed panel (sized so an A and a B micro-panel fit in L1). */
+static constexpr size_t kKC = 256;
+/** Target rows of a packed A block, see GemmBlocking::mc. */
+static std::atomic<size_t> g_mc{GemmBlocking{}.mc};
+/** Target columns of a packed B panel, see GemmBlocking::nc. */
+static std::atomic<size_t> g_nc{GemmBlocking{}.nc};
+/** Blocking of the calling thread's innermost GemmBlockingScope, if any. */
+static thread_local const GemmBlocking* t_blocking = nullptr;
+/** Largest micro-tile of any kernel, used for edge tile scratch space. */
+static constexpr size_t kMaxTile = 12 * 32;
+
+/**
+ * @brief Register-blocked micro-kernel computing one full micro-tile.
+ *
+ * Computes `C = beta * C + A * B` for an [mr, nr] tile of C, where A is a
+ * packed [kc, mr] micro-panel and B a packed [kc, nr] micro-panel. If @p beta
+ * is zero, C is not read.
+ */
+using MicroKernelFn = void (*)(size_t kc, const float* a, const float* b,
+                               float* c, size_t ldc, float beta);
+
+/**
+ * @brief Micro-kernel together with its register tile shape.
+ */
+struct GemmKernel {
+  size_t mr;        /**< Rows of the micro-tile */
+  size_t nr;        /**< Columns of the micro-tile */
+  MicroKernelFn fn; /**< Kernel entry point */
+};
+
+/**
+ * @brief Portable micro-kernel, left to the compiler to vectorise.
+ */
+template <size_t MR, size_t NR>
+static void kernel_generic(size_t kc, const float* a, const float* b,
+                           float* c, size_t ldc, float beta) {
+  float acc[MR][NR] = {};
+  for (size_t p = 0; p < kc; ++p, a += MR, b += NR)
+    for (size_t i = 0; i < MR; ++i)
+      for (size_t j = 0; j < NR; ++j) acc[i][j] += a[i] * b[j];
+  for (size_t i = 0; i < MR; ++i)
+    for (size_t j = 0; j < NR; ++j)
+      c[i * ldc + j] =
+          beta == 0.f ? acc[i][j] : beta * c[i * ldc + j] + acc[i][j];
+}
+
+#if defined(VF_X86)
+/**
+ * @brief AVX2/FMA micro-kernel with a 6x16 register tile.
+ *
+ * Twelve accumulators, two B vectors and one broadcast A value use 15 of the
+ * 16 ymm registers.
+ */
+VF_TARGET("avx2,fma")
+static void kernel_avx2(size_t kc, const float* a, const float* b, float* c,
+                        size_t ldc, float beta) {
+  constexpr size_t MR = 6;
+  __m256 acc[MR][2];
+  VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+    acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+  }
+  for (size_t p = 0; p < kc; ++p, a += MR, b += 16) {
+    const __m256 b0 = _mm256_load_ps(b);
+    const __m256 b1 = _mm256_load_ps(b + 8);
+    VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+      const __m256 ai = _mm256_broadcast_ss(a + i);
+      acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+    }
+  }
+  const __m256 vbeta = _mm256_set1_ps(beta);
+  VF_UNROLL for (size_t i = 0; i < MR; ++i, c += ldc) {
+    if (beta != 0.f) {
+      acc[i][0] = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(c), acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(c + 8), acc[i][1]);
+    }
+    _mm256_storeu_ps(c, acc[i][0]);
+    _mm256_storeu_ps(c + 8, acc[i][1]);
+  }
+}
+
+/**
+ * @brief AVX-512 micro-kernel with a 12x32 register tile.
+ *
+ * Twenty-four accumulators, two B vectors and one broadcast A value use 27 of
+ * the 32 zmm registers.
+ */
+VF_TARGET("avx512f")
+static void kernel_avx512(size_t kc, const float* a, const float* b, float* c,
+                          size_t ldc, float beta) {
+  constexpr size_t MR = 12;
+  __m512 acc[MR][2];
+  VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+    acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+  }
+  for (size_t p = 0; p < kc; ++p, a += MR, b += 32) {
+    const __m512 b0 = _mm512_load_ps(b);
+    const __m512 b1 = _mm512_load_ps(b + 16);
+    VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+      const __m512 ai = _mm512_set1_ps(a[i]);
+      acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+      acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+    }
+  }
+  const __m512 vbeta = _mm512_set1_ps(beta);
+  VF_UNROLL for (size_t i = 0; i < MR; ++i, c += ldc) {
+    if (beta != 0.f) {
+      acc[i][0] = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(c), acc[i][0]);
+      acc[i][1] = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(c + 16), acc[i][1]);
+    }
+    _mm512_storeu_ps(c, acc[i][0]);
+    _mm512_storeu_ps(c + 16, acc[i][1]);
+  }
+}
+#endif
+
+static constexpr GemmKernel kGenericKernel{4, 8, kernel_generic<4, 8>};
+#if defined(VF_X86)
+static constexpr GemmKernel kAvx2Kernel{6, 16, kernel_avx2};
+static constexpr GemmKernel kAvx512Kernel{12, 32, kernel_avx512};
+#endif
+
+/**
+ * @brief Select the fastest micro-kernel supported by the CPU.
+ */
+static const GemmKernel& select_kernel() {
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512f) return kAvx512Kernel;
+  if (cpu.avx2 && cpu.fma) return kAvx2Kernel;
+#endif
+  return kGenericKernel;
+}
+
+/**
+ * @brief Find the micro-kernel that matches the tile shape of a packed A.
+ */
+static const GemmKernel& kernel_for(size_t mr, size_t nr) {
+#if defined(VF_X86)
+  if (mr == kAvx512Kernel.mr && nr == kAvx512Kernel.nr) return kAvx512Kernel;
+  if (mr == kAvx2Kernel.mr && nr == kAvx2Kernel.nr) return kAvx2Kernel;
+#endif
+  if (mr == kGenericKernel.mr && nr == kGenericKernel.nr)
+    return kGenericKernel;
+  throw std::invalid_argument("sgemm_packed: unknown packing layout");
+}
+
+/**
+ * @brief Get a per-thread 64-byte aligned packing buffer of @p n floats.
+ *
+ * Buffers only grow, so steady-state GEMM calls do not allocate. Slot 0 holds
+ * packed A blocks and slot 1 packed B panels, kept per ScratchScope depth.
+ */
+static float* pack_buffer(size_t slot, size_t n) {
+  thread_local ScratchBuffers<float, 2> buffers;
+  return buffers.get(slot, n);
+}
+
+/**
+ * @brief Pack rows [i0, i0 + mc) and columns [p0, p0 + kc) of alpha * op(A).
+ *
+ * The block is stored as consecutive [kc, mr] micro-panels; rows beyond the
+ * matrix are zero padded.
+ */
+static void pack_a(bool trans, const float* a, size_t lda, size_t i0,
+                   size_t mc, size_t p0, size_t kc, float alpha, size_t mr,
+                   float* dst) {
+  for (size_t ip = 0; ip < mc; ip += mr, dst += mr * kc) {
+    const size_t rows = std::min(mr, mc - ip);
+    if (trans) {
+      for (size_t p = 0; p < kc; ++p) {
+        const float* src = a + (p0 + p) * lda + i0 + ip;
+        for (size_t r = 0; r < rows; ++r) dst[p * mr + r] = alpha * src[r];
+      }
+    } else {
+      // Read rows of A contiguously; the strided writes stay within L1.
+      for (size_t r = 0; r < rows; ++r) {
+        const float* src = a + (i0 + ip + r) * lda + p0;
+        for (size_t p = 0; p < kc; ++p) dst[p * mr + r] = alpha * src[p];
+      }
+    }
+    for (size_t r = rows; r < mr; ++r)
+      for (size_t p = 0; p < kc; ++p) dst[p * mr + r] = 0.f;
+  }
+}
+
+/**
+ * @brief Pack micro-panels [first, last) of rows [p0, p0 + kc) and columns
+ * [j0, j0 + nc) of op(B).
+ *
+ * Each micro-panel is a [kc, nr] row-major slab; columns beyond the matrix
+ * are zero padded.
+ */
+static void pack_b(bool trans, const float* b, size_t ldb, size_t p0,
+                   size_t kc, size_t j0, size_t nc, size_t nr, size_t first,
+                   size_t last, float* dst) {
+  for (size_t panel = first; panel < last; ++panel) {
+    const size_t jp = panel * nr, cols = std::min(nr, nc - jp);
+    float* out = dst + panel * nr * kc;
+    for (size_t p = 0; p < kc; ++p, out += nr) {
+      if (trans) {
+        for (size_t j = 0; j < cols; ++j)
+          out[j] = b[(j0 + jp + j) * ldb + p0 + p];
+      } else {
+        const float* row = b + (p0 + p) * ldb + j0 + jp;
+        std::copy(row, row + cols, out);
+      }
+      std::fill(out + cols, out + nr, 0.f);
+    }
+  }
+}
+
+/**
+ * @brief Apply an epilogue to the [rows, cols] tile of C at (row0, col0).
+ *
+ * @p c points at the tile itself.
+ */
+static void apply_epilogue(const GemmEpilogue& epi, size_t row0, size_t col0,
+                           size_t rows, size_t cols, float* c, size_t ldc) {
+  for (size_t i = 0; i < rows; ++i) {
+    float* row = c + i * ldc;
+    const float bias = epi.row_bias ? epi.row_bias[row0 + i] : 0.f;
+    if (epi.residual) {
+      const float* r = epi.residual + (row0 + i) * epi.ldr + col0;
+      for (size_t j = 0; j < cols; ++j) row[j] += bias + r[j];
+    } else if (bias != 0.f) {
+      for (size_t j = 0; j < cols; ++j) row[j] += bias;
+    }
+    for (size_t j = 0; j < cols; ++j)
+      row[j] = std::min(std::max(row[j], epi.clamp_min), epi.clamp_max);
+  }
+}
+
+/**
+ * @brief Multiply a packed [mc, kc] A block with packed B micro-panels
+ * [first, last) into the matching tiles of C.
+ *
+ * If @p epi is given, each tile is finished with it right after it is
+ * computed; (row0, col0) is the position of @p c in the full C.
+ */
+static void macro_kernel(const GemmKernel& kern, size_t mc, size_t nc,
+                         size_t kc, const float* pa, const float* pb,
+                         size_t first, size_t last, float beta, float* c,
+                         size_t ldc, const GemmEpilogue* epi, size_t row0,
+                         size_t col0) {
+  alignas(64) float tile[kMaxTile];
+  for (size_t panel = first; panel < last; ++panel) {
+    const size_t jr = panel * kern.nr, cols = std::min(kern.nr, nc - jr);
+    const float* b = pb + panel * kern.nr * kc;
+    for (size_t ir = 0; ir < mc; ir += kern.mr) {
+      const size_t rows = std::min(kern.mr, mc - ir);
+      float* ct = c + ir * ldc + jr;
+      if (rows == kern.mr && cols == kern.nr) {
+        kern.fn(kc, pa + ir * kc, b, ct, ldc, beta);
+      } else {
+        // Edge tile: compute the full tile into scratch and copy the valid
+        // part.
+        kern.fn(kc, pa + ir * kc, b, tile, kern.nr, 0.f);
+        for (size_t i = 0; i < rows; ++i)
+          for (size_t j = 0; j < cols; ++j) {
+            float& dst = ct[i * ldc + j];
+            const float v = tile[i * kern.nr + j];
+            dst = beta == 0.f ? v : beta * dst + v;
+          }
+      }
+      if (epi) apply_epilogue(*epi, row0 + ir, col0 + jr, rows, cols, ct, ldc);
+    }
+  }
+}
+
+/**
+ * @brief Scale C by beta (used when the product term vanishes).
+ */
+static void scale_c(size_t m, size_t n, float beta, float* c, size_t ldc) {
+  if (beta == 1.f) return;
+  for (size_t i = 0; i < m; ++i) {
+    float* row = c + i * ldc;
+    if (beta == 0.f)
+      std::fill(row, row + n, 0.f);
+    else
+      for (size_t j = 0; j < n; ++j) row[j] *= beta;
+  }
+}
+
+/**
+ * @brief Blocked GEMM driver shared by sgemm() and sgemm_packed().
+ *
+ * Either @p packed (whole pre-packed A) or @p a (packed on the fly) is used.
+ * The epilogue, if any, runs with the last slice of the K loop.
+ */
+static void gemm_driver(const GemmKernel& kern, const float* packed,
+                        bool trans_a, const float* a, size_t lda, float alpha,
+                        bool trans_b, size_t m, size_t n, size_t k,
+                        const float* b, size_t ldb, float beta, float* c,
+                        size_t ldc, const GemmEpilogue* epilogue) {
+  const size_t mr = kern.mr, nr = kern.nr;
+  const GemmBlocking blocking = sgemm_blocking();
+  const size_t mc_max = std::max(mr, blocking.mc / mr * mr);
+  const size_t nc_max = std::max(nr, blocking.nc / nr * nr);
+  const size_t m_pad = (m + mr - 1) / mr * mr;
+  const size_t m_blocks = (m + mc_max - 1) / mc_max;
+  const size_t threads = num_threads();
+  ScratchScope scope;  // B panels stay in use across parallel_for()
+
+  for (size_t jc = 0; jc < n; jc += nc_max) {
+    const size_t nc = std::min(nc_max, n - jc);
+    const size_t n_panels = (nc + nr - 1) / nr;
+    for (size_t pc = 0; pc < k; pc += kKC) {
+      const size_t kc = std::min(kKC, k - pc);
+      const float beta_k = pc == 0 ? beta : 1.f;
+      const GemmEpilogue* epi = pc + kc == k ? epilogue : nullptr;
+
+      float* pb = pack_buffer(1, n_panels * nr * kc);
+      parallel_for(0, n_panels, 16, [&](size_t first, size_t last) {
+        pack_b(trans_b, b, ldb, pc, kc, jc, nc, nr, first, last, pb);
+      });
+
+      // Split along N as well when there are too few M blocks to occupy
+      // every thread; tasks of the same M block are adjacent so a thread
+      // running several of them packs the A block only once.
+      const size_t n_split = std::clamp<size_t>(
+          (threads + m_blocks - 1) / m_blocks, 1, n_panels);
+      parallel_for(0, m_blocks * n_split, 1, [&](size_t t0, size_t t1) {
+        size_t packed_block = size_t(-1);
+        const float* pa = nullptr;
+        for (size_t t = t0; t < t1; ++t) {
+          const size_t ib = t / n_split, js = t % n_split;
+          const size_t ic = ib * mc_max, mc = std::min(mc_max, m - ic);
+          if (ib != packed_block) {
+            if (packed) {
+              pa = packed + pc * m_pad + ic * kc;
+            } else {
+              const size_t mc_pad = (mc + mr - 1) / mr * mr;
+              float* buf = pack_buffer(0, mc_pad * kc);
+              pack_a(trans_a, a, lda, ic, mc, pc, kc, alpha, mr, buf);
+              pa = buf;
+            }
+            packed_block = ib;
+          }
+          macro_kernel(kern, mc, nc, kc, pa, pb, n_panels * js / n_split,
+                       n_panels * (js + 1) / n_split, beta_k,
+                       c + ic * ldc + jc, ldc, epi, ic, jc);
+        }
+      });
+    }
+  }
+}
+
+/**
+ * @brief Get the cache blocking used by sgemm() and sgemm_packed().
+ */
+GemmBlocking sgemm_blocking() {
+  if (t_blocking) return *t_blocking;
+  return {g_mc.load(std::memory_order_relaxed),
+          g_nc.load(std::memory_order_relaxed)};
+}
+
+/**
+ * @brief Set the process-wide cache blocking of sgemm() and sgemm_packed().
+ */
+void set_sgemm_blocking(const GemmBlocking& blocking) {
+  if (blocking.mc == 0 || blocking.nc == 0)
+    throw std::invalid_argument("set_sgemm_blocking: block sizes must be > 0");
+  g_mc.store(blocking.mc, std::memory_order_relaxed);
+  g_nc.store(blocking.nc, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Use @p blocking for GEMMs called on this thread.
+ */
+GemmBlockingScope::GemmBlockingScope(const GemmBlocking& blocking)
+    : blocking_(blocking), previous_(t_blocking) {
+  if (blocking.mc == 0 || blocking.nc == 0)
+    throw std::invalid_argument("GemmBlockingScope: block sizes must be > 0");
+  t_blocking = &blocking_;
+}
+
+/**
+ * @brief Restore the enclosing blocking.
+ */
+GemmBlockingScope::~GemmBlockingScope() { t_blocking = previous_; }
+
+/**
+ * @brief Single-precision general matrix multiply on row-major matrices.
+ */
+void sgemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+           float alpha, const float* a, size_t lda, const float* b, size_t ldb,
+           float beta, float* c, size_t ldc) {
+  if (m == 0 || n == 0) return;
+  if (k == 0 || alpha == 0.f) {
+    scale_c(m, n, beta, c, ldc);
+    return;
+  }
+  gemm_driver(select_kernel(), nullptr, trans_a, a, lda, alpha, trans_b, m, n,
+              k, b, ldb, beta, c, ldc, nullptr);
+}
+
+/**
+ * @brief Pack `alpha * op(A)` for repeated use with sgemm_packed().
+ *
+ * Panels of every [kc] slice are stored back to back, slice `pc` starting at
+ * `pc * m_pad` where `m_pad` is m rounded up to the micro-tile height.
+ */
+GemmPackedA sgemm_pack_a(bool trans_a, size_t m, size_t k, float alpha,
+                         const float* a, size_t lda) {
+  const GemmKernel& kern = select_kernel();
+  GemmPackedA packed;
+  packed.m = m;
+  packed.k = k;
+  packed.mr = kern.mr;
+  packed.nr = kern.nr;
+  const size_t m_pad = (m + kern.mr - 1) / kern.mr * kern.mr;
+  if (m_pad * k == 0) return packed;
+  packed.data = Tensor<float>(Shape{m_pad * k});
+  float* dst = packed.data.data();
+  for (size_t pc = 0; pc < k; pc += kKC) {
+    const size_t kc = std::min(kKC, k - pc);
+    pack_a(trans_a, a, lda, 0, m, pc, kc, alpha, kern.mr, dst + pc * m_pad);
+  }
+  return packed;
+}
+
+/**
+ * @brief Get a key identifying the panel layout of sgemm_pack_a().
+ */
+std::string sgemm_pack_key() {
+  const GemmKernel& kern = select_kernel();
+  return "f32-" + std::to_string(kern.mr) + "x" + std::to_string(kern.nr);
+}
+
+/**
+ * @brief Adopt panels packed earlier by sgemm_pack_a(), e.g. from a cache.
+ */
+GemmPackedA sgemm_adopt_packed(size_t m, size_t k, Tensor<float> data) {
+  const GemmKernel& kern = select_kernel();
+  const size_t m_pad = (m + kern.mr - 1) / kern.mr * kern.mr;
+  if (data.numel() != m_pad * k)
+    throw std::invalid_argument("sgemm_adopt_packed: wrong panel size");
+  GemmPackedA packed;
+  packed.m = m;
+  packed.k = k;
+  packed.mr = kern.mr;
+  packed.nr = kern.nr;
+  packed.data = std::move(data);
+  return packed;
+}
+
+/**
+ * @brief General matrix multiply with a pre-packed left operand.
+ */
+void sgemm_packed(const GemmPackedA& a, bool trans_b, size_t n, const float* b,
+                  size_t ldb, float beta, float* c, size_t ldc,
+                  const GemmEpilogue& epilogue) {
+  if (a.m == 0 || n == 0) return;
+  const GemmEpilogue* epi = epilogue.active() ? &epilogue : nullptr;
+  if (a.k == 0) {
+    scale_c(a.m, n, beta, c, ldc);
+    if (epi) apply_epilogue(*epi, 0, 0, a.m, n, c, ldc);
+    return;
+  }
+  if (a.empty()) throw std::invalid_argument("sgemm_packed: A is not packed");
+  gemm_driver(kernel_for(a.mr, a.nr), a.data.data(), false, nullptr, 0, 1.f,
+              trans_b, a.m, n, a.k, b, ldb, beta, c, ldc, epi);
+}
+
+/**
+ * @brief Multiply two row-major matrices.
+ */
+Tensor<float> matmul(const Tensor<float>& a, const Tensor<float>& b) {
+  if (a.rank() != 2 || b.rank() != 2 || a.dim(1) != b.dim(0))
+    throw std::invalid_argument("matmul: expected [m, k] x [k, n] matrices");
+  const size_t m = a.dim(0), k = a.dim(1), n = b.dim(1);
+  Tensor<float> c(Shape{m, n});
+  sgemm(false, false, m, n, k, 1.f, a.data(), k, b.data(), n, 0.f, c.data(),
+        n);
+  return c;
+}
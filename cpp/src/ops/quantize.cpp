@@ -0,0 +1,583 @@
+#include "ops/quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+#include "utils/scratch.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+#endif
+
+/** Target rows of a block of A handled by one task. */
+static constexpr size_t kMC = 144;
+/** Budget in bytes for the packed B panels of one column block (1 MiB). */
+static constexpr size_t kPanelBytes = size_t(1) << 20;
+/** Largest micro-tile of any kernel, used for tile scratch space. */
+static constexpr size_t kMaxTile = 12 * 32;
+
+/**
+ * @brief Integer micro-kernel computing one full micro-tile.
+ *
+ * Multiplies a packed [groups, mr, 4] signed panel of A with a packed
+ * [groups, nr, 4] unsigned panel of B and writes the 32-bit sums to the
+ * row-major [mr, nr] tile @p c.
+ */
+using QMicroKernelFn = void (*)(size_t groups, const int8_t* a,
+                                const uint8_t* b, int32_t* c);
+
+/**
+ * @brief Integer micro-kernel together with its tile shape and code range.
+ */
+struct QGemmKernel {
+  size_t mr;         /**< Rows of the micro-tile */
+  size_t nr;         /**< Columns of the micro-tile */
+  int32_t qmax;      /**< Largest weight code the kernel accumulates exactly */
+  const char* name;  /**< Name reported by qgemm_kernel_name() */
+  QMicroKernelFn fn; /**< Kernel entry point */
+};
+
+/**
+ * @brief Portable micro-kernel, left to the compiler to vectorise.
+ */
+template <size_t MR, size_t NR>
+static void qkernel_generic(size_t groups, const int8_t* a, const uint8_t* b,
+                            int32_t* c) {
+  int32_t acc[MR][NR] = {};
+  for (size_t p = 0; p < groups; ++p, a += MR * 4, b += NR * 4)
+    for (size_t i = 0; i < MR; ++i)
+      for (size_t j = 0; j < NR; ++j)
+        for (size_t t = 0; t < 4; ++t)
+          acc[i][j] += int32_t(a[i * 4 + t]) * int32_t(b[j * 4 + t]);
+  for (size_t i = 0; i < MR; ++i)
+    for (size_t j = 0; j < NR; ++j) c[i * NR + j] = acc[i][j];
+}
+
+#if defined(VF_X86)
+/**
+ * @brief Load four packed codes of A as one 32-bit lane value.
+ */
+static inline int32_t load_group(const int8_t* a) {
+  int32_t v;
+  std::memcpy(&v, a, sizeof(v));
+  return v;
+}
+
+/**
+ * @brief AVX2 micro-kernel with a 4x16 tile built on `vpmaddubsw`.
+ *
+ * `vpmaddubsw` multiplies unsigned B codes with signed A codes and adds
+ * adjacent pairs into saturating 16-bit lanes; `vpmaddwd` with ones widens
+ * them to 32 bits. With 7-bit weights the pair sums cannot saturate.
+ */
+VF_TARGET("avx2")
+static void qkernel_avx2(size_t groups, const int8_t* a, const uint8_t* b,
+                         int32_t* c) {
+  constexpr size_t MR = 4;
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc[MR][2];
+  VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+    acc[i][0] = acc[i][1] = _mm256_setzero_si256();
+  }
+  for (size_t p = 0; p < groups; ++p, a += MR * 4, b += 64) {
+    const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i b1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32));
+    VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+      const __m256i ai = _mm256_set1_epi32(load_group(a + i * 4));
+      acc[i][0] = _mm256_add_epi32(
+          acc[i][0], _mm256_madd_epi16(_mm256_maddubs_epi16(b0, ai), ones));
+      acc[i][1] = _mm256_add_epi32(
+          acc[i][1], _mm256_madd_epi16(_mm256_maddubs_epi16(b1, ai), ones));
+    }
+  }
+  VF_UNROLL for (size_t i = 0; i < MR; ++i, c += 16) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), acc[i][0]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + 8), acc[i][1]);
+  }
+}
+
+/**
+ * @brief AVX-VNNI micro-kernel with a 6x16 tile built on `vpdpbusd`.
+ *
+ * Twelve accumulators, two B vectors and one broadcast A group use 15 of
+ * the 16 ymm registers.
+ */
+VF_TARGET("avx2,avxvnni")
+static void qkernel_avxvnni(size_t groups, const int8_t* a, const uint8_t* b,
+                            int32_t* c) {
+  constexpr size_t MR = 6;
+  __m256i acc[MR][2];
+  VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+    acc[i][0] = acc[i][1] = _mm256_setzero_si256();
+  }
+  for (size_t p = 0; p < groups; ++p, a += MR * 4, b += 64) {
+    const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i b1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32));
+    VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+      const __m256i ai = _mm256_set1_epi32(load_group(a + i * 4));
+      acc[i][0] = _mm256_dpbusd_avx_epi32(acc[i][0], b0, ai);
+      acc[i][1] = _mm256_dpbusd_avx_epi32(acc[i][1], b1, ai);
+    }
+  }
+  VF_UNROLL for (size_t i = 0; i < MR; ++i, c += 16) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), acc[i][0]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + 8), acc[i][1]);
+  }
+}
+
+/**
+ * @brief AVX-512 VNNI micro-kernel with a 12x32 tile built on `vpdpbusd`.
+ */
+VF_TARGET("avx512f,avx512vnni")
+static void qkernel_avx512vnni(size_t groups, const int8_t* a,
+                               const uint8_t* b, int32_t* c) {
+  constexpr size_t MR = 12;
+  __m512i acc[MR][2];
+  VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+    acc[i][0] = acc[i][1] = _mm512_setzero_si512();
+  }
+  for (size_t p = 0; p < groups; ++p, a += MR * 4, b += 128) {
+    const __m512i b0 = _mm512_loadu_si512(b);
+    const __m512i b1 = _mm512_loadu_si512(b + 64);
+    VF_UNROLL for (size_t i = 0; i < MR; ++i) {
+      const __m512i ai = _mm512_set1_epi32(load_group(a + i * 4));
+      acc[i][0] = _mm512_dpbusd_epi32(acc[i][0], b0, ai);
+      acc[i][1] = _mm512_dpbusd_epi32(acc[i][1], b1, ai);
+    }
+  }
+  VF_UNROLL for (size_t i = 0; i < MR; ++i, c += 32) {
+    _mm512_storeu_si512(c, acc[i][0]);
+    _mm512_storeu_si512(c + 16, acc[i][1]);
+  }
+}
+
+/**
+ * @brief Quantize with AVX2, 32 values per iteration.
+ */
+VF_TARGET("avx2")
+static size_t quantize_u8_avx2(const float* x, size_t n, float inv, float zp,
+                               uint8_t* q) {
+  const __m256 vinv = _mm256_set1_ps(inv), vzp = _mm256_set1_ps(zp);
+  const __m256 lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(255.f);
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v[4];
+    VF_UNROLL for (size_t r = 0; r < 4; ++r) {
+      __m256 f = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i + 8 * r),
+                                             vinv),
+                               vzp);
+      f = _mm256_min_ps(_mm256_max_ps(f, lo), hi);
+      v[r] = _mm256_cvtps_epi32(f);
+    }
+    // The packs interleave 128-bit lanes; the permute restores the order.
+    const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v[0], v[1]),
+                                               _mm256_packs_epi32(v[2], v[3]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(q + i),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+  return i;
+}
+#endif
+
+static constexpr QGemmKernel kGenericKernel{4, 8, 127, "generic",
+                                            qkernel_generic<4, 8>};
+#if defined(VF_X86)
+static constexpr QGemmKernel kAvx2Kernel{4, 16, 63, "avx2", qkernel_avx2};
+static constexpr QGemmKernel kAvxVnniKernel{6, 16, 127, "avx-vnni",
+                                            qkernel_avxvnni};
+static constexpr QGemmKernel kAvx512VnniKernel{12, 32, 127, "avx512-vnni",
+                                               qkernel_avx512vnni};
+#endif
+
+/**
+ * @brief Select the fastest integer micro-kernel supported by the CPU.
+ */
+static const QGemmKernel& select_kernel() {
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512f && cpu.avx512vnni) return kAvx512VnniKernel;
+  if (cpu.avx2 && cpu.avxvnni) return kAvxVnniKernel;
+  if (cpu.avx2) return kAvx2Kernel;
+#endif
+  return kGenericKernel;
+}
+
+/**
+ * @brief Find the micro-kernel that matches the packing of a quantized A.
+ */
+static const QGemmKernel& kernel_for(const QGemmPackedA& a) {
+#if defined(VF_X86)
+  for (const QGemmKernel* kern :
+       {&kAvx512VnniKernel, &kAvxVnniKernel, &kAvx2Kernel})
+    if (a.mr == kern->mr && a.nr == kern->nr && a.qmax == kern->qmax)
+      return *kern;
+#endif
+  if (a.mr == kGenericKernel.mr && a.nr == kGenericKernel.nr &&
+      a.qmax <= kGenericKernel.qmax)
+    return kGenericKernel;
+  throw std::invalid_argument("qgemm: unknown packing layout");
+}
+
+/**
+ * @brief Get a per-thread 64-byte aligned byte buffer of @p n bytes.
+ *
+ * Slot 0 holds packed B panels, slots 1 and 2 the quantized input and the
+ * im2col matrix of QConv2d, kept per ScratchScope depth.
+ */
+static uint8_t* byte_buffer(size_t slot, size_t n) {
+  thread_local ScratchBuffers<uint8_t, 3> buffers;
+  return buffers.get(slot, n);
+}
+
+/**
+ * @brief Round @p k up to a whole number of four-value groups.
+ */
+static size_t round_up4(size_t k) { return (k + 3) / 4 * 4; }
+
+/**
+ * @brief Choose unsigned 8-bit parameters covering a real range.
+ */
+QuantParams choose_quant_params(float min, float max) {
+  if (!std::isfinite(min) || !std::isfinite(max) || min > max)
+    throw std::invalid_argument("quantize: range must be finite and ordered");
+  min = std::min(min, 0.f);
+  max = std::max(max, 0.f);
+  QuantParams params;
+  if (max == min) return params;
+  params.scale = (max - min) / 255.f;
+  params.zero_point = int32_t(
+      std::clamp(std::nearbyint(-min / params.scale), 0.f, 255.f));
+  return params;
+}
+
+/**
+ * @brief Quantize real values to unsigned 8-bit codes.
+ */
+void quantize_u8(const float* x, size_t n, const QuantParams& params,
+                 uint8_t* q) {
+  const float inv = 1.f / params.scale, zp = float(params.zero_point);
+  size_t i = 0;
+#if defined(VF_X86)
+  if (cpu_features().avx2) i = quantize_u8_avx2(x, n, inv, zp, q);
+#endif
+  for (; i < n; ++i)
+    q[i] = uint8_t(
+        std::nearbyint(std::min(std::max(x[i] * inv + zp, 0.f), 255.f)));
+}
+
+/**
+ * @brief Quantize and pack a row-major matrix A for qgemm().
+ *
+ * Row i lands in micro-panel i / mr at offset `(p / 4) * mr * 4 +
+ * (i % mr) * 4 + p % 4` for column p; padding rows and columns are zero.
+ */
+QGemmPackedA qgemm_quantize_a(size_t m, size_t k, const float* a,
+                              size_t lda) {
+  const QGemmKernel& kern = select_kernel();
+  QGemmPackedA packed;
+  packed.m = m;
+  packed.k = k;
+  packed.mr = kern.mr;
+  packed.nr = kern.nr;
+  packed.qmax = kern.qmax;
+  if (m == 0) return packed;
+  packed.scales = Tensor<float>(Shape{m});
+  packed.scales.fill(1.f);
+  packed.row_sums = Tensor<int32_t>(Shape{m});
+  const size_t k4 = round_up4(k);
+  const size_t m_pad = (m + kern.mr - 1) / kern.mr * kern.mr;
+  if (k4 == 0) return packed;
+  packed.data = Tensor<int8_t>(Shape{m_pad * k4});
+  const float qmax = float(kern.qmax);
+  parallel_for(0, m, 16, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const float* row = a + i * lda;
+      float amax = 0.f;
+      for (size_t p = 0; p < k; ++p) amax = std::max(amax, std::abs(row[p]));
+      const float scale = amax > 0.f ? amax / qmax : 1.f;
+      int8_t* dst =
+          packed.data.data() + i / kern.mr * kern.mr * k4 + i % kern.mr * 4;
+      int32_t sum = 0;
+      for (size_t p = 0; p < k; ++p) {
+        const int32_t q = int32_t(std::clamp(std::nearbyint(row[p] / scale),
+                                             -qmax, qmax));
+        dst[p / 4 * kern.mr * 4 + p % 4] = int8_t(q);
+        sum += q;
+      }
+      packed.scales[i] = scale;
+      packed.row_sums[i] = sum;
+    }
+  });
+  return packed;
+}
+
+/**
+ * @brief Get the name of the integer micro-kernel used by qgemm_quantize_a().
+ */
+const char* qgemm_kernel_name() { return select_kernel().name; }
+
+/**
+ * @brief Pack micro-panels [first, last) of columns [j0, j0 + nc) of op(B).
+ *
+ * Each micro-panel is a [k4 / 4, nr, 4] slab; columns beyond the block and
+ * rows beyond k are zero.
+ */
+static void pack_b(bool trans, const uint8_t* b, size_t ldb, size_t k,
+                   size_t j0, size_t nc, size_t nr, size_t first, size_t last,
+                   uint8_t* dst) {
+  const size_t k4 = round_up4(k);
+  for (size_t panel = first; panel < last; ++panel) {
+    const size_t jp = panel * nr, cols = std::min(nr, nc - jp);
+    uint8_t* out = dst + panel * nr * k4;
+    if (cols < nr || k != k4) std::memset(out, 0, nr * k4);
+    if (trans) {
+      for (size_t j = 0; j < cols; ++j) {
+        const uint8_t* src = b + (j0 + jp + j) * ldb;
+        for (size_t p = 0; p < k; ++p)
+          out[p / 4 * nr * 4 + j * 4 + p % 4] = src[p];
+      }
+      continue;
+    }
+    // Interleave four rows of B at a time into the groups of the panel.
+    for (size_t p = 0; p < k; p += 4, out += nr * 4) {
+      const size_t depth = std::min<size_t>(4, k - p);
+      for (size_t t = 0; t < depth; ++t) {
+        const uint8_t* row = b + (p + t) * ldb + j0 + jp;
+        for (size_t j = 0; j < cols; ++j) out[j * 4 + t] = row[j];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Dequantize an [rows, cols] tile of 32-bit sums into C and apply the
+ * epilogue.
+ *
+ * (row0, col0) is the position of @p c in the full C.
+ */
+static void dequantize_tile(const QGemmPackedA& a, const int32_t* tile,
+                            size_t nr, size_t rows, size_t cols, size_t row0,
+                            size_t col0, const QuantParams& b_params,
+                            const GemmEpilogue& epi, float* c, size_t ldc) {
+  for (size_t i = 0; i < rows; ++i) {
+    const size_t r = row0 + i;
+    const float scale = a.scales[r] * b_params.scale;
+    const int32_t offset = b_params.zero_point * a.row_sums[r];
+    const float bias = epi.row_bias ? epi.row_bias[r] : 0.f;
+    const int32_t* acc = tile + i * nr;
+    float* dst = c + i * ldc;
+    if (epi.residual) {
+      const float* res = epi.residual + r * epi.ldr + col0;
+      for (size_t j = 0; j < cols; ++j)
+        dst[j] = std::min(
+            std::max(scale * float(acc[j] - offset) + bias + res[j],
+                     epi.clamp_min),
+            epi.clamp_max);
+    } else {
+      for (size_t j = 0; j < cols; ++j)
+        dst[j] = std::min(
+            std::max(scale * float(acc[j] - offset) + bias, epi.clamp_min),
+            epi.clamp_max);
+    }
+  }
+}
+
+/**
+ * @brief 8-bit integer matrix multiply with a pre-quantized left operand.
+ */
+void qgemm(const QGemmPackedA& a, bool trans_b, size_t n, const uint8_t* b,
+           size_t ldb, const QuantParams& b_params, float* c, size_t ldc,
+           const GemmEpilogue& epilogue) {
+  if (a.m == 0 || n == 0) return;
+  if (a.k == 0) {
+    // Every product vanishes; only the epilogue contributes.
+    alignas(64) const int32_t zeros[kMaxTile] = {};
+    for (size_t i = 0; i < a.m; ++i)
+      for (size_t j = 0; j < n; j += 32)
+        dequantize_tile(a, zeros, 32, 1, std::min<size_t>(32, n - j), i,
+                        j, b_params, epilogue, c + i * ldc + j, ldc);
+    return;
+  }
+  if (a.empty()) throw std::invalid_argument("qgemm: A is not packed");
+  const QGemmKernel& kern = kernel_for(a);
+  const size_t mr = kern.mr, nr = kern.nr, k4 = round_up4(a.k);
+  const size_t m = a.m;
+  const size_t mc_max = std::max(mr, kMC / mr * mr);
+  const size_t nc_max = std::max(nr, kPanelBytes / k4 / nr * nr);
+  const size_t m_blocks = (m + mc_max - 1) / mc_max;
+  const size_t threads = num_threads();
+  ScratchScope scope;  // B panels stay in use across parallel_for()
+
+  for (size_t jc = 0; jc < n; jc += nc_max) {
+    const size_t nc = std::min(nc_max, n - jc);
+    const size_t n_panels = (nc + nr - 1) / nr;
+    uint8_t* pb = byte_buffer(0, n_panels * nr * k4);
+    parallel_for(0, n_panels, 16, [&](size_t first, size_t last) {
+      pack_b(trans_b, b, ldb, a.k, jc, nc, nr, first, last, pb);
+    });
+
+    // Split along N as well when there are too few M blocks to occupy
+    // every thread.
+    const size_t n_split = std::clamp<size_t>(
+        (threads + m_blocks - 1) / m_blocks, 1, n_panels);
+    parallel_for(0, m_blocks * n_split, 1, [&](size_t t0, size_t t1) {
+      alignas(64) int32_t tile[kMaxTile];
+      for (size_t t = t0; t < t1; ++t) {
+        const size_t ib = t / n_split, js = t % n_split;
+        const size_t ic = ib * mc_max, mc = std::min(mc_max, m - ic);
+        for (size_t panel = n_panels * js / n_split;
+             panel < n_panels * (js + 1) / n_split; ++panel) {
+          const size_t jr = panel * nr, cols = std::min(nr, nc - jr);
+          const uint8_t* bp = pb + panel * nr * k4;
+          for (size_t ir = 0; ir < mc; ir += mr) {
+            const size_t rows = std::min(mr, mc - ir);
+            kern.fn(k4 / 4, a.data.data() + (ic + ir) * k4, bp, tile);
+            dequantize_tile(a, tile, nr, rows, cols, ic + ir, jc + jr,
+                            b_params, epilogue,
+                            c + (ic + ir) * ldc + jc + jr, ldc);
+          }
+        }
+      }
+    });
+  }
+}
+
+/**
+ * @brief Lower one quantized image (or group) to the 8-bit im2col matrix.
+ *
+ * Same layout as the float im2col of Conv2d; padded taps hold @p pad, the
+ * code of zero.
+ */
+static void im2col_u8(const uint8_t* in, size_t channels, size_t h, size_t w,
+                      size_t kh, size_t kw, size_t oh, size_t ow,
+                      const Conv2dParams& p, uint8_t pad, uint8_t* col) {
+  parallel_for(0, channels * kh * kw, 4, [&](size_t first, size_t last) {
+    for (size_t r = first; r < last; ++r) {
+      const size_t c = r / (kh * kw), y = r / kw % kh, x = r % kw;
+      const uint8_t* plane = in + c * h * w;
+      uint8_t* dst = col + r * oh * ow;
+      for (size_t oy = 0; oy < oh; ++oy, dst += ow) {
+        const ptrdiff_t iy = ptrdiff_t(oy * p.stride_h + y * p.dilation_h) -
+                             ptrdiff_t(p.pad_top);
+        if (iy < 0 || iy >= ptrdiff_t(h)) {
+          std::fill(dst, dst + ow, pad);
+          continue;
+        }
+        const uint8_t* row = plane + size_t(iy) * w;
+        const ptrdiff_t ix0 =
+            ptrdiff_t(x * p.dilation_w) - ptrdiff_t(p.pad_left);
+        for (size_t ox = 0; ox < ow; ++ox) {
+          const ptrdiff_t ix = ix0 + ptrdiff_t(ox * p.stride_w);
+          dst[ox] = ix < 0 || ix >= ptrdiff_t(w) ? pad : row[ix];
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Quantize a convolution layer.
+ */
+QConv2d::QConv2d(const Tensor<float>& weight, const Tensor<float>& bias,
+                 const Conv2dParams& params, const QuantParams& input)
+    : params_(params), input_(input), bias_(bias) {
+  if (weight.rank() != 4)
+    throw std::invalid_argument(
+        "QConv2d: weight must be [C_out, C_in, KH, KW]");
+  const size_t groups = params.groups;
+  out_channels_ = weight.dim(0);
+  in_channels_ = weight.dim(1) * groups;
+  kernel_h_ = weight.dim(2);
+  kernel_w_ = weight.dim(3);
+  if (groups == 0 || out_channels_ % groups != 0 || in_channels_ == 0)
+    throw std::invalid_argument("QConv2d: C_out must be divisible by groups");
+  if (kernel_h_ == 0 || kernel_w_ == 0 || params.stride_h == 0 ||
+      params.stride_w == 0 || params.dilation_h == 0 || params.dilation_w == 0)
+    throw std::invalid_argument("QConv2d: kernel, stride and dilation > 0");
+  if (!bias.empty() && bias.shape() != Shape{out_channels_})
+    throw std::invalid_argument("QConv2d: bias must be [C_out]");
+  if (!(input.scale > 0.f) || input.zero_point < 0 || input.zero_point > 255)
+    throw std::invalid_argument("QConv2d: invalid input quantization");
+  const size_t og = out_channels_ / groups;
+  const size_t k = weight.dim(1) * kernel_h_ * kernel_w_;
+  weights_.reserve(groups);
+  for (size_t g = 0; g < groups; ++g)
+    weights_.push_back(
+        qgemm_quantize_a(og, k, weight.data() + g * og * k, k));
+}
+
+/**
+ * @brief Compute the output shape for an input shape.
+ */
+Shape QConv2d::outputShape(const Shape& input) const {
+  if (input.rank() != 4 || input[1] != in_channels_)
+    throw std::invalid_argument("QConv2d: input shape does not match layer");
+  const size_t oh =
+      conv_output_size(input[2], kernel_h_, params_.stride_h, params_.pad_top,
+                       params_.pad_bottom, params_.dilation_h);
+  const size_t ow =
+      conv_output_size(input[3], kernel_w_, params_.stride_w, params_.pad_left,
+                       params_.pad_right, params_.dilation_w);
+  if (oh == 0 || ow == 0)
+    throw std::invalid_argument("QConv2d: kernel larger than padded input");
+  return Shape{input[0], out_channels_, oh, ow};
+}
+
+/**
+ * @brief Run the convolution.
+ */
+void QConv2d::forward(const Tensor<float>& input, Tensor<float>& output,
+                      const ConvEpilogue& epilogue) const {
+  if (output.shape() != outputShape(input.shape()))
+    throw std::invalid_argument("QConv2d: output shape mismatch");
+  if (epilogue.residual && epilogue.residual->shape() != output.shape())
+    throw std::invalid_argument("QConv2d: residual shape mismatch");
+  const Conv2dParams& p = params_;
+  const size_t n = input.dim(0), h = input.dim(2), w = input.dim(3);
+  const size_t pixels = output.dim(2) * output.dim(3);
+  const size_t groups = p.groups, ig = in_channels_ / groups;
+  const size_t og = out_channels_ / groups;
+  const bool pointwise = kernel_h_ == 1 && kernel_w_ == 1 && p.stride_h == 1 &&
+                         p.stride_w == 1 &&
+                         p.pad_top + p.pad_left + p.pad_bottom + p.pad_right ==
+                             0;
+
+  ScratchScope scope;  // the codes and im2col matrix outlive the GEMMs
+  uint8_t* qin = byte_buffer(1, input.numel());
+  parallel_for(0, input.numel(), size_t(1) << 14,
+               [&](size_t first, size_t last) {
+                 quantize_u8(input.data() + first, last - first, input_,
+                             qin + first);
+               });
+  uint8_t* col = pointwise
+                     ? nullptr
+                     : byte_buffer(2, ig * kernel_h_ * kernel_w_ * pixels);
+  const float* res = epilogue.residual ? epilogue.residual->data() : nullptr;
+  const float* bias = bias_.empty() ? nullptr : bias_.data();
+  for (size_t b = 0; b < n; ++b) {
+    for (size_t g = 0; g < groups; ++g) {
+      const uint8_t* x = qin + (b * in_channels_ + g * ig) * h * w;
+      const size_t at = (b * out_channels_ + g * og) * pixels;
+      if (col) {
+        im2col_u8(x, ig, h, w, kernel_h_, kernel_w_, output.dim(2),
+                  output.dim(3), p, uint8_t(input_.zero_point), col);
+        x = col;
+      }
+      GemmEpilogue tail;
+      tail.row_bias = bias ? bias + g * og : nullptr;
+      tail.residual = res ? res + at : nullptr;
+      tail.ldr = pixels;
+      tail.clamp_min = epilogue.clamp_min;
+      tail.clamp_max = epilogue.clamp_max;
+      qgemm(weights_[g], false, pixels, x, pixels, input_,
+            output.data() + at, pixels, tail);
+    }
+  }
+}
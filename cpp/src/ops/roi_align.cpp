@@ -0,0 +1,252 @@
+#include "ops/roi_align.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Bilinear sampling position along one axis.
+ *
+ * A sample interpolates between feature rows (or columns) @p lo and @p hi with
+ * weights @p w_lo and @p w_hi. Samples falling outside the feature map
+ * contribute zero but still count towards the bin average.
+ */
+struct AxisSample {
+  size_t lo = 0;     /**< Lower neighbour index */
+  size_t hi = 0;     /**< Upper neighbour index */
+  float w_lo = 0.f;  /**< Weight of the lower neighbour */
+  float w_hi = 0.f;  /**< Weight of the upper neighbour */
+  bool valid = false; /**< Whether the sample lies on the feature map */
+};
+
+/**
+ * @brief Accumulate a weighted sum of four channel vectors into @p out.
+ *
+ * Computes `out[c] += w[0] * p[0][c] + ... + w[3] * p[3][c]` for every channel.
+ */
+using AccumulateFn = void (*)(float* out, const float* const p[4],
+                              const float w[4], size_t channels);
+
+/**
+ * @brief Portable implementation of the four-corner accumulation.
+ */
+static void accumulate_scalar(float* out, const float* const p[4],
+                              const float w[4], size_t channels) {
+  for (size_t c = 0; c < channels; ++c)
+    out[c] += w[0] * p[0][c] + w[1] * p[1][c] + w[2] * p[2][c] + w[3] * p[3][c];
+}
+
+#if defined(VF_X86)
+/**
+ * @brief AVX2/FMA implementation of the four-corner accumulation.
+ */
+VF_TARGET("avx2,fma")
+static void accumulate_avx2(float* out, const float* const p[4],
+                            const float w[4], size_t channels) {
+  const __m256 w0 = _mm256_set1_ps(w[0]);
+  const __m256 w1 = _mm256_set1_ps(w[1]);
+  const __m256 w2 = _mm256_set1_ps(w[2]);
+  const __m256 w3 = _mm256_set1_ps(w[3]);
+  size_t c = 0;
+  for (; c + 8 <= channels; c += 8) {
+    __m256 acc = _mm256_loadu_ps(out + c);
+    acc = _mm256_fmadd_ps(w0, _mm256_loadu_ps(p[0] + c), acc);
+    acc = _mm256_fmadd_ps(w1, _mm256_loadu_ps(p[1] + c), acc);
+    acc = _mm256_fmadd_ps(w2, _mm256_loadu_ps(p[2] + c), acc);
+    acc = _mm256_fmadd_ps(w3, _mm256_loadu_ps(p[3] + c), acc);
+    _mm256_storeu_ps(out + c, acc);
+  }
+  for (; c < channels; ++c)
+    out[c] += w[0] * p[0][c] + w[1] * p[1][c] + w[2] * p[2][c] + w[3] * p[3][c];
+}
+
+/**
+ * @brief AVX-512 implementation of the four-corner accumulation.
+ *
+ * The channel tail is handled with masked loads and stores.
+ */
+VF_TARGET("avx512f")
+static void accumulate_avx512(float* out, const float* const p[4],
+                              const float w[4], size_t channels) {
+  const __m512 w0 = _mm512_set1_ps(w[0]);
+  const __m512 w1 = _mm512_set1_ps(w[1]);
+  const __m512 w2 = _mm512_set1_ps(w[2]);
+  const __m512 w3 = _mm512_set1_ps(w[3]);
+  for (size_t c = 0; c < channels; c += 16) {
+    const size_t rem = channels - c;
+    const __mmask16 m =
+        rem >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << rem) - 1);
+    __m512 acc = _mm512_maskz_loadu_ps(m, out + c);
+    acc = _mm512_fmadd_ps(w0, _mm512_maskz_loadu_ps(m, p[0] + c), acc);
+    acc = _mm512_fmadd_ps(w1, _mm512_maskz_loadu_ps(m, p[1] + c), acc);
+    acc = _mm512_fmadd_ps(w2, _mm512_maskz_loadu_ps(m, p[2] + c), acc);
+    acc = _mm512_fmadd_ps(w3, _mm512_maskz_loadu_ps(m, p[3] + c), acc);
+    _mm512_mask_storeu_ps(out + c, m, acc);
+  }
+}
+#endif
+
+/**
+ * @brief Select the fastest accumulation kernel supported by the CPU.
+ *
+ * @return Pointer to the selected kernel.
+ */
+static AccumulateFn select_accumulate() {
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512f) return accumulate_avx512;
+  if (cpu.avx2 && cpu.fma) return accumulate_avx2;
+#endif
+  return accumulate_scalar;
+}
+
+/**
+ * @brief Compute the bilinear sampling positions for one axis of a ROI.
+ *
+ * Produces `bins * grid` samples, the samples of bin `b` being stored at
+ * `[b * grid, (b + 1) * grid)`.
+ *
+ * @param start ROI start coordinate on the feature map.
+ * @param bin_size Extent of one bin.
+ * @param bins Number of output bins.
+ * @param grid Number of samples per bin.
+ * @param extent Size of the feature map along this axis.
+ * @param samples Receives the sampling positions.
+ */
+static void compute_axis_samples(float start, float bin_size, size_t bins,
+                                 size_t grid, size_t extent,
+                                 std::vector<AxisSample>& samples) {
+  samples.resize(bins * grid);
+  for (size_t b = 0; b < bins; ++b) {
+    for (size_t g = 0; g < grid; ++g) {
+      AxisSample& s = samples[b * grid + g];
+      float v = start + static_cast<float>(b) * bin_size +
+                (static_cast<float>(g) + .5f) * bin_size /
+                    static_cast<float>(grid);
+      s = AxisSample{};
+      if (v < -1.f || v > static_cast<float>(extent)) continue;
+      if (v <= 0.f) v = 0.f;
+      size_t lo = static_cast<size_t>(v);
+      size_t hi;
+      if (lo >= extent - 1) {
+        hi = lo = extent - 1;
+        v = static_cast<float>(lo);
+      } else {
+        hi = lo + 1;
+      }
+      const float l = v - static_cast<float>(lo);
+      s = AxisSample{lo, hi, 1.f - l, l, true};
+    }
+  }
+}
+
+/**
+ * @brief Pool fixed-size features for each region of interest (ROIAlign).
+ */
+void roi_align(const Tensor<float>& input, const Tensor<float>& rois,
+               Tensor<float>& output, const RoiAlignParams& params) {
+  if (input.rank() != 4)
+    throw std::invalid_argument("roi_align: input must be NHWC");
+  if (rois.rank() != 2 || rois.dim(1) != 5)
+    throw std::invalid_argument("roi_align: rois must have shape [R, 5]");
+  const size_t batch = input.dim(0), height = input.dim(1);
+  const size_t width = input.dim(2), channels = input.dim(3);
+  const size_t num_rois = rois.dim(0);
+  const size_t ph = params.pooled_height, pw = params.pooled_width;
+  if (output.shape() != Shape{num_rois, ph, pw, channels})
+    throw std::invalid_argument("roi_align: output shape mismatch");
+  if (num_rois == 0 || channels == 0) return;
+  if (height == 0 || width == 0) {
+    output.fill(0.f);
+    return;
+  }
+
+  const AccumulateFn accumulate = select_accumulate();
+  const float offset = params.aligned ? .5f : 0.f;
+  const float* in = input.data();
+  const float* roi_data = rois.data();
+  float* out = output.data();
+  const size_t bin_stride = channels;
+
+  parallel_for(0, num_rois, 1, [&](size_t first, size_t last) {
+    std::vector<AxisSample> ys, xs;
+    for (size_t r = first; r < last; ++r) {
+      const float* roi = roi_data + r * 5;
+      float* roi_out = out + r * ph * pw * bin_stride;
+      std::fill(roi_out, roi_out + ph * pw * bin_stride, 0.f);
+
+      const auto b = static_cast<long long>(roi[0]);
+      if (b < 0 || static_cast<size_t>(b) >= batch) continue;
+
+      const float x1 = roi[1] * params.spatial_scale - offset;
+      const float y1 = roi[2] * params.spatial_scale - offset;
+      float roi_w = roi[3] * params.spatial_scale - offset - x1;
+      float roi_h = roi[4] * params.spatial_scale - offset - y1;
+      if (!params.aligned) {
+        roi_w = std::max(roi_w, 1.f);
+        roi_h = std::max(roi_h, 1.f);
+      }
+      const float bin_h = roi_h / static_cast<float>(ph);
+      const float bin_w = roi_w / static_cast<float>(pw);
+      const size_t grid_h =
+          params.sampling_ratio > 0
+              ? static_cast<size_t>(params.sampling_ratio)
+              : static_cast<size_t>(std::max(std::ceil(bin_h), 0.f));
+      const size_t grid_w =
+          params.sampling_ratio > 0
+              ? static_cast<size_t>(params.sampling_ratio)
+              : static_cast<size_t>(std::max(std::ceil(bin_w), 0.f));
+      const size_t count = std::max<size_t>(grid_h * grid_w, 1);
+      const float inv_count = 1.f / static_cast<float>(count);
+
+      compute_axis_samples(y1, bin_h, ph, grid_h, height, ys);
+      compute_axis_samples(x1, bin_w, pw, grid_w, width, xs);
+
+      const float* image = in + static_cast<size_t>(b) * height * width *
+                                    channels;
+      for (size_t py = 0; py < ph; ++py) {
+        for (size_t px = 0; px < pw; ++px) {
+          float* bin = roi_out + (py * pw + px) * bin_stride;
+          for (size_t gy = 0; gy < grid_h; ++gy) {
+            const AxisSample& sy = ys[py * grid_h + gy];
+            if (!sy.valid) continue;
+            const float* row_lo = image + sy.lo * width * channels;
+            const float* row_hi = image + sy.hi * width * channels;
+            for (size_t gx = 0; gx < grid_w; ++gx) {
+              const AxisSample& sx = xs[px * grid_w + gx];
+              if (!sx.valid) continue;
+              const float* corners[4] = {
+                  row_lo + sx.lo * channels, row_lo + sx.hi * channels,
+                  row_hi + sx.lo * channels, row_hi + sx.hi * channels};
+              const float weights[4] = {sy.w_lo * sx.w_lo, sy.w_lo * sx.w_hi,
+                                        sy.w_hi * sx.w_lo, sy.w_hi * sx.w_hi};
+              accumulate(bin, corners, weights, channels);
+            }
+          }
+          for (size_t c = 0; c < channels; ++c) bin[c] *= inv_count;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Pool fixed-size features for each region of interest (ROIAlign).
+ */
+Tensor<float> roi_align(const Tensor<float>& input, const Tensor<float>& rois,
+                        const RoiAlignParams& params) {
+  if (input.rank() != 4 || rois.rank() != 2)
+    throw std::invalid_argument("roi_align: expected NHWC input and [R, 5]");
+  Tensor<float> output(Shape{rois.dim(0), params.pooled_height,
+                             params.pooled_width, input.dim(3)});
+  roi_align(input, rois, output, params);
+  return output;
+}
@@ -0,0 +1,217 @@
+#include "ops/winograd.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils/parallel.h"
+#include "utils/scratch.h"
+
+/** Output tile edge of F(4x4, 3x3). */
+static constexpr size_t kOutTile = 4;
+
+/** Input tile edge of F(4x4, 3x3). */
+static constexpr size_t kInTile = 6;
+
+/** Number of transformed-domain positions (6 x 6). */
+static constexpr size_t kPositions = kInTile * kInTile;
+
+/** Workspace budget in floats for one block of tiles (8 MiB). */
+static constexpr size_t kWorkspaceFloats = size_t(2) << 20;
+
+/**
+ * @brief Get a per-thread 64-byte aligned scratch buffer of @p n floats.
+ */
+static float* scratch(size_t n) {
+  thread_local ScratchBuffers<float> buffers;
+  return buffers.get(0, n);
+}
+
+/**
+ * @brief Apply B^T to six values read with stride @p ds.
+ */
+static inline void input_1d(const float* d, size_t ds, float* t, size_t ts) {
+  const float d0 = d[0], d1 = d[ds], d2 = d[2 * ds], d3 = d[3 * ds];
+  const float d4 = d[4 * ds], d5 = d[5 * ds];
+  const float a = d4 - 4.f * d2, b = d3 - 4.f * d1;
+  const float c = d4 - d2, e = 2.f * (d3 - d1);
+  t[0] = 4.f * d0 - 5.f * d2 + d4;
+  t[ts] = a + b;
+  t[2 * ts] = a - b;
+  t[3 * ts] = c + e;
+  t[4 * ts] = c - e;
+  t[5 * ts] = 4.f * d1 - 5.f * d3 + d5;
+}
+
+/**
+ * @brief Apply A^T to six values read with stride @p ms.
+ */
+static inline void output_1d(const float* m, size_t ms, float* o, size_t os) {
+  const float a = m[ms] + m[2 * ms], b = m[ms] - m[2 * ms];
+  const float c = m[3 * ms] + m[4 * ms], d = m[3 * ms] - m[4 * ms];
+  o[0] = m[0] + a + c;
+  o[os] = b + 2.f * d;
+  o[2 * os] = a + 4.f * c;
+  o[3 * os] = b + 8.f * d + m[5 * ms];
+}
+
+/**
+ * @brief Check whether a convolution can use Winograd F(4x4, 3x3).
+ */
+bool winograd_supported(const Conv2dParams& params, size_t kernel_h,
+                        size_t kernel_w) {
+  return kernel_h == 3 && kernel_w == 3 && params.stride_h == 1 &&
+         params.stride_w == 1 && params.dilation_h == 1 &&
+         params.dilation_w == 1 && params.groups == 1;
+}
+
+/**
+ * @brief Check whether Winograd F(4x4, 3x3) is expected to beat im2col.
+ */
+bool winograd_profitable(const Conv2dParams& params, size_t in_channels,
+                         size_t out_channels, size_t kernel_h,
+                         size_t kernel_w) {
+  return winograd_supported(params, kernel_h, kernel_w) && in_channels >= 32 &&
+         out_channels >= 32;
+}
+
+/**
+ * @brief Transform 3x3 filters into the Winograd domain.
+ */
+std::vector<GemmPackedA> winograd_transform_weights(
+    const Tensor<float>& weight) {
+  if (weight.rank() != 4 || weight.dim(2) != 3 || weight.dim(3) != 3)
+    throw std::invalid_argument("winograd: weight must be [C_out, C_in, 3, 3]");
+  static const float kG[kInTile][3] = {
+      {1.f / 4, 0.f, 0.f},           {-1.f / 6, -1.f / 6, -1.f / 6},
+      {-1.f / 6, 1.f / 6, -1.f / 6}, {1.f / 24, 1.f / 12, 1.f / 6},
+      {1.f / 24, -1.f / 12, 1.f / 6}, {0.f, 0.f, 1.f}};
+  const size_t co = weight.dim(0), ci = weight.dim(1);
+  // [36, C_out, C_in], one GEMM operand per transformed position.
+  Tensor<float> u(Shape{kPositions, co, ci});
+  parallel_for(0, co * ci, 64, [&](size_t first, size_t last) {
+    for (size_t f = first; f < last; ++f) {
+      const float* g = weight.data() + f * 9;
+      float t[kInTile][3];
+      for (size_t i = 0; i < kInTile; ++i)
+        for (size_t j = 0; j < 3; ++j)
+          t[i][j] = kG[i][0] * g[j] + kG[i][1] * g[3 + j] +
+                    kG[i][2] * g[6 + j];
+      for (size_t i = 0; i < kInTile; ++i)
+        for (size_t j = 0; j < kInTile; ++j)
+          u[(i * kInTile + j) * co * ci + f] =
+              t[i][0] * kG[j][0] + t[i][1] * kG[j][1] + t[i][2] * kG[j][2];
+    }
+  });
+  std::vector<GemmPackedA> packed;
+  packed.reserve(kPositions);
+  for (size_t p = 0; p < kPositions; ++p)
+    packed.push_back(sgemm_pack_a(false, co, ci, 1.f, u.data() + p * co * ci,
+                                  ci));
+  return packed;
+}
+
+/**
+ * @brief Run a stride-1 3x3 convolution with Winograd F(4x4, 3x3).
+ */
+void winograd_conv(const std::vector<GemmPackedA>& weights, const float* bias,
+                   const Conv2dParams& params, const Tensor<float>& input,
+                   Tensor<float>& output, const ConvEpilogue& epilogue) {
+  if (weights.size() != kPositions || input.rank() != 4 ||
+      output.rank() != 4)
+    throw std::invalid_argument("winograd: expected NCHW tensors");
+  const size_t n = input.dim(0), ci = input.dim(1);
+  const size_t h = input.dim(2), w = input.dim(3);
+  const size_t co = output.dim(1), oh = output.dim(2), ow = output.dim(3);
+  if (weights[0].k != ci || weights[0].m != co || output.dim(0) != n ||
+      oh != conv_output_size(h, 3, 1, params.pad_top, params.pad_bottom, 1) ||
+      ow != conv_output_size(w, 3, 1, params.pad_left, params.pad_right, 1) ||
+      oh == 0 || ow == 0 ||
+      (epilogue.residual && epilogue.residual->shape() != output.shape()))
+    throw std::invalid_argument("winograd: shape mismatch");
+
+  const size_t tiles_w = (ow + kOutTile - 1) / kOutTile;
+  const size_t per_image = (oh + kOutTile - 1) / kOutTile * tiles_w;
+  const size_t total = n * per_image;
+  const size_t block = std::min(
+      total, std::max<size_t>(16, kWorkspaceFloats / (kPositions * (ci + co))));
+  ScratchScope scope;  // the transforms stay in use across parallel_for()
+  float* v = scratch(kPositions * (ci + co) * block);
+  float* m = v + kPositions * ci * block;
+  const float* in = input.data();
+  const float* res = epilogue.residual ? epilogue.residual->data() : nullptr;
+  const float lo = epilogue.clamp_min, hi = epilogue.clamp_max;
+  float* out = output.data();
+
+  for (size_t t0 = 0; t0 < total; t0 += block) {
+    const size_t count = std::min(block, total - t0);
+
+    // V[p] = B^T d B, stored as 36 [C_in, count] matrices.
+    parallel_for(0, ci * count, 16, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        const size_t c = i / count, t = i % count, tile = t0 + t;
+        const size_t b = tile / per_image, r = tile % per_image;
+        const ptrdiff_t y0 =
+            ptrdiff_t(r / tiles_w * kOutTile) - ptrdiff_t(params.pad_top);
+        const ptrdiff_t x0 =
+            ptrdiff_t(r % tiles_w * kOutTile) - ptrdiff_t(params.pad_left);
+        const float* plane = in + (b * ci + c) * h * w;
+        float d[kPositions], tmp[kPositions], vt[kPositions];
+        if (y0 >= 0 && x0 >= 0 && size_t(y0) + kInTile <= h &&
+            size_t(x0) + kInTile <= w) {
+          for (size_t y = 0; y < kInTile; ++y)
+            std::copy_n(plane + (size_t(y0) + y) * w + size_t(x0), kInTile,
+                        d + y * kInTile);
+        } else {
+          for (size_t y = 0; y < kInTile; ++y)
+            for (size_t x = 0; x < kInTile; ++x) {
+              const ptrdiff_t iy = y0 + ptrdiff_t(y), ix = x0 + ptrdiff_t(x);
+              d[y * kInTile + x] =
+                  iy >= 0 && ix >= 0 && iy < ptrdiff_t(h) && ix < ptrdiff_t(w)
+                      ? plane[size_t(iy) * w + size_t(ix)]
+                      : 0.f;
+            }
+        }
+        for (size_t x = 0; x < kInTile; ++x)
+          input_1d(d + x, kInTile, tmp + x, kInTile);
+        for (size_t y = 0; y < kInTile; ++y)
+          input_1d(tmp + y * kInTile, 1, vt + y * kInTile, 1);
+        for (size_t p = 0; p < kPositions; ++p)
+          v[(p * ci + c) * count + t] = vt[p];
+      }
+    });
+
+    // M[p] = U[p] * V[p]: 36 independent GEMMs run as one batch.
+    parallel_for(0, kPositions, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; ++p)
+        sgemm_packed(weights[p], false, count, v + p * ci * count, count, 0.f,
+                     m + p * co * count, count);
+    });
+
+    // Y = A^T M A, cropped to the output, plus bias, residual and clamp.
+    parallel_for(0, co * count, 16, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        const size_t o = i / count, t = i % count, tile = t0 + t;
+        const size_t b = tile / per_image, r = tile % per_image;
+        const size_t y0 = r / tiles_w * kOutTile, x0 = r % tiles_w * kOutTile;
+        float mt[kPositions], tmp[kOutTile * kInTile], y[kOutTile * kOutTile];
+        for (size_t p = 0; p < kPositions; ++p)
+          mt[p] = m[(p * co + o) * count + t];
+        for (size_t x = 0; x < kInTile; ++x)
+          output_1d(mt + x, kInTile, tmp + x, kInTile);
+        for (size_t r4 = 0; r4 < kOutTile; ++r4)
+          output_1d(tmp + r4 * kInTile, 1, y + r4 * kOutTile, 1);
+        const float add = bias ? bias[o] : 0.f;
+        const size_t rows = std::min(kOutTile, oh - y0);
+        const size_t cols = std::min(kOutTile, ow - x0);
+        const size_t at = ((b * co + o) * oh + y0) * ow + x0;
+        float* dst = out + at;
+        for (size_t yy = 0; yy < rows; ++yy)
+          for (size_t xx = 0; xx < cols; ++xx) {
+            float v = y[yy * kOutTile + xx] + add;
+            if (res) v += res[at + yy * ow + xx];
+            dst[yy * ow + xx] = std::min(std::max(v, lo), hi);
+          }
+      }
+    });
+  }
+}
@@ -0,0 +1,342 @@
+#include "runtime/autotune.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "utils/parallel.h"
+
+/** Algorithms in the order they are stored and tried. */
+static constexpr ConvAlgorithm kAlgorithms[] = {
+    ConvAlgorithm::kGemm, ConvAlgorithm::kIm2col, ConvAlgorithm::kDirect,
+    ConvAlgorithm::kDepthwise, ConvAlgorithm::kWinograd};
+
+/**
+ * @brief Get the name of a convolution algorithm.
+ */
+const char* conv_algorithm_name(ConvAlgorithm algorithm) {
+  switch (algorithm) {
+    case ConvAlgorithm::kGemm:
+      return "gemm";
+    case ConvAlgorithm::kIm2col:
+      return "im2col";
+    case ConvAlgorithm::kDirect:
+      return "direct";
+    case ConvAlgorithm::kDepthwise:
+      return "depthwise";
+    case ConvAlgorithm::kWinograd:
+      return "winograd";
+    default:
+      return "auto";
+  }
+}
+
+/**
+ * @brief Parse an algorithm name written by conv_algorithm_name().
+ *
+ * @return true if the name is known.
+ */
+static bool parse_algorithm(const std::string& name, ConvAlgorithm& out) {
+  for (ConvAlgorithm algorithm : kAlgorithms) {
+    if (name == conv_algorithm_name(algorithm)) {
+      out = algorithm;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Read the lines of a database file (none if it does not exist).
+ */
+static std::vector<std::string> read_lines(const std::string& path) {
+  std::vector<std::string> lines;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line);) lines.push_back(line);
+  return lines;
+}
+
+/**
+ * @brief Get the CPU model named by a section line, or null otherwise.
+ */
+static const char* section_cpu(const std::string& line) {
+  return line.rfind("cpu ", 0) == 0 ? line.c_str() + 4 : nullptr;
+}
+
+/**
+ * @brief Open a database, reading the section of the CPU if the file exists.
+ */
+TuningDatabase::TuningDatabase(std::string path, std::string cpu)
+    : path_(std::move(path)), cpu_(std::move(cpu)) {
+  if (path_.empty()) return;
+  const std::vector<std::string> lines = read_lines(path_);
+  bool ours = false;
+  for (size_t n = 0; n < lines.size(); ++n) {
+    const std::string& line = lines[n];
+    if (line.empty() || line[0] == '#') continue;
+    if (const char* model = section_cpu(line)) {
+      ours = cpu_ == model;
+      continue;
+    }
+    if (!ours) continue;
+    std::istringstream fields(line);
+    std::string kind, key, name;
+    fields >> kind;
+    bool valid = false;
+    if (kind == "gemm") {
+      GemmBlocking blocking;
+      valid = bool(fields >> blocking.mc >> blocking.nc) && blocking.mc &&
+              blocking.nc;
+      if (valid) gemm_ = blocking;
+    } else if (kind == "conv") {
+      ConvTuning tuning;
+      valid = fields >> key >> name >> tuning.threads >> tuning.micros &&
+              parse_algorithm(name, tuning.algorithm);
+      if (valid) convs_[key] = tuning;
+    }
+    if (!valid)
+      throw std::runtime_error("TuningDatabase: malformed line " +
+                               std::to_string(n + 1) + " of " + path_);
+  }
+}
+
+/**
+ * @brief Get the tuning of a convolution shape.
+ */
+const ConvTuning* TuningDatabase::findConv(const std::string& key) const {
+  const auto it = convs_.find(key);
+  return it == convs_.end() ? nullptr : &it->second;
+}
+
+/**
+ * @brief Record the tuning of a convolution shape.
+ */
+void TuningDatabase::setConv(const std::string& key,
+                             const ConvTuning& tuning) {
+  if (key.empty() || key.find_first_of(" \t\n") != std::string::npos)
+    throw std::invalid_argument("TuningDatabase: invalid key");
+  convs_[key] = tuning;
+}
+
+/**
+ * @brief Write the entries back to the backing file.
+ */
+void TuningDatabase::save() const {
+  if (path_.empty())
+    throw std::runtime_error("TuningDatabase: no file to save to");
+  // Keep the sections of other CPU models as they are.
+  std::vector<std::string> kept;
+  bool ours = false;
+  for (const std::string& line : read_lines(path_)) {
+    if (const char* model = section_cpu(line)) ours = cpu_ == model;
+    if (!ours && line.rfind("# vision-foundry", 0) != 0) kept.push_back(line);
+  }
+
+  const std::string tmp = path_ + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out) throw std::runtime_error("TuningDatabase: cannot create " + tmp);
+    out << "# vision-foundry tuning database\n";
+    for (const std::string& line : kept) out << line << '\n';
+    out << "cpu " << cpu_ << '\n';
+    if (gemm_) out << "gemm " << gemm_->mc << ' ' << gemm_->nc << '\n';
+    for (const auto& [key, tuning] : convs_)
+      out << "conv " << key << ' ' << conv_algorithm_name(tuning.algorithm)
+          << ' ' << tuning.threads << ' ' << tuning.micros << '\n';
+    if (!out) throw std::runtime_error("TuningDatabase: cannot write " + tmp);
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path_, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    throw std::runtime_error("TuningDatabase: cannot replace " + path_);
+  }
+}
+
+/**
+ * @brief Build the tuning key of a convolution node for an input shape.
+ */
+std::string conv_tuning_key(const Conv2dOp& op, const Shape& input) {
+  const Conv2d& conv = op.conv();
+  const Conv2dParams& p = conv.params();
+  std::ostringstream key;
+  const auto dims = [&key](const char* tag, auto first, auto... rest) {
+    key << tag << first;
+    ((key << 'x' << rest), ...);
+  };
+  key << (conv.layout() == ConvLayout::kNchw ? "nchw:i" : "nchwc:i");
+  for (size_t d = 0; d < input.rank(); ++d) key << (d ? "x" : "") << input[d];
+  key << ":o" << conv.outChannels();
+  dims(":k", op.weight().dim(2), op.weight().dim(3));
+  dims(":s", p.stride_h, p.stride_w);
+  dims(":p", p.pad_top, p.pad_left, p.pad_bottom, p.pad_right);
+  dims(":d", p.dilation_h, p.dilation_w);
+  key << ":g" << p.groups;
+  return key.str();
+}
+
+/**
+ * @brief Fill a tensor with uniform random values in [-1, 1].
+ */
+static Tensor<float> random_tensor(const Shape& shape, std::mt19937& rng) {
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  Tensor<float> t(shape);
+  for (size_t i = 0; i < t.numel(); ++i) t[i] = dist(rng);
+  return t;
+}
+
+/**
+ * @brief Time the fastest of @p repeats calls after one warm-up call.
+ *
+ * @return Latency in microseconds.
+ */
+template <typename Function>
+static double fastest_us(size_t repeats, Function&& fn) {
+  fn();
+  double best = std::numeric_limits<double>::infinity();
+  for (size_t r = 0; r < repeats; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+/**
+ * @brief Pick the fastest GEMM blocking on an im2col-sized product.
+ */
+static GemmBlocking tune_gemm(size_t repeats, std::mt19937& rng) {
+  constexpr size_t m = 128, n = 3136, k = 576;  // 3x3x64 -> 128 on 56x56
+  const Tensor<float> a = random_tensor(Shape{m, k}, rng);
+  const Tensor<float> b = random_tensor(Shape{k, n}, rng);
+  Tensor<float> c(Shape{m, n});
+  GemmBlocking best;
+  double best_us = std::numeric_limits<double>::infinity();
+  for (size_t mc : {72u, 144u, 288u}) {
+    for (size_t nc : {1536u, 3072u, 6144u}) {
+      GemmBlockingScope scope({mc, nc});
+      const double us = fastest_us(repeats, [&] {
+        sgemm(false, false, m, n, k, 1.f, a.data(), k, b.data(), n, 0.f,
+              c.data(), n);
+      });
+      if (us < best_us) {
+        best_us = us;
+        best = {mc, nc};
+      }
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Benchmark candidate configurations and record the fastest.
+ */
+size_t autotune(const Graph& graph, const std::vector<Shape>& input_shapes,
+                TuningDatabase& db, const AutotuneOptions& options) {
+  if (options.repeats == 0)
+    throw std::invalid_argument("autotune: repeats must be positive");
+  const size_t limit = num_threads();
+  std::vector<size_t> thread_counts = options.thread_counts;
+  if (thread_counts.empty()) {
+    for (size_t t = 1; t < limit; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(limit);
+  }
+  if (std::count(thread_counts.begin(), thread_counts.end(), 0u))
+    throw std::invalid_argument("autotune: thread counts must be positive");
+  const std::vector<Shape> shapes = graph.inferShapes(input_shapes);
+  std::mt19937 rng(1);
+  size_t tuned = 0;
+  if (options.tune_gemm && (!db.gemm() || options.retune))
+    db.setGemm(tune_gemm(options.repeats, rng));
+  // Layers are timed with the blocking their plans will run with.
+  std::optional<GemmBlockingScope> blocking;
+  if (db.gemm()) blocking.emplace(*db.gemm());
+
+  std::set<std::string> seen;
+  for (const Node& node : graph.nodes()) {
+    const auto* conv = dynamic_cast<const Conv2dOp*>(node.op.get());
+    if (!conv) continue;
+    const Shape& in_shape = shapes[node.inputs[0]];
+    const std::string key = conv_tuning_key(*conv, in_shape);
+    if (!seen.insert(key).second) continue;
+    if (db.findConv(key) && !options.retune) continue;
+
+    const Tensor<float> input = random_tensor(in_shape, rng);
+    const Tensor<float> residual =
+        conv->hasResidual() ? random_tensor(shapes[node.output], rng)
+                            : Tensor<float>();
+    const Tensor<float>* args[] = {&input, &residual};
+    const std::span<const Tensor<float>* const> used(
+        args, conv->hasResidual() ? 2 : 1);
+    Tensor<float> output(shapes[node.output]);
+    ConvTuning best;
+    best.micros = std::numeric_limits<double>::infinity();
+    for (ConvAlgorithm algorithm : kAlgorithms) {
+      std::shared_ptr<Conv2dOp> candidate;
+      try {
+        candidate = conv->withAlgorithm(algorithm);
+      } catch (const std::invalid_argument&) {
+        continue;  // not applicable to this layer
+      }
+      for (size_t threads : thread_counts) {
+        ThreadLimitScope scope(threads);
+        const double us = fastest_us(
+            options.repeats, [&] { candidate->forward(used, output); });
+        if (us < best.micros) best = {algorithm, threads, us};
+      }
+    }
+    db.setConv(key, best);
+    ++tuned;
+  }
+  return tuned;
+}
+
+/**
+ * @brief Specialize a graph for input shapes using tuned configurations.
+ */
+std::shared_ptr<const Graph> apply_tuning(
+    std::shared_ptr<const Graph> graph, const std::vector<Shape>& input_shapes,
+    const TuningDatabase& db, std::vector<size_t>* node_threads) {
+  const std::vector<Shape> shapes = graph->inferShapes(input_shapes);
+  const std::vector<Node>& nodes = graph->nodes();
+  std::vector<std::shared_ptr<const Operator>> ops(nodes.size());
+  std::vector<size_t> threads(nodes.size(), 0);
+  bool changed = false;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    ops[i] = nodes[i].op;
+    const auto* conv = dynamic_cast<const Conv2dOp*>(ops[i].get());
+    if (!conv) continue;
+    const ConvTuning* tuning =
+        db.findConv(conv_tuning_key(*conv, shapes[nodes[i].inputs[0]]));
+    if (!tuning) continue;
+    threads[i] = tuning->threads;
+    if (tuning->algorithm != conv->conv().algorithm()) {
+      ops[i] = conv->withAlgorithm(tuning->algorithm);
+      changed = true;
+    }
+  }
+  if (node_threads) *node_threads = std::move(threads);
+  if (!changed) return graph;
+
+  auto tuned = std::make_shared<Graph>();
+  std::vector<ValueId> map(graph->numValues());
+  for (ValueId v : graph->inputs())
+    map[v] = tuned->addInput(graph->valueName(v));
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    std::vector<ValueId> inputs;
+    for (ValueId v : nodes[i].inputs) inputs.push_back(map[v]);
+    map[nodes[i].output] =
+        tuned->addNode(nodes[i].name, ops[i], std::move(inputs));
+  }
+  for (ValueId v : graph->outputs()) tuned->addOutput(map[v]);
+  return tuned;
+}
@@ -0,0 +1,86 @@
+#include "runtime/executor.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils/numa.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Plan a graph for the given input shapes.
+ */
+Executor::Executor(std::shared_ptr<const Graph> graph,
+                   const std::vector<Shape>& input_shapes, int numa_node)
+    : graph_(std::move(graph)) {
+  if (!graph_) throw std::invalid_argument("Executor: null graph");
+  shapes_ = graph_->inferShapes(input_shapes);
+  const std::vector<Node>& nodes = graph_->nodes();
+
+  // Lifetime of each node output: from its node to its last consumer, or to
+  // the end of the run for graph outputs.
+  std::vector<TensorLifetime> lifetimes(nodes.size());
+  std::vector<size_t> producer(graph_->numValues(), nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    producer[nodes[i].output] = i;
+    lifetimes[i] = {shapes_[nodes[i].output].numel() * sizeof(float), i, i};
+  }
+  for (size_t i = 0; i < nodes.size(); ++i)
+    for (ValueId v : nodes[i].inputs)
+      if (producer[v] < nodes.size()) lifetimes[producer[v]].last = i;
+  for (ValueId v : graph_->outputs())
+    if (producer[v] < nodes.size()) lifetimes[producer[v]].last = nodes.size();
+  plan_ = plan_memory(lifetimes, kTensorAlignment);
+
+  const Shape arena_shape{plan_.arena_bytes / sizeof(float)};
+  arena_ = numa_node < 0 ? Tensor<float>(arena_shape)
+                         : numa_tensor<float>(arena_shape, size_t(numa_node));
+  values_.resize(graph_->numValues());
+  for (size_t i = 0; i < nodes.size(); ++i)
+    values_[nodes[i].output] = Tensor<float>::wrap(
+        arena_.data() + plan_.offsets[i] / sizeof(float),
+        shapes_[nodes[i].output], arena_.storage());
+  args_.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+    for (ValueId v : nodes[i].inputs) args_[i].push_back(&values_[v]);
+}
+
+/**
+ * @brief Limit the threads of individual nodes.
+ */
+void Executor::setNodeThreads(std::vector<size_t> threads) {
+  if (!threads.empty() && threads.size() != graph_->nodes().size())
+    throw std::invalid_argument("Executor: one thread limit per node");
+  node_threads_ = std::move(threads);
+}
+
+/**
+ * @brief Set the GEMM cache blocking used while this executor runs.
+ */
+void Executor::setGemmBlocking(std::optional<GemmBlocking> blocking) {
+  if (blocking && (blocking->mc == 0 || blocking->nc == 0))
+    throw std::invalid_argument("Executor: GEMM block sizes must be > 0");
+  gemm_blocking_ = blocking;
+}
+
+/**
+ * @brief Run the graph.
+ */
+void Executor::run(std::span<const Tensor<float>> inputs) {
+  const std::vector<ValueId>& ids = graph_->inputs();
+  if (inputs.size() != ids.size())
+    throw std::invalid_argument("Executor: wrong number of inputs");
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (inputs[i].shape() != shapes_[ids[i]])
+      throw std::invalid_argument("Executor: input '" +
+                                  graph_->valueName(ids[i]) +
+                                  "' does not match the planned shape");
+    values_[ids[i]] = inputs[i];
+  }
+  std::optional<GemmBlockingScope> blocking;
+  if (gemm_blocking_) blocking.emplace(*gemm_blocking_);
+  const std::vector<Node>& nodes = graph_->nodes();
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    ThreadLimitScope threads(node_threads_.empty() ? 0 : node_threads_[i]);
+    nodes[i].op->forward(args_[i], values_[nodes[i].output]);
+  }
+}
@@ -0,0 +1,119 @@
+#include "runtime/fusion.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "runtime/operators.h"
+
+/** Marker for values without a single fusable consumer. */
+static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Node that replaces a fused chain.
+ */
+struct FusedChain {
+  size_t last = kNone;                 /**< Index of the last absorbed node */
+  std::shared_ptr<const Operator> op;  /**< Replacement operator */
+  std::vector<ValueId> inputs;         /**< Inputs in the original graph */
+};
+
+/**
+ * @brief Fuse elementwise chains into the nodes that produce their input.
+ */
+Graph fuse_graph(const Graph& graph, FusionStats* stats) {
+  const std::vector<Node>& nodes = graph.nodes();
+  FusionStats counts;
+
+  // consumer[v]: the node reading v if it is the only reader and v is not a
+  // graph output.
+  std::vector<size_t> readers(graph.numValues(), 0);
+  std::vector<size_t> consumer(graph.numValues(), kNone);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    for (ValueId v : nodes[i].inputs) {
+      ++readers[v];
+      consumer[v] = i;
+    }
+  for (ValueId v : graph.outputs()) readers[v] += 2;
+  for (ValueId v = 0; v < graph.numValues(); ++v)
+    if (readers[v] != 1) consumer[v] = kNone;
+
+  std::vector<FusedChain> chains(nodes.size());
+  std::vector<bool> absorbed(nodes.size(), false);
+  const auto clip_of = [](const Node& node) {
+    return dynamic_cast<const ClipOp*>(node.op.get());
+  };
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (absorbed[i]) continue;
+    const Node& head = nodes[i];
+    FusedChain chain;
+    chain.inputs = head.inputs;
+    ValueId value = head.output;
+    if (auto conv = std::dynamic_pointer_cast<const Conv2dOp>(head.op)) {
+      bool epilogue = false;
+      for (size_t j = consumer[value]; j != kNone; j = consumer[value]) {
+        const Node& next = nodes[j];
+        if (const auto* bn = dynamic_cast<const BatchNormOp*>(next.op.get());
+            bn && !epilogue) {
+          conv = conv->foldAffine(bn->scale(), bn->shift());
+          ++counts.folded_batch_norms;
+        } else if (dynamic_cast<const AddOp*>(next.op.get()) &&
+                   !conv->hasResidual() && !epilogue &&
+                   next.inputs[0] != next.inputs[1]) {
+          const auto* add = static_cast<const AddOp*>(next.op.get());
+          conv = conv->withResidual()->withClamp(add->clampMin(),
+                                                 add->clampMax());
+          chain.inputs.push_back(next.inputs[next.inputs[0] == value]);
+          epilogue = true;
+          ++counts.fused_residuals;
+        } else if (const ClipOp* clip = clip_of(next)) {
+          conv = conv->withClamp(clip->min(), clip->max());
+          epilogue = true;
+          ++counts.fused_activations;
+        } else {
+          break;
+        }
+        absorbed[j] = true;
+        chain.last = j;
+        value = next.output;
+      }
+      chain.op = conv;
+    } else if (const auto* add = dynamic_cast<const AddOp*>(head.op.get())) {
+      float lo = add->clampMin(), hi = add->clampMax();
+      for (size_t j = consumer[value]; j != kNone; j = consumer[value]) {
+        const ClipOp* clip = clip_of(nodes[j]);
+        if (!clip) break;
+        lo = std::max(lo, clip->min());
+        hi = std::min(hi, clip->max());
+        ++counts.fused_activations;
+        absorbed[j] = true;
+        chain.last = j;
+        value = nodes[j].output;
+      }
+      chain.op = std::make_shared<AddOp>(lo, hi);
+    }
+    if (chain.last != kNone) {
+      absorbed[i] = true;  // emitted at the end of the chain instead
+      chains[chain.last] = std::move(chain);
+    }
+  }
+
+  // Emit nodes in the original order, replacing each chain at its end.
+  Graph fused;
+  std::vector<ValueId> map(graph.numValues(), kNone);
+  for (ValueId v : graph.inputs()) map[v] = fused.addInput(graph.valueName(v));
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const bool replaced = bool(chains[i].op);
+    if (absorbed[i] && !replaced) continue;  // head or interior of a chain
+    const Node& node = nodes[i];
+    std::vector<ValueId> inputs;
+    for (ValueId v : replaced ? chains[i].inputs : node.inputs)
+      inputs.push_back(map[v]);
+    map[node.output] = fused.addNode(
+        node.name, replaced ? chains[i].op : node.op, std::move(inputs));
+  }
+  for (ValueId v : graph.outputs()) fused.addOutput(map[v]);
+  if (stats) *stats = counts;
+  return fused;
+}
@@ -0,0 +1,62 @@
+#include "runtime/graph.h"
+
+#include <stdexcept>
+
+/**
+ * @brief Add a graph input.
+ */
+ValueId Graph::addInput(const std::string& name) {
+  values_.push_back(name);
+  inputs_.push_back(values_.size() - 1);
+  return inputs_.back();
+}
+
+/**
+ * @brief Append a node.
+ */
+ValueId Graph::addNode(const std::string& name,
+                       std::shared_ptr<const Operator> op,
+                       std::vector<ValueId> inputs) {
+  if (!op) throw std::invalid_argument("Graph: node '" + name + "' has no op");
+  for (ValueId v : inputs)
+    if (v >= values_.size())
+      throw std::invalid_argument("Graph: node '" + name +
+                                  "' consumes an unknown value");
+  values_.push_back(name);
+  nodes_.push_back(
+      {name, std::move(op), std::move(inputs), values_.size() - 1});
+  return nodes_.back().output;
+}
+
+/**
+ * @brief Mark a value as a graph output.
+ */
+void Graph::addOutput(ValueId value) {
+  if (value >= values_.size())
+    throw std::invalid_argument("Graph: unknown output value");
+  outputs_.push_back(value);
+}
+
+/**
+ * @brief Infer the shape of every value.
+ */
+std::vector<Shape> Graph::inferShapes(
+    const std::vector<Shape>& input_shapes) const {
+  if (input_shapes.size() != inputs_.size())
+    throw std::invalid_argument("Graph: wrong number of input shapes");
+  std::vector<Shape> shapes(values_.size());
+  for (size_t i = 0; i < inputs_.size(); ++i)
+    shapes[inputs_[i]] = input_shapes[i];
+  std::vector<Shape> args;
+  for (const Node& node : nodes_) {
+    args.clear();
+    for (ValueId v : node.inputs) args.push_back(shapes[v]);
+    try {
+      shapes[node.output] = node.op->outputShape(args);
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument("Graph: node '" + node.name + "' (" +
+                                  node.op->type() + "): " + e.what());
+    }
+  }
+  return shapes;
+}
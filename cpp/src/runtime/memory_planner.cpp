@@ -0,0 +1,85 @@
+#include "runtime/memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+/**
+ * @brief Tensor already assigned an offset.
+ */
+struct Placed {
+  size_t offset; /**< Byte offset */
+  size_t bytes;  /**< Aligned size */
+  size_t first;  /**< First live step */
+  size_t last;   /**< Last live step */
+};
+
+/**
+ * @brief Assign arena offsets to tensors with known lifetimes.
+ */
+MemoryPlan plan_memory(const std::vector<TensorLifetime>& tensors,
+                       size_t alignment) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    throw std::invalid_argument("plan_memory: alignment must be a power of 2");
+  const auto aligned = [&](size_t bytes) {
+    return (bytes + alignment - 1) & ~(alignment - 1);
+  };
+  size_t steps = 0;
+  for (const TensorLifetime& t : tensors) {
+    if (t.last < t.first)
+      throw std::invalid_argument("plan_memory: lifetime ends before start");
+    steps = std::max(steps, t.last + 1);
+  }
+
+  MemoryPlan plan;
+  plan.offsets.assign(tensors.size(), 0);
+  std::vector<size_t> order(tensors.size());
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return tensors[a].bytes > tensors[b].bytes;
+  });
+
+  std::vector<Placed> placed;  // sorted by offset
+  placed.reserve(tensors.size());
+  for (size_t i : order) {
+    const TensorLifetime& t = tensors[i];
+    const size_t bytes = aligned(t.bytes);
+    size_t best = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;  // end of the highest conflicting tensor so far
+    for (const Placed& p : placed) {
+      if (p.last < t.first || t.last < p.first) continue;
+      if (p.offset >= end) {
+        const size_t gap = p.offset - end;
+        if (gap >= bytes && gap < best_gap) {
+          best = end;
+          best_gap = gap;
+        }
+      }
+      end = std::max(end, p.offset + p.bytes);
+    }
+    if (best == std::numeric_limits<size_t>::max()) best = end;
+    plan.offsets[i] = best;
+    plan.arena_bytes = std::max(plan.arena_bytes, best + bytes);
+    const Placed entry{best, bytes, t.first, t.last};
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), entry,
+                                   [](const Placed& a, const Placed& b) {
+                                     return a.offset < b.offset;
+                                   }),
+                  entry);
+  }
+
+  // Lower bound: total aligned bytes live at the busiest step.
+  std::vector<size_t> live(steps + 1, 0);
+  for (const TensorLifetime& t : tensors) {
+    live[t.first] += aligned(t.bytes);
+    live[t.last + 1] -= aligned(t.bytes);
+  }
+  size_t current = 0;
+  for (size_t s = 0; s < steps; ++s) {
+    current += live[s];
+    plan.peak_live_bytes = std::max(plan.peak_live_bytes, current);
+  }
+  return plan;
+}
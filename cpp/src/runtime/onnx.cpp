@@ -0,0 +1,1326 @@
+#include "runtime/onnx.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "runtime/operators.h"
+#include "utils/mapped_file.h"
+#include "utils/protobuf.h"
+
+static_assert(std::endian::native == std::endian::little,
+              "ONNX raw tensor data is little-endian");
+
+/** TensorProto.DataType codes of the supported element types. */
+static constexpr int64_t kOnnxFloat = 1;
+static constexpr int64_t kOnnxInt32 = 6;
+static constexpr int64_t kOnnxInt64 = 7;
+static constexpr int64_t kOnnxDouble = 11;
+
+/** Marker for a constant that has no graph value (yet). */
+static constexpr ValueId kNoValue = ~ValueId(0);
+
+/**
+ * @brief Decoded TensorProto: float values, or int64 values for integer
+ * tensors (shape computations).
+ */
+struct OnnxTensor {
+  Shape shape;               /**< Dimensions */
+  bool integer = false;      /**< Holds ints rather than data */
+  Tensor<float> data;        /**< Float values */
+  std::vector<int64_t> ints; /**< Integer values */
+};
+
+/**
+ * @brief Decoded AttributeProto (the fields the importer uses).
+ */
+struct OnnxAttribute {
+  std::string name;              /**< Attribute name */
+  float f = 0.f;                 /**< FLOAT value */
+  int64_t i = 0;                 /**< INT value */
+  std::string s;                 /**< STRING value */
+  std::vector<float> floats;     /**< FLOATS value */
+  std::vector<int64_t> ints;     /**< INTS value */
+  std::optional<OnnxTensor> t;   /**< TENSOR value */
+};
+
+/**
+ * @brief Decoded NodeProto.
+ */
+struct OnnxNode {
+  std::string name;                      /**< Node name (may be empty) */
+  std::string op_type;                   /**< Operator type */
+  std::string domain;                    /**< Operator domain */
+  std::vector<std::string> inputs;       /**< Input names ("" if omitted) */
+  std::vector<std::string> outputs;      /**< Output names */
+  std::vector<OnnxAttribute> attributes; /**< Attributes */
+};
+
+/**
+ * @brief Decoded ValueInfoProto: a name and dimensions (-1 if symbolic).
+ */
+struct OnnxValueInfo {
+  std::string name;          /**< Value name */
+  bool has_shape = false;    /**< Whether a shape was declared */
+  std::vector<int64_t> dims; /**< Dimensions, -1 if unknown */
+};
+
+/**
+ * @brief Value of the ONNX graph during import.
+ *
+ * Either produced at run time by a graph value, or a constant known at
+ * import; constants get a graph value (a ConstantOp) only when a run-time
+ * node consumes them.
+ */
+struct ImportValue {
+  bool is_constant = false; /**< Known at import */
+  OnnxTensor constant;      /**< Value if is_constant */
+  ValueId id = kNoValue;    /**< Graph value (materialized if constant) */
+  Shape shape;              /**< Inferred shape */
+};
+
+/**
+ * @brief State of one import.
+ */
+struct Importer {
+  std::shared_ptr<Graph> graph = std::make_shared<Graph>(); /**< Output */
+  std::unordered_map<std::string, ImportValue> values; /**< By ONNX name */
+  int64_t opset = 0;  /**< Default-domain opset */
+  size_t folded = 0;  /**< Nodes evaluated at import */
+};
+
+/**
+ * @brief Start reading a nested message field.
+ */
+static ProtoReader nested(const ProtoField& field) {
+  if (field.wire != ProtoWireType::kBytes)
+    throw std::runtime_error("onnx: expected a message field");
+  return ProtoReader(field.bytes);
+}
+
+/**
+ * @brief Get a string field.
+ */
+static std::string string_field(const ProtoField& field) {
+  if (field.wire != ProtoWireType::kBytes)
+    throw std::runtime_error("onnx: expected a string field");
+  return std::string(field.asString());
+}
+
+/**
+ * @brief Build a shape from ONNX dimensions.
+ */
+static Shape to_shape(const std::vector<int64_t>& dims) {
+  if (dims.size() > kMaxTensorRank)
+    throw std::invalid_argument("onnx: rank exceeds kMaxTensorRank");
+  Shape shape;
+  for (int64_t d : dims) {
+    if (d < 0) throw std::invalid_argument("onnx: negative dimension");
+    shape.push_back(size_t(d));
+  }
+  return shape;
+}
+
+/**
+ * @brief Get the number of elements of @p shape, rejecting sizes that do
+ * not fit size_t.
+ */
+static size_t checked_numel(const Shape& shape) {
+  if (std::find(shape.begin(), shape.end(), size_t(0)) != shape.end())
+    return 0;
+  size_t n = 1;
+  for (size_t d : shape) {
+    if (n > std::numeric_limits<size_t>::max() / d)
+      throw std::invalid_argument("onnx: tensor size overflows");
+    n *= d;
+  }
+  return n;
+}
+
+/**
+ * @brief Create an integer constant.
+ */
+static OnnxTensor make_ints(const Shape& shape, std::vector<int64_t> ints) {
+  OnnxTensor t;
+  t.shape = shape;
+  t.integer = true;
+  t.ints = std::move(ints);
+  return t;
+}
+
+/**
+ * @brief Create a float constant.
+ */
+static OnnxTensor make_floats(const Tensor<float>& data) {
+  OnnxTensor t;
+  t.shape = data.shape();
+  t.data = data;
+  return t;
+}
+
+/**
+ * @brief Read a little-endian value from unaligned memory.
+ */
+template <typename T>
+static T read_le(const uint8_t* p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  return v;
+}
+
+/**
+ * @brief Check that raw bytes hold exactly @p count values of type From.
+ */
+template <typename From>
+static void check_raw(std::span<const uint8_t> raw, size_t count) {
+  if (raw.size() % sizeof(From) != 0 || raw.size() / sizeof(From) != count)
+    throw std::runtime_error("onnx: raw tensor data has the wrong size");
+}
+
+/**
+ * @brief Copy @p count little-endian values of type From from raw bytes.
+ */
+template <typename From, typename To>
+static void from_raw(std::span<const uint8_t> raw, size_t count, To* out) {
+  check_raw<From>(raw, count);
+  for (size_t i = 0; i < count; ++i)
+    out[i] = To(read_le<From>(raw.data() + i * sizeof(From)));
+}
+
+/**
+ * @brief Decode a TensorProto.
+ */
+static OnnxTensor parse_tensor(const ProtoField& field) {
+  ProtoReader reader = nested(field);
+  ProtoField f;
+  std::vector<int64_t> dims, ints;
+  std::vector<float> floats;
+  std::vector<double> doubles;
+  std::span<const uint8_t> raw;
+  bool has_raw = false;
+  int64_t type = 0, location = 0;
+  while (reader.next(f)) {
+    switch (f.number) {
+      case 1: proto_append_varints(f, dims); break;
+      case 2: type = f.asInt64(); break;
+      case 4: proto_append_floats(f, floats); break;
+      case 5:  // int32_data
+      case 7: proto_append_varints(f, ints); break;  // int64_data
+      case 9:
+        if (f.wire != ProtoWireType::kBytes)
+          throw std::runtime_error("onnx: raw_data is not bytes");
+        raw = f.bytes;
+        has_raw = true;
+        break;
+      case 10:  // double_data
+        if (f.wire == ProtoWireType::kFixed64) {
+          doubles.push_back(f.asDouble());
+        } else if (f.wire == ProtoWireType::kBytes && f.bytes.size() % 8 == 0) {
+          for (size_t i = 0; i < f.bytes.size(); i += 8)
+            doubles.push_back(std::bit_cast<double>(
+                read_le<uint64_t>(f.bytes.data() + i)));
+        } else {
+          throw std::runtime_error("onnx: invalid double_data");
+        }
+        break;
+      case 14: location = f.asInt64(); break;
+      default: break;
+    }
+  }
+  if (location != 0)
+    throw std::invalid_argument("onnx: external tensor data is not supported");
+
+  OnnxTensor t;
+  t.shape = to_shape(dims);
+  const size_t n = checked_numel(t.shape);
+  // Validate the payload before allocating: dims are untrusted.
+  switch (type) {
+    case kOnnxFloat:
+    case kOnnxDouble:
+      if (has_raw && type == kOnnxFloat) {
+        check_raw<float>(raw, n);
+      } else if (has_raw) {
+        check_raw<double>(raw, n);
+      } else if ((type == kOnnxFloat ? floats.size() : doubles.size()) != n) {
+        throw std::runtime_error("onnx: tensor data has the wrong size");
+      }
+      t.data = Tensor<float>(t.shape);
+      if (has_raw && type == kOnnxFloat) {
+        from_raw<float>(raw, n, t.data.data());
+      } else if (has_raw) {
+        from_raw<double>(raw, n, t.data.data());
+      } else if (type == kOnnxFloat) {
+        std::copy_n(floats.data(), n, t.data.data());
+      } else {
+        std::copy_n(doubles.data(), n, t.data.data());
+      }
+      break;
+    case kOnnxInt32:
+    case kOnnxInt64:
+      t.integer = true;
+      if (has_raw) {
+        if (type == kOnnxInt32)
+          check_raw<int32_t>(raw, n);
+        else
+          check_raw<int64_t>(raw, n);
+        t.ints.resize(n);
+        if (type == kOnnxInt32)
+          from_raw<int32_t>(raw, n, t.ints.data());
+        else
+          from_raw<int64_t>(raw, n, t.ints.data());
+      } else {
+        if (ints.size() != n)
+          throw std::runtime_error("onnx: tensor data has the wrong size");
+        t.ints = std::move(ints);
+      }
+      break;
+    default:
+      throw std::invalid_argument("onnx: unsupported tensor data type " +
+                                  std::to_string(type));
+  }
+  return t;
+}
+
+/**
+ * @brief Decode an AttributeProto.
+ */
+static OnnxAttribute parse_attribute(const ProtoField& field) {
+  ProtoReader reader = nested(field);
+  ProtoField f;
+  OnnxAttribute a;
+  while (reader.next(f)) {
+    switch (f.number) {
+      case 1: a.name = string_field(f); break;
+      case 2: a.f = f.asFloat(); break;
+      case 3: a.i = f.asInt64(); break;
+      case 4: a.s = string_field(f); break;
+      case 5: a.t = parse_tensor(f); break;
+      case 7: proto_append_floats(f, a.floats); break;
+      case 8: proto_append_varints(f, a.ints); break;
+      default: break;  // subgraphs, strings, docs
+    }
+  }
+  return a;
+}
+
+/**
+ * @brief Decode a NodeProto.
+ */
+static OnnxNode parse_node(const ProtoField& field) {
+  ProtoReader reader = nested(field);
+  ProtoField f;
+  OnnxNode node;
+  while (reader.next(f)) {
+    switch (f.number) {
+      case 1: node.inputs.push_back(string_field(f)); break;
+      case 2: node.outputs.push_back(string_field(f)); break;
+      case 3: node.name = string_field(f); break;
+      case 4: node.op_type = string_field(f); break;
+      case 5: node.attributes.push_back(parse_attribute(f)); break;
+      case 7: node.domain = string_field(f); break;
+      default: break;
+    }
+  }
+  if (node.outputs.empty())
+    throw std::runtime_error("onnx: node '" + node.name + "' has no output");
+  return node;
+}
+
+/**
+ * @brief Decode a ValueInfoProto.
+ */
+static OnnxValueInfo parse_value_info(const ProtoField& field) {
+  ProtoReader reader = nested(field);
+  ProtoField f;
+  OnnxValueInfo info;
+  while (reader.next(f)) {
+    if (f.number == 1) info.name = string_field(f);
+    if (f.number != 2) continue;
+    ProtoReader type = nested(f);  // TypeProto
+    ProtoField tf;
+    while (type.next(tf)) {
+      if (tf.number != 1) continue;
+      ProtoReader tensor = nested(tf);  // TypeProto.Tensor
+      ProtoField sf;
+      while (tensor.next(sf)) {
+        if (sf.number != 2) continue;
+        info.has_shape = true;
+        ProtoReader shape = nested(sf);  // TensorShapeProto
+        ProtoField df;
+        while (shape.next(df)) {
+          if (df.number != 1) continue;
+          ProtoReader dim = nested(df);
+          ProtoField vf;
+          int64_t value = -1;
+          while (dim.next(vf))
+            if (vf.number == 1) value = vf.asInt64();
+          info.dims.push_back(value);
+        }
+      }
+    }
+  }
+  return info;
+}
+
+/**
+ * @brief Find an attribute by name.
+ */
+static const OnnxAttribute* find_attr(const OnnxNode& node,
+                                      std::string_view name) {
+  for (const OnnxAttribute& a : node.attributes)
+    if (a.name == name) return &a;
+  return nullptr;
+}
+
+static int64_t attr_int(const OnnxNode& node, std::string_view name,
+                        int64_t fallback) {
+  const OnnxAttribute* a = find_attr(node, name);
+  return a ? a->i : fallback;
+}
+
+static float attr_float(const OnnxNode& node, std::string_view name,
+                        float fallback) {
+  const OnnxAttribute* a = find_attr(node, name);
+  return a ? a->f : fallback;
+}
+
+static std::string attr_string(const OnnxNode& node, std::string_view name,
+                               const std::string& fallback) {
+  const OnnxAttribute* a = find_attr(node, name);
+  return a ? a->s : fallback;
+}
+
+static std::vector<int64_t> attr_ints(const OnnxNode& node,
+                                      std::string_view name,
+                                      std::vector<int64_t> fallback) {
+  const OnnxAttribute* a = find_attr(node, name);
+  return a ? a->ints : fallback;
+}
+
+/**
+ * @brief Check whether optional input @p i is given.
+ */
+static bool has_input(const OnnxNode& node, size_t i) {
+  return i < node.inputs.size() && !node.inputs[i].empty();
+}
+
+/**
+ * @brief Look up input @p i of a node.
+ */
+static ImportValue& input(Importer& im, const OnnxNode& node, size_t i) {
+  if (!has_input(node, i))
+    throw std::invalid_argument("missing input " + std::to_string(i));
+  const auto it = im.values.find(node.inputs[i]);
+  if (it == im.values.end())
+    throw std::invalid_argument("unknown input '" + node.inputs[i] + "'");
+  return it->second;
+}
+
+/**
+ * @brief Look up input @p i of a node, which must be known at import.
+ */
+static const OnnxTensor& constant_input(Importer& im, const OnnxNode& node,
+                                        size_t i) {
+  const ImportValue& v = input(im, node, i);
+  if (!v.is_constant)
+    throw std::invalid_argument("input '" + node.inputs[i] +
+                                "' must be constant");
+  return v.constant;
+}
+
+/**
+ * @brief Get element @p i of a constant as a double.
+ */
+static double element(const OnnxTensor& t, size_t i) {
+  return t.integer ? double(t.ints[i]) : double(t.data[i]);
+}
+
+/**
+ * @brief Get a constant as floats.
+ */
+static Tensor<float> as_floats(const OnnxTensor& t) {
+  if (!t.integer) return t.data;
+  Tensor<float> out(t.shape);
+  for (size_t i = 0; i < t.ints.size(); ++i) out[i] = float(t.ints[i]);
+  return out;
+}
+
+/**
+ * @brief Get a constant as integers.
+ */
+static std::vector<int64_t> as_ints(const OnnxTensor& t) {
+  if (t.integer) return t.ints;
+  std::vector<int64_t> out(t.shape.numel());
+  for (size_t i = 0; i < out.size(); ++i) out[i] = std::llround(t.data[i]);
+  return out;
+}
+
+/**
+ * @brief Resolve a possibly negative axis against @p rank.
+ */
+static size_t normalize_axis(int64_t axis, size_t rank,
+                             bool inclusive = false) {
+  const int64_t r = int64_t(rank) + (inclusive ? 1 : 0);
+  if (axis < -r || axis >= r) throw std::invalid_argument("axis out of range");
+  return size_t(axis < 0 ? axis + r : axis);
+}
+
+/**
+ * @brief Record a constant output.
+ */
+static void set_constant(Importer& im, const std::string& name,
+                         OnnxTensor value) {
+  ImportValue v;
+  v.is_constant = true;
+  v.shape = value.shape;
+  v.constant = std::move(value);
+  im.values[name] = std::move(v);
+}
+
+/**
+ * @brief Get the graph value of a named ONNX value, materializing a
+ * constant as a ConstantOp node on first use.
+ */
+static ValueId value_id(Importer& im, const std::string& name) {
+  ImportValue& v = im.values.at(name);
+  if (v.id == kNoValue)
+    v.id = im.graph->addNode(
+        name, std::make_shared<ConstantOp>(as_floats(v.constant).clone()), {});
+  return v.id;
+}
+
+/**
+ * @brief Apply an operator to named values.
+ *
+ * The output shape is inferred immediately. If every argument is constant
+ * the operator is evaluated now and its output becomes a constant;
+ * otherwise a graph node is appended.
+ */
+static void emit(Importer& im, const std::string& output,
+                 std::shared_ptr<const Operator> op,
+                 const std::vector<std::string>& args) {
+  std::vector<Shape> shapes;
+  bool constant = true;
+  for (const std::string& a : args) {
+    const ImportValue& v = im.values.at(a);
+    shapes.push_back(v.shape);
+    constant = constant && v.is_constant;
+  }
+  ImportValue result;
+  result.shape = op->outputShape(shapes);
+  if (constant) {
+    std::vector<Tensor<float>> tensors;
+    std::vector<const Tensor<float>*> ptrs;
+    for (const std::string& a : args)
+      tensors.push_back(as_floats(im.values.at(a).constant));
+    for (const Tensor<float>& t : tensors) ptrs.push_back(&t);
+    Tensor<float> out(result.shape);
+    op->forward(ptrs, out);
+    result.is_constant = true;
+    result.constant = make_floats(out);
+    ++im.folded;
+  } else {
+    std::vector<ValueId> ids;
+    for (const std::string& a : args) ids.push_back(value_id(im, a));
+    result.id = im.graph->addNode(output, std::move(op), std::move(ids));
+  }
+  im.values[output] = std::move(result);
+}
+
+/**
+ * @brief Give input 0 of a node a new shape (a copy at run time).
+ */
+static void reshape_input(Importer& im, const OnnxNode& node,
+                          const Shape& shape) {
+  const ImportValue& x = input(im, node, 0);
+  if (x.shape.numel() != shape.numel())
+    throw std::invalid_argument("element count mismatch");
+  if (x.is_constant) {
+    OnnxTensor t = x.constant;
+    t.shape = shape;
+    if (!t.integer) t.data = t.data.reshape(shape);
+    set_constant(im, node.outputs[0], std::move(t));
+    ++im.folded;
+    return;
+  }
+  emit(im, node.outputs[0], std::make_shared<ReshapeOp>(shape),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Evaluate a binary arithmetic operator on constants with numpy
+ * broadcasting.
+ */
+static OnnxTensor fold_binary(const OnnxTensor& a, const OnnxTensor& b,
+                              const std::string& op) {
+  const size_t rank = std::max(a.shape.rank(), b.shape.rank());
+  Shape out;
+  size_t sa[kMaxTensorRank] = {}, sb[kMaxTensorRank] = {};
+  for (size_t d = 0; d < rank; ++d) {
+    const size_t ia = d + a.shape.rank(), ib = d + b.shape.rank();
+    const size_t da = ia >= rank ? a.shape[ia - rank] : 1;
+    const size_t db = ib >= rank ? b.shape[ib - rank] : 1;
+    if (da != db && da != 1 && db != 1)
+      throw std::invalid_argument("shapes cannot be broadcast");
+    out.push_back(std::max(da, db));
+  }
+  for (size_t d = rank, na = 1, nb = 1; d-- > 0;) {
+    const size_t ia = d + a.shape.rank(), ib = d + b.shape.rank();
+    const size_t da = ia >= rank ? a.shape[ia - rank] : 1;
+    const size_t db = ib >= rank ? b.shape[ib - rank] : 1;
+    sa[d] = da == 1 ? 0 : na;
+    sb[d] = db == 1 ? 0 : nb;
+    na *= da;
+    nb *= db;
+  }
+  const bool integer = a.integer && b.integer;
+  OnnxTensor r;
+  r.shape = out;
+  r.integer = integer;
+  const size_t n = out.numel();
+  if (integer)
+    r.ints.resize(n);
+  else
+    r.data = Tensor<float>(out);
+  for (size_t i = 0; i < n; ++i) {
+    size_t ia = 0, ib = 0;
+    for (size_t d = rank, rem = i; d-- > 0;) {
+      ia += rem % out[d] * sa[d];
+      ib += rem % out[d] * sb[d];
+      rem /= out[d];
+    }
+    if (integer) {
+      const int64_t x = a.ints[ia], y = b.ints[ib];
+      if (op == "Div" && y == 0) throw std::invalid_argument("division by 0");
+      r.ints[i] = op == "Add"   ? x + y
+                  : op == "Sub" ? x - y
+                  : op == "Mul" ? x * y
+                                : x / y;
+    } else {
+      const double x = element(a, ia), y = element(b, ib);
+      r.data[i] = float(op == "Add"   ? x + y
+                        : op == "Sub" ? x - y
+                        : op == "Mul" ? x * y
+                                      : x / y);
+    }
+  }
+  return r;
+}
+
+/**
+ * @brief Get per-channel values of a constant broadcast over NCHW-like
+ * input of shape @p x, or nothing if it varies along other axes.
+ */
+static std::optional<std::vector<float>> channel_values(const OnnxTensor& c,
+                                                        const Shape& x) {
+  if (x.rank() < 2 || c.shape.rank() > x.rank()) return std::nullopt;
+  const size_t channels = x[1];
+  std::vector<float> v(channels);
+  if (c.shape.numel() == 1) {
+    std::fill(v.begin(), v.end(), float(element(c, 0)));
+    return v;
+  }
+  // Right-aligned, c must be 1 everywhere except the channel axis.
+  const size_t lead = x.rank() - c.shape.rank();
+  for (size_t d = 0; d < c.shape.rank(); ++d) {
+    const size_t axis = d + lead;
+    if (c.shape[d] != 1 && (axis != 1 || c.shape[d] != channels))
+      return std::nullopt;
+  }
+  for (size_t i = 0; i < channels; ++i) v[i] = float(element(c, i));
+  return v;
+}
+
+/**
+ * @brief Import Add, Sub, Mul and Div.
+ */
+static void import_binary(Importer& im, const OnnxNode& node) {
+  const ImportValue& a = input(im, node, 0);
+  const ImportValue& b = input(im, node, 1);
+  const std::string& op = node.op_type;
+  if (a.is_constant && b.is_constant) {
+    set_constant(im, node.outputs[0], fold_binary(a.constant, b.constant, op));
+    ++im.folded;
+    return;
+  }
+  if (!a.is_constant && !b.is_constant) {
+    if (op == "Add")
+      emit(im, node.outputs[0], std::make_shared<AddOp>(), node.inputs);
+    else if (op == "Mul")
+      emit(im, node.outputs[0], std::make_shared<MulOp>(), node.inputs);
+    else
+      throw std::invalid_argument("both inputs are computed at run time");
+    return;
+  }
+  // One computed input x and one constant c.
+  const bool c_first = a.is_constant;
+  const ImportValue& x = c_first ? b : a;
+  const OnnxTensor& c = c_first ? a.constant : b.constant;
+  const std::string& x_name = node.inputs[c_first ? 1 : 0];
+  if (const auto v = channel_values(c, x.shape)) {
+    Tensor<float> scale(Shape{v->size()}), shift(Shape{v->size()});
+    for (size_t i = 0; i < v->size(); ++i) {
+      const float k = (*v)[i];
+      scale[i] = op == "Mul" ? k : op == "Div" ? 1.f / k : 1.f;
+      shift[i] = op == "Add" || op == "Sub" ? k : 0.f;
+      if (op == "Sub" && !c_first) shift[i] = -k;
+      if (op == "Sub" && c_first) scale[i] = -1.f;
+    }
+    if (op == "Div" && c_first)
+      throw std::invalid_argument("division by a computed value");
+    emit(im, node.outputs[0], std::make_shared<BatchNormOp>(scale, shift),
+         {x_name});
+    return;
+  }
+  if (c.shape == x.shape && (op == "Add" || op == "Mul")) {
+    std::shared_ptr<const Operator> elementwise;
+    if (op == "Add")
+      elementwise = std::make_shared<AddOp>();
+    else
+      elementwise = std::make_shared<MulOp>();
+    emit(im, node.outputs[0], elementwise, node.inputs);
+    return;
+  }
+  throw std::invalid_argument("unsupported broadcast");
+}
+
+/**
+ * @brief Import Conv (2D).
+ */
+static void import_conv(Importer& im, const OnnxNode& node) {
+  const Shape x = input(im, node, 0).shape;
+  const Tensor<float> weight = as_floats(constant_input(im, node, 1));
+  const Tensor<float> bias = has_input(node, 2)
+                                 ? as_floats(constant_input(im, node, 2))
+                                 : Tensor<float>();
+  if (weight.rank() != 4 || x.rank() != 4)
+    throw std::invalid_argument("only 2D convolutions are supported");
+  const size_t kh = weight.dim(2), kw = weight.dim(3);
+  const auto kernel = attr_ints(node, "kernel_shape",
+                                {int64_t(kh), int64_t(kw)});
+  const auto strides = attr_ints(node, "strides", {1, 1});
+  const auto dilations = attr_ints(node, "dilations", {1, 1});
+  auto pads = attr_ints(node, "pads", {0, 0, 0, 0});
+  if (kernel != std::vector<int64_t>{int64_t(kh), int64_t(kw)} ||
+      strides.size() != 2 || dilations.size() != 2 || pads.size() != 4 ||
+      std::any_of(strides.begin(), strides.end(), [](int64_t v) {
+        return v < 1;
+      }) ||
+      std::any_of(dilations.begin(), dilations.end(),
+                  [](int64_t v) { return v < 1; }) ||
+      std::any_of(pads.begin(), pads.end(), [](int64_t v) { return v < 0; }))
+    throw std::invalid_argument("invalid kernel, stride, dilation or pads");
+
+  const std::string auto_pad = attr_string(node, "auto_pad", "NOTSET");
+  if (auto_pad == "SAME_UPPER" || auto_pad == "SAME_LOWER") {
+    for (size_t d = 0; d < 2; ++d) {
+      const int64_t in = int64_t(x[2 + d]), s = strides[d];
+      const int64_t k = (int64_t(d ? kw : kh) - 1) * dilations[d] + 1;
+      const int64_t out = (in + s - 1) / s;
+      const int64_t total = std::max<int64_t>(0, (out - 1) * s + k - in);
+      const int64_t small = total / 2;
+      pads[d] = auto_pad == "SAME_UPPER" ? small : total - small;
+      pads[d + 2] = total - pads[d];
+    }
+  } else if (auto_pad == "VALID") {
+    pads = {0, 0, 0, 0};
+  } else if (auto_pad != "NOTSET") {
+    throw std::invalid_argument("unsupported auto_pad " + auto_pad);
+  }
+
+  Conv2dParams params;
+  params.stride_h = size_t(strides[0]);
+  params.stride_w = size_t(strides[1]);
+  params.dilation_h = size_t(dilations[0]);
+  params.dilation_w = size_t(dilations[1]);
+  params.pad_top = size_t(pads[0]);
+  params.pad_left = size_t(pads[1]);
+  params.pad_bottom = size_t(pads[2]);
+  params.pad_right = size_t(pads[3]);
+  const int64_t group = attr_int(node, "group", 1);
+  if (group < 1) throw std::invalid_argument("invalid group");
+  params.groups = size_t(group);
+  emit(im, node.outputs[0], std::make_shared<Conv2dOp>(weight, bias, params),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Import MaxPool (square windows, symmetric padding).
+ */
+static void import_max_pool(Importer& im, const OnnxNode& node) {
+  const auto kernel = attr_ints(node, "kernel_shape", {});
+  const auto strides = attr_ints(node, "strides", {1, 1});
+  const auto pads = attr_ints(node, "pads", {0, 0, 0, 0});
+  const auto dilations = attr_ints(node, "dilations", {1, 1});
+  const std::string auto_pad = attr_string(node, "auto_pad", "NOTSET");
+  const auto all_equal = [](const std::vector<int64_t>& v) {
+    return std::adjacent_find(v.begin(), v.end(), std::not_equal_to<>()) ==
+           v.end();
+  };
+  if (kernel.size() != 2 || strides.size() != 2 || pads.size() != 4 ||
+      !all_equal(kernel) || !all_equal(strides) || !all_equal(pads) ||
+      dilations != std::vector<int64_t>{1, 1} ||
+      attr_int(node, "ceil_mode", 0) != 0 ||
+      (auto_pad != "NOTSET" && auto_pad != "VALID") ||
+      node.outputs.size() > 1 || kernel[0] < 1 || strides[0] < 1 ||
+      pads[0] < 0)
+    throw std::invalid_argument(
+        "only square windows with equal strides and pads are supported");
+  emit(im, node.outputs[0],
+       std::make_shared<MaxPool2dOp>(size_t(kernel[0]), size_t(strides[0]),
+                                     size_t(pads[0])),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Import Clip (attributes before opset 11, inputs after).
+ */
+static void import_clip(Importer& im, const OnnxNode& node) {
+  float lo = -std::numeric_limits<float>::infinity();
+  float hi = std::numeric_limits<float>::infinity();
+  if (im.opset < 11) {
+    lo = attr_float(node, "min", lo);
+    hi = attr_float(node, "max", hi);
+  } else {
+    if (has_input(node, 1))
+      lo = float(element(constant_input(im, node, 1), 0));
+    if (has_input(node, 2))
+      hi = float(element(constant_input(im, node, 2), 0));
+  }
+  if (lo == 0.f && hi == std::numeric_limits<float>::infinity())
+    emit(im, node.outputs[0], std::make_shared<ReluOp>(), {node.inputs[0]});
+  else
+    emit(im, node.outputs[0], std::make_shared<ClipOp>(lo, hi),
+         {node.inputs[0]});
+}
+
+/**
+ * @brief Import Resize and Upsample in nearest mode with integer factors.
+ */
+static void import_resize(Importer& im, const OnnxNode& node) {
+  const Shape x = input(im, node, 0).shape;
+  if (x.rank() != 4) throw std::invalid_argument("expected NCHW input");
+  if (attr_string(node, "mode", "nearest") != "nearest")
+    throw std::invalid_argument("only nearest mode is supported");
+  std::vector<double> scales;
+  const auto append = [&](const OnnxTensor& s) {
+    for (size_t i = 0; i < s.shape.numel(); ++i)
+      scales.push_back(element(s, i));
+  };
+  if (const OnnxAttribute* a = find_attr(node, "scales")) {
+    scales.assign(a->floats.begin(), a->floats.end());  // Upsample-7
+  } else if (node.op_type == "Upsample" || im.opset < 11) {
+    append(constant_input(im, node, 1));
+  } else if (has_input(node, 3)) {
+    const std::vector<int64_t> sizes = as_ints(constant_input(im, node, 3));
+    for (size_t d = 0; d < sizes.size() && d < x.rank(); ++d)
+      scales.push_back(x[d] ? double(sizes[d]) / double(x[d]) : 0.);
+  } else {
+    append(constant_input(im, node, 2));
+  }
+  if (scales.size() != 4 || scales[0] != 1. || scales[1] != 1. ||
+      scales[2] < 1. || scales[3] < 1. ||
+      scales[2] != std::floor(scales[2]) || scales[3] != std::floor(scales[3]))
+    throw std::invalid_argument("only integer spatial factors are supported");
+  emit(im, node.outputs[0],
+       std::make_shared<UpsampleNearestOp>(size_t(scales[2]),
+                                           size_t(scales[3])),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Import Concat.
+ */
+static void import_concat(Importer& im, const OnnxNode& node) {
+  if (node.inputs.empty()) throw std::invalid_argument("no inputs");
+  const size_t rank = input(im, node, 0).shape.rank();
+  const size_t axis = normalize_axis(attr_int(node, "axis", 0), rank);
+  bool integer = true;
+  for (size_t i = 0; i < node.inputs.size(); ++i) {
+    const ImportValue& v = input(im, node, i);
+    integer = integer && v.is_constant && v.constant.integer;
+  }
+  if (!integer) {
+    emit(im, node.outputs[0], std::make_shared<ConcatOp>(axis), node.inputs);
+    return;
+  }
+  // Integer constants (shape arithmetic) stay integers.
+  std::vector<Shape> shapes;
+  for (size_t i = 0; i < node.inputs.size(); ++i)
+    shapes.push_back(input(im, node, i).shape);
+  const Shape out = ConcatOp(axis).outputShape(shapes);
+  size_t outer = 1, inner = 1;
+  for (size_t d = 0; d < axis; ++d) outer *= out[d];
+  for (size_t d = axis + 1; d < rank; ++d) inner *= out[d];
+  std::vector<int64_t> ints;
+  for (size_t o = 0; o < outer; ++o)
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+      const OnnxTensor& t = input(im, node, i).constant;
+      const size_t len = t.shape[axis] * inner;
+      ints.insert(ints.end(), t.ints.begin() + ptrdiff_t(o * len),
+                  t.ints.begin() + ptrdiff_t(o * len + len));
+    }
+  set_constant(im, node.outputs[0], make_ints(out, std::move(ints)));
+  ++im.folded;
+}
+
+/**
+ * @brief Import Reshape with ONNX 0 (copy) and -1 (infer) semantics.
+ */
+static void import_reshape(Importer& im, const OnnxNode& node) {
+  const Shape x = input(im, node, 0).shape;
+  std::vector<int64_t> spec = im.opset < 5
+                                  ? attr_ints(node, "shape", {})
+                                  : as_ints(constant_input(im, node, 1));
+  size_t known = 1;
+  ptrdiff_t infer = -1;
+  for (size_t d = 0; d < spec.size(); ++d) {
+    if (spec[d] == 0 && attr_int(node, "allowzero", 0) == 0) {
+      if (d >= x.rank()) throw std::invalid_argument("invalid shape");
+      spec[d] = int64_t(x[d]);
+    }
+    if (spec[d] == -1) {
+      if (infer >= 0) throw std::invalid_argument("more than one -1");
+      infer = ptrdiff_t(d);
+    } else if (spec[d] < 0) {
+      throw std::invalid_argument("invalid shape");
+    } else {
+      known *= size_t(spec[d]);
+    }
+  }
+  if (infer >= 0) {
+    if (known == 0 || x.numel() % known != 0)
+      throw std::invalid_argument("cannot infer dimension");
+    spec[size_t(infer)] = int64_t(x.numel() / known);
+  }
+  reshape_input(im, node, to_shape(spec));
+}
+
+/**
+ * @brief Import Squeeze and Unsqueeze (axes as attribute or input).
+ */
+static void import_squeeze(Importer& im, const OnnxNode& node) {
+  const Shape x = input(im, node, 0).shape;
+  const bool unsqueeze = node.op_type == "Unsqueeze";
+  std::vector<int64_t> axes = has_input(node, 1)
+                                  ? as_ints(constant_input(im, node, 1))
+                                  : attr_ints(node, "axes", {});
+  std::vector<int64_t> dims;
+  if (unsqueeze) {
+    const size_t rank = x.rank() + axes.size();
+    std::vector<bool> inserted(rank);
+    for (int64_t a : axes) inserted[normalize_axis(a, rank)] = true;
+    for (size_t d = 0, s = 0; d < rank; ++d)
+      dims.push_back(inserted[d] ? 1 : int64_t(x[s++]));
+  } else {
+    std::vector<bool> removed(x.rank(), axes.empty());
+    for (int64_t a : axes) removed[normalize_axis(a, x.rank())] = true;
+    for (size_t d = 0; d < x.rank(); ++d) {
+      if (removed[d] && x[d] != 1) {
+        if (!axes.empty()) throw std::invalid_argument("axis is not 1");
+        removed[d] = false;
+      }
+      if (!removed[d]) dims.push_back(int64_t(x[d]));
+    }
+  }
+  reshape_input(im, node, to_shape(dims));
+}
+
+/**
+ * @brief Import Gemm with a constant right operand.
+ */
+static void import_gemm(Importer& im, const OnnxNode& node) {
+  const bool matmul = node.op_type == "MatMul";
+  if (!matmul && attr_int(node, "transA", 0) != 0)
+    throw std::invalid_argument("transA is not supported");
+  const Tensor<float> b = as_floats(constant_input(im, node, 1));
+  if (b.rank() != 2) throw std::invalid_argument("B must be a matrix");
+  const bool trans_b = !matmul && attr_int(node, "transB", 0) != 0;
+  const float alpha = matmul ? 1.f : attr_float(node, "alpha", 1.f);
+  const float beta = matmul ? 0.f : attr_float(node, "beta", 1.f);
+  const size_t n = trans_b ? b.dim(0) : b.dim(1);
+  const size_t k = trans_b ? b.dim(1) : b.dim(0);
+  Tensor<float> weight(Shape{n, k});
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < k; ++j)
+      weight[i * k + j] = alpha * (trans_b ? b[i * k + j] : b[j * n + i]);
+  Tensor<float> bias;
+  if (!matmul && has_input(node, 2)) {
+    const OnnxTensor& c = constant_input(im, node, 2);
+    const size_t cn = c.shape.numel();
+    if (cn != 1 && cn != n)
+      throw std::invalid_argument("C must be a scalar or [N]");
+    bias = Tensor<float>(Shape{n});
+    for (size_t i = 0; i < n; ++i)
+      bias[i] = beta * float(element(c, cn == 1 ? 0 : i));
+  }
+  emit(im, node.outputs[0], std::make_shared<LinearOp>(weight, bias),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Import Transpose.
+ */
+static void import_transpose(Importer& im, const OnnxNode& node) {
+  const size_t rank = input(im, node, 0).shape.rank();
+  std::vector<int64_t> perm = attr_ints(node, "perm", {});
+  if (perm.empty())
+    for (size_t d = rank; d-- > 0;) perm.push_back(int64_t(d));
+  std::vector<size_t> p;
+  for (int64_t v : perm) p.push_back(normalize_axis(v, rank));
+  emit(im, node.outputs[0], std::make_shared<TransposeOp>(p),
+       {node.inputs[0]});
+}
+
+/**
+ * @brief Import Constant.
+ */
+static void import_constant(Importer& im, const OnnxNode& node) {
+  if (node.attributes.size() != 1)
+    throw std::invalid_argument("expected one value attribute");
+  const OnnxAttribute& a = node.attributes[0];
+  OnnxTensor t;
+  if (a.name == "value" && a.t) {
+    t = *a.t;
+  } else if (a.name == "value_float") {
+    Tensor<float> v(Shape{});
+    v[0] = a.f;
+    t = make_floats(v);
+  } else if (a.name == "value_floats") {
+    Tensor<float> v(Shape{a.floats.size()});
+    std::copy(a.floats.begin(), a.floats.end(), v.data());
+    t = make_floats(v);
+  } else if (a.name == "value_int") {
+    t = make_ints(Shape{}, {a.i});
+  } else if (a.name == "value_ints") {
+    t = make_ints(Shape{a.ints.size()}, a.ints);
+  } else {
+    throw std::invalid_argument("unsupported value attribute " + a.name);
+  }
+  set_constant(im, node.outputs[0], std::move(t));
+}
+
+/**
+ * @brief Import Shape (folded from the inferred shape).
+ */
+static void import_shape(Importer& im, const OnnxNode& node) {
+  const Shape x = input(im, node, 0).shape;
+  const int64_t rank = int64_t(x.rank());
+  const auto clamp = [&](int64_t v) {
+    return std::clamp<int64_t>(v < 0 ? v + rank : v, 0, rank);
+  };
+  const int64_t start = clamp(attr_int(node, "start", 0));
+  const int64_t end = clamp(attr_int(node, "end", rank));
+  std::vector<int64_t> dims;
+  for (int64_t d = start; d < end; ++d) dims.push_back(int64_t(x[size_t(d)]));
+  const size_t n = dims.size();
+  set_constant(im, node.outputs[0], make_ints(Shape{n}, std::move(dims)));
+  ++im.folded;
+}
+
+/**
+ * @brief Import Gather on constants.
+ */
+static void import_gather(Importer& im, const OnnxNode& node) {
+  const OnnxTensor& data = constant_input(im, node, 0);
+  const std::vector<int64_t> indices = as_ints(constant_input(im, node, 1));
+  const Shape& index_shape = input(im, node, 1).shape;
+  const size_t axis = normalize_axis(attr_int(node, "axis", 0),
+                                     data.shape.rank());
+  const size_t extent = data.shape[axis];
+  size_t outer = 1, inner = 1;
+  Shape out;
+  for (size_t d = 0; d < axis; ++d) {
+    outer *= data.shape[d];
+    out.push_back(data.shape[d]);
+  }
+  for (size_t d = 0; d < index_shape.rank(); ++d) out.push_back(index_shape[d]);
+  for (size_t d = axis + 1; d < data.shape.rank(); ++d) {
+    inner *= data.shape[d];
+    out.push_back(data.shape[d]);
+  }
+  std::vector<size_t> source;
+  for (size_t o = 0; o < outer; ++o)
+    for (int64_t index : indices) {
+      const int64_t i = index < 0 ? index + int64_t(extent) : index;
+      if (i < 0 || i >= int64_t(extent))
+        throw std::invalid_argument("index out of range");
+      for (size_t j = 0; j < inner; ++j)
+        source.push_back((o * extent + size_t(i)) * inner + j);
+    }
+  OnnxTensor r;
+  r.shape = out;
+  r.integer = data.integer;
+  if (data.integer) {
+    for (size_t s : source) r.ints.push_back(data.ints[s]);
+  } else {
+    r.data = Tensor<float>(out);
+    for (size_t i = 0; i < source.size(); ++i) r.data[i] = data.data[source[i]];
+  }
+  set_constant(im, node.outputs[0], std::move(r));
+  ++im.folded;
+}
+
+/**
+ * @brief Import Slice on one-dimensional constants.
+ */
+static void import_slice(Importer& im, const OnnxNode& node) {
+  const OnnxTensor& data = constant_input(im, node, 0);
+  if (data.shape.rank() != 1)
+    throw std::invalid_argument("only 1-D constants can be sliced");
+  std::vector<int64_t> starts, ends, axes, steps;
+  if (im.opset < 10) {
+    starts = attr_ints(node, "starts", {});
+    ends = attr_ints(node, "ends", {});
+    axes = attr_ints(node, "axes", {0});
+  } else {
+    starts = as_ints(constant_input(im, node, 1));
+    ends = as_ints(constant_input(im, node, 2));
+    axes = has_input(node, 3) ? as_ints(constant_input(im, node, 3))
+                              : std::vector<int64_t>{0};
+    if (has_input(node, 4)) steps = as_ints(constant_input(im, node, 4));
+  }
+  if (steps.empty()) steps = {1};
+  if (starts.size() != 1 || ends.size() != 1 || axes.size() != 1 ||
+      steps.size() != 1 || normalize_axis(axes[0], 1) != 0 || steps[0] == 0)
+    throw std::invalid_argument("invalid slice");
+  const int64_t n = int64_t(data.shape[0]), step = steps[0];
+  const auto resolve = [&](int64_t v, int64_t lo, int64_t hi) {
+    if (v < 0) v = v < -n ? -1 : v + n;  // avoid overflow on INT64_MIN
+    return std::clamp(v, lo, hi);
+  };
+  const int64_t begin = step > 0 ? resolve(starts[0], 0, n)
+                                 : resolve(starts[0], -1, n - 1);
+  const int64_t end = step > 0 ? resolve(ends[0], 0, n)
+                               : resolve(ends[0], -1, n - 1);
+  std::vector<size_t> source;
+  for (int64_t i = begin; step > 0 ? i < end : i > end; i += step)
+    source.push_back(size_t(i));
+  OnnxTensor r;
+  r.shape = Shape{source.size()};
+  r.integer = data.integer;
+  if (data.integer) {
+    for (size_t s : source) r.ints.push_back(data.ints[s]);
+  } else {
+    r.data = Tensor<float>(r.shape);
+    for (size_t i = 0; i < source.size(); ++i) r.data[i] = data.data[source[i]];
+  }
+  set_constant(im, node.outputs[0], std::move(r));
+  ++im.folded;
+}
+
+/**
+ * @brief Import Cast (to float at run time, any supported type on
+ * constants).
+ */
+static void import_cast(Importer& im, const OnnxNode& node) {
+  const ImportValue& x = input(im, node, 0);
+  const int64_t to = attr_int(node, "to", kOnnxFloat);
+  const bool integer = to == kOnnxInt32 || to == kOnnxInt64;
+  if (!integer && to != kOnnxFloat && to != kOnnxDouble)
+    throw std::invalid_argument("unsupported target type");
+  if (!x.is_constant) {
+    if (integer) throw std::invalid_argument("cannot cast to an integer type");
+    im.values[node.outputs[0]] = x;
+    return;
+  }
+  OnnxTensor t = integer ? make_ints(x.shape, as_ints(x.constant))
+                         : make_floats(as_floats(x.constant));
+  set_constant(im, node.outputs[0], std::move(t));
+  ++im.folded;
+}
+
+/**
+ * @brief Import one node.
+ */
+static void import_node(Importer& im, const OnnxNode& node) {
+  const std::string& type = node.op_type;
+  const std::string& out = node.outputs[0];
+  if (!node.domain.empty() && node.domain != "ai.onnx")
+    throw std::invalid_argument("unsupported domain " + node.domain);
+  if (type == "Conv") {
+    import_conv(im, node);
+  } else if (type == "BatchNormalization") {
+    const float eps = attr_float(node, "epsilon", 1e-5f);
+    Tensor<float> p[4];
+    for (size_t i = 0; i < 4; ++i)
+      p[i] = as_floats(constant_input(im, node, i + 1));
+    emit(im, out, std::make_shared<BatchNormOp>(p[0], p[1], p[2], p[3], eps),
+         {node.inputs[0]});
+  } else if (type == "Relu") {
+    emit(im, out, std::make_shared<ReluOp>(), {node.inputs[0]});
+  } else if (type == "Clip") {
+    import_clip(im, node);
+  } else if (type == "LeakyRelu") {
+    emit(im, out,
+         std::make_shared<LeakyReluOp>(attr_float(node, "alpha", 0.01f)),
+         {node.inputs[0]});
+  } else if (type == "Sigmoid") {
+    emit(im, out, std::make_shared<SigmoidOp>(), {node.inputs[0]});
+  } else if (type == "Add" || type == "Sub" || type == "Mul" ||
+             type == "Div") {
+    import_binary(im, node);
+  } else if (type == "MaxPool") {
+    import_max_pool(im, node);
+  } else if (type == "GlobalAveragePool") {
+    emit(im, out, std::make_shared<GlobalAveragePoolOp>(), {node.inputs[0]});
+  } else if (type == "Concat") {
+    import_concat(im, node);
+  } else if (type == "Resize" || type == "Upsample") {
+    import_resize(im, node);
+  } else if (type == "Reshape") {
+    import_reshape(im, node);
+  } else if (type == "Flatten") {
+    const Shape x = input(im, node, 0).shape;
+    const size_t axis =
+        normalize_axis(attr_int(node, "axis", 1), x.rank(), true);
+    size_t outer = 1;
+    for (size_t d = 0; d < axis; ++d) outer *= x[d];
+    reshape_input(im, node, Shape{outer, outer ? x.numel() / outer : 0});
+  } else if (type == "Squeeze" || type == "Unsqueeze") {
+    import_squeeze(im, node);
+  } else if (type == "Transpose") {
+    import_transpose(im, node);
+  } else if (type == "Gemm" || type == "MatMul") {
+    import_gemm(im, node);
+  } else if (type == "Identity" || type == "Dropout") {
+    im.values[out] = input(im, node, 0);
+  } else if (type == "Cast") {
+    import_cast(im, node);
+  } else if (type == "Constant") {
+    import_constant(im, node);
+  } else if (type == "Shape") {
+    import_shape(im, node);
+  } else if (type == "Gather") {
+    import_gather(im, node);
+  } else if (type == "Slice") {
+    import_slice(im, node);
+  } else {
+    throw std::invalid_argument("unsupported operator");
+  }
+}
+
+/**
+ * @brief Import an ONNX model into an inference graph.
+ */
+OnnxModel import_onnx(std::span<const uint8_t> model,
+                      const OnnxImportOptions& options) {
+  Importer im;
+  std::span<const uint8_t> graph_bytes;
+  bool has_graph = false, has_opset = false;
+  ProtoReader reader(model);
+  ProtoField f;
+  while (reader.next(f)) {
+    if (f.number == 7) {
+      nested(f);
+      graph_bytes = f.bytes;
+      has_graph = true;
+    } else if (f.number == 8) {
+      ProtoReader opset = nested(f);
+      ProtoField of;
+      std::string domain;
+      int64_t version = 0;
+      while (opset.next(of)) {
+        if (of.number == 1) domain = string_field(of);
+        if (of.number == 2) version = of.asInt64();
+      }
+      if (domain.empty() || domain == "ai.onnx") {
+        im.opset = version;
+        has_opset = true;
+      }
+    }
+  }
+  if (!has_graph) throw std::runtime_error("onnx: model has no graph");
+  if (!has_opset) throw std::runtime_error("onnx: model has no opset");
+
+  std::vector<OnnxNode> nodes;
+  std::vector<OnnxValueInfo> inputs;
+  std::vector<std::string> outputs;
+  std::unordered_set<std::string> initializers;
+  ProtoReader graph(graph_bytes);
+  while (graph.next(f)) {
+    switch (f.number) {
+      case 1: nodes.push_back(parse_node(f)); break;
+      case 5: {
+        ProtoReader t = nested(f);
+        ProtoField tf;
+        std::string name;
+        while (t.next(tf))
+          if (tf.number == 8) name = string_field(tf);
+        set_constant(im, name, parse_tensor(f));
+        initializers.insert(name);
+        break;
+      }
+      case 11: inputs.push_back(parse_value_info(f)); break;
+      case 12: outputs.push_back(parse_value_info(f).name); break;
+      default: break;
+    }
+  }
+
+  // Older exporters also list initializers as graph inputs.
+  std::erase_if(inputs, [&](const OnnxValueInfo& v) {
+    return initializers.count(v.name) != 0;
+  });
+  OnnxModel result;
+  if (!options.input_shapes.empty() &&
+      options.input_shapes.size() != inputs.size())
+    throw std::invalid_argument("onnx: expected " +
+                                std::to_string(inputs.size()) +
+                                " input shape(s)");
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    Shape shape;
+    if (!options.input_shapes.empty()) {
+      shape = options.input_shapes[i];
+    } else {
+      if (!inputs[i].has_shape)
+        throw std::invalid_argument("onnx: input '" + inputs[i].name +
+                                    "' has no shape; pass input_shapes");
+      std::vector<int64_t> dims = inputs[i].dims;
+      for (int64_t& d : dims)
+        if (d <= 0) d = 1;  // symbolic (e.g. batch)
+      shape = to_shape(dims);
+    }
+    ImportValue v;
+    v.id = im.graph->addInput(inputs[i].name);
+    v.shape = shape;
+    im.values[inputs[i].name] = v;
+    result.input_shapes.push_back(shape);
+  }
+
+  for (const OnnxNode& node : nodes) {
+    try {
+      import_node(im, node);
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument("onnx: node '" +
+                                  (node.name.empty() ? node.outputs[0]
+                                                     : node.name) +
+                                  "' (" + node.op_type + "): " + e.what());
+    }
+  }
+  for (const std::string& name : outputs) {
+    if (!im.values.count(name))
+      throw std::runtime_error("onnx: output '" + name + "' is not produced");
+    im.graph->addOutput(value_id(im, name));
+  }
+  result.graph = std::move(im.graph);
+  result.opset = im.opset;
+  result.folded_nodes = im.folded;
+  return result;
+}
+
+/**
+ * @brief Import an ONNX model file into an inference graph.
+ */
+OnnxModel import_onnx_file(const std::string& path,
+                           const OnnxImportOptions& options) {
+  const MappedFile file(path);
+  return import_onnx({file.data(), file.size()}, options);
+}
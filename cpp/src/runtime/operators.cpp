@@ -0,0 +1,578 @@
+#include "runtime/operators.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "ops/gemm.h"
+#include "utils/parallel.h"
+
+/** Elements per parallel chunk of elementwise operators. */
+static constexpr size_t kElementGrain = size_t(1) << 14;
+
+/**
+ * @brief Check the input count of an operator.
+ */
+static void expect_inputs(size_t count, size_t expected, const char* type) {
+  if (count != expected)
+    throw std::invalid_argument(std::string(type) + ": expected " +
+                                std::to_string(expected) + " input(s)");
+}
+
+/**
+ * @brief Prepare a convolution node.
+ */
+Conv2dOp::Conv2dOp(const Tensor<float>& weight, const Tensor<float>& bias,
+                   const Conv2dParams& params, ConvLayout layout,
+                   ConvAlgorithm algorithm, std::vector<GemmPackedA> prepacked)
+    : weight_(weight), bias_(bias),
+      conv_(weight, bias, params, layout, algorithm, std::move(prepacked)) {}
+
+/**
+ * @brief Derive a layer computing `conv(x) * scale[c] + shift[c]`.
+ */
+std::shared_ptr<Conv2dOp> Conv2dOp::foldAffine(
+    const Tensor<float>& scale, const Tensor<float>& shift) const {
+  const size_t co = conv_.outChannels();
+  if (scale.shape() != Shape{co} || shift.shape() != Shape{co})
+    throw std::invalid_argument("Conv2d: affine must be [C_out]");
+  if (residual_ || clamp_min_ > -std::numeric_limits<float>::infinity() ||
+      clamp_max_ < std::numeric_limits<float>::infinity())
+    throw std::invalid_argument("Conv2d: cannot fold after an epilogue");
+  Tensor<float> weight = weight_.clone();
+  Tensor<float> bias(Shape{co});
+  const size_t per_filter = weight.numel() / co;
+  for (size_t c = 0; c < co; ++c) {
+    float* f = weight.data() + c * per_filter;
+    for (size_t i = 0; i < per_filter; ++i) f[i] *= scale[c];
+    bias[c] = (bias_.empty() ? 0.f : bias_[c]) * scale[c] + shift[c];
+  }
+  // The folded layer keeps the algorithm the original one selected.
+  return std::make_shared<Conv2dOp>(weight, bias, conv_.params(),
+                                    conv_.layout(), conv_.algorithm());
+}
+
+/**
+ * @brief Derive a node that also adds a second input to the output.
+ */
+std::shared_ptr<Conv2dOp> Conv2dOp::withResidual() const {
+  auto op = std::make_shared<Conv2dOp>(*this);
+  op->residual_ = true;
+  return op;
+}
+
+/**
+ * @brief Derive a node that also clamps the output to [lo, hi].
+ */
+std::shared_ptr<Conv2dOp> Conv2dOp::withClamp(float lo, float hi) const {
+  auto op = std::make_shared<Conv2dOp>(*this);
+  op->clamp_min_ = std::max(clamp_min_, lo);
+  op->clamp_max_ = std::min(clamp_max_, hi);
+  return op;
+}
+
+/**
+ * @brief Derive a node running the same layer with another algorithm.
+ */
+std::shared_ptr<Conv2dOp> Conv2dOp::withAlgorithm(
+    ConvAlgorithm algorithm) const {
+  auto op = std::make_shared<Conv2dOp>(weight_, bias_, conv_.params(),
+                                       conv_.layout(), algorithm);
+  op->residual_ = residual_;
+  op->clamp_min_ = clamp_min_;
+  op->clamp_max_ = clamp_max_;
+  return op;
+}
+
+/**
+ * @brief Infer the output shape of the convolution.
+ */
+Shape Conv2dOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), residual_ ? 2 : 1, type());
+  const Shape out = conv_.outputShape(inputs[0]);
+  if (residual_ && inputs[1] != out)
+    throw std::invalid_argument("Conv2d: residual shape mismatch");
+  return out;
+}
+
+/**
+ * @brief Run the convolution and its epilogue.
+ */
+void Conv2dOp::forward(std::span<const Tensor<float>* const> inputs,
+                       Tensor<float>& output) const {
+  ConvEpilogue epilogue;
+  epilogue.residual = residual_ ? inputs[1] : nullptr;
+  epilogue.clamp_min = clamp_min_;
+  epilogue.clamp_max = clamp_max_;
+  conv_.forward(*inputs[0], output, epilogue);
+}
+
+/**
+ * @brief Fold batch-norm statistics into a per-channel affine transform.
+ */
+BatchNormOp::BatchNormOp(const Tensor<float>& gamma, const Tensor<float>& beta,
+                         const Tensor<float>& mean, const Tensor<float>& var,
+                         float eps) {
+  const Shape& shape = gamma.shape();
+  if (shape.rank() != 1 || beta.shape() != shape || mean.shape() != shape ||
+      var.shape() != shape)
+    throw std::invalid_argument("BatchNorm: parameters must all be [C]");
+  scale_ = Tensor<float>(shape);
+  shift_ = Tensor<float>(shape);
+  for (size_t c = 0; c < shape[0]; ++c) {
+    scale_[c] = gamma[c] / std::sqrt(var[c] + eps);
+    shift_[c] = beta[c] - mean[c] * scale_[c];
+  }
+}
+
+/**
+ * @brief Create a per-channel affine transform directly.
+ */
+BatchNormOp::BatchNormOp(const Tensor<float>& scale, const Tensor<float>& shift)
+    : scale_(scale.clone()), shift_(shift.clone()) {
+  if (scale.rank() != 1 || shift.shape() != scale.shape())
+    throw std::invalid_argument("BatchNorm: scale and shift must be [C]");
+}
+
+/**
+ * @brief Infer the output shape of the batch normalization.
+ */
+Shape BatchNormOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].rank() < 2 || inputs[0][1] != scale_.numel())
+    throw std::invalid_argument("BatchNorm: channel count mismatch");
+  return inputs[0];
+}
+
+/**
+ * @brief Apply the per-channel affine transform.
+ */
+void BatchNormOp::forward(std::span<const Tensor<float>* const> inputs,
+                          Tensor<float>& output) const {
+  const Tensor<float>& x = *inputs[0];
+  const size_t c = x.dim(1), plane = x.numel() / (x.dim(0) * c);
+  const float* in = x.data();
+  float* out = output.data();
+  parallel_for(0, x.dim(0) * c, 1, [&](size_t first, size_t last) {
+    for (size_t nc = first; nc < last; ++nc) {
+      const float a = scale_[nc % c], b = shift_[nc % c];
+      const float* src = in + nc * plane;
+      float* dst = out + nc * plane;
+      for (size_t i = 0; i < plane; ++i) dst[i] = src[i] * a + b;
+    }
+  });
+}
+
+/**
+ * @brief Create a clamp to [min, max].
+ */
+ClipOp::ClipOp(float min, float max) : min_(min), max_(max) {
+  if (!(min <= max)) throw std::invalid_argument("Clip: min > max");
+}
+
+/**
+ * @brief Infer the output shape of the clamp.
+ */
+Shape ClipOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  return inputs[0];
+}
+
+/**
+ * @brief Clamp every element.
+ */
+void ClipOp::forward(std::span<const Tensor<float>* const> inputs,
+                     Tensor<float>& output) const {
+  const float* in = inputs[0]->data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), kElementGrain, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i)
+      out[i] = std::min(std::max(in[i], min_), max_);
+  });
+}
+
+/**
+ * @brief Infer the output shape of the sum.
+ */
+Shape AddOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 2, type());
+  if (inputs[0] != inputs[1])
+    throw std::invalid_argument("Add: input shapes differ");
+  return inputs[0];
+}
+
+/**
+ * @brief Add the two inputs and clamp.
+ */
+void AddOp::forward(std::span<const Tensor<float>* const> inputs,
+                    Tensor<float>& output) const {
+  const float* a = inputs[0]->data();
+  const float* b = inputs[1]->data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), kElementGrain, [&](size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; ++i)
+      out[i] = std::min(std::max(a[i] + b[i], clamp_min_), clamp_max_);
+  });
+}
+
+/**
+ * @brief Create a pooling operator.
+ */
+MaxPool2dOp::MaxPool2dOp(size_t kernel, size_t stride, size_t pad)
+    : kernel_(kernel), stride_(stride), pad_(pad) {
+  if (kernel == 0 || stride == 0 || pad >= kernel)
+    throw std::invalid_argument("MaxPool2d: need kernel, stride > 0 and "
+                                "pad < kernel");
+}
+
+/**
+ * @brief Infer the output shape of the pooling.
+ */
+Shape MaxPool2dOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  const Shape& in = inputs[0];
+  if (in.rank() != 4) throw std::invalid_argument("MaxPool2d: expected NCHW");
+  const size_t oh = conv_output_size(in[2], kernel_, stride_, pad_, pad_, 1);
+  const size_t ow = conv_output_size(in[3], kernel_, stride_, pad_, pad_, 1);
+  if (oh == 0 || ow == 0)
+    throw std::invalid_argument("MaxPool2d: window larger than input");
+  return Shape{in[0], in[1], oh, ow};
+}
+
+/**
+ * @brief Take the maximum over every window.
+ */
+void MaxPool2dOp::forward(std::span<const Tensor<float>* const> inputs,
+                          Tensor<float>& output) const {
+  const Tensor<float>& x = *inputs[0];
+  const size_t h = x.dim(2), w = x.dim(3);
+  const size_t oh = output.dim(2), ow = output.dim(3);
+  const float* in = x.data();
+  float* out = output.data();
+  parallel_for(0, x.dim(0) * x.dim(1), 1, [&](size_t first, size_t last) {
+    for (size_t nc = first; nc < last; ++nc) {
+      const float* plane = in + nc * h * w;
+      float* dst = out + nc * oh * ow;
+      for (size_t oy = 0; oy < oh; ++oy) {
+        const size_t y0 = oy * stride_ >= pad_ ? oy * stride_ - pad_ : 0;
+        const size_t y1 = std::min(h, oy * stride_ + kernel_ - pad_);
+        for (size_t ox = 0; ox < ow; ++ox) {
+          const size_t x0 = ox * stride_ >= pad_ ? ox * stride_ - pad_ : 0;
+          const size_t x1 = std::min(w, ox * stride_ + kernel_ - pad_);
+          float m = -std::numeric_limits<float>::infinity();
+          for (size_t y = y0; y < y1; ++y)
+            for (size_t xx = x0; xx < x1; ++xx)
+              m = std::max(m, plane[y * w + xx]);
+          dst[oy * ow + ox] = m;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Infer the output shape of the pooling.
+ */
+Shape GlobalAveragePoolOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].rank() != 4)
+    throw std::invalid_argument("GlobalAveragePool: expected NCHW");
+  return Shape{inputs[0][0], inputs[0][1], 1, 1};
+}
+
+/**
+ * @brief Average every channel plane.
+ */
+void GlobalAveragePoolOp::forward(std::span<const Tensor<float>* const> inputs,
+                                  Tensor<float>& output) const {
+  const Tensor<float>& x = *inputs[0];
+  const size_t plane = x.dim(2) * x.dim(3);
+  const float* in = x.data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), 1, [&](size_t first, size_t last) {
+    for (size_t nc = first; nc < last; ++nc) {
+      const float* src = in + nc * plane;
+      float sum = 0.f;
+      for (size_t i = 0; i < plane; ++i) sum += src[i];
+      out[nc] = sum / float(plane);
+    }
+  });
+}
+
+/**
+ * @brief Infer the output shape of the sigmoid.
+ */
+Shape SigmoidOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  return inputs[0];
+}
+
+/**
+ * @brief Apply the logistic function to every element.
+ */
+void SigmoidOp::forward(std::span<const Tensor<float>* const> inputs,
+                        Tensor<float>& output) const {
+  const float* in = inputs[0]->data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), kElementGrain, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i) out[i] = 1.f / (1.f + std::exp(-in[i]));
+  });
+}
+
+/**
+ * @brief Infer the output shape of the leaky ReLU.
+ */
+Shape LeakyReluOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  return inputs[0];
+}
+
+/**
+ * @brief Apply the leaky ReLU to every element.
+ */
+void LeakyReluOp::forward(std::span<const Tensor<float>* const> inputs,
+                          Tensor<float>& output) const {
+  const float* in = inputs[0]->data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), kElementGrain, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i)
+      out[i] = in[i] >= 0.f ? in[i] : alpha_ * in[i];
+  });
+}
+
+/**
+ * @brief Infer the output shape of the product.
+ */
+Shape MulOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 2, type());
+  if (inputs[0] != inputs[1])
+    throw std::invalid_argument("Mul: input shapes differ");
+  return inputs[0];
+}
+
+/**
+ * @brief Multiply the two inputs.
+ */
+void MulOp::forward(std::span<const Tensor<float>* const> inputs,
+                    Tensor<float>& output) const {
+  const float* a = inputs[0]->data();
+  const float* b = inputs[1]->data();
+  float* out = output.data();
+  parallel_for(0, output.numel(), kElementGrain, [&](size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; ++i) out[i] = a[i] * b[i];
+  });
+}
+
+/**
+ * @brief Infer the output shape of the concatenation.
+ */
+Shape ConcatOp::outputShape(std::span<const Shape> inputs) const {
+  if (inputs.empty()) throw std::invalid_argument("Concat: no inputs");
+  Shape out = inputs[0];
+  if (axis_ >= out.rank()) throw std::invalid_argument("Concat: bad axis");
+  size_t total = 0;
+  for (const Shape& s : inputs) {
+    if (s.rank() != out.rank())
+      throw std::invalid_argument("Concat: input ranks differ");
+    for (size_t d = 0; d < s.rank(); ++d)
+      if (d != axis_ && s[d] != out[d])
+        throw std::invalid_argument("Concat: input shapes differ");
+    total += s[axis_];
+  }
+  Shape result;
+  for (size_t d = 0; d < out.rank(); ++d)
+    result.push_back(d == axis_ ? total : out[d]);
+  return result;
+}
+
+/**
+ * @brief Copy the inputs side by side along the axis.
+ */
+void ConcatOp::forward(std::span<const Tensor<float>* const> inputs,
+                       Tensor<float>& output) const {
+  size_t outer = 1, inner = 1;
+  for (size_t d = 0; d < axis_; ++d) outer *= output.dim(d);
+  for (size_t d = axis_ + 1; d < output.rank(); ++d) inner *= output.dim(d);
+  const size_t row = output.dim(axis_) * inner;
+  size_t at = 0;
+  for (const Tensor<float>* x : inputs) {
+    const size_t len = x->dim(axis_) * inner;
+    const float* src = x->data();
+    float* dst = output.data() + at;
+    parallel_for(0, outer, std::max<size_t>(1, kElementGrain / (len + 1)),
+                 [&](size_t b, size_t e) {
+                   for (size_t o = b; o < e; ++o)
+                     std::copy_n(src + o * len, len, dst + o * row);
+                 });
+    at += len;
+  }
+}
+
+/**
+ * @brief Create an upsampling operator.
+ */
+UpsampleNearestOp::UpsampleNearestOp(size_t scale_h, size_t scale_w)
+    : scale_h_(scale_h), scale_w_(scale_w) {
+  if (scale_h == 0 || scale_w == 0)
+    throw std::invalid_argument("UpsampleNearest: factors must be > 0");
+}
+
+/**
+ * @brief Infer the output shape of the upsampling.
+ */
+Shape UpsampleNearestOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  const Shape& in = inputs[0];
+  if (in.rank() != 4)
+    throw std::invalid_argument("UpsampleNearest: expected NCHW");
+  return Shape{in[0], in[1], in[2] * scale_h_, in[3] * scale_w_};
+}
+
+/**
+ * @brief Repeat every pixel scale_h x scale_w times.
+ */
+void UpsampleNearestOp::forward(std::span<const Tensor<float>* const> inputs,
+                                Tensor<float>& output) const {
+  const Tensor<float>& x = *inputs[0];
+  const size_t h = x.dim(2), w = x.dim(3), ow = output.dim(3);
+  const float* in = x.data();
+  float* out = output.data();
+  parallel_for(0, x.dim(0) * x.dim(1) * h, 16, [&](size_t first, size_t last) {
+    for (size_t r = first; r < last; ++r) {
+      const float* src = in + r * w;
+      float* dst = out + r * scale_h_ * ow;
+      for (size_t xx = 0; xx < w; ++xx)
+        std::fill_n(dst + xx * scale_w_, scale_w_, src[xx]);
+      for (size_t k = 1; k < scale_h_; ++k)
+        std::copy_n(dst, ow, dst + k * ow);
+    }
+  });
+}
+
+/**
+ * @brief Infer the output shape of the reshape.
+ */
+Shape ReshapeOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].numel() != shape_.numel())
+    throw std::invalid_argument("Reshape: element count mismatch");
+  return shape_;
+}
+
+/**
+ * @brief Copy the input.
+ */
+void ReshapeOp::forward(std::span<const Tensor<float>* const> inputs,
+                        Tensor<float>& output) const {
+  std::copy_n(inputs[0]->data(), output.numel(), output.data());
+}
+
+/**
+ * @brief Create a transpose.
+ */
+TransposeOp::TransposeOp(std::vector<size_t> perm) : perm_(std::move(perm)) {
+  std::vector<bool> seen(perm_.size());
+  for (size_t p : perm_) {
+    if (p >= perm_.size() || seen[p])
+      throw std::invalid_argument("Transpose: not a permutation");
+    seen[p] = true;
+  }
+}
+
+/**
+ * @brief Infer the output shape of the transpose.
+ */
+Shape TransposeOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].rank() != perm_.size())
+    throw std::invalid_argument("Transpose: rank mismatch");
+  Shape out;
+  for (size_t p : perm_) out.push_back(inputs[0][p]);
+  return out;
+}
+
+/**
+ * @brief Gather the input in permuted order.
+ */
+void TransposeOp::forward(std::span<const Tensor<float>* const> inputs,
+                          Tensor<float>& output) const {
+  const Tensor<float>& x = *inputs[0];
+  const size_t rank = perm_.size();
+  if (rank == 0) {
+    output[0] = x[0];
+    return;
+  }
+  // Input stride of every output dimension.
+  size_t in_strides[kMaxTensorRank] = {}, strides[kMaxTensorRank] = {};
+  for (size_t d = rank, s = 1; d-- > 0;) {
+    in_strides[d] = s;
+    s *= x.dim(d);
+  }
+  for (size_t d = 0; d < rank; ++d) strides[d] = in_strides[perm_[d]];
+  const size_t inner = output.dim(rank - 1);
+  const size_t inner_stride = strides[rank - 1];
+  const float* in = x.data();
+  float* out = output.data();
+  parallel_for(0, output.numel() / inner, 16, [&](size_t first, size_t last) {
+    for (size_t row = first; row < last; ++row) {
+      size_t src = 0;
+      for (size_t d = rank - 1, r = row; d-- > 0;) {
+        src += r % output.dim(d) * strides[d];
+        r /= output.dim(d);
+      }
+      float* dst = out + row * inner;
+      for (size_t i = 0; i < inner; ++i) dst[i] = in[src + i * inner_stride];
+    }
+  });
+}
+
+/**
+ * @brief Create a fully connected layer.
+ */
+LinearOp::LinearOp(const Tensor<float>& weight, const Tensor<float>& bias)
+    : weight_(weight), bias_(bias) {
+  if (weight.rank() != 2 ||
+      (!bias.empty() && bias.shape() != Shape{weight.dim(0)}))
+    throw std::invalid_argument("Linear: weight must be [N, K], bias [N]");
+}
+
+/**
+ * @brief Infer the output shape of the layer.
+ */
+Shape LinearOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].rank() != 2 || inputs[0][1] != weight_.dim(1))
+    throw std::invalid_argument("Linear: input must be [M, K]");
+  return Shape{inputs[0][0], weight_.dim(0)};
+}
+
+/**
+ * @brief Multiply by the transposed weights and add the bias.
+ */
+void LinearOp::forward(std::span<const Tensor<float>* const> inputs,
+                       Tensor<float>& output) const {
+  const size_t m = output.dim(0), n = output.dim(1), k = weight_.dim(1);
+  sgemm(false, true, m, n, k, 1.f, inputs[0]->data(), k, weight_.data(), k,
+        0.f, output.data(), n);
+  if (bias_.empty()) return;
+  for (size_t i = 0; i < m; ++i)
+    for (size_t j = 0; j < n; ++j) output[i * n + j] += bias_[j];
+}
+
+/**
+ * @brief Infer the output shape of the constant.
+ */
+Shape ConstantOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 0, type());
+  return value_.shape();
+}
+
+/**
+ * @brief Copy the constant to the output.
+ */
+void ConstantOp::forward(std::span<const Tensor<float>* const>,
+                         Tensor<float>& output) const {
+  std::copy_n(value_.data(), output.numel(), output.data());
+}
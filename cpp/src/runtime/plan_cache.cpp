@@ -0,0 +1,152 @@
+#include "runtime/plan_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Encode input shapes as rank-prefixed dimension lists.
+ */
+static std::vector<size_t> shape_key(const std::vector<Shape>& shapes) {
+  std::vector<size_t> key;
+  for (const Shape& shape : shapes) {
+    key.push_back(shape.rank());
+    for (size_t d : shape) key.push_back(d);
+  }
+  return key;
+}
+
+/**
+ * @brief Create an empty cache.
+ */
+PlanCache::PlanCache(std::shared_ptr<const Graph> graph, size_t capacity)
+    : graph_(std::move(graph)), capacity_(capacity) {
+  if (!graph_) throw std::invalid_argument("PlanCache: null graph");
+  if (capacity_ == 0)
+    throw std::invalid_argument("PlanCache: capacity must be positive");
+}
+
+/**
+ * @brief Create an empty cache building one graph per set of shapes.
+ */
+PlanCache::PlanCache(GraphBuilder builder, size_t capacity)
+    : builder_(std::move(builder)), capacity_(capacity) {
+  if (!builder_) throw std::invalid_argument("PlanCache: empty builder");
+  if (capacity_ == 0)
+    throw std::invalid_argument("PlanCache: capacity must be positive");
+}
+
+/**
+ * @brief Specialize plans with the configurations of a tuning database.
+ */
+void PlanCache::setTuning(std::shared_ptr<TuningDatabase> db, bool autotune,
+                          AutotuneOptions options) {
+  tuning_ = std::move(db);
+  autotune_ = autotune && tuning_;
+  autotune_options_ = std::move(options);
+  index_.clear();
+  entries_.clear();
+}
+
+/**
+ * @brief Build the (tuned) executor for a set of input shapes.
+ */
+std::shared_ptr<Executor> PlanCache::plan(
+    const std::vector<Shape>& input_shapes) {
+  std::shared_ptr<const Graph> graph =
+      builder_ ? builder_(input_shapes) : graph_;
+  if (!graph) throw std::invalid_argument("PlanCache: builder gave no graph");
+  if (!tuning_) return std::make_shared<Executor>(graph, input_shapes);
+  if (autotune_) {
+    const bool had_gemm = tuning_->gemm().has_value();
+    const size_t tuned =
+        autotune(*graph, input_shapes, *tuning_, autotune_options_);
+    if ((tuned || !had_gemm) && !tuning_->path().empty()) tuning_->save();
+  }
+  std::vector<size_t> threads;
+  auto executor = std::make_shared<Executor>(
+      apply_tuning(graph, input_shapes, *tuning_, &threads), input_shapes);
+  if (std::any_of(threads.begin(), threads.end(),
+                  [](size_t t) { return t != 0; }))
+    executor->setNodeThreads(std::move(threads));
+  executor->setGemmBlocking(tuning_->gemm());
+  return executor;
+}
+
+/**
+ * @brief Get the total arena bytes of the cached plans.
+ */
+size_t PlanCache::arenaBytes() const {
+  size_t bytes = 0;
+  for (const Entry& entry : entries_)
+    bytes += entry.executor->plan().arena_bytes;
+  return bytes;
+}
+
+/**
+ * @brief Check whether a plan for the given input shapes is cached.
+ */
+bool PlanCache::contains(const std::vector<Shape>& input_shapes) const {
+  return index_.count(shape_key(input_shapes)) != 0;
+}
+
+/**
+ * @brief Get the plan for the given input shapes, planning it on a miss.
+ */
+std::shared_ptr<Executor> PlanCache::get(
+    const std::vector<Shape>& input_shapes) {
+  std::vector<size_t> key = shape_key(input_shapes);
+  const auto found = index_.find(key);
+  if (found != index_.end()) {
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return found->second->executor;
+  }
+  // Plan before evicting, so a shape that fails inference costs nothing.
+  std::shared_ptr<Executor> executor = plan(input_shapes);
+  ++stats_.misses;
+  if (entries_.size() == capacity_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+    ++stats_.evictions;
+  }
+  entries_.push_front({key, executor});
+  index_.emplace(std::move(key), entries_.begin());
+  return executor;
+}
+
+/**
+ * @brief Run the graph with the plan matching the input shapes.
+ */
+std::shared_ptr<Executor> PlanCache::run(
+    std::span<const Tensor<float>> inputs) {
+  std::vector<Shape> shapes;
+  shapes.reserve(inputs.size());
+  for (const Tensor<float>& input : inputs) shapes.push_back(input.shape());
+  std::shared_ptr<Executor> executor = get(shapes);
+  executor->run(inputs);
+  return executor;
+}
+
+/**
+ * @brief Plan the expected input shapes ahead of time.
+ */
+void PlanCache::warmup(const std::vector<std::vector<Shape>>& shapes,
+                       bool run_once) {
+  for (const std::vector<Shape>& input_shapes : shapes) {
+    const bool planned = contains(input_shapes);
+    std::shared_ptr<Executor> executor = get(input_shapes);
+    if (!run_once || planned) continue;
+    std::vector<Tensor<float>> zeros;
+    for (const Shape& shape : input_shapes) zeros.emplace_back(shape);
+    executor->run(zeros);
+  }
+}
+
+/**
+ * @brief Drop every plan and reset the counts.
+ */
+void PlanCache::clear() {
+  index_.clear();
+  entries_.clear();
+  stats_ = {};
+}
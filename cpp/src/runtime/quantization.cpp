@@ -0,0 +1,395 @@
+#include "runtime/quantization.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "runtime/executor.h"
+#include "utils/scratch.h"
+
+/**
+ * @brief Check the number of inputs of an operator.
+ */
+static void expect_inputs(size_t count, size_t expected, const char* type) {
+  if (count != expected)
+    throw std::invalid_argument(std::string(type) + ": expected " +
+                                std::to_string(expected) + " input(s)");
+}
+
+/**
+ * @brief Check whether a node is a layer with an INT8 implementation.
+ */
+static bool quantizable(const Operator& op) {
+  if (const auto* conv = dynamic_cast<const Conv2dOp*>(&op))
+    return conv->conv().layout() == ConvLayout::kNchw &&
+           conv->conv().algorithm() != ConvAlgorithm::kDepthwise;
+  return dynamic_cast<const LinearOp*>(&op) != nullptr;
+}
+
+/**
+ * @brief Find the histogram bin count that clips at a percentile.
+ *
+ * @return Number of leading bins holding @p percentile % of the counts.
+ */
+static size_t percentile_bins(const std::vector<double>& histogram,
+                              double percentile) {
+  double total = 0.;
+  for (double h : histogram) total += h;
+  const double target = total * percentile / 100.;
+  double sum = 0.;
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    sum += histogram[i];
+    if (sum >= target) return i + 1;
+  }
+  return histogram.size();
+}
+
+/**
+ * @brief Find the histogram bin count whose clipped, quantized distribution
+ * is closest to the observed one.
+ *
+ * For every candidate i the reference P is the first i bins with all
+ * outliers added to the last one, and Q is P's bins merged into @p levels
+ * codes and spread back evenly over the non-empty bins. The candidate with
+ * the smallest KL(P || Q) wins.
+ */
+static size_t entropy_bins(const std::vector<double>& histogram,
+                           size_t levels) {
+  const size_t bins = histogram.size();
+  levels = std::min(levels, bins);
+  std::vector<double> tail(bins + 1, 0.);
+  for (size_t i = bins; i-- > 0;) tail[i] = tail[i + 1] + histogram[i];
+  std::vector<double> p(bins), q(bins);
+  size_t best = bins;
+  double best_kl = std::numeric_limits<double>::infinity();
+  for (size_t i = levels; i <= bins; ++i) {
+    std::copy_n(histogram.begin(), i, p.begin());
+    p[i - 1] += tail[i];
+    std::fill_n(q.begin(), i, 0.);
+    for (size_t j = 0; j < levels; ++j) {
+      const size_t start = j * i / levels, stop = (j + 1) * i / levels;
+      double total = 0.;
+      size_t nonzero = 0;
+      for (size_t b = start; b < stop; ++b) {
+        total += histogram[b];
+        nonzero += histogram[b] != 0.;
+      }
+      for (size_t b = start; b < stop && nonzero; ++b)
+        if (histogram[b] != 0.) q[b] = total / double(nonzero);
+    }
+    double p_sum = 0., q_sum = 0.;
+    for (size_t b = 0; b < i; ++b) {
+      p_sum += p[b];
+      q_sum += q[b];
+    }
+    if (p_sum == 0. || q_sum == 0.) continue;
+    double kl = 0.;
+    for (size_t b = 0; b < i; ++b) {
+      if (p[b] == 0.) continue;
+      const double pn = p[b] / p_sum;
+      const double qn = std::max(q[b] / q_sum, 1e-12);
+      kl += pn * std::log(pn / qn);
+    }
+    if (kl < best_kl) {
+      best_kl = kl;
+      best = i;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Prepare the statistics of a graph's quantizable layers.
+ */
+Calibrator::Calibrator(const Graph& graph, CalibrationOptions options)
+    : graph_(graph), options_(options) {
+  if (!(options.percentile > 0. && options.percentile <= 100.) ||
+      options.bins == 0)
+    throw std::invalid_argument(
+        "Calibrator: percentile must be in (0, 100] and bins > 0");
+  for (const Node& node : graph.nodes())
+    if (quantizable(*node.op)) {
+      Observer observer;
+      observer.name = node.name;
+      observer.value = node.inputs[0];
+      observers_.push_back(std::move(observer));
+    }
+}
+
+/**
+ * @brief Run one calibration batch and record its statistics.
+ */
+void Calibrator::collect(std::span<const Tensor<float>> inputs) {
+  const std::vector<ValueId>& graph_inputs = graph_.inputs();
+  expect_inputs(inputs.size(), graph_inputs.size(), "Calibrator");
+  std::vector<Shape> input_shapes;
+  for (const Tensor<float>& t : inputs) input_shapes.push_back(t.shape());
+  const std::vector<Shape> shapes = graph_.inferShapes(input_shapes);
+
+  // Eager run keeping every value, so each observer sees its input.
+  std::vector<Tensor<float>> values(graph_.numValues());
+  for (size_t i = 0; i < inputs.size(); ++i)
+    values[graph_inputs[i]] = inputs[i];
+  std::vector<const Tensor<float>*> args;
+  for (const Node& node : graph_.nodes()) {
+    args.clear();
+    for (ValueId v : node.inputs) args.push_back(&values[v]);
+    values[node.output] = Tensor<float>(shapes[node.output]);
+    node.op->forward(args, values[node.output]);
+  }
+
+  for (Observer& observer : observers_) {
+    const Tensor<float>& x = values[observer.value];
+    const float* data = x.data();
+    const size_t n = x.numel();
+    if (pass_ == 0) {
+      for (size_t i = 0; i < n; ++i) {
+        observer.min = std::min(observer.min, data[i]);
+        observer.max = std::max(observer.max, data[i]);
+      }
+      continue;
+    }
+    const float amax = std::max(-observer.min, observer.max);
+    if (!(amax > 0.f)) continue;
+    const size_t bins = observer.histogram.size();
+    const float per_bin = float(bins) / amax;
+    for (size_t i = 0; i < n; ++i) {
+      const size_t bin = size_t(std::abs(data[i]) * per_bin);
+      observer.histogram[std::min(bin, bins - 1)] += 1.;
+    }
+  }
+}
+
+/**
+ * @brief Finish the current pass over the calibration data.
+ */
+bool Calibrator::nextPass() {
+  if (pass_ > 0 || options_.method == CalibrationMethod::kMinMax) return false;
+  for (Observer& observer : observers_)
+    observer.histogram.assign(options_.bins, 0.);
+  pass_ = 1;
+  return true;
+}
+
+/**
+ * @brief Derive the input quantization of every observed layer.
+ */
+CalibrationTable Calibrator::table() const {
+  const bool clipped = options_.method != CalibrationMethod::kMinMax;
+  if (clipped && pass_ == 0)
+    throw std::runtime_error("Calibrator: histogram pass has not run");
+  CalibrationTable table;
+  for (const Observer& observer : observers_) {
+    if (observer.min > observer.max)
+      throw std::runtime_error("Calibrator: no batch was collected");
+    float lo = observer.min, hi = observer.max;
+    const float amax = std::max(-lo, hi);
+    if (clipped && amax > 0.f) {
+      const std::vector<double>& h = observer.histogram;
+      // Non-negative inputs (e.g. after ReLU) get all 255 codes on one side.
+      const size_t kept =
+          options_.method == CalibrationMethod::kPercentile
+              ? percentile_bins(h, options_.percentile)
+              : entropy_bins(h, lo >= 0.f ? 255 : 128);
+      const float threshold = amax * float(kept) / float(h.size());
+      lo = std::max(lo, -threshold);
+      hi = std::min(hi, threshold);
+    }
+    table[observer.name] = choose_quant_params(lo, hi);
+  }
+  return table;
+}
+
+/**
+ * @brief Check that a convolution node can be quantized.
+ */
+static const Conv2dOp& nchw_source(const Conv2dOp& source) {
+  if (source.conv().layout() != ConvLayout::kNchw)
+    throw std::invalid_argument("QConv2d: only the NCHW layout is supported");
+  return source;
+}
+
+/**
+ * @brief Quantize a convolution node.
+ */
+QConv2dOp::QConv2dOp(const Conv2dOp& source, const QuantParams& input)
+    : conv_(nchw_source(source).weight(), source.bias(),
+            source.conv().params(), input),
+      residual_(source.hasResidual()),
+      clamp_min_(source.clampMin()),
+      clamp_max_(source.clampMax()) {}
+
+/**
+ * @brief Infer the output shape of the convolution.
+ */
+Shape QConv2dOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), residual_ ? 2 : 1, type());
+  const Shape out = conv_.outputShape(inputs[0]);
+  if (residual_ && inputs[1] != out)
+    throw std::invalid_argument("QConv2d: residual shape mismatch");
+  return out;
+}
+
+/**
+ * @brief Run the convolution and its epilogue.
+ */
+void QConv2dOp::forward(std::span<const Tensor<float>* const> inputs,
+                        Tensor<float>& output) const {
+  ConvEpilogue epilogue;
+  epilogue.residual = residual_ ? inputs[1] : nullptr;
+  epilogue.clamp_min = clamp_min_;
+  epilogue.clamp_max = clamp_max_;
+  conv_.forward(*inputs[0], output, epilogue);
+}
+
+/**
+ * @brief Quantize a fully connected node.
+ */
+QLinearOp::QLinearOp(const LinearOp& source, const QuantParams& input)
+    : weight_(qgemm_quantize_a(source.weight().dim(0), source.weight().dim(1),
+                               source.weight().data(),
+                               source.weight().dim(1))),
+      bias_(source.bias()),
+      input_(input) {}
+
+/**
+ * @brief Infer the output shape of the layer.
+ */
+Shape QLinearOp::outputShape(std::span<const Shape> inputs) const {
+  expect_inputs(inputs.size(), 1, type());
+  if (inputs[0].rank() != 2 || inputs[0][1] != weight_.k)
+    throw std::invalid_argument("QLinear: input must be [M, K]");
+  return Shape{inputs[0][0], weight_.m};
+}
+
+/**
+ * @brief Multiply by the quantized weights and add the bias.
+ *
+ * The weights are the GEMM's left operand, so the product is formed as
+ * [N, M] in scratch and transposed into the [M, N] output.
+ */
+void QLinearOp::forward(std::span<const Tensor<float>* const> inputs,
+                        Tensor<float>& output) const {
+  thread_local ScratchBuffers<uint8_t> code_buffers;
+  thread_local ScratchBuffers<float> product_buffers;
+  const Tensor<float>& x = *inputs[0];
+  const size_t m = output.dim(0), n = output.dim(1), k = weight_.k;
+  ScratchScope scope;  // both buffers outlive the GEMM
+  uint8_t* codes = code_buffers.get(0, std::max<size_t>(x.numel(), 1));
+  float* product = product_buffers.get(0, std::max<size_t>(m * n, 1));
+  quantize_u8(x.data(), x.numel(), input_, codes);
+  GemmEpilogue epilogue;
+  epilogue.row_bias = bias_.empty() ? nullptr : bias_.data();
+  qgemm(weight_, true, m, codes, k, input_, product, m, epilogue);
+  for (size_t i = 0; i < m; ++i)
+    for (size_t j = 0; j < n; ++j) output[i * n + j] = product[j * m + i];
+}
+
+/**
+ * @brief Replace calibrated layers with their INT8 counterparts.
+ */
+Graph quantize_graph(const Graph& graph, const CalibrationTable& table,
+                     QuantizationStats* stats) {
+  QuantizationStats counts;
+  Graph quantized;
+  std::vector<ValueId> map(graph.numValues());
+  for (ValueId v : graph.inputs())
+    map[v] = quantized.addInput(graph.valueName(v));
+  for (const Node& node : graph.nodes()) {
+    std::shared_ptr<const Operator> op = node.op;
+    const auto* conv = dynamic_cast<const Conv2dOp*>(op.get());
+    const auto* linear = dynamic_cast<const LinearOp*>(op.get());
+    const auto entry = table.find(node.name);
+    if (quantizable(*op) && entry != table.end()) {
+      if (conv) {
+        op = std::make_shared<QConv2dOp>(*conv, entry->second);
+        ++counts.quantized_convs;
+      } else {
+        op = std::make_shared<QLinearOp>(*linear, entry->second);
+        ++counts.quantized_linears;
+      }
+    } else if (conv || linear) {
+      ++counts.float_layers;
+    }
+    std::vector<ValueId> inputs;
+    for (ValueId v : node.inputs) inputs.push_back(map[v]);
+    map[node.output] = quantized.addNode(node.name, op, std::move(inputs));
+  }
+  for (ValueId v : graph.outputs()) quantized.addOutput(map[v]);
+  if (stats) *stats = counts;
+  return quantized;
+}
+
+/**
+ * @brief Time the mean latency of an executor in milliseconds.
+ */
+static double mean_ms(Executor& executor,
+                      std::span<const Tensor<float>> inputs, size_t repeats) {
+  if (repeats == 0) return 0.;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < repeats; ++r) executor.run(inputs);
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / double(repeats);
+}
+
+/**
+ * @brief Measure a quantized graph against its FP32 source.
+ */
+QuantizationReport compare_quantized(const Graph& reference,
+                                     const Graph& quantized,
+                                     std::span<const Tensor<float>> inputs,
+                                     size_t repeats) {
+  if (reference.outputs().size() != quantized.outputs().size())
+    throw std::invalid_argument("compare_quantized: output count differs");
+  std::vector<Shape> shapes;
+  for (const Tensor<float>& t : inputs) shapes.push_back(t.shape());
+  Executor fp32(std::make_shared<const Graph>(reference), shapes);
+  Executor int8(std::make_shared<const Graph>(quantized), shapes);
+  fp32.run(inputs);
+  int8.run(inputs);
+
+  QuantizationReport report;
+  double signal = 0., noise = 0., abs_sum = 0.;
+  size_t count = 0;
+  for (size_t o = 0; o < reference.outputs().size(); ++o) {
+    const Tensor<float>& a = fp32.output(o);
+    const Tensor<float>& b = int8.output(o);
+    if (a.shape() != b.shape())
+      throw std::invalid_argument("compare_quantized: output shape differs");
+    for (size_t i = 0; i < a.numel(); ++i) {
+      const double err = double(a[i]) - double(b[i]);
+      report.max_abs_error = std::max(report.max_abs_error, std::abs(err));
+      abs_sum += std::abs(err);
+      signal += double(a[i]) * a[i];
+      noise += err * err;
+    }
+    count += a.numel();
+  }
+  report.mean_abs_error = count ? abs_sum / double(count) : 0.;
+  report.sqnr_db = noise > 0. ? 10. * std::log10(signal / noise)
+                              : std::numeric_limits<double>::infinity();
+  report.fp32_ms = mean_ms(fp32, inputs, repeats);
+  report.int8_ms = mean_ms(int8, inputs, repeats);
+  report.kernel = qgemm_kernel_name();
+  return report;
+}
+
+/**
+ * @brief Format a report as a single human-readable line.
+ */
+std::string format_quantization_report(const QuantizationReport& report) {
+  std::ostringstream out;
+  out << std::setprecision(4) << "int8 (" << report.kernel
+      << ") vs fp32: max |err| " << report.max_abs_error << ", mean |err| "
+      << report.mean_abs_error << ", SQNR " << std::fixed
+      << std::setprecision(1) << report.sqnr_db << " dB; "
+      << std::setprecision(3) << report.fp32_ms << " ms -> "
+      << report.int8_ms << " ms (" << std::setprecision(2)
+      << report.speedup() << "x)";
+  return out.str();
+}
@@ -0,0 +1,293 @@
+#include "runtime/weights.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+
+static_assert(std::endian::native == std::endian::little,
+              "weights files use little-endian byte order");
+
+static constexpr char kMagic[8] = {'V', 'F', 'W', 'E', 'I', 'G', 'H', 'T'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kHeaderBytes = 32;
+
+/** Element type code of float32 tensors (the only type stored so far). */
+static constexpr uint32_t kFloat32 = 0;
+
+/**
+ * @brief Round @p n up to the tensor alignment.
+ */
+static uint64_t align_up(uint64_t n) {
+  return (n + kTensorAlignment - 1) / kTensorAlignment * kTensorAlignment;
+}
+
+/**
+ * @brief Append the bytes of a trivially copyable value.
+ */
+template <typename T>
+static void put(std::vector<char>& out, const T& v) {
+  const char* p = reinterpret_cast<const char*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+/**
+ * @brief Bounds-checked little-endian reader over a byte range.
+ */
+struct ByteCursor {
+  const uint8_t* p;
+  const uint8_t* end;
+
+  template <typename T>
+  T get() {
+    if (size_t(end - p) < sizeof(T))
+      throw std::runtime_error("WeightsFile: truncated index");
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+  }
+};
+
+/**
+ * @brief Write tensors to a weights container file.
+ */
+void save_weights(const std::string& path,
+                  const std::vector<NamedTensor>& tensors, uint64_t tag) {
+  std::unordered_set<std::string> names;
+  for (const NamedTensor& t : tensors)
+    if (!names.insert(t.first).second)
+      throw std::invalid_argument("save_weights: duplicate name " + t.first);
+
+  // The index size does not depend on the offsets, so size it first.
+  size_t index_bytes = 0;
+  for (const NamedTensor& t : tensors)
+    index_bytes += 4 + t.first.size() + 8 + 8 * t.second.rank() + 8;
+  uint64_t offset = align_up(kHeaderBytes + index_bytes);
+
+  std::vector<char> head;
+  head.insert(head.end(), kMagic, kMagic + 8);
+  put(head, kVersion);
+  put(head, uint32_t(tensors.size()));
+  put(head, uint64_t(index_bytes));
+  put(head, tag);
+  std::vector<uint64_t> offsets;
+  for (const NamedTensor& t : tensors) {
+    put(head, uint32_t(t.first.size()));
+    head.insert(head.end(), t.first.begin(), t.first.end());
+    put(head, kFloat32);
+    put(head, uint32_t(t.second.rank()));
+    for (size_t d = 0; d < t.second.rank(); ++d)
+      put(head, uint64_t(t.second.dim(d)));
+    put(head, offset);
+    offsets.push_back(offset);
+    offset = align_up(offset + t.second.numel() * sizeof(float));
+  }
+
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("save_weights: cannot create " + tmp);
+    out.write(head.data(), std::streamsize(head.size()));
+    static const char zeros[kTensorAlignment] = {};
+    uint64_t at = head.size();
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      out.write(zeros, std::streamsize(offsets[i] - at));
+      const Tensor<float>& t = tensors[i].second;
+      const uint64_t bytes = t.numel() * sizeof(float);
+      if (bytes) out.write(reinterpret_cast<const char*>(t.data()),
+                           std::streamsize(bytes));
+      at = offsets[i] + bytes;
+    }
+    out.write(zeros, std::streamsize(align_up(at) - at));
+    if (!out) throw std::runtime_error("save_weights: cannot write " + tmp);
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    throw std::runtime_error("save_weights: cannot replace " + path);
+  }
+}
+
+/**
+ * @brief Map a weights file and read its index.
+ */
+WeightsFile::WeightsFile(const std::string& path)
+    : path_(path), file_(std::make_shared<MappedFile>(path)) {
+  const uint8_t* base = file_->data();
+  const size_t size = file_->size();
+  if (size < kHeaderBytes || std::memcmp(base, kMagic, 8) != 0)
+    throw std::runtime_error("WeightsFile: not a weights file: " + path);
+  ByteCursor header{base + 8, base + kHeaderBytes};
+  if (header.get<uint32_t>() != kVersion)
+    throw std::runtime_error("WeightsFile: unsupported version");
+  const auto count = header.get<uint32_t>();
+  const auto index_bytes = header.get<uint64_t>();
+  tag_ = header.get<uint64_t>();
+  if (index_bytes > size - kHeaderBytes)
+    throw std::runtime_error("WeightsFile: truncated index");
+
+  ByteCursor index{base + kHeaderBytes, base + kHeaderBytes + index_bytes};
+  entries_.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    WeightsEntry& e = entries_[i];
+    const auto len = index.get<uint32_t>();
+    if (size_t(index.end - index.p) < len)
+      throw std::runtime_error("WeightsFile: truncated index");
+    e.name.assign(reinterpret_cast<const char*>(index.p), len);
+    index.p += len;
+    if (index.get<uint32_t>() != kFloat32)
+      throw std::runtime_error("WeightsFile: unsupported element type");
+    const auto rank = index.get<uint32_t>();
+    if (rank > kMaxTensorRank)
+      throw std::runtime_error("WeightsFile: bad rank");
+    for (uint32_t d = 0; d < rank; ++d)
+      e.shape.push_back(index.get<uint64_t>());
+    e.offset = index.get<uint64_t>();
+    const uint64_t bytes = e.shape.numel() * sizeof(float);
+    if (e.offset % kTensorAlignment != 0 || e.offset > size ||
+        bytes > size - e.offset)
+      throw std::runtime_error("WeightsFile: tensor out of range: " + e.name);
+    if (!by_name_.emplace(e.name, i).second)
+      throw std::runtime_error("WeightsFile: duplicate name " + e.name);
+  }
+}
+
+/**
+ * @brief Get a zero-copy view of a tensor.
+ */
+Tensor<float> WeightsFile::tensor(const std::string& name) const {
+  std::optional<Tensor<float>> t = find(name);
+  if (!t) throw std::out_of_range("WeightsFile: no tensor " + name);
+  return *t;
+}
+
+/**
+ * @brief Get a zero-copy view of a tensor if it is stored.
+ */
+std::optional<Tensor<float>> WeightsFile::find(const std::string& name) const {
+  const auto it = by_name_.find(name);
+  if (it == by_name_.end()) return std::nullopt;
+  const WeightsEntry& e = entries_[it->second];
+  // The mapping is read-only; views must not be written through.
+  float* data = reinterpret_cast<float*>(
+      const_cast<uint8_t*>(file_->data() + e.offset));
+  return Tensor<float>::wrap(data, e.shape, file_);
+}
+
+/**
+ * @brief Fingerprint a file by size and modification time (0 if missing).
+ */
+static uint64_t file_fingerprint(const std::string& path) {
+  std::error_code ec;
+  const uint64_t size = std::filesystem::file_size(path, ec);
+  if (ec) return 0;
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) return 0;
+  const auto ticks = uint64_t(mtime.time_since_epoch().count());
+  return size * 0x9e3779b97f4a7c15ull ^ ticks;
+}
+
+/**
+ * @brief Open (or prepare to create) the sidecar of a weights file.
+ */
+PrepackedCache::PrepackedCache(const std::string& weights_path)
+    : path_(weights_path + "." + sgemm_pack_key() + ".packed"),
+      source_(file_fingerprint(weights_path)) {
+  try {
+    file_.emplace(path_);
+    if (file_->tag() != source_) file_.reset();
+  } catch (const std::exception&) {
+    file_.reset();
+  }
+}
+
+/**
+ * @brief Look up a prepacked tensor (saved or pending).
+ */
+std::optional<Tensor<float>> PrepackedCache::find(
+    const std::string& name) const {
+  for (const NamedTensor& t : pending_)
+    if (t.first == name) return t.second;
+  return file_ ? file_->find(name) : std::nullopt;
+}
+
+/**
+ * @brief Add a prepacked tensor to be written by save().
+ */
+void PrepackedCache::insert(const std::string& name,
+                            const Tensor<float>& tensor) {
+  for (NamedTensor& t : pending_)
+    if (t.first == name) {
+      t.second = tensor;
+      return;
+    }
+  pending_.emplace_back(name, tensor);
+}
+
+/**
+ * @brief Write the saved and pending tensors to the sidecar and remap it.
+ */
+void PrepackedCache::save() {
+  if (pending_.empty()) return;
+  std::vector<NamedTensor> all;
+  if (file_)
+    for (const WeightsEntry& e : file_->entries())
+      if (!std::any_of(pending_.begin(), pending_.end(),
+                       [&](const NamedTensor& t) { return t.first == e.name; }))
+        all.emplace_back(e.name, file_->tensor(e.name));
+  all.insert(all.end(), pending_.begin(), pending_.end());
+  save_weights(path_, all, source_);
+  file_.emplace(path_);
+  pending_.clear();
+}
+
+/**
+ * @brief Build a convolution node from tensors in a weights file.
+ */
+std::shared_ptr<Conv2dOp> load_conv2d(const WeightsFile& weights,
+                                      const std::string& name,
+                                      const Conv2dParams& params,
+                                      ConvLayout layout,
+                                      ConvAlgorithm algorithm,
+                                      PrepackedCache* cache) {
+  const Tensor<float> weight = weights.tensor(name + ".weight");
+  const Tensor<float> bias =
+      weights.find(name + ".bias").value_or(Tensor<float>());
+  if (weight.rank() != 4 || params.groups == 0)
+    throw std::invalid_argument("load_conv2d: " + name +
+                                ".weight must be [C_out, C_in, KH, KW]");
+  const size_t m = weight.dim(0) / params.groups;
+  const std::string prefix = name + ".packed.";
+
+  std::vector<GemmPackedA> prepacked;
+  if (cache)
+    while (std::optional<Tensor<float>> panels =
+               cache->find(prefix + std::to_string(prepacked.size()))) {
+      if (panels->rank() != 2) break;
+      prepacked.push_back(sgemm_adopt_packed(m, panels->dim(0), *panels));
+    }
+  if (!prepacked.empty()) {
+    try {
+      return std::make_shared<Conv2dOp>(weight, bias, params, layout,
+                                        algorithm, std::move(prepacked));
+    } catch (const std::invalid_argument&) {
+      // Stale entry (e.g. a different algorithm was selected): repack.
+    }
+  }
+  auto op = std::make_shared<Conv2dOp>(weight, bias, params, layout, algorithm);
+  if (cache) {
+    const std::vector<GemmPackedA>& packed = op->conv().packedWeights();
+    for (size_t i = 0; i < packed.size(); ++i) {
+      const GemmPackedA& a = packed[i];
+      cache->insert(prefix + std::to_string(i),
+                    a.data.reshape(Shape{a.k, a.data.numel() / a.k}));
+    }
+  }
+  return op;
+}
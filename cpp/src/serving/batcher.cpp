@@ -0,0 +1,190 @@
+#include "serving/batcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "data/collate.hpp"
+
+/**
+ * @brief Get the size a batch of @p n samples is padded to.
+ */
+size_t padded_batch_size(size_t n, const std::vector<size_t>& batch_sizes) {
+  if (batch_sizes.empty()) return n;
+  const auto it = std::lower_bound(batch_sizes.begin(), batch_sizes.end(), n);
+  if (it == batch_sizes.end())
+    throw std::invalid_argument("padded_batch_size: batch too large");
+  return *it;
+}
+
+/**
+ * @brief Run a batched model on equally shaped samples.
+ */
+std::vector<Tensor<float>> run_batch(const BatchModel& model,
+                                     const std::vector<Tensor<float>>& samples,
+                                     const std::vector<size_t>& batch_sizes) {
+  const size_t n = samples.size();
+  const size_t padded = padded_batch_size(n, batch_sizes);
+  Tensor<float> output;
+  if (padded > n) {
+    std::vector<Tensor<float>> filled = samples;
+    filled.resize(padded, Tensor<float>(samples[0].shape()));
+    output = model(collate<float>(filled));
+  } else {
+    output = model(collate<float>(samples));
+  }
+  if (output.empty() || output.rank() == 0 || output.dim(0) != padded)
+    throw std::runtime_error(
+        "run_batch: model output does not match the batch size");
+
+  Shape row;
+  for (size_t d = 1; d < output.rank(); ++d) row.push_back(output.dim(d));
+  const size_t row_size = row.numel();
+  std::vector<Tensor<float>> results;
+  results.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    results.emplace_back(row);
+    std::memcpy(results.back().data(), output.data() + i * row_size,
+                row_size * sizeof(float));
+  }
+  return results;
+}
+
+/**
+ * @brief Start the batcher thread.
+ */
+DynamicBatcher::DynamicBatcher(Model model, BatchingOptions options)
+    : model_(std::move(model)), options_(std::move(options)) {
+  if (!model_) throw std::invalid_argument("DynamicBatcher: no model");
+  if (options_.max_batch == 0)
+    throw std::invalid_argument("DynamicBatcher: max_batch must be positive");
+  const std::vector<size_t>& sizes = options_.batch_sizes;
+  for (size_t i = 0; i < sizes.size(); ++i)
+    if (sizes[i] == 0 || (i > 0 && sizes[i] <= sizes[i - 1]))
+      throw std::invalid_argument(
+          "DynamicBatcher: batch sizes must be positive and ascending");
+  if (!sizes.empty())
+    options_.max_batch = std::min(options_.max_batch, sizes.back());
+  thread_ = std::thread([this] { loop(); });
+}
+
+/**
+ * @brief Complete the queued requests and stop the thread.
+ */
+DynamicBatcher::~DynamicBatcher() {
+  stop();
+  if (thread_.joinable()) thread_.join();
+}
+
+/**
+ * @brief Queue a request.
+ */
+void DynamicBatcher::submit(Tensor<float> sample, Callback done) {
+  if (sample.empty())
+    throw std::invalid_argument("DynamicBatcher: empty sample");
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) throw std::runtime_error("DynamicBatcher: stopped");
+    queue_.push_back({std::move(sample), std::move(done), Clock::now()});
+  }
+  wake_.notify_one();
+}
+
+/**
+ * @brief Get the number of queued requests.
+ */
+size_t DynamicBatcher::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+/**
+ * @brief Get the counters.
+ */
+BatcherStats DynamicBatcher::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+/**
+ * @brief Complete the queued requests and stop accepting new ones.
+ */
+void DynamicBatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+}
+
+/**
+ * @brief Main loop of the batcher thread.
+ */
+void DynamicBatcher::loop() {
+  std::vector<Request> batch;
+  for (;;) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) return;  // stopped and drained
+
+    // The oldest request opens the batch; only samples of its shape join.
+    const Shape shape = queue_.front().sample.shape();
+    const auto full = [&] {
+      size_t same = 0;
+      for (const Request& r : queue_)
+        if (r.sample.shape() == shape && ++same == options_.max_batch)
+          return true;
+      return false;
+    };
+    wake_.wait_until(lock, queue_.front().time + options_.max_delay,
+                     [&] { return stop_ || full(); });
+
+    batch.clear();
+    for (auto it = queue_.begin();
+         it != queue_.end() && batch.size() < options_.max_batch;) {
+      if (it->sample.shape() == shape) {
+        batch.push_back(std::move(*it));
+        it = queue_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    lock.unlock();
+    runBatch(batch);
+  }
+}
+
+/**
+ * @brief Run one batch and complete its requests.
+ */
+void DynamicBatcher::runBatch(std::vector<Request>& batch) {
+  const size_t n = batch.size();
+  std::vector<Tensor<float>> samples;
+  samples.reserve(n);
+  for (const Request& r : batch) samples.push_back(r.sample);
+  std::vector<Tensor<float>> results;
+  std::exception_ptr error;
+  try {
+    results = run_batch(model_, samples, options_.batch_sizes);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  {
+    // Counted first, so the stats cover a request once it completes.
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.requests += n;
+    stats_.batches += 1;
+    stats_.padded_samples += padded_batch_size(n, options_.batch_sizes) - n;
+    if (error) stats_.failed += n;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    try {
+      batch[i].done(error ? Tensor<float>() : std::move(results[i]), error);
+    } catch (...) {
+      // A failing callback must not take down the other requests.
+    }
+  }
+}
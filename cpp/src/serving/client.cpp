@@ -0,0 +1,89 @@
+#include "serving/client.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+/**
+ * @brief Connect to a server.
+ */
+InferenceClient::InferenceClient(const std::string& socket_path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument("InferenceClient: bad socket path");
+  std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0)
+    throw std::system_error(errno, std::system_category(), "socket");
+  if (connect(fd_, reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    const int error = errno;
+    ::close(fd_);
+    throw std::system_error(error, std::system_category(), "connect");
+  }
+}
+
+/**
+ * @brief Close the connection.
+ */
+InferenceClient::~InferenceClient() { ::close(fd_); }
+
+/**
+ * @brief Send a request without waiting for its response.
+ */
+uint64_t InferenceClient::send(const Tensor<float>& sample) {
+  Message request;
+  request.id = next_id_++;
+  request.tensor = sample;
+  frame_.clear();
+  encode_message(request, frame_);
+  size_t written = 0;
+  while (written < frame_.size()) {
+    const ssize_t n = ::send(fd_, frame_.data() + written,
+                             frame_.size() - written, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::system_category(), "send");
+    }
+    written += size_t(n);
+  }
+  return request.id;
+}
+
+/**
+ * @brief Wait for the next response.
+ */
+Message InferenceClient::receive() {
+  Message response;
+  uint8_t buffer[64 * 1024];
+  while (!reader_.next(response)) {
+    const ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::system_category(), "recv");
+    }
+    if (n == 0)
+      throw std::runtime_error("InferenceClient: connection closed");
+    reader_.feed(buffer, size_t(n));
+  }
+  return response;
+}
+
+/**
+ * @brief Run one request and wait for its result.
+ */
+Tensor<float> InferenceClient::infer(const Tensor<float>& sample) {
+  const uint64_t id = send(sample);
+  Message response = receive();
+  if (response.id != id)
+    throw std::runtime_error("InferenceClient: unexpected response id");
+  if (response.status != MessageStatus::kOk)
+    throw std::runtime_error("InferenceClient: " + response.error);
+  return std::move(response.tensor);
+}
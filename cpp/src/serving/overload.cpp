@@ -0,0 +1,59 @@
+#include "serving/overload.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Create a controller at the best level.
+ */
+OverloadController::OverloadController(OverloadControlOptions options)
+    : options_(std::move(options)) {
+  if (options_.levels.empty())
+    options_.levels = {{1, 1, 4}, {1, 1, 8}, {2, 1, 8}, {2, 2, 8}, {4, 3, 8}};
+  for (const QualityLevel& l : options_.levels)
+    if (l.downscale == 0 || l.keep_every == 0 || l.max_batch == 0)
+      throw std::invalid_argument("OverloadController: bad quality level");
+  if (!(options_.target_p99_ms > 0.) || options_.window == 0 ||
+      options_.queue_high == 0 || !(options_.recover_ratio > 0.) ||
+      options_.recover_ratio > 1. || options_.degrade_windows == 0 ||
+      options_.recover_windows == 0)
+    throw std::invalid_argument("OverloadController: bad options");
+  window_.reserve(options_.window);
+}
+
+/**
+ * @brief Report a completed frame.
+ */
+bool OverloadController::observe(double latency_ms, size_t queue_depth) {
+  window_.push_back(latency_ms);
+  peak_queue_ = std::max(peak_queue_, queue_depth);
+  if (window_.size() < options_.window) return false;
+
+  const size_t rank = std::min(window_.size() - 1,
+                               size_t(0.99 * double(window_.size())));
+  std::nth_element(window_.begin(), window_.begin() + ptrdiff_t(rank),
+                   window_.end());
+  last_p99_ms_ = window_[rank];
+  const bool overloaded = last_p99_ms_ > options_.target_p99_ms ||
+                          peak_queue_ >= options_.queue_high;
+  const bool calm =
+      last_p99_ms_ < options_.target_p99_ms * options_.recover_ratio &&
+      peak_queue_ < (options_.queue_high + 1) / 2;
+  window_.clear();
+  peak_queue_ = 0;
+  overloaded_ = overloaded ? overloaded_ + 1 : 0;
+  calm_ = calm ? calm_ + 1 : 0;
+
+  size_t level = level_;
+  if (overloaded_ >= options_.degrade_windows &&
+      level_ + 1 < options_.levels.size())
+    ++level;
+  else if (calm_ >= options_.recover_windows && level_ > 0)
+    --level;
+  if (level == level_) return false;
+  level_ = level;
+  overloaded_ = calm_ = 0;
+  ++changes_;
+  return true;
+}
@@ -0,0 +1,115 @@
+#include "serving/protocol.h"
+
+#include <cstring>
+#include <stdexcept>
+
+/** Bytes of the fixed part of a frame. */
+static constexpr size_t kHeaderBytes = 4 + 4 + 8 + 4 + 4;
+
+/**
+ * @brief Append the bytes of a trivially copyable value.
+ */
+template <typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Read a trivially copyable value at @p at.
+ */
+template <typename T>
+static T get(const uint8_t* at) {
+  T value;
+  std::memcpy(&value, at, sizeof(T));
+  return value;
+}
+
+/**
+ * @brief Serialize a message as one frame.
+ */
+void encode_message(const Message& message, std::vector<uint8_t>& out) {
+  const bool ok = message.status == MessageStatus::kOk;
+  // An empty tensor is sent as shape [0], so it survives the round trip.
+  const Shape shape = !ok                    ? Shape{}
+                      : message.tensor.empty() ? Shape{0}
+                                               : message.tensor.shape();
+  const size_t payload = ok ? message.tensor.numel() * sizeof(float)
+                            : message.error.size();
+  const size_t bytes = kHeaderBytes + shape.rank() * 8 + payload;
+  if (bytes > kMaxMessageBytes)
+    throw std::invalid_argument("encode_message: message too large");
+  out.reserve(out.size() + bytes);
+  put(out, kServingMagic);
+  put(out, uint32_t(bytes));
+  put(out, message.id);
+  put(out, uint32_t(message.status));
+  put(out, uint32_t(shape.rank()));
+  for (size_t d : shape) put(out, uint64_t(d));
+  const auto* data =
+      ok ? reinterpret_cast<const uint8_t*>(message.tensor.data())
+         : reinterpret_cast<const uint8_t*>(message.error.data());
+  if (payload) out.insert(out.end(), data, data + payload);
+}
+
+/**
+ * @brief Append received bytes.
+ */
+void MessageReader::feed(const uint8_t* data, size_t size) {
+  // Drop decoded frames before growing, so the buffer stays small.
+  if (offset_ > 0 && offset_ >= buffer_.size() / 2) {
+    buffer_.erase(buffer_.begin(), buffer_.begin() + ptrdiff_t(offset_));
+    offset_ = 0;
+  }
+  buffer_.insert(buffer_.end(), data, data + size);
+}
+
+/**
+ * @brief Decode the next complete frame.
+ */
+bool MessageReader::next(Message& message) {
+  const size_t available = buffer_.size() - offset_;
+  if (available < 8) return false;
+  const uint8_t* frame = buffer_.data() + offset_;
+  if (get<uint32_t>(frame) != kServingMagic)
+    throw std::runtime_error("MessageReader: bad magic");
+  const size_t bytes = get<uint32_t>(frame + 4);
+  if (bytes < kHeaderBytes || bytes > kMaxMessageBytes)
+    throw std::runtime_error("MessageReader: bad frame size");
+  if (available < bytes) return false;
+
+  const auto status = MessageStatus(get<uint32_t>(frame + 16));
+  const size_t rank = get<uint32_t>(frame + 20);
+  if (status != MessageStatus::kOk && status != MessageStatus::kError)
+    throw std::runtime_error("MessageReader: bad status");
+  if (rank > kMaxTensorRank || kHeaderBytes + rank * 8 > bytes)
+    throw std::runtime_error("MessageReader: bad rank");
+  Shape shape;
+  for (size_t d = 0; d < rank; ++d)
+    shape.push_back(size_t(get<uint64_t>(frame + kHeaderBytes + d * 8)));
+  const uint8_t* payload = frame + kHeaderBytes + rank * 8;
+  const size_t payload_bytes = bytes - kHeaderBytes - rank * 8;
+
+  message = Message();
+  message.id = get<uint64_t>(frame + 8);
+  message.status = status;
+  if (status == MessageStatus::kOk) {
+    // Checked by division so huge dimensions cannot overflow the product.
+    size_t numel = 1;
+    for (size_t d : shape) {
+      if (d != 0 && numel > payload_bytes / sizeof(float) / d)
+        throw std::runtime_error("MessageReader: shape exceeds payload");
+      numel *= d;
+    }
+    if (numel * sizeof(float) != payload_bytes)
+      throw std::runtime_error("MessageReader: shape does not match payload");
+    message.tensor = Tensor<float>(shape);
+    if (payload_bytes)
+      std::memcpy(message.tensor.data(), payload, payload_bytes);
+  } else {
+    message.error.assign(reinterpret_cast<const char*>(payload),
+                         payload_bytes);
+  }
+  offset_ += bytes;
+  return true;
+}
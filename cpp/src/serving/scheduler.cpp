@@ -0,0 +1,363 @@
+#include "serving/scheduler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+/** Weight of the newest batch in the run-time moving average. */
+static constexpr double kCostSmoothing = 0.25;
+
+/**
+ * @brief Get the shape of a [C, H, W] frame downscaled by @p factor, or an
+ * empty shape if it cannot be.
+ */
+static Shape downscaled_shape(const Shape& shape, size_t factor) {
+  if (shape.rank() != 3 || shape[1] < factor || shape[2] < factor) return {};
+  return Shape{shape[0], shape[1] / factor, shape[2] / factor};
+}
+
+/**
+ * @brief Downscale a [C, H, W] frame by averaging factor x factor blocks
+ * (trailing rows and columns that do not fill a block are dropped).
+ */
+static Tensor<float> downscale_frame(const Tensor<float>& frame,
+                                     size_t factor) {
+  const Shape shape = downscaled_shape(frame.shape(), factor);
+  Tensor<float> out(shape);
+  const size_t h = frame.dim(1), w = frame.dim(2);
+  const float scale = 1.f / float(factor * factor);
+  for (size_t c = 0; c < shape[0]; ++c)
+    for (size_t y = 0; y < shape[1]; ++y)
+      for (size_t x = 0; x < shape[2]; ++x) {
+        float sum = 0.f;
+        for (size_t dy = 0; dy < factor; ++dy) {
+          const float* row =
+              frame.data() + (c * h + y * factor + dy) * w + x * factor;
+          for (size_t dx = 0; dx < factor; ++dx) sum += row[dx];
+        }
+        out.data()[(c * shape[1] + y) * shape[2] + x] = sum * scale;
+      }
+  return out;
+}
+
+/**
+ * @brief Get the @p q quantile of sorted values.
+ */
+static double quantile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0.;
+  return sorted[std::min(sorted.size() - 1, size_t(q * sorted.size()))];
+}
+
+/**
+ * @brief Format stream statistics as one line per stream.
+ */
+std::string format_stream_stats(const std::vector<StreamStats>& stats) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  for (const StreamStats& s : stats) {
+    out << s.name << ": " << s.completed << "/" << s.submitted
+        << " frames (downscaled " << s.downscaled << ", dropped "
+        << s.dropped << ", skipped " << s.skipped << ", failed "
+        << s.failed << ", late " << s.late
+        << "), latency ms p50 " << s.p50_ms << " p95 " << s.p95_ms
+        << " p99 " << s.p99_ms << " max " << s.max_ms << "\n";
+  }
+  return out.str();
+}
+
+/**
+ * @brief Start the scheduler thread.
+ */
+StreamScheduler::StreamScheduler(BatchModel model, SchedulerOptions options)
+    : model_(std::move(model)), options_(std::move(options)) {
+  if (!model_) throw std::invalid_argument("StreamScheduler: no model");
+  if (options_.max_batch == 0 || options_.downscale == 0)
+    throw std::invalid_argument(
+        "StreamScheduler: max_batch and downscale must be positive");
+  const std::vector<size_t>& sizes = options_.batch_sizes;
+  for (size_t i = 0; i < sizes.size(); ++i)
+    if (sizes[i] == 0 || (i > 0 && sizes[i] <= sizes[i - 1]))
+      throw std::invalid_argument(
+          "StreamScheduler: batch sizes must be positive and ascending");
+  if (!sizes.empty())
+    options_.max_batch = std::min(options_.max_batch, sizes.back());
+  if (options_.overload_control)
+    controller_.emplace(*options_.overload_control);
+  thread_ = std::thread([this] { loop(); });
+}
+
+/**
+ * @brief Run the queued frames and stop the thread.
+ */
+StreamScheduler::~StreamScheduler() {
+  stop();
+  if (thread_.joinable()) thread_.join();
+}
+
+/**
+ * @brief Register a stream.
+ */
+size_t StreamScheduler::addStream(const StreamOptions& options) {
+  if (options.weight == 0 || options.max_queue == 0)
+    throw std::invalid_argument(
+        "StreamScheduler: weight and max_queue must be positive");
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t id = streams_.size();
+  auto stream = std::make_unique<Stream>();
+  stream->options = options;
+  stream->stats.name =
+      options.name.empty() ? "stream" + std::to_string(id) : options.name;
+  streams_.push_back(std::move(stream));
+  classes_[options.priority].streams.push_back(id);
+  return id;
+}
+
+/**
+ * @brief Queue a frame of a stream.
+ */
+void StreamScheduler::submit(size_t stream, Tensor<float> frame,
+                             Callback done) {
+  if (frame.empty())
+    throw std::invalid_argument("StreamScheduler: empty frame");
+  Callback rejected;
+  FrameStatus status = FrameStatus::kDropped;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stream& s = *streams_.at(stream);
+    if (stop_) throw std::runtime_error("StreamScheduler: stopped");
+    ++s.stats.submitted;
+    if (controller_ &&
+        s.arrivals++ % controller_->quality().keep_every != 0) {
+      ++s.stats.skipped;
+      rejected = std::move(done);
+      status = FrameStatus::kSkipped;
+    } else {
+      if (s.queue.size() >= s.options.max_queue) {
+        // A fresher frame is worth more than a stale one.
+        rejected = std::move(s.queue.front().done);
+        s.queue.pop_front();
+        --queued_;
+        ++s.stats.dropped;
+      }
+      const Clock::time_point now = Clock::now();
+      s.queue.push_back(
+          {std::move(frame), std::move(done), now, now + s.options.deadline});
+      ++queued_;
+    }
+  }
+  wake_.notify_one();
+  if (rejected) rejected(status, Tensor<float>());
+}
+
+/**
+ * @brief Get the statistics of every stream.
+ */
+std::vector<StreamStats> StreamScheduler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<StreamStats> stats;
+  for (const auto& stream : streams_) {
+    StreamStats s = stream->stats;
+    std::vector<double> sorted = stream->latency;
+    std::sort(sorted.begin(), sorted.end());
+    s.p50_ms = quantile(sorted, 0.50);
+    s.p95_ms = quantile(sorted, 0.95);
+    s.p99_ms = quantile(sorted, 0.99);
+    s.max_ms = sorted.empty() ? 0. : sorted.back();
+    stats.push_back(std::move(s));
+  }
+  return stats;
+}
+
+/**
+ * @brief Get the quality level set by the overload controller.
+ */
+QualityLevel StreamScheduler::quality() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (controller_) return controller_->quality();
+  return {1, 1, options_.max_batch};
+}
+
+/**
+ * @brief Run the queued frames and stop accepting new ones.
+ */
+void StreamScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+}
+
+/**
+ * @brief Get the expected run time of a batch of @p shape frames.
+ */
+double StreamScheduler::cost(const Shape& shape) const {
+  for (const auto& [s, seconds] : cost_)
+    if (s == shape) return seconds;
+  return 0.;
+}
+
+/**
+ * @brief Record a completed frame's latency.
+ */
+double StreamScheduler::record(Stream& stream, const Frame& frame,
+                               Clock::time_point now) {
+  const double ms =
+      std::chrono::duration<double, std::milli>(now - frame.arrival).count();
+  if (stream.latency.size() < kLatencyWindow) {
+    stream.latency.push_back(ms);
+  } else {
+    stream.latency[stream.latency_next] = ms;
+  }
+  stream.latency_next = (stream.latency_next + 1) % kLatencyWindow;
+  if (now > frame.deadline) ++stream.stats.late;
+  return ms;
+}
+
+/**
+ * @brief Pick the next batch.
+ */
+std::vector<StreamScheduler::Picked> StreamScheduler::pick(
+    std::vector<Picked>& dropped) {
+  const Clock::time_point now = Clock::now();
+  const auto finish = [&](const Shape& shape) {
+    return now + std::chrono::duration_cast<Clock::duration>(
+                     std::chrono::duration<double>(cost(shape)));
+  };
+  size_t max_batch = options_.max_batch, level_factor = 1;
+  if (controller_) {
+    max_batch = std::min(max_batch, controller_->quality().max_batch);
+    level_factor = controller_->quality().downscale;
+  }
+  std::vector<Picked> batch;
+  Shape shape;
+  for (auto& [priority, group] : classes_) {
+    const size_t n = group.streams.size();
+    // Stop after a full round in which no stream contributed.
+    for (size_t idle = 0; idle < n && batch.size() < max_batch;) {
+      const size_t id = group.streams[group.cursor];
+      Stream& s = *streams_[id];
+      if (!s.visiting) s.deficit = s.options.weight;
+      bool took = false;
+      while (s.deficit > 0 && !s.queue.empty() &&
+             batch.size() < max_batch) {
+        Frame& frame = s.queue.front();
+        Shape frame_shape = frame.data.shape();
+        size_t factor = 1;
+        const Shape level_shape = downscaled_shape(frame_shape, level_factor);
+        if (level_factor > 1 && level_shape.rank() > 0) {
+          frame_shape = level_shape;
+          factor = level_factor;
+        }
+        if (finish(frame_shape) > frame.deadline) {
+          const Shape small =
+              downscaled_shape(frame_shape, options_.downscale);
+          if (s.options.overload != OverloadPolicy::kDownscale ||
+              small.rank() == 0 || finish(small) > frame.deadline) {
+            dropped.push_back({id, std::move(frame), 1});
+            s.queue.pop_front();
+            --queued_;
+            ++s.stats.dropped;
+            continue;
+          }
+          frame_shape = small;
+          factor *= options_.downscale;
+        }
+        if (!batch.empty() && frame_shape != shape) break;
+        shape = frame_shape;
+        batch.push_back({id, std::move(frame), factor});
+        s.queue.pop_front();
+        --queued_;
+        --s.deficit;
+        took = true;
+      }
+      // A full batch suspends the visit; the next batch resumes it.
+      s.visiting = batch.size() == max_batch && s.deficit > 0 &&
+                   !s.queue.empty();
+      if (s.visiting) break;
+      group.cursor = (group.cursor + 1) % n;
+      idle = took ? 0 : idle + 1;
+    }
+    if (batch.size() == max_batch) break;
+  }
+  return batch;
+}
+
+/**
+ * @brief Main loop of the scheduler thread.
+ */
+void StreamScheduler::loop() {
+  for (;;) {
+    std::vector<Picked> batch, dropped;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || queued_ > 0; });
+      if (queued_ == 0) return;  // stopped and drained
+      batch = pick(dropped);
+    }
+    for (Picked& p : dropped) {
+      try {
+        p.frame.done(FrameStatus::kDropped, Tensor<float>());
+      } catch (...) {
+        // A failing callback must not take down the other frames.
+      }
+    }
+    if (batch.empty()) continue;
+
+    std::vector<Tensor<float>> samples;
+    samples.reserve(batch.size());
+    for (const Picked& p : batch)
+      samples.push_back(p.factor > 1 ? downscale_frame(p.frame.data, p.factor)
+                                     : p.frame.data);
+    const Clock::time_point start = Clock::now();
+    std::vector<Tensor<float>> results;
+    bool failed = false;
+    try {
+      results = run_batch(model_, samples, options_.batch_sizes);
+    } catch (...) {
+      failed = true;
+    }
+    const Clock::time_point end = Clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const double seconds = std::chrono::duration<double>(end - start).count();
+      const Shape& shape = samples[0].shape();
+      auto it = std::find_if(cost_.begin(), cost_.end(),
+                             [&](const auto& c) { return c.first == shape; });
+      if (it == cost_.end())
+        cost_.emplace_back(shape, seconds);
+      else
+        it->second += kCostSmoothing * (seconds - it->second);
+      for (const Picked& p : batch) {
+        Stream& s = *streams_[p.stream];
+        double ms = 0.;
+        if (failed) {
+          // Failed frames still took their time; the controller sees them.
+          ++s.stats.failed;
+          ms = std::chrono::duration<double, std::milli>(end - p.frame.arrival)
+                   .count();
+        } else {
+          ++s.stats.completed;
+          if (p.factor > 1) ++s.stats.downscaled;
+          ms = record(s, p.frame, end);
+        }
+        if (controller_) controller_->observe(ms, queued_);
+      }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const FrameStatus status = failed ? FrameStatus::kFailed
+                                 : batch[i].factor > 1
+                                     ? FrameStatus::kDownscaled
+                                     : FrameStatus::kDone;
+      try {
+        batch[i].frame.done(status,
+                            failed ? Tensor<float>() : std::move(results[i]));
+      } catch (...) {
+        // A failing callback must not take down the other frames.
+      }
+    }
+  }
+}
@@ -0,0 +1,350 @@
+#include "serving/server.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+/** epoll tag of the listening socket (connection ids start at 1). */
+static constexpr uint64_t kListenTag = 0;
+
+/** epoll tag of the eventfd. */
+static constexpr uint64_t kWakeTag = ~uint64_t(0);
+
+/** Bytes read from a socket per recv() call. */
+static constexpr size_t kReadChunk = 64 * 1024;
+
+/**
+ * @brief Throw the current errno as a std::system_error.
+ */
+[[noreturn]] static void throw_errno(const char* what) {
+  throw std::system_error(errno, std::system_category(), what);
+}
+
+/**
+ * @brief Watch a descriptor with epoll.
+ */
+static void watch(int epoll_fd, int fd, uint32_t events, uint64_t tag) {
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = tag;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    throw_errno("epoll_ctl");
+}
+
+/**
+ * @brief Bind the socket and start the batcher.
+ */
+InferenceServer::InferenceServer(DynamicBatcher::Model model,
+                                 ServerOptions options)
+    : options_(std::move(options)),
+      batcher_(std::make_unique<DynamicBatcher>(std::move(model),
+                                                options_.batching)) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (options_.socket_path.empty() ||
+      options_.socket_path.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument("InferenceServer: bad socket path");
+  std::memcpy(address.sun_path, options_.socket_path.c_str(),
+              options_.socket_path.size() + 1);
+  const auto release = [&] {
+    for (int* fd : {&listen_fd_, &epoll_fd_, &event_fd_}) {
+      if (*fd >= 0) ::close(*fd);
+      *fd = -1;
+    }
+  };
+  try {
+    listen_fd_ =
+        socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) throw_errno("socket");
+    ::unlink(options_.socket_path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0)
+      throw_errno("bind");
+    if (listen(listen_fd_, SOMAXCONN) != 0) throw_errno("listen");
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) throw_errno("epoll_create1");
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) throw_errno("eventfd");
+    watch(epoll_fd_, listen_fd_, EPOLLIN | EPOLLET, kListenTag);
+    watch(epoll_fd_, event_fd_, EPOLLIN | EPOLLET, kWakeTag);
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+/**
+ * @brief Close every connection and remove the socket file.
+ */
+InferenceServer::~InferenceServer() {
+  // Completions reference this server, so finish them first.
+  batcher_.reset();
+  for (auto& [id, connection] : connections_) ::close(connection->fd);
+  for (int fd : {listen_fd_, epoll_fd_, event_fd_})
+    if (fd >= 0) ::close(fd);
+  ::unlink(options_.socket_path.c_str());
+}
+
+/**
+ * @brief Serve clients until stop() is called.
+ */
+void InferenceServer::run() {
+  epoll_event events[64];
+  while (!stop_.load()) {
+    const int n = epoll_wait(epoll_fd_, events, 64, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("epoll_wait");
+    }
+    for (int i = 0; i < n; ++i) {
+      const uint64_t tag = events[i].data.u64;
+      const uint32_t flags = events[i].events;
+      if (tag == kListenTag) {
+        accept();
+      } else if (tag == kWakeTag) {
+        uint64_t count;
+        while (::read(event_fd_, &count, sizeof(count)) > 0) {
+        }
+        deliver();
+      } else {
+        // Read before closing on a hang-up, so final requests are seen.
+        if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) read(tag);
+        if ((flags & EPOLLOUT) && connections_.count(tag)) {
+          connections_[tag]->writable = true;
+          flush(tag);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Make run() return.
+ */
+void InferenceServer::stop() {
+  stop_.store(true);
+  const uint64_t one = 1;
+  // Best effort: a full counter already guarantees a wakeup.
+  [[maybe_unused]] const ssize_t written = ::write(event_fd_, &one, 8);
+}
+
+/**
+ * @brief Get the counters.
+ */
+ServerStats InferenceServer::stats() const {
+  ServerStats stats;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats = stats_;
+  }
+  stats.batcher = batcher_->stats();
+  return stats;
+}
+
+/**
+ * @brief Accept every pending connection.
+ */
+void InferenceServer::accept() {
+  for (;;) {
+    const int fd = accept4(listen_fd_, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return;  // EAGAIN, or out of descriptors until a client leaves
+    }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (connections_.size() >= options_.max_connections) {
+      ::close(fd);
+      ++stats_.refused;
+      continue;
+    }
+    const uint64_t id = next_connection_++;
+    auto connection = std::make_unique<Connection>();
+    connection->fd = fd;
+    connections_[id] = std::move(connection);
+    watch(epoll_fd_, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, id);
+    ++stats_.accepted;
+  }
+}
+
+/**
+ * @brief Read everything available from a connection and submit its
+ * requests.
+ */
+void InferenceServer::read(uint64_t id) {
+  auto it = connections_.find(id);
+  if (it == connections_.end()) return;
+  Connection& connection = *it->second;
+  uint8_t buffer[kReadChunk];
+  bool closed = false;
+  for (;;) {
+    // Leave the input in the socket until the client takes its output;
+    // flush() resumes, as no new edge may come.
+    connection.paused = connection.output.size() - connection.written >
+                        options_.max_output_bytes;
+    if (connection.paused) break;
+    const ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+      connection.reader.feed(buffer, size_t(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n == 0) {
+      connection.eof = true;
+    } else {
+      closed = errno != EAGAIN && errno != EWOULDBLOCK;
+    }
+    break;
+  }
+
+  Message request;
+  try {
+    while (connection.reader.next(request)) {
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.requests;
+      }
+      const uint64_t request_id = request.id;
+      ++connection.in_flight;
+      if (request.status != MessageStatus::kOk || request.tensor.empty()) {
+        Message reply;
+        reply.id = request_id;
+        reply.status = MessageStatus::kError;
+        reply.error = "request must carry a non-empty tensor";
+        respond(id, reply);
+        continue;
+      }
+      batcher_->submit(std::move(request.tensor),
+                       [this, id, request_id](Tensor<float> result,
+                                              std::exception_ptr error) {
+                         Message reply;
+                         reply.id = request_id;
+                         if (error) {
+                           reply.status = MessageStatus::kError;
+                           try {
+                             std::rethrow_exception(error);
+                           } catch (const std::exception& e) {
+                             reply.error = e.what();
+                           } catch (...) {
+                             reply.error = "unknown error";
+                           }
+                         } else {
+                           reply.tensor = std::move(result);
+                         }
+                         respond(id, reply);
+                       });
+    }
+  } catch (const std::runtime_error&) {
+    // Malformed stream (or the batcher stopped): drop the client.
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.dropped;
+    closed = true;
+  }
+  // After EOF, stay open until every request read is answered and sent.
+  if (closed || (connection.eof && connection.in_flight == 0 &&
+                 connection.written == connection.output.size()))
+    close(id);
+}
+
+/**
+ * @brief Send as much queued output as the socket accepts.
+ */
+void InferenceServer::flush(uint64_t id) {
+  auto it = connections_.find(id);
+  if (it == connections_.end()) return;
+  Connection& connection = *it->second;
+  while (connection.writable &&
+         connection.written < connection.output.size()) {
+    const ssize_t n = send(connection.fd,
+                           connection.output.data() + connection.written,
+                           connection.output.size() - connection.written,
+                           MSG_NOSIGNAL);
+    if (n > 0) {
+      connection.written += size_t(n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      connection.writable = false;  // EPOLLOUT resumes the flush
+    } else {
+      close(id);
+      return;
+    }
+  }
+  if (connection.written == connection.output.size()) {
+    connection.output.clear();
+    connection.written = 0;
+    if (connection.eof && connection.in_flight == 0) {
+      close(id);
+      return;
+    }
+  }
+  if (connection.paused && connection.output.size() - connection.written <=
+                               options_.max_output_bytes)
+    read(id);
+}
+
+/**
+ * @brief Forget a connection; its pending responses are discarded.
+ */
+void InferenceServer::close(uint64_t id) {
+  auto it = connections_.find(id);
+  if (it == connections_.end()) return;
+  ::close(it->second->fd);  // also removes it from the epoll set
+  connections_.erase(it);
+}
+
+/**
+ * @brief Move completed responses to their connections and send them.
+ */
+void InferenceServer::deliver() {
+  std::vector<std::pair<uint64_t, std::vector<uint8_t>>> done;
+  {
+    std::lock_guard<std::mutex> lock(done_mutex_);
+    done.swap(done_);
+  }
+  for (auto& [id, bytes] : done) {
+    auto it = connections_.find(id);
+    if (it == connections_.end()) continue;  // client left
+    --it->second->in_flight;
+    std::vector<uint8_t>& output = it->second->output;
+    output.insert(output.end(), bytes.begin(), bytes.end());
+  }
+  for (auto& [id, bytes] : done) flush(id);
+}
+
+/**
+ * @brief Queue a response for the loop thread (any thread).
+ */
+void InferenceServer::respond(uint64_t connection, const Message& message) {
+  std::vector<uint8_t> bytes;
+  try {
+    encode_message(message, bytes);
+  } catch (const std::invalid_argument& e) {
+    // A result too large for one frame still gets an answer, which also
+    // settles the request's in_flight count.
+    Message reply;
+    reply.id = message.id;
+    reply.status = MessageStatus::kError;
+    reply.error = e.what();
+    bytes.clear();
+    encode_message(reply, bytes);
+  }
+  {
+    std::lock_guard<std::mutex> lock(done_mutex_);
+    done_.emplace_back(connection, std::move(bytes));
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.responses;
+  }
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t written = ::write(event_fd_, &one, 8);
+}
@@ -0,0 +1,106 @@
+#include "utils/arena.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+/** Alignment of arena blocks, so tensor buffers need no padding. */
+static constexpr size_t kBlockAlignment = 64;
+
+/**
+ * @brief Construct an empty arena.
+ */
+MonotonicArena::MonotonicArena(size_t block_size,
+                               std::pmr::memory_resource* upstream)
+    : upstream_(upstream), block_size_(block_size) {
+  if (block_size == 0)
+    throw std::invalid_argument("MonotonicArena: block size must be positive");
+}
+
+/**
+ * @brief Return the blocks to the upstream resource.
+ */
+MonotonicArena::~MonotonicArena() { release(); }
+
+/**
+ * @brief Rewind the arena, merging its blocks into one.
+ */
+void MonotonicArena::reset() {
+  if (blocks_.size() > 1) {
+    const size_t total = capacity();
+    release();
+    blocks_.push_back({upstream_->allocate(total, kBlockAlignment), total});
+  }
+  offset_ = 0;
+  used_ = 0;
+}
+
+/**
+ * @brief Return every block to the upstream resource.
+ */
+void MonotonicArena::release() {
+  for (const Block& block : blocks_)
+    upstream_->deallocate(block.data, block.size, kBlockAlignment);
+  blocks_.clear();
+  offset_ = 0;
+  used_ = 0;
+}
+
+/**
+ * @brief Get the number of bytes held in blocks.
+ */
+size_t MonotonicArena::capacity() const {
+  size_t total = 0;
+  for (const Block& block : blocks_) total += block.size;
+  return total;
+}
+
+/**
+ * @brief Bump-allocate from the last block, adding a block if it is full.
+ */
+void* MonotonicArena::do_allocate(size_t bytes, size_t alignment) {
+  if (!blocks_.empty()) {
+    const Block& block = blocks_.back();
+    const auto base = reinterpret_cast<uintptr_t>(block.data);
+    const uintptr_t start =
+        (base + offset_ + alignment - 1) & ~uintptr_t(alignment - 1);
+    const size_t end = size_t(start - base) + bytes;
+    if (end <= block.size) {
+      used_ += end - offset_;
+      offset_ = end;
+      return reinterpret_cast<void*>(start);
+    }
+  }
+  // Blocks grow geometrically so a large batch needs few of them; reset()
+  // then merges them.
+  size_t size = block_size_;
+  while (size < bytes + alignment) size *= 2;
+  block_size_ = size * 2;
+  blocks_.push_back({upstream_->allocate(size, kBlockAlignment), size});
+  const auto base = reinterpret_cast<uintptr_t>(blocks_.back().data);
+  const uintptr_t start =
+      (base + alignment - 1) & ~uintptr_t(alignment - 1);
+  offset_ = size_t(start - base) + bytes;
+  used_ += offset_;
+  return reinterpret_cast<void*>(start);
+}
+
+/**
+ * @brief Do nothing; memory is reclaimed by reset().
+ */
+void MonotonicArena::do_deallocate(void*, size_t, size_t) {}
+
+/**
+ * @brief Arenas are only interchangeable with themselves.
+ */
+bool MonotonicArena::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+/**
+ * @brief Get the calling thread's pool allocator.
+ */
+std::pmr::memory_resource* thread_pool_resource() {
+  thread_local std::pmr::unsynchronized_pool_resource pool;
+  return &pool;
+}
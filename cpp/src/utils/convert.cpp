@@ -0,0 +1,195 @@
+#include "utils/convert.h"
+
+#include "utils/cpu_features.h"
+
+#if defined(VF_X86)
+#include <immintrin.h>
+
+/**
+ * @brief Convert floats to half precision with AVX-512F, 16 per iteration.
+ *
+ * The all-ones masked forms are used because GCC warns about the undefined
+ * pass-through operand of the unmasked intrinsics.
+ *
+ * @return Number of values converted.
+ */
+VF_TARGET("avx512f")
+static size_t f32_to_f16_avx512(const float* src, size_t n, Half* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        _mm512_maskz_cvtps_ph(0xffff, _mm512_loadu_ps(src + i),
+                              _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  return i;
+}
+
+/**
+ * @brief Convert floats to half precision with F16C, 8 per iteration.
+ */
+VF_TARGET("avx,f16c")
+static size_t f32_to_f16_f16c(const float* src, size_t n, Half* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  return i;
+}
+
+/**
+ * @brief Convert half precision values to floats with AVX-512F.
+ */
+VF_TARGET("avx512f")
+static size_t f16_to_f32_avx512(const Half* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_ps(dst + i,
+                     _mm512_maskz_cvtph_ps(0xffff, _mm256_loadu_si256(
+                         reinterpret_cast<const __m256i*>(src + i))));
+  return i;
+}
+
+/**
+ * @brief Convert half precision values to floats with F16C.
+ */
+VF_TARGET("avx,f16c")
+static size_t f16_to_f32_f16c(const Half* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(
+                                  reinterpret_cast<const __m128i*>(src + i))));
+  return i;
+}
+
+/**
+ * @brief Convert floats to bfloat16 with `vcvtneps2bf16`, 16 per iteration.
+ *
+ * The instruction treats subnormal inputs as zero.
+ */
+VF_TARGET("avx512f,avx512bf16")
+static size_t f32_to_bf16_avx512(const float* src, size_t n, BFloat16* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        (__m256i)_mm512_cvtneps_pbh(_mm512_loadu_ps(src + i)));
+  return i;
+}
+
+/**
+ * @brief Round eight floats to bfloat16 in the low half of each 32-bit lane.
+ */
+VF_TARGET("avx2")
+static inline __m256i round_bf16_avx2(__m256i u) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i half = _mm256_set1_epi32(0x7fff);
+  const __m256i magnitude = _mm256_and_si256(u, _mm256_set1_epi32(0x7fffffff));
+  const __m256i nan =
+      _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(0x7f800000));
+  const __m256i upper = _mm256_srli_epi32(u, 16);
+  const __m256i rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(u, _mm256_add_epi32(half, _mm256_and_si256(upper, one))),
+      16);
+  const __m256i quiet = _mm256_or_si256(upper, _mm256_set1_epi32(0x40));
+  return _mm256_blendv_epi8(rounded, quiet, nan);
+}
+
+/**
+ * @brief Convert floats to bfloat16 with AVX2 integer rounding.
+ */
+VF_TARGET("avx2")
+static size_t f32_to_bf16_avx2(const float* src, size_t n, BFloat16* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i lo = round_bf16_avx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    const __m256i hi = round_bf16_avx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8)));
+    // The pack interleaves 128-bit lanes; the permute restores the order.
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8));
+  }
+  return i;
+}
+
+/**
+ * @brief Widen bfloat16 values to floats with AVX2.
+ */
+VF_TARGET("avx2")
+static size_t bf16_to_f32_avx2(const BFloat16* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i wide = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_slli_epi32(wide, 16));
+  }
+  return i;
+}
+#endif
+
+/**
+ * @brief Convert floats to half precision.
+ */
+void convert(const float* src, size_t n, Half* dst) {
+  size_t i = 0;
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512f)
+    i = f32_to_f16_avx512(src, n, dst);
+  else if (cpu.f16c)
+    i = f32_to_f16_f16c(src, n, dst);
+#endif
+  for (; i < n; ++i) dst[i] = Half(src[i]);
+}
+
+/**
+ * @brief Convert half precision values to floats (exact).
+ */
+void convert(const Half* src, size_t n, float* dst) {
+  size_t i = 0;
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512f)
+    i = f16_to_f32_avx512(src, n, dst);
+  else if (cpu.f16c)
+    i = f16_to_f32_f16c(src, n, dst);
+#endif
+  for (; i < n; ++i) dst[i] = float(src[i]);
+}
+
+/**
+ * @brief Convert floats to bfloat16.
+ */
+void convert(const float* src, size_t n, BFloat16* dst) {
+  size_t i = 0;
+#if defined(VF_X86)
+  const CpuFeatures& cpu = cpu_features();
+  if (cpu.avx512bf16)
+    i = f32_to_bf16_avx512(src, n, dst);
+  else if (cpu.avx2)
+    i = f32_to_bf16_avx2(src, n, dst);
+#endif
+  for (; i < n; ++i) dst[i] = BFloat16(src[i]);
+}
+
+/**
+ * @brief Convert bfloat16 values to floats (exact).
+ */
+void convert(const BFloat16* src, size_t n, float* dst) {
+  size_t i = 0;
+#if defined(VF_X86)
+  if (cpu_features().avx2) i = bf16_to_f32_avx2(src, n, dst);
+#endif
+  for (; i < n; ++i) dst[i] = float(src[i]);
+}
+
+/**
+ * @brief Convert 8-bit pixels to floats (exact).
+ */
+void convert(const uint8_t* src, size_t n, float* dst) {
+  for (size_t i = 0; i < n; ++i) dst[i] = float(src[i]);
+}
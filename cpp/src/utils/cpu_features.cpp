@@ -0,0 +1,151 @@
+#include "utils/cpu_features.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(VF_X86)
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(VF_X86)
+/**
+ * @brief Execute the CPUID instruction.
+ *
+ * @param leaf Function number (EAX input).
+ * @param subleaf Sub-function number (ECX input).
+ * @param regs Receives EAX, EBX, ECX and EDX.
+ */
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(r[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ * @brief Read extended control register 0 (enabled OS register state).
+ *
+ * @return The value of XCR0.
+ */
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t lo = 0, hi = 0;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+/**
+ * @brief Query the host CPU for supported instruction set extensions.
+ *
+ * @return The detected feature set.
+ */
+static CpuFeatures detect() {
+  CpuFeatures f;
+#if defined(VF_X86)
+  uint32_t r[4];
+  cpuid(0, 0, r);
+  const uint32_t max_leaf = r[0];
+  if (max_leaf < 1) return f;
+
+  cpuid(1, 0, r);
+  const bool osxsave = (r[2] >> 27) & 1;
+  const bool avx = (r[2] >> 28) & 1;
+  if (!osxsave || !avx) return f;
+
+  // The OS must preserve YMM state for AVX and ZMM/opmask state for AVX-512.
+  const uint64_t xcr0 = xgetbv0();
+  const bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+  const bool zmm_enabled = (xcr0 & 0xE6) == 0xE6;
+  if (!ymm_enabled) return f;
+
+  f.fma = (r[2] >> 12) & 1;
+  f.f16c = (r[2] >> 29) & 1;
+
+  if (max_leaf >= 7) {
+    cpuid(7, 0, r);
+    f.avx2 = (r[1] >> 5) & 1;
+    if (zmm_enabled) {
+      f.avx512f = (r[1] >> 16) & 1;
+      f.avx512bw = (r[1] >> 30) & 1;
+      f.avx512vl = (r[1] >> 31) & 1;
+      f.avx512vnni = (r[2] >> 11) & 1;
+    }
+    const uint32_t max_subleaf = r[0];
+    if (max_subleaf >= 1) {
+      cpuid(7, 1, r);
+      f.avxvnni = (r[0] >> 4) & 1;
+      f.avx512bf16 = zmm_enabled && ((r[0] >> 5) & 1);
+    }
+  }
+#endif
+  return f;
+}
+
+/**
+ * @brief Read the CPU brand string from the extended CPUID leaves.
+ *
+ * @return The trimmed brand string, or "unknown".
+ */
+static std::string detect_model() {
+  std::string model;
+#if defined(VF_X86)
+  uint32_t r[4];
+  cpuid(0x80000000u, 0, r);
+  if (r[0] >= 0x80000004u) {
+    char brand[49] = {};
+    for (uint32_t leaf = 0; leaf < 3; ++leaf) {
+      cpuid(0x80000002u + leaf, 0, r);
+      std::memcpy(brand + 16 * leaf, r, 16);
+    }
+    model = brand;
+  }
+#endif
+  const size_t first = model.find_first_not_of(' ');
+  if (first == std::string::npos) return "unknown";
+  return model.substr(first, model.find_last_not_of(' ') - first + 1);
+}
+
+/**
+ * @brief Storage for the feature set reported by cpu_features().
+ *
+ * @return Reference to the active feature set.
+ */
+static CpuFeatures& active() {
+  static CpuFeatures features = detect();
+  return features;
+}
+
+/**
+ * @brief Get the instruction set extensions of the host CPU.
+ */
+const CpuFeatures& cpu_features() { return active(); }
+
+/**
+ * @brief Get the model name of the host CPU.
+ */
+const std::string& cpu_model() {
+  static const std::string model = detect_model();
+  return model;
+}
+
+/**
+ * @brief Override the feature set reported by cpu_features().
+ */
+void set_cpu_features(const CpuFeatures& features) { active() = features; }
+
+/**
+ * @brief Restore the feature set detected from the host CPU.
+ */
+void reset_cpu_features() { active() = detect(); }
@@ -0,0 +1,524 @@
+#include "utils/frame_ring.h"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+/**
+ * @brief Round @p bytes up to a whole number of cache lines.
+ */
+static size_t cache_lines(size_t bytes) {
+  return (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+}
+
+/**
+ * @brief Get slot @p i of the ring mapped at @p base.
+ */
+static FrameSlotHeader* ring_slot(uint8_t* base, size_t stride, size_t i) {
+  return reinterpret_cast<FrameSlotHeader*>(
+      base + cache_lines(sizeof(FrameRingHeader)) + i * stride);
+}
+
+/**
+ * @brief Check that a frame description fits a slot of @p slot_bytes.
+ *
+ * The description lives in memory other processes write, so the size is
+ * checked factor by factor instead of trusting FrameInfo::bytes().
+ */
+static bool frame_fits(const FrameInfo& info, size_t slot_bytes) {
+  if (info.type != FramePixelType::kUInt8 &&
+      info.type != FramePixelType::kFloat32)
+    return false;
+  uint64_t bytes = frame_pixel_size(info.type);
+  for (const uint64_t d : {info.width, info.height, info.channels}) {
+    if (d != 0 && bytes > slot_bytes / d) return false;
+    bytes *= d;
+  }
+  return true;
+}
+
+/**
+ * @brief Get the pixels of a slot.
+ */
+static uint8_t* slot_pixels(FrameSlotHeader* slot) {
+  return reinterpret_cast<uint8_t*>(slot) + sizeof(FrameSlotHeader);
+}
+
+/**
+ * @brief Mapping of an attached reader, shared with the frames it handed
+ * out so that it outlives them.
+ */
+struct FrameRingReader::State {
+  uint8_t* base = nullptr;              /**< Start of the mapping */
+  size_t size = 0;                      /**< Length of the mapping */
+  FrameRingHeader* header = nullptr;    /**< Ring header */
+  size_t slot_count = 0;                /**< Number of slots, as validated */
+  size_t slot_bytes = 0;                /**< Pixel capacity, as validated */
+  size_t slot_stride = 0;               /**< Slot distance, as validated */
+  size_t reader = 0;                    /**< Index of the reader's pins */
+  std::mutex mutex;                     /**< Guards counts */
+  uint32_t counts[kMaxFrameSlots] = {}; /**< Frames held per slot */
+
+  /**
+   * @brief Drop one hold on slot @p i, unpinning it after the last one.
+   */
+  void unpin(size_t i) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--counts[i] == 0)
+      header->pins[reader].fetch_and(~(uint64_t(1) << i),
+                                     std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Unpin everything, release the reader entry and unmap.
+   */
+  ~State();
+};
+
+/**
+ * @brief Ask readers to wake up and re-check the ring.
+ */
+static void wake_readers(FrameRingHeader* header) {
+  // Orders the publication before the waiter check (pairs with the fence
+  // in FrameRingReader::waitFor()).
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header->waiters.load(std::memory_order_relaxed) == 0) return;
+  header->epoch.fetch_add(1, std::memory_order_release);
+  futex_wake(header->epoch, true, true);
+}
+
+#if defined(_WIN32)
+/**
+ * @brief Frame rings need POSIX shared memory.
+ */
+FrameRingWriter::FrameRingWriter(const std::string& name, size_t, size_t)
+    : name_(name) {
+  throw std::runtime_error("FrameRingWriter: not supported on Windows");
+}
+
+/**
+ * @brief Nothing to release.
+ */
+FrameRingWriter::~FrameRingWriter() = default;
+
+/**
+ * @brief Frame rings need POSIX shared memory.
+ */
+FrameRingReader::FrameRingReader(const std::string&) {
+  throw std::runtime_error("FrameRingReader: not supported on Windows");
+}
+
+/**
+ * @brief Nothing to release.
+ */
+FrameRingReader::State::~State() = default;
+
+/**
+ * @brief Readers never attach on Windows.
+ */
+static bool reclaim_dead_readers(FrameRingHeader*) { return false; }
+#else
+/**
+ * @brief Check whether process @p pid still exists.
+ */
+static bool process_alive(uint32_t pid) {
+  return ::kill(pid_t(pid), 0) == 0 || errno != ESRCH;
+}
+
+/**
+ * @brief Release the entries and pins of readers whose process died.
+ *
+ * @return Whether any entry was released.
+ */
+static bool reclaim_dead_readers(FrameRingHeader* header) {
+  const auto self = uint32_t(::getpid());
+  bool reclaimed = false;
+  for (size_t r = 0; r < kMaxFrameReaders; ++r) {
+    uint32_t owner = header->attached[r].load(std::memory_order_acquire);
+    if (owner == 0 || process_alive(owner)) continue;
+    // Take the entry before clearing its pins, so a reader attaching to it
+    // meanwhile cannot lose pins it has just set.
+    if (!header->attached[r].compare_exchange_strong(owner, self)) continue;
+    header->pins[r].store(0, std::memory_order_seq_cst);
+    header->attached[r].store(0, std::memory_order_release);
+    reclaimed = true;
+  }
+  return reclaimed;
+}
+
+/**
+ * @brief Create (or replace) the ring.
+ */
+FrameRingWriter::FrameRingWriter(const std::string& name, size_t slots,
+                                 size_t slot_bytes)
+    : name_(name) {
+  if (slots < 2 || slots > kMaxFrameSlots)
+    throw std::invalid_argument("FrameRingWriter: slots must be in [2, " +
+                                std::to_string(kMaxFrameSlots) + "]");
+  if (slot_bytes == 0)
+    throw std::invalid_argument("FrameRingWriter: slot size must be positive");
+  const size_t stride = cache_lines(sizeof(FrameSlotHeader) + slot_bytes);
+  size_ = cache_lines(sizeof(FrameRingHeader)) + slots * stride;
+
+  // A previous writer that crashed leaves its object behind.
+  ::shm_unlink(name.c_str());
+  const int fd =
+      ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(),
+                            "shm_open " + name);
+  if (::ftruncate(fd, off_t(size_)) != 0) {
+    const int err = errno;
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    throw std::system_error(err, std::generic_category(), "ftruncate " + name);
+  }
+  void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int err = errno;
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    ::shm_unlink(name.c_str());
+    throw std::system_error(err, std::generic_category(), "mmap " + name);
+  }
+  base_ = static_cast<uint8_t*>(p);
+
+  header_ = new (base_) FrameRingHeader();
+  header_->version = kFrameRingVersion;
+  header_->slot_count = uint32_t(slots);
+  header_->slot_bytes = slot_bytes;
+  header_->slot_stride = stride;
+  for (size_t i = 0; i < slots; ++i) new (slot(i)) FrameSlotHeader();
+  // Readers check the magic last, so they never see a half-built ring.
+  header_->magic.store(kFrameRingMagic, std::memory_order_release);
+}
+
+/**
+ * @brief Mark the ring closed, wake readers and remove the object.
+ */
+FrameRingWriter::~FrameRingWriter() {
+  header_->closed.store(1, std::memory_order_seq_cst);
+  header_->epoch.fetch_add(1, std::memory_order_release);
+  futex_wake(header_->epoch, true, true);
+  ::munmap(base_, size_);
+  ::shm_unlink(name_.c_str());
+}
+
+/**
+ * @brief Attach to a ring created by a FrameRingWriter.
+ */
+FrameRingReader::FrameRingReader(const std::string& name) {
+  const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(),
+                            "shm_open " + name);
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), "stat " + name);
+  }
+  const auto size = size_t(st.st_size);
+  if (size < cache_lines(sizeof(FrameRingHeader))) {
+    ::close(fd);
+    throw std::runtime_error("FrameRingReader: " + name +
+                             " is not a frame ring");
+  }
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int err = errno;
+  ::close(fd);
+  if (p == MAP_FAILED)
+    throw std::system_error(err, std::generic_category(), "mmap " + name);
+
+  auto* header = static_cast<FrameRingHeader*>(p);
+  const auto fail = [&](const std::string& what) {
+    ::munmap(p, size);
+    throw std::runtime_error("FrameRingReader: " + name + " " + what);
+  };
+  if (header->magic.load(std::memory_order_acquire) != kFrameRingMagic)
+    fail("is not an initialized frame ring");
+  if (header->version != kFrameRingVersion)
+    fail("has layout version " + std::to_string(header->version));
+  // Slots are located with this geometry from now on, so it is checked
+  // once here and kept out of reach of the shared header.
+  const uint64_t slot_bytes = header->slot_bytes;
+  const uint64_t stride = header->slot_stride;
+  if (slot_bytes == 0 || slot_bytes > size || stride > size ||
+      stride % kCacheLineSize != 0 ||
+      stride < sizeof(FrameSlotHeader) + slot_bytes)
+    fail("has an invalid slot layout");
+  if (header->slot_count < 2 || header->slot_count > kMaxFrameSlots ||
+      cache_lines(sizeof(FrameRingHeader)) + header->slot_count * stride >
+          size)
+    fail("is truncated");
+  const auto self = uint32_t(::getpid());
+  size_t reader = kMaxFrameReaders;
+  for (size_t r = 0; r < kMaxFrameReaders && reader == kMaxFrameReaders; ++r) {
+    uint32_t owner = header->attached[r].load(std::memory_order_acquire);
+    // A reader that died without detaching leaves its entry behind.
+    if (owner != 0 && process_alive(owner)) continue;
+    if (header->attached[r].compare_exchange_strong(owner, self))
+      reader = r;
+  }
+  if (reader == kMaxFrameReaders) fail("has too many readers");
+  header->pins[reader].store(0, std::memory_order_seq_cst);
+
+  state_ = std::make_shared<State>();
+  state_->base = static_cast<uint8_t*>(p);
+  state_->size = size;
+  state_->header = header;
+  state_->slot_count = header->slot_count;
+  state_->slot_bytes = slot_bytes;
+  state_->slot_stride = stride;
+  state_->reader = reader;
+}
+
+/**
+ * @brief Unpin everything, release the reader entry and unmap.
+ */
+FrameRingReader::State::~State() {
+  if (!base) return;
+  header->pins[reader].store(0, std::memory_order_seq_cst);
+  header->attached[reader].store(0, std::memory_order_release);
+  ::munmap(base, size);
+}
+#endif
+
+/**
+ * @brief Get slot @p i.
+ */
+FrameSlotHeader* FrameRingWriter::slot(size_t i) const {
+  return ring_slot(base_, header_->slot_stride, i);
+}
+
+/**
+ * @brief Check whether any reader holds slot @p i.
+ */
+bool FrameRingWriter::pinned(size_t i) const {
+  const uint64_t bit = uint64_t(1) << i;
+  for (const auto& pins : header_->pins)
+    if (pins.load(std::memory_order_seq_cst) & bit) return true;
+  return false;
+}
+
+/**
+ * @brief Claim the oldest slot no reader holds.
+ */
+void* FrameRingWriter::begin() {
+  current_.reset();  // an abandoned slot stays odd, i.e. invalid
+  const size_t n = slots();
+  // Only when every slot is held are readers checked for having died.
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass == 1 && !reclaim_dead_readers(header_)) break;
+    for (size_t k = 0; k < n; ++k) {
+      const size_t i = (next_slot_ + k) % n;
+      if (pinned(i)) continue;
+      FrameSlotHeader* s = slot(i);
+      const uint64_t previous = s->version.load(std::memory_order_relaxed);
+      s->version.store(2 * next_sequence_ + 1, std::memory_order_seq_cst);
+      // A reader may have pinned the slot after the check above; it then
+      // sees the odd version and lets go, or we see its pin and back off.
+      if (pinned(i)) {
+        s->version.store(previous, std::memory_order_seq_cst);
+        continue;
+      }
+      current_ = i;
+      next_slot_ = (i + 1) % n;
+      return slot_pixels(s);
+    }
+  }
+  ++dropped_;
+  return nullptr;
+}
+
+/**
+ * @brief Publish the frame written since begin() and wake readers.
+ */
+uint64_t FrameRingWriter::commit(FrameInfo info) {
+  if (!current_)
+    throw std::logic_error("FrameRingWriter: commit() without begin()");
+  if (info.bytes() > slotBytes())
+    throw std::invalid_argument("FrameRingWriter: frame exceeds slot size");
+  FrameSlotHeader* s = slot(*current_);
+  info.sequence = next_sequence_;
+  s->info = info;
+  s->version.store(2 * next_sequence_ + 2, std::memory_order_release);
+  current_.reset();
+  header_->published.store(++next_sequence_, std::memory_order_seq_cst);
+  wake_readers(header_);
+  return info.sequence;
+}
+
+/**
+ * @brief Copy a frame in and publish it.
+ */
+bool FrameRingWriter::write(const FrameInfo& info, const void* pixels) {
+  if (info.bytes() > slotBytes())
+    throw std::invalid_argument("FrameRingWriter: frame exceeds slot size");
+  void* data = begin();
+  if (!data) return false;
+  std::memcpy(data, pixels, info.bytes());
+  commit(info);
+  return true;
+}
+
+/**
+ * @brief Detach; frames still held keep the mapping alive.
+ */
+FrameRingReader::~FrameRingReader() = default;
+
+/**
+ * @brief Get the number of slots.
+ */
+size_t FrameRingReader::slots() const { return state_->slot_count; }
+
+/**
+ * @brief Get the number of frames published so far.
+ */
+uint64_t FrameRingReader::published() const {
+  return state_->header->published.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Check whether the writer has gone away.
+ */
+bool FrameRingReader::closed() const {
+  return state_->header->closed.load(std::memory_order_acquire) != 0;
+}
+
+/**
+ * @brief Pin slot @p slot if it still holds frame @p sequence.
+ */
+std::optional<SharedFrame> FrameRingReader::pin(size_t slot,
+                                                uint64_t sequence) const {
+  State& state = *state_;
+  FrameSlotHeader* s = ring_slot(state.base, state.slot_stride, slot);
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.counts[slot]++ == 0)
+      state.header->pins[state.reader].fetch_or(uint64_t(1) << slot,
+                                                std::memory_order_seq_cst);
+  }
+  // Pairs with the writer's re-check in begin(): if the version still
+  // matches, the writer will see the pin before touching the slot.
+  if (s->version.load(std::memory_order_seq_cst) != 2 * sequence + 2) {
+    state.unpin(slot);
+    return std::nullopt;
+  }
+  // The writer leaves a pinned slot alone, so the description is stable;
+  // it is still checked, since any process mapping the ring can write it.
+  const FrameInfo info = s->info;
+  if (!frame_fits(info, state.slot_bytes)) {
+    state.unpin(slot);
+    throw std::runtime_error("FrameRingReader: frame exceeds its slot");
+  }
+  uint8_t* data = slot_pixels(s);
+  return SharedFrame{
+      info, data,
+      std::shared_ptr<void>(data, [state = state_, slot](void*) {
+        state->unpin(slot);
+      })};
+}
+
+/**
+ * @brief Get a frame by sequence number.
+ */
+std::optional<SharedFrame> FrameRingReader::get(uint64_t sequence) const {
+  if (sequence >= published()) return std::nullopt;
+  const uint64_t version = 2 * sequence + 2;
+  // A slot the writer backed off from is briefly odd; look twice.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    bool busy = false;
+    for (size_t i = 0; i < slots(); ++i) {
+      const uint64_t v =
+          ring_slot(state_->base, state_->slot_stride, i)
+              ->version.load(std::memory_order_acquire);
+      if (v == version) return pin(i, sequence);
+      busy |= (v & 1) != 0;
+    }
+    if (!busy) break;
+    cpu_relax();
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Get the newest complete frame.
+ */
+std::optional<SharedFrame> FrameRingReader::latest() const {
+  // The writer overwrites the oldest slot first, so losing the newest one
+  // to it between the scan and the pin takes a lap; retry a few times.
+  for (size_t attempt = 0; attempt < slots(); ++attempt) {
+    size_t newest = slots();
+    uint64_t best = 0;
+    for (size_t i = 0; i < slots(); ++i) {
+      const uint64_t v =
+          ring_slot(state_->base, state_->slot_stride, i)
+              ->version.load(std::memory_order_acquire);
+      if (v != 0 && (v & 1) == 0 && v > best) {
+        best = v;
+        newest = i;
+      }
+    }
+    if (newest == slots()) return std::nullopt;
+    if (auto frame = pin(newest, best / 2 - 1)) return frame;
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Wait until frame @p sequence is published.
+ */
+bool FrameRingReader::waitFor(uint64_t sequence,
+                              std::chrono::nanoseconds timeout) const {
+  FrameRingHeader* header = state_->header;
+  const auto ready = [&] {
+    return header->published.load(std::memory_order_acquire) > sequence;
+  };
+  for (int i = 0; i < EventCount::kSpins; ++i) {
+    if (ready()) return true;
+    cpu_relax();
+  }
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  for (;;) {
+    header->waiters.fetch_add(1, std::memory_order_seq_cst);
+    // Orders the announcement before the re-check (pairs with the fence
+    // in wake_readers()).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint32_t key = header->epoch.load(std::memory_order_acquire);
+    const auto remaining = deadline - std::chrono::steady_clock::now();
+    if (ready() || closed() || remaining <= remaining.zero()) {
+      header->waiters.fetch_sub(1, std::memory_order_relaxed);
+      return ready();
+    }
+    futex_wait_for(header->epoch, key, remaining, true);
+    header->waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Wait for a frame newer than @p after and return the newest one.
+ */
+std::optional<SharedFrame> FrameRingReader::waitLatest(
+    uint64_t after, std::chrono::nanoseconds timeout) const {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  const uint64_t next = after + 1;  // wraps to 0 for "no frame yet"
+  while (waitFor(next, timeout)) {
+    if (auto frame = latest(); frame && frame->info.sequence >= next)
+      return frame;
+    timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (timeout <= timeout.zero()) break;
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,119 @@
+#include "utils/mapped_file.h"
+
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#if defined(_WIN32)
+/**
+ * @brief Map the file at @p path into memory.
+ */
+MappedFile::MappedFile(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::system_error(static_cast<int>(GetLastError()),
+                            std::system_category(), "open " + path);
+  file_ = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    const auto err = static_cast<int>(GetLastError());
+    release();
+    throw std::system_error(err, std::system_category(), "stat " + path);
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  if (size_ == 0) return;
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ == nullptr) {
+    const auto err = static_cast<int>(GetLastError());
+    release();
+    throw std::system_error(err, std::system_category(), "map " + path);
+  }
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == nullptr) {
+    const auto err = static_cast<int>(GetLastError());
+    release();
+    throw std::system_error(err, std::system_category(), "map " + path);
+  }
+}
+
+/**
+ * @brief Release the view and handles owned by the mapping.
+ */
+void MappedFile::release() noexcept {
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_) CloseHandle(file_);
+  data_ = nullptr;
+  mapping_ = file_ = nullptr;
+  size_ = 0;
+}
+#else
+/**
+ * @brief Map the file at @p path into memory.
+ */
+MappedFile::MappedFile(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), "stat " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      const int err = errno;
+      ::close(fd);
+      size_ = 0;
+      throw std::system_error(err, std::generic_category(), "mmap " + path);
+    }
+    data_ = static_cast<const uint8_t*>(p);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+}
+
+/**
+ * @brief Unmap the file.
+ */
+void MappedFile::release() noexcept {
+  if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+#endif
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    release();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#if defined(_WIN32)
+    std::swap(file_, other.file_);
+    std::swap(mapping_, other.mapping_);
+#endif
+  }
+  return *this;
+}
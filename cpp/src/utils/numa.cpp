@@ -0,0 +1,308 @@
+#include "utils/numa.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** `mbind` mode placing pages on the given nodes only (linux/mempolicy.h). */
+static constexpr int kMpolBind = 2;
+#endif
+
+/**
+ * @brief Parse a kernel CPU list such as "0-3,8,10-11".
+ */
+std::vector<size_t> parse_cpu_list(const std::string& list) {
+  std::vector<size_t> cpus;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    item.erase(std::remove_if(item.begin(), item.end(),
+                              [](unsigned char c) { return std::isspace(c); }),
+               item.end());
+    if (item.empty()) continue;
+    const size_t dash = item.find('-');
+    size_t first = 0, last = 0;
+    try {
+      size_t used = 0;
+      first = std::stoul(item.substr(0, dash), &used);
+      if (used != std::min(dash, item.size()))
+        throw std::invalid_argument(item);
+      last = first;
+      if (dash != std::string::npos) {
+        last = std::stoul(item.substr(dash + 1), &used);
+        if (used != item.size() - dash - 1) throw std::invalid_argument(item);
+      }
+    } catch (const std::logic_error&) {
+      throw std::invalid_argument("parse_cpu_list: bad entry '" + item + "'");
+    }
+    if (last < first)
+      throw std::invalid_argument("parse_cpu_list: bad range '" + item + "'");
+    for (size_t cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+/**
+ * @brief Read the NUMA topology from sysfs.
+ */
+std::vector<NumaNode> read_numa_topology(const std::string& root) {
+  namespace fs = std::filesystem;
+  std::vector<NumaNode> nodes;
+  std::error_code error;
+  for (fs::directory_iterator it(root, error), end; !error && it != end;
+       it.increment(error)) {
+    const std::string name = it->path().filename().string();
+    if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+        !std::all_of(name.begin() + 4, name.end(),
+                     [](unsigned char c) { return std::isdigit(c); }))
+      continue;
+    NumaNode node;
+    node.id = std::stoul(name.substr(4));
+    std::ifstream cpulist(it->path() / "cpulist");
+    std::string list;
+    std::getline(cpulist, list);
+    node.cpus = parse_cpu_list(list);
+    // e.g. "Node 0 MemTotal:       6158152 kB"
+    std::ifstream meminfo(it->path() / "meminfo");
+    for (std::string line; std::getline(meminfo, line);) {
+      std::istringstream fields(line);
+      std::string tag, id, key;
+      size_t kb = 0;
+      if (fields >> tag >> id >> key >> kb && key == "MemTotal:") {
+        node.memory_bytes = kb * 1024;
+        break;
+      }
+    }
+    nodes.push_back(std::move(node));
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+  return nodes;
+}
+
+/**
+ * @brief Get the NUMA topology of the machine.
+ */
+const std::vector<NumaNode>& numa_nodes() {
+  static const std::vector<NumaNode> nodes = [] {
+    std::vector<NumaNode> found;
+#if defined(__linux__)
+    found = read_numa_topology();
+#endif
+    if (found.empty()) {
+      NumaNode all;
+      for (size_t cpu = 0; cpu < hardware_threads(); ++cpu)
+        all.cpus.push_back(cpu);
+      found.push_back(std::move(all));
+    }
+    return found;
+  }();
+  return nodes;
+}
+
+/**
+ * @brief Find a node by id.
+ *
+ * @throws std::invalid_argument if there is none.
+ */
+static const NumaNode& find_node(size_t node, const char* caller) {
+  for (const NumaNode& n : numa_nodes())
+    if (n.id == node) return n;
+  throw std::invalid_argument(std::string(caller) + ": no NUMA node " +
+                              std::to_string(node));
+}
+
+/**
+ * @brief Get the node of a CPU.
+ */
+size_t numa_node_of_cpu(size_t cpu) {
+  for (const NumaNode& node : numa_nodes())
+    if (std::binary_search(node.cpus.begin(), node.cpus.end(), cpu))
+      return node.id;
+  return 0;
+}
+
+/**
+ * @brief Get the node the calling thread is currently running on.
+ */
+size_t current_numa_node() {
+#if defined(__linux__)
+  const int cpu = sched_getcpu();
+  if (cpu >= 0) return numa_node_of_cpu(size_t(cpu));
+#endif
+  return numa_nodes().front().id;
+}
+
+#if defined(__linux__)
+/**
+ * @brief Build the CPU set of a node.
+ *
+ * @throws std::invalid_argument if the node has no CPUs.
+ */
+static cpu_set_t node_cpu_set(const NumaNode& node, const char* caller) {
+  if (node.cpus.empty())
+    throw std::invalid_argument(std::string(caller) + ": NUMA node " +
+                                std::to_string(node.id) + " has no CPUs");
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t cpu : node.cpus)
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  return set;
+}
+#endif
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node.
+ */
+void bind_thread_to_numa_node(size_t node) {
+  const NumaNode& n = find_node(node, "bind_thread_to_numa_node");
+#if defined(__linux__)
+  const cpu_set_t set = node_cpu_set(n, "bind_thread_to_numa_node");
+  if (const int err = pthread_setaffinity_np(pthread_self(), sizeof(set),
+                                             &set))
+    throw std::system_error(err, std::system_category(),
+                            "bind_thread_to_numa_node");
+#else
+  if (n.cpus.empty())
+    throw std::invalid_argument("bind_thread_to_numa_node: NUMA node " +
+                                std::to_string(node) + " has no CPUs");
+#endif
+}
+
+/**
+ * @brief Get the thread pool of a node.
+ */
+ThreadPool& numa_thread_pool(size_t node) {
+  static std::mutex mutex;
+  static std::map<size_t, ThreadPool*> pools;
+  const NumaNode& n = find_node(node, "numa_thread_pool");
+  if (n.cpus.empty())
+    throw std::invalid_argument("numa_thread_pool: NUMA node " +
+                                std::to_string(node) + " has no CPUs");
+  std::lock_guard<std::mutex> lock(mutex);
+  ThreadPool*& pool = pools[node];
+  if (!pool) {
+    ThreadPoolOptions options;
+    options.cpus = n.cpus;
+    options.max_threads = n.cpus.size();
+    pool = &create_thread_pool(options);
+  }
+  return *pool;
+}
+
+/**
+ * @brief Allocate zeroed memory on a node.
+ */
+void* numa_alloc(size_t bytes, size_t node) {
+  const NumaNode& n = find_node(node, "numa_alloc");
+  if (bytes == 0) return nullptr;
+#if defined(__linux__)
+  void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) throw std::bad_alloc();
+  // Explicit placement; may be refused (no NUMA support, sandboxing), in
+  // which case first touch from the node's CPUs places the pages.
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);
+  // The kernel ignores the last bit of maxnode, so leave one spare bit.
+  std::vector<unsigned long> mask((node + 1) / kBitsPerWord + 1, 0);
+  mask[node / kBitsPerWord] = 1ul << (node % kBitsPerWord);
+  syscall(SYS_mbind, ptr, bytes, kMpolBind, mask.data(),
+          mask.size() * kBitsPerWord, 0);
+  cpu_set_t previous;
+  const bool rebind =
+      !n.cpus.empty() &&
+      pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) ==
+          0;
+  if (rebind) {
+    const cpu_set_t set = node_cpu_set(n, "numa_alloc");
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+  const size_t page = size_t(sysconf(_SC_PAGESIZE));
+  for (size_t offset = 0; offset < bytes; offset += page)
+    static_cast<volatile char*>(ptr)[offset] = 0;
+  if (rebind)
+    pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+  return ptr;
+#else
+  (void)n;
+  void* ptr = ::operator new(bytes, std::align_val_t{kTensorAlignment});
+  std::memset(ptr, 0, bytes);
+  return ptr;
+#endif
+}
+
+/**
+ * @brief Release memory from numa_alloc().
+ */
+void numa_free(void* ptr, size_t bytes) {
+  if (!ptr) return;
+#if defined(__linux__)
+  munmap(ptr, bytes);
+#else
+  (void)bytes;
+  ::operator delete(ptr, std::align_val_t{kTensorAlignment});
+#endif
+}
+
+/**
+ * @brief Get memory on a node no tensor is using.
+ */
+std::shared_ptr<void> NumaBufferCache::acquire(size_t bytes, size_t node) {
+  const auto unused = [](const Buffer& b) {
+    return b.memory.use_count() == 1;
+  };
+  for (const Buffer& b : buffers_)
+    if (b.node == node && b.bytes >= bytes && unused(b)) {
+      // Order the last user's accesses before the caller's.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return b.memory;
+    }
+  void* memory = numa_alloc(bytes, node);
+  Buffer fresh{node, bytes, std::shared_ptr<void>(memory, [bytes](void* p) {
+                 numa_free(p, bytes);
+               })};
+  if (buffers_.size() < capacity_) {
+    buffers_.push_back(fresh);
+  } else {
+    // Replace an idle buffer that did not fit, if there is one.
+    const auto idle = std::find_if(buffers_.begin(), buffers_.end(), unused);
+    if (idle != buffers_.end()) *idle = fresh;
+  }
+  return fresh.memory;
+}
+
+/**
+ * @brief Get the node holding the page of an address.
+ */
+int numa_node_of_address(const void* ptr) {
+#if defined(__linux__)
+  const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+  void* pages[1] = {reinterpret_cast<void*>(uintptr_t(ptr) & ~(page - 1))};
+  int status[1] = {-1};
+  if (syscall(SYS_move_pages, 0, 1, pages, nullptr, status, 0) != 0)
+    return -1;
+  return status[0] >= 0 ? status[0] : -1;
+#else
+  (void)ptr;
+  return -1;
+#endif
+}
@@ -0,0 +1,753 @@
+#include "utils/parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/** Thread limit set by set_num_threads() (0 means hardware_threads()). */
+static std::atomic<size_t> g_num_threads{0};
+
+/** Cap of the calling thread's innermost ThreadLimitScope (0: none). */
+static thread_local size_t t_thread_cap = 0;
+
+/** Bumped when the thread limit changes; idle surplus workers wait on it. */
+static std::atomic<uint32_t> g_limit_epoch{0};
+
+/** Most workers the pool starts (the caller is the extra thread). */
+static constexpr size_t kMaxWorkers = 255;
+
+/** Deques lent to threads outside the pool that call parallel_for(). */
+static constexpr size_t kExternalSlots = 16;
+
+/** Chunks per thread targeted by the adaptive chunk size. */
+static constexpr size_t kChunksPerThread = 8;
+
+/** Failed attempts to find work before a thread goes to sleep. */
+static constexpr unsigned kSpins = 64;
+
+/**
+ * @brief Unit of work held in the deques.
+ *
+ * Tasks are intrusive: the spawner owns the storage (a stack frame for
+ * parallel_for(), the heap for TaskGroup) and @p execute signals completion.
+ */
+struct PoolTask {
+  void (*execute)(PoolTask* task) = nullptr; /**< Runs the task */
+};
+
+/**
+ * @brief Fixed-capacity Chase-Lev work-stealing deque.
+ *
+ * The owning thread pushes and pops at the bottom; other threads steal from
+ * the top (Lê et al., "Correct and Efficient Work-Stealing for Weak Memory
+ * Models", 2013). Each slot also records the job its task belongs to, so a
+ * thread waiting for one job steals only that job's tasks, and whether it
+ * is a parallel_for() chunk. When full, push() fails and the caller runs
+ * the work itself.
+ */
+class WorkDeque {
+ private:
+  static constexpr int64_t kCapacity = 256;  /**< Slots (a power of two) */
+  alignas(64) std::atomic<int64_t> top_{0};     /**< Next index to steal */
+  alignas(64) std::atomic<int64_t> bottom_{0};  /**< Next index to push */
+  std::atomic<PoolTask*> tasks_[kCapacity] = {}; /**< Ring of tasks */
+  std::atomic<const void*> jobs_[kCapacity] = {}; /**< Job per slot */
+  std::atomic<bool> chunks_[kCapacity] = {};      /**< Chunk per slot */
+
+  /**
+   * @brief Check whether the owner may take slot @p at while waiting for
+   * @p job: a task of that job, or any task that is not a chunk of another
+   * parallel_for() call (which could re-enter a body suspended below).
+   */
+  bool ownerMayTake(int64_t at, const void* job) const {
+    return !job ||
+           jobs_[at & (kCapacity - 1)].load(std::memory_order_relaxed) ==
+               job ||
+           !chunks_[at & (kCapacity - 1)].load(std::memory_order_relaxed);
+  }
+
+ public:
+  /**
+   * @brief Push a task (owner only).
+   *
+   * @param chunk Whether the task is a parallel_for() chunk.
+   * @return false if the deque is full.
+   */
+  bool push(PoolTask* task, const void* job, bool chunk) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= kCapacity) return false;
+    tasks_[b & (kCapacity - 1)].store(task, std::memory_order_relaxed);
+    jobs_[b & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+    chunks_[b & (kCapacity - 1)].store(chunk, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pop the newest task if the owner may take it (owner only).
+   *
+   * Tasks of other jobs on top are taken too (help-first), so they cannot
+   * hide the waited-for job's tasks below them.
+   *
+   * @param job Job the owner waits for, or null for any.
+   * @return The task, or null.
+   */
+  PoolTask* pop(const void* job) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    if (b < top_.load(std::memory_order_acquire)) return nullptr;
+    if (!ownerMayTake(b, job)) return nullptr;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    PoolTask* task = nullptr;
+    if (t <= b) {
+      task = tasks_[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+      if (t == b) {  // last task: race thieves for it
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+          task = nullptr;
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  /**
+   * @brief Steal the oldest task if it belongs to @p job (any thread).
+   *
+   * A stale snapshot may read a reused slot, but then the CAS on top fails.
+   *
+   * @param job Required job, or null for any.
+   * @return The task, or null if empty, lost a race or of another job.
+   */
+  PoolTask* steal(const void* job) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    if (job && jobs_[t & (kCapacity - 1)].load(std::memory_order_relaxed) !=
+                   job)
+      return nullptr;
+    PoolTask* task =
+        tasks_[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+      return nullptr;
+    return task;
+  }
+
+  /**
+   * @brief Check (racily) whether pop() or steal() could take a task.
+   */
+  bool hasWork(const void* job, bool owner) const {
+    const int64_t t = top_.load(std::memory_order_acquire);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return false;
+    if (owner) return ownerMayTake(b - 1, job);
+    return !job ||
+           jobs_[t & (kCapacity - 1)].load(std::memory_order_relaxed) == job;
+  }
+};
+
+/**
+ * @brief Pool thread and the deque it owns.
+ */
+struct Worker {
+  WorkDeque deque;    /**< Tasks spawned by this worker */
+  std::thread thread; /**< The worker thread */
+};
+
+/**
+ * @brief Deque lent to a thread outside the pool while it runs parallel work.
+ */
+struct ExternalSlot {
+  std::atomic<bool> used{false}; /**< Claimed by a thread */
+  WorkDeque deque;               /**< Tasks spawned by that thread */
+};
+
+/** Deque of the current thread (null outside the pool and parallel work). */
+static thread_local WorkDeque* t_deque = nullptr;
+
+class ThreadPool;
+
+/** Pool of the current thread (null: the default pool). */
+static thread_local ThreadPool* t_pool = nullptr;
+
+/** State of the per-thread xorshift generator choosing steal victims. */
+static thread_local uint32_t t_rng = 0;
+
+/**
+ * @brief Work-stealing scheduler; the default pool serves the whole process.
+ */
+class ThreadPool {
+ private:
+  std::mutex mutex_;  /**< Guards growth, options_ and injected_ */
+  std::unique_ptr<Worker> workers_[kMaxWorkers];  /**< Started workers */
+  std::atomic<size_t> num_workers_{0};            /**< Published workers */
+  ExternalSlot slots_[kExternalSlots];            /**< Lent deques */
+  std::deque<std::pair<PoolTask*, const void*>> injected_; /**< No deque */
+  std::atomic<size_t> num_injected_{0};           /**< injected_.size() */
+  std::atomic<uint32_t> epoch_{0};    /**< Bumped when work or results appear */
+  std::atomic<size_t> sleepers_{0};   /**< Threads waiting on epoch_ */
+  std::atomic<size_t> max_threads_{0}; /**< options_.max_threads */
+  ThreadPoolOptions options_;         /**< Worker affinity */
+#if defined(__linux__)
+  cpu_set_t initial_affinity_;        /**< Affinity of the process at start */
+#endif
+
+  /**
+   * @brief Apply the affinity options to one worker.
+   *
+   * @return false if the system rejected the CPU set.
+   */
+  bool applyAffinity(size_t index) {
+#if defined(__linux__)
+    cpu_set_t set = initial_affinity_;
+    if (options_.pin || !options_.cpus.empty()) {
+      CPU_ZERO(&set);
+      if (options_.pin) {
+        const size_t n = options_.cpus.empty() ? hardware_threads()
+                                               : options_.cpus.size();
+        CPU_SET(options_.cpus.empty() ? index % n
+                                      : options_.cpus[index % n],
+                &set);
+      } else {
+        for (size_t cpu : options_.cpus) CPU_SET(cpu, &set);
+      }
+    }
+    return pthread_setaffinity_np(workers_[index]->thread.native_handle(),
+                                  sizeof(set), &set) == 0;
+#else
+    (void)index;
+    return true;
+#endif
+  }
+
+  /**
+   * @brief Take a task from the current thread's deque, another deque or
+   * the injection queue.
+   *
+   * @param job Job the thread waits for, or null for any.
+   */
+  PoolTask* find(const void* job) {
+    if (t_deque)
+      if (PoolTask* task = t_deque->pop(job)) return task;
+    const size_t workers = num_workers_.load(std::memory_order_acquire);
+    const size_t victims = workers + kExternalSlots;
+    if (t_rng == 0)
+      t_rng = uint32_t(std::hash<std::thread::id>()(
+                  std::this_thread::get_id())) | 1u;
+    t_rng ^= t_rng << 13;
+    t_rng ^= t_rng >> 17;
+    t_rng ^= t_rng << 5;
+    const size_t start = t_rng % victims;
+    for (size_t i = 0; i < victims; ++i) {
+      const size_t v = (start + i) % victims;
+      WorkDeque& deque =
+          v < workers ? workers_[v]->deque : slots_[v - workers].deque;
+      if (&deque == t_deque) continue;
+      if (PoolTask* task = deque.steal(job)) return task;
+    }
+    if (num_injected_.load(std::memory_order_acquire) == 0) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = injected_.begin(); it != injected_.end(); ++it) {
+      if (job && it->second != job) continue;
+      PoolTask* task = it->first;
+      injected_.erase(it);
+      num_injected_.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Check whether find() could currently succeed.
+   */
+  bool hasWork(const void* job) {
+    if (t_deque && t_deque->hasWork(job, true)) return true;
+    const size_t workers = num_workers_.load(std::memory_order_acquire);
+    for (size_t v = 0; v < workers; ++v)
+      if (workers_[v]->deque.hasWork(job, false)) return true;
+    for (ExternalSlot& slot : slots_)
+      if (slot.deque.hasWork(job, false)) return true;
+    return num_injected_.load(std::memory_order_acquire) != 0;
+  }
+
+  /**
+   * @brief Sleep until woken, unless @p ready already holds.
+   */
+  template <typename Ready>
+  void sleepUnless(Ready&& ready) {
+    const uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready()) epoch_.wait(epoch, std::memory_order_seq_cst);
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Main loop of worker @p index.
+   */
+  void workerMain(size_t index) {
+    t_pool = this;
+    t_deque = &workers_[index]->deque;
+    unsigned idle = 0;
+    for (;;) {
+      // Worker i is the (i + 2)-th thread counting the caller.
+      const uint32_t limit_epoch = g_limit_epoch.load();
+      if (index + 2 > limit()) {
+        g_limit_epoch.wait(limit_epoch);
+        continue;
+      }
+      if (PoolTask* task = find(nullptr)) {
+        task->execute(task);
+        idle = 0;
+      } else if (++idle < kSpins) {
+        std::this_thread::yield();
+      } else {
+        sleepUnless([&] {
+          return index + 2 > limit() || hasWork(nullptr);
+        });
+        idle = 0;
+      }
+    }
+  }
+
+ public:
+  ThreadPool() {
+#if defined(__linux__)
+    CPU_ZERO(&initial_affinity_);
+    if (sched_getaffinity(0, sizeof(initial_affinity_), &initial_affinity_))
+      for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        CPU_SET(cpu, &initial_affinity_);
+#endif
+  }
+
+  /**
+   * @brief Start workers until there are at least @p n.
+   */
+  void ensureWorkers(size_t n) {
+    n = std::min(n, kMaxWorkers);
+    if (num_workers_.load(std::memory_order_acquire) >= n) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = num_workers_.load(std::memory_order_relaxed); i < n;
+         ++i) {
+      workers_[i] = std::make_unique<Worker>();
+      workers_[i]->thread = std::thread([this, i] { workerMain(i); });
+      num_workers_.store(i + 1, std::memory_order_release);
+      // A rejected CPU set leaves the worker on the process's CPUs;
+      // configure_thread_pool() reports it.
+      (void)applyAffinity(i);
+    }
+  }
+
+  /**
+   * @brief Get the most threads taking part in this pool's work.
+   */
+  size_t limit() const {
+    const size_t max = max_threads_.load(std::memory_order_relaxed);
+    return max == 0 ? num_threads() : std::min(max, num_threads());
+  }
+
+  /**
+   * @brief Get the number of started workers.
+   */
+  size_t numWorkers() const {
+    return num_workers_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Replace the affinity options and apply them to every worker.
+   */
+  void configure(const ThreadPoolOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    max_threads_.store(options.max_threads, std::memory_order_relaxed);
+    g_limit_epoch.fetch_add(1);
+    g_limit_epoch.notify_all();
+    bool applied = true;
+    for (size_t i = 0; i < num_workers_.load(std::memory_order_relaxed); ++i)
+      applied = applyAffinity(i) && applied;
+    if (!applied)
+      throw std::runtime_error("configure_thread_pool: cannot set affinity");
+  }
+
+  /**
+   * @brief Queue a task from a thread without a deque.
+   */
+  void inject(PoolTask* task, const void* job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      injected_.emplace_back(task, job);
+    }
+    num_injected_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Wake sleeping threads after new work or a completion.
+   */
+  void wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) == 0) return;
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    epoch_.notify_all();
+  }
+
+  /**
+   * @brief Run tasks of @p job, and others the thread spawned on top of
+   * them, until @p done holds.
+   */
+  template <typename Done>
+  void helpUntil(const void* job, Done&& done) {
+    unsigned idle = 0;
+    while (!done()) {
+      if (PoolTask* task = find(job)) {
+        task->execute(task);
+        idle = 0;
+      } else if (++idle < kSpins) {
+        std::this_thread::yield();
+      } else {
+        sleepUnless([&] { return done() || hasWork(job); });
+        idle = 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Lend a deque to the current thread if it has none.
+   *
+   * @return The slot to give back, or null (none needed or none free).
+   */
+  ExternalSlot* claim() {
+    if (t_deque) return nullptr;
+    for (ExternalSlot& slot : slots_) {
+      if (!slot.used.exchange(true, std::memory_order_acquire)) {
+        t_deque = &slot.deque;
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Give back a deque lent by claim().
+   */
+  static void release(ExternalSlot* slot) {
+    if (!slot) return;
+    t_deque = nullptr;
+    slot->used.store(false, std::memory_order_release);
+  }
+};
+
+/**
+ * @brief Get the pool of the current thread.
+ *
+ * Pools are intentionally leaked: workers run until the process exits, and
+ * static destructors may still use parallel_for().
+ */
+static ThreadPool& pool() {
+  if (t_pool) return *t_pool;
+  static ThreadPool* instance = new ThreadPool();
+  return *instance;
+}
+
+/**
+ * @brief Deque lent to the current thread for the lifetime of the guard.
+ */
+class SlotGuard {
+ private:
+  ExternalSlot* slot_; /**< Lent slot, if any */
+
+ public:
+  SlotGuard() : slot_(pool().claim()) {}
+  ~SlotGuard() { ThreadPool::release(slot_); }
+  SlotGuard(const SlotGuard&) = delete;
+  SlotGuard& operator=(const SlotGuard&) = delete;
+};
+
+/**
+ * @brief One parallel_for_range() call.
+ */
+struct RangeJob {
+  ThreadPool* pool;          /**< Pool running the call */
+  ParallelRangeFn fn;        /**< Body */
+  void* context;             /**< Body argument */
+  size_t chunk;              /**< Ranges below twice this are not split */
+  std::mutex error_mutex;    /**< Guards error */
+  std::exception_ptr error;  /**< First exception thrown by the body */
+
+  /**
+   * @brief Run the body on one chunk, recording its exception.
+   */
+  void call(size_t begin, size_t end) {
+    try {
+      fn(context, begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) error = std::current_exception();
+    }
+  }
+};
+
+static void run_range(RangeJob& job, size_t begin, size_t end);
+
+/**
+ * @brief Upper half of a split range, waiting in a deque to be taken.
+ */
+struct RangeTask : PoolTask {
+  RangeJob* job;                   /**< Owning call */
+  size_t begin;                    /**< First index */
+  size_t end;                      /**< One past the last index */
+  std::atomic<bool> done{false};   /**< Set once the range has run */
+
+  RangeTask(RangeJob& j, size_t b, size_t e) : job(&j), begin(b), end(e) {
+    execute = [](PoolTask* base) {
+      auto* task = static_cast<RangeTask*>(base);
+      run_range(*task->job, task->begin, task->end);
+      // The spawner may return (destroying the task) once done is set.
+      ThreadPool* pool = task->job->pool;
+      task->done.store(true, std::memory_order_release);
+      pool->wake();
+    };
+  }
+};
+
+/**
+ * @brief Run [begin, end) of a job, splitting off upper halves as tasks.
+ *
+ * The lower half is processed recursively on this thread; the upper half
+ * is either taken by another thread or popped back and run here.
+ */
+static void run_range(RangeJob& job, size_t begin, size_t end) {
+  if (end - begin < 2 * job.chunk) {
+    job.call(begin, end);
+    return;
+  }
+  const size_t mid = begin + (end - begin) / 2;
+  RangeTask upper(job, mid, end);
+  if (!t_deque || !t_deque->push(&upper, &job, true)) {
+    job.call(begin, end);
+    return;
+  }
+  job.pool->wake();
+  run_range(job, begin, mid);
+  job.pool->helpUntil(&job, [&] {
+    return upper.done.load(std::memory_order_acquire);
+  });
+}
+
+/**
+ * @brief Heap-allocated task of a TaskGroup.
+ */
+struct GroupTask : PoolTask {
+  TaskGroup* group;          /**< Owning group */
+  std::function<void()> fn;  /**< Work */
+
+  GroupTask(TaskGroup* g, std::function<void()> f)
+      : group(g), fn(std::move(f)) {
+    execute = [](PoolTask* base) {
+      std::unique_ptr<GroupTask> task(static_cast<GroupTask*>(base));
+      TaskGroup* owner = task->group;
+      try {
+        task->fn();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(owner->error_mutex_);
+        if (!owner->error_) owner->error_ = std::current_exception();
+      }
+      task.reset();
+      // The group may be destroyed once pending_ drops.
+      ThreadPool* pool = owner->pool_;
+      owner->pending_.fetch_sub(1, std::memory_order_acq_rel);
+      pool->wake();
+    };
+  }
+};
+
+/**
+ * @brief Get the number of hardware threads available to the process.
+ */
+size_t hardware_threads() {
+  static const size_t n =
+      std::max<size_t>(1, std::thread::hardware_concurrency());
+  return n;
+}
+
+/**
+ * @brief Get the process-wide thread limit, ignoring ThreadLimitScope.
+ */
+static size_t process_threads() {
+  const size_t n = g_num_threads.load(std::memory_order_relaxed);
+  return n == 0 ? hardware_threads() : n;
+}
+
+/**
+ * @brief Get the maximum number of threads used by parallel_for().
+ */
+size_t num_threads() {
+  const size_t n = process_threads();
+  return t_thread_cap ? std::min(n, t_thread_cap) : n;
+}
+
+/**
+ * @brief Set the maximum number of threads used by parallel_for().
+ */
+void set_num_threads(size_t n) {
+  if (g_num_threads.exchange(n) == n) return;
+  g_limit_epoch.fetch_add(1);
+  g_limit_epoch.notify_all();
+}
+
+/**
+ * @brief Cap the calling thread at @p n threads.
+ */
+ThreadLimitScope::ThreadLimitScope(size_t n) : previous_(t_thread_cap) {
+  if (n != 0) t_thread_cap = previous_ ? std::min(previous_, n) : n;
+}
+
+/**
+ * @brief Restore the enclosing cap.
+ */
+ThreadLimitScope::~ThreadLimitScope() { t_thread_cap = previous_; }
+
+/**
+ * @brief Check that every CPU of the options fits a CPU set.
+ */
+static void check_cpus(const ThreadPoolOptions& options, const char* caller) {
+#if defined(__linux__)
+  for (size_t cpu : options.cpus)
+    if (cpu >= CPU_SETSIZE)
+      throw std::invalid_argument(std::string(caller) + ": CPU " +
+                                  std::to_string(cpu) + " out of range");
+#else
+  (void)options;
+  (void)caller;
+#endif
+}
+
+/**
+ * @brief Set the CPU affinity and size of the current pool's workers.
+ */
+void configure_thread_pool(const ThreadPoolOptions& options) {
+  check_cpus(options, "configure_thread_pool");
+  pool().configure(options);
+}
+
+/**
+ * @brief Get the number of worker threads started by the current pool.
+ */
+size_t pool_workers() { return pool().numWorkers(); }
+
+/**
+ * @brief Create a pool with its own workers.
+ */
+ThreadPool& create_thread_pool(const ThreadPoolOptions& options) {
+  check_cpus(options, "create_thread_pool");
+  auto* created = new ThreadPool();
+  created->configure(options);
+  return *created;
+}
+
+/**
+ * @brief Route the current thread's parallel work to @p pool.
+ */
+ThreadPoolScope::ThreadPoolScope(ThreadPool& pool)
+    : previous_pool_(t_pool), previous_deque_(t_deque) {
+  // A deque belongs to one pool; a thread entering another pool borrows
+  // one of that pool's deques when it runs parallel work.
+  if (&::pool() != &pool) t_deque = nullptr;
+  t_pool = &pool;
+}
+
+/**
+ * @brief Restore the enclosing pool.
+ */
+ThreadPoolScope::~ThreadPoolScope() {
+  t_pool = previous_pool_;
+  t_deque = static_cast<WorkDeque*>(previous_deque_);
+}
+
+/**
+ * @brief Run a type-erased body over [begin, end) split into chunks.
+ */
+void parallel_for_range(size_t begin, size_t end, size_t grain,
+                        ParallelRangeFn fn, void* context) {
+  if (begin >= end) return;
+  const size_t n = end - begin;
+  grain = std::max<size_t>(grain, 1);
+  ThreadPool& p = pool();
+  const size_t width = p.limit();
+  if (width <= 1 || n < 2 * grain) {
+    fn(context, begin, end);
+    return;
+  }
+  p.ensureWorkers(width - 1);
+  SlotGuard slot;
+  // Idle workers steal whatever chunks there are, so a caller capped
+  // below the pool makes no more chunks than it may use threads.
+  const bool capped = t_thread_cap != 0 && t_thread_cap < process_threads();
+  const size_t chunk =
+      capped ? std::max(grain, (n + width - 1) / width)
+             : std::max(grain, n / (width * kChunksPerThread));
+  RangeJob job{&p, fn, context, chunk, {}, {}};
+  run_range(job, begin, end);
+  if (job.error) std::rethrow_exception(job.error);
+}
+
+/**
+ * @brief Bind the group to the current thread's pool.
+ */
+TaskGroup::TaskGroup() : pool_(&pool()) {}
+
+/**
+ * @brief Wait for pending tasks, discarding their exceptions.
+ */
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+  }
+}
+
+/**
+ * @brief Spawn a task.
+ */
+void TaskGroup::run(std::function<void()> fn) {
+  auto* task = new GroupTask(this, std::move(fn));
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  pool_->ensureWorkers(pool_->limit() - 1);
+  if (&pool() != pool_ || !t_deque || !t_deque->push(task, this, false))
+    pool_->inject(task, this);
+  pool_->wake();
+}
+
+/**
+ * @brief Wait until every spawned task has finished.
+ */
+void TaskGroup::wait() {
+  {
+    ThreadPoolScope scope(*pool_);
+    SlotGuard slot;
+    pool_->helpUntil(this, [&] {
+      return pending_.load(std::memory_order_acquire) == 0;
+    });
+  }
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    std::swap(error, error_);
+  }
+  if (error) std::rethrow_exception(error);
+}
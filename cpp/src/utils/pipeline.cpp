@@ -0,0 +1,22 @@
+#include "utils/pipeline.h"
+
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Format per-stage statistics as one line per stage.
+ */
+std::string format_pipeline_stats(
+    const std::vector<PipelineStageStats>& stats) {
+  std::ostringstream out;
+  out << std::fixed;
+  for (const PipelineStageStats& s : stats) {
+    const double rate = s.wall_seconds > 0. ? s.items / s.wall_seconds : 0.;
+    out << s.name << " x" << s.workers << ": " << s.items << " items, "
+        << std::setprecision(1) << rate << "/s, occupancy "
+        << 100. * s.occupancy() << "%, starved " << std::setprecision(3)
+        << s.starved_seconds << " s, blocked " << s.blocked_seconds
+        << " s\n";
+  }
+  return out.str();
+}
@@ -0,0 +1,113 @@
+#include "utils/protobuf.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+static_assert(std::endian::native == std::endian::little,
+              "fixed-width protobuf fields are read in place");
+
+/**
+ * @brief Decode a varint at @p p, advancing it.
+ */
+static uint64_t read_varint(const uint8_t*& p, const uint8_t* end) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (p == end) throw std::runtime_error("protobuf: truncated varint");
+    const uint8_t b = *p++;
+    v |= uint64_t(b & 0x7f) << shift;
+    if (!(b & 0x80)) return v;
+  }
+  throw std::runtime_error("protobuf: varint too long");
+}
+
+/**
+ * @brief Read @p n little-endian bytes at @p p, advancing it.
+ */
+static uint64_t read_fixed(const uint8_t*& p, const uint8_t* end, size_t n) {
+  if (size_t(end - p) < n) throw std::runtime_error("protobuf: truncated");
+  uint64_t v = 0;
+  std::memcpy(&v, p, n);
+  p += n;
+  return v;
+}
+
+/**
+ * @brief Get a fixed32 payload as a float.
+ */
+float ProtoField::asFloat() const {
+  return std::bit_cast<float>(uint32_t(value));
+}
+
+/**
+ * @brief Get a fixed64 payload as a double.
+ */
+double ProtoField::asDouble() const { return std::bit_cast<double>(value); }
+
+/**
+ * @brief Read the next field.
+ */
+bool ProtoReader::next(ProtoField& field) {
+  if (p_ == end_) return false;
+  const uint64_t key = read_varint(p_, end_);
+  field.number = uint32_t(key >> 3);
+  if (field.number == 0) throw std::runtime_error("protobuf: field number 0");
+  field.bytes = {};
+  switch (key & 7) {
+    case 0:
+      field.wire = ProtoWireType::kVarint;
+      field.value = read_varint(p_, end_);
+      break;
+    case 1:
+      field.wire = ProtoWireType::kFixed64;
+      field.value = read_fixed(p_, end_, 8);
+      break;
+    case 2: {
+      field.wire = ProtoWireType::kBytes;
+      const uint64_t len = read_varint(p_, end_);
+      if (len > uint64_t(end_ - p_))
+        throw std::runtime_error("protobuf: truncated length-delimited field");
+      field.bytes = {p_, size_t(len)};
+      field.value = len;
+      p_ += len;
+      break;
+    }
+    case 5:
+      field.wire = ProtoWireType::kFixed32;
+      field.value = read_fixed(p_, end_, 4);
+      break;
+    default:
+      throw std::runtime_error("protobuf: unsupported wire type");
+  }
+  return true;
+}
+
+/**
+ * @brief Append the values of a repeated varint field.
+ */
+void proto_append_varints(const ProtoField& field, std::vector<int64_t>& out) {
+  if (field.wire == ProtoWireType::kVarint) {
+    out.push_back(field.asInt64());
+    return;
+  }
+  if (field.wire != ProtoWireType::kBytes)
+    throw std::runtime_error("protobuf: expected a varint field");
+  const uint8_t* p = field.bytes.data();
+  const uint8_t* end = p + field.bytes.size();
+  while (p != end) out.push_back(int64_t(read_varint(p, end)));
+}
+
+/**
+ * @brief Append the values of a repeated float field (packed or unpacked).
+ */
+void proto_append_floats(const ProtoField& field, std::vector<float>& out) {
+  if (field.wire == ProtoWireType::kFixed32) {
+    out.push_back(field.asFloat());
+    return;
+  }
+  if (field.wire != ProtoWireType::kBytes || field.bytes.size() % 4 != 0)
+    throw std::runtime_error("protobuf: expected a float field");
+  const size_t n = field.bytes.size() / 4;
+  out.resize(out.size() + n);
+  std::memcpy(out.data() + out.size() - n, field.bytes.data(), n * 4);
+}
@@ -0,0 +1,74 @@
+#include "utils/wait.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#endif
+
+#include <thread>
+
+/**
+ * @brief Sleep while a word holds an expected value.
+ */
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected,
+                bool shared) {
+#if defined(__linux__)
+  // std::atomic<uint32_t> is a plain 32-bit word on Linux targets.
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+          shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, nullptr,
+          nullptr, 0);
+#else
+  (void)shared;
+  word.wait(expected, std::memory_order_acquire);
+#endif
+}
+
+/**
+ * @brief Like futex_wait(), giving up after @p timeout.
+ */
+bool futex_wait_for(std::atomic<uint32_t>& word, uint32_t expected,
+                    std::chrono::nanoseconds timeout, bool shared) {
+#if defined(__linux__)
+  const auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  timespec relative{};
+  relative.tv_sec = time_t(seconds.count());
+  relative.tv_nsec = long((timeout - seconds).count());
+  const long result =
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+              shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, &relative,
+              nullptr, 0);
+  return !(result != 0 && errno == ETIMEDOUT);
+#else
+  (void)shared;
+  // No timed std::atomic wait: poll with short sleeps.
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (word.load(std::memory_order_acquire) == expected) {
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+  return true;
+#endif
+}
+
+/**
+ * @brief Wake threads sleeping in futex_wait() on @p word.
+ */
+void futex_wake(std::atomic<uint32_t>& word, bool all, bool shared) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+          shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1,
+          nullptr, nullptr, 0);
+#else
+  (void)shared;
+  if (all)
+    word.notify_all();
+  else
+    word.notify_one();
+#endif
+}
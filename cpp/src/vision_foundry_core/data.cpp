@@ -1,5 +1,7 @@
 #include "data/data.hpp"
 
+#include <memory_resource>
+
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -17,6 +19,15 @@ class PyDataset : public Dataset<SampleType> {
     );
   }
 
+  SampleType getItemScratch(
+      size_t index, std::pmr::memory_resource* scratch) const override {
+    PYBIND11_OVERRIDE(SampleType,           // Return type
+                      Dataset<SampleType>,  // Parent class
+                      getItemScratch,       // Name of function in C++
+                      index, scratch        // Argument(s)
+    );
+  }
+
   size_t size() const override {
     PYBIND11_OVERRIDE_PURE(size_t,               // Return type
                            Dataset<SampleType>,  // Parent class
@@ -26,8 +37,15 @@ class PyDataset : public Dataset<SampleType> {
 };
 
 PYBIND11_MODULE(data, m) {
+  // Opaque handle: Python overrides of getItemScratch receive the loader's
+  // arena but can only pass it on.
+  pybind11::class_<std::pmr::memory_resource,
+                   std::unique_ptr<std::pmr::memory_resource,
+                                   pybind11::nodelete>>(m, "MemoryResource");
+
   pybind11::class_<Dataset<float>, PyDataset<float>>(m, "DatasetFloat")
       .def(pybind11::init<>())
       .def("getItem", &Dataset<float>::getItem)
+      .def("getItemScratch", &Dataset<float>::getItemScratch)
       .def("size", &Dataset<float>::size);
 }
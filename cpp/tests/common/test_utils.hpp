@@ -0,0 +1,14 @@
+#pragma once
+#include <random>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @brief Fill a tensor with uniform random values in [-1, 1].
+ */
+inline Tensor<float> random_tensor(const Shape& shape, std::mt19937& rng) {
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  Tensor<float> t(shape);
+  for (size_t i = 0; i < t.numel(); ++i) t[i] = dist(rng);
+  return t;
+}
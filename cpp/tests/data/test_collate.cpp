@@ -0,0 +1,119 @@
+/**
+ * @file test_collate.cpp
+ * @brief Unit tests for batch collation and the decoded-sample cache.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "data/collate.hpp"
+#include "data/data.hpp"
+#include "data/sample_cache.hpp"
+#include "utils/numa.h"
+
+/**
+ * @brief Dataset of [2, 3] float images that counts its decodes.
+ */
+class ImageDataset : public Dataset<Tensor<float>> {
+ public:
+  mutable std::atomic<size_t> decodes{0}; /**< getItem() calls */
+
+  Tensor<float> getItem(size_t index) const override {
+    ++decodes;
+    Tensor<float> t(Shape{2, 3});
+    for (size_t i = 0; i < t.numel(); ++i) t[i] = float(index) + 0.5f * i;
+    return t;
+  }
+  size_t size() const override { return 5; }
+};
+
+/**
+ * @test
+ * @brief Verifies samples are stacked and converted.
+ */
+TEST(CollateTest, StacksAndConverts) {
+  ImageDataset dataset;
+  const std::vector<Tensor<float>> samples = {dataset.getItem(0),
+                                              dataset.getItem(3)};
+  const Tensor<float> batch = collate<float>(samples);
+  EXPECT_EQ(batch.shape(), (Shape{2, 2, 3}));
+  EXPECT_EQ(batch(1, 1, 2), 5.5f);
+  const Tensor<Half> half = collate<Half>(samples);
+  EXPECT_EQ(half.shape(), batch.shape());
+  for (size_t i = 0; i < batch.numel(); ++i)
+    EXPECT_EQ(float(half[i]), batch[i]);
+
+  std::vector<Tensor<Half>> half_samples = {tensor_cast<Half>(samples[1])};
+  EXPECT_EQ(collate<float>(half_samples)(0, 0, 1), 3.5f);
+
+  Tensor<float> local =
+      collate<float>(samples, int(numa_nodes().front().id));
+  ASSERT_EQ(local.shape(), batch.shape());
+  for (size_t i = 0; i < batch.numel(); ++i) EXPECT_EQ(local[i], batch[i]);
+  const float* local_data = local.data();
+  local = Tensor<float>();
+  // A released node-local batch is reused by the next one.
+  const Tensor<float> again =
+      collate<float>(samples, int(numa_nodes().front().id));
+  EXPECT_EQ(again.data(), local_data);
+  EXPECT_EQ(again(1, 1, 2), 5.5f);
+  EXPECT_THROW(collate<float>(samples, 1 << 20), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies invalid batches are rejected.
+ */
+TEST(CollateTest, RejectsInvalidBatches) {
+  EXPECT_THROW(collate<float>(std::vector<Tensor<float>>{}),
+               std::invalid_argument);
+  const std::vector<Tensor<float>> mixed = {Tensor<float>(Shape{2}),
+                                            Tensor<float>(Shape{3})};
+  EXPECT_THROW(collate<float>(mixed), std::invalid_argument);
+  const std::vector<Tensor<float>> deep = {
+      Tensor<float>(Shape{1, 1, 1, 1, 1, 1})};
+  EXPECT_THROW(collate<float>(deep), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies the cache decodes each sample once and feeds a loader.
+ */
+TEST(SampleCacheTest, DecodesOnce) {
+  ImageDataset dataset;
+  CachedDataset<Half, ImageDataset> cache(dataset);
+  ASSERT_EQ(cache.size(), 5u);
+  DataLoader<CachedDataset<Half, ImageDataset>> loader(cache, 2);
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    loader.reset();
+    while (loader.hasNext()) {
+      const Tensor<float> batch = collate<float>(loader.nextBatch());
+      EXPECT_EQ(batch.shape()[1], 2u);
+    }
+  }
+  EXPECT_EQ(dataset.decodes, 5u);
+  EXPECT_EQ(cache.misses(), 5u);
+  EXPECT_EQ(cache.hits(), 10u);
+  EXPECT_EQ(cache.bytes(), 5u * 6u * sizeof(Half));
+  EXPECT_EQ(float(cache.getItem(4)(1, 2)), 6.5f);
+  EXPECT_EQ(cache.getItem(2).data(), cache.getItem(2).data());
+  EXPECT_THROW(cache.getItem(5), std::out_of_range);
+}
+
+/**
+ * @test
+ * @brief Verifies samples beyond the byte budget are decoded every time.
+ */
+TEST(SampleCacheTest, RespectsBudget) {
+  ImageDataset dataset;
+  CachedDataset<BFloat16, ImageDataset> cache(dataset, 2 * 6 * 2);
+  for (int pass = 0; pass < 2; ++pass)
+    for (size_t i = 0; i < cache.size(); ++i)
+      EXPECT_EQ(float(cache.getItem(i)(0, 1)), float(i) + 0.5f);
+  EXPECT_EQ(cache.bytes(), 24u);
+  EXPECT_EQ(cache.hits(), 2u);
+  EXPECT_EQ(cache.misses(), 8u);
+  EXPECT_EQ(dataset.decodes, 8u);
+}
@@ -8,7 +8,10 @@
 
 #include <gtest/gtest.h>
 
+#include <memory_resource>
+
 #include "data/data.hpp"
+#include "tensor/tensor.hpp"
 
 /**
  * @class IntDataset
@@ -131,3 +134,100 @@ TEST(DataLoaderTest, ResetAndShuffleDeterministicCheck) {
   std::sort(epoch2.begin(), epoch2.end());
   for (size_t i = 0; i < d.size(); ++i) EXPECT_EQ(epoch1[i], epoch2[i]);
 }
+
+/**
+ * @brief Dataset whose samples and decode buffers live in the loader's
+ * per-batch arena.
+ */
+class ScratchDataset : public Dataset<std::pmr::vector<int>> {
+ public:
+  std::pmr::vector<int> getItem(size_t index) const override {
+    return getItemScratch(index, std::pmr::get_default_resource());
+  }
+
+  std::pmr::vector<int> getItemScratch(
+      size_t index, std::pmr::memory_resource* scratch) const override {
+    std::pmr::vector<int> decoded(64, int(index), scratch);  // transient
+    return std::pmr::vector<int>(decoded.begin(), decoded.begin() + 3,
+                                 scratch);
+  }
+
+  size_t size() const override { return 6; }
+};
+
+/**
+ * @test DataLoaderTest.LoadsThroughScratchArena
+ * @brief Tests that samples are built in the loader's arenas, that an
+ * arena is rewound when reused without growing, and that plain datasets
+ * still load through the default overload.
+ */
+TEST(DataLoaderTest, LoadsThroughScratchArena) {
+  ScratchDataset d;
+  DataLoader<ScratchDataset> loader(d, 2, false);
+  auto b1 = loader.nextBatch();
+  ASSERT_EQ(b1.size(), 2u);
+  EXPECT_EQ(b1[1][2], 1);
+  const MonotonicArena* first = &loader.arena();
+  EXPECT_EQ(b1[0].get_allocator().resource(), first);
+  const size_t used = first->used();
+  const size_t capacity = first->capacity();
+  EXPECT_GE(used, 2 * (64 + 3) * sizeof(int));
+
+  auto b2 = loader.nextBatch();
+  EXPECT_EQ(b2[0][0], 2);
+  EXPECT_NE(&loader.arena(), first);
+  b1 = loader.nextBatch();  // reuses the first arena
+  EXPECT_EQ(b1[0][0], 4);
+  EXPECT_EQ(&loader.arena(), first);
+  EXPECT_EQ(first->used(), used);
+  EXPECT_EQ(first->capacity(), capacity);
+
+  IntDataset plain({5, 6, 7});
+  DataLoader<IntDataset> plain_loader(plain, 3, false);
+  EXPECT_EQ(plain_loader.nextBatch()[2], 7);
+  EXPECT_EQ(plain_loader.arena().capacity(), 0u);
+}
+
+
+/**
+ * @class ArenaTensorDataset
+ * @brief Dataset whose samples are tensors allocated in the scratch arena.
+ */
+class ArenaTensorDataset : public Dataset<Tensor<float>> {
+ public:
+  Tensor<float> getItem(size_t index) const override {
+    return getItemScratch(index, std::pmr::get_default_resource());
+  }
+
+  Tensor<float> getItemScratch(
+      size_t index, std::pmr::memory_resource* scratch) const override {
+    Tensor<float> t(Shape{16}, scratch);
+    t.fill(float(index));
+    return t;
+  }
+
+  size_t size() const override { return 8; }
+};
+
+/**
+ * @test DataLoaderTest.HeldBatchSurvivesNextBatch
+ * @brief Tests that a batch held while the next one is loaded keeps its
+ * data and reference counts, and can be copied and released afterwards.
+ */
+TEST(DataLoaderTest, HeldBatchSurvivesNextBatch) {
+  ArenaTensorDataset d;
+  DataLoader<ArenaTensorDataset> loader(d, 2, false);
+  std::vector<Tensor<float>> batch = loader.nextBatch();
+  for (int i = 1; i < 4; ++i) {
+    std::vector<Tensor<float>> previous = batch;
+    batch = loader.nextBatch();
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_EQ(batch[j].storage().use_count(), 1);
+      EXPECT_EQ(previous[j].storage().use_count(), 1);
+      EXPECT_EQ(previous[j][15], float(2 * (i - 1) + int(j)));
+      EXPECT_EQ(batch[j][0], float(2 * i + int(j)));
+    }
+    Tensor<float> copy = batch[1];
+    EXPECT_EQ(batch[1].storage().use_count(), 2);
+  }
+}
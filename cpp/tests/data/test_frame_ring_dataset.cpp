@@ -0,0 +1,73 @@
+/**
+ * @file test_frame_ring_dataset.cpp
+ * @brief Unit tests for FrameRingDataset fed by a local test producer.
+ */
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data/collate.hpp"
+#include "data/data.hpp"
+#include "data/frame_ring_dataset.hpp"
+#include "utils/frame_ring.h"
+
+/**
+ * @test FrameRingDatasetTest.LoadsRenderedFramesInBatches
+ * @brief Tests that a DataLoader over a ring gets every frame in order,
+ * zero-copy, while a producer thread renders them, and that batches
+ * collate into float tensors.
+ */
+TEST(FrameRingDatasetTest, LoadsRenderedFramesInBatches) {
+  const std::string name = "/vf_test_dataset_" + std::to_string(::getpid());
+  // More slots than frames: the test must not depend on the loader
+  // keeping up with the renderer.
+  FrameRingWriter writer(name, 16, 6 * 4 * 3);
+  FrameRingReader reader(name);
+  FrameRingDataset<uint8_t> dataset(reader, 10);
+  EXPECT_EQ(dataset.size(), 10u);
+  EXPECT_THROW(dataset.getItem(10), std::out_of_range);
+
+  FrameInfo info;
+  info.width = 6;
+  info.height = 4;
+  info.channels = 3;
+  std::thread renderer([&] {
+    for (size_t i = 0; i < 10; ++i) {
+      const std::vector<uint8_t> frame(info.bytes(), uint8_t(10 * i));
+      writer.write(info, frame.data());
+      std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+  });
+
+  DataLoader<FrameRingDataset<uint8_t>> loader(dataset, 3, false);
+  size_t seen = 0;
+  while (loader.hasNext()) {
+    std::vector<Tensor<uint8_t>> batch = loader.nextBatch();
+    for (const Tensor<uint8_t>& frame : batch) {
+      EXPECT_EQ(frame.shape(), (Shape{4, 6, 3}));
+      EXPECT_EQ(frame(3, 5, 2), uint8_t(10 * seen));
+      ++seen;
+    }
+    const Tensor<float> images = collate<float>(batch);
+    EXPECT_EQ(images.dim(0), batch.size());
+    EXPECT_EQ(images(0, 0, 0, 0), float(batch[0](0, 0, 0)));
+  }
+  renderer.join();
+  EXPECT_EQ(seen, 10u);
+
+  const std::vector<uint8_t> blank(info.bytes());
+  for (size_t i = 0; i < 16; ++i) writer.write(info, blank.data());
+  FrameRingDataset<uint8_t> late(reader, 1, 0);
+  EXPECT_THROW(late.getItem(0), std::runtime_error);  // overwritten
+  FrameRingDataset<uint8_t> future(reader, 1, std::nullopt,
+                                   std::chrono::milliseconds(5));
+  EXPECT_THROW(future.getItem(0), std::runtime_error);  // never rendered
+}
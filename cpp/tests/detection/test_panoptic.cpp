@@ -0,0 +1,124 @@
+/**
+ * @file test_panoptic.cpp
+ * @brief Unit tests for merging instance and semantic outputs.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "detection/panoptic.h"
+
+/**
+ * @brief Encode an axis-aligned rectangle [x0, x1) x [y0, y1) as an RLE.
+ */
+static Rle rect_mask(size_t h, size_t w, size_t x0, size_t y0, size_t x1,
+                     size_t y1) {
+  std::vector<uint8_t> m(h * w, 0);
+  for (size_t y = y0; y < y1; ++y)
+    for (size_t x = x0; x < x1; ++x) m[y * w + x] = 1;
+  return rle_encode(m.data(), h, w);
+}
+
+/**
+ * @brief Find the segment with the given id.
+ */
+static const PanopticSegment* find_segment(const PanopticResult& r,
+                                           uint32_t id) {
+  for (const auto& s : r.segments)
+    if (s.id == id) return &s;
+  return nullptr;
+}
+
+/**
+ * @test
+ * @brief Verifies that overlaps go to the higher scoring instance and that
+ * stuff fills the remaining pixels.
+ */
+TEST(PanopticTest, ResolvesOverlapsByScoreAndFillsStuff) {
+  const size_t h = 10, w = 12;
+  // Semantic map: class 1 (runway) on the top half, class 2 (apron) below.
+  Tensor<int32_t> semantic(Shape{h, w});
+  for (size_t y = 0; y < h; ++y)
+    for (size_t x = 0; x < w; ++x) semantic(y, x) = y < 5 ? 1 : 2;
+
+  BoxSet inst;
+  inst.push_back(0, 0, 0, 0, .6f, 7);  // lower score, overlaps the next one
+  inst.push_back(0, 0, 0, 0, .9f, 7);
+  std::vector<Rle> masks{rect_mask(h, w, 2, 2, 6, 6),
+                         rect_mask(h, w, 4, 2, 8, 6)};
+
+  PanopticParams p;
+  p.stuff_area_threshold = 1;
+  auto r = panoptic_merge(masks, inst, semantic, {false, true, true}, p);
+
+  // Best instance gets id 7001 and its full area.
+  EXPECT_EQ(r.ids(3, 5), 7001u);
+  EXPECT_EQ(r.ids(3, 7), 7001u);
+  // Second instance keeps only the unclaimed part (50% overlap allowed).
+  EXPECT_EQ(r.ids(3, 2), 7002u);
+  ASSERT_NE(find_segment(r, 7002), nullptr);
+  EXPECT_EQ(find_segment(r, 7002)->area, 8u);
+  EXPECT_EQ(find_segment(r, 7002)->instance, 0);
+  // Stuff classes fill everything else.
+  EXPECT_EQ(r.ids(0, 0), 1000u);
+  EXPECT_EQ(r.ids(9, 11), 2000u);
+  ASSERT_NE(find_segment(r, 2000), nullptr);
+  EXPECT_EQ(find_segment(r, 2000)->area, 5u * w - 4u * 1u - 2u * 1u);
+}
+
+/**
+ * @test
+ * @brief Verifies that instances mostly covered by better ones and instances
+ * below the score threshold are dropped.
+ */
+TEST(PanopticTest, DropsOccludedAndLowScoreInstances) {
+  const size_t h = 8, w = 8;
+  Tensor<int32_t> semantic(Shape{h, w});
+  BoxSet inst;
+  inst.push_back(0, 0, 0, 0, .9f, 3);
+  inst.push_back(0, 0, 0, 0, .8f, 3);  // 75% covered by the first
+  inst.push_back(0, 0, 0, 0, .1f, 3);  // below the score threshold
+  std::vector<Rle> masks{rect_mask(h, w, 0, 0, 4, 4),
+                         rect_mask(h, w, 1, 0, 5, 4),
+                         rect_mask(h, w, 6, 6, 8, 8)};
+
+  auto r = panoptic_merge(masks, inst, semantic, {false});
+  ASSERT_EQ(r.segments.size(), 1u);
+  EXPECT_EQ(r.segments[0].id, 3001u);
+  EXPECT_EQ(r.ids(0, 4), 0u);
+  EXPECT_EQ(r.ids(7, 7), 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies that small stuff regions are returned to void.
+ */
+TEST(PanopticTest, RemovesSmallStuffSegments) {
+  const size_t h = 6, w = 6;
+  Tensor<int32_t> semantic(Shape{h, w});
+  semantic.fill(1);
+  semantic(0, 0) = 2;  // single-pixel hangar region
+
+  PanopticParams p;
+  p.stuff_area_threshold = 2;
+  p.void_id = 99;
+  auto r = panoptic_merge({}, BoxSet{}, semantic, {false, true, true}, p);
+  EXPECT_EQ(r.ids(0, 0), 99u);
+  EXPECT_EQ(r.ids(5, 5), 1000u);
+  ASSERT_EQ(r.segments.size(), 1u);
+  EXPECT_EQ(r.segments[0].area, h * w - 1);
+}
+
+/**
+ * @test
+ * @brief Verifies that masks of the wrong size are rejected.
+ */
+TEST(PanopticTest, RejectsMismatchedMaskSize) {
+  Tensor<int32_t> semantic(Shape{4, 4});
+  BoxSet inst;
+  inst.push_back(0, 0, 0, 0, 1.f, 1);
+  std::vector<Rle> masks{rect_mask(5, 4, 0, 0, 1, 1)};
+  EXPECT_THROW(panoptic_merge(masks, inst, semantic, {}),
+               std::invalid_argument);
+}
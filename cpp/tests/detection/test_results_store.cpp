@@ -0,0 +1,277 @@
+/**
+ * @file test_results_store.cpp
+ * @brief Unit tests for the columnar detection results store.
+ *
+ * Stores are written to the temporary directory, read back through the
+ * memory-mapped reader and filtered scans are compared with a linear filter
+ * over the original detections.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "detection/results_store.h"
+
+/**
+ * @brief Temporary store path removed when the test ends.
+ */
+struct TempStore {
+  std::string path;
+  explicit TempStore(const std::string& name)
+      : path((std::filesystem::temp_directory_path() / name).string()) {
+    std::filesystem::remove(path);
+  }
+  ~TempStore() { std::filesystem::remove(path); }
+};
+
+/**
+ * @brief Detections of one synthetic frame.
+ *
+ * Objects drift to the right as frames advance so blocks cover distinct
+ * frame and x ranges.
+ */
+static BoxSet frame_boxes(int64_t frame, std::mt19937& rng) {
+  std::uniform_real_distribution<float> jitter(0.f, 50.f), score(0.f, 1.f);
+  std::uniform_int_distribution<int32_t> label(0, 4);
+  BoxSet boxes;
+  for (int i = 0; i < 3; ++i) {
+    const float x = float(frame) * 10.f + jitter(rng), y = jitter(rng);
+    boxes.push_back(x, y, x + 20.f, y + 20.f, score(rng), label(rng));
+  }
+  return boxes;
+}
+
+/**
+ * @test
+ * @brief Verifies that every detection round-trips through the store.
+ */
+TEST(ResultsStoreTest, RoundTrip) {
+  TempStore tmp("vf_results_roundtrip.vfr");
+  std::mt19937 rng(1);
+  std::vector<BoxSet> frames;
+  {
+    ResultsStoreWriter writer(tmp.path, {"person", "car"}, false, 16);
+    for (int64_t f = 0; f < 100; ++f) {
+      frames.push_back(frame_boxes(f, rng));
+      writer.append(f, frames.back());
+    }
+  }
+  const ResultsStoreReader reader(tmp.path);
+  ASSERT_EQ(reader.size(), 300u);
+  EXPECT_EQ(reader.blocks().size(), 19u);  // 18 full blocks + 12 rows
+
+  const ResultsRows rows = reader.scan();
+  ASSERT_EQ(rows.frame_ids.size(), 300u);
+  for (size_t r = 0; r < 300; ++r) {
+    const BoxSet& src = frames[r / 3];
+    const size_t i = r % 3;
+    EXPECT_EQ(rows.frame_ids[r], int64_t(r / 3));
+    EXPECT_EQ(rows.boxes.x1[r], src.x1[i]);
+    EXPECT_EQ(rows.boxes.y2[r], src.y2[i]);
+    EXPECT_EQ(rows.boxes.scores[r], src.scores[i]);
+    EXPECT_EQ(rows.boxes.labels[r], src.labels[i]);
+  }
+  const std::vector<std::string> names{"person", "car", "", "", ""};
+  EXPECT_EQ(reader.classes().size(), 5u);
+  for (const ResultsClass& c : reader.classes())
+    EXPECT_EQ(c.name, names[size_t(c.label)]);
+}
+
+/**
+ * @test
+ * @brief Verifies filtered scans against a linear filter and block skipping.
+ */
+TEST(ResultsStoreTest, FilteredScanSkipsBlocks) {
+  TempStore tmp("vf_results_filter.vfr");
+  std::mt19937 rng(2);
+  std::vector<BoxSet> frames;
+  {
+    ResultsStoreWriter writer(tmp.path, {}, false, 30);
+    for (int64_t f = 0; f < 200; ++f) {
+      frames.push_back(frame_boxes(f * 3, rng));  // non-unit frame deltas
+      writer.append(f * 3, frames.back());
+    }
+  }
+  const ResultsStoreReader reader(tmp.path);
+
+  ResultsQuery q;
+  q.frame_min = 150;
+  q.frame_max = 299;
+  q.min_score = .3f;
+  q.labels = {1, 3};
+  q.window = SpatialWindow{1000.f, 0.f, 2500.f, 30.f};
+  ResultsScanStats stats;
+  const ResultsRows rows = reader.scan(q, &stats);
+
+  size_t expected = 0;
+  for (int64_t f = 0; f < 200; ++f) {
+    const int64_t id = f * 3;
+    const BoxSet& b = frames[size_t(f)];
+    for (size_t i = 0; i < b.size(); ++i)
+      expected += id >= q.frame_min && id <= q.frame_max &&
+                  b.scores[i] >= q.min_score &&
+                  (b.labels[i] == 1 || b.labels[i] == 3) &&
+                  b.x1[i] <= 2500.f && b.x2[i] >= 1000.f && b.y1[i] <= 30.f;
+  }
+  EXPECT_EQ(rows.frame_ids.size(), expected);
+  EXPECT_GT(expected, 0u);
+  for (size_t r = 0; r < rows.frame_ids.size(); ++r) {
+    EXPECT_GE(rows.frame_ids[r], 150);
+    EXPECT_LE(rows.frame_ids[r], 299);
+    EXPECT_GE(rows.boxes.scores[r], .3f);
+  }
+  EXPECT_EQ(stats.blocks_total, 20u);
+  EXPECT_GE(stats.blocks_skipped, 15u);
+  EXPECT_LE(stats.rows_scanned, 5u * 30u);
+}
+
+/**
+ * @test
+ * @brief Verifies nearest-neighbour queries against a brute-force search
+ * and that blocks far from the point are not decoded.
+ */
+TEST(ResultsStoreTest, NearestVisitsCloseBlocks) {
+  TempStore tmp("vf_results_nearest.vfr");
+  std::mt19937 rng(3);
+  BoxSet all;
+  {
+    ResultsStoreWriter writer(tmp.path, {}, false, 30);
+    for (int64_t f = 0; f < 200; ++f) {
+      const BoxSet boxes = frame_boxes(f, rng);
+      for (size_t i = 0; i < boxes.size(); ++i)
+        all.push_back(boxes.x1[i], boxes.y1[i], boxes.x2[i], boxes.y2[i],
+                      boxes.scores[i], boxes.labels[i]);
+      writer.append(f, boxes);
+    }
+  }
+  const ResultsStoreReader reader(tmp.path);
+  const float px = 1005.f, py = 25.f;
+  const auto distance = [&](const BoxSet& b, size_t i) {
+    const float dx = std::max({b.x1[i] - px, 0.f, px - b.x2[i]});
+    const float dy = std::max({b.y1[i] - py, 0.f, py - b.y2[i]});
+    return dx * dx + dy * dy;
+  };
+
+  ResultsQuery q;
+  q.labels = {0, 2};
+  ResultsScanStats stats;
+  const ResultsRows rows = reader.nearest(px, py, 10, q, &stats);
+  std::vector<float> expected;
+  for (size_t i = 0; i < all.size(); ++i)
+    if (all.labels[i] == 0 || all.labels[i] == 2)
+      expected.push_back(distance(all, i));
+  std::sort(expected.begin(), expected.end());
+  expected.resize(10);
+  ASSERT_EQ(rows.boxes.size(), 10u);
+  for (size_t r = 0; r < 10; ++r) {
+    EXPECT_FLOAT_EQ(distance(rows.boxes, r), expected[r]);
+    EXPECT_TRUE(rows.boxes.labels[r] == 0 || rows.boxes.labels[r] == 2);
+  }
+  EXPECT_EQ(stats.blocks_total, 20u);
+  EXPECT_GE(stats.blocks_skipped, 15u);
+
+  EXPECT_TRUE(reader.nearest(px, py, 0).frame_ids.empty());
+  EXPECT_EQ(reader.nearest(px, py, 1000).frame_ids.size(), 600u);
+}
+
+/**
+ * @test
+ * @brief Verifies that reopening a store appends blocks and keeps classes.
+ */
+TEST(ResultsStoreTest, AppendAcrossRuns) {
+  TempStore tmp("vf_results_append.vfr");
+  BoxSet a, b;
+  a.push_back(0.f, 0.f, 1.f, 1.f, .9f, 7);
+  b.push_back(2.f, 2.f, 3.f, 3.f, .8f, 7);
+  b.push_back(4.f, 4.f, 5.f, 5.f, .7f, 2);
+  {
+    ResultsStoreWriter writer(tmp.path, {}, false, 8);
+    writer.append(-5, a);
+  }
+  {
+    ResultsStoreWriter writer(tmp.path, {}, true, 1);
+    writer.append(10, b);
+  }
+  const ResultsStoreReader reader(tmp.path);
+  EXPECT_EQ(reader.rowsPerBlock(), 8u);
+  ASSERT_EQ(reader.size(), 3u);
+  EXPECT_EQ(reader.classes().size(), 2u);
+  const ResultsRows rows = reader.scan();
+  EXPECT_EQ(rows.frame_ids, (std::vector<int64_t>{-5, 10, 10}));
+  EXPECT_EQ(rows.boxes.labels, (std::vector<int32_t>{7, 7, 2}));
+
+  ResultsQuery q;
+  q.labels = {2};
+  ResultsScanStats stats;
+  EXPECT_EQ(reader.scan(q, &stats).boxes.size(), 1u);
+  EXPECT_EQ(stats.blocks_skipped, 1u);
+}
+
+/**
+ * @test
+ * @brief Verifies that a store whose writer died keeps every flushed row,
+ * ignores a torn tail and can be reopened for appending.
+ */
+TEST(ResultsStoreTest, SurvivesWriterCrash) {
+  TempStore tmp("vf_results_crash.vfr");
+  TempStore crashed("vf_results_crashed.vfr");
+  std::mt19937 rng(4);
+  {
+    ResultsStoreWriter writer(tmp.path, {}, false, 4);
+    for (int64_t f = 0; f < 5; ++f) writer.append(f, frame_boxes(f, rng));
+    writer.flush();
+    for (int64_t f = 5; f < 10; ++f) writer.append(f, frame_boxes(f, rng));
+    writer.flush();
+    // Full blocks written after the last flush() are not indexed yet.
+    for (int64_t f = 10; f < 20; ++f) writer.append(f, frame_boxes(f, rng));
+    std::filesystem::copy_file(tmp.path, crashed.path);
+  }
+  const ResultsStoreReader complete(tmp.path);
+  EXPECT_EQ(complete.size(), 60u);
+
+  const uint64_t end = ResultsStoreReader(crashed.path).dataEnd();
+  {
+    const ResultsStoreReader reader(crashed.path);
+    EXPECT_EQ(reader.size(), 30u);
+    const ResultsRows rows = reader.scan();
+    EXPECT_EQ(rows.frame_ids.front(), 0);
+    EXPECT_EQ(rows.frame_ids.back(), 9);
+  }
+  // A footer torn halfway falls back to the previous one.
+  {
+    std::ofstream out(crashed.path, std::ios::binary | std::ios::app);
+    const std::vector<char> torn(100, '\x01');
+    out.write(torn.data(), std::streamsize(torn.size()));
+  }
+  EXPECT_EQ(ResultsStoreReader(crashed.path).size(), 30u);
+  EXPECT_EQ(ResultsStoreReader(crashed.path).dataEnd(), end);
+
+  {
+    ResultsStoreWriter writer(crashed.path, {}, true);
+    writer.append(42, frame_boxes(42, rng));
+  }
+  EXPECT_GT(std::filesystem::file_size(crashed.path), end);
+  const ResultsStoreReader reader(crashed.path);
+  ASSERT_EQ(reader.size(), 33u);
+  EXPECT_EQ(reader.scan().frame_ids.back(), 42);
+}
+
+/**
+ * @test
+ * @brief Verifies that malformed files are rejected.
+ */
+TEST(ResultsStoreTest, RejectsInvalidFiles) {
+  TempStore tmp("vf_results_invalid.vfr");
+  {
+    std::ofstream out(tmp.path, std::ios::binary);
+    out << "definitely not a results store";
+  }
+  EXPECT_THROW(ResultsStoreReader{tmp.path}, std::runtime_error);
+  EXPECT_THROW(ResultsStoreReader{tmp.path + ".missing"}, std::system_error);
+  EXPECT_THROW(ResultsStoreWriter(tmp.path, {}, false, 0),
+               std::invalid_argument);
+}
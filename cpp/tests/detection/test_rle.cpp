@@ -0,0 +1,63 @@
+/**
+ * @file test_rle.cpp
+ * @brief Unit tests for run-length encoded masks.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "detection/rle.h"
+
+/**
+ * @test
+ * @brief Verifies the COCO column-major run layout on a small mask.
+ */
+TEST(RleTest, EncodesColumnMajorStartingWithZeros) {
+  // 2x3 mask, row-major:
+  //   1 0 1
+  //   1 0 0
+  const std::vector<uint8_t> mask{1, 0, 1, 1, 0, 0};
+  Rle rle = rle_encode(mask.data(), 2, 3);
+  EXPECT_EQ(rle.height, 2u);
+  EXPECT_EQ(rle.width, 3u);
+  EXPECT_EQ(rle.counts, (std::vector<uint32_t>{0, 2, 2, 1, 1}));
+  EXPECT_EQ(rle_area(rle), 3u);
+}
+
+/**
+ * @test
+ * @brief Verifies that decoding an encoded random mask round-trips.
+ */
+TEST(RleTest, RoundTripsRandomMask) {
+  std::mt19937 rng(5);
+  std::bernoulli_distribution bit(.3);
+  const size_t h = 13, w = 17;
+  std::vector<uint8_t> mask(h * w), decoded(h * w);
+  size_t area = 0;
+  for (auto& m : mask) area += (m = bit(rng));
+
+  Rle rle = rle_encode(mask.data(), h, w);
+  rle_decode(rle, decoded.data());
+  EXPECT_EQ(decoded, mask);
+  EXPECT_EQ(rle_area(rle), area);
+}
+
+/**
+ * @test
+ * @brief Verifies that the builder merges adjacent spans and pads with zeros.
+ */
+TEST(RleTest, BuilderMergesAndPads) {
+  RleBuilder b(4, 4);
+  b.append(false, 3);
+  b.append(true, 2);
+  b.append(true, 3);
+  b.append(false, 0);
+  Rle rle = b.finish();
+  EXPECT_EQ(rle.counts, (std::vector<uint32_t>{3, 5, 8}));
+
+  RleBuilder overflow(1, 1);
+  overflow.append(true, 2);
+  EXPECT_THROW(overflow.finish(), std::length_error);
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test_spatial_index.cpp
+ * @brief Unit tests for the PackedRTree and UniformGrid spatial indexes and
+ * for merging tiled detections.
+ *
+ * Window and nearest neighbour queries are checked against brute-force scans
+ * over random boxes.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "detection/spatial_index.h"
+#include "detection/tile_merge.h"
+
+/**
+ * @brief Create random boxes scattered over a square scene.
+ */
+static BoxSet random_boxes(size_t n, float extent, std::mt19937& rng) {
+  std::uniform_real_distribution<float> pos(0.f, extent), size(1.f, 40.f);
+  std::uniform_int_distribution<int32_t> label(0, 3);
+  BoxSet boxes;
+  for (size_t i = 0; i < n; ++i) {
+    const float x = pos(rng), y = pos(rng);
+    boxes.push_back(x, y, x + size(rng), y + size(rng), pos(rng) / extent,
+                    label(rng));
+  }
+  return boxes;
+}
+
+/**
+ * @brief Brute-force window query.
+ */
+static std::vector<uint32_t> scan_window(const BoxSet& b,
+                                         const SpatialWindow& w) {
+  std::vector<uint32_t> r;
+  for (uint32_t i = 0; i < b.size(); ++i)
+    if (b.x1[i] <= w.x2 && b.y1[i] <= w.y2 && b.x2[i] >= w.x1 &&
+        b.y2[i] >= w.y1)
+      r.push_back(i);
+  return r;
+}
+
+/**
+ * @brief Distance from a point to box @p i.
+ */
+static float distance(const BoxSet& b, uint32_t i, float x, float y) {
+  const float dx = std::max({b.x1[i] - x, 0.f, x - b.x2[i]});
+  const float dy = std::max({b.y1[i] - y, 0.f, y - b.y2[i]});
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * @brief Check a k-NN result against a brute-force ranking.
+ */
+static void expect_nearest(const BoxSet& b, const std::vector<uint32_t>& got,
+                           float x, float y, size_t k) {
+  std::vector<float> all;
+  for (uint32_t i = 0; i < b.size(); ++i) all.push_back(distance(b, i, x, y));
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(got.size(), std::min(k, b.size()));
+  for (size_t i = 0; i < got.size(); ++i)
+    EXPECT_FLOAT_EQ(distance(b, got[i], x, y), all[i]) << "Rank " << i;
+}
+
+/**
+ * @test
+ * @brief Verifies R-tree and grid window queries against a linear scan.
+ */
+TEST(SpatialIndexTest, WindowQueriesMatchScan) {
+  std::mt19937 rng(8);
+  const BoxSet boxes = random_boxes(2000, 1000.f, rng);
+  const PackedRTree tree(boxes);
+  const UniformGrid grid(boxes, 32.f);
+  std::uniform_real_distribution<float> pos(-50.f, 1050.f), size(0.f, 200.f);
+  for (int q = 0; q < 50; ++q) {
+    const float x = pos(rng), y = pos(rng);
+    const SpatialWindow w{x, y, x + size(rng), y + size(rng)};
+    std::vector<uint32_t> from_tree, from_grid;
+    tree.search(w, from_tree);
+    grid.search(w, from_grid);
+    std::sort(from_tree.begin(), from_tree.end());
+    std::sort(from_grid.begin(), from_grid.end());
+    const auto expected = scan_window(boxes, w);
+    EXPECT_EQ(from_tree, expected);
+    EXPECT_EQ(from_grid, expected);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies that filters restrict window query results.
+ */
+TEST(SpatialIndexTest, FilterRestrictsResults) {
+  std::mt19937 rng(9);
+  const BoxSet boxes = random_boxes(500, 300.f, rng);
+  const PackedRTree tree(boxes, 4);
+  const SpatialFilter only_class_2 = [&](uint32_t i) {
+    return boxes.labels[i] == 2;
+  };
+  std::vector<uint32_t> r;
+  tree.search({0.f, 0.f, 400.f, 400.f}, r, only_class_2);
+  size_t expected = 0;
+  for (auto l : boxes.labels) expected += l == 2;
+  EXPECT_EQ(r.size(), expected);
+  for (auto i : r) EXPECT_EQ(boxes.labels[i], 2);
+}
+
+/**
+ * @test
+ * @brief Verifies R-tree and grid k-NN queries against a brute-force ranking.
+ */
+TEST(SpatialIndexTest, NearestMatchesBruteForce) {
+  std::mt19937 rng(10);
+  const BoxSet boxes = random_boxes(1500, 800.f, rng);
+  const PackedRTree tree(boxes);
+  const UniformGrid grid(boxes, 25.f);
+  std::uniform_real_distribution<float> pos(-100.f, 900.f);
+  for (int q = 0; q < 30; ++q) {
+    const float x = pos(rng), y = pos(rng);
+    expect_nearest(boxes, tree.nearest(x, y, 7), x, y, 7);
+    expect_nearest(boxes, grid.nearest(x, y, 7), x, y, 7);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies k-NN distance limits and empty indexes.
+ */
+TEST(SpatialIndexTest, NearestRespectsMaxDistance) {
+  BoxSet boxes;
+  boxes.push_back(0.f, 0.f, 1.f, 1.f, 1.f, 0);
+  boxes.push_back(10.f, 0.f, 11.f, 1.f, 1.f, 0);
+  const PackedRTree tree(boxes);
+  const UniformGrid grid(boxes, 2.f);
+  EXPECT_EQ(tree.nearest(2.f, .5f, 5, 3.f), std::vector<uint32_t>{0});
+  EXPECT_EQ(grid.nearest(2.f, .5f, 5, 3.f), std::vector<uint32_t>{0});
+  EXPECT_TRUE(PackedRTree(BoxSet{}).nearest(0.f, 0.f, 3).empty());
+  EXPECT_THROW(UniformGrid(boxes, 0.f), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies that duplicates from overlapping tiles are merged.
+ */
+TEST(TileMergeTest, RemovesCrossTileDuplicates) {
+  // Two 100x100 tiles overlapping by 20 pixels see the same aircraft.
+  BoxSet left, right;
+  left.push_back(85.f, 10.f, 99.f, 30.f, .7f, 1);   // clipped view
+  left.push_back(10.f, 10.f, 20.f, 20.f, .9f, 1);
+  right.push_back(5.f, 10.f, 20.f, 30.f, .95f, 1);  // full view
+  right.push_back(5.f, 10.f, 20.f, 30.f, .6f, 2);   // other class
+  auto merged = merge_tile_detections({left, right}, {{0.f, 0.f}, {80.f, 0.f}});
+  ASSERT_EQ(merged.size(), 3u);
+  EXPECT_FLOAT_EQ(merged.scores[0], .95f);
+  EXPECT_FLOAT_EQ(merged.x1[0], 85.f);
+  EXPECT_FLOAT_EQ(merged.scores[1], .9f);
+  EXPECT_EQ(merged.labels[2], 2);
+
+  TileMergeParams agnostic;
+  agnostic.class_aware = false;
+  EXPECT_EQ(
+      merge_tile_detections({left, right}, {{0, 0}, {80, 0}}, agnostic).size(),
+      2u);
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_conv.cpp
+ * @brief Unit tests for the 2D convolution kernels and layout conversions.
+ *
+ * Every algorithm is compared against a naive NCHW convolution over shapes
+ * with padding, stride, dilation, groups and channel counts that leave
+ * partial NCHWc blocks.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "ops/conv.h"
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Shape of one convolution test case.
+ */
+struct ConvCase {
+  size_t n, ci, co, h, w, kh, kw;
+  Conv2dParams p;
+};
+
+/**
+ * @brief Naive grouped, strided, dilated and padded NCHW convolution.
+ */
+static Tensor<float> conv_reference(const Tensor<float>& x,
+                                    const Tensor<float>& wt,
+                                    const Tensor<float>& bias,
+                                    const Conv2dParams& p) {
+  const size_t n = x.dim(0), h = x.dim(2), w = x.dim(3);
+  const size_t co = wt.dim(0), cig = wt.dim(1), kh = wt.dim(2), kw = wt.dim(3);
+  const size_t oh = conv_output_size(h, kh, p.stride_h, p.pad_top,
+                                     p.pad_bottom, p.dilation_h);
+  const size_t ow = conv_output_size(w, kw, p.stride_w, p.pad_left,
+                                     p.pad_right, p.dilation_w);
+  const size_t cog = co / p.groups;
+  Tensor<float> y(Shape{n, co, oh, ow});
+  for (size_t b = 0; b < n; ++b)
+    for (size_t o = 0; o < co; ++o)
+      for (size_t oy = 0; oy < oh; ++oy)
+        for (size_t ox = 0; ox < ow; ++ox) {
+          double acc = bias.empty() ? 0. : bias[o];
+          for (size_t c = 0; c < cig; ++c)
+            for (size_t ky = 0; ky < kh; ++ky)
+              for (size_t kx = 0; kx < kw; ++kx) {
+                const long iy = long(oy * p.stride_h + ky * p.dilation_h) -
+                                long(p.pad_top);
+                const long ix = long(ox * p.stride_w + kx * p.dilation_w) -
+                                long(p.pad_left);
+                if (iy < 0 || ix < 0 || iy >= long(h) || ix >= long(w))
+                  continue;
+                acc += double(x(b, o / cog * cig + c, size_t(iy),
+                                size_t(ix))) *
+                       wt(o, c, ky, kx);
+              }
+          y(b, o, oy, ox) = float(acc);
+        }
+  return y;
+}
+
+/**
+ * @brief Run one case with a given layout and algorithm and compare.
+ */
+static void check(const ConvCase& c, ConvLayout layout,
+                  ConvAlgorithm algorithm = ConvAlgorithm::kAuto,
+                  bool with_bias = true) {
+  std::mt19937 rng(unsigned(c.ci * 131 + c.co * 7 + c.kh));
+  const Tensor<float> x = random_tensor(Shape{c.n, c.ci, c.h, c.w}, rng);
+  const Tensor<float> wt =
+      random_tensor(Shape{c.co, c.ci / c.p.groups, c.kh, c.kw}, rng);
+  const Tensor<float> bias =
+      with_bias ? random_tensor(Shape{c.co}, rng) : Tensor<float>();
+  const Tensor<float> expected = conv_reference(x, wt, bias, c.p);
+
+  const Conv2d conv(wt, bias, c.p, layout, algorithm);
+  Tensor<float> y;
+  if (layout == ConvLayout::kNchwc)
+    y = to_nchw(conv.forward(to_nchwc(x, conv.block())), c.co);
+  else
+    y = conv.forward(x);
+  ASSERT_EQ(y.shape(), expected.shape());
+  const float tol = 1e-4f * float(c.ci * c.kh * c.kw);
+  for (size_t i = 0; i < y.numel(); ++i)
+    ASSERT_NEAR(y[i], expected[i], tol)
+        << "index " << i << " algorithm " << int(conv.algorithm());
+}
+
+/**
+ * @brief Convolution shapes shared by the tests.
+ */
+static std::vector<ConvCase> cases() {
+  std::vector<ConvCase> v;
+  Conv2dParams same3;
+  same3.pad_top = same3.pad_left = same3.pad_bottom = same3.pad_right = 1;
+  Conv2dParams strided = same3;
+  strided.stride_h = strided.stride_w = 2;
+  Conv2dParams dilated;
+  dilated.pad_top = dilated.pad_left = 2;
+  dilated.pad_bottom = 1;
+  dilated.dilation_h = dilated.dilation_w = 2;
+  Conv2dParams asym;
+  asym.stride_w = 3;
+  asym.pad_right = 2;
+  v.push_back({1, 16, 32, 9, 23, 1, 1, {}});     // 1x1
+  v.push_back({2, 5, 11, 7, 13, 3, 3, same3});   // partial blocks
+  v.push_back({1, 24, 20, 17, 17, 3, 3, strided});
+  v.push_back({1, 8, 8, 12, 30, 3, 3, dilated});
+  v.push_back({1, 3, 17, 10, 25, 5, 3, asym});
+  v.push_back({1, 16, 16, 5, 40, 1, 7, same3});  // wide row tiles
+  return v;
+}
+
+/**
+ * @test
+ * @brief Verifies the NCHW GEMM and im2col algorithms against the reference.
+ */
+TEST(ConvTest, NchwMatchesReference) {
+  for (const ConvCase& c : cases()) check(c, ConvLayout::kNchw);
+  check(cases()[0], ConvLayout::kNchw, ConvAlgorithm::kIm2col, false);
+
+  ConvCase grouped{2, 12, 18, 8, 9, 3, 3, {}};
+  grouped.p.groups = 3;
+  grouped.p.pad_top = grouped.p.pad_left = 1;
+  check(grouped, ConvLayout::kNchw);
+}
+
+/**
+ * @test
+ * @brief Verifies the NCHWc direct kernels against the reference.
+ */
+TEST(ConvTest, NchwcDirectMatchesReference) {
+  for (const ConvCase& c : cases()) check(c, ConvLayout::kNchwc);
+  check(cases()[1], ConvLayout::kNchwc, ConvAlgorithm::kDirect, false);
+}
+
+/**
+ * @test
+ * @brief Verifies depthwise kernels in both layouts.
+ */
+TEST(ConvTest, DepthwiseMatchesReference) {
+  for (size_t stride : {1, 2}) {
+    ConvCase c{2, 20, 20, 11, 14, 3, 3, {}};
+    c.p.groups = 20;
+    c.p.stride_h = c.p.stride_w = stride;
+    c.p.pad_top = c.p.pad_left = c.p.pad_bottom = c.p.pad_right = 1;
+    check(c, ConvLayout::kNchw);
+    check(c, ConvLayout::kNchwc);
+    c.p.dilation_w = 2;
+    check(c, ConvLayout::kNchwc, ConvAlgorithm::kDepthwise, false);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies every available kernel set, single and multi-threaded.
+ */
+TEST(ConvTest, AllKernelsAgree) {
+  const CpuFeatures detected = cpu_features();
+  CpuFeatures avx2_only;
+  avx2_only.avx2 = detected.avx2;
+  avx2_only.fma = detected.fma;
+  ConvCase dw{1, 9, 9, 6, 19, 3, 3, {}};
+  dw.p.groups = 9;
+  dw.p.pad_top = dw.p.pad_left = 1;
+  set_num_threads(3);
+  for (const CpuFeatures& f : {CpuFeatures{}, avx2_only, detected}) {
+    set_cpu_features(f);
+    for (const ConvCase& c : cases()) check(c, ConvLayout::kNchwc);
+    check(dw, ConvLayout::kNchwc);
+    check(cases()[2], ConvLayout::kNchw);
+  }
+  set_num_threads(0);
+  reset_cpu_features();
+}
+
+/**
+ * @test
+ * @brief Verifies the fused residual add and clamp on every algorithm.
+ */
+TEST(ConvTest, EpilogueMatchesReference) {
+  std::mt19937 rng(21);
+  ConvCase dw{1, 12, 12, 9, 10, 3, 3, {}};
+  dw.p.groups = 12;
+  dw.p.pad_top = dw.p.pad_left = dw.p.pad_bottom = dw.p.pad_right = 1;
+  const struct {
+    ConvCase c;
+    ConvLayout layout;
+    ConvAlgorithm algorithm;
+  } runs[] = {
+      {cases()[0], ConvLayout::kNchw, ConvAlgorithm::kGemm},
+      {cases()[1], ConvLayout::kNchw, ConvAlgorithm::kIm2col},
+      {cases()[1], ConvLayout::kNchw, ConvAlgorithm::kWinograd},
+      {cases()[2], ConvLayout::kNchwc, ConvAlgorithm::kDirect},
+      {dw, ConvLayout::kNchw, ConvAlgorithm::kDepthwise},
+      {dw, ConvLayout::kNchwc, ConvAlgorithm::kDepthwise},
+  };
+  for (const auto& run : runs) {
+    const ConvCase& c = run.c;
+    const Tensor<float> x = random_tensor(Shape{c.n, c.ci, c.h, c.w}, rng);
+    const Tensor<float> wt =
+        random_tensor(Shape{c.co, c.ci / c.p.groups, c.kh, c.kw}, rng);
+    const Tensor<float> bias = random_tensor(Shape{c.co}, rng);
+    const Tensor<float> plain = conv_reference(x, wt, bias, c.p);
+    const Tensor<float> residual = random_tensor(plain.shape(), rng);
+
+    const Conv2d conv(wt, bias, c.p, run.layout, run.algorithm);
+    const bool blocked = run.layout == ConvLayout::kNchwc;
+    const Tensor<float> in = blocked ? to_nchwc(x, conv.block()) : x;
+    const Tensor<float> res =
+        blocked ? to_nchwc(residual, conv.block()) : residual;
+    ConvEpilogue epilogue;
+    epilogue.residual = &res;
+    epilogue.clamp_min = 0.f;
+    epilogue.clamp_max = 1.5f;
+    Tensor<float> y(conv.outputShape(in.shape()));
+    conv.forward(in, y, epilogue);
+    if (blocked) y = to_nchw(y, c.co);
+    const float tol = 2e-4f * float(c.ci * c.kh * c.kw);
+    for (size_t i = 0; i < y.numel(); ++i)
+      ASSERT_NEAR(y[i], std::clamp(plain[i] + residual[i], 0.f, 1.5f), tol)
+          << "index " << i << " algorithm " << int(conv.algorithm());
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies NCHW <-> NCHWc round trips and zero channel padding.
+ */
+TEST(ConvTest, LayoutRoundTrip) {
+  std::mt19937 rng(12);
+  const Tensor<float> x = random_tensor(Shape{2, 11, 3, 5}, rng);
+  const Tensor<float> blocked = to_nchwc(x, 8);
+  ASSERT_EQ(blocked.shape(), (Shape{2, 2, 3, 5, 8}));
+  EXPECT_EQ(blocked(1, 1, 2, 4, 2), x(1, 10, 2, 4));
+  EXPECT_EQ(blocked(1, 1, 2, 4, 3), 0.f);
+  const Tensor<float> back = to_nchw(blocked, 11);
+  for (size_t i = 0; i < x.numel(); ++i) EXPECT_EQ(back[i], x[i]);
+}
+
+/**
+ * @test
+ * @brief Verifies rejection of unsupported algorithms and bad shapes.
+ */
+TEST(ConvTest, RejectsInvalidConfigurations) {
+  const Tensor<float> w3(Shape{4, 4, 3, 3}), w1(Shape{4, 4, 1, 1});
+  const Tensor<float> none;
+  EXPECT_THROW(Conv2d(w3, none, {}, ConvLayout::kNchw, ConvAlgorithm::kGemm),
+               std::invalid_argument);
+  EXPECT_THROW(Conv2d(w1, none, {}, ConvLayout::kNchw, ConvAlgorithm::kDirect),
+               std::invalid_argument);
+  EXPECT_THROW(
+      Conv2d(w1, none, {}, ConvLayout::kNchwc, ConvAlgorithm::kDepthwise),
+      std::invalid_argument);
+  Conv2dParams grouped;
+  grouped.groups = 2;
+  EXPECT_THROW(Conv2d(w1, none, grouped, ConvLayout::kNchwc),
+               std::invalid_argument);
+  EXPECT_THROW(Conv2d(w1, Tensor<float>(Shape{3}), {}), std::invalid_argument);
+
+  const Conv2d conv(w3, none, {});
+  EXPECT_EQ(conv.algorithm(), ConvAlgorithm::kIm2col);
+  EXPECT_THROW(conv.forward(Tensor<float>(Shape{1, 3, 8, 8})),
+               std::invalid_argument);
+  EXPECT_THROW(conv.forward(Tensor<float>(Shape{1, 4, 2, 8})),
+               std::invalid_argument);
+  Tensor<float> out(Shape{1, 4, 5, 5});
+  EXPECT_THROW(conv.forward(Tensor<float>(Shape{1, 4, 8, 8}), out),
+               std::invalid_argument);
+}
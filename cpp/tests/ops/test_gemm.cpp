@@ -0,0 +1,265 @@
+/**
+ * @file test_gemm.cpp
+ * @brief Unit tests for the blocked SGEMM.
+ *
+ * Results are compared with a naive triple loop in double precision for all
+ * transpose combinations, shapes that leave partial micro-tiles and blocks,
+ * every micro-kernel the CPU supports and multi-threaded execution.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "ops/gemm.h"
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Operands and expected result of one GEMM problem.
+ */
+struct GemmCase {
+  size_t m, n, k;
+  bool ta, tb;
+  float alpha, beta;
+  std::vector<float> a, b, c, expected;
+  size_t lda, ldb, ldc;
+};
+
+/**
+ * @brief Build a random GEMM problem with padded leading dimensions.
+ */
+static GemmCase make_case(size_t m, size_t n, size_t k, bool ta, bool tb,
+                          float alpha, float beta, std::mt19937& rng) {
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  GemmCase g{m, n, k, ta, tb, alpha, beta, {}, {}, {}, {}, 0, 0, 0};
+  g.lda = (ta ? m : k) + 3;
+  g.ldb = (tb ? k : n) + 1;
+  g.ldc = n + 2;
+  g.a.resize((ta ? k : m) * g.lda);
+  g.b.resize((tb ? n : k) * g.ldb);
+  g.c.resize(m * g.ldc);
+  for (auto* v : {&g.a, &g.b, &g.c})
+    for (float& x : *v) x = dist(rng);
+  g.expected = g.c;
+  for (size_t i = 0; i < m; ++i)
+    for (size_t j = 0; j < n; ++j) {
+      double acc = 0.;
+      for (size_t p = 0; p < k; ++p) {
+        const float av = ta ? g.a[p * g.lda + i] : g.a[i * g.lda + p];
+        const float bv = tb ? g.b[j * g.ldb + p] : g.b[p * g.ldb + j];
+        acc += double(av) * bv;
+      }
+      float& e = g.expected[i * g.ldc + j];
+      e = float(alpha * acc + (beta == 0.f ? 0. : double(beta) * e));
+    }
+  return g;
+}
+
+/**
+ * @brief Run sgemm() on a case and compare against the reference.
+ */
+static void check(GemmCase g) {
+  sgemm(g.ta, g.tb, g.m, g.n, g.k, g.alpha, g.a.data(), g.lda, g.b.data(),
+        g.ldb, g.beta, g.c.data(), g.ldc);
+  const float tol = 1e-5f * float(g.k + 1);
+  for (size_t i = 0; i < g.m; ++i)
+    for (size_t j = 0; j < g.ldc; ++j)
+      ASSERT_NEAR(g.c[i * g.ldc + j], g.expected[i * g.ldc + j], tol)
+          << "m=" << g.m << " n=" << g.n << " k=" << g.k << " at (" << i
+          << ", " << j << ")";
+}
+
+/**
+ * @test
+ * @brief Verifies all transpose combinations over awkward shapes.
+ */
+TEST(GemmTest, MatchesReference) {
+  std::mt19937 rng(3);
+  const size_t shapes[][3] = {{1, 1, 1},   {7, 5, 3},    {13, 33, 17},
+                              {50, 70, 9}, {145, 40, 300}, {30, 97, 513}};
+  for (const auto& s : shapes)
+    for (bool ta : {false, true})
+      for (bool tb : {false, true})
+        check(make_case(s[0], s[1], s[2], ta, tb, 1.f, 0.f, rng));
+}
+
+/**
+ * @test
+ * @brief Verifies alpha and beta scaling, including beta == 0 with NaN in C.
+ */
+TEST(GemmTest, AlphaBeta) {
+  std::mt19937 rng(4);
+  check(make_case(20, 40, 30, false, false, .5f, 1.f, rng));
+  check(make_case(20, 40, 300, true, false, -2.f, .25f, rng));
+  check(make_case(20, 40, 30, false, true, 0.f, 3.f, rng));
+
+  GemmCase g = make_case(9, 18, 5, false, false, 1.f, 0.f, rng);
+  for (size_t i = 0; i < g.m; ++i)
+    for (size_t j = 0; j < g.n; ++j)
+      g.c[i * g.ldc + j] = std::numeric_limits<float>::quiet_NaN();
+  check(g);
+}
+
+/**
+ * @test
+ * @brief Verifies every available micro-kernel against the reference.
+ */
+TEST(GemmTest, AllKernelsAgree) {
+  std::mt19937 rng(5);
+  const CpuFeatures detected = cpu_features();
+  CpuFeatures avx2_only;
+  avx2_only.avx2 = detected.avx2;
+  avx2_only.fma = detected.fma;
+  for (const CpuFeatures& f : {CpuFeatures{}, avx2_only, detected}) {
+    set_cpu_features(f);
+    check(make_case(37, 71, 290, false, false, 1.f, .5f, rng));
+    check(make_case(37, 71, 29, true, true, 1.f, 0.f, rng));
+  }
+  reset_cpu_features();
+}
+
+/**
+ * @test
+ * @brief Verifies M/N partitioning across threads, including wide outputs
+ * with fewer M blocks than threads and outputs wider than one B panel.
+ */
+TEST(GemmTest, Parallel) {
+  std::mt19937 rng(6);
+  set_num_threads(4);
+  check(make_case(300, 200, 100, false, false, 1.f, 0.f, rng));
+  check(make_case(8, 500, 64, false, false, 1.f, 1.f, rng));
+  check(make_case(3, 3500, 20, false, true, 1.f, 0.f, rng));
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies GEMMs nested through task groups: parallel_for() bodies
+ * spawn tasks that run GEMMs and run a GEMM themselves, so a thread waiting
+ * inside one GEMM may run another that needs its own packing buffers.
+ */
+TEST(GemmTest, NestedInTaskGroup) {
+  std::mt19937 rng(10);
+  set_num_threads(4);
+  for (int round = 0; round < 5; ++round) {
+    std::vector<GemmCase> outer, inner;
+    for (int t = 0; t < 8; ++t) {
+      outer.push_back(make_case(96, 300, 300, false, false, 1.f, 0.f, rng));
+      inner.push_back(make_case(64, 500, 280, false, true, 1.f, 0.f, rng));
+    }
+    TaskGroup group;
+    parallel_for(0, outer.size(), 1, [&](size_t first, size_t last) {
+      for (size_t t = first; t < last; ++t) {
+        GemmCase* g = &inner[t];
+        group.run([g] { check(*g); });
+        check(outer[t]);
+      }
+    });
+    group.wait();
+  }
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies the pre-packed A path against the reference.
+ */
+TEST(GemmTest, PackedA) {
+  std::mt19937 rng(7);
+  for (bool ta : {false, true}) {
+    GemmCase g = make_case(61, 45, 300, ta, false, 1.5f, .5f, rng);
+    const GemmPackedA packed =
+        sgemm_pack_a(ta, g.m, g.k, g.alpha, g.a.data(), g.lda);
+    EXPECT_EQ(packed.m, g.m);
+    EXPECT_EQ(packed.k, g.k);
+    sgemm_packed(packed, false, g.n, g.b.data(), g.ldb, g.beta, g.c.data(),
+                 g.ldc);
+    for (size_t i = 0; i < g.c.size(); ++i)
+      ASSERT_NEAR(g.c[i], g.expected[i], 1e-3f);
+  }
+  float c = 1.f;
+  EXPECT_THROW(sgemm_packed(GemmPackedA{1, 1, 4, 8, {}}, false, 1, &c, 1, 0.f,
+                            &c, 1),
+               std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies results do not depend on the cache blocking.
+ */
+TEST(GemmTest, Blocking) {
+  std::mt19937 rng(12);
+  EXPECT_EQ(sgemm_blocking().mc, GemmBlocking{}.mc);
+  for (const GemmBlocking& blocking :
+       {GemmBlocking{1, 1}, GemmBlocking{30, 50}, GemmBlocking{500, 9000}}) {
+    set_sgemm_blocking(blocking);
+    EXPECT_EQ(sgemm_blocking().nc, blocking.nc);
+    check(make_case(77, 130, 300, false, true, 1.f, .5f, rng));
+    GemmCase g = make_case(40, 90, 270, false, false, 1.f, 0.f, rng);
+    const GemmPackedA packed =
+        sgemm_pack_a(false, g.m, g.k, 1.f, g.a.data(), g.lda);
+    sgemm_packed(packed, false, g.n, g.b.data(), g.ldb, 0.f, g.c.data(),
+                 g.ldc);
+    for (size_t i = 0; i < g.m; ++i)
+      for (size_t j = 0; j < g.n; ++j)
+        ASSERT_NEAR(g.c[i * g.ldc + j], g.expected[i * g.ldc + j], 3e-3f);
+  }
+  set_sgemm_blocking({});
+  EXPECT_EQ(sgemm_blocking().nc, GemmBlocking{}.nc);
+  EXPECT_THROW(set_sgemm_blocking({0, 64}), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies the fused bias, residual and clamp epilogue.
+ */
+TEST(GemmTest, Epilogue) {
+  std::mt19937 rng(8);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (size_t k : {0, 37, 600}) {  // empty, single and multiple K slices
+    GemmCase g = make_case(29, 70, k, false, false, 1.f, 0.f, rng);
+    std::vector<float> bias(g.m), residual(g.m * 80);
+    for (float& v : bias) v = dist(rng);
+    for (float& v : residual) v = dist(rng);
+    GemmEpilogue epi;
+    epi.row_bias = bias.data();
+    epi.residual = residual.data();
+    epi.ldr = 80;
+    epi.clamp_min = -0.5f;
+    epi.clamp_max = 0.75f;
+    const GemmPackedA packed =
+        sgemm_pack_a(false, g.m, g.k, 1.f, g.a.data(), g.lda);
+    sgemm_packed(packed, false, g.n, g.b.data(), g.ldb, 0.f, g.c.data(),
+                 g.ldc, epi);
+    for (size_t i = 0; i < g.m; ++i)
+      for (size_t j = 0; j < g.n; ++j) {
+        const float v = g.expected[i * g.ldc + j] + bias[i] +
+                        residual[i * 80 + j];
+        ASSERT_NEAR(g.c[i * g.ldc + j], std::clamp(v, -0.5f, 0.75f), 1e-3f);
+      }
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies the tensor convenience wrapper.
+ */
+TEST(GemmTest, Matmul) {
+  Tensor<float> a(Shape{2, 3}), b(Shape{3, 2});
+  for (size_t i = 0; i < 6; ++i) {
+    a[i] = float(i + 1);
+    b[i] = float(6 - i);
+  }
+  const Tensor<float> c = matmul(a, b);
+  ASSERT_EQ(c.shape(), (Shape{2, 2}));
+  EXPECT_FLOAT_EQ(c(0, 0), 1 * 6 + 2 * 4 + 3 * 2);
+  EXPECT_FLOAT_EQ(c(0, 1), 1 * 5 + 2 * 3 + 3 * 1);
+  EXPECT_FLOAT_EQ(c(1, 0), 4 * 6 + 5 * 4 + 6 * 2);
+  EXPECT_FLOAT_EQ(c(1, 1), 4 * 5 + 5 * 3 + 6 * 1);
+  EXPECT_THROW(matmul(a, a), std::invalid_argument);
+}
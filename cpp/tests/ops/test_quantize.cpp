@@ -0,0 +1,240 @@
+/**
+ * @file test_quantize.cpp
+ * @brief Unit tests for the INT8 GEMM and convolution.
+ *
+ * qgemm() is compared with an exact integer reference built from the same
+ * per-row weight quantization for every micro-kernel the CPU supports, so
+ * any packing or accumulation error shows up as a mismatch rather than as
+ * quantization noise. QConv2d is compared with the float convolution.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "ops/conv.h"
+#include "ops/quantize.h"
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Run qgemm() on random operands and compare with the reference.
+ */
+static void check_qgemm(size_t m, size_t n, size_t k, bool tb,
+                        std::mt19937& rng) {
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::uniform_int_distribution<int> code(0, 255);
+  const size_t lda = k + 3, ldb = (tb ? k : n) + 1, ldc = n + 2;
+  std::vector<float> a(m * lda), bias(m), residual(m * n), c(m * ldc, -7.f);
+  std::vector<uint8_t> b((tb ? n : k) * ldb);
+  for (float& v : a) v = dist(rng);
+  for (float& v : bias) v = dist(rng);
+  for (float& v : residual) v = dist(rng);
+  for (uint8_t& v : b) v = uint8_t(code(rng));
+  const QuantParams bp{0.02f, 100};
+
+  const QGemmPackedA packed = qgemm_quantize_a(m, k, a.data(), lda);
+  ASSERT_EQ(packed.m, m);
+  ASSERT_EQ(packed.k, k);
+  GemmEpilogue epi;
+  epi.row_bias = bias.data();
+  epi.residual = residual.data();
+  epi.ldr = n;
+  epi.clamp_min = -1.5f;
+  epi.clamp_max = 2.f;
+  qgemm(packed, tb, n, b.data(), ldb, bp, c.data(), ldc, epi);
+
+  const float qmax = float(packed.qmax);
+  for (size_t i = 0; i < m; ++i) {
+    float amax = 0.f;
+    for (size_t p = 0; p < k; ++p)
+      amax = std::max(amax, std::abs(a[i * lda + p]));
+    const float sa = amax > 0.f ? amax / qmax : 1.f;
+    ASSERT_EQ(packed.scales[i], sa);
+    for (size_t j = 0; j < n; ++j) {
+      int64_t acc = 0;
+      for (size_t p = 0; p < k; ++p) {
+        const float qa =
+            std::clamp(std::nearbyint(a[i * lda + p] / sa), -qmax, qmax);
+        const int bv = tb ? b[j * ldb + p] : b[p * ldb + j];
+        acc += int64_t(qa) * (bv - bp.zero_point);
+      }
+      const float v =
+          sa * bp.scale * float(acc) + bias[i] + residual[i * n + j];
+      ASSERT_NEAR(c[i * ldc + j], std::clamp(v, -1.5f, 2.f),
+                  1e-5f * (1.f + std::abs(v)))
+          << "m=" << m << " n=" << n << " k=" << k << " at (" << i << ", "
+          << j << ")";
+    }
+    for (size_t j = n; j < ldc; ++j) ASSERT_EQ(c[i * ldc + j], -7.f);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies parameter selection covers the range and keeps zero exact.
+ */
+TEST(QuantizeTest, ChooseParams) {
+  const QuantParams relu = choose_quant_params(0.f, 6.f);
+  EXPECT_EQ(relu.zero_point, 0);
+  EXPECT_FLOAT_EQ(relu.scale, 6.f / 255.f);
+  const QuantParams mixed = choose_quant_params(-1.f, 3.f);
+  EXPECT_EQ(mixed.zero_point, 64);
+  const QuantParams positive = choose_quant_params(2.f, 4.f);
+  EXPECT_EQ(positive.zero_point, 0);
+  EXPECT_FLOAT_EQ(positive.scale, 4.f / 255.f);
+  EXPECT_EQ(choose_quant_params(0.f, 0.f).scale, 1.f);
+  EXPECT_THROW(choose_quant_params(1.f, -1.f), std::invalid_argument);
+  EXPECT_THROW(choose_quant_params(0.f, INFINITY), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies rounding and saturation in the vector and scalar paths.
+ */
+TEST(QuantizeTest, QuantizeU8) {
+  const QuantParams p{0.5f, 10};
+  std::vector<float> x(70);
+  for (size_t i = 0; i < x.size(); ++i) x[i] = float(i) * 0.75f - 20.f;
+  x[3] = 0.25f;   // 10.5 rounds to even
+  x[40] = 1e9f;   // saturates high
+  x[41] = -1e9f;  // saturates low
+  std::vector<uint8_t> q(x.size());
+  quantize_u8(x.data(), x.size(), p, q.data());
+  for (size_t i = 0; i < x.size(); ++i) {
+    const float e =
+        std::clamp(std::nearbyint(x[i] / p.scale + 10.f), 0.f, 255.f);
+    ASSERT_EQ(q[i], uint8_t(e)) << "at " << i;
+  }
+  EXPECT_EQ(q[3], 10);
+  EXPECT_EQ(q[40], 255);
+  EXPECT_EQ(q[41], 0);
+}
+
+/**
+ * @test
+ * @brief Verifies every available micro-kernel against the exact reference,
+ * with partial tiles, K not a multiple of four and both B layouts.
+ */
+TEST(QuantizeTest, AllKernelsMatchReference) {
+  std::mt19937 rng(11);
+  const CpuFeatures detected = cpu_features();
+  CpuFeatures avx2;
+  avx2.avx2 = detected.avx2;
+  CpuFeatures avxvnni = avx2;
+  avxvnni.avxvnni = detected.avxvnni;
+  std::vector<const char*> names;
+  for (const CpuFeatures& f : {CpuFeatures{}, avx2, avxvnni, detected}) {
+    set_cpu_features(f);
+    names.push_back(qgemm_kernel_name());
+    for (bool tb : {false, true}) {
+      check_qgemm(1, 1, 1, tb, rng);
+      check_qgemm(37, 71, 290, tb, rng);
+      check_qgemm(150, 45, 27, tb, rng);
+    }
+  }
+  reset_cpu_features();
+  EXPECT_STREQ(names[0], "generic");
+  if (detected.avx2) {
+    EXPECT_STREQ(names[1], "avx2");
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies M/N partitioning across threads and multiple B blocks.
+ */
+TEST(QuantizeTest, Parallel) {
+  std::mt19937 rng(12);
+  set_num_threads(4);
+  check_qgemm(300, 200, 100, false, rng);
+  check_qgemm(3, 9000, 200, false, rng);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies an empty reduction leaves only the epilogue and that a
+ * foreign packing layout is rejected.
+ */
+TEST(QuantizeTest, EdgeCases) {
+  std::mt19937 rng(13);
+  check_qgemm(5, 40, 0, false, rng);
+  QGemmPackedA bogus;
+  bogus.m = bogus.k = 1;
+  bogus.mr = 3;
+  bogus.nr = 5;
+  bogus.data = Tensor<int8_t>(Shape{12});
+  float c = 0.f;
+  const uint8_t b[4] = {};
+  EXPECT_THROW(qgemm(bogus, false, 1, b, 1, {}, &c, 1),
+               std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies the INT8 convolution stays close to the float one for
+ * padded, strided, grouped and pointwise layers with a fused epilogue.
+ */
+TEST(QuantizeTest, ConvMatchesFloat) {
+  std::mt19937 rng(14);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  struct Case {
+    size_t ci, co, k, stride, pad, groups;
+  };
+  for (const Case& s : {Case{16, 24, 3, 1, 1, 1}, Case{8, 12, 3, 2, 1, 2},
+                        Case{32, 16, 1, 1, 0, 1}}) {
+    Conv2dParams p;
+    p.stride_h = p.stride_w = s.stride;
+    p.pad_top = p.pad_left = p.pad_bottom = p.pad_right = s.pad;
+    p.groups = s.groups;
+    Tensor<float> x(Shape{2, s.ci, 11, 9});
+    Tensor<float> w(Shape{s.co, s.ci / s.groups, s.k, s.k});
+    Tensor<float> b(Shape{s.co});
+    for (auto* t : {&x, &w, &b})
+      for (size_t i = 0; i < t->numel(); ++i) (*t)[i] = dist(rng);
+
+    const Conv2d ref(w, b, p);
+    const QConv2d q(w, b, p, choose_quant_params(-1.f, 1.f));
+    ASSERT_EQ(q.outputShape(x.shape()), ref.outputShape(x.shape()));
+    Tensor<float> residual(ref.outputShape(x.shape()));
+    for (size_t i = 0; i < residual.numel(); ++i) residual[i] = dist(rng);
+    ConvEpilogue epi;
+    epi.residual = &residual;
+    epi.clamp_min = 0.f;
+    Tensor<float> expected(residual.shape()), actual(residual.shape());
+    ref.forward(x, expected, epi);
+    q.forward(x, actual, epi);
+
+    // Errors scale with the accumulated magnitude of a filter's products.
+    const float tol =
+        0.02f * std::sqrt(float(s.ci / s.groups * s.k * s.k)) + 1e-3f;
+    for (size_t i = 0; i < actual.numel(); ++i)
+      ASSERT_NEAR(actual[i], expected[i], tol) << "at " << i;
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies invalid layers and inputs are rejected.
+ */
+TEST(QuantizeTest, ConvRejectsInvalid) {
+  const Tensor<float> w(Shape{4, 2, 3, 3}), none;
+  Conv2dParams p;
+  EXPECT_THROW(QConv2d(Tensor<float>(Shape{4, 2}), none, p, {}),
+               std::invalid_argument);
+  EXPECT_THROW(QConv2d(w, Tensor<float>(Shape{3}), p, {}),
+               std::invalid_argument);
+  EXPECT_THROW(QConv2d(w, none, p, QuantParams{0.f, 0}),
+               std::invalid_argument);
+  p.groups = 3;
+  EXPECT_THROW(QConv2d(w, none, p, {}), std::invalid_argument);
+  const QConv2d conv(w, none, Conv2dParams{}, {});
+  EXPECT_THROW(conv.outputShape(Shape{1, 3, 8, 8}), std::invalid_argument);
+  EXPECT_THROW(conv.outputShape(Shape{1, 2, 2, 2}), std::invalid_argument);
+  Tensor<float> x(Shape{1, 2, 8, 8}), y(Shape{1, 4, 5, 5});
+  EXPECT_THROW(conv.forward(x, y), std::invalid_argument);
+}
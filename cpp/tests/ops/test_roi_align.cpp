@@ -0,0 +1,216 @@
+/**
+ * @file test_roi_align.cpp
+ * @brief Unit tests for the `roi_align` operation using Google Test (gtest).
+ *
+ * The optimized NHWC kernel is compared against a naive per-element reference
+ * transcribed from torchvision's ROIAlign, for aligned and unaligned boxes,
+ * fixed and adaptive sampling, ROIs partly outside the feature map and channel
+ * counts that exercise the SIMD tails.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "ops/roi_align.h"
+#include "utils/cpu_features.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Bilinearly interpolate channel @p c of an NHWC image at (y, x).
+ */
+static float bilinear_reference(const Tensor<float>& input, size_t n, float y,
+                                float x, size_t c) {
+  const auto height = static_cast<float>(input.dim(1));
+  const auto width = static_cast<float>(input.dim(2));
+  if (y < -1.f || y > height || x < -1.f || x > width) return 0.f;
+  y = std::max(y, 0.f);
+  x = std::max(x, 0.f);
+  auto y_lo = static_cast<size_t>(y), x_lo = static_cast<size_t>(x);
+  size_t y_hi, x_hi;
+  if (y_lo >= input.dim(1) - 1) {
+    y_hi = y_lo = input.dim(1) - 1;
+    y = static_cast<float>(y_lo);
+  } else {
+    y_hi = y_lo + 1;
+  }
+  if (x_lo >= input.dim(2) - 1) {
+    x_hi = x_lo = input.dim(2) - 1;
+    x = static_cast<float>(x_lo);
+  } else {
+    x_hi = x_lo + 1;
+  }
+  const float ly = y - y_lo, lx = x - x_lo, hy = 1.f - ly, hx = 1.f - lx;
+  return hy * hx * input(n, y_lo, x_lo, c) + hy * lx * input(n, y_lo, x_hi, c) +
+         ly * hx * input(n, y_hi, x_lo, c) + ly * lx * input(n, y_hi, x_hi, c);
+}
+
+/**
+ * @brief Naive ROIAlign computing every output element independently.
+ */
+static Tensor<float> roi_align_reference(const Tensor<float>& input,
+                                         const Tensor<float>& rois,
+                                         const RoiAlignParams& p) {
+  const size_t ph = p.pooled_height, pw = p.pooled_width, C = input.dim(3);
+  Tensor<float> out(Shape{rois.dim(0), ph, pw, C});
+  const float offset = p.aligned ? .5f : 0.f;
+  for (size_t r = 0; r < rois.dim(0); ++r) {
+    const auto n = static_cast<size_t>(rois(r, 0));
+    const float x1 = rois(r, 1) * p.spatial_scale - offset;
+    const float y1 = rois(r, 2) * p.spatial_scale - offset;
+    float rw = rois(r, 3) * p.spatial_scale - offset - x1;
+    float rh = rois(r, 4) * p.spatial_scale - offset - y1;
+    if (!p.aligned) {
+      rw = std::max(rw, 1.f);
+      rh = std::max(rh, 1.f);
+    }
+    const float bh = rh / ph, bw = rw / pw;
+    const int gh = p.sampling_ratio > 0 ? p.sampling_ratio
+                                        : static_cast<int>(std::ceil(bh));
+    const int gw = p.sampling_ratio > 0 ? p.sampling_ratio
+                                        : static_cast<int>(std::ceil(bw));
+    const float count = std::max(gh * gw, 1);
+    for (size_t py = 0; py < ph; ++py)
+      for (size_t px = 0; px < pw; ++px)
+        for (size_t c = 0; c < C; ++c) {
+          float sum = 0.f;
+          for (int iy = 0; iy < gh; ++iy) {
+            const float y = y1 + py * bh + (iy + .5f) * bh / gh;
+            for (int ix = 0; ix < gw; ++ix) {
+              const float x = x1 + px * bw + (ix + .5f) * bw / gw;
+              sum += bilinear_reference(input, n, y, x, c);
+            }
+          }
+          out(r, py, px, c) = sum / count;
+        }
+  }
+  return out;
+}
+
+/**
+ * @brief Create an NHWC tensor filled with uniformly distributed values.
+ */
+static Tensor<float> random_input(size_t n, size_t h, size_t w, size_t c,
+                                  std::mt19937& rng) {
+  Tensor<float> t(Shape{n, h, w, c});
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (size_t i = 0; i < t.numel(); ++i) t[i] = dist(rng);
+  return t;
+}
+
+/**
+ * @brief Create random ROIs, some of which extend past the image border.
+ */
+static Tensor<float> random_rois(size_t count, size_t batch, float h, float w,
+                                 std::mt19937& rng) {
+  Tensor<float> rois(Shape{count, 5});
+  std::uniform_real_distribution<float> ux(-4.f, w + 4.f), uy(-4.f, h + 4.f);
+  for (size_t r = 0; r < count; ++r) {
+    float xa = ux(rng), xb = ux(rng), ya = uy(rng), yb = uy(rng);
+    rois(r, 0) = static_cast<float>(r % batch);
+    rois(r, 1) = std::min(xa, xb);
+    rois(r, 2) = std::min(ya, yb);
+    rois(r, 3) = std::max(xa, xb);
+    rois(r, 4) = std::max(ya, yb);
+  }
+  return rois;
+}
+
+/**
+ * @brief Assert that two tensors have the same shape and close values.
+ */
+static void expect_near(const Tensor<float>& a, const Tensor<float>& b) {
+  ASSERT_EQ(a.shape(), b.shape());
+  for (size_t i = 0; i < a.numel(); ++i)
+    ASSERT_NEAR(a[i], b[i], 1e-5f) << "Mismatch at flat index " << i;
+}
+
+/**
+ * @test
+ * @brief Verifies `roi_align` against the reference for aligned boxes with
+ * adaptive sampling and a channel count that is not a multiple of 8 or 16.
+ */
+TEST(RoiAlignTest, MatchesReferenceAlignedAdaptive) {
+  std::mt19937 rng(1);
+  auto input = random_input(2, 17, 23, 19, rng);
+  auto rois = random_rois(12, 2, 68.f, 92.f, rng);
+  RoiAlignParams p;
+  p.spatial_scale = .25f;
+  expect_near(roi_align(input, rois, p), roi_align_reference(input, rois, p));
+}
+
+/**
+ * @test
+ * @brief Verifies `roi_align` against the reference for unaligned boxes with a
+ * fixed sampling ratio and non-square output.
+ */
+TEST(RoiAlignTest, MatchesReferenceUnalignedFixedRatio) {
+  std::mt19937 rng(2);
+  auto input = random_input(1, 9, 14, 32, rng);
+  auto rois = random_rois(7, 1, 9.f, 14.f, rng);
+  RoiAlignParams p;
+  p.pooled_height = 5;
+  p.pooled_width = 3;
+  p.sampling_ratio = 2;
+  p.aligned = false;
+  expect_near(roi_align(input, rois, p), roi_align_reference(input, rois, p));
+}
+
+/**
+ * @test
+ * @brief Verifies that every SIMD specialization matches the scalar fallback.
+ */
+TEST(RoiAlignTest, SimdMatchesScalar) {
+  std::mt19937 rng(3);
+  auto input = random_input(1, 12, 12, 37, rng);
+  auto rois = random_rois(5, 1, 12.f, 12.f, rng);
+  RoiAlignParams p;
+
+  const CpuFeatures detected = cpu_features();
+  set_cpu_features(CpuFeatures{});
+  auto scalar = roi_align(input, rois, p);
+
+  CpuFeatures avx2_only;
+  avx2_only.avx2 = detected.avx2;
+  avx2_only.fma = detected.fma;
+  set_cpu_features(avx2_only);
+  auto avx2 = roi_align(input, rois, p);
+  reset_cpu_features();
+  auto best = roi_align(input, rois, p);
+
+  expect_near(scalar, avx2);
+  expect_near(scalar, best);
+}
+
+/**
+ * @test
+ * @brief Verifies that parallel execution over ROIs matches the reference.
+ */
+TEST(RoiAlignTest, ParallelOverRois) {
+  std::mt19937 rng(4);
+  auto input = random_input(3, 16, 16, 8, rng);
+  auto rois = random_rois(64, 3, 16.f, 16.f, rng);
+  RoiAlignParams p;
+  p.sampling_ratio = 2;
+
+  set_num_threads(4);
+  auto parallel = roi_align(input, rois, p);
+  set_num_threads(0);
+  expect_near(parallel, roi_align_reference(input, rois, p));
+}
+
+/**
+ * @test
+ * @brief Verifies that mismatched output shapes are rejected.
+ */
+TEST(RoiAlignTest, RejectsBadShapes) {
+  Tensor<float> input(Shape{1, 4, 4, 2});
+  Tensor<float> rois(Shape{1, 5});
+  Tensor<float> output(Shape{1, 7, 7, 3});
+  EXPECT_THROW(roi_align(input, rois, output, RoiAlignParams{}),
+               std::invalid_argument);
+  Tensor<float> bad_rois(Shape{1, 4});
+  EXPECT_THROW(roi_align(input, bad_rois, RoiAlignParams{}),
+               std::invalid_argument);
+}
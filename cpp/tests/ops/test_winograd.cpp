@@ -0,0 +1,126 @@
+/**
+ * @file test_winograd.cpp
+ * @brief Unit tests for the Winograd F(4x4, 3x3) convolution path.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "ops/conv.h"
+#include "ops/winograd.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Naive padded stride-1 3x3 NCHW convolution.
+ */
+static Tensor<float> conv3x3_reference(const Tensor<float>& x,
+                                       const Tensor<float>& wt,
+                                       const Tensor<float>& bias,
+                                       const Conv2dParams& p) {
+  const size_t n = x.dim(0), ci = x.dim(1), h = x.dim(2), w = x.dim(3);
+  const size_t co = wt.dim(0);
+  const size_t oh = conv_output_size(h, 3, 1, p.pad_top, p.pad_bottom, 1);
+  const size_t ow = conv_output_size(w, 3, 1, p.pad_left, p.pad_right, 1);
+  Tensor<float> y(Shape{n, co, oh, ow});
+  for (size_t b = 0; b < n; ++b)
+    for (size_t o = 0; o < co; ++o)
+      for (size_t oy = 0; oy < oh; ++oy)
+        for (size_t ox = 0; ox < ow; ++ox) {
+          double acc = bias.empty() ? 0. : bias[o];
+          for (size_t c = 0; c < ci; ++c)
+            for (size_t ky = 0; ky < 3; ++ky)
+              for (size_t kx = 0; kx < 3; ++kx) {
+                const long iy = long(oy + ky) - long(p.pad_top);
+                const long ix = long(ox + kx) - long(p.pad_left);
+                if (iy < 0 || ix < 0 || iy >= long(h) || ix >= long(w))
+                  continue;
+                acc += double(x(b, c, size_t(iy), size_t(ix))) *
+                       wt(o, c, ky, kx);
+              }
+          y(b, o, oy, ox) = float(acc);
+        }
+  return y;
+}
+
+/**
+ * @brief Compare a Winograd layer against the reference on one shape.
+ */
+static void check(size_t n, size_t ci, size_t co, size_t h, size_t w,
+                  const Conv2dParams& p, bool with_bias = true) {
+  std::mt19937 rng(unsigned(ci * 31 + co + h));
+  const Tensor<float> x = random_tensor(Shape{n, ci, h, w}, rng);
+  const Tensor<float> wt = random_tensor(Shape{co, ci, 3, 3}, rng);
+  const Tensor<float> bias =
+      with_bias ? random_tensor(Shape{co}, rng) : Tensor<float>();
+  const Tensor<float> expected = conv3x3_reference(x, wt, bias, p);
+
+  const Conv2d conv(wt, bias, p, ConvLayout::kNchw, ConvAlgorithm::kWinograd);
+  const Tensor<float> y = conv.forward(x);
+  ASSERT_EQ(y.shape(), expected.shape());
+  const float tol = 2e-4f * float(ci * 9);
+  for (size_t i = 0; i < y.numel(); ++i)
+    ASSERT_NEAR(y[i], expected[i], tol) << "index " << i;
+}
+
+/**
+ * @test
+ * @brief Verifies Winograd against the reference with padding and edges.
+ */
+TEST(WinogradTest, MatchesReference) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  Conv2dParams asym;
+  asym.pad_top = 2;
+  asym.pad_right = 1;
+  check(2, 5, 7, 9, 13, same);
+  check(1, 3, 4, 11, 6, {}, false);  // unpadded, partial tiles
+  check(1, 8, 3, 4, 4, asym);
+  check(1, 1, 1, 3, 3, {});  // a single output pixel
+}
+
+/**
+ * @test
+ * @brief Verifies results span several tile blocks and thread counts.
+ */
+TEST(WinogradTest, MultipleBlocksAndThreads) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  check(1, 48, 48, 100, 100, same);
+  set_num_threads(3);
+  check(3, 16, 24, 21, 18, same);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies automatic selection and rejection of unsupported shapes.
+ */
+TEST(WinogradTest, Selection) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  const Tensor<float> none;
+  EXPECT_EQ(Conv2d(Tensor<float>(Shape{64, 64, 3, 3}), none, same).algorithm(),
+            ConvAlgorithm::kWinograd);
+  EXPECT_EQ(Conv2d(Tensor<float>(Shape{8, 3, 3, 3}), none, same).algorithm(),
+            ConvAlgorithm::kIm2col);
+  Conv2dParams strided = same;
+  strided.stride_h = strided.stride_w = 2;
+  EXPECT_FALSE(winograd_supported(strided, 3, 3));
+  EXPECT_EQ(Conv2d(Tensor<float>(Shape{64, 64, 3, 3}), none, strided)
+                .algorithm(),
+            ConvAlgorithm::kIm2col);
+
+  EXPECT_THROW(Conv2d(Tensor<float>(Shape{4, 4, 3, 3}), none, strided,
+                      ConvLayout::kNchw, ConvAlgorithm::kWinograd),
+               std::invalid_argument);
+  EXPECT_THROW(Conv2d(Tensor<float>(Shape{4, 4, 5, 5}), none, {},
+                      ConvLayout::kNchw, ConvAlgorithm::kWinograd),
+               std::invalid_argument);
+  EXPECT_THROW(Conv2d(Tensor<float>(Shape{4, 4, 3, 3}), none, {},
+                      ConvLayout::kNchwc, ConvAlgorithm::kWinograd),
+               std::invalid_argument);
+  EXPECT_THROW(winograd_transform_weights(Tensor<float>(Shape{4, 4, 1, 1})),
+               std::invalid_argument);
+}
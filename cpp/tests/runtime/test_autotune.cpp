@@ -0,0 +1,224 @@
+/**
+ * @file test_autotune.cpp
+ * @brief Unit tests for the autotuner, its database and tuned plans.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "runtime/autotune.h"
+#include "runtime/plan_cache.h"
+#include "utils/parallel.h"
+
+/**
+ * @brief Temporary database path removed when the test ends.
+ */
+struct TempDatabase {
+  std::string path;
+  explicit TempDatabase(const std::string& name)
+      : path((std::filesystem::temp_directory_path() / name).string()) {
+    std::filesystem::remove(path);
+  }
+  ~TempDatabase() { std::filesystem::remove(path); }
+};
+
+/**
+ * @brief Graph with a Winograd-eligible 3x3 conv (ReLU6 fused), a 1x1 conv
+ * and a 3x3 conv repeating the first layer's geometry.
+ */
+static std::shared_ptr<Graph> tunable_graph(std::mt19937& rng) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  const auto conv = [&](size_t ci, size_t co, size_t k,
+                        const Conv2dParams& p) {
+    return std::make_shared<Conv2dOp>(random_tensor(Shape{co, ci, k, k}, rng),
+                                      random_tensor(Shape{co}, rng), p);
+  };
+  auto g = std::make_shared<Graph>();
+  ValueId x = g->addInput("image");
+  x = g->addNode("conv1", conv(16, 16, 3, same)->withClamp(0.f, 6.f), {x});
+  x = g->addNode("conv2", conv(16, 16, 1, {}), {x});
+  g->addOutput(g->addNode("conv3", conv(16, 16, 3, same), {x}));
+  return g;
+}
+
+/**
+ * @brief Run a graph once on an input with a fresh executor.
+ */
+static Tensor<float> run_once(std::shared_ptr<const Graph> g,
+                              const Tensor<float>& x) {
+  Executor exec(std::move(g), {x.shape()});
+  exec.run({&x, 1});
+  return exec.output(0).clone();
+}
+
+/**
+ * @test
+ * @brief Verifies databases keep one section per CPU model in one file.
+ */
+TEST(AutotuneTest, DatabasePerCpuModel) {
+  EXPECT_FALSE(cpu_model().empty());
+  TempDatabase tmp("vf_tuning_sections.txt");
+  {
+    TuningDatabase xeon(tmp.path, "Intel(R) Xeon(R) Gold 6338");
+    EXPECT_EQ(xeon.size(), 0u);
+    xeon.setGemm({96, 4096});
+    xeon.setConv("nchw:i1x3x8x8:o4", {ConvAlgorithm::kWinograd, 4, 12.5});
+    xeon.save();
+  }
+  {
+    TuningDatabase epyc(tmp.path, "AMD EPYC 7763 64-Core Processor");
+    EXPECT_EQ(epyc.size(), 0u);
+    EXPECT_FALSE(epyc.gemm());
+    epyc.setConv("nchw:i1x3x8x8:o4", {ConvAlgorithm::kIm2col, 8, 9.});
+    epyc.save();
+  }
+  TuningDatabase xeon(tmp.path, "Intel(R) Xeon(R) Gold 6338");
+  ASSERT_EQ(xeon.size(), 1u);
+  ASSERT_TRUE(xeon.gemm());
+  EXPECT_EQ(xeon.gemm()->mc, 96u);
+  const ConvTuning* entry = xeon.findConv("nchw:i1x3x8x8:o4");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->algorithm, ConvAlgorithm::kWinograd);
+  EXPECT_EQ(entry->threads, 4u);
+  EXPECT_DOUBLE_EQ(entry->micros, 12.5);
+  xeon.save();  // rewriting one section keeps the other
+  const TuningDatabase epyc(tmp.path, "AMD EPYC 7763 64-Core Processor");
+  ASSERT_NE(epyc.findConv("nchw:i1x3x8x8:o4"), nullptr);
+  EXPECT_EQ(epyc.findConv("nchw:i1x3x8x8:o4")->algorithm,
+            ConvAlgorithm::kIm2col);
+  EXPECT_EQ(epyc.findConv("other"), nullptr);
+}
+
+/**
+ * @test
+ * @brief Verifies malformed files and misuse are rejected.
+ */
+TEST(AutotuneTest, RejectsInvalidDatabases) {
+  TempDatabase tmp("vf_tuning_invalid.txt");
+  {
+    std::ofstream out(tmp.path);
+    out << "cpu Test CPU\nconv key bogus 1 2\n";
+  }
+  EXPECT_THROW(TuningDatabase(tmp.path, "Test CPU"), std::runtime_error);
+  EXPECT_NO_THROW(TuningDatabase(tmp.path, "Other CPU"));
+  TuningDatabase memory;
+  EXPECT_EQ(memory.cpu(), cpu_model());
+  EXPECT_THROW(memory.save(), std::runtime_error);
+  EXPECT_THROW(memory.setConv("two words", {}), std::invalid_argument);
+
+  std::mt19937 rng(50);
+  const std::shared_ptr<Graph> g = tunable_graph(rng);
+  AutotuneOptions options;
+  options.repeats = 0;
+  EXPECT_THROW(autotune(*g, {Shape{1, 16, 8, 8}}, memory, options),
+               std::invalid_argument);
+  options.repeats = 1;
+  options.thread_counts = {0};
+  EXPECT_THROW(autotune(*g, {Shape{1, 16, 8, 8}}, memory, options),
+               std::invalid_argument);
+  Executor exec(g, {Shape{1, 16, 8, 8}});
+  EXPECT_THROW(exec.setNodeThreads({1}), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies tuning records every distinct layer shape and that tuned
+ * graphs compute the same result.
+ */
+TEST(AutotuneTest, TunesAndAppliesPerShape) {
+  std::mt19937 rng(51);
+  const std::shared_ptr<Graph> g = tunable_graph(rng);
+  const Tensor<float> x = random_tensor(Shape{1, 16, 12, 12}, rng);
+  TuningDatabase db;
+  AutotuneOptions options;
+  options.thread_counts = {1, 2};
+  options.repeats = 1;
+  options.tune_gemm = false;
+  const size_t limit = num_threads();
+  EXPECT_EQ(autotune(*g, {x.shape()}, db, options), 2u);  // conv3 = conv1
+  EXPECT_EQ(num_threads(), limit);
+  EXPECT_EQ(db.size(), 2u);
+  EXPECT_FALSE(db.gemm());
+  EXPECT_EQ(autotune(*g, {x.shape()}, db, options), 0u);
+
+  const auto& conv1 = static_cast<const Conv2dOp&>(*g->nodes()[0].op);
+  const std::string key = conv_tuning_key(conv1, x.shape());
+  EXPECT_EQ(key, "nchw:i1x16x12x12:o16:k3x3:s1x1:p1x1x1x1:d1x1:g1");
+  const ConvTuning* measured = db.findConv(key);
+  ASSERT_NE(measured, nullptr);
+  EXPECT_GT(measured->micros, 0.);
+  EXPECT_TRUE(measured->threads == 1 || measured->threads == 2);
+
+  // Force the algorithm the auto selection did not pick.
+  const ConvAlgorithm other =
+      conv1.conv().algorithm() == ConvAlgorithm::kWinograd
+          ? ConvAlgorithm::kIm2col
+          : ConvAlgorithm::kWinograd;
+  db.setConv(key, {other, 2, 1.});
+  std::vector<size_t> threads;
+  const std::shared_ptr<const Graph> tuned =
+      apply_tuning(g, {x.shape()}, db, &threads);
+  ASSERT_NE(tuned.get(), g.get());
+  const auto& retuned = static_cast<const Conv2dOp&>(*tuned->nodes()[0].op);
+  EXPECT_EQ(retuned.conv().algorithm(), other);
+  EXPECT_EQ(retuned.clampMax(), 6.f);
+  EXPECT_EQ(tuned->nodes()[1].op, g->nodes()[1].op);
+  EXPECT_EQ(tuned->nodes()[2].name, "conv3");
+  ASSERT_EQ(threads.size(), 3u);
+  EXPECT_EQ(threads[0], 2u);
+  EXPECT_EQ(threads[2], 2u);
+
+  const Tensor<float> expected = run_once(g, x);
+  const Tensor<float> actual = run_once(tuned, x);
+  for (size_t i = 0; i < expected.numel(); ++i)
+    ASSERT_NEAR(actual[i], expected[i], 1e-3f);
+
+  // A shape without entries leaves the graph untouched.
+  EXPECT_EQ(apply_tuning(g, {Shape{2, 16, 9, 9}}, db).get(), g.get());
+}
+
+/**
+ * @test
+ * @brief Verifies a plan cache in autotuning mode tunes on first use,
+ * persists the results and reuses them after a restart.
+ */
+TEST(AutotuneTest, PlanCacheTunesOnFirstRun) {
+  std::mt19937 rng(52);
+  const std::shared_ptr<Graph> g = tunable_graph(rng);
+  const Tensor<float> x = random_tensor(Shape{1, 16, 10, 10}, rng);
+  const Tensor<float> expected = run_once(g, x);
+  TempDatabase tmp("vf_tuning_plan_cache.txt");
+  AutotuneOptions options;
+  options.repeats = 1;
+  {
+    PlanCache cache(g);
+    cache.setTuning(std::make_shared<TuningDatabase>(tmp.path), true,
+                    options);
+    const std::shared_ptr<Executor> exec = cache.run({&x, 1});
+    for (size_t i = 0; i < expected.numel(); ++i)
+      ASSERT_NEAR(exec->output(0)[i], expected[i], 1e-3f);
+    EXPECT_EQ(exec->nodeThreads().size(), 3u);
+    EXPECT_EQ(cache.tuning()->size(), 2u);
+  }
+  ASSERT_TRUE(std::filesystem::exists(tmp.path));
+
+  auto db = std::make_shared<TuningDatabase>(tmp.path);
+  ASSERT_EQ(db->size(), 2u);
+  ASSERT_TRUE(db->gemm());
+  EXPECT_EQ(sgemm_blocking().mc, GemmBlocking{}.mc);
+  PlanCache restarted(g);
+  restarted.setTuning(db);
+  const std::shared_ptr<Executor> exec = restarted.run({&x, 1});
+  for (size_t i = 0; i < expected.numel(); ++i)
+    ASSERT_NEAR(exec->output(0)[i], expected[i], 1e-3f);
+  ASSERT_TRUE(exec->gemmBlocking());
+  EXPECT_EQ(exec->gemmBlocking()->mc, db->gemm()->mc);
+  EXPECT_EQ(exec->gemmBlocking()->nc, db->gemm()->nc);
+  EXPECT_EQ(sgemm_blocking().nc, GemmBlocking{}.nc);
+  EXPECT_EQ(db->size(), 2u);
+}
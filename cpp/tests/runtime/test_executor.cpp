@@ -0,0 +1,232 @@
+/**
+ * @file test_executor.cpp
+ * @brief Unit tests for the graph, its operators and the planned executor.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "runtime/executor.h"
+#include "runtime/operators.h"
+#include "utils/numa.h"
+#include "utils/parallel.h"
+
+// The replacement operators below pair operator new with free(), which GCC
+// flags at inlined call sites although the pairing is consistent here.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+/** Number of global operator new calls made by this test binary. */
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t n) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t n, std::align_val_t a) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  const size_t align = size_t(a);
+  if (void* p = std::aligned_alloc(align, (n + align - 1) / align * align))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+/**
+ * @brief Build a stem plus one residual block:
+ * conv-bn-relu-pool, then conv-bn-relu-conv-bn, add, relu.
+ */
+static std::shared_ptr<Graph> residual_graph(std::mt19937& rng) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  const auto conv = [&](size_t ci, size_t co) {
+    return std::make_shared<Conv2dOp>(random_tensor(Shape{co, ci, 3, 3}, rng),
+                                      Tensor<float>(), same);
+  };
+  const auto bn = [&](size_t c) {
+    Tensor<float> var = random_tensor(Shape{c}, rng);
+    for (size_t i = 0; i < c; ++i) var[i] = 1.f + 0.5f * var[i];
+    return std::make_shared<BatchNormOp>(
+        random_tensor(Shape{c}, rng), random_tensor(Shape{c}, rng),
+        random_tensor(Shape{c}, rng), var);
+  };
+  auto g = std::make_shared<Graph>();
+  const auto relu = std::make_shared<ReluOp>();
+  ValueId x = g->addInput("image");
+  x = g->addNode("stem_conv", conv(3, 16), {x});
+  x = g->addNode("stem_bn", bn(16), {x});
+  x = g->addNode("stem_relu", relu, {x});
+  const ValueId skip =
+      g->addNode("pool", std::make_shared<MaxPool2dOp>(3, 2, 1), {x});
+  x = g->addNode("conv1", conv(16, 16), {skip});
+  x = g->addNode("bn1", bn(16), {x});
+  x = g->addNode("relu1", relu, {x});
+  x = g->addNode("conv2", conv(16, 16), {x});
+  x = g->addNode("bn2", bn(16), {x});
+  x = g->addNode("add", std::make_shared<AddOp>(), {x, skip});
+  g->addOutput(g->addNode("relu2", relu, {x}));
+  return g;
+}
+
+/**
+ * @brief Run a graph node by node with a freshly allocated output each.
+ */
+static Tensor<float> run_eager(const Graph& g, const Tensor<float>& input) {
+  std::vector<Tensor<float>> values(g.numValues());
+  values[g.inputs()[0]] = input;
+  for (const Node& node : g.nodes()) {
+    std::vector<const Tensor<float>*> args;
+    std::vector<Shape> shapes;
+    for (ValueId v : node.inputs) {
+      args.push_back(&values[v]);
+      shapes.push_back(values[v].shape());
+    }
+    values[node.output] = Tensor<float>(node.op->outputShape(shapes));
+    node.op->forward(args, values[node.output]);
+  }
+  return values[g.outputs()[0]];
+}
+
+/**
+ * @test
+ * @brief Verifies planned execution matches eager execution.
+ */
+TEST(ExecutorTest, MatchesEagerExecution) {
+  std::mt19937 rng(5);
+  const std::shared_ptr<Graph> g = residual_graph(rng);
+  const Tensor<float> x = random_tensor(Shape{2, 3, 20, 18}, rng);
+  Executor exec(g, {x.shape()});
+  EXPECT_EQ(exec.shape(g->outputs()[0]), (Shape{2, 16, 10, 9}));
+  const Tensor<float> expected = run_eager(*g, x);
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    exec.run({&x, 1});
+    const Tensor<float>& y = exec.output(0);
+    ASSERT_EQ(y.shape(), expected.shape());
+    for (size_t i = 0; i < y.numel(); ++i) ASSERT_FLOAT_EQ(y[i], expected[i]);
+  }
+
+  // Same results with the arena placed on a NUMA node.
+  Executor local(g, {x.shape()}, int(numa_nodes().front().id));
+  local.run({&x, 1});
+  for (size_t i = 0; i < expected.numel(); ++i)
+    ASSERT_FLOAT_EQ(local.output(0)[i], expected[i]);
+}
+
+/**
+ * @test
+ * @brief Verifies intermediates share memory and runs do not allocate.
+ */
+TEST(ExecutorTest, PlannedArenaWithoutAllocations) {
+  std::mt19937 rng(6);
+  const std::shared_ptr<Graph> g = residual_graph(rng);
+  const Tensor<float> x = random_tensor(Shape{1, 3, 64, 64}, rng);
+  set_num_threads(1);
+  Executor exec(g, {x.shape()});
+  size_t total = 0;
+  for (const Node& node : g->nodes())
+    total += exec.shape(node.output).numel() * sizeof(float);
+  EXPECT_LT(exec.plan().arena_bytes, total / 2);
+  EXPECT_GE(exec.plan().arena_bytes, exec.plan().peak_live_bytes);
+
+  exec.run({&x, 1});  // warm up operator scratch buffers
+  const size_t before = g_allocations.load();
+  for (int i = 0; i < 3; ++i) exec.run({&x, 1});
+  EXPECT_EQ(g_allocations.load(), before);
+  set_num_threads(0);
+}
+
+/**
+ * @class ThreadProbeOp
+ * @brief Operator writing the thread limit and GEMM row blocking it runs
+ * with into its two outputs.
+ */
+class ThreadProbeOp : public Operator {
+ public:
+  const char* type() const override { return "ThreadProbe"; }
+
+  Shape outputShape(std::span<const Shape>) const override {
+    return Shape{2};
+  }
+
+  void forward(std::span<const Tensor<float>* const>,
+               Tensor<float>& output) const override {
+    output[0] = float(num_threads());
+    output[1] = float(sgemm_blocking().mc);
+  }
+};
+
+/**
+ * @test
+ * @brief Verifies per-node thread limits and the executor's GEMM blocking
+ * apply inside run() only, leaving the process-wide settings alone.
+ */
+TEST(ExecutorTest, NodeSettingsAreScopedToRun) {
+  auto g = std::make_shared<Graph>();
+  const ValueId x = g->addInput("x");
+  const ValueId capped =
+      g->addNode("capped", std::make_shared<ThreadProbeOp>(), {x});
+  const ValueId free =
+      g->addNode("free", std::make_shared<ThreadProbeOp>(), {capped});
+  g->addOutput(capped);
+  g->addOutput(free);
+  Executor exec(g, {Shape{1}});
+  exec.setNodeThreads({1, 0});
+  exec.setGemmBlocking(GemmBlocking{48, 1024});
+  EXPECT_THROW(exec.setGemmBlocking(GemmBlocking{0, 1024}),
+               std::invalid_argument);
+
+  set_num_threads(3);
+  const Tensor<float> in(Shape{1});
+  exec.run({&in, 1});
+  EXPECT_EQ(exec.output(0)[0], 1.f);
+  EXPECT_EQ(exec.output(0)[1], 48.f);
+  EXPECT_EQ(exec.output(1)[0], 3.f);
+  EXPECT_EQ(exec.output(1)[1], 48.f);
+  EXPECT_EQ(num_threads(), 3u);
+  EXPECT_EQ(sgemm_blocking().mc, GemmBlocking{}.mc);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies graph construction and shape errors.
+ */
+TEST(ExecutorTest, RejectsInvalidGraphs) {
+  Graph g;
+  const ValueId a = g.addInput("a");
+  const ValueId b = g.addInput("b");
+  EXPECT_THROW(g.addNode("bad", nullptr, {a}), std::invalid_argument);
+  EXPECT_THROW(g.addNode("bad", std::make_shared<ReluOp>(), {7}),
+               std::invalid_argument);
+  g.addOutput(g.addNode("sum", std::make_shared<AddOp>(), {a, b}));
+  EXPECT_THROW(g.addOutput(42), std::invalid_argument);
+  const auto shared = std::make_shared<Graph>(g);
+  EXPECT_THROW(Executor(shared, {Shape{2, 3}, Shape{3, 2}}),
+               std::invalid_argument);
+  EXPECT_THROW(Executor(shared, {Shape{2, 3}}), std::invalid_argument);
+
+  Executor exec(shared, {Shape{2, 3}, Shape{2, 3}});
+  const Tensor<float> wrong[] = {Tensor<float>(Shape{2, 3}),
+                                 Tensor<float>(Shape{3, 3})};
+  EXPECT_THROW(exec.run(wrong), std::invalid_argument);
+  Tensor<float> in[] = {Tensor<float>(Shape{2, 3}), Tensor<float>(Shape{2, 3})};
+  in[0].fill(1.f);
+  in[1].fill(2.f);
+  exec.run(in);
+  EXPECT_EQ(exec.output(0)(1, 2), 3.f);
+  EXPECT_THROW(MaxPool2dOp(2, 2, 2), std::invalid_argument);
+}
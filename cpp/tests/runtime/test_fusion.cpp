@@ -0,0 +1,118 @@
+/**
+ * @file test_fusion.cpp
+ * @brief Unit tests for the conv/batch-norm/elementwise fusion pass.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "runtime/executor.h"
+#include "runtime/fusion.h"
+#include "runtime/operators.h"
+
+/**
+ * @brief Random batch norm over @p c channels with positive variance.
+ */
+static std::shared_ptr<BatchNormOp> random_bn(size_t c, std::mt19937& rng) {
+  Tensor<float> var = random_tensor(Shape{c}, rng);
+  for (size_t i = 0; i < c; ++i) var[i] = 1.f + 0.5f * var[i];
+  return std::make_shared<BatchNormOp>(random_tensor(Shape{c}, rng),
+                                       random_tensor(Shape{c}, rng),
+                                       random_tensor(Shape{c}, rng), var);
+}
+
+/**
+ * @brief Run a graph once and copy its first output.
+ */
+static Tensor<float> run(const Graph& g, const Tensor<float>& x) {
+  Executor exec(std::make_shared<Graph>(g), {x.shape()});
+  exec.run({&x, 1});
+  return exec.output(0).clone();
+}
+
+/**
+ * @test
+ * @brief Verifies fused chains and unchanged results on a residual network.
+ */
+TEST(FusionTest, FusesConvChainsAndPreservesResults) {
+  std::mt19937 rng(9);
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  const auto conv = [&](size_t ci, size_t co, ConvAlgorithm algorithm) {
+    return std::make_shared<Conv2dOp>(random_tensor(Shape{co, ci, 3, 3}, rng),
+                                      random_tensor(Shape{co}, rng), same,
+                                      ConvLayout::kNchw, algorithm);
+  };
+  const auto relu = std::make_shared<ReluOp>();
+  Graph g;
+  ValueId x = g.addInput("x");
+  x = g.addNode("c1", conv(8, 16, ConvAlgorithm::kIm2col), {x});
+  x = g.addNode("b1", random_bn(16, rng), {x});
+  const ValueId r1 = g.addNode("r1", relu, {x});
+  x = g.addNode("c2", conv(16, 16, ConvAlgorithm::kWinograd), {r1});
+  x = g.addNode("b2", random_bn(16, rng), {x});
+  x = g.addNode("a2", std::make_shared<AddOp>(), {r1, x});
+  x = g.addNode("r2", relu, {x});
+  const ValueId p = g.addNode("pool", std::make_shared<MaxPool2dOp>(2, 2), {x});
+  x = g.addNode("c3", conv(16, 16, ConvAlgorithm::kAuto), {p});
+  x = g.addNode("k3", std::make_shared<ClipOp>(0.f, 6.f), {x});
+  x = g.addNode("a3", std::make_shared<AddOp>(), {x, p});
+  g.addOutput(g.addNode("r3", relu, {x}));
+
+  FusionStats stats;
+  const Graph fused = fuse_graph(g, &stats);
+  EXPECT_EQ(stats.folded_batch_norms, 2u);
+  EXPECT_EQ(stats.fused_residuals, 1u);
+  EXPECT_EQ(stats.fused_activations, 4u);
+  ASSERT_EQ(fused.nodes().size(), 5u);
+  EXPECT_EQ(fused.nodes()[0].name, "r1");
+  EXPECT_EQ(fused.nodes()[1].name, "r2");
+  EXPECT_EQ(fused.nodes()[1].inputs.size(), 2u);
+  EXPECT_EQ(fused.nodes()[4].name, "r3");
+  EXPECT_STREQ(fused.nodes()[4].op->type(), "Add");
+
+  const Tensor<float> input = random_tensor(Shape{2, 8, 12, 10}, rng);
+  const Tensor<float> expected = run(g, input);
+  const Tensor<float> actual = run(fused, input);
+  ASSERT_EQ(actual.shape(), expected.shape());
+  for (size_t i = 0; i < actual.numel(); ++i)
+    ASSERT_NEAR(actual[i], expected[i], 2e-3f) << "index " << i;
+}
+
+/**
+ * @test
+ * @brief Verifies values with outside readers are never fused away.
+ */
+TEST(FusionTest, StopsAtSharedAndOutputValues) {
+  std::mt19937 rng(10);
+  const auto relu = std::make_shared<ReluOp>();
+  Graph g;
+  ValueId x = g.addInput("x");
+  const ValueId c = g.addNode(
+      "c", std::make_shared<Conv2dOp>(random_tensor(Shape{4, 4, 1, 1}, rng),
+                                      Tensor<float>(), Conv2dParams{}),
+      {x});
+  const ValueId b = g.addNode("b", random_bn(4, rng), {c});
+  const ValueId r = g.addNode("r", relu, {b});
+  g.addOutput(b);
+  g.addOutput(r);
+
+  FusionStats stats;
+  const Graph fused = fuse_graph(g, &stats);
+  EXPECT_EQ(stats.folded_batch_norms, 1u);
+  EXPECT_EQ(stats.fused_activations, 0u);
+  ASSERT_EQ(fused.nodes().size(), 2u);
+  EXPECT_EQ(fused.valueName(fused.outputs()[0]), "b");
+  EXPECT_EQ(fused.valueName(fused.outputs()[1]), "r");
+
+  const Tensor<float> input = random_tensor(Shape{1, 4, 3, 3}, rng);
+  Executor a(std::make_shared<Graph>(g), {input.shape()});
+  Executor f(std::make_shared<Graph>(fused), {input.shape()});
+  a.run({&input, 1});
+  f.run({&input, 1});
+  for (size_t o = 0; o < 2; ++o)
+    for (size_t i = 0; i < input.numel(); ++i)
+      EXPECT_NEAR(a.output(o)[i], f.output(o)[i], 1e-5f);
+}
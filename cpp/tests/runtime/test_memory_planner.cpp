@@ -0,0 +1,91 @@
+/**
+ * @file test_memory_planner.cpp
+ * @brief Unit tests for the greedy-by-size arena planner.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "runtime/memory_planner.h"
+
+/**
+ * @brief Check that no two tensors live at the same time share bytes.
+ */
+static void expect_valid(const std::vector<TensorLifetime>& tensors,
+                         const MemoryPlan& plan, size_t alignment) {
+  ASSERT_EQ(plan.offsets.size(), tensors.size());
+  size_t total = 0;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(plan.offsets[i] % alignment, 0u);
+    EXPECT_LE(plan.offsets[i] + tensors[i].bytes, plan.arena_bytes);
+    total += (tensors[i].bytes + alignment - 1) / alignment * alignment;
+    for (size_t j = 0; j < i; ++j) {
+      const TensorLifetime& a = tensors[i];
+      const TensorLifetime& b = tensors[j];
+      if (a.last < b.first || b.last < a.first) continue;
+      const bool disjoint = plan.offsets[i] + a.bytes <= plan.offsets[j] ||
+                            plan.offsets[j] + b.bytes <= plan.offsets[i];
+      EXPECT_TRUE(disjoint) << "tensors " << i << " and " << j;
+    }
+  }
+  EXPECT_GE(plan.arena_bytes, plan.peak_live_bytes);
+  EXPECT_LE(plan.arena_bytes, total);
+}
+
+/**
+ * @test
+ * @brief Verifies that a chain of layers reuses memory ping-pong style.
+ */
+TEST(MemoryPlannerTest, ChainReusesMemory) {
+  const std::vector<TensorLifetime> chain = {
+      {1000, 0, 1}, {1000, 1, 2}, {1000, 2, 3}, {1000, 3, 4}, {500, 4, 5}};
+  const MemoryPlan plan = plan_memory(chain, 64);
+  expect_valid(chain, plan, 64);
+  EXPECT_EQ(plan.arena_bytes, 2048u);
+  EXPECT_EQ(plan.peak_live_bytes, 2048u);
+  EXPECT_EQ(plan.offsets[0], plan.offsets[2]);
+}
+
+/**
+ * @test
+ * @brief Verifies that small tensors fill gaps left between large ones.
+ */
+TEST(MemoryPlannerTest, FillsGaps) {
+  // A long-lived tensor pinned above a short one leaves a gap that a later
+  // small tensor can use.
+  const std::vector<TensorLifetime> tensors = {
+      {4096, 0, 1}, {4096, 0, 5}, {1024, 3, 4}, {2048, 4, 5}};
+  const MemoryPlan plan = plan_memory(tensors, 64);
+  expect_valid(tensors, plan, 64);
+  EXPECT_EQ(plan.arena_bytes, plan.peak_live_bytes);
+}
+
+/**
+ * @test
+ * @brief Verifies random lifetimes never overlap in memory.
+ */
+TEST(MemoryPlannerTest, RandomLifetimes) {
+  std::mt19937 rng(3);
+  for (int trial = 0; trial < 20; ++trial) {
+    std::vector<TensorLifetime> tensors(60);
+    for (TensorLifetime& t : tensors) {
+      t.bytes = 1 + rng() % 100000;
+      t.first = rng() % 50;
+      t.last = t.first + rng() % 8;
+    }
+    const MemoryPlan plan = plan_memory(tensors, 128);
+    expect_valid(tensors, plan, 128);
+    EXPECT_LE(double(plan.arena_bytes), 1.5 * double(plan.peak_live_bytes));
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies rejection of invalid lifetimes and alignments.
+ */
+TEST(MemoryPlannerTest, RejectsInvalidInput) {
+  EXPECT_THROW(plan_memory({{10, 3, 2}}), std::invalid_argument);
+  EXPECT_THROW(plan_memory({{10, 0, 1}}, 48), std::invalid_argument);
+  EXPECT_EQ(plan_memory({}).arena_bytes, 0u);
+}
@@ -0,0 +1,400 @@
+/**
+ * @file test_onnx.cpp
+ * @brief Unit tests for the ONNX model importer.
+ *
+ * Models are encoded in the test with a minimal protobuf writer, imported,
+ * and run through the executor; results are compared with a direct
+ * implementation of the same network.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/test_utils.hpp"
+#include "ops/conv.h"
+#include "runtime/executor.h"
+#include "runtime/fusion.h"
+#include "runtime/onnx.h"
+
+/**
+ * @brief Minimal protocol buffers encoder for building test models.
+ */
+struct Proto {
+  std::string bytes;
+
+  Proto& varint(uint32_t field, uint64_t v) {
+    key(field, 0);
+    raw_varint(v);
+    return *this;
+  }
+  Proto& str(uint32_t field, std::string_view s) {
+    key(field, 2);
+    raw_varint(s.size());
+    bytes += s;
+    return *this;
+  }
+  Proto& msg(uint32_t field, const Proto& m) { return str(field, m.bytes); }
+  Proto& f32(uint32_t field, float v) {
+    key(field, 5);
+    bytes.append(reinterpret_cast<const char*>(&v), 4);
+    return *this;
+  }
+
+ private:
+  void key(uint32_t field, uint32_t wire) { raw_varint(field << 3 | wire); }
+  void raw_varint(uint64_t v) {
+    for (; v >= 0x80; v >>= 7) bytes += char((v & 0x7f) | 0x80);
+    bytes += char(v);
+  }
+};
+
+/**
+ * @brief Encode a float TensorProto (raw data).
+ */
+static Proto float_tensor(const std::string& name, const Tensor<float>& t) {
+  Proto p;
+  for (size_t d = 0; d < t.rank(); ++d) p.varint(1, t.dim(d));
+  p.varint(2, 1).str(8, name);
+  p.str(9, {reinterpret_cast<const char*>(t.data()), t.numel() * 4});
+  return p;
+}
+
+/**
+ * @brief Encode an int64 TensorProto (unpacked int64_data).
+ */
+static Proto int_tensor(const std::string& name, std::vector<int64_t> dims,
+                        std::vector<int64_t> values) {
+  Proto p;
+  for (int64_t d : dims) p.varint(1, uint64_t(d));
+  p.varint(2, 7).str(8, name);
+  for (int64_t v : values) p.varint(7, uint64_t(v));
+  return p;
+}
+
+static Proto attr_int(const std::string& name, int64_t v) {
+  return Proto().str(1, name).varint(3, uint64_t(v)).varint(20, 2);
+}
+
+static Proto attr_float(const std::string& name, float v) {
+  return Proto().str(1, name).f32(2, v).varint(20, 1);
+}
+
+static Proto attr_ints(const std::string& name, std::vector<int64_t> v) {
+  Proto p;
+  p.str(1, name);
+  for (int64_t x : v) p.varint(8, uint64_t(x));
+  return p.varint(20, 7);
+}
+
+/**
+ * @brief Encode a NodeProto.
+ */
+static Proto node(const std::string& op, std::vector<std::string> inputs,
+                  const std::string& output, std::vector<Proto> attrs = {}) {
+  Proto p;
+  for (const std::string& i : inputs) p.str(1, i);
+  p.str(2, output).str(3, output + "_node").str(4, op);
+  for (const Proto& a : attrs) p.msg(5, a);
+  return p;
+}
+
+/**
+ * @brief Encode a float ValueInfoProto (-1 dims become symbolic).
+ */
+static Proto value_info(const std::string& name, std::vector<int64_t> dims) {
+  Proto shape;
+  for (int64_t d : dims)
+    shape.msg(1, d < 0 ? Proto().str(2, "N") : Proto().varint(1, uint64_t(d)));
+  const Proto tensor = Proto().varint(1, 1).msg(2, shape);
+  return Proto().str(1, name).msg(2, Proto().msg(1, tensor));
+}
+
+/**
+ * @brief Encode a ModelProto around a GraphProto.
+ */
+static std::vector<uint8_t> model(const Proto& graph, int64_t opset = 13) {
+  Proto m;
+  m.varint(1, 8).msg(8, Proto().str(1, "").varint(2, uint64_t(opset)));
+  m.msg(7, graph);
+  return {m.bytes.begin(), m.bytes.end()};
+}
+
+/**
+ * @brief Weights of the small detector-style test network.
+ */
+struct TestNet {
+  Tensor<float> w, b, gamma, beta, mean, var, offset, fc_w, fc_b;
+
+  explicit TestNet(std::mt19937& rng)
+      : w(random_tensor(Shape{4, 3, 3, 3}, rng)),
+        b(random_tensor(Shape{4}, rng)),
+        gamma(random_tensor(Shape{4}, rng)),
+        beta(random_tensor(Shape{4}, rng)),
+        mean(random_tensor(Shape{4}, rng)),
+        var(random_tensor(Shape{4}, rng)),
+        offset(random_tensor(Shape{1, 8, 1, 1}, rng)),
+        fc_w(random_tensor(Shape{5, 8}, rng)),
+        fc_b(random_tensor(Shape{5}, rng)) {
+    for (size_t i = 0; i < 4; ++i) var[i] = 1.f + 0.5f * var[i];
+  }
+
+  /**
+   * @brief Encode the network as an ONNX model.
+   *
+   * conv -> bn -> relu -> maxpool -> resize x2 -> SiLU, concatenated with
+   * the relu output, plus a per-channel constant, global average pool, a
+   * reshape whose target is computed by a Shape/Gather/Unsqueeze/Concat
+   * chain, and a Gemm.
+   */
+  std::vector<uint8_t> encode() const {
+    Proto g;
+    g.msg(1, node("Conv", {"x", "w", "b"}, "c",
+                  {attr_ints("pads", {1, 1, 1, 1}),
+                   attr_ints("kernel_shape", {3, 3})}));
+    g.msg(1, node("BatchNormalization", {"c", "gamma", "beta", "mean", "var"},
+                  "n", {attr_float("epsilon", 1e-3f)}));
+    g.msg(1, node("Relu", {"n"}, "r"));
+    g.msg(1, node("MaxPool", {"r"}, "p",
+                  {attr_ints("kernel_shape", {2, 2}),
+                   attr_ints("strides", {2, 2})}));
+    g.msg(1, node("Constant", {}, "scales",
+                  {Proto().str(1, "value").varint(20, 4).msg(
+                      5, float_tensor("", scales()))}));
+    g.msg(1, node("Resize", {"p", "", "scales"}, "u"));
+    g.msg(1, node("Sigmoid", {"u"}, "s"));
+    g.msg(1, node("Mul", {"u", "s"}, "m"));
+    g.msg(1, node("Concat", {"m", "r"}, "k", {attr_int("axis", 1)}));
+    g.msg(1, node("Add", {"k", "offset"}, "a"));
+    g.msg(1, node("GlobalAveragePool", {"a"}, "gap"));
+    g.msg(1, node("Shape", {"gap"}, "shape"));
+    g.msg(1, node("Gather", {"shape", "zero"}, "batch",
+                  {attr_int("axis", 0)}));
+    g.msg(1, node("Unsqueeze", {"batch", "axes"}, "batch1"));
+    g.msg(1, node("Concat", {"batch1", "minus_one"}, "target",
+                  {attr_int("axis", 0)}));
+    g.msg(1, node("Reshape", {"gap", "target"}, "flat"));
+    g.msg(1, node("Dropout", {"flat"}, "drop"));
+    g.msg(1, node("Gemm", {"drop", "fc_w", "fc_b"}, "y",
+                  {attr_int("transB", 1)}));
+    g.str(2, "test_net");
+    for (const auto& [name, t] :
+         {std::pair{"w", w}, {"b", b}, {"gamma", gamma}, {"beta", beta},
+          {"mean", mean}, {"var", var}, {"offset", offset}, {"fc_w", fc_w},
+          {"fc_b", fc_b}})
+      g.msg(5, float_tensor(name, t));
+    g.msg(5, int_tensor("zero", {}, {0}));
+    g.msg(5, int_tensor("axes", {1}, {0}));
+    g.msg(5, int_tensor("minus_one", {1}, {-1}));
+    g.msg(11, value_info("x", {-1, 3, 8, 8}));
+    g.msg(11, value_info("w", {4, 3, 3, 3}));  // initializer listed as input
+    g.msg(12, value_info("y", {-1, 5}));
+    return model(g);
+  }
+
+  static Tensor<float> scales() {
+    Tensor<float> s(Shape{4});
+    s[0] = s[1] = 1.f;
+    s[2] = s[3] = 2.f;
+    return s;
+  }
+
+  /**
+   * @brief Compute the network directly on [N, 3, 8, 8] input.
+   */
+  Tensor<float> reference(const Tensor<float>& x) const {
+    Conv2dParams same;
+    same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+    Tensor<float> r = Conv2d(w, b, same).forward(x);
+    const size_t n = x.dim(0);
+    for (size_t i = 0; i < r.numel(); ++i) {
+      const size_t c = i / 64 % 4;
+      const float v = (r[i] - mean[c]) / std::sqrt(var[c] + 1e-3f) * gamma[c] +
+                      beta[c];
+      r[i] = std::max(v, 0.f);
+    }
+    Tensor<float> y(Shape{n, 5});
+    for (size_t bi = 0; bi < n; ++bi) {
+      float gap[8];
+      for (size_t c = 0; c < 8; ++c) {
+        double sum = 0.;
+        for (size_t yy = 0; yy < 8; ++yy)
+          for (size_t xx = 0; xx < 8; ++xx) {
+            float v;
+            if (c < 4) {  // SiLU of the upsampled 2x2 max
+              const size_t py = yy / 2 * 2, px = xx / 2 * 2;
+              const float u = std::max(
+                  std::max(r(bi, c, py, px), r(bi, c, py, px + 1)),
+                  std::max(r(bi, c, py + 1, px), r(bi, c, py + 1, px + 1)));
+              v = u / (1.f + std::exp(-u));
+            } else {
+              v = r(bi, c - 4, yy, xx);
+            }
+            sum += v + offset[c];
+          }
+        gap[c] = float(sum / 64.);
+      }
+      for (size_t o = 0; o < 5; ++o) {
+        float acc = fc_b[o];
+        for (size_t c = 0; c < 8; ++c) acc += gap[c] * fc_w(o, c);
+        y(bi, o) = acc;
+      }
+    }
+    return y;
+  }
+};
+
+/**
+ * @brief Run an imported model once and copy its first output.
+ */
+static Tensor<float> run(const OnnxModel& m, const Tensor<float>& x) {
+  Executor exec(m.graph, m.input_shapes);
+  exec.run({&x, 1});
+  return exec.output(0).clone();
+}
+
+/**
+ * @test
+ * @brief Verifies an imported network against a direct implementation.
+ */
+TEST(OnnxTest, ImportsAndMatchesReference) {
+  std::mt19937 rng(4);
+  const TestNet net(rng);
+  const std::vector<uint8_t> bytes = net.encode();
+
+  const OnnxModel m = import_onnx(bytes);
+  EXPECT_EQ(m.opset, 13);
+  ASSERT_EQ(m.input_shapes.size(), 1u);
+  EXPECT_EQ(m.input_shapes[0], (Shape{1, 3, 8, 8}));  // symbolic batch
+  EXPECT_EQ(m.folded_nodes, 4u);  // Shape, Gather, Unsqueeze, Concat
+  for (const Node& n : m.graph->nodes())
+    EXPECT_STRNE(n.op->type(), "Constant");
+  const Tensor<float> x = random_tensor(Shape{1, 3, 8, 8}, rng);
+  const Tensor<float> expected = net.reference(x);
+  const Tensor<float> y = run(m, x);
+  ASSERT_EQ(y.shape(), expected.shape());
+  for (size_t i = 0; i < y.numel(); ++i) EXPECT_NEAR(y[i], expected[i], 1e-4f);
+
+  // Explicit shapes re-specialize the graph, and it survives fusion.
+  OnnxImportOptions options;
+  options.input_shapes = {Shape{2, 3, 8, 8}};
+  OnnxModel batch = import_onnx(bytes, options);
+  FusionStats stats;
+  batch.graph = std::make_shared<Graph>(fuse_graph(*batch.graph, &stats));
+  EXPECT_EQ(stats.folded_batch_norms, 1u);
+  EXPECT_EQ(stats.fused_activations, 1u);
+  const Tensor<float> x2 = random_tensor(Shape{2, 3, 8, 8}, rng);
+  const Tensor<float> expected2 = net.reference(x2);
+  const Tensor<float> y2 = run(batch, x2);
+  ASSERT_EQ(y2.shape(), (Shape{2, 5}));
+  for (size_t i = 0; i < y2.numel(); ++i)
+    EXPECT_NEAR(y2[i], expected2[i], 1e-4f);
+}
+
+/**
+ * @test
+ * @brief Verifies constant folding of float subgraphs and constant inputs.
+ */
+TEST(OnnxTest, FoldsConstants) {
+  std::mt19937 rng(5);
+  const Tensor<float> a = random_tensor(Shape{2, 3}, rng);
+  Proto g;
+  g.msg(1, node("Transpose", {"a"}, "at"));                 // folded
+  g.msg(1, node("Mul", {"at", "two"}, "a2"));               // folded
+  g.msg(1, node("Sub", {"x", "a2"}, "d"));                  // same shape
+  g.msg(1, node("Concat", {"d", "a2"}, "y", {attr_int("axis", 0)}));
+  g.msg(5, float_tensor("a", a));
+  Tensor<float> two(Shape{});
+  two[0] = 2.f;
+  g.msg(5, float_tensor("two", two));
+  g.msg(11, value_info("x", {3, 2}));
+  g.msg(12, value_info("y", {6, 2}));
+  // Sub of two same-shape values is not supported; use Add with -2a.
+  EXPECT_THROW(import_onnx(model(g)), std::invalid_argument);
+
+  Proto h;
+  h.msg(1, node("Transpose", {"a"}, "at"));
+  h.msg(1, node("Mul", {"at", "minus_two"}, "a2"));
+  h.msg(1, node("Add", {"x", "a2"}, "d"));
+  h.msg(1, node("Concat", {"d", "a2"}, "y", {attr_int("axis", 0)}));
+  h.msg(5, float_tensor("a", a));
+  two[0] = -2.f;
+  h.msg(5, float_tensor("minus_two", two));
+  h.msg(11, value_info("x", {3, 2}));
+  h.msg(12, value_info("y", {6, 2}));
+  const OnnxModel m = import_onnx(model(h));
+  EXPECT_EQ(m.folded_nodes, 2u);
+  ASSERT_EQ(m.graph->nodes().size(), 3u);  // Constant, Add, Concat
+  const Tensor<float> x = random_tensor(Shape{3, 2}, rng);
+  const Tensor<float> y = run(m, x);
+  ASSERT_EQ(y.shape(), (Shape{6, 2}));
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_FLOAT_EQ(y(i, j), x(i, j) - 2.f * a(j, i));
+      EXPECT_FLOAT_EQ(y(i + 3, j), -2.f * a(j, i));
+    }
+}
+
+/**
+ * @test
+ * @brief Verifies rejection of malformed and unsupported models.
+ */
+TEST(OnnxTest, RejectsInvalidModels) {
+  const std::vector<uint8_t> garbage = {0x3a, 0x10, 0x01};
+  EXPECT_THROW(import_onnx(garbage), std::runtime_error);
+  const std::string no_graph = Proto().varint(1, 8).bytes;
+  EXPECT_THROW(import_onnx({reinterpret_cast<const uint8_t*>(no_graph.data()),
+                            no_graph.size()}),
+               std::runtime_error);
+
+  Proto g;
+  g.msg(1, node("Softmax", {"x"}, "y"));
+  g.msg(11, value_info("x", {1, 4}));
+  g.msg(12, value_info("y", {1, 4}));
+  try {
+    import_onnx(model(g));
+    FAIL() << "expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_NE(std::string(e.what()).find("y_node"), std::string::npos);
+    EXPECT_NE(std::string(e.what()).find("Softmax"), std::string::npos);
+  }
+
+  Proto h;
+  h.msg(1, node("Relu", {"x"}, "y"));
+  h.msg(11, Proto().str(1, "x"));  // no shape declared
+  h.msg(12, value_info("y", {1, 4}));
+  EXPECT_THROW(import_onnx(model(h)), std::invalid_argument);
+  OnnxImportOptions options;
+  options.input_shapes = {Shape{1, 4}};
+  EXPECT_EQ(import_onnx(model(h), options).graph->nodes().size(), 1u);
+  options.input_shapes.push_back(Shape{1});
+  EXPECT_THROW(import_onnx(model(h), options), std::invalid_argument);
+  EXPECT_THROW(import_onnx_file("/nonexistent/model.onnx"), std::system_error);
+
+  // Initializer dims are checked against the payload before allocating.
+  const auto with_initializer = [](const Proto& tensor) {
+    Proto g;
+    g.msg(1, node("Relu", {"x"}, "y"));
+    g.msg(5, tensor);
+    g.msg(11, value_info("x", {1, 4}));
+    g.msg(12, value_info("y", {1, 4}));
+    return model(g);
+  };
+  const std::string four_bytes(4, '\0');
+  Proto huge;  // 2^40 floats backed by one
+  huge.varint(1, 1u << 20).varint(1, 1u << 20).varint(2, 1).str(8, "w");
+  EXPECT_THROW(import_onnx(with_initializer(huge.str(9, four_bytes))),
+               std::runtime_error);
+  Proto overflow;  // 2^120 elements
+  for (int d = 0; d < 3; ++d) overflow.varint(1, uint64_t(1) << 40);
+  overflow.varint(2, 1).str(8, "w").str(9, four_bytes);
+  EXPECT_THROW(import_onnx(with_initializer(overflow)), std::invalid_argument);
+  Proto negative;
+  negative.varint(1, uint64_t(-1)).varint(2, 1).str(8, "w");
+  EXPECT_THROW(import_onnx(with_initializer(negative.str(9, four_bytes))),
+               std::invalid_argument);
+}
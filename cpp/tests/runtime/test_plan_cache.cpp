@@ -0,0 +1,164 @@
+/**
+ * @file test_plan_cache.cpp
+ * @brief Unit tests for the shape-specialized plan cache.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "runtime/operators.h"
+#include "runtime/plan_cache.h"
+
+/**
+ * @brief Fully convolutional graph accepting any spatial size:
+ * conv-relu, strided conv, global average pool.
+ */
+static std::shared_ptr<Graph> backbone(std::mt19937& rng) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  Conv2dParams down = same;
+  down.stride_h = down.stride_w = 2;
+  auto g = std::make_shared<Graph>();
+  ValueId x = g->addInput("image");
+  x = g->addNode("conv1",
+                 std::make_shared<Conv2dOp>(
+                     random_tensor(Shape{8, 3, 3, 3}, rng),
+                     random_tensor(Shape{8}, rng), same),
+                 {x});
+  x = g->addNode("relu", std::make_shared<ReluOp>(), {x});
+  x = g->addNode("conv2",
+                 std::make_shared<Conv2dOp>(
+                     random_tensor(Shape{16, 8, 3, 3}, rng), Tensor<float>(),
+                     down),
+                 {x});
+  g->addOutput(g->addNode("pool", std::make_shared<GlobalAveragePoolOp>(),
+                          {x}));
+  return g;
+}
+
+/**
+ * @test
+ * @brief Verifies plans are reused per shape and match fresh executors.
+ */
+TEST(PlanCacheTest, ReusesPlansPerShape) {
+  std::mt19937 rng(41);
+  const std::shared_ptr<Graph> g = backbone(rng);
+  PlanCache cache(g, 4);
+  const Shape buckets[] = {Shape{2, 3, 16, 24}, Shape{2, 3, 24, 16},
+                           Shape{1, 3, 20, 20}};
+  for (int round = 0; round < 3; ++round) {
+    for (const Shape& shape : buckets) {
+      const Tensor<float> x = random_tensor(shape, rng);
+      const std::shared_ptr<Executor> exec = cache.run({&x, 1});
+      Executor fresh(g, {shape});
+      fresh.run({&x, 1});
+      const Tensor<float>& y = exec->output(0);
+      ASSERT_EQ(y.shape(), (Shape{shape[0], 16, 1, 1}));
+      for (size_t i = 0; i < y.numel(); ++i)
+        ASSERT_FLOAT_EQ(y[i], fresh.output(0)[i]);
+    }
+  }
+  EXPECT_EQ(cache.size(), 3u);
+  EXPECT_EQ(cache.stats().misses, 3u);
+  EXPECT_EQ(cache.stats().hits, 6u);
+  EXPECT_EQ(cache.stats().evictions, 0u);
+  EXPECT_EQ(cache.get({buckets[1]}), cache.get({buckets[1]}));
+  EXPECT_GT(cache.arenaBytes(), 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies the least recently used plan is evicted first.
+ */
+TEST(PlanCacheTest, EvictsLeastRecentlyUsed) {
+  std::mt19937 rng(42);
+  PlanCache cache(backbone(rng), 2);
+  const Shape a{1, 3, 8, 8}, b{1, 3, 8, 16}, c{1, 3, 16, 8};
+  const std::shared_ptr<Executor> first = cache.get({a});
+  cache.get({b});
+  cache.get({a});  // b is now least recently used
+  cache.get({c});
+  EXPECT_EQ(cache.stats().evictions, 1u);
+  EXPECT_TRUE(cache.contains({a}));
+  EXPECT_FALSE(cache.contains({b}));
+  EXPECT_TRUE(cache.contains({c}));
+  cache.get({b});
+  EXPECT_FALSE(cache.contains({a}));
+  EXPECT_EQ(cache.size(), 2u);
+
+  // An evicted plan stays usable by its holder.
+  const Tensor<float> x = random_tensor(a, rng);
+  first->run({&x, 1});
+  EXPECT_EQ(first->output(0).shape(), (Shape{1, 16, 1, 1}));
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.stats().misses, 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies warmup plans expected shapes so serving only hits.
+ */
+TEST(PlanCacheTest, WarmupPrecompilesShapes) {
+  std::mt19937 rng(43);
+  PlanCache cache(backbone(rng), 3);
+  const std::vector<std::vector<Shape>> expected = {
+      {Shape{4, 3, 32, 32}}, {Shape{4, 3, 32, 48}}, {Shape{4, 3, 32, 32}}};
+  cache.warmup(expected);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.stats().misses, 2u);
+  const PlanCacheStats before = cache.stats();
+  const Tensor<float> x = random_tensor(Shape{4, 3, 32, 48}, rng);
+  cache.run({&x, 1});
+  EXPECT_EQ(cache.stats().misses, before.misses);
+  EXPECT_EQ(cache.stats().hits, before.hits + 1);
+  cache.warmup({{Shape{2, 3, 8, 8}}}, false);
+  EXPECT_EQ(cache.size(), 3u);
+}
+
+/**
+ * @test
+ * @brief Verifies invalid use is rejected without disturbing the cache.
+ */
+TEST(PlanCacheTest, RejectsInvalidUse) {
+  std::mt19937 rng(44);
+  EXPECT_THROW(PlanCache(std::shared_ptr<const Graph>()),
+               std::invalid_argument);
+  EXPECT_THROW(PlanCache(backbone(rng), 0), std::invalid_argument);
+  PlanCache cache(backbone(rng), 1);
+  cache.get({Shape{1, 3, 8, 8}});
+  EXPECT_THROW(cache.get({Shape{1, 4, 8, 8}}), std::invalid_argument);
+  EXPECT_THROW(cache.get({}), std::invalid_argument);
+  EXPECT_TRUE(cache.contains({Shape{1, 3, 8, 8}}));
+  EXPECT_EQ(cache.stats().evictions, 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies a builder-backed cache builds one graph per new shape.
+ */
+TEST(PlanCacheTest, BuildsGraphPerShape) {
+  std::mt19937 rng(45);
+  const std::shared_ptr<Graph> g = backbone(rng);
+  std::vector<std::vector<Shape>> built;
+  PlanCache cache(
+      [&](const std::vector<Shape>& shapes) -> std::shared_ptr<const Graph> {
+        built.push_back(shapes);
+        return g;
+      },
+      2);
+  EXPECT_EQ(cache.graph(), nullptr);
+  cache.warmup({{Shape{1, 3, 8, 8}}, {Shape{2, 3, 8, 8}}});
+  const Tensor<float> x = random_tensor(Shape{2, 3, 8, 8}, rng);
+  EXPECT_EQ(cache.run({&x, 1})->output(0).shape(), (Shape{2, 16, 1, 1}));
+  ASSERT_EQ(built.size(), 2u);
+  EXPECT_EQ(built[1], (std::vector<Shape>{Shape{2, 3, 8, 8}}));
+
+  EXPECT_THROW(PlanCache(PlanCache::GraphBuilder()), std::invalid_argument);
+  PlanCache empty([](const std::vector<Shape>&) { return nullptr; });
+  EXPECT_THROW(empty.get({Shape{1, 3, 8, 8}}), std::invalid_argument);
+  EXPECT_EQ(empty.size(), 0u);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file test_quantization.cpp
+ * @brief Unit tests for INT8 calibration and graph quantization.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "data/data.hpp"
+#include "runtime/operators.h"
+#include "runtime/quantization.h"
+
+/**
+ * @brief Deterministic random [3, 16, 16] images in [-1, 1].
+ */
+class NoiseDataset : public Dataset<Tensor<float>> {
+ public:
+  Tensor<float> getItem(size_t index) const override {
+    std::mt19937 rng(unsigned(100 + index));
+    return random_tensor(Shape{3, 16, 16}, rng);
+  }
+  size_t size() const override { return 8; }
+};
+
+/**
+ * @brief Small classifier: two ReLU convs, a depthwise conv, pooling and a
+ * linear head, for batches of four images.
+ */
+static Graph classifier(std::mt19937& rng) {
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  Conv2dParams down = same;
+  down.stride_h = down.stride_w = 2;
+  Conv2dParams depthwise = same;
+  depthwise.groups = 32;
+  const auto conv = [&](size_t ci, size_t co, const Conv2dParams& p) {
+    const float gain = std::sqrt(3.f / float(ci / p.groups * 9));
+    Tensor<float> w = random_tensor(Shape{co, ci / p.groups, 3, 3}, rng);
+    for (size_t i = 0; i < w.numel(); ++i) w[i] *= gain;
+    return std::make_shared<Conv2dOp>(w, random_tensor(Shape{co}, rng), p);
+  };
+  Graph g;
+  ValueId x = g.addInput("image");
+  x = g.addNode("conv1", conv(3, 16, same)->withClamp(0.f, 6.f), {x});
+  x = g.addNode("conv2", conv(16, 32, down)->withClamp(0.f, 6.f), {x});
+  x = g.addNode("dw", conv(32, 32, depthwise), {x});
+  x = g.addNode("pool", std::make_shared<GlobalAveragePoolOp>(), {x});
+  x = g.addNode("flat", std::make_shared<ReshapeOp>(Shape{4, 32}), {x});
+  g.addOutput(g.addNode(
+      "fc",
+      std::make_shared<LinearOp>(random_tensor(Shape{10, 32}, rng),
+                                 random_tensor(Shape{10}, rng)),
+      {x}));
+  return g;
+}
+
+/**
+ * @test
+ * @brief Verifies every calibration method through a DataLoader.
+ */
+TEST(QuantizationTest, CalibratesThroughDataLoader) {
+  std::mt19937 rng(21);
+  const Graph g = classifier(rng);
+  NoiseDataset dataset;
+  DataLoader<NoiseDataset> loader(dataset, 4, false);
+
+  CalibrationOptions options;
+  const CalibrationTable minmax = calibrate(g, loader, options);
+  ASSERT_EQ(minmax.size(), 3u);  // the depthwise conv is not observed
+  EXPECT_FALSE(minmax.count("dw"));
+  const QuantParams in = minmax.at("conv1");
+  EXPECT_NEAR(in.scale, 2.f / 255.f, 1e-4f);
+  EXPECT_NEAR(in.zero_point, 128, 1);
+  EXPECT_EQ(minmax.at("conv2").zero_point, 0);  // ReLU output
+  EXPECT_LE(minmax.at("conv2").scale, 6.f / 255.f);
+
+  for (CalibrationMethod method :
+       {CalibrationMethod::kPercentile, CalibrationMethod::kEntropy}) {
+    options.method = method;
+    options.percentile = 99.;
+    const CalibrationTable clipped = calibrate(g, loader, options);
+    ASSERT_EQ(clipped.size(), 3u);
+    for (const auto& [name, params] : clipped) {
+      EXPECT_LE(params.scale, minmax.at(name).scale * 1.0001f) << name;
+      EXPECT_GT(params.scale, minmax.at(name).scale * 0.2f) << name;
+    }
+    EXPECT_EQ(clipped.at("conv2").zero_point, 0);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies the quantized graph tracks the FP32 one and is reported.
+ */
+TEST(QuantizationTest, QuantizedGraphMatchesFloat) {
+  std::mt19937 rng(22);
+  const Graph g = classifier(rng);
+  NoiseDataset dataset;
+  DataLoader<NoiseDataset> loader(dataset, 4);
+  CalibrationOptions options;
+  options.method = CalibrationMethod::kEntropy;
+  const CalibrationTable table = calibrate(g, loader, options);
+
+  QuantizationStats stats;
+  const Graph q = quantize_graph(g, table, &stats);
+  EXPECT_EQ(stats.quantized_convs, 2u);
+  EXPECT_EQ(stats.quantized_linears, 1u);
+  EXPECT_EQ(stats.float_layers, 1u);
+  ASSERT_EQ(q.nodes().size(), g.nodes().size());
+  EXPECT_STREQ(q.nodes()[0].op->type(), "QConv2d");
+  EXPECT_STREQ(q.nodes()[2].op->type(), "Conv2d");
+  EXPECT_STREQ(q.nodes()[5].op->type(), "QLinear");
+  EXPECT_EQ(q.nodes()[5].name, "fc");
+
+  const std::vector<Tensor<float>> samples = {
+      dataset.getItem(0), dataset.getItem(1), dataset.getItem(2),
+      dataset.getItem(3)};
+  const Tensor<float> batch = collate<float>(samples);
+  const QuantizationReport report = compare_quantized(g, q, {&batch, 1}, 2);
+  EXPECT_GT(report.sqnr_db, 20.);
+  EXPECT_LT(report.mean_abs_error, report.max_abs_error + 1e-12);
+  EXPECT_GT(report.fp32_ms, 0.);
+  EXPECT_GT(report.int8_ms, 0.);
+  EXPECT_FALSE(report.kernel.empty());
+  const std::string line = format_quantization_report(report);
+  EXPECT_NE(line.find("SQNR"), std::string::npos);
+  EXPECT_NE(line.find(report.kernel), std::string::npos);
+
+  // A layer missing from the table stays in FP32.
+  CalibrationTable partial = table;
+  partial.erase("fc");
+  quantize_graph(g, partial, &stats);
+  EXPECT_EQ(stats.quantized_linears, 0u);
+  EXPECT_EQ(stats.float_layers, 2u);
+}
+
+/**
+ * @test
+ * @brief Verifies misuse of the calibration API is rejected.
+ */
+TEST(QuantizationTest, RejectsInvalidUse) {
+  std::mt19937 rng(23);
+  const Graph g = classifier(rng);
+  CalibrationOptions bad;
+  bad.percentile = 0.;
+  EXPECT_THROW(Calibrator(g, bad), std::invalid_argument);
+
+  Calibrator empty(g);
+  EXPECT_EQ(empty.numLayers(), 3u);
+  EXPECT_THROW(empty.table(), std::runtime_error);
+  EXPECT_THROW(empty.collect({}), std::invalid_argument);
+
+  CalibrationOptions entropy;
+  entropy.method = CalibrationMethod::kEntropy;
+  Calibrator two_pass(g, entropy);
+  const Tensor<float> batch = random_tensor(Shape{4, 3, 16, 16}, rng);
+  two_pass.collect({&batch, 1});
+  EXPECT_THROW(two_pass.table(), std::runtime_error);
+  EXPECT_TRUE(two_pass.nextPass());
+  two_pass.collect({&batch, 1});
+  EXPECT_FALSE(two_pass.nextPass());
+  EXPECT_EQ(two_pass.table().size(), 3u);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_weights.cpp
+ * @brief Unit tests for the memory-mapped weights container.
+ *
+ * Containers are written to the temporary directory and read back through
+ * zero-copy views; convolution layers loaded from them, with and without
+ * the prepacked sidecar, are compared with layers built from the original
+ * tensors.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "common/test_utils.hpp"
+#include "runtime/weights.h"
+
+/**
+ * @brief Temporary weights path removed (with its sidecar) when the test
+ * ends.
+ */
+struct TempWeights {
+  std::string path;
+  explicit TempWeights(const std::string& name)
+      : path((std::filesystem::temp_directory_path() / name).string()) {
+    clean();
+  }
+  ~TempWeights() { clean(); }
+  void clean() {
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + "." + sgemm_pack_key() + ".packed");
+  }
+};
+
+/**
+ * @test
+ * @brief Verifies round trips, alignment and views outliving the file.
+ */
+TEST(WeightsTest, RoundTripZeroCopy) {
+  TempWeights tmp("vf_weights_roundtrip.vfw");
+  std::mt19937 rng(1);
+  const std::vector<NamedTensor> tensors = {
+      {"a", random_tensor(Shape{3, 5}, rng)},
+      {"b", random_tensor(Shape{7}, rng)},
+      {"c", random_tensor(Shape{2, 3, 1, 1}, rng)}};
+  save_weights(tmp.path, tensors, 42);
+
+  Tensor<float> kept;
+  {
+    const WeightsFile file(tmp.path);
+    EXPECT_EQ(file.tag(), 42u);
+    ASSERT_EQ(file.entries().size(), 3u);
+    for (const NamedTensor& t : tensors) {
+      ASSERT_TRUE(file.contains(t.first));
+      const Tensor<float> view = file.tensor(t.first);
+      EXPECT_EQ(view.shape(), t.second.shape());
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(view.data()) % kTensorAlignment,
+                0u);
+      for (size_t i = 0; i < view.numel(); ++i)
+        ASSERT_EQ(view[i], t.second[i]);
+    }
+    EXPECT_FALSE(file.find("missing"));
+    EXPECT_THROW(file.tensor("missing"), std::out_of_range);
+    kept = file.tensor("b");
+  }
+  // The view keeps the mapping alive after the WeightsFile is gone.
+  for (size_t i = 0; i < kept.numel(); ++i)
+    EXPECT_EQ(kept[i], tensors[1].second[i]);
+}
+
+/**
+ * @test
+ * @brief Verifies rejection of duplicate names and invalid files.
+ */
+TEST(WeightsTest, RejectsInvalidInput) {
+  TempWeights tmp("vf_weights_invalid.vfw");
+  const Tensor<float> t(Shape{4});
+  EXPECT_THROW(save_weights(tmp.path, {{"x", t}, {"x", t}}),
+               std::invalid_argument);
+  EXPECT_THROW(WeightsFile(tmp.path + ".missing"), std::system_error);
+
+  { std::ofstream(tmp.path, std::ios::binary) << "not a weights file at all"; }
+  EXPECT_THROW(WeightsFile{tmp.path}, std::runtime_error);
+
+  // Truncating the data section must be caught by the index bounds checks.
+  save_weights(tmp.path, {{"x", Tensor<float>(Shape{1024})}});
+  std::filesystem::resize_file(tmp.path,
+                               std::filesystem::file_size(tmp.path) - 64);
+  EXPECT_THROW(WeightsFile{tmp.path}, std::runtime_error);
+}
+
+/**
+ * @test
+ * @brief Verifies convolution loading with the prepacked sidecar.
+ */
+TEST(WeightsTest, PrepackedCache) {
+  TempWeights tmp("vf_weights_conv.vfw");
+  std::mt19937 rng(2);
+  Conv2dParams same;
+  same.pad_top = same.pad_left = same.pad_bottom = same.pad_right = 1;
+  const Tensor<float> w3 = random_tensor(Shape{40, 36, 3, 3}, rng);
+  const Tensor<float> b3 = random_tensor(Shape{40}, rng);
+  const Tensor<float> w1 = random_tensor(Shape{16, 40, 1, 1}, rng);
+  save_weights(tmp.path,
+               {{"c3.weight", w3}, {"c3.bias", b3}, {"c1.weight", w1}});
+  const Tensor<float> x = random_tensor(Shape{1, 36, 10, 9}, rng);
+
+  const Tensor<float> y3 = Conv2d(w3, b3, same).forward(x);
+  const Tensor<float> y1 = Conv2d(w1, Tensor<float>(), {}).forward(y3);
+  auto check = [&](const Conv2dOp& c3, const Conv2dOp& c1) {
+    const Tensor<float> z3 = c3.conv().forward(x);
+    const Tensor<float> z1 = c1.conv().forward(z3);
+    for (size_t i = 0; i < y3.numel(); ++i) ASSERT_EQ(z3[i], y3[i]);
+    for (size_t i = 0; i < y1.numel(); ++i) ASSERT_EQ(z1[i], y1[i]);
+  };
+
+  const WeightsFile file(tmp.path);
+  {
+    PrepackedCache cache(tmp.path);
+    EXPECT_FALSE(cache.dirty());
+    const auto c3 = load_conv2d(file, "c3", same, ConvLayout::kNchw,
+                                ConvAlgorithm::kAuto, &cache);
+    const auto c1 = load_conv2d(file, "c1", {}, ConvLayout::kNchw,
+                                ConvAlgorithm::kAuto, &cache);
+    EXPECT_EQ(c3->conv().algorithm(), ConvAlgorithm::kWinograd);
+    EXPECT_TRUE(cache.dirty());
+    check(*c3, *c1);
+    cache.save();
+    EXPECT_FALSE(cache.dirty());
+  }
+
+  // A second load adopts the mapped panels instead of packing.
+  PrepackedCache cache(tmp.path);
+  const auto c3 = load_conv2d(file, "c3", same, ConvLayout::kNchw,
+                              ConvAlgorithm::kAuto, &cache);
+  const auto c1 = load_conv2d(file, "c1", {}, ConvLayout::kNchw,
+                              ConvAlgorithm::kAuto, &cache);
+  EXPECT_FALSE(cache.dirty());
+  const Tensor<float> panel = *cache.find("c3.packed.0");
+  EXPECT_EQ(c3->conv().packedWeights()[0].data.data(), panel.data());
+  EXPECT_EQ(c3->weight().data(), file.tensor("c3.weight").data());
+  check(*c3, *c1);
+
+  // A different algorithm does not match the cached panels and repacks.
+  const auto im2col = load_conv2d(file, "c3", same, ConvLayout::kNchw,
+                                  ConvAlgorithm::kIm2col, &cache);
+  EXPECT_EQ(im2col->conv().algorithm(), ConvAlgorithm::kIm2col);
+  EXPECT_TRUE(cache.dirty());
+  EXPECT_THROW(load_conv2d(file, "c9", same), std::out_of_range);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_batcher.cpp
+ * @brief Unit tests for the dynamic batcher.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "serving/batcher.h"
+
+/**
+ * @brief Model adding 1 to every element, recording the batch sizes.
+ */
+static DynamicBatcher::Model add_one(std::vector<size_t>& sizes) {
+  return [&sizes](const Tensor<float>& batch) {
+    sizes.push_back(batch.dim(0));
+    Tensor<float> out = batch.clone();
+    for (size_t i = 0; i < out.numel(); ++i) out.data()[i] += 1.f;
+    return out;
+  };
+}
+
+/**
+ * @brief Submit a one-element sample and return its future result.
+ */
+static std::future<float> submit(DynamicBatcher& batcher, float value) {
+  auto promise = std::make_shared<std::promise<float>>();
+  Tensor<float> sample({1});
+  sample.data()[0] = value;
+  batcher.submit(sample, [promise](Tensor<float> result,
+                                   std::exception_ptr error) {
+    if (error)
+      promise->set_exception(error);
+    else
+      promise->set_value(result.data()[0]);
+  });
+  return promise->get_future();
+}
+
+/**
+ * @test
+ * @brief Verifies queued requests share a batch and get their own rows.
+ */
+TEST(DynamicBatcherTest, BatchesQueuedRequests) {
+  std::vector<size_t> sizes;
+  BatchingOptions options;
+  options.max_batch = 4;
+  options.max_delay = std::chrono::seconds(10);
+  DynamicBatcher batcher(add_one(sizes), options);
+  std::vector<std::future<float>> results;
+  for (int i = 0; i < 8; ++i) results.push_back(submit(batcher, float(i)));
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(results[i].get(), float(i) + 1.f);
+  // Full batches close at once, without waiting for the delay.
+  EXPECT_EQ(sizes, std::vector<size_t>({4, 4}));
+  const BatcherStats stats = batcher.stats();
+  EXPECT_EQ(stats.requests, 8u);
+  EXPECT_EQ(stats.batches, 2u);
+  EXPECT_DOUBLE_EQ(stats.meanBatch(), 4.);
+}
+
+/**
+ * @test
+ * @brief Verifies a lone request runs once the delay expires.
+ */
+TEST(DynamicBatcherTest, RespectsMaxDelay) {
+  std::vector<size_t> sizes;
+  BatchingOptions options;
+  options.max_batch = 64;
+  options.max_delay = std::chrono::milliseconds(20);
+  DynamicBatcher batcher(add_one(sizes), options);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(submit(batcher, 1.f).get(), 2.f);
+  const auto waited = std::chrono::steady_clock::now() - start;
+  EXPECT_GE(waited, std::chrono::milliseconds(15));
+  EXPECT_LT(waited, std::chrono::seconds(5));
+  EXPECT_EQ(sizes, std::vector<size_t>({1}));
+}
+
+/**
+ * @test
+ * @brief Verifies padding to batch sizes, shape grouping and errors.
+ */
+TEST(DynamicBatcherTest, PadsGroupsAndFails) {
+  std::vector<size_t> sizes;
+  BatchingOptions options;
+  options.max_batch = 8;
+  options.max_delay = std::chrono::milliseconds(200);
+  options.batch_sizes = {2, 4};
+  {
+    DynamicBatcher batcher(add_one(sizes), options);
+    std::vector<std::future<float>> results;
+    for (int i = 0; i < 3; ++i) results.push_back(submit(batcher, 1.f));
+    Tensor<float> other({2});
+    std::promise<Shape> shape;
+    batcher.submit(other, [&](Tensor<float> result, std::exception_ptr) {
+      shape.set_value(result.shape());
+    });
+    for (auto& r : results) EXPECT_EQ(r.get(), 2.f);
+    EXPECT_EQ(shape.get_future().get(), Shape({2}));
+    batcher.stop();
+    EXPECT_THROW(submit(batcher, 0.f), std::runtime_error);
+    const BatcherStats stats = batcher.stats();
+    EXPECT_EQ(stats.batches, 2u);
+    EXPECT_EQ(stats.padded_samples, 1u + 1u);  // 3 -> 4 and 1 -> 2
+  }
+  EXPECT_EQ(sizes, std::vector<size_t>({4, 2}));
+
+  DynamicBatcher failing(
+      [](const Tensor<float>&) -> Tensor<float> {
+        throw std::runtime_error("model failed");
+      },
+      options);
+  std::future<float> result = submit(failing, 1.f);
+  EXPECT_THROW(result.get(), std::runtime_error);
+  EXPECT_EQ(failing.stats().failed, 1u);
+
+  EXPECT_THROW(DynamicBatcher(nullptr), std::invalid_argument);
+  options.batch_sizes = {4, 2};
+  EXPECT_THROW(DynamicBatcher(add_one(sizes), options),
+               std::invalid_argument);
+  EXPECT_THROW(failing.submit(Tensor<float>(), nullptr),
+               std::invalid_argument);
+}
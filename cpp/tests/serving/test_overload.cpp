@@ -0,0 +1,107 @@
+/**
+ * @file test_overload.cpp
+ * @brief Unit tests for the overload controller.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "serving/overload.h"
+
+/**
+ * @brief Report a window of frames of one latency and queue depth.
+ */
+static bool window(OverloadController& controller, double ms,
+                   size_t queue = 0, size_t frames = 10) {
+  bool changed = false;
+  for (size_t i = 0; i < frames; ++i)
+    changed = controller.observe(ms, queue);
+  return changed;
+}
+
+/**
+ * @test
+ * @brief Verifies stepping down on high p99 or deep queues, and back up
+ * only after enough calm windows.
+ */
+TEST(OverloadControllerTest, StepsWithHysteresis) {
+  OverloadControlOptions options;
+  options.target_p99_ms = 20.;
+  options.window = 10;
+  options.queue_high = 8;
+  options.recover_windows = 2;
+  options.levels = {{1, 1, 4}, {2, 1, 8}, {2, 2, 8}};
+  OverloadController controller(options);
+  EXPECT_EQ(controller.level(), 0u);
+  EXPECT_EQ(controller.quality().max_batch, 4u);
+
+  EXPECT_FALSE(window(controller, 10.));
+  EXPECT_TRUE(window(controller, 30.));
+  EXPECT_EQ(controller.level(), 1u);
+  EXPECT_DOUBLE_EQ(controller.lastP99(), 30.);
+  // One slow frame in ten is the p99 of the window.
+  for (int i = 0; i < 9; ++i) controller.observe(5., 0);
+  EXPECT_TRUE(controller.observe(40., 0));
+  EXPECT_EQ(controller.level(), 2u);
+  EXPECT_FALSE(window(controller, 100.));  // already the cheapest
+  EXPECT_EQ(controller.quality().keep_every, 2u);
+
+  // Inside the band (14..20 ms) nothing moves; recovery needs two calm
+  // windows in a row.
+  EXPECT_FALSE(window(controller, 18.));
+  EXPECT_FALSE(window(controller, 5.));
+  EXPECT_FALSE(window(controller, 18.));
+  EXPECT_FALSE(window(controller, 5.));
+  EXPECT_TRUE(window(controller, 5.));
+  EXPECT_EQ(controller.level(), 1u);
+
+  // A deep queue degrades even while latency is still fine.
+  EXPECT_TRUE(window(controller, 5., 8));
+  EXPECT_EQ(controller.level(), 2u);
+  EXPECT_FALSE(window(controller, 5., 5));  // not calm: queue >= 8 / 2
+  EXPECT_FALSE(window(controller, 5., 3));
+  EXPECT_TRUE(window(controller, 5., 3));
+  EXPECT_EQ(controller.changes(), 5u);
+}
+
+/**
+ * @test
+ * @brief Verifies recovery with the smallest queue thresholds.
+ */
+TEST(OverloadControllerTest, RecoversWithSmallQueueThreshold) {
+  OverloadControlOptions options;
+  options.target_p99_ms = 20.;
+  options.window = 10;
+  options.recover_windows = 1;
+  options.levels = {{1, 1, 4}, {2, 1, 8}};
+  for (size_t high : {1, 2, 3}) {
+    options.queue_high = high;
+    OverloadController controller(options);
+    EXPECT_TRUE(window(controller, 5., high));
+    EXPECT_EQ(controller.level(), 1u);
+    EXPECT_FALSE(window(controller, 5., (high + 1) / 2));  // not calm
+    EXPECT_TRUE(window(controller, 5., 0));
+    EXPECT_EQ(controller.level(), 0u);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies the default ladder and option checks.
+ */
+TEST(OverloadControllerTest, DefaultsAndValidation) {
+  OverloadController controller;
+  EXPECT_EQ(controller.quality().downscale, 1u);
+  EXPECT_EQ(controller.quality().keep_every, 1u);
+
+  OverloadControlOptions options;
+  options.window = 0;
+  EXPECT_THROW(OverloadController{options}, std::invalid_argument);
+  options = {};
+  options.recover_ratio = 1.5;
+  EXPECT_THROW(OverloadController{options}, std::invalid_argument);
+  options = {};
+  options.levels = {{1, 0, 8}};
+  EXPECT_THROW(OverloadController{options}, std::invalid_argument);
+}
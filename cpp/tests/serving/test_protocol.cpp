@@ -0,0 +1,96 @@
+/**
+ * @file test_protocol.cpp
+ * @brief Unit tests for the inference server wire format.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "serving/protocol.h"
+
+/**
+ * @test
+ * @brief Verifies tensor, error and empty messages survive a round trip,
+ * fed one byte at a time.
+ */
+TEST(ProtocolTest, RoundTrip) {
+  Message tensor;
+  tensor.id = 7;
+  tensor.tensor = Tensor<float>({2, 3});
+  for (size_t i = 0; i < 6; ++i) tensor.tensor.data()[i] = float(i) - 2.5f;
+  Message error;
+  error.id = 8;
+  error.status = MessageStatus::kError;
+  error.error = "shape mismatch";
+  Message empty;
+  empty.id = 9;
+
+  std::vector<uint8_t> bytes;
+  encode_message(tensor, bytes);
+  encode_message(error, bytes);
+  encode_message(empty, bytes);
+
+  MessageReader reader;
+  std::vector<Message> decoded;
+  Message message;
+  for (uint8_t byte : bytes) {
+    reader.feed(&byte, 1);
+    while (reader.next(message)) decoded.push_back(message);
+  }
+  EXPECT_EQ(reader.buffered(), 0u);
+  ASSERT_EQ(decoded.size(), 3u);
+
+  EXPECT_EQ(decoded[0].id, 7u);
+  EXPECT_EQ(decoded[0].status, MessageStatus::kOk);
+  ASSERT_EQ(decoded[0].tensor.shape(), Shape({2, 3}));
+  for (size_t i = 0; i < 6; ++i)
+    EXPECT_EQ(decoded[0].tensor.data()[i], float(i) - 2.5f);
+
+  EXPECT_EQ(decoded[1].id, 8u);
+  EXPECT_EQ(decoded[1].status, MessageStatus::kError);
+  EXPECT_EQ(decoded[1].error, "shape mismatch");
+  EXPECT_TRUE(decoded[1].tensor.empty());
+
+  EXPECT_EQ(decoded[2].id, 9u);
+  EXPECT_EQ(decoded[2].status, MessageStatus::kOk);
+  EXPECT_TRUE(decoded[2].tensor.empty());
+}
+
+/**
+ * @test
+ * @brief Verifies malformed frames are rejected.
+ */
+TEST(ProtocolTest, RejectsMalformedFrames) {
+  Message message;
+  message.tensor = Tensor<float>({4});
+  std::vector<uint8_t> good;
+  encode_message(message, good);
+
+  const auto decode = [](std::vector<uint8_t> bytes) {
+    MessageReader reader;
+    reader.feed(bytes.data(), bytes.size());
+    Message out;
+    return reader.next(out);
+  };
+  EXPECT_TRUE(decode(good));
+  EXPECT_FALSE(decode({good.begin(), good.end() - 1}));  // incomplete
+
+  std::vector<uint8_t> magic = good;
+  magic[0] ^= 0xFF;
+  EXPECT_THROW(decode(magic), std::runtime_error);
+
+  std::vector<uint8_t> size = good;
+  size[4] = 3;  // frame shorter than its header
+  size[5] = size[6] = size[7] = 0;
+  EXPECT_THROW(decode(size), std::runtime_error);
+
+  std::vector<uint8_t> shape = good;
+  shape[24] = 5;  // 5 elements claimed, 4 sent
+  EXPECT_THROW(decode(shape), std::runtime_error);
+
+  std::vector<uint8_t> status = good;
+  status[16] = 9;
+  EXPECT_THROW(decode(status), std::runtime_error);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file test_scheduler.cpp
+ * @brief Unit tests for the multi-stream fair scheduler.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "serving/scheduler.h"
+
+/**
+ * @brief Model that blocks its first batch until released.
+ */
+struct GatedModel {
+  std::promise<void> entered; /**< Set when the first batch starts */
+  std::promise<void> release; /**< Set by the test to let it finish */
+  std::shared_future<void> released = release.get_future().share();
+  bool first = true; /**< Only touched by the scheduler thread */
+
+  BatchModel model() {
+    return [this](const Tensor<float>& batch) {
+      if (first) {
+        first = false;
+        entered.set_value();
+        released.wait();
+      }
+      return batch.clone();
+    };
+  }
+};
+
+/**
+ * @brief Make a [1, 2, 2] frame filled with @p value.
+ */
+static Tensor<float> frame(float value) {
+  Tensor<float> t({1, 2, 2});
+  t.fill(value);
+  return t;
+}
+
+/**
+ * @test
+ * @brief Verifies priority classes and deficit round robin by weight.
+ */
+TEST(StreamSchedulerTest, ServesByPriorityAndWeight) {
+  GatedModel gate;
+  SchedulerOptions options;
+  options.max_batch = 4;
+  std::vector<size_t> order;  // appended on the scheduler thread
+  auto scheduler = std::make_unique<StreamScheduler>(gate.model(), options);
+  StreamOptions stream;
+  stream.deadline = std::chrono::seconds(60);
+  stream.max_queue = 8;
+  stream.priority = 9;
+  const size_t blocker = scheduler->addStream(stream);
+  stream.priority = 0;
+  const size_t a = scheduler->addStream(stream);
+  const size_t b = scheduler->addStream(stream);
+  stream.weight = 2;
+  const size_t c = scheduler->addStream(stream);
+  stream.weight = 1;
+  stream.priority = 5;
+  const size_t high = scheduler->addStream(stream);
+
+  const auto submit = [&](size_t id) {
+    scheduler->submit(id, frame(float(id)),
+                     [&order, id](FrameStatus status, Tensor<float>) {
+                       if (status == FrameStatus::kDone) order.push_back(id);
+                     });
+  };
+  submit(blocker);
+  gate.entered.get_future().wait();
+  // A busy stream cannot crowd out the others.
+  for (int i = 0; i < 8; ++i) submit(a);
+  for (int i = 0; i < 8; ++i) submit(b);
+  for (int i = 0; i < 8; ++i) submit(c);
+  submit(high);
+  submit(high);
+  gate.release.set_value();
+  scheduler.reset();  // runs the queued frames
+
+  ASSERT_EQ(order.size(), 27u);
+  const std::vector<size_t> expected = {blocker, high, high, a, b, c, c,
+                                        a,       b,    c,    c, a, b, c, c};
+  EXPECT_EQ(std::vector<size_t>(order.begin(), order.begin() + 15),
+            expected);
+}
+
+/**
+ * @test
+ * @brief Verifies frames that would miss their deadline are downscaled or
+ * dropped once the batch cost is known.
+ */
+TEST(StreamSchedulerTest, DropsOrDownscalesLateFrames) {
+  StreamScheduler scheduler([](const Tensor<float>& batch) {
+    if (batch.dim(2) > 2)  // full resolution is slow
+      std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    return batch.clone();
+  });
+  StreamOptions relaxed;
+  relaxed.deadline = std::chrono::seconds(60);
+  StreamOptions strict;
+  strict.deadline = std::chrono::milliseconds(10);
+  StreamOptions shrinking = strict;
+  shrinking.overload = OverloadPolicy::kDownscale;
+  const size_t warm = scheduler.addStream(relaxed);
+  const size_t drop = scheduler.addStream(strict);
+  const size_t down = scheduler.addStream(shrinking);
+
+  const auto run = [&](size_t stream, Tensor<float> input) {
+    auto result = std::make_shared<
+        std::promise<std::pair<FrameStatus, Tensor<float>>>>();
+    scheduler.submit(stream, std::move(input),
+                     [result](FrameStatus status, Tensor<float> out) {
+                       result->set_value({status, out});
+                     });
+    return result->get_future().get();
+  };
+  Tensor<float> image({1, 4, 4});
+  for (size_t i = 0; i < 16; ++i) image.data()[i] = float(i);
+
+  EXPECT_EQ(run(warm, image).first, FrameStatus::kDone);  // learns 30 ms
+  EXPECT_EQ(run(drop, image).first, FrameStatus::kDropped);
+  const auto [status, out] = run(down, image);
+  ASSERT_EQ(status, FrameStatus::kDownscaled);
+  ASSERT_EQ(out.shape(), Shape({1, 2, 2}));
+  EXPECT_FLOAT_EQ(out.data()[0], (0.f + 1.f + 4.f + 5.f) / 4.f);
+  EXPECT_FLOAT_EQ(out.data()[3], (10.f + 11.f + 14.f + 15.f) / 4.f);
+
+  const std::vector<StreamStats> stats = scheduler.stats();
+  EXPECT_EQ(stats[warm].completed, 1u);
+  EXPECT_GE(stats[warm].p50_ms, 25.);
+  EXPECT_EQ(stats[drop].dropped, 1u);
+  EXPECT_EQ(stats[drop].completed, 0u);
+  EXPECT_EQ(stats[down].downscaled, 1u);
+  EXPECT_EQ(stats[down].completed, 1u);
+}
+
+/**
+ * @test
+ * @brief Verifies full queues evict their oldest frame, and the stats,
+ * report and argument checks.
+ */
+TEST(StreamSchedulerTest, EvictsAndReports) {
+  GatedModel gate;
+  StreamScheduler scheduler(gate.model());
+  StreamOptions options;
+  options.name = "cam0";
+  options.max_queue = 1;
+  const size_t cam = scheduler.addStream(options);
+
+  std::vector<FrameStatus> statuses(4, FrameStatus::kFailed);
+  std::promise<void> last;
+  for (size_t i = 0; i < 4; ++i) {
+    scheduler.submit(cam, frame(1.f),
+                     [&, i](FrameStatus status, Tensor<float>) {
+                       statuses[i] = status;
+                       if (i == 3) last.set_value();
+                     });
+    if (i == 0) gate.entered.get_future().wait();
+  }
+  gate.release.set_value();
+  last.get_future().wait();
+  EXPECT_EQ(statuses, std::vector<FrameStatus>(
+                          {FrameStatus::kDone, FrameStatus::kDropped,
+                           FrameStatus::kDropped, FrameStatus::kDone}));
+
+  const StreamStats stats = scheduler.stats()[cam];
+  EXPECT_EQ(stats.submitted, 4u);
+  EXPECT_EQ(stats.completed, 2u);
+  EXPECT_EQ(stats.dropped, 2u);
+  EXPECT_NE(format_stream_stats({stats}).find("cam0: 2/4 frames"),
+            std::string::npos);
+
+  EXPECT_THROW(scheduler.submit(7, frame(1.f), nullptr), std::out_of_range);
+  EXPECT_THROW(scheduler.submit(cam, Tensor<float>(), nullptr),
+               std::invalid_argument);
+  options.weight = 0;
+  EXPECT_THROW(scheduler.addStream(options), std::invalid_argument);
+  EXPECT_THROW(StreamScheduler(nullptr), std::invalid_argument);
+  scheduler.stop();
+  EXPECT_THROW(scheduler.submit(cam, frame(1.f), nullptr), std::runtime_error);
+}
+
+/**
+ * @test
+ * @brief Verifies the overload controller lowers resolution, skips frames
+ * and caps batches when latency exceeds its target, then recovers.
+ */
+TEST(StreamSchedulerTest, AdaptsQualityUnderOverload) {
+  SchedulerOptions options;
+  OverloadControlOptions control;
+  control.target_p99_ms = 10.;
+  control.window = 4;
+  control.recover_windows = 1;
+  control.levels = {{1, 1, 8}, {2, 2, 1}};
+  options.overload_control = control;
+  std::vector<Shape> shapes;  // appended on the scheduler thread
+  StreamScheduler scheduler(
+      [&shapes](const Tensor<float>& batch) {
+        shapes.push_back(batch.shape());
+        if (batch.dim(3) > 2)  // full resolution is slow
+          std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return batch.clone();
+      },
+      options);
+  StreamOptions stream;
+  stream.deadline = std::chrono::seconds(60);
+  const size_t cam = scheduler.addStream(stream);
+
+  const auto run = [&] {
+    auto result = std::make_shared<std::promise<FrameStatus>>();
+    scheduler.submit(cam, Tensor<float>({1, 4, 4}),
+                     [result](FrameStatus status, Tensor<float>) {
+                       result->set_value(status);
+                     });
+    return result->get_future().get();
+  };
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(run(), FrameStatus::kDone);
+  EXPECT_EQ(scheduler.quality().downscale, 2u);  // 20 ms > 10 ms target
+  // Every other frame is skipped, the rest run at half resolution.
+  for (int i = 0; i < 7; ++i)
+    EXPECT_EQ(run(), i % 2 ? FrameStatus::kSkipped : FrameStatus::kDownscaled);
+  EXPECT_EQ(shapes.back(), Shape({1, 1, 2, 2}));
+  // Four fast frames make a calm window: back to full quality.
+  EXPECT_EQ(scheduler.quality().downscale, 1u);
+  EXPECT_EQ(run(), FrameStatus::kDone);
+  EXPECT_EQ(shapes.back(), Shape({1, 1, 4, 4}));
+
+  const StreamStats stats = scheduler.stats()[cam];
+  EXPECT_EQ(stats.submitted, 12u);
+  EXPECT_EQ(stats.skipped, 3u);
+  EXPECT_EQ(stats.downscaled, 4u);
+}
+
+/**
+ * @test
+ * @brief Verifies that slow failing batches count towards overload.
+ */
+TEST(StreamSchedulerTest, FailedFramesReachController) {
+  SchedulerOptions options;
+  OverloadControlOptions control;
+  control.target_p99_ms = 10.;
+  control.window = 4;
+  control.levels = {{1, 1, 8}, {2, 1, 8}};
+  options.overload_control = control;
+  StreamScheduler scheduler(
+      [](const Tensor<float>&) -> Tensor<float> {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        throw std::runtime_error("model");
+      },
+      options);
+  StreamOptions stream;
+  stream.deadline = std::chrono::seconds(60);
+  const size_t cam = scheduler.addStream(stream);
+
+  for (int i = 0; i < 4; ++i) {
+    auto result = std::make_shared<std::promise<FrameStatus>>();
+    scheduler.submit(cam, Tensor<float>({1, 4, 4}),
+                     [result](FrameStatus status, Tensor<float>) {
+                       result->set_value(status);
+                     });
+    EXPECT_EQ(result->get_future().get(), FrameStatus::kFailed);
+  }
+  EXPECT_EQ(scheduler.quality().downscale, 2u);  // 20 ms > 10 ms target
+  EXPECT_EQ(scheduler.stats()[cam].failed, 4u);
+}
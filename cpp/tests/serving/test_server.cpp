@@ -0,0 +1,247 @@
+/**
+ * @file test_server.cpp
+ * @brief Unit tests for the inference server and client.
+ */
+
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "serving/client.h"
+#include "serving/server.h"
+
+/**
+ * @brief Server on a temporary socket, running on its own thread.
+ */
+class ServerFixture {
+ public:
+  std::string path;         /**< Socket path */
+  InferenceServer server;   /**< Server under test */
+  std::thread thread;       /**< Runs the event loop */
+
+  explicit ServerFixture(ServerOptions options, const std::string& name,
+                         DynamicBatcher::Model model = double_model)
+      : path(options.socket_path = socket_path(name)),
+        server(std::move(model), options),
+        thread([this] { server.run(); }) {}
+
+  ~ServerFixture() {
+    server.stop();
+    thread.join();
+  }
+
+  /**
+   * @brief Double every element; fails on negative input.
+   */
+  static Tensor<float> double_model(const Tensor<float>& batch) {
+    Tensor<float> out = batch.clone();
+    for (size_t i = 0; i < out.numel(); ++i) {
+      if (out.data()[i] < 0) throw std::runtime_error("negative input");
+      out.data()[i] *= 2.f;
+    }
+    return out;
+  }
+
+  static std::string socket_path(const std::string& name) {
+    return "/tmp/vf_test_" + name + "_" + std::to_string(getpid()) +
+           ".sock";
+  }
+};
+
+/**
+ * @brief Make a [3] sample filled with @p value.
+ */
+static Tensor<float> sample(float value) {
+  Tensor<float> t({3});
+  t.fill(value);
+  return t;
+}
+
+/**
+ * @brief Open a blocking connection to @p path without a client.
+ */
+static int connect_raw(const std::string& path) {
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)))
+    throw std::runtime_error("connect failed");
+  return fd;
+}
+
+/**
+ * @brief Write a request frame to a raw connection.
+ */
+static void send_raw(int fd, uint64_t id, const Tensor<float>& tensor) {
+  Message request;
+  request.id = id;
+  request.tensor = tensor;
+  std::vector<uint8_t> bytes;
+  encode_message(request, bytes);
+  for (size_t sent = 0; sent < bytes.size();) {
+    const ssize_t n = write(fd, bytes.data() + sent, bytes.size() - sent);
+    if (n <= 0) throw std::runtime_error("write failed");
+    sent += size_t(n);
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies blocking and pipelined requests from several clients.
+ */
+TEST(InferenceServerTest, ServesClients) {
+  ServerOptions options;
+  options.batching.max_batch = 8;
+  options.batching.max_delay = std::chrono::milliseconds(5);
+  ServerFixture fixture(options, "serve");
+
+  InferenceClient single(fixture.path);
+  Tensor<float> out = single.infer(sample(1.5f));
+  ASSERT_EQ(out.shape(), Shape({3}));
+  EXPECT_EQ(out.data()[2], 3.f);
+
+  std::vector<std::thread> clients;
+  std::vector<int> correct(4, 0);
+  for (int c = 0; c < 4; ++c)
+    clients.emplace_back([&, c] {
+      InferenceClient client(fixture.path);
+      std::map<uint64_t, float> expected;
+      for (int i = 0; i < 16; ++i)
+        expected[client.send(sample(float(c * 100 + i)))] =
+            2.f * float(c * 100 + i);
+      for (int i = 0; i < 16; ++i) {
+        Message m = client.receive();
+        if (m.status == MessageStatus::kOk &&
+            m.tensor.data()[0] == expected.at(m.id))
+          ++correct[c];
+      }
+    });
+  for (std::thread& t : clients) t.join();
+  EXPECT_EQ(correct, std::vector<int>(4, 16));
+
+  const ServerStats stats = fixture.server.stats();
+  EXPECT_EQ(stats.accepted, 5u);
+  EXPECT_EQ(stats.requests, 65u);
+  EXPECT_EQ(stats.responses, 65u);
+  EXPECT_EQ(stats.batcher.requests, 65u);
+  EXPECT_LT(stats.batcher.batches, 65u);  // pipelined requests were batched
+}
+
+/**
+ * @test
+ * @brief Verifies model errors are answered and malformed clients dropped.
+ */
+TEST(InferenceServerTest, ReportsErrorsAndDropsBadClients) {
+  ServerOptions options;
+  options.batching.max_delay = std::chrono::microseconds(100);
+  options.max_connections = 2;
+  ServerFixture fixture(options, "errors");
+
+  InferenceClient client(fixture.path);
+  EXPECT_THROW(client.infer(sample(-1.f)), std::runtime_error);
+  EXPECT_THROW(client.infer(Tensor<float>()), std::runtime_error);
+  EXPECT_EQ(client.infer(sample(2.f)).data()[0], 4.f);  // still usable
+
+  // Garbage gets the connection closed.
+  const int fd = connect_raw(fixture.path);
+  const char garbage[16] = "not a frame....";
+  ASSERT_EQ(write(fd, garbage, sizeof(garbage)), 16);
+  char byte;
+  EXPECT_EQ(read(fd, &byte, 1), 0);  // EOF
+  close(fd);
+
+  // Past max_connections clients are refused.
+  InferenceClient second(fixture.path);
+  EXPECT_EQ(second.infer(sample(1.f)).data()[0], 2.f);
+  InferenceClient third(fixture.path);
+  EXPECT_THROW(third.infer(sample(1.f)), std::exception);
+
+  const ServerStats stats = fixture.server.stats();
+  EXPECT_EQ(stats.dropped, 1u);
+  EXPECT_EQ(stats.refused, 1u);
+  EXPECT_EQ(stats.batcher.failed, 1u);
+
+  EXPECT_THROW(InferenceServer([](const Tensor<float>& t) { return t; },
+                               ServerOptions{}),
+               std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies that a result too large for one frame is answered with
+ * an error and leaves the connection usable.
+ */
+TEST(InferenceServerTest, AnswersOversizedResults) {
+  ServerOptions options;
+  options.batching.max_delay = std::chrono::microseconds(100);
+  options.batching.max_batch = 1;
+  ServerFixture fixture(
+      options, "oversized", [](const Tensor<float>& batch) {
+        if (batch.data()[0] != 1.f) return ServerFixture::double_model(batch);
+        return Tensor<float>(
+            Shape{batch.dim(0), kMaxMessageBytes / sizeof(float) + 1});
+      });
+
+  InferenceClient client(fixture.path);
+  try {
+    client.infer(sample(1.f));
+    ADD_FAILURE() << "oversized result was not reported";
+  } catch (const std::runtime_error& e) {
+    EXPECT_NE(std::string(e.what()).find("too large"), std::string::npos);
+  }
+  EXPECT_EQ(client.infer(sample(2.f)).data()[0], 4.f);
+}
+
+/**
+ * @test
+ * @brief Verifies that a client with unread output is not read from, and
+ * that a client which shuts down sending still gets its responses.
+ */
+TEST(InferenceServerTest, PausesSlowReadersAndAnswersAfterShutdown) {
+  ServerOptions options;
+  options.batching.max_delay = std::chrono::microseconds(100);
+  options.max_output_bytes = 0;
+  ServerFixture fixture(options, "backpressure");
+
+  // A response larger than the socket buffers stays partly unsent.
+  const int fd = connect_raw(fixture.path);
+  Tensor<float> large({1 << 20});
+  large.fill(1.f);
+  send_raw(fd, 1, large);
+  pollfd ready{fd, POLLIN, 0};
+  ASSERT_EQ(poll(&ready, 1, 10000), 1);
+  send_raw(fd, 2, sample(3.f));
+  ASSERT_EQ(shutdown(fd, SHUT_WR), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(fixture.server.stats().requests, 1u);  // second one unread
+
+  MessageReader reader;
+  std::vector<Message> responses;
+  uint8_t buffer[64 * 1024];
+  for (;;) {
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    ASSERT_GE(n, 0);
+    if (n == 0) break;  // closed once everything was sent
+    reader.feed(buffer, size_t(n));
+    for (Message m; reader.next(m);) responses.push_back(std::move(m));
+  }
+  close(fd);
+  ASSERT_EQ(responses.size(), 2u);
+  EXPECT_EQ(responses[0].id, 1u);
+  EXPECT_EQ(responses[0].tensor.numel(), size_t(1) << 20);
+  EXPECT_EQ(responses[0].tensor.data()[123], 2.f);
+  EXPECT_EQ(responses[1].id, 2u);
+  EXPECT_EQ(responses[1].tensor.data()[0], 6.f);
+  EXPECT_EQ(fixture.server.stats().requests, 2u);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file test_half.cpp
+ * @brief Unit tests for the Half and BFloat16 storage types.
+ *
+ * Every 16-bit encoding is round-tripped through float, and rounding,
+ * overflow and subnormal cases are checked against known encodings.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+#include "tensor/half.hpp"
+#include "tensor/tensor.hpp"
+
+/**
+ * @test
+ * @brief Verifies every half encoding survives a round trip through float.
+ */
+TEST(HalfTest, RoundTripsEveryEncoding) {
+  for (uint32_t bits = 0; bits <= 0xffff; ++bits) {
+    const Half h = Half::fromBits(uint16_t(bits));
+    const float f = float(h);
+    if ((bits & 0x7c00) == 0x7c00 && (bits & 0x3ff)) {
+      EXPECT_TRUE(std::isnan(f)) << bits;
+      EXPECT_TRUE(std::isnan(float(Half(f)))) << bits;
+    } else {
+      ASSERT_EQ(Half(f).bits, bits) << "f=" << f;
+    }
+  }
+}
+
+/**
+ * @test
+ * @brief Verifies rounding to nearest even, overflow and subnormals.
+ */
+TEST(HalfTest, RoundsToNearestEven) {
+  EXPECT_EQ(Half(1.f).bits, 0x3c00);
+  EXPECT_EQ(Half(-2.f).bits, 0xc000);
+  EXPECT_EQ(Half(65504.f).bits, 0x7bff);
+  EXPECT_EQ(Half(65519.f).bits, 0x7bff);
+  EXPECT_EQ(Half(65520.f).bits, 0x7c00);  // rounds up to infinity
+  EXPECT_EQ(Half(-1e10f).bits, 0xfc00);
+  EXPECT_EQ(Half(std::ldexp(1.f, -24)).bits, 0x0001);
+  EXPECT_EQ(Half(std::ldexp(1.f, -25)).bits, 0x0000);  // tie to even
+  EXPECT_EQ(Half(std::ldexp(3.f, -25)).bits, 0x0002);  // tie to even
+  EXPECT_EQ(Half(1.f + std::ldexp(1.f, -11)).bits, 0x3c00);
+  EXPECT_EQ(Half(1.f + std::ldexp(3.f, -11)).bits, 0x3c02);
+  EXPECT_EQ(Half(-0.f).bits, 0x8000);
+  EXPECT_EQ(float(Half::fromBits(0x0001)), std::ldexp(1.f, -24));
+  EXPECT_TRUE(std::isinf(float(Half::fromBits(0x7c00))));
+}
+
+/**
+ * @test
+ * @brief Verifies every bfloat16 encoding survives a round trip and that
+ * conversion rounds to nearest even and quiets NaNs.
+ */
+TEST(BFloat16Test, RoundTripsAndRounds) {
+  for (uint32_t bits = 0; bits <= 0xffff; ++bits) {
+    const float f = float(BFloat16::fromBits(uint16_t(bits)));
+    if (std::isnan(f))
+      EXPECT_TRUE(std::isnan(float(BFloat16(f)))) << bits;
+    else
+      ASSERT_EQ(BFloat16(f).bits, bits) << "f=" << f;
+  }
+  EXPECT_EQ(BFloat16(1.f).bits, 0x3f80);
+  EXPECT_EQ(BFloat16(1.f + std::ldexp(1.f, -8)).bits, 0x3f80);
+  EXPECT_EQ(BFloat16(1.f + std::ldexp(3.f, -8)).bits, 0x3f82);
+  EXPECT_EQ(BFloat16(std::numeric_limits<float>::max()).bits, 0x7f80);
+  const float snan = std::numeric_limits<float>::signaling_NaN();
+  EXPECT_TRUE(std::isnan(float(BFloat16(snan))));
+  EXPECT_EQ(BFloat16(snan).bits & 0x40, 0x40);
+}
+
+/**
+ * @test
+ * @brief Verifies tensors of 16-bit types allocate two bytes per element.
+ */
+TEST(HalfTest, TensorStorage) {
+  Tensor<Half> t(Shape{4, 8});
+  EXPECT_EQ(t.numel(), 32u);
+  EXPECT_EQ(t[31].bits, 0);
+  t.fill(Half(0.5f));
+  EXPECT_EQ(float(t(3, 7)), 0.5f);
+  EXPECT_EQ(reinterpret_cast<const char*>(t.data() + 32) -
+                reinterpret_cast<const char*>(t.data()),
+            64);
+  Tensor<BFloat16> b(Shape{2});
+  b[1] = BFloat16(-3.f);
+  EXPECT_EQ(float(b.clone()[1]), -3.f);
+}
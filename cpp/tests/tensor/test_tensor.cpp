@@ -0,0 +1,78 @@
+/**
+ * @file test_tensor.cpp
+ * @brief Unit tests for the Shape and Tensor classes.
+ *
+ * This file verifies allocation, alignment, element access, views and the
+ * shallow copy semantics of Tensor.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "tensor/tensor.hpp"
+
+/**
+ * @test ShapeTest.RankAndNumel
+ * @brief Tests that a Shape reports its rank, extents and element count.
+ */
+TEST(ShapeTest, RankAndNumel) {
+  Shape s{2, 3, 4};
+  EXPECT_EQ(s.rank(), 3u);
+  EXPECT_EQ(s[1], 3u);
+  EXPECT_EQ(s.numel(), 24u);
+  s.push_back(5);
+  EXPECT_EQ(s.numel(), 120u);
+  EXPECT_EQ(s, (Shape{2, 3, 4, 5}));
+  EXPECT_THROW((Shape{1, 1, 1, 1, 1, 1, 1}), std::invalid_argument);
+}
+
+/**
+ * @test TensorTest.AllocatesZeroedAlignedBuffer
+ * @brief Tests that a new tensor is zero-initialized and cache-line aligned.
+ */
+TEST(TensorTest, AllocatesZeroedAlignedBuffer) {
+  Tensor<float> t(Shape{3, 5});
+  ASSERT_FALSE(t.empty());
+  EXPECT_EQ(t.numel(), 15u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(t.data()) % kTensorAlignment, 0u);
+  for (size_t i = 0; i < t.numel(); ++i) EXPECT_EQ(t[i], 0.f);
+}
+
+/**
+ * @test TensorTest.RowMajorIndexing
+ * @brief Tests that multi-dimensional indexing is row-major.
+ */
+TEST(TensorTest, RowMajorIndexing) {
+  Tensor<int> t(Shape{2, 3, 4});
+  t(1, 2, 3) = 7;
+  EXPECT_EQ(t[1 * 12 + 2 * 4 + 3], 7);
+}
+
+/**
+ * @test TensorTest.CopiesShareAndCloneDoesNot
+ * @brief Tests shallow copy, reshape and clone semantics.
+ */
+TEST(TensorTest, CopiesShareAndCloneDoesNot) {
+  Tensor<float> a(Shape{2, 2});
+  Tensor<float> b = a;
+  Tensor<float> c = a.reshape(Shape{4});
+  Tensor<float> d = a.clone();
+  a(0, 1) = 3.f;
+  EXPECT_EQ(b(0, 1), 3.f);
+  EXPECT_EQ(c[1], 3.f);
+  EXPECT_EQ(d(0, 1), 0.f);
+  EXPECT_THROW(a.reshape(Shape{3}), std::invalid_argument);
+}
+
+/**
+ * @test TensorTest.WrapsExternalMemory
+ * @brief Tests that wrap() creates a view without copying.
+ */
+TEST(TensorTest, WrapsExternalMemory) {
+  float buffer[6] = {0, 1, 2, 3, 4, 5};
+  auto t = Tensor<float>::wrap(buffer, Shape{2, 3});
+  EXPECT_EQ(t.data(), buffer);
+  EXPECT_EQ(t(1, 2), 5.f);
+  EXPECT_EQ(t.storage(), nullptr);
+}
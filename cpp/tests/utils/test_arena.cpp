@@ -0,0 +1,141 @@
+/**
+ * @file test_arena.cpp
+ * @brief Unit tests for the monotonic arena and the thread-local pool
+ * allocator.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "utils/arena.h"
+
+/**
+ * @brief Upstream resource counting the blocks it hands out.
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0; /**< Calls to allocate() */
+  size_t live = 0;        /**< Bytes not yet deallocated */
+
+ protected:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    live += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    live -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * @test
+ * @brief Verifies alignment, that allocations do not overlap, and that the
+ * arena grows as needed.
+ */
+TEST(MonotonicArenaTest, AllocatesAlignedAndGrows) {
+  EXPECT_THROW(MonotonicArena(0), std::invalid_argument);
+  CountingResource upstream;
+  MonotonicArena arena(256, &upstream);
+  EXPECT_EQ(arena.capacity(), 0u);  // lazy
+  char* a = static_cast<char*>(arena.allocate(10, 1));
+  auto* b = static_cast<double*>(arena.allocate(sizeof(double), 8));
+  void* c = arena.allocate(100, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+  EXPECT_GE(reinterpret_cast<char*>(b), a + 10);
+  EXPECT_GE(static_cast<char*>(c), reinterpret_cast<char*>(b + 1));
+  EXPECT_EQ(upstream.allocations, 1u);
+  EXPECT_GE(arena.used(), 10u + 8u + 100u);
+
+  void* big = arena.allocate(1000, 16);  // larger than any block so far
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 16, 0u);
+  EXPECT_EQ(upstream.allocations, 2u);
+  EXPECT_GE(arena.capacity(), 256u + 1000u);
+  arena.deallocate(big, 1000, 16);  // no-op
+}
+
+/**
+ * @test
+ * @brief Verifies that reset() merges the blocks so the next batch of the
+ * same size needs no upstream allocation, and release() frees everything.
+ */
+TEST(MonotonicArenaTest, ResetReusesMergedBlock) {
+  CountingResource upstream;
+  MonotonicArena arena(128, &upstream);
+  auto batch = [&] {
+    for (int i = 0; i < 20; ++i) (void)arena.allocate(100, 8);
+  };
+  batch();
+  const size_t grown = upstream.allocations;
+  EXPECT_GT(grown, 1u);
+  const size_t capacity = arena.capacity();
+  arena.reset();
+  EXPECT_EQ(arena.used(), 0u);
+  EXPECT_EQ(arena.capacity(), capacity);
+  EXPECT_EQ(upstream.allocations, grown + 1);  // the merged block
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    batch();
+    arena.reset();
+  }
+  EXPECT_EQ(upstream.allocations, grown + 1);
+  arena.release();
+  EXPECT_EQ(arena.capacity(), 0u);
+  EXPECT_EQ(upstream.live, 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies std::pmr containers and tensors backed by an arena.
+ */
+TEST(MonotonicArenaTest, BacksContainersAndTensors) {
+  MonotonicArena arena;
+  std::pmr::vector<int> values(&arena);
+  for (int i = 0; i < 1000; ++i) values.push_back(i);
+  EXPECT_EQ(values[999], 999);
+
+  Tensor<float> t(Shape{3, 5}, &arena);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(t.data()) % kTensorAlignment, 0u);
+  EXPECT_EQ(t.numel(), 15u);
+  EXPECT_EQ(t(2, 4), 0.0f);
+  t.fill(1.5f);
+  Tensor<float> copy = t;
+  EXPECT_EQ(copy(1, 1), 1.5f);
+  EXPECT_TRUE(Tensor<float>(Shape{0}, &arena).empty());
+}
+
+/**
+ * @test
+ * @brief Verifies that each thread gets its own pool and that it serves
+ * allocations.
+ */
+TEST(ThreadPoolResourceTest, PerThreadPool) {
+  std::pmr::memory_resource* main_pool = thread_pool_resource();
+  EXPECT_EQ(thread_pool_resource(), main_pool);
+  std::pmr::memory_resource* other_pool = nullptr;
+  std::thread([&] {
+    other_pool = thread_pool_resource();
+    std::pmr::vector<int> v(other_pool);
+    v.assign(100, 7);
+    EXPECT_EQ(v[99], 7);
+  }).join();
+  EXPECT_NE(other_pool, main_pool);
+
+  std::pmr::vector<std::pmr::vector<int>> rows(main_pool);
+  for (int i = 0; i < 50; ++i) rows.emplace_back(size_t(i + 1), i);
+  EXPECT_EQ(rows[49].size(), 50u);
+  EXPECT_EQ(rows[49].get_allocator().resource(), main_pool);
+}
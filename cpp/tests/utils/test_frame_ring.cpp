@@ -0,0 +1,324 @@
+/**
+ * @file test_frame_ring.cpp
+ * @brief Unit tests for the shared-memory frame ring: publishing, zero-copy
+ * reads, pinning, waiting, a producer in another process, corrupt rings
+ * and readers that die while attached.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "utils/frame_ring.h"
+
+/**
+ * @brief Get a ring name unique to this test process.
+ */
+static std::string ring_name(const std::string& test) {
+  return "/vf_test_" + test + "_" + std::to_string(::getpid());
+}
+
+/**
+ * @brief Publish a width x height RGB frame filled with @p value.
+ */
+static bool write_frame(FrameRingWriter& ring, uint32_t width,
+                        uint32_t height, uint8_t value) {
+  FrameInfo info;
+  info.width = width;
+  info.height = height;
+  info.channels = 3;
+  info.timestamp_ns = value;
+  const std::vector<uint8_t> pixels(info.bytes(), value);
+  return ring.write(info, pixels.data());
+}
+
+/**
+ * @test
+ * @brief Verifies publishing, lookup by sequence, the newest frame and the
+ * zero-copy tensor view.
+ */
+TEST(FrameRingTest, PublishesAndReadsInPlace) {
+  const std::string name = ring_name("basic");
+  FrameRingWriter writer(name, 4, 8 * 4 * 3);
+  FrameRingReader reader(name);
+  EXPECT_EQ(reader.slots(), 4u);
+  EXPECT_EQ(reader.published(), 0u);
+  EXPECT_FALSE(reader.latest());
+  EXPECT_FALSE(reader.get(0));
+
+  for (uint8_t v = 0; v < 6; ++v) EXPECT_TRUE(write_frame(writer, 8, 4, v));
+  EXPECT_EQ(reader.published(), 6u);
+  EXPECT_FALSE(reader.get(1));  // overwritten
+  std::optional<SharedFrame> frame = reader.get(3);
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(frame->info.sequence, 3u);
+  EXPECT_EQ(frame->info.timestamp_ns, 3u);
+  EXPECT_EQ(frame->info.width, 8u);
+  EXPECT_EQ(uintptr_t(frame->data) % kCacheLineSize, 0u);
+
+  Tensor<uint8_t> pixels = frame->tensor<uint8_t>();
+  EXPECT_EQ(pixels.shape(), (Shape{4, 8, 3}));
+  EXPECT_EQ(pixels.data(), frame->data);  // no copy
+  EXPECT_EQ(pixels(3, 7, 2), 3);
+  EXPECT_THROW(frame->tensor<float>(), std::invalid_argument);
+
+  std::optional<SharedFrame> newest = reader.latest();
+  ASSERT_TRUE(newest);
+  EXPECT_EQ(newest->info.sequence, 5u);
+  EXPECT_EQ(newest->data[0], 5);
+}
+
+/**
+ * @test
+ * @brief Verifies that held frames are never overwritten and that the
+ * writer drops frames when every slot is held.
+ */
+TEST(FrameRingTest, PinnedSlotsAreSkipped) {
+  const std::string name = ring_name("pins");
+  FrameRingWriter writer(name, 3, 16 * 16 * 3);
+  FrameRingReader reader(name);
+  ASSERT_TRUE(write_frame(writer, 16, 16, 0));
+  Tensor<uint8_t> held = reader.get(0)->tensor<uint8_t>();
+  for (uint8_t v = 1; v < 20; ++v) ASSERT_TRUE(write_frame(writer, 16, 16, v));
+  EXPECT_TRUE(std::all_of(held.data(), held.data() + held.numel(),
+                          [](uint8_t p) { return p == 0; }));
+  ASSERT_TRUE(reader.get(0));
+
+  std::optional<SharedFrame> second = reader.latest();
+  ASSERT_TRUE(second);
+  ASSERT_TRUE(write_frame(writer, 16, 16, 20));
+  std::optional<SharedFrame> third = reader.latest();
+  ASSERT_TRUE(third);
+  EXPECT_EQ(third->info.sequence, 20u);
+  EXPECT_FALSE(write_frame(writer, 16, 16, 21));  // all three held
+  EXPECT_EQ(writer.dropped(), 1u);
+
+  held = Tensor<uint8_t>();
+  EXPECT_TRUE(write_frame(writer, 16, 16, 22));  // reuses slot 0
+  EXPECT_FALSE(reader.get(0));
+  EXPECT_EQ(second->data[0], 19);
+}
+
+/**
+ * @test
+ * @brief Verifies argument checks, the reader limit and that a missing
+ * ring is reported.
+ */
+TEST(FrameRingTest, RejectsBadUse) {
+  const std::string name = ring_name("errors");
+  EXPECT_THROW(FrameRingWriter(name, 1, 64), std::invalid_argument);
+  EXPECT_THROW(FrameRingWriter(name, kMaxFrameSlots + 1, 64),
+               std::invalid_argument);
+  EXPECT_THROW(FrameRingWriter(name, 2, 0), std::invalid_argument);
+  EXPECT_THROW(FrameRingReader reader(name), std::system_error);
+
+  FrameRingWriter writer(name, 2, 12);
+  EXPECT_THROW(writer.commit(FrameInfo{}), std::logic_error);
+  FrameInfo big;
+  big.width = big.height = 4;
+  big.channels = 1;
+  EXPECT_THROW(writer.write(big, nullptr), std::invalid_argument);
+
+  std::vector<std::unique_ptr<FrameRingReader>> readers;
+  for (size_t i = 0; i < kMaxFrameReaders; ++i)
+    readers.push_back(std::make_unique<FrameRingReader>(name));
+  EXPECT_THROW(FrameRingReader extra(name), std::runtime_error);
+  readers.pop_back();
+  EXPECT_NO_THROW(FrameRingReader again(name));
+}
+
+/**
+ * @brief Fork a process that attaches a reader, pins the frames with the
+ * given sequence numbers and exits without detaching.
+ */
+static void run_dying_reader(const std::string& name,
+                             const std::vector<uint64_t>& frames) {
+  const pid_t child = ::fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    int status = 1;
+    try {
+      auto* reader = new FrameRingReader(name);
+      for (const uint64_t sequence : frames)
+        new std::optional<SharedFrame>(reader->get(sequence));
+      status = 0;
+    } catch (...) {
+    }
+    ::_exit(status);
+  }
+  int status = 0;
+  ASSERT_EQ(::waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+/**
+ * @test
+ * @brief Verifies that entries and pins of readers whose process died are
+ * reclaimed by new readers and by the writer.
+ */
+TEST(FrameRingTest, ReclaimsDeadReaders) {
+  const std::string name = ring_name("dead");
+  FrameRingWriter writer(name, 2, 2 * 2 * 3);
+  ASSERT_TRUE(write_frame(writer, 2, 2, 0));
+  ASSERT_TRUE(write_frame(writer, 2, 2, 1));
+
+  for (size_t i = 0; i < kMaxFrameReaders; ++i) run_dying_reader(name, {});
+  {
+    std::vector<std::unique_ptr<FrameRingReader>> readers;
+    for (size_t i = 0; i < kMaxFrameReaders; ++i)
+      readers.push_back(std::make_unique<FrameRingReader>(name));
+  }
+
+  run_dying_reader(name, {0, 1});
+  EXPECT_TRUE(write_frame(writer, 2, 2, 2));
+  EXPECT_EQ(writer.dropped(), 0u);
+  FrameRingReader reader(name);
+  ASSERT_TRUE(reader.get(2));
+  EXPECT_EQ(reader.get(2)->data[0], 2);
+}
+
+/**
+ * @test
+ * @brief Verifies that a reader rejects a slot layout or frame description
+ * that does not fit the ring.
+ */
+TEST(FrameRingTest, RejectsCorruptRings) {
+  const std::string name = ring_name("corrupt");
+  FrameRingWriter writer(name, 2, 64);
+  ASSERT_TRUE(write_frame(writer, 2, 2, 7));
+  FrameRingReader reader(name);
+
+  const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  struct stat st {};
+  ASSERT_EQ(::fstat(fd, &st), 0);
+  void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  ::close(fd);
+  ASSERT_NE(p, MAP_FAILED);
+  auto* header = static_cast<FrameRingHeader*>(p);
+  const size_t first_slot = (sizeof(FrameRingHeader) + kCacheLineSize - 1) /
+                            kCacheLineSize * kCacheLineSize;
+  FrameInfo& info = reinterpret_cast<FrameSlotHeader*>(
+                        static_cast<uint8_t*>(p) + first_slot)
+                        ->info;
+
+  const FrameInfo good = info;
+  info.width = 1000;
+  EXPECT_THROW(reader.get(0), std::runtime_error);
+  info.width = info.height = info.channels = UINT32_MAX;
+  info.type = FramePixelType::kFloat32;
+  EXPECT_THROW(reader.latest(), std::runtime_error);
+  info = good;
+  EXPECT_EQ(reader.get(0)->data[0], 7);
+
+  const uint64_t stride = header->slot_stride;
+  header->slot_stride = sizeof(FrameSlotHeader);
+  EXPECT_THROW(FrameRingReader bad(name), std::runtime_error);
+  header->slot_stride = stride;
+  EXPECT_NO_THROW(FrameRingReader again(name));
+  ::munmap(p, size_t(st.st_size));
+}
+
+/**
+ * @test
+ * @brief Verifies waiting for frames, timeouts, live-stream reads and that
+ * closing the ring wakes readers.
+ */
+TEST(FrameRingTest, WaitsForFrames) {
+  const std::string name = ring_name("wait");
+  auto writer = std::make_unique<FrameRingWriter>(name, 4, 2 * 2 * 3);
+  FrameRingReader reader(name);
+  EXPECT_FALSE(reader.waitFor(0, std::chrono::milliseconds(5)));
+  EXPECT_FALSE(reader.waitLatest(UINT64_MAX, std::chrono::milliseconds(5)));
+
+  std::thread producer([&] {
+    for (uint8_t v = 0; v < 50; ++v) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      write_frame(*writer, 2, 2, v);
+    }
+  });
+  EXPECT_TRUE(reader.waitFor(49, std::chrono::seconds(10)));
+  producer.join();
+  std::optional<SharedFrame> frame =
+      reader.waitLatest(UINT64_MAX, std::chrono::seconds(1));
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(frame->info.sequence, 49u);
+  EXPECT_FALSE(reader.waitLatest(49, std::chrono::milliseconds(5)));
+  frame.reset();
+
+  std::thread closer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    writer.reset();
+  });
+  EXPECT_FALSE(reader.waitFor(50, std::chrono::seconds(10)));
+  closer.join();
+  EXPECT_TRUE(reader.closed());
+  EXPECT_EQ(reader.get(49)->data[0], 49);  // still mapped
+}
+
+/**
+ * @test
+ * @brief Verifies a reader in another process: every frame it holds is
+ * whole, and frames arrive in order.
+ */
+TEST(FrameRingTest, CrossProcessReader) {
+  const std::string name = ring_name("process");
+  constexpr uint32_t kWidth = 64, kHeight = 48;
+  constexpr uint64_t kFrames = 300;
+  FrameRingWriter writer(name, 4, kWidth * kHeight * 3);
+
+  const pid_t child = ::fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    int status = 1;
+    try {
+      FrameRingReader reader(name);
+      uint64_t last = UINT64_MAX;
+      size_t seen = 0;
+      while (last + 1 < kFrames) {
+        std::optional<SharedFrame> frame =
+            reader.waitLatest(last, std::chrono::seconds(10));
+        if (!frame) break;
+        if (last != UINT64_MAX && frame->info.sequence <= last) break;
+        last = frame->info.sequence;
+        const auto value = uint8_t(last);
+        const uint8_t* end = frame->data + frame->info.bytes();
+        if (!std::all_of(frame->data, end,
+                         [&](uint8_t p) { return p == value; }))
+          break;
+        ++seen;
+      }
+      status = last + 1 == kFrames && seen > 0 ? 0 : 2;
+    } catch (...) {
+      status = 3;
+    }
+    ::_exit(status);
+  }
+
+  // Give the reader a head start; it catches up with waitLatest() anyway.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (uint64_t i = 0; i < kFrames; ++i) {
+    while (!write_frame(writer, kWidth, kHeight, uint8_t(i)))
+      std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  int status = 0;
+  ASSERT_EQ(::waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
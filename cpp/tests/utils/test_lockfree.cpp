@@ -0,0 +1,182 @@
+/**
+ * @file test_lockfree.cpp
+ * @brief Stress tests for the lock-free queues, the object pool and the
+ * futex wait primitives.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/mpmc_queue.h"
+#include "utils/object_pool.h"
+#include "utils/spsc_queue.h"
+#include "utils/wait.h"
+
+/**
+ * @test
+ * @brief Verifies the SPSC queue in order, at capacity, and across threads
+ * with a sleeping consumer.
+ */
+TEST(SpscQueueTest, OrderCapacityAndStress) {
+  EXPECT_THROW(SpscQueue<int>(0), std::invalid_argument);
+  SpscQueue<std::unique_ptr<int>> small(3);
+  EXPECT_EQ(small.capacity(), 4u);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(small.tryPush(std::make_unique<int>(i)));
+  auto extra = std::make_unique<int>(9);
+  EXPECT_FALSE(small.tryPush(extra));
+  EXPECT_NE(extra, nullptr);  // untouched on failure
+  EXPECT_EQ(small.size(), 4u);
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(small.tryPop(value));
+    EXPECT_EQ(*value, i);
+  }
+  EXPECT_FALSE(small.tryPop(value));
+
+  constexpr uint64_t kItems = 200000;
+  SpscQueue<uint64_t> queue(64);
+  EventCount pushed;
+  uint64_t expected = 0;
+  bool in_order = true;
+  std::thread consumer([&] {
+    for (uint64_t item; expected < kItems;) {
+      pushed.await([&] { return queue.tryPop(item); });
+      in_order = in_order && item == expected;
+      ++expected;
+    }
+  });
+  for (uint64_t i = 0; i < kItems; ++i) {
+    while (!queue.tryPush(i)) std::this_thread::yield();
+    pushed.notify();
+  }
+  consumer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(expected, kItems);
+}
+
+/**
+ * @test
+ * @brief Verifies the MPMC queue delivers every item exactly once, in
+ * order per producer, under many producers and consumers.
+ */
+TEST(MpmcQueueTest, ExactlyOnceUnderContention) {
+  MpmcQueue<int> small(1);
+  EXPECT_EQ(small.capacity(), 2u);
+  EXPECT_TRUE(small.tryPush(1));
+  EXPECT_TRUE(small.tryPush(2));
+  EXPECT_FALSE(small.tryPush(3));
+  int value = 0;
+  EXPECT_TRUE(small.tryPop(value));
+  EXPECT_EQ(value, 1);
+
+  constexpr int kProducers = 4, kConsumers = 4, kItems = 50000;
+  MpmcQueue<int> queue(128);
+  std::vector<std::atomic<int>> seen(kProducers * kItems);
+  std::atomic<int> consumed{0};
+  std::atomic<bool> ordered{true};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p)
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < kItems; ++i)
+        while (!queue.tryPush(p * kItems + i)) std::this_thread::yield();
+    });
+  for (int c = 0; c < kConsumers; ++c)
+    threads.emplace_back([&] {
+      std::vector<int> last(kProducers, -1);
+      for (int item; consumed.load() < kProducers * kItems;) {
+        if (!queue.tryPop(item)) {
+          std::this_thread::yield();
+          continue;
+        }
+        seen[item].fetch_add(1);
+        consumed.fetch_add(1);
+        const int p = item / kItems, i = item % kItems;
+        if (i <= last[p]) ordered = false;
+        last[p] = i;
+      }
+    });
+  for (std::thread& t : threads) t.join();
+  int duplicates_or_losses = 0;
+  for (const auto& count : seen) duplicates_or_losses += count.load() != 1;
+  EXPECT_EQ(duplicates_or_losses, 0);
+  EXPECT_TRUE(ordered.load());
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies objects are recycled, exclusive and waited for.
+ */
+TEST(ObjectPoolTest, RecyclesExclusively) {
+  EXPECT_THROW(ObjectPool<int>(0), std::invalid_argument);
+  ObjectPool<std::vector<float>> buffers(
+      2, [] { return std::make_unique<std::vector<float>>(1024); });
+  const float* first = nullptr;
+  {
+    auto a = buffers.acquire();
+    auto b = buffers.tryAcquire();
+    ASSERT_TRUE(a && b);
+    EXPECT_EQ(a->size(), 1024u);
+    first = a->data();
+    EXPECT_FALSE(buffers.tryAcquire());
+    EXPECT_EQ(buffers.available(), 0u);
+
+    // A waiting acquire() wakes when a handle is released.
+    std::thread waiter([&] {
+      auto c = buffers.acquire();
+      EXPECT_TRUE(c);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    a.reset();
+    waiter.join();
+  }
+  EXPECT_EQ(buffers.available(), 2u);
+  bool recycled = false;
+  for (int i = 0; i < 2; ++i) {
+    auto handle = buffers.acquire();
+    recycled = recycled || handle->data() == first;
+  }
+  EXPECT_TRUE(recycled);
+
+  ObjectPool<std::atomic<int>> pool(3);
+  std::atomic<int> overlaps{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 6; ++t)
+    threads.emplace_back([&] {
+      for (int i = 0; i < 20000; ++i) {
+        auto user = pool.acquire();
+        if (user->fetch_add(1) != 0) ++overlaps;
+        user->fetch_sub(1);
+      }
+    });
+  for (std::thread& t : threads) t.join();
+  EXPECT_EQ(overlaps.load(), 0);
+  EXPECT_EQ(pool.available(), 3u);
+}
+
+/**
+ * @test
+ * @brief Verifies futex waits time out, and wake on a changed word.
+ */
+TEST(FutexTest, WaitsAndWakes) {
+  std::atomic<uint32_t> word{0};
+  EXPECT_FALSE(futex_wait_for(word, 0, std::chrono::milliseconds(5)));
+  futex_wait(word, 1);  // returns at once: the word differs
+
+  std::thread waker([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    word.store(1);
+    futex_wake(word, true);
+  });
+  while (word.load() == 0) futex_wait(word, 0);
+  waker.join();
+  EXPECT_EQ(word.load(), 1u);
+}
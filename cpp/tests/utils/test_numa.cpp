@@ -0,0 +1,172 @@
+/**
+ * @file test_numa.cpp
+ * @brief Unit tests for NUMA topology discovery and node-local allocation.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/numa.h"
+
+/**
+ * @test
+ * @brief Verifies parsing of kernel CPU lists.
+ */
+TEST(NumaTest, ParsesCpuLists) {
+  EXPECT_EQ(parse_cpu_list("0-3,8,10-11\n"),
+            (std::vector<size_t>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(parse_cpu_list("5,1-2,2"), (std::vector<size_t>{1, 2, 5}));
+  EXPECT_TRUE(parse_cpu_list("").empty());
+  EXPECT_THROW(parse_cpu_list("3-1"), std::invalid_argument);
+  EXPECT_THROW(parse_cpu_list("a"), std::invalid_argument);
+  EXPECT_THROW(parse_cpu_list("1-2x"), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies the topology is read from a sysfs-like directory tree.
+ */
+TEST(NumaTest, ReadsSysfsTopology) {
+  namespace fs = std::filesystem;
+  const fs::path root = fs::temp_directory_path() / "vf_test_numa";
+  fs::remove_all(root);
+  const auto write = [&](const std::string& node, const std::string& cpus,
+                         const std::string& meminfo) {
+    fs::create_directories(root / node);
+    std::ofstream(root / node / "cpulist") << cpus << "\n";
+    std::ofstream(root / node / "meminfo") << meminfo;
+  };
+  write("node1", "4-7", "Node 1 MemFree: 5 kB\nNode 1 MemTotal: 2048 kB\n");
+  write("node0", "0-3", "Node 0 MemTotal: 1024 kB\n");
+  write("node2", "", "");  // memory-only node
+  fs::create_directories(root / "power");
+  std::ofstream(root / "online") << "0-2\n";
+
+  const std::vector<NumaNode> nodes = read_numa_topology(root.string());
+  fs::remove_all(root);
+  ASSERT_EQ(nodes.size(), 3u);
+  EXPECT_EQ(nodes[0].id, 0u);
+  EXPECT_EQ(nodes[0].cpus, (std::vector<size_t>{0, 1, 2, 3}));
+  EXPECT_EQ(nodes[0].memory_bytes, 1024u * 1024u);
+  EXPECT_EQ(nodes[1].id, 1u);
+  EXPECT_EQ(nodes[1].cpus.front(), 4u);
+  EXPECT_EQ(nodes[1].memory_bytes, 2048u * 1024u);
+  EXPECT_TRUE(nodes[2].cpus.empty());
+  EXPECT_TRUE(read_numa_topology((root / "missing").string()).empty());
+}
+
+/**
+ * @test
+ * @brief Verifies the machine topology covers the CPUs in use.
+ */
+TEST(NumaTest, MachineTopology) {
+  const std::vector<NumaNode>& nodes = numa_nodes();
+  ASSERT_FALSE(nodes.empty());
+  size_t cpus = 0;
+  for (const NumaNode& node : nodes) {
+    cpus += node.cpus.size();
+    for (size_t cpu : node.cpus) EXPECT_EQ(numa_node_of_cpu(cpu), node.id);
+  }
+  EXPECT_GE(cpus, 1u);
+  const size_t here = current_numa_node();
+  EXPECT_TRUE(std::any_of(nodes.begin(), nodes.end(),
+                          [&](const NumaNode& n) { return n.id == here; }));
+}
+
+/**
+ * @test
+ * @brief Verifies node-local allocations are zeroed, aligned and placed.
+ */
+TEST(NumaTest, AllocatesOnNode) {
+  const size_t node = numa_nodes().front().id;
+  const size_t bytes = 1 << 20;
+  auto* data = static_cast<unsigned char*>(numa_alloc(bytes, node));
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % kTensorAlignment, 0u);
+  for (size_t i = 0; i < bytes; i += 4093) EXPECT_EQ(data[i], 0);
+  const int placed = numa_node_of_address(data + bytes / 2);
+  if (placed >= 0) {
+    EXPECT_EQ(size_t(placed), node);
+  }
+  numa_free(data, bytes);
+  EXPECT_EQ(numa_alloc(0, node), nullptr);
+  numa_free(nullptr, 0);
+  EXPECT_THROW(numa_alloc(64, 1 << 20), std::invalid_argument);
+
+  Tensor<float> t = numa_tensor<float>(Shape{3, 5}, node);
+  ASSERT_FALSE(t.empty());
+  EXPECT_EQ(t.numel(), 15u);
+  EXPECT_EQ(t[14], 0.f);
+  t[14] = 1.f;
+  Tensor<float> shared = t;
+  t = Tensor<float>();
+  EXPECT_EQ(shared[14], 1.f);  // storage outlives the first handle
+  const Tensor<float> none = numa_tensor<float>(Shape{0, 4}, node);
+  EXPECT_EQ(none.shape(), (Shape{0, 4}));
+  EXPECT_EQ(none.numel(), 0u);
+}
+
+/**
+ * @test
+ * @brief Verifies the buffer cache recycles released node-local memory.
+ */
+TEST(NumaTest, BufferCacheRecycles) {
+  const size_t node = numa_nodes().front().id;
+  NumaBufferCache cache(2);
+  Tensor<float> a = cache.tensor<float>(Shape{64, 64}, node);
+  const float* first = a.data();
+  Tensor<float> b = cache.tensor<float>(Shape{64, 64}, node);
+  EXPECT_NE(b.data(), first);  // a is still in use
+  a = Tensor<float>();
+  const Tensor<float> c = cache.tensor<float>(Shape{32, 64}, node);
+  EXPECT_EQ(c.data(), first);  // smaller requests fit released buffers
+  EXPECT_EQ(cache.size(), 2u);
+
+  // Beyond the capacity allocations are handed out uncached.
+  const Tensor<float> d = cache.tensor<float>(Shape{64, 64}, node);
+  EXPECT_NE(d.data(), b.data());
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.tensor<float>(Shape{0, 3}, node).shape(), (Shape{0, 3}));
+  EXPECT_THROW(cache.tensor<float>(Shape{4}, 1 << 20), std::invalid_argument);
+}
+
+/**
+ * @test
+ * @brief Verifies parallel work and thread binding through a node's pool.
+ */
+TEST(NumaTest, NodeThreadPool) {
+  const NumaNode& node = numa_nodes().front();
+  ThreadPool& pool = numa_thread_pool(node.id);
+  EXPECT_EQ(&numa_thread_pool(node.id), &pool);
+  EXPECT_THROW(numa_thread_pool(1 << 20), std::invalid_argument);
+
+  set_num_threads(4);
+  std::atomic<size_t> count{0};
+  std::atomic<bool> off_node{false};
+  size_t workers = 0;
+  // A separate thread, so the binding does not outlive the test.
+  std::thread([&] {
+    bind_thread_to_numa_node(node.id);
+    ThreadPoolScope scope(pool);
+    parallel_for(0, 1000, 1, [&](size_t b, size_t e) {
+      if (current_numa_node() != node.id) off_node = true;
+      count += e - b;
+    });
+    workers = pool_workers();
+  }).join();
+  set_num_threads(0);
+  // A node pool never has more threads than the node has CPUs.
+  EXPECT_LT(workers, node.cpus.size());
+  EXPECT_EQ(count.load(), 1000u);
+  EXPECT_FALSE(off_node.load());
+  EXPECT_THROW(bind_thread_to_numa_node(1 << 20), std::invalid_argument);
+}
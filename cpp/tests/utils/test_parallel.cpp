@@ -0,0 +1,307 @@
+/**
+ * @file test_parallel.cpp
+ * @brief Unit tests for `parallel_for`, task groups and the thread pool.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/parallel.h"
+
+/**
+ * @test
+ * @brief Verifies that every index is visited exactly once.
+ */
+TEST(ParallelForTest, VisitsEveryIndexOnce) {
+  set_num_threads(4);
+  std::vector<std::atomic<int>> hits(1000);
+  parallel_for(0, hits.size(), 7, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i) hits[i].fetch_add(1);
+  });
+  set_num_threads(0);
+  for (auto& h : hits) EXPECT_EQ(h.load(), 1);
+}
+
+/**
+ * @test
+ * @brief Verifies that ranges smaller than the grain run as a single chunk.
+ */
+TEST(ParallelForTest, SmallRangeRunsInline) {
+  set_num_threads(4);
+  int chunks = 0;
+  parallel_for(3, 10, 100, [&](size_t b, size_t e) {
+    ++chunks;
+    EXPECT_EQ(b, 3u);
+    EXPECT_EQ(e, 10u);
+  });
+  set_num_threads(0);
+  EXPECT_EQ(chunks, 1);
+}
+
+/**
+ * @test
+ * @brief Verifies that nested parallel_for() calls complete without
+ * deadlock, with inner ranges split as well.
+ */
+TEST(ParallelForTest, NestedCallsDoNotDeadlock) {
+  set_num_threads(4);
+  std::atomic<int> inner_chunks{0};
+  std::vector<std::atomic<int>> hits(8 * 8 * 64);
+  for (int repeat = 0; repeat < 20; ++repeat) {
+    inner_chunks = 0;
+    for (auto& h : hits) h = 0;
+    parallel_for(0, 8, 1, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; ++i)
+        parallel_for(0, 8, 1, [&](size_t jb, size_t je) {
+          for (size_t j = jb; j < je; ++j)
+            parallel_for(0, 64, 4, [&](size_t kb, size_t ke) {
+              inner_chunks.fetch_add(1);
+              for (size_t k = kb; k < ke; ++k)
+                hits[(i * 8 + j) * 64 + k].fetch_add(1);
+            });
+        });
+    });
+    for (auto& h : hits) ASSERT_EQ(h.load(), 1);
+    EXPECT_GT(inner_chunks.load(), 64);
+  }
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies that chunks honour the grain and that the pool threads
+ * are reused across calls.
+ */
+TEST(ParallelForTest, ReusesPoolThreads) {
+  set_num_threads(4);
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  for (int repeat = 0; repeat < 50; ++repeat) {
+    parallel_for(0, 4096, 16, [&](size_t b, size_t e) {
+      EXPECT_GE(e - b, 16u);
+      std::lock_guard<std::mutex> lock(mutex);
+      ids.insert(std::this_thread::get_id());
+    });
+  }
+  EXPECT_LE(ids.size(), 4u);
+  EXPECT_GE(pool_workers(), 3u);
+  const size_t workers = pool_workers();
+  parallel_for(0, 4096, 16, [](size_t, size_t) {});
+  EXPECT_EQ(pool_workers(), workers);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies task groups, including nested groups and parallel loops
+ * inside tasks, and exception propagation.
+ */
+TEST(TaskGroupTest, RunsNestedTasks) {
+  set_num_threads(3);
+  std::atomic<int> sum{0};
+  {
+    TaskGroup outer;
+    for (int i = 0; i < 16; ++i) {
+      outer.run([&sum, i] {
+        TaskGroup inner;
+        for (int j = 0; j < 4; ++j)
+          inner.run([&sum, i, j] {
+            parallel_for(0, 10, 1, [&](size_t b, size_t e) {
+              sum.fetch_add(int(e - b) * (i * 4 + j));
+            });
+          });
+        inner.wait();
+      });
+    }
+    outer.wait();
+  }
+  EXPECT_EQ(sum.load(), 10 * (63 * 64 / 2));
+
+  TaskGroup failing;
+  failing.run([] { throw std::runtime_error("task"); });
+  failing.run([] {});
+  EXPECT_THROW(failing.wait(), std::runtime_error);
+  failing.run([&sum] { sum = -1; });
+  failing.wait();
+  EXPECT_EQ(sum.load(), -1);
+
+  // Tasks run on the waiting thread when no worker may take part.
+  set_num_threads(1);
+  TaskGroup serial;
+  std::thread::id ran_on;
+  serial.run([&] { ran_on = std::this_thread::get_id(); });
+  serial.wait();
+  EXPECT_EQ(ran_on, std::this_thread::get_id());
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies that a waiting thread runs tasks of other groups that
+ * sit on top of its own deque, so a single thread cannot stall.
+ */
+TEST(TaskGroupTest, WaitRunsOwnDequeFirst) {
+  set_num_threads(1);
+  std::atomic<int> ran{0};
+  TaskGroup outer;
+  outer.run([&] {
+    TaskGroup later;
+    parallel_for(0, 4, 1, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; ++i) {
+        TaskGroup inner;
+        inner.run([&] { ++ran; });
+        later.run([&] { ++ran; });  // pushed on top of inner's task
+        inner.wait();
+      }
+    });
+    later.wait();
+  });
+  outer.wait();
+  EXPECT_EQ(ran.load(), 8);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies parallel loops started from several outside threads.
+ */
+TEST(TaskGroupTest, ExternalThreads) {
+  set_num_threads(4);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> total{0};
+  for (int t = 0; t < 20; ++t)
+    threads.emplace_back([&] {
+      parallel_for(0, 1000, 10, [&](size_t b, size_t e) {
+        total.fetch_add(e - b);
+      });
+    });
+  for (std::thread& t : threads) t.join();
+  EXPECT_EQ(total.load(), 20u * 1000u);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies worker affinity options are validated and applied.
+ */
+TEST(ParallelForTest, PoolAffinity) {
+  set_num_threads(2);
+  parallel_for(0, 64, 1, [](size_t, size_t) {});
+  ThreadPoolOptions pinned;
+  pinned.pin = true;
+  pinned.cpus = {0};
+  EXPECT_NO_THROW(configure_thread_pool(pinned));
+  std::atomic<size_t> count{0};
+  parallel_for(0, 64, 1, [&](size_t b, size_t e) { count += e - b; });
+  EXPECT_EQ(count.load(), 64u);
+  ThreadPoolOptions invalid;
+  invalid.cpus = {size_t(1) << 20};
+  EXPECT_THROW(configure_thread_pool(invalid), std::invalid_argument);
+  configure_thread_pool({});
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies that scopes route parallel work to a separate pool.
+ */
+TEST(ParallelForTest, PoolScopes) {
+  set_num_threads(4);
+  ThreadPoolOptions options;
+  options.max_threads = 2;
+  ThreadPool& small = create_thread_pool(options);
+  const size_t shared_workers = pool_workers();
+  std::set<std::thread::id> ids;
+  std::mutex mutex;
+  std::atomic<size_t> count{0};
+  {
+    ThreadPoolScope scope(small);
+    parallel_for(0, 2000, 1, [&](size_t b, size_t e) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+      }
+      // Nested work and task groups stay in the pool of the scope.
+      parallel_for(b, e, 1, [&](size_t nb, size_t ne) { count += ne - nb; });
+    });
+    EXPECT_LE(pool_workers(), 1u);
+    TaskGroup group;
+    for (int i = 0; i < 10; ++i) group.run([&] { count += 1; });
+    group.wait();
+    EXPECT_THROW(create_thread_pool({{size_t(1) << 20}, false, 0}),
+                 std::invalid_argument);
+  }
+  set_num_threads(0);
+  EXPECT_EQ(count.load(), 2010u);
+  EXPECT_LE(ids.size(), 2u);
+  EXPECT_EQ(pool_workers(), shared_workers);
+}
+
+/**
+ * @test
+ * @brief Verifies that an exception thrown by a chunk reaches the caller.
+ */
+TEST(ParallelForTest, PropagatesExceptions) {
+  set_num_threads(4);
+  EXPECT_THROW(parallel_for(0, 100, 1,
+                            [](size_t b, size_t) {
+                              if (b > 0) throw std::runtime_error("chunk");
+                            }),
+               std::runtime_error);
+  set_num_threads(0);
+}
+
+/**
+ * @test
+ * @brief Verifies the thread limit getter and setter.
+ */
+TEST(ParallelForTest, ThreadLimit) {
+  EXPECT_GE(hardware_threads(), 1u);
+  set_num_threads(3);
+  EXPECT_EQ(num_threads(), 3u);
+  set_num_threads(0);
+  EXPECT_EQ(num_threads(), hardware_threads());
+}
+
+/**
+ * @test
+ * @brief Verifies a thread limit scope caps only its own thread, nests
+ * and bounds the threads working on a parallel_for().
+ */
+TEST(ParallelForTest, ThreadLimitScope) {
+  set_num_threads(4);
+  {
+    ThreadLimitScope outer(2);
+    EXPECT_EQ(num_threads(), 2u);
+    {
+      ThreadLimitScope wider(3);
+      EXPECT_EQ(num_threads(), 2u);
+      ThreadLimitScope none(0);
+      EXPECT_EQ(num_threads(), 2u);
+    }
+    size_t other = 0;
+    std::thread([&] { other = num_threads(); }).join();
+    EXPECT_EQ(other, 4u);
+
+    for (int round = 0; round < 20; ++round) {
+      std::mutex mutex;
+      std::set<std::thread::id> ids;
+      std::atomic<size_t> chunks{0};
+      parallel_for(0, 1000, 1, [&](size_t, size_t) {
+        chunks.fetch_add(1);
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+      });
+      EXPECT_LE(chunks.load(), 2u);
+      EXPECT_LE(ids.size(), 2u);
+    }
+  }
+  EXPECT_EQ(num_threads(), 4u);
+  set_num_threads(0);
+}
@@ -0,0 +1,192 @@
+/**
+ * @file test_pipeline.cpp
+ * @brief Unit tests for the bounded queue and the staged pipeline.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/bounded_queue.h"
+#include "utils/pipeline.h"
+
+/**
+ * @test
+ * @brief Verifies capacity, closing and many producers and consumers.
+ */
+TEST(BoundedQueueTest, BlocksAndCloses) {
+  EXPECT_THROW(BoundedQueue<int>(0), std::invalid_argument);
+  BoundedQueue<int> small(2);
+  EXPECT_TRUE(small.push(1));
+  EXPECT_TRUE(small.push(2));
+  EXPECT_EQ(small.size(), 2u);
+  int value = 0;
+  EXPECT_TRUE(small.tryPop(value));
+  EXPECT_EQ(value, 1);
+  small.close();
+  EXPECT_TRUE(small.closed());
+  EXPECT_FALSE(small.push(3));
+  EXPECT_TRUE(small.pop(value));  // drains after closing
+  EXPECT_EQ(value, 2);
+  EXPECT_FALSE(small.pop(value));
+  EXPECT_FALSE(small.tryPop(value));
+
+  BoundedQueue<int> queue(3);
+  std::atomic<long> sum{0};
+  std::vector<std::thread> producers, consumers;
+  for (int p = 0; p < 4; ++p)
+    producers.emplace_back([&, p] {
+      for (int i = 1; i <= 500; ++i) queue.push(p * 1000 + i);
+    });
+  for (int c = 0; c < 3; ++c)
+    consumers.emplace_back([&] {
+      for (int v; queue.pop(v);) sum += v;
+    });
+  for (std::thread& t : producers) t.join();
+  queue.close();
+  for (std::thread& t : consumers) t.join();
+  EXPECT_EQ(sum.load(), 4 * 500 * 501 / 2 + 500 * 1000 * (0 + 1 + 2 + 3));
+}
+
+/**
+ * @brief Frame-like buffer recycled through a pipeline.
+ */
+struct Frame {
+  std::vector<int> pixels; /**< Payload */
+  int index = -1;          /**< Source position */
+};
+
+/**
+ * @test
+ * @brief Verifies buffers are recycled and the sink sees the source order.
+ */
+TEST(PipelineTest, RecyclesBuffersInOrder) {
+  std::atomic<int> made{0};
+  Pipeline<Frame> pipeline(4, [&] {
+    ++made;
+    return Frame{std::vector<int>(16), -1};
+  });
+  EXPECT_EQ(pipeline.buffers(), 4u);
+  EXPECT_EQ(made.load(), 4);
+
+  int next = 0;
+  std::set<const int*> buffers;
+  std::vector<int> seen;
+  pipeline
+      .source("decode",
+              [&](Frame& f) {
+                if (next == 100) return false;
+                f.index = next++;
+                for (int& p : f.pixels) p = f.index;
+                return true;
+              })
+      .stage("square",
+             [](Frame& f) {
+               for (int& p : f.pixels) p *= p;
+               // Uneven work, so that the three workers overtake each other.
+               if (f.index % 7 == 0)
+                 std::this_thread::sleep_for(std::chrono::microseconds(300));
+             },
+             3)
+      .sink("publish", [&](Frame& f) {
+        buffers.insert(f.pixels.data());
+        EXPECT_EQ(f.pixels[3], f.index * f.index);
+        seen.push_back(f.index);
+      });
+  pipeline.run();
+
+  EXPECT_EQ(made.load(), 4);
+  EXPECT_LE(buffers.size(), 4u);
+  ASSERT_EQ(seen.size(), 100u);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(seen[i], i);
+  const std::vector<PipelineStageStats> stats = pipeline.stats();
+  ASSERT_EQ(stats.size(), 3u);
+  EXPECT_EQ(stats[1].name, "square");
+  EXPECT_EQ(stats[1].workers, 3u);
+  for (const PipelineStageStats& s : stats) {
+    EXPECT_EQ(s.items, 100u) << s.name;
+    EXPECT_GT(s.wall_seconds, 0.);
+    EXPECT_GE(s.occupancy(), 0.);
+    EXPECT_LE(s.occupancy(), 1.01);
+  }
+  EXPECT_NE(format_pipeline_stats(stats).find("square x3: 100 items"),
+            std::string::npos);
+  EXPECT_THROW(pipeline.start(), std::runtime_error);
+}
+
+/**
+ * @test
+ * @brief Verifies stages overlap, so throughput follows the slowest stage.
+ */
+TEST(PipelineTest, OverlapsStages) {
+  const auto work = [](int&) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  };
+  int produced = 0;
+  Pipeline<int> pipeline(6);
+  pipeline
+      .source("decode",
+              [&](int&) {
+                work(produced);
+                return ++produced <= 40;
+              })
+      .stage("preprocess", work)
+      .stage("infer", work, 2)
+      .stage("postprocess", work);
+  const auto start = std::chrono::steady_clock::now();
+  pipeline.run();
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  // Sequentially the four stages would take 40 * 8 ms.
+  EXPECT_LT(seconds, 0.6 * 40 * 0.008);
+  const std::vector<PipelineStageStats> stats = pipeline.stats();
+  EXPECT_EQ(stats.back().items, 40u);
+  EXPECT_GT(stats[0].occupancy(), 0.5);
+  EXPECT_LT(stats[2].occupancy(), stats[0].occupancy());
+}
+
+/**
+ * @test
+ * @brief Verifies stage errors, stopping and invalid construction.
+ */
+TEST(PipelineTest, StopsOnErrorsAndRequest) {
+  Pipeline<int> failing(2);
+  int n = 0;
+  failing.source("count", [&](int& v) {
+    v = n++;
+    return true;  // endless
+  });
+  failing.stage("check", [](int& v) {
+    if (v == 5) throw std::runtime_error("bad frame");
+  });
+  EXPECT_THROW(failing.run(), std::runtime_error);
+
+  Pipeline<int> endless(3);
+  std::atomic<int> consumed{0};
+  endless.source("count", [](int&) { return true; })
+      .sink("consume", [&](int&) { ++consumed; });
+  endless.start();
+  while (consumed.load() < 50) std::this_thread::yield();
+  endless.stop();
+  endless.wait();
+  EXPECT_GE(endless.stats()[1].items, 50u);
+
+  EXPECT_THROW(Pipeline<int>(0), std::invalid_argument);
+  Pipeline<int> invalid(1);
+  EXPECT_THROW(invalid.start(), std::invalid_argument);
+  EXPECT_THROW(invalid.stage("s", [](int&) {}), std::invalid_argument);
+  invalid.source("s", [](int&) { return false; });
+  EXPECT_THROW(invalid.source("s", [](int&) { return false; }),
+               std::invalid_argument);
+  EXPECT_THROW(invalid.stage("t", [](int&) {}, 0), std::invalid_argument);
+  invalid.sink("u", [](int&) {});
+  EXPECT_THROW(invalid.stage("v", [](int&) {}), std::invalid_argument);
+  invalid.run();  // empty stream
+  EXPECT_EQ(invalid.stats()[1].items, 0u);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test_protobuf.cpp
+ * @brief Unit tests for the protocol buffers wire-format reader.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "utils/protobuf.h"
+
+/**
+ * @test
+ * @brief Verifies decoding of every supported wire type.
+ */
+TEST(ProtobufTest, DecodesWireTypes) {
+  // 1: varint 300, 2: "hi", 3: float 1.5, 4: fixed64 double 2.0,
+  // 5: varint -1 (ten bytes).
+  const std::vector<uint8_t> msg = {
+      0x08, 0xac, 0x02, 0x12, 0x02, 'h',  'i',  0x1d, 0x00, 0x00, 0xc0,
+      0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x28,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+  ProtoReader reader(msg);
+  ProtoField f;
+  ASSERT_TRUE(reader.next(f));
+  EXPECT_EQ(f.number, 1u);
+  EXPECT_EQ(f.asInt64(), 300);
+  ASSERT_TRUE(reader.next(f));
+  EXPECT_EQ(f.wire, ProtoWireType::kBytes);
+  EXPECT_EQ(f.asString(), "hi");
+  ASSERT_TRUE(reader.next(f));
+  EXPECT_EQ(f.asFloat(), 1.5f);
+  ASSERT_TRUE(reader.next(f));
+  EXPECT_EQ(f.asDouble(), 2.0);
+  ASSERT_TRUE(reader.next(f));
+  EXPECT_EQ(f.asInt64(), -1);
+  EXPECT_FALSE(reader.next(f));
+}
+
+/**
+ * @test
+ * @brief Verifies packed and unpacked repeated fields.
+ */
+TEST(ProtobufTest, RepeatedFields) {
+  // 1: packed [1, 150], 1: unpacked 7, 2: packed floats [1, -2].
+  const std::vector<uint8_t> msg = {0x0a, 0x03, 0x01, 0x96, 0x01, 0x08,
+                                    0x07, 0x12, 0x08, 0x00, 0x00, 0x80,
+                                    0x3f, 0x00, 0x00, 0x00, 0xc0};
+  ProtoReader reader(msg);
+  ProtoField f;
+  std::vector<int64_t> ints;
+  std::vector<float> floats;
+  while (reader.next(f)) {
+    if (f.number == 1) proto_append_varints(f, ints);
+    if (f.number == 2) proto_append_floats(f, floats);
+  }
+  EXPECT_EQ(ints, (std::vector<int64_t>{1, 150, 7}));
+  EXPECT_EQ(floats, (std::vector<float>{1.f, -2.f}));
+}
+
+/**
+ * @test
+ * @brief Verifies that truncated and unsupported input is rejected.
+ */
+TEST(ProtobufTest, RejectsInvalidInput) {
+  const std::vector<std::vector<uint8_t>> bad = {
+      {0x08},              // missing varint
+      {0x08, 0x80},        // truncated varint
+      {0x12, 0x05, 'a'},   // length past the end
+      {0x1d, 0x00, 0x00},  // truncated fixed32
+      {0x0b},              // group (wire type 3)
+      {0x00, 0x00},        // field number 0
+  };
+  for (const auto& msg : bad) {
+    ProtoReader reader(msg);
+    ProtoField f;
+    EXPECT_THROW(while (reader.next(f)){}, std::runtime_error);
+  }
+  const std::vector<uint8_t> floats = {0x0a, 0x03, 0, 0, 0};
+  ProtoReader reader(floats);
+  ProtoField f;
+  ASSERT_TRUE(reader.next(f));
+  std::vector<float> out;
+  EXPECT_THROW(proto_append_floats(f, out), std::runtime_error);
+}
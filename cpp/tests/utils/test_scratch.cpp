@@ -0,0 +1,52 @@
+/**
+ * @file test_scratch.cpp
+ * @brief Unit tests for the per-depth kernel scratch buffers.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "utils/scratch.h"
+
+/**
+ * @test
+ * @brief Verifies that calls at one depth share a buffer that only grows.
+ */
+TEST(ScratchTest, ReusedAtSameDepth) {
+  ScratchBuffers<float, 2> buffers;
+  ScratchScope scope;
+  float* a = buffers.get(0, 64);
+  EXPECT_EQ(buffers.get(0, 16), a);
+  EXPECT_NE(buffers.get(1, 16), a);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+  EXPECT_EQ(buffers.get(0, 64), a);
+}
+
+/**
+ * @test
+ * @brief Verifies that a nested scope gets its own buffers and that
+ * buffers of outer scopes stay put while deeper ones are added.
+ */
+TEST(ScratchTest, NestedScopesGetOwnBuffers) {
+  ScratchBuffers<int> buffers;
+  EXPECT_EQ(scratch_depth(), 0u);
+  ScratchScope outer;
+  int* a = buffers.get(0, 8);
+  a[0] = 1;
+  {
+    ScratchScope inner;
+    EXPECT_EQ(inner.depth(), 1u);
+    int* b = buffers.get(0, 8);
+    EXPECT_NE(b, a);
+    b[0] = 2;
+    {
+      ScratchScope deepest;
+      EXPECT_NE(buffers.get(0, 8), b);
+    }
+    EXPECT_EQ(buffers.get(0, 8), b);
+  }
+  EXPECT_EQ(scratch_depth(), 1u);
+  EXPECT_EQ(buffers.get(0, 8), a);
+  EXPECT_EQ(a[0], 1);
+}